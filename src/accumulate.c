@@ -0,0 +1,126 @@
+// accumulate.c — see accumulate.h
+#include "accumulate.h"
+#include "shader.h"
+
+#include <string.h>
+
+// Fullscreen triangle from gl_VertexID, no vertex buffer needed.
+static const char* kBlendVert =
+    "#version 330 core\n"
+    "void main() {\n"
+    "    vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+    "    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);\n"
+    "}\n";
+
+// Clamped like the window would show it; the weight comes from the blend color.
+static const char* kBlendFrag =
+    "#version 330 core\n"
+    "out vec4 FragColor;\n"
+    "uniform sampler2D uScene;\n"
+    "void main() {\n"
+    "    FragColor = clamp(texelFetch(uScene, ivec2(gl_FragCoord.xy), 0), 0.0, 1.0);\n"
+    "}\n";
+
+bool AccumInit(TemporalAccumulation* a, int max_samples, char* log, int logsz) {
+    memset(a, 0, sizeof(*a));
+    a->max_samples = max_samples > 0 ? max_samples : 1;
+
+    GLuint vs = CompileShader(GL_VERTEX_SHADER, kBlendVert, log, logsz);
+    if (!vs) return false;
+    GLuint fs = CompileShader(GL_FRAGMENT_SHADER, kBlendFrag, log, logsz);
+    if (!fs) { glDeleteShader(vs); return false; }
+    a->blend_prog = LinkProgram(vs, fs, log, logsz);
+    glDeleteShader(vs); glDeleteShader(fs);
+    if (!a->blend_prog) return false;
+
+    glUseProgram(a->blend_prog);
+    glUniform1i(glGetUniformLocation(a->blend_prog, "uScene"), 0);
+    glGenVertexArrays(1, &a->empty_vao);
+    return true;
+}
+
+void AccumShutdown(TemporalAccumulation* a) {
+    DestroyRenderTarget(&a->scene);
+    DestroyRenderTarget(&a->mean);
+    if (a->blend_prog) { glDeleteProgram(a->blend_prog); a->blend_prog = 0; }
+    if (a->empty_vao) { glDeleteVertexArrays(1, &a->empty_vao); a->empty_vao = 0; }
+}
+
+void AccumReset(TemporalAccumulation* a) {
+    a->started = false;
+}
+
+// Radical inverse of i in base b: 0.5, 0.25, 0.75, ... for b = 2.
+static float Halton(int i, int b) {
+    float f = 1.f, r = 0.f;
+    for (; i > 0; i /= b) {
+        f /= (float)b;
+        r += f * (float)(i % b);
+    }
+    return r;
+}
+
+static bool SameView(const FrameInputs* a, const FrameInputs* b) {
+    return a->time == b->time && a->mouse[0] == b->mouse[0] && a->mouse[1] == b->mouse[1] &&
+           a->mouse_buttons == b->mouse_buttons &&
+           a->resolution[0] == b->resolution[0] && a->resolution[1] == b->resolution[1];
+}
+
+bool AccumBegin(TemporalAccumulation* a, int w, int h, FrameInputs* now) {
+    if (a->mean.width != w || a->mean.height != h) {
+        DestroyRenderTarget(&a->scene);
+        DestroyRenderTarget(&a->mean);
+        if (!CreateRenderTarget(&a->scene, w, h, GL_RGBA16F) || !CreateRenderTarget(&a->mean, w, h, GL_RGBA32F)) {
+            DestroyRenderTarget(&a->scene);
+            DestroyRenderTarget(&a->mean);
+            return false;
+        }
+        a->started = false;
+    }
+    if (!a->started || !SameView(now, &a->inputs)) {
+        a->inputs = *now;
+        a->started = true;
+        a->samples = 0;
+        a->started_at = NowSeconds();
+        a->done_seconds = 0.0;
+    }
+    if (a->samples >= a->max_samples) return false;
+    // Sample 0 at the pixel center, then Halton points over the pixel.
+    int n = a->samples;
+    now->jitter[0] = n ? Halton(n, 2) - 0.5f : 0.f;
+    now->jitter[1] = n ? Halton(n, 3) - 0.5f : 0.f;
+    glBindFramebuffer(GL_FRAMEBUFFER, a->scene.fbo);
+    return true;
+}
+
+void AccumEnd(TemporalAccumulation* a) {
+    // mean += (sample - mean) / (n + 1): the first sample replaces whatever was there.
+    glBindFramebuffer(GL_FRAMEBUFFER, a->mean.fbo);
+    glViewport(0, 0, a->mean.width, a->mean.height);
+    glEnable(GL_BLEND);
+    glBlendColor(0.f, 0.f, 0.f, 1.f / (float)(a->samples + 1));
+    glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+    glUseProgram(a->blend_prog);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, a->scene.color);
+    glBindVertexArray(a->empty_vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glDisable(GL_BLEND);
+    if (++a->samples == a->max_samples) a->done_seconds = NowSeconds() - a->started_at;
+}
+
+void AccumPresent(TemporalAccumulation* a, GLuint dst_fbo) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, a->mean.fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst_fbo);
+    glBlitFramebuffer(0, 0, a->mean.width, a->mean.height, 0, 0, a->mean.width, a->mean.height,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, dst_fbo);
+}
+
+bool AccumReady(const TemporalAccumulation* a) {
+    return a->mean.fbo != 0;
+}
+
+bool AccumDone(const TemporalAccumulation* a) {
+    return a->started && a->samples >= a->max_samples;
+}
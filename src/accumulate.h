@@ -0,0 +1,51 @@
+// accumulate.h — anti-aliased stills while time is paused
+//
+// With time paused every frame would draw the same image. Instead each paused frame
+// draws the scene once more with a new subpixel offset (uJitter in the FrameInputs
+// block, and vUV through the quad) into a scene target, and a blend pass folds it into
+// a GL_RGBA32F running mean that every frame presents. The offsets follow the Halton
+// (2, 3) sequence, the first sample sits at the pixel center, so the first frame looks
+// like an ordinary one and the still converges evenly. Once max_samples are in, frames
+// only present the still and the GPU idles.
+//
+// The still starts over when the size, the mouse or the paused time changes, or when
+// the caller resets it (a reload, new parameters or textures).
+
+#ifndef SHADERDEVEL_ACCUMULATE_H
+#define SHADERDEVEL_ACCUMULATE_H
+
+#include "platform.h"
+#include "render_target.h"
+#include "uniforms.h"
+#include <glad/gl.h>
+
+typedef struct {
+    int          max_samples;
+    RenderTarget scene;          // this sample, GL_RGBA16F
+    RenderTarget mean;           // the still so far, GL_RGBA32F
+    int          samples;        // in mean
+    FrameInputs  inputs;         // the view being accumulated
+    bool         started;
+    double       started_at;
+    double       done_seconds;   // from the first sample to the last, 0 = not done
+    GLuint       blend_prog, empty_vao;
+} TemporalAccumulation;
+
+// Needs a current context. False (with log) if the blend shader fails to build.
+bool AccumInit(TemporalAccumulation* a, int max_samples, char* log, int logsz);
+void AccumShutdown(TemporalAccumulation* a);
+
+// The next Begin starts a new still.
+void AccumReset(TemporalAccumulation* a);
+// Sizes the targets for w x h and starts over if now shows another view. Returns
+// false when the still is done (or the targets can't be allocated: see AccumReady);
+// otherwise sets now->jitter for the next sample and binds the scene target.
+bool AccumBegin(TemporalAccumulation* a, int w, int h, FrameInputs* now);
+// Folds the scene target into the mean.
+void AccumEnd(TemporalAccumulation* a);
+// Copies the mean to dst_fbo.
+void AccumPresent(TemporalAccumulation* a, GLuint dst_fbo);
+bool AccumReady(const TemporalAccumulation* a);
+bool AccumDone(const TemporalAccumulation* a);
+
+#endif // SHADERDEVEL_ACCUMULATE_H
@@ -0,0 +1,512 @@
+// app.c — see app.h
+#include "app.h"
+#include "shader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+App g_app = {0};
+
+void ApplyProgram(GLuint prog) {
+    if (g_app.program) glDeleteProgram(g_app.program);
+    g_app.program = prog;
+    glUseProgram(g_app.program);
+    g_app.uTime       = glGetUniformLocation(g_app.program, "uTime");
+    g_app.uResolution = glGetUniformLocation(g_app.program, "uResolution");
+    g_app.uMouse      = glGetUniformLocation(g_app.program, "uMouse");
+    g_app.uChannelResolution = glGetUniformLocation(g_app.program, "iChannelResolution");
+    SetupProgramUniforms(g_app.program);
+    glUseProgram(g_app.program);
+    if (g_app.compute) ComputePassSetProgram(g_app.compute, g_app.program);
+    if (g_app.progressive) ProgressiveRestart(g_app.progressive, true); // a new cost, too
+    if (g_app.accum) AccumReset(g_app.accum);
+}
+
+// ============== Quad (pos,uv) =====================================
+// Triangle strip: (-1, -1) .. (1, 1)
+// pos.xy, uv.xy; uv spans (u0, v0) .. (u1, v1)
+static void QuadVertices(float verts[16], float u0, float v0, float u1, float v1) {
+    const float quad[16] = {
+        -1.f, -1.f,   u0, v0,
+         1.f, -1.f,   u1, v0,
+        -1.f,  1.f,   u0, v1,
+         1.f,  1.f,   u1, v1,
+    };
+    memcpy(verts, quad, sizeof(quad));
+}
+
+void CreateFullscreenQuad(void) {
+    float verts[16];
+    QuadVertices(verts, 0.f, 0.f, 1.f, 1.f);
+    glGenVertexArrays(1, &g_app.vao);
+    glBindVertexArray(g_app.vao);
+    glGenBuffers(1, &g_app.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, g_app.vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
+
+    GLint locPos = g_app.program ? glGetAttribLocation(g_app.program, "aPos") : -1;
+    GLint locUV  = g_app.program ? glGetAttribLocation(g_app.program, "aUV")  : -1;
+
+    // In case shader uses layout(location=...), these are typically 0 and 1,
+    // but we query to be robust.
+    if (locPos < 0) locPos = 0;
+    if (locUV  < 0) locUV  = 1;
+
+    glVertexAttribPointer((GLuint)locPos, 2, GL_FLOAT, GL_FALSE, 4*(GLsizei)sizeof(float), (const void*)(0));
+    glEnableVertexAttribArray((GLuint)locPos);
+    glVertexAttribPointer((GLuint)locUV,  2, GL_FLOAT, GL_FALSE, 4*(GLsizei)sizeof(float), (const void*)(2*sizeof(float)));
+    glEnableVertexAttribArray((GLuint)locUV);
+    glBindVertexArray(0);
+}
+
+void SwapProgram(GLuint prog) {
+    ApplyProgram(prog);
+    if (g_app.gpu_timer) GpuTimerReset(g_app.gpu_timer); // per-version numbers
+    // Rebind VAO because attrib locations could have changed
+    if (g_app.vao) { glDeleteVertexArrays(1, &g_app.vao); g_app.vao = 0; }
+    if (g_app.vbo) { glDeleteBuffers(1, &g_app.vbo); g_app.vbo = 0; }
+    CreateFullscreenQuad();
+}
+
+// ============================ Drawing ==============================
+static void FillDate(float out[4]) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    struct tm lt;
+#ifdef _WIN32
+    localtime_s(&lt, &ts.tv_sec);
+#else
+    localtime_r(&ts.tv_sec, &lt);
+#endif
+    out[0] = (float)(lt.tm_year + 1900);
+    out[1] = (float)(lt.tm_mon + 1);
+    out[2] = (float)lt.tm_mday;
+    out[3] = (float)(lt.tm_hour * 3600 + lt.tm_min * 60 + lt.tm_sec) + (float)ts.tv_nsec * 1e-9f;
+}
+
+// The params file's images on units 0..3 and their sizes; false without a cache.
+static bool BindChannelTextures(float res[USER_CHANNELS][3]) {
+    memset(res, 0, sizeof(float) * USER_CHANNELS * 3);
+    if (!g_app.textures) return false;
+    for (int c = 0; c < USER_CHANNELS; ++c) {
+        int w = 0, h = 0;
+        glActiveTexture(GL_TEXTURE0 + c);
+        glBindTexture(GL_TEXTURE_2D, g_app.channel_texture[c] < 0 ? 0 : TextureCacheTexture(g_app.textures, g_app.channel_texture[c], &w, &h));
+        res[c][0] = (float)w; res[c][1] = (float)h; res[c][2] = w ? 1.f : 0.f;
+    }
+    glActiveTexture(GL_TEXTURE0);
+    return true;
+}
+
+// The single program with its loose uniforms and channel textures, for in.
+static void BindSceneProgram(const FrameInputs* in) {
+    glUseProgram(g_app.program);
+    if (g_app.uTime >= 0)       glUniform1f(g_app.uTime, in->time);
+    if (g_app.uResolution >= 0) glUniform2f(g_app.uResolution, in->resolution[0], in->resolution[1]);
+    if (g_app.uMouse >= 0)      glUniform2f(g_app.uMouse, in->mouse[0], in->mouse[1]);
+    float res[USER_CHANNELS][3];
+    if (BindChannelTextures(res) && g_app.uChannelResolution >= 0) glUniform3fv(g_app.uChannelResolution, USER_CHANNELS, res[0]);
+}
+
+// Every tile sees the cell as its output: one upload of the block with the cell's
+// size and mouse serves them all.
+static void DrawGrid(const FrameInputs* in, int width, int height) {
+    FrameInputs cell = *in;
+    ShaderGridCellInputs(g_app.grid, width, height, in->mouse[0], in->mouse[1], cell.resolution, cell.mouse);
+    if (g_app.frame_uniforms) FrameUniformsUpload(g_app.frame_uniforms, &cell);
+    GLint dst = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &dst);
+    float res[USER_CHANNELS][3];
+    bool channels = BindChannelTextures(res);
+    glBindVertexArray(g_app.vao);
+    if (g_app.gpu_timer) GpuTimerBegin(g_app.gpu_timer);
+    ShaderGridRender(g_app.grid, cell.time, cell.mouse, channels ? res[0] : NULL, (GLuint)dst);
+    if (g_app.gpu_timer) GpuTimerEnd(g_app.gpu_timer);
+    if (g_app.frame_uniforms) FrameUniformsFence(g_app.frame_uniforms);
+}
+
+// Draws with in into (0, 0, width, height) of the bound framebuffer.
+static void DrawScene(const FrameInputs* in, int width, int height) {
+    if (g_app.grid) { DrawGrid(in, width, height); return; }
+    if (g_app.frame_uniforms) FrameUniformsUpload(g_app.frame_uniforms, in);
+
+    if (g_app.graph) {
+        GLint dst = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &dst);
+        glBindVertexArray(g_app.vao);
+        if (g_app.gpu_timer) GpuTimerBegin(g_app.gpu_timer);
+        RenderGraphRender(g_app.graph, in->time, in->mouse[0], in->mouse[1], width, height, (GLuint)dst);
+        if (g_app.gpu_timer) GpuTimerEnd(g_app.gpu_timer);
+        if (g_app.frame_uniforms) FrameUniformsFence(g_app.frame_uniforms);
+        return;
+    }
+
+    glViewport(0, 0, width, height);
+    BindSceneProgram(in);
+    if (g_app.compute) {
+        // The timer measures the shader, not the blit.
+        if (g_app.gpu_timer) GpuTimerBegin(g_app.gpu_timer);
+        bool ok = ComputePassDispatch(g_app.compute, width, height);
+        if (g_app.gpu_timer) GpuTimerEnd(g_app.gpu_timer);
+        if (g_app.frame_uniforms) FrameUniformsFence(g_app.frame_uniforms);
+        if (ok) ComputePassPresent(g_app.compute, width, height);
+        return;
+    }
+    glBindVertexArray(g_app.vao);
+    if (g_app.gpu_timer) GpuTimerBegin(g_app.gpu_timer);
+    // using triangle strip; 4 verts
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    if (g_app.gpu_timer) GpuTimerEnd(g_app.gpu_timer);
+    if (g_app.frame_uniforms) FrameUniformsFence(g_app.frame_uniforms);
+}
+
+// This frame's inputs at render_width x render_height; advances the frame counter.
+static void NextFrameInputs(float timeSec, FrameInputs* out) {
+    float t = g_app.paused ? (float)g_app.paused_offset : timeSec;
+    // mouse is in output pixels; shaders compare it against uResolution
+    float sx = g_app.width  > 0 ? (float)g_app.render_width  / (float)g_app.width  : 1.f;
+    float sy = g_app.height > 0 ? (float)g_app.render_height / (float)g_app.height : 1.f;
+
+    memset(out, 0, sizeof(*out));
+    out->resolution[0] = (float)g_app.render_width;
+    out->resolution[1] = (float)g_app.render_height;
+    out->mouse[0] = (float)g_app.mouse_x * sx;
+    out->mouse[1] = (float)g_app.mouse_y * sy;
+    if (g_app.frame_uniforms) FillDate(out->date);
+    out->time = t;
+    out->time_delta = g_app.frame_index ? (float)(timeSec - g_app.last_frame_seconds) : 0.f;
+    out->frame = (int32_t)g_app.frame_index;
+    out->mouse_buttons = g_app.mouse_buttons;
+    g_app.last_frame_seconds = timeSec;
+    g_app.frame_index++;
+}
+
+void Render(float timeSec) {
+    FrameInputs in;
+    NextFrameInputs(timeSec, &in);
+    DrawScene(&in, g_app.render_width, g_app.render_height);
+}
+
+// A budget of tiles into the progressive target, which is then the output.
+static void RenderProgressive(float timeSec, GLuint dst_fbo) {
+    ProgressiveRender* p = g_app.progressive;
+    g_app.render_width  = g_app.width;
+    g_app.render_height = g_app.height;
+    FrameInputs in;
+    NextFrameInputs(timeSec, &in);
+    if (ProgressiveBegin(p, g_app.width, g_app.height, &in, !g_app.paused)) {
+        if (g_app.frame_uniforms) FrameUniformsUpload(g_app.frame_uniforms, &p->inputs);
+        BindSceneProgram(&p->inputs);
+        glBindVertexArray(g_app.vao);
+        if (g_app.gpu_timer) GpuTimerBegin(g_app.gpu_timer);
+        ProgressiveDrawTiles(p);
+        if (g_app.gpu_timer) GpuTimerEnd(g_app.gpu_timer);
+        if (g_app.frame_uniforms) FrameUniformsFence(g_app.frame_uniforms);
+    }
+    ProgressivePresent(p, dst_fbo);
+}
+
+static bool Accumulating(void) {
+    return g_app.accum && g_app.paused && !g_app.graph && !g_app.grid && !g_app.progressive;
+}
+
+// The next sample of the paused still into its mean, which is then the output.
+static void RenderStill(float timeSec, GLuint dst_fbo) {
+    TemporalAccumulation* a = g_app.accum;
+    g_app.render_width  = g_app.width;
+    g_app.render_height = g_app.height;
+    FrameInputs in;
+    NextFrameInputs(timeSec, &in);
+    if (AccumBegin(a, g_app.width, g_app.height, &in)) {
+        RenderRegion(&in, g_app.width, g_app.height);
+        AccumEnd(a);
+    } else if (!AccumReady(a)) {
+        glBindFramebuffer(GL_FRAMEBUFFER, dst_fbo); // no float targets: plain frames
+        DrawScene(&in, g_app.width, g_app.height);
+        return;
+    }
+    AccumPresent(a, dst_fbo);
+}
+
+bool SceneNeedsFrames(void) {
+    if (g_app.grid) return ShaderGridPending(g_app.grid);
+    if (Accumulating()) return !AccumDone(g_app.accum);
+    return g_app.progressive && !g_app.graph && !g_app.grid && !g_app.compute && !g_app.progressive->complete;
+}
+
+void RenderRegion(const FrameInputs* in, int width, int height) {
+    float rw = in->resolution[0], rh = in->resolution[1];
+    float x0 = in->tile_offset[0] + in->jitter[0], y0 = in->tile_offset[1] + in->jitter[1];
+    bool whole = x0 == 0.f && y0 == 0.f && (float)width == rw && (float)height == rh;
+    float verts[16];
+    if (!whole) {
+        // vUV follows the region; gl_FragCoord needs uTileOffset and uJitter added.
+        QuadVertices(verts, x0 / rw, y0 / rh, (x0 + (float)width) / rw, (y0 + (float)height) / rh);
+        glBindBuffer(GL_ARRAY_BUFFER, g_app.vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
+    }
+    DrawScene(in, width, height);
+    if (!whole) {
+        QuadVertices(verts, 0.f, 0.f, 1.f, 1.f);
+        glBindBuffer(GL_ARRAY_BUFFER, g_app.vbo);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
+    }
+}
+
+void RenderFrame(float timeSec, GLuint dst_fbo) {
+    if (g_app.progressive && !g_app.graph && !g_app.grid && !g_app.compute) {
+        RenderProgressive(timeSec, dst_fbo);
+        FrameCaptureGrab(g_app.capture, dst_fbo, g_app.width, g_app.height);
+        return;
+    }
+    if (Accumulating()) {
+        RenderStill(timeSec, dst_fbo); // at full size, whatever dynres would pick
+        FrameCaptureGrab(g_app.capture, dst_fbo, g_app.width, g_app.height);
+        return;
+    }
+    DynamicResolution* dr = g_app.dynres;
+    if (dr) {
+        double scene_ms;
+        if (g_app.gpu_timer && GpuTimerTakeLatest(g_app.gpu_timer, &scene_ms)) DynResUpdate(dr, scene_ms);
+        if (DynResBegin(dr, g_app.width, g_app.height, &g_app.render_width, &g_app.render_height)) {
+            Render(timeSec);
+            DynResEnd(dr, dst_fbo);
+            FrameCaptureGrab(g_app.capture, dst_fbo, g_app.width, g_app.height);
+            return;
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, dst_fbo);
+    g_app.render_width  = g_app.width;
+    g_app.render_height = g_app.height;
+    Render(timeSec);
+    FrameCaptureGrab(g_app.capture, dst_fbo, g_app.width, g_app.height);
+}
+
+// ============================ Programs =============================
+int ProgramCount(void) {
+    return g_app.graph ? g_app.graph->count : g_app.grid ? g_app.grid->count : 1;
+}
+
+const char* ProgramName(int tag) {
+    if (tag < 0 || tag >= ProgramCount()) return "?";
+    return g_app.graph ? g_app.graph->pass[tag].name : g_app.grid ? g_app.grid->tile[tag].name : "program";
+}
+
+static const char* ProgramFragPath(int tag) {
+    return g_app.graph ? g_app.graph->pass[tag].frag_path : g_app.grid ? g_app.grid->tile[tag].frag_path : g_app.frag_path;
+}
+
+static uint64_t ProgramHash(int tag) {
+    return g_app.graph ? g_app.graph->pass[tag].source_hash : g_app.grid ? g_app.grid->tile[tag].source_hash : g_app.program_hash;
+}
+
+// ============================ Hot reload ===========================
+// Shader files (roots and includes) by watcher id, in NormalizeShaderPath form.
+static char s_shader_path[WATCHER_MAX_FILES][APP_PATH_MAX];
+static bool s_is_shader[WATCHER_MAX_FILES];
+
+static void WatchShaderFile(const char* path, void* user) {
+    (void)user;
+    int id = FileWatcherAddFile(g_app.watcher, path);
+    if (id < 0 || s_is_shader[id]) return;
+    snprintf(s_shader_path[id], APP_PATH_MAX, "%s", path);
+    s_is_shader[id] = true;
+}
+
+void WatchShaderFiles(void) {
+    if (!g_app.watcher) return;
+    IncludeCache* includes = GetIncludeCache();
+    if (!g_app.compute) ForEachShaderDependency(includes, g_app.vert_path, WatchShaderFile, NULL);
+    for (int i = 0; i < ProgramCount(); ++i)
+        ForEachShaderDependency(includes, ProgramFragPath(i), WatchShaderFile, NULL);
+}
+
+bool SubmitChangedPrograms(bool all, double requested_at) {
+    // Take every flag, even when rebuilding everything, so none fires again later.
+    const char* changed[WATCHER_MAX_FILES];
+    int n = 0;
+    for (int id = 0; g_app.watcher && id < WATCHER_MAX_FILES; ++id)
+        if (s_is_shader[id] && FileWatcherTakeChanged(g_app.watcher, id)) changed[n++] = s_shader_path[id];
+    if (g_app.graph)
+        return RenderGraphSubmitChanged(g_app.graph, g_app.compiler, g_app.vert_path, changed, n, all, requested_at) > 0;
+    if (g_app.grid)
+        return ShaderGridSubmitChanged(g_app.grid, g_app.compiler, g_app.vert_path, changed, n, all, requested_at) > 0;
+    IncludeCache* includes = GetIncludeCache();
+    if (!all && (g_app.compute || !ShaderDependsOnAny(includes, g_app.vert_path, changed, n)) &&
+        !ShaderDependsOnAny(includes, g_app.frag_path, changed, n)) return false;
+    ShaderCompilerSubmit(g_app.compiler, g_app.vert_path, g_app.frag_path, all ? 0 : g_app.program_hash, requested_at);
+    return true;
+}
+
+bool ApplyCompileResult(const CompileResult* r) {
+    WatchShaderFiles(); // a new #include, or a missing one the user is about to create
+    const char* what = ProgramName(r->tag);
+    if (r->unchanged) {
+        g_app.reloads_skipped++;
+        TelemetryReloadSkipped(g_app.telemetry_thread, what);
+        return true;
+    }
+    if (!r->program) {
+        TelemetryCompileError(g_app.telemetry_thread, what, r->log);
+        return false;
+    }
+    TelemetrySetProgram(g_app.telemetry_thread, what, r->source_hash);
+    if (g_app.graph) {
+        RenderGraphSwapProgram(g_app.graph, r->tag, r->program, r->source_hash);
+        if (g_app.gpu_timer) GpuTimerReset(g_app.gpu_timer); // per-version numbers, as in SwapProgram
+    } else if (g_app.grid) {
+        ShaderGridSwapProgram(g_app.grid, r->tag, r->program, r->source_hash);
+        if (g_app.gpu_timer) GpuTimerReset(g_app.gpu_timer);
+    } else {
+        SwapProgram(r->program);
+        g_app.program_hash = r->source_hash;
+    }
+    if (g_app.pacer) FramePacerResetStats(g_app.pacer); // the frame's cost changed
+    return true;
+}
+
+// Takes the images the params name before letting go of the previous ones, so a file
+// named in both stays cached.
+static void AcquireParamChannels(void) {
+    if (!g_app.textures || g_app.graph) return; // a graph names its own
+    UserParams* params = GetUserParams();
+    for (int c = 0; c < USER_CHANNELS; ++c) {
+        int old = g_app.channel_texture[c];
+        g_app.channel_texture[c] = params && params->channel[c][0] ? TextureCacheAcquire(g_app.textures, params->channel[c]) : -1;
+        if (old >= 0) TextureCacheRelease(g_app.textures, old);
+    }
+}
+
+bool ReloadChangedParams(char* log, int logsz) {
+    log[0] = 0;
+    UserParams* params = GetUserParams();
+    if (!params || !g_app.watcher || g_app.params_watch < 0 ||
+        !FileWatcherTakeChanged(g_app.watcher, g_app.params_watch)) return false;
+    if (!LoadUserParams(params->path, params, log, logsz)) return true;
+    AcquireParamChannels();
+    if (g_app.progressive) ProgressiveRestart(g_app.progressive, false);
+    if (g_app.accum) AccumReset(g_app.accum);
+    if (g_app.graph) {
+        for (int i = 0; i < g_app.graph->count; ++i) {
+            if (!ApplyUserParams(g_app.graph->pass[i].program, params)) continue;
+            g_app.graph->pass[i].dirty = true; // idle passes must show the new values
+        }
+    } else if (g_app.grid) {
+        for (int i = 0; i < g_app.grid->count; ++i) ApplyUserParams(g_app.grid->tile[i].program, params);
+        ShaderGridInvalidate(g_app.grid);
+    } else {
+        ApplyUserParams(g_app.program, params);
+    }
+    return true;
+}
+
+// ========================== Cost analysis ==========================
+int UpdateShaderCost(int tag, char* out, int outsz) {
+    out[0] = 0;
+    if (tag < 0 || tag >= ProgramCount()) return -1;
+    const char* frag = ProgramFragPath(tag);
+    char* vsrc = NULL;
+    char* fsrc = NULL;
+    static ShaderFileTable files[2];
+    char log[512];
+    if (!LoadShaderSources(g_app.vert_path, frag, &vsrc, &fsrc, files, log, sizeof(log))) {
+        snprintf(out, (size_t)outsz, "cost: %s", log);
+        return -1;
+    }
+    ShaderCostReport* report = (ShaderCostReport*)calloc(1, sizeof(ShaderCostReport));
+    bool ok = report && AnalyzeShaderCost(fsrc, &files[1], report, log, sizeof(log));
+    free(vsrc);
+    free(fsrc);
+    if (!ok) {
+        snprintf(out, (size_t)outsz, "cost: %s", report ? log : "out of memory");
+        free(report);
+        return -1;
+    }
+    char summary[256];
+    FormatShaderCostSummary(report, summary, sizeof(summary));
+    int n = snprintf(out, (size_t)outsz, "cost %s", summary);
+    int warnings = 0;
+    ShaderCostReport* prev = g_app.cost[tag];
+    if (prev && n > 0 && n + 1 < outsz) {
+        out[n++] = '\n';
+        warnings = DiffShaderCost(prev, report, out + n, (size_t)(outsz - n));
+        if (!out[n]) out[n - 1] = 0;
+    }
+    if (prev) { FreeShaderCostReport(prev); free(prev); }
+    g_app.cost[tag] = report;
+    return warnings;
+}
+
+void FreeShaderCosts(void) {
+    for (int i = 0; i < COMPILER_MAX_TAGS; ++i) {
+        if (!g_app.cost[i]) continue;
+        FreeShaderCostReport(g_app.cost[i]);
+        free(g_app.cost[i]);
+        g_app.cost[i] = NULL;
+    }
+}
+
+// ============================= Textures ============================
+void AttachChannelTextures(TextureCache* c) {
+    g_app.textures = c;
+    for (int i = 0; i < USER_CHANNELS; ++i) g_app.channel_texture[i] = -1;
+    if (!c) return;
+    if (g_app.graph) RenderGraphAttachTextures(g_app.graph, c);
+    else AcquireParamChannels();
+}
+
+void DetachChannelTextures(void) {
+    for (int i = 0; i < USER_CHANNELS && g_app.textures; ++i)
+        if (g_app.channel_texture[i] >= 0) TextureCacheRelease(g_app.textures, g_app.channel_texture[i]);
+    for (int i = 0; i < USER_CHANNELS; ++i) g_app.channel_texture[i] = -1;
+    g_app.textures = NULL;
+}
+
+void AttachTelemetry(Telemetry* t) {
+    g_app.telemetry = t;
+    g_app.telemetry_thread = TelemetryRegisterThread(t, "render");
+    if (!g_app.telemetry_thread) return;
+    if (g_app.gpu_timer) GpuTimerSetSink(g_app.gpu_timer, TelemetryGpuSample, g_app.telemetry_thread);
+    for (int i = 0; i < ProgramCount(); ++i)
+        TelemetrySetProgram(g_app.telemetry_thread, ProgramName(i), ProgramHash(i));
+}
+
+void DetachTelemetry(void) {
+    if (g_app.gpu_timer) GpuTimerSetSink(g_app.gpu_timer, NULL, NULL);
+    g_app.telemetry = NULL;
+    g_app.telemetry_thread = NULL;
+}
+
+int UpdateTextures(char* out, int outsz) {
+    out[0] = 0;
+    if (!g_app.textures) return 0;
+    TextureLoadEvent ev[8];
+    int n = TextureCacheUpdate(g_app.textures, ev, 8);
+    if (!n) return 0;
+    if (g_app.progressive) ProgressiveRestart(g_app.progressive, false);
+    if (g_app.accum) AccumReset(g_app.accum);
+    if (g_app.grid) ShaderGridInvalidate(g_app.grid);
+    TextureCacheStats st;
+    TextureCacheGetStats(g_app.textures, &st);
+    int len = 0;
+    for (int i = 0; i < n && len < outsz; ++i) {
+        const char* sep = i ? "\n" : "";
+        if (ev[i].ok)
+            len += snprintf(out + len, (size_t)(outsz - len), "%stexture %s %dx%d loaded in %.1f ms (decode %.1f ms), %.1f of %.0f MB resident",
+                            sep, ev[i].path, ev[i].width, ev[i].height, ev[i].load_ms, ev[i].decode_ms,
+                            (double)st.resident_bytes / (1 << 20), (double)st.budget_bytes / (1 << 20));
+        else
+            len += snprintf(out + len, (size_t)(outsz - len), "%stexture %s: %s", sep, ev[i].path, ev[i].error);
+    }
+    return n;
+}
+
+void FormatTextureMemory(char* out, size_t outsz) {
+    out[0] = 0;
+    if (!g_app.textures) return;
+    TextureCacheStats st;
+    TextureCacheGetStats(g_app.textures, &st);
+    snprintf(out, outsz, "tex %.1f/%.0f MB", (double)st.resident_bytes / (1 << 20), (double)st.budget_bytes / (1 << 20));
+}
@@ -0,0 +1,172 @@
+// app.h — playground state and the drawing path shared by every front end
+//
+// The entry point (main.c on Win32, main_headless.c elsewhere) fills in g_app and
+// owns the context; the functions below only touch the GL side.
+
+#ifndef SHADERDEVEL_APP_H
+#define SHADERDEVEL_APP_H
+
+#include "platform.h"
+#include "accumulate.h"
+#include "capture.h"
+#include "compiler.h"
+#include "compute_pass.h"
+#include "gpu_timer.h"
+#include "dynres.h"
+#include "frame_pacer.h"
+#include "progressive.h"
+#include "render_graph.h"
+#include "shader_grid.h"
+#include "shader_cost.h"
+#include "telemetry.h"
+#include "texture_cache.h"
+#include "uniforms.h"
+#include "watcher.h"
+#include <glad/gl.h>
+
+typedef struct {
+#ifdef _WIN32
+    HINSTANCE hinst;
+    HWND      hwnd;
+    HDC       hdc;
+    HGLRC     glrc;
+#endif
+    int       width, height;               // output (window / benchmark target) size
+    int       render_width, render_height; // scene size this frame; smaller under dynamic resolution
+    bool      running;
+    bool      key_down[256];
+    bool      paused;
+
+    GLuint    program;
+    GLuint    vao, vbo;
+    // optional multi-pass graph; when set it replaces program (which stays 0)
+    RenderGraph* graph;
+    // optional grid of independent shaders; replaces program like graph (never both)
+    ShaderGrid* grid;
+    // set when frag_path is a compute shader: program is dispatched into its image,
+    // which is blitted where the quad would have drawn (no graph, grid or progressive)
+    ComputePass* compute;
+
+    // uniforms: the FrameInputs block (uniforms.h) for every program, plus the loose
+    // legacy ones when the program declares them (-1 otherwise)
+    FrameUniforms* frame_uniforms; // NULL: only the legacy uniforms are set
+    GLint     uTime, uResolution, uMouse, uChannelResolution;
+    uint32_t  frame_index;
+    double    last_frame_seconds;
+    int       params_watch;        // watcher id of the user parameter file, -1 if none
+
+    // optional; image inputs (the params file's iChannelN for the single program, the
+    // graph's own otherwise) and their handles in it, -1 = unbound
+    TextureCache* textures;
+    int       channel_texture[USER_CHANNELS];
+
+    // shader files (UTF-8); WatchShaderFiles() watches them and everything they include
+    char      vert_path[APP_PATH_MAX];
+    char      frag_path[APP_PATH_MAX];
+    FileWatcher* watcher;
+
+    // async rebuilds; reload latency = file change -> first presented frame with the new program
+    ShaderCompiler* compiler;
+    double    reload_requested_at; // 0 when no swapped-in program is waiting for its first frame
+    double    last_reload_ms;
+    uint64_t  program_hash;        // ProgramSourceHash of program, 0 if unknown
+    int       reloads_skipped;     // file changes whose expanded sources hashed the same
+    // static cost of each program's fragment shader (by compile tag) as last built
+    ShaderCostReport* cost[COMPILER_MAX_TAGS];
+
+    // optional; Render() brackets the draw with it and SwapProgram() starts a new version
+    GpuTimer* gpu_timer;
+    // optional; the front end's loop drives it around RenderFrame and the swap, a new
+    // program restarts its statistics
+    FramePacer* pacer;
+    // optional; NULL renders the scene straight into the output at full size
+    DynamicResolution* dynres;
+    // optional, single program only; draws the scene a time budget of tiles per frame
+    ProgressiveRender* progressive;
+    // optional, single program only; while paused, jittered samples average into a still
+    TemporalAccumulation* accum;
+    // optional; RenderFrame() queues a readback of every output frame into it
+    FrameCapture* capture;
+    // optional; the render thread's slot, ApplyCompileResult reports builds to it
+    Telemetry* telemetry;
+    TelemetryThread* telemetry_thread;
+
+    int       mouse_x, mouse_y; // in window client coords
+    int       mouse_buttons;    // bit 0 left, 1 right, 2 middle
+    double    start_seconds;
+    double    paused_offset;
+} App;
+
+extern App g_app;
+
+// Replaces g_app.program (deleting the old one), re-queries uniform locations and sets
+// it up for the FrameInputs block and the user parameters (and g_app.compute for it).
+void ApplyProgram(GLuint prog);
+// (Re)creates g_app.vao/vbo for the current program's attribute layout (0/1 with a graph).
+void CreateFullscreenQuad(void);
+// ApplyProgram + rebuild the quad, since attribute locations could have changed.
+// Also resets g_app.gpu_timer so each shader version gets its own statistics.
+void SwapProgram(GLuint prog);
+// Draws the scene at render_width x render_height into the currently bound framebuffer,
+// after uploading this frame's FrameInputs once for every program that draws.
+void Render(float timeSec);
+// Draws the single program (no graph) with fixed inputs into (0, 0, width, height) of
+// the bound framebuffer, as the region of an in->resolution image that starts at
+// in->tile_offset: how offline renders cut frames bigger than a framebuffer into tiles.
+// vUV also follows in->jitter. Leaves g_app's clock, frame counter and mouse alone.
+void RenderRegion(const FrameInputs* in, int width, int height);
+// One output frame into dst_fbo: Render() directly, or at the dynamic-resolution scale
+// followed by the upscale pass, or this frame's progressive tiles and the image so far,
+// or while paused the next sample of the accumulated still and the still, then handed
+// to g_app.capture. Presenting is up to the caller.
+void RenderFrame(float timeSec, GLuint dst_fbo);
+// True while the scheduler should keep drawing with time stopped: a progressive pass
+// or a paused still is unfinished.
+bool SceneNeedsFrames(void);
+
+// What the compile tags name: graph passes, grid tiles or the single program (tag 0).
+// The name is the pass, the tile's file name or "program".
+int         ProgramCount(void);
+const char* ProgramName(int tag);
+
+// Hot reload glue shared by the front ends. WatchShaderFiles adds the shader files and
+// their includes (as of the last build) to g_app.watcher. SubmitChangedPrograms runs
+// after FileWatcherPoll (or with all=true for a manual reload) and queues rebuilds of
+// the single program or of the graph passes that include a changed file; false if
+// nothing was queued.
+void WatchShaderFiles(void);
+bool SubmitChangedPrograms(bool all, double requested_at);
+// Installs a finished build (the single program or its graph pass); false on a failed
+// build. An unchanged result installs nothing, counts in g_app.reloads_skipped and
+// returns true. Either way, starts watching any include the build came across, and
+// reports the outcome to g_app.telemetry_thread.
+bool ApplyCompileResult(const CompileResult* r);
+// After FileWatcherPoll: re-reads the user parameter file if it changed and applies it
+// to the live program(s). False if unchanged; a bad file keeps the old values and logs.
+bool ReloadChangedParams(char* log, int logsz);
+// Re-analyzes the fragment shader of a program (compile tag; 0 without a graph) as it
+// is on disk now, writes "cost <summary>" and what changed since its last analysis to
+// out, one item per line, and keeps the new report in g_app.cost. Returns how many
+// items are warnings (see DiffShaderCost), -1 if the shader could not be analyzed.
+int  UpdateShaderCost(int tag, char* out, int outsz);
+void FreeShaderCosts(void);
+
+// Makes c the source of image inputs and acquires the ones the user params and the
+// graph name; Detach releases the single program's (the graph releases its own when
+// destroyed). ReloadChangedParams re-acquires after a change.
+void AttachChannelTextures(TextureCache* c);
+void DetachChannelTextures(void);
+// Render thread, once per iteration: advances the loads and writes a line per finished
+// one to out ("texture <path> WxH loaded in 12.3 ms (decode 8.1 ms), 24.0 of 256 MB
+// resident", or the reason it failed). Returns how many finished: the picture changed.
+int  UpdateTextures(char* out, int outsz);
+// "tex 24.0/256 MB" (resident of budget), "" without a cache.
+void FormatTextureMemory(char* out, size_t outsz);
+
+// On the render thread, after the programs and g_app.gpu_timer exist: registers the
+// thread with t, hands it the GPU timer's samples and the hashes of the programs now
+// on screen. Detach stops the samples; the front end reports frames and reloads.
+void AttachTelemetry(Telemetry* t);
+void DetachTelemetry(void);
+
+#endif // SHADERDEVEL_APP_H
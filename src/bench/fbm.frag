@@ -0,0 +1,24 @@
+#version 330 core
+// Domain-warped fbm: three nested 8-octave value-noise sums per pixel.
+in vec2 vUV;
+out vec4 FragColor;
+
+layout(std140) uniform FrameInputs {
+    vec2  uResolution;
+    vec2  uMouse;
+    vec4  uDate;
+    float uTime;
+};
+
+#include "noise.glsl"
+
+void main() {
+    vec2 p = vUV * vec2(uResolution.x / uResolution.y, 1.0) * 3.0;
+    vec2 q = vec2(Fbm(p, 8), Fbm(p + vec2(5.2, 1.3), 8));
+    vec2 r = vec2(Fbm(p + 4.0 * q + vec2(1.7, 9.2) + 0.15 * uTime, 8),
+                  Fbm(p + 4.0 * q + vec2(8.3, 2.8) + 0.126 * uTime, 8));
+    float f = Fbm(p + 4.0 * r, 8);
+    vec3 col = mix(vec3(0.1, 0.3, 0.4), vec3(0.9, 0.8, 0.5), clamp(f * f * 2.0, 0.0, 1.0));
+    col = mix(col, vec3(0.0, 0.1, 0.2), clamp(length(q), 0.0, 1.0));
+    FragColor = vec4(col, 1.0);
+}
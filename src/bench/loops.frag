@@ -0,0 +1,30 @@
+#version 330 core
+// ALU- and branch-heavy: a Mandelbrot zoom with data-dependent early exit plus a fixed
+// trigonometric accumulation loop.
+in vec2 vUV;
+out vec4 FragColor;
+
+layout(std140) uniform FrameInputs {
+    vec2  uResolution;
+    vec2  uMouse;
+    vec4  uDate;
+    float uTime;
+};
+
+void main() {
+    vec2 p = (vUV * 2.0 - 1.0) * vec2(uResolution.x / uResolution.y, 1.0);
+    vec2 c = vec2(-0.745, 0.186) + p * (0.02 + 0.01 * sin(uTime * 0.1));
+    vec2 z = vec2(0.0);
+    int n = 0;
+    for (; n < 256; ++n) {
+        z = vec2(z.x * z.x - z.y * z.y, 2.0 * z.x * z.y) + c;
+        if (dot(z, z) > 16.0) break;
+    }
+    float acc = 0.0;
+    for (int i = 0; i < 64; ++i) {
+        float fi = float(i);
+        acc += sin(p.x * fi + uTime) * cos(p.y * fi * 0.7) / (1.0 + fi);
+    }
+    float m = float(n) / 256.0;
+    FragColor = vec4(vec3(m, m * m, sqrt(m)) + 0.05 * acc, 1.0);
+}
@@ -0,0 +1,26 @@
+// noise.glsl — value noise and fbm shared by the benchmark corpus
+#pragma once
+
+float Hash12(vec2 p) {
+    vec3 p3 = fract(vec3(p.xyx) * 0.1031);
+    p3 += dot(p3, p3.yzx + 33.33);
+    return fract((p3.x + p3.y) * p3.z);
+}
+
+float ValueNoise(vec2 p) {
+    vec2 i = floor(p), f = fract(p);
+    f = f * f * (3.0 - 2.0 * f);
+    return mix(mix(Hash12(i), Hash12(i + vec2(1.0, 0.0)), f.x),
+               mix(Hash12(i + vec2(0.0, 1.0)), Hash12(i + vec2(1.0, 1.0)), f.x), f.y);
+}
+
+float Fbm(vec2 p, int octaves) {
+    float sum = 0.0, amp = 0.5;
+    mat2 rot = mat2(0.8, 0.6, -0.6, 0.8);
+    for (int i = 0; i < octaves; ++i) {
+        sum += amp * ValueNoise(p);
+        p = rot * p * 2.03;
+        amp *= 0.5;
+    }
+    return sum;
+}
@@ -0,0 +1,69 @@
+#version 330 core
+// Sphere-traced SDF scene: a repeated field of rounded boxes over a noisy floor, soft shadows.
+in vec2 vUV;
+out vec4 FragColor;
+
+layout(std140) uniform FrameInputs {
+    vec2  uResolution;
+    vec2  uMouse;
+    vec4  uDate;
+    float uTime;
+};
+
+#include "noise.glsl"
+
+float SdRoundBox(vec3 p, vec3 b, float r) {
+    vec3 q = abs(p) - b;
+    return length(max(q, 0.0)) + min(max(q.x, max(q.y, q.z)), 0.0) - r;
+}
+
+float Map(vec3 p) {
+    vec3 c = p;
+    c.xz = mod(c.xz + 2.0, 4.0) - 2.0;
+    float boxes = SdRoundBox(c - vec3(0.0, 1.0, 0.0), vec3(0.6), 0.2);
+    float floor_ = p.y + 0.3 * ValueNoise(p.xz * 1.5);
+    return min(boxes, floor_);
+}
+
+vec3 Normal(vec3 p) {
+    const vec2 e = vec2(1e-3, 0.0);
+    return normalize(vec3(Map(p + e.xyy) - Map(p - e.xyy),
+                          Map(p + e.yxy) - Map(p - e.yxy),
+                          Map(p + e.yyx) - Map(p - e.yyx)));
+}
+
+float SoftShadow(vec3 ro, vec3 rd) {
+    float res = 1.0, t = 0.05;
+    for (int i = 0; i < 32; ++i) {
+        float h = Map(ro + rd * t);
+        res = min(res, 8.0 * h / t);
+        t += clamp(h, 0.02, 0.5);
+        if (res < 0.01 || t > 12.0) break;
+    }
+    return clamp(res, 0.0, 1.0);
+}
+
+void main() {
+    vec2 p = (vUV * 2.0 - 1.0) * vec2(uResolution.x / uResolution.y, 1.0);
+    vec3 ro = vec3(3.0 * sin(uTime * 0.2), 2.5, 3.0 * cos(uTime * 0.2) - 6.0);
+    vec3 fw = normalize(vec3(0.0, 0.8, 0.0) - ro);
+    vec3 rt = normalize(cross(fw, vec3(0.0, 1.0, 0.0)));
+    vec3 rd = normalize(p.x * rt + p.y * cross(rt, fw) + 1.6 * fw);
+
+    float t = 0.0;
+    bool hit = false;
+    for (int i = 0; i < 128; ++i) {
+        float d = Map(ro + rd * t);
+        if (d < 1e-3) { hit = true; break; }
+        t += d;
+        if (t > 40.0) break;
+    }
+    vec3 col = vec3(0.55, 0.7, 0.9) - 0.3 * rd.y;
+    if (hit) {
+        vec3 pos = ro + rd * t, n = Normal(pos);
+        vec3 light = normalize(vec3(0.6, 0.8, -0.3));
+        float diff = max(dot(n, light), 0.0) * SoftShadow(pos + n * 2e-3, light);
+        col = mix(vec3(0.9, 0.85, 0.8) * (0.15 + 0.85 * diff), col, 1.0 - exp(-0.02 * t * t));
+    }
+    FragColor = vec4(pow(col, vec3(0.4545)), 1.0);
+}
@@ -0,0 +1,26 @@
+#version 330 core
+// Bandwidth-bound: 48 dependent, mip-mapped lookups per pixel into the harness's
+// 512x512 RGBA8 noise texture (uBenchTex, unit 0) along a swirling path.
+in vec2 vUV;
+out vec4 FragColor;
+
+layout(std140) uniform FrameInputs {
+    vec2  uResolution;
+    vec2  uMouse;
+    vec4  uDate;
+    float uTime;
+};
+
+uniform sampler2D uBenchTex;
+
+void main() {
+    vec2 uv = vUV * 3.0;
+    vec4 acc = vec4(0.0);
+    for (int i = 0; i < 48; ++i) {
+        vec4 s = texture(uBenchTex, uv);
+        acc += s;
+        uv += (s.xy - 0.5) * 0.05 + vec2(0.013, 0.007) * uTime;
+        uv *= 1.01;
+    }
+    FragColor = vec4(acc.rgb / 48.0, 1.0);
+}
@@ -0,0 +1,291 @@
+// capture.c — see capture.h
+#include "capture.h"
+#include "profiler.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+// A readback that failed is SKIPPED rather than FREE: the writer consumes slots in ring
+// order and has to step past it to the frames queued behind.
+enum { SLOT_FREE, SLOT_IN_FLIGHT, SLOT_QUEUED, SLOT_SKIPPED };
+
+typedef struct {
+    GLuint   pbo;
+    GLsync   fence;
+    uint8_t* data;  // persistent mapping, or the copy taken after the fence
+    int      state; // under lock; only the GL thread leaves SLOT_FREE
+} CaptureSlot;
+
+struct FrameCapture {
+    FILE*       out;
+    bool        y4m;
+    int         width, height;
+    size_t      frame_bytes;   // RGBA readback
+    bool        persistent;
+    CaptureSlot slot[CAPTURE_RING];
+    int         head;          // next slot to read into (GL thread)
+    int         fence_tail;    // oldest slot in flight (GL thread)
+    int         in_flight;
+
+    Thread      writer;
+    int         write_tail;    // oldest slot queued (writer)
+    uint8_t*    yuv;           // writer's conversion buffer
+    Mutex       lock;
+    CondVar     wake;
+    bool        quit;
+    CaptureStats stats;        // under lock
+};
+
+// ============================ Writer ===============================
+static bool HasExtension(const char* path, const char* ext) {
+    size_t n = strlen(path), e = strlen(ext);
+    if (n < e) return false;
+    for (size_t i = 0; i < e; ++i)
+        if (tolower((unsigned char)path[n - e + i]) != ext[i]) return false;
+    return true;
+}
+
+static uint8_t ClampByte(int v) { return (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v); }
+
+// BT.601 limited range, chroma from the 2x2 average (an odd last row/column repeats).
+// rgba rows are bottom-up, the planes top-down.
+static void ConvertToI420(const uint8_t* rgba, int w, int h, uint8_t* yuv) {
+    int cw = (w + 1) / 2, ch = (h + 1) / 2;
+    uint8_t* py = yuv;
+    uint8_t* pu = py + (size_t)w * h;
+    uint8_t* pv = pu + (size_t)cw * ch;
+    for (int y = 0; y < h; ++y) {
+        const uint8_t* s = rgba + (size_t)(h - 1 - y) * w * 4;
+        uint8_t* d = py + (size_t)y * w;
+        for (int x = 0; x < w; ++x, s += 4)
+            d[x] = (uint8_t)(((66 * s[0] + 129 * s[1] + 25 * s[2] + 128) >> 8) + 16);
+    }
+    for (int cy = 0; cy < ch; ++cy) {
+        int y0 = 2 * cy, y1 = y0 + 1 < h ? y0 + 1 : y0;
+        const uint8_t* r0 = rgba + (size_t)(h - 1 - y0) * w * 4;
+        const uint8_t* r1 = rgba + (size_t)(h - 1 - y1) * w * 4;
+        for (int cx = 0; cx < cw; ++cx) {
+            int x0 = 8 * cx, x1 = 2 * cx + 1 < w ? x0 + 4 : x0;
+            int r = (r0[x0] + r0[x1] + r1[x0] + r1[x1] + 2) >> 2;
+            int g = (r0[x0 + 1] + r0[x1 + 1] + r1[x0 + 1] + r1[x1 + 1] + 2) >> 2;
+            int b = (r0[x0 + 2] + r0[x1 + 2] + r1[x0 + 2] + r1[x1 + 2] + 2) >> 2;
+            pu[(size_t)cy * cw + cx] = ClampByte(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            pv[(size_t)cy * cw + cx] = ClampByte(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+// Bytes written, 0 on a write error.
+static size_t WriteFrame(FrameCapture* c, const uint8_t* rgba) {
+    int w = c->width, h = c->height;
+    if (c->y4m) {
+        size_t size = (size_t)w * h + 2 * (size_t)((w + 1) / 2) * ((h + 1) / 2);
+        ConvertToI420(rgba, w, h, c->yuv);
+        if (fwrite("FRAME\n", 1, 6, c->out) != 6 || fwrite(c->yuv, 1, size, c->out) != size) return 0;
+        return size + 6;
+    }
+    size_t row = (size_t)w * 4;
+    for (int y = h - 1; y >= 0; --y)
+        if (fwrite(rgba + (size_t)y * row, 1, row, c->out) != row) return 0;
+    return row * h;
+}
+
+static void WriterMain(void* arg) {
+    FrameCapture* c = (FrameCapture*)arg;
+    PROFILE_THREAD("capture writer");
+    for (;;) {
+        CaptureSlot* s = &c->slot[c->write_tail];
+        MutexLock(&c->lock);
+        // Slots are handed over in ring order, so quitting with this one not handed over
+        // means everything has been written.
+        while (!c->quit && s->state != SLOT_QUEUED && s->state != SLOT_SKIPPED) CondWait(&c->wake, &c->lock);
+        if (s->state == SLOT_SKIPPED) {
+            s->state = SLOT_FREE;
+            MutexUnlock(&c->lock);
+            c->write_tail = (c->write_tail + 1) % CAPTURE_RING;
+            continue;
+        }
+        if (s->state != SLOT_QUEUED) { MutexUnlock(&c->lock); break; }
+        bool failed = c->stats.write_error;
+        MutexUnlock(&c->lock);
+
+        PROFILE_BEGIN("write frame");
+        size_t bytes = failed ? 0 : WriteFrame(c, s->data);
+        PROFILE_END();
+
+        MutexLock(&c->lock);
+        s->state = SLOT_FREE;
+        if (bytes) { ++c->stats.written; c->stats.bytes += bytes; }
+        else { c->stats.write_error = true; ++c->stats.dropped_writer; }
+        MutexUnlock(&c->lock);
+        c->write_tail = (c->write_tail + 1) % CAPTURE_RING;
+    }
+}
+
+// ============================ GL side ==============================
+// Hands every finished readback (oldest first) to the writer; wait=true blocks on them.
+static void CollectFinished(FrameCapture* c, bool wait) {
+    while (c->in_flight > 0) {
+        CaptureSlot* s = &c->slot[c->fence_tail];
+        GLenum r = glClientWaitSync(s->fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 1000000000ull : 0);
+        if (r == GL_TIMEOUT_EXPIRED) { if (wait) continue; break; }
+        glDeleteSync(s->fence);
+        s->fence = NULL;
+        bool ok = true;
+        if (!c->persistent) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, s->pbo);
+            const void* p = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)c->frame_bytes, GL_MAP_READ_BIT);
+            if (p) memcpy(s->data, p, c->frame_bytes);
+            ok = p && glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+        MutexLock(&c->lock);
+        s->state = ok ? SLOT_QUEUED : SLOT_SKIPPED;
+        if (!ok) ++c->stats.dropped_gpu;
+        CondSignal(&c->wake);
+        MutexUnlock(&c->lock);
+        c->fence_tail = (c->fence_tail + 1) % CAPTURE_RING;
+        --c->in_flight;
+    }
+}
+
+static void DestroySlots(FrameCapture* c) {
+    for (int i = 0; i < CAPTURE_RING; ++i) {
+        CaptureSlot* s = &c->slot[i];
+        if (s->fence) glDeleteSync(s->fence);
+        if (!s->pbo) continue;
+        if (c->persistent && s->data) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, s->pbo);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        } else {
+            free(s->data);
+        }
+        glDeleteBuffers(1, &s->pbo);
+    }
+}
+
+static bool CreateSlot(FrameCapture* c, CaptureSlot* s) {
+    GLsizeiptr size = (GLsizeiptr)c->frame_bytes;
+    glGenBuffers(1, &s->pbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s->pbo);
+    if (c->persistent) {
+        GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_PIXEL_PACK_BUFFER, size, NULL, flags);
+        s->data = (uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, flags);
+    } else {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+        s->data = (uint8_t*)malloc(c->frame_bytes);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return s->data != NULL;
+}
+
+FILE* CaptureOpenStream(const char* path, bool* out_y4m) {
+    *out_y4m = !strcmp(path, "-") || HasExtension(path, ".y4m");
+    return OpenWriteStream(path);
+}
+
+FrameCapture* FrameCaptureCreate(FILE* out, bool y4m, int width, int height, int fps, char* log, int logsz) {
+    if (log && logsz > 0) log[0] = 0;
+    if (width <= 0 || height <= 0 || fps <= 0) {
+        if (log) snprintf(log, logsz, "Bad capture size %dx%d at %d fps.", width, height, fps);
+        fclose(out);
+        return NULL;
+    }
+    FrameCapture* c = (FrameCapture*)calloc(1, sizeof(FrameCapture));
+    if (!c) { fclose(out); return NULL; }
+    c->out = out;
+    c->width = width;
+    c->height = height;
+    c->frame_bytes = (size_t)width * height * 4;
+    c->y4m = y4m;
+    c->persistent = GLAD_GL_ARB_buffer_storage != 0;
+    if (c->y4m) c->yuv = (uint8_t*)malloc((size_t)width * height + 2 * (size_t)((width + 1) / 2) * ((height + 1) / 2));
+    bool ok = !c->y4m || c->yuv;
+    for (int i = 0; i < CAPTURE_RING && ok; ++i) {
+        ok = CreateSlot(c, &c->slot[i]);
+        // A driver that won't map persistently still does the copying path.
+        if (!ok && c->persistent && i == 0) {
+            DestroySlots(c);
+            memset(&c->slot[0], 0, sizeof(c->slot[0]));
+            c->persistent = false;
+            ok = CreateSlot(c, &c->slot[0]);
+        }
+    }
+    if (!ok) {
+        if (log) snprintf(log, logsz, "Out of memory for %d %dx%d capture buffers.", CAPTURE_RING, width, height);
+        fclose(out); DestroySlots(c); free(c->yuv); free(c);
+        return NULL;
+    }
+    if (c->y4m && fprintf(out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps) < 0) {
+        if (log) snprintf(log, logsz, "Could not write the Y4M header.");
+        fclose(out); DestroySlots(c); free(c->yuv); free(c);
+        return NULL;
+    }
+    MutexInit(&c->lock);
+    CondInit(&c->wake);
+    if (!ThreadStart(&c->writer, WriterMain, c)) {
+        if (log) snprintf(log, logsz, "Could not start the capture writer thread.");
+        CondDestroy(&c->wake); MutexDestroy(&c->lock);
+        fclose(c->out); DestroySlots(c); free(c->yuv); free(c);
+        return NULL;
+    }
+    return c;
+}
+
+void FrameCaptureDestroy(FrameCapture* c, CaptureStats* stats) {
+    if (!c) return;
+    CollectFinished(c, true);
+    MutexLock(&c->lock);
+    c->quit = true;
+    CondBroadcast(&c->wake);
+    MutexUnlock(&c->lock);
+    ThreadJoin(c->writer);
+    if (fclose(c->out) != 0) c->stats.write_error = true;
+    if (stats) *stats = c->stats;
+    DestroySlots(c);
+    CondDestroy(&c->wake);
+    MutexDestroy(&c->lock);
+    free(c->yuv);
+    free(c);
+}
+
+void FrameCaptureGrab(FrameCapture* c, GLuint fbo, int width, int height) {
+    if (!c) return;
+    PROFILE_BEGIN("capture readback");
+    CollectFinished(c, false);
+    PROFILE_END();
+    CaptureSlot* s = &c->slot[c->head];
+    MutexLock(&c->lock);
+    ++c->stats.grabbed;
+    bool take = false;
+    if (width != c->width || height != c->height) ++c->stats.dropped_size;
+    else if (s->state == SLOT_IN_FLIGHT)           ++c->stats.dropped_gpu;
+    else if (s->state != SLOT_FREE)                ++c->stats.dropped_writer; // queued or skipped, not reached yet
+    else { s->state = SLOT_IN_FLIGHT; take = true; }
+    MutexUnlock(&c->lock);
+    if (!take) return;
+
+    GLint prev_read = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &prev_read);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, s->pbo);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)prev_read);
+    s->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    c->head = (c->head + 1) % CAPTURE_RING;
+    ++c->in_flight;
+}
+
+void FrameCaptureGetStats(FrameCapture* c, CaptureStats* out) {
+    MutexLock(&c->lock);
+    *out = c->stats;
+    MutexUnlock(&c->lock);
+}
+
+uint64_t FrameCaptureDropped(const CaptureStats* s) {
+    return s->dropped_gpu + s->dropped_writer + s->dropped_size;
+}
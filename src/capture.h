@@ -0,0 +1,54 @@
+// capture.h — streams output frames to a file or a pipe without stalling the renderer
+//
+// Each grabbed frame is read into the next of CAPTURE_RING pixel buffer objects with
+// a fence behind it; a later grab finds the fence signalled and hands the buffer to a
+// writer thread, which converts and writes it while the GL thread moves on. With
+// GL_ARB_buffer_storage the buffers stay mapped and the writer reads them in place;
+// otherwise the GL thread copies each one out once. When every buffer is still in
+// flight (GPU behind) or waiting to be written (disk or pipe behind), the frame is
+// dropped and counted instead of blocking.
+//
+// Output by file name:
+//   *.y4m  YUV4MPEG2, 4:2:0 BT.601 limited range, at the nominal frame rate
+//   -      the same Y4M on stdout:  shaderdevel --capture - ... | ffmpeg -i - out.mp4
+//   other  raw RGBA, top row first: ffmpeg -f rawvideo -pix_fmt rgba -s WxH -r FPS -i FILE
+// A raw stream has no header; every frame is width * height * 4 bytes.
+
+#ifndef SHADERDEVEL_CAPTURE_H
+#define SHADERDEVEL_CAPTURE_H
+
+#include "platform.h"
+#include <glad/gl.h>
+
+#define CAPTURE_RING 4 // frames between glReadPixels and the writer
+
+typedef struct FrameCapture FrameCapture;
+
+typedef struct {
+    uint64_t grabbed;        // FrameCaptureGrab calls
+    uint64_t written;
+    uint64_t dropped_gpu;    // every buffer still waiting on its fence
+    uint64_t dropped_writer; // every buffer still queued for the writer
+    uint64_t dropped_size;   // frame size differed from the stream's
+    uint64_t bytes;
+    bool     write_error;    // the writer stopped; later frames count as dropped_writer
+} CaptureStats;
+
+// The stream for path (OpenWriteStream) and whether it gets Y4M. Open it before
+// printing anything when path is "-".
+FILE*         CaptureOpenStream(const char* path, bool* out_y4m);
+
+// Needs a current context; takes out over, closing it even on failure. width x height
+// is fixed for the stream; fps only goes into the Y4M header. NULL with a message in
+// log on failure.
+FrameCapture* FrameCaptureCreate(FILE* out, bool y4m, int width, int height, int fps, char* log, int logsz);
+// Waits for the frames in flight, writes them, and closes the stream. stats may be NULL.
+void          FrameCaptureDestroy(FrameCapture* c, CaptureStats* stats);
+
+// Queues a readback of fbo's color buffer (0 = the back buffer) after the frame's
+// draws, and passes finished earlier ones to the writer. Never waits on the GPU.
+void          FrameCaptureGrab(FrameCapture* c, GLuint fbo, int width, int height);
+void          FrameCaptureGetStats(FrameCapture* c, CaptureStats* out);
+uint64_t      FrameCaptureDropped(const CaptureStats* s);
+
+#endif // SHADERDEVEL_CAPTURE_H
@@ -0,0 +1,444 @@
+// compiler.c — see compiler.h
+#include "compiler.h"
+#include "shader.h"
+#include "compute_pass.h"
+#include "render_target.h"
+#include "profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    int      tag;
+    char     vpath[APP_PATH_MAX];
+    char     fpath[APP_PATH_MAX];
+    double   requested_at;
+    uint64_t live_hash;
+    uint64_t seq; // submission order, oldest tag is built first
+} CompileRequest;
+
+// Newest pending request per tag.
+typedef struct {
+    CompileRequest req[COMPILER_MAX_TAGS];
+    bool           has[COMPILER_MAX_TAGS];
+    uint64_t       next_seq;
+} RequestQueue;
+
+struct ShaderCompiler {
+    CompilerMode     mode;
+
+    // Finished results handed to the render thread (all modes), one slot per tag.
+    Mutex            lock;
+    CompileResult*   results[COMPILER_MAX_TAGS];
+    volatile int32_t result_ready; // number of non-NULL results
+    void           (*notify)(void* user); // under lock
+    void*            notify_user;
+
+    // Worker thread mode.
+    ContextBindFn    bind;
+    void*            bind_user;
+    Thread           thread;
+    CondVar          wake;
+    RequestQueue     queue;
+    bool             stop;
+    int              worker_state; // 0 starting, 1 running, -1 could not bind its context
+    GLuint           warm_vao;     // worker context only
+    RenderTarget     warm_rt;      // worker context only
+
+    // Parallel KHR mode (render thread only).
+    bool             khr_busy;
+    GLuint           khr_vs, khr_fs, khr_prog; // khr_vs 0 for a compute program, khr_fs its stage
+    GLenum           khr_fs_type;
+    bool             khr_vs_new, khr_fs_new; // compiled for this build, not from the stage cache
+    uint64_t         khr_vs_hash, khr_fs_hash;
+    uint64_t         khr_cache_key; // valid when the program cache is on
+    CompileResult*   khr_result;    // of the build in flight, filled in by KhrFinish
+    ShaderFileTable* khr_files;     // source numbers of the build in flight, per stage
+    RequestQueue     khr_queue;
+};
+
+const char* CompilerModeName(CompilerMode mode) {
+    switch (mode) {
+    case COMPILER_WORKER_THREAD: return "worker thread";
+    case COMPILER_PARALLEL_KHR:  return "parallel KHR";
+    default:                     return "sync";
+    }
+}
+
+static void QueuePush(RequestQueue* q, const CompileRequest* req) {
+    q->req[req->tag] = *req; // latest wins
+    q->req[req->tag].seq = q->next_seq++;
+    q->has[req->tag] = true;
+}
+
+static bool QueuePop(RequestQueue* q, CompileRequest* out) {
+    int best = -1;
+    for (int i = 0; i < COMPILER_MAX_TAGS; ++i)
+        if (q->has[i] && (best < 0 || q->req[i].seq < q->req[best].seq)) best = i;
+    if (best < 0) return false;
+    *out = q->req[best];
+    q->has[best] = false;
+    return true;
+}
+
+// Caller holds c->lock. Takes ownership of r; replaces (and frees) any result with the
+// same tag the render thread hasn't picked up.
+static void PublishResultLocked(ShaderCompiler* c, CompileResult* r) {
+    CompileResult* old = c->results[r->tag];
+    if (old) {
+        if (old->program) glDeleteProgram(old->program);
+        free(old);
+    } else {
+        AtomicAdd32(&c->result_ready, 1);
+    }
+    c->results[r->tag] = r;
+    if (c->notify) c->notify(c->notify_user);
+}
+
+static void PublishResult(ShaderCompiler* c, CompileResult* r) {
+    MutexLock(&c->lock);
+    PublishResultLocked(c, r);
+    MutexUnlock(&c->lock);
+}
+
+static void CopyBuildInfo(CompileResult* r, const BuildInfo* info) {
+    r->cache_hit = info->cache_hit;
+    r->unchanged = info->unchanged;
+    r->source_hash = info->source_hash;
+    r->stages_compiled = info->stages_compiled;
+}
+
+// ========================= Worker thread ===========================
+// Drivers often defer the real compile to the first draw; do that draw here so the
+// render thread's first frame with the new program doesn't pay for it. A compute
+// program gets one workgroup writing into the same 8x8 image (compute_pass.h).
+static void WarmUpProgram(ShaderCompiler* c, GLuint prog, bool compute) {
+    if (!c->warm_vao) {
+        glGenVertexArrays(1, &c->warm_vao); // VAOs aren't shared between contexts
+        CreateRenderTarget(&c->warm_rt, 8, 8, GL_RGBA8);
+    }
+    glUseProgram(prog);
+    if (compute) {
+        glBindImageTexture(COMPUTE_OUTPUT_UNIT, c->warm_rt.color, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+        glDispatchCompute(1, 1, 1);
+        glBindImageTexture(COMPUTE_OUTPUT_UNIT, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    } else {
+        glBindFramebuffer(GL_FRAMEBUFFER, c->warm_rt.fbo);
+        glViewport(0, 0, c->warm_rt.width, c->warm_rt.height);
+        glBindVertexArray(c->warm_vao);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glBindVertexArray(0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+    glUseProgram(0);
+    // Completed on this context before the render thread can see the name.
+    glFinish();
+}
+
+static void CompilerThread(void* arg) {
+    ShaderCompiler* c = (ShaderCompiler*)arg;
+    PROFILE_THREAD("compiler");
+    bool bound = c->bind(c->bind_user, true);
+    MutexLock(&c->lock);
+    c->worker_state = bound ? 1 : -1;
+    CondBroadcast(&c->wake);
+    MutexUnlock(&c->lock);
+    if (!bound) return;
+
+    for (;;) {
+        CompileRequest req;
+        MutexLock(&c->lock);
+        while (!c->stop && !QueuePop(&c->queue, &req)) CondWait(&c->wake, &c->lock);
+        if (c->stop) { MutexUnlock(&c->lock); break; }
+        MutexUnlock(&c->lock);
+
+        CompileResult* r = (CompileResult*)calloc(1, sizeof(CompileResult));
+        if (!r) continue; // out of memory: this edit is dropped, the next one retries
+        PROFILE_BEGIN("build");
+        r->tag = req.tag;
+        r->requested_at = req.requested_at;
+        BuildInfo info = { .skip_hash = req.live_hash };
+        if (LoadAndBuildProgramFromFiles(req.vpath, req.fpath, &r->program, &info, r->log, sizeof(r->log)) && r->program) {
+            PROFILE_BEGIN("warm up");
+            WarmUpProgram(c, r->program, IsComputeShaderPath(req.fpath));
+            PROFILE_END();
+        }
+        PROFILE_END();
+        CopyBuildInfo(r, &info);
+        r->ready_at = NowSeconds();
+
+        MutexLock(&c->lock);
+        if (c->queue.has[r->tag]) {
+            // A newer edit arrived while we built this one; never show the stale version.
+            if (r->program) glDeleteProgram(r->program);
+            free(r);
+        } else {
+            PublishResultLocked(c, r);
+        }
+        MutexUnlock(&c->lock);
+    }
+
+    if (c->warm_vao) glDeleteVertexArrays(1, &c->warm_vao);
+    DestroyRenderTarget(&c->warm_rt);
+    c->bind(c->bind_user, false);
+}
+
+// ========================= Parallel KHR ============================
+static CompileResult* NewResult(const CompileRequest* req) {
+    CompileResult* r = (CompileResult*)calloc(1, sizeof(CompileResult));
+    if (!r) return NULL;
+    r->tag = req->tag;
+    r->requested_at = req->requested_at;
+    return r;
+}
+
+// The stage cache's object (pinned) if it has one, else a compile submitted without waiting.
+static GLuint KhrStage(GLenum type, const char* src, uint64_t* hash, bool* is_new) {
+    StageCache* sc = GetStageCache();
+    *hash = StageSourceHash(type, src);
+    GLuint sh = sc ? StageCacheFind(sc, type, *hash) : 0;
+    *is_new = sh == 0;
+    if (sh) return sh;
+    sh = glCreateShader(type);
+    glShaderSource(sh, 1, &src, NULL);
+    glCompileShader(sh);
+    return sh;
+}
+
+// The result is allocated up front, so a build that starts can always report.
+static void KhrStart(ShaderCompiler* c, const CompileRequest* req) {
+    char *vsrc = NULL, *fsrc = NULL;
+    CompileResult* r = NewResult(req);
+    if (!r) return; // out of memory: this edit is dropped, the next one retries
+    if (!LoadShaderSources(req->vpath, req->fpath, &vsrc, &fsrc, c->khr_files, r->log, sizeof(r->log))) {
+        r->ready_at = NowSeconds();
+        PublishResult(c, r);
+        return;
+    }
+    uint64_t source_hash = ProgramSourceHash(vsrc, fsrc);
+    if (req->live_hash && source_hash == req->live_hash) {
+        r->unchanged = true;
+        r->source_hash = source_hash;
+        r->ready_at = NowSeconds();
+        PublishResult(c, r);
+        free(vsrc); free(fsrc);
+        return;
+    }
+    ProgramCache* cache = GetProgramCache();
+    if (cache) {
+        // glProgramBinary is cheap enough to do inline; only a miss goes parallel.
+        c->khr_cache_key = ProgramCacheKey(cache, vsrc, fsrc);
+        GLuint cached = ProgramCacheLoad(cache, c->khr_cache_key);
+        if (cached) {
+            r->program = cached;
+            r->cache_hit = true;
+            r->source_hash = source_hash;
+            r->ready_at = NowSeconds();
+            PublishResult(c, r);
+            free(vsrc); free(fsrc);
+            return;
+        }
+    }
+
+    // None of these block with KHR_parallel_shader_compile; status queries would.
+    c->khr_fs_type = vsrc ? GL_FRAGMENT_SHADER : GL_COMPUTE_SHADER;
+    c->khr_vs_new = false;
+    c->khr_vs = vsrc ? KhrStage(GL_VERTEX_SHADER, vsrc, &c->khr_vs_hash, &c->khr_vs_new) : 0;
+    c->khr_fs = KhrStage(c->khr_fs_type, fsrc, &c->khr_fs_hash, &c->khr_fs_new);
+    c->khr_prog = glCreateProgram();
+    if (cache) glProgramParameteri(c->khr_prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    if (c->khr_vs) glAttachShader(c->khr_prog, c->khr_vs);
+    glAttachShader(c->khr_prog, c->khr_fs);
+    // Attached, the cache's objects outlive an eviction until KhrFinish detaches them.
+    StageCache* sc = GetStageCache();
+    if (sc && c->khr_vs && !c->khr_vs_new) StageCacheRelease(sc, c->khr_vs);
+    if (sc && !c->khr_fs_new) StageCacheRelease(sc, c->khr_fs);
+    glLinkProgram(c->khr_prog);
+    r->source_hash = source_hash;
+    r->stages_compiled = c->khr_vs_new + c->khr_fs_new;
+    c->khr_result = r;
+    c->khr_busy = true;
+    free(vsrc); free(fsrc);
+}
+
+// A stage compiled for the finished build: kept by the stage cache if it compiled
+// (even when the other stage didn't, so fixing that one recompiles only it).
+static void KhrReleaseStage(GLuint prog, GLenum type, GLuint sh, uint64_t hash, bool is_new, bool linked) {
+    StageCache* sc = GetStageCache();
+    if (linked) glDetachShader(prog, sh);
+    if (!is_new) return; // the cache's
+    GLint ok = 0;
+    glGetShaderiv(sh, GL_COMPILE_STATUS, &ok);
+    if (sc && ok) { StageCacheInsert(sc, type, hash, sh); StageCacheRelease(sc, sh); }
+    else glDeleteShader(sh);
+}
+
+static void KhrFinish(ShaderCompiler* c) {
+    GLint done = 0;
+    glGetProgramiv(c->khr_prog, GL_COMPLETION_STATUS_KHR, &done);
+    if (!done) return;
+
+    CompileResult* r = c->khr_result;
+    c->khr_result = NULL;
+    GLint ok = 0;
+    glGetProgramiv(c->khr_prog, GL_LINK_STATUS, &ok);
+    if (ok) {
+        r->program = c->khr_prog;
+        if (GetProgramCache()) ProgramCacheStore(GetProgramCache(), c->khr_cache_key, r->program);
+    } else {
+        // Report the first stage that failed to compile, else the link log.
+        GLint vs_ok = 1, fs_ok = 0;
+        if (c->khr_vs) glGetShaderiv(c->khr_vs, GL_COMPILE_STATUS, &vs_ok);
+        glGetShaderiv(c->khr_fs, GL_COMPILE_STATUS, &fs_ok);
+        GLenum failed = !vs_ok ? GL_VERTEX_SHADER : !fs_ok ? c->khr_fs_type : 0;
+        if (!vs_ok)      glGetShaderInfoLog(c->khr_vs, sizeof(r->log), NULL, r->log);
+        else if (!fs_ok) glGetShaderInfoLog(c->khr_fs, sizeof(r->log), NULL, r->log);
+        else             glGetProgramInfoLog(c->khr_prog, sizeof(r->log), NULL, r->log);
+        MapBuildLog(c->khr_files, failed, r->log, sizeof(r->log));
+    }
+    if (c->khr_vs) KhrReleaseStage(c->khr_prog, GL_VERTEX_SHADER, c->khr_vs, c->khr_vs_hash, c->khr_vs_new, ok);
+    KhrReleaseStage(c->khr_prog, c->khr_fs_type, c->khr_fs, c->khr_fs_hash, c->khr_fs_new, ok);
+    if (!ok) glDeleteProgram(c->khr_prog);
+    c->khr_vs = c->khr_fs = c->khr_prog = 0;
+    c->khr_busy = false;
+    r->ready_at = NowSeconds();
+
+    if (c->khr_queue.has[r->tag]) {
+        // Superseded while it compiled.
+        if (r->program) glDeleteProgram(r->program);
+        free(r);
+    } else {
+        PublishResult(c, r);
+    }
+}
+
+static void KhrAdvance(ShaderCompiler* c) {
+    if (c->khr_busy) KhrFinish(c);
+    // Cache hits and read errors complete inside KhrStart; keep going until one is in flight.
+    CompileRequest next;
+    while (!c->khr_busy && QueuePop(&c->khr_queue, &next)) KhrStart(c, &next);
+}
+
+// ============================ Public API ===========================
+ShaderCompiler* ShaderCompilerCreate(ContextBindFn bind_worker, void* user) {
+    ShaderCompiler* c = (ShaderCompiler*)calloc(1, sizeof(ShaderCompiler));
+    if (!c) return NULL;
+    MutexInit(&c->lock);
+    CondInit(&c->wake);
+    c->mode = COMPILER_SYNC;
+
+    if (bind_worker) {
+        c->bind = bind_worker;
+        c->bind_user = user;
+        if (ThreadStart(&c->thread, CompilerThread, c)) {
+            MutexLock(&c->lock);
+            while (c->worker_state == 0) CondWait(&c->wake, &c->lock);
+            MutexUnlock(&c->lock);
+            if (c->worker_state > 0) { c->mode = COMPILER_WORKER_THREAD; return c; }
+            ThreadJoin(c->thread);
+        }
+    }
+    // Without memory for the source numbers KHR mode can't map logs; sync needs none.
+    bool parallel = GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile;
+    if (parallel && (c->khr_files = (ShaderFileTable*)malloc(2 * sizeof(ShaderFileTable)))) {
+        if (GLAD_GL_KHR_parallel_shader_compile) glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu); // let the driver pick
+        else glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+        c->mode = COMPILER_PARALLEL_KHR;
+    }
+    return c;
+}
+
+void ShaderCompilerDestroy(ShaderCompiler* c) {
+    if (!c) return;
+    if (c->mode == COMPILER_WORKER_THREAD) {
+        MutexLock(&c->lock);
+        c->stop = true;
+        CondSignal(&c->wake);
+        MutexUnlock(&c->lock);
+        ThreadJoin(c->thread);
+    }
+    if (c->khr_busy) {
+        if (c->khr_vs_new) glDeleteShader(c->khr_vs);
+        if (c->khr_fs_new) glDeleteShader(c->khr_fs);
+        glDeleteProgram(c->khr_prog);
+        free(c->khr_result);
+    }
+    free(c->khr_files);
+    for (int i = 0; i < COMPILER_MAX_TAGS; ++i) {
+        if (!c->results[i]) continue;
+        if (c->results[i]->program) glDeleteProgram(c->results[i]->program);
+        free(c->results[i]);
+    }
+    CondDestroy(&c->wake);
+    MutexDestroy(&c->lock);
+    free(c);
+}
+
+CompilerMode ShaderCompilerGetMode(const ShaderCompiler* c) { return c->mode; }
+
+void ShaderCompilerSubmit(ShaderCompiler* c, const char* vpath, const char* fpath, uint64_t live_hash, double requested_at) {
+    ShaderCompilerSubmitTagged(c, 0, vpath, fpath, live_hash, requested_at);
+}
+
+void ShaderCompilerSubmitTagged(ShaderCompiler* c, int tag, const char* vpath, const char* fpath, uint64_t live_hash, double requested_at) {
+    if (tag < 0 || tag >= COMPILER_MAX_TAGS) return;
+    CompileRequest req;
+    req.tag = tag;
+    req.seq = 0;
+    snprintf(req.vpath, sizeof(req.vpath), "%s", vpath);
+    snprintf(req.fpath, sizeof(req.fpath), "%s", fpath);
+    req.requested_at = requested_at;
+    req.live_hash = live_hash;
+
+    switch (c->mode) {
+    case COMPILER_WORKER_THREAD:
+        MutexLock(&c->lock);
+        QueuePush(&c->queue, &req);
+        CondSignal(&c->wake);
+        MutexUnlock(&c->lock);
+        break;
+    case COMPILER_PARALLEL_KHR:
+        if (c->khr_busy) QueuePush(&c->khr_queue, &req);
+        else KhrStart(c, &req);
+        break;
+    case COMPILER_SYNC: {
+        CompileResult* r = (CompileResult*)calloc(1, sizeof(CompileResult));
+        if (!r) break; // out of memory: this edit is dropped, the next one retries
+        r->tag = tag;
+        r->requested_at = requested_at;
+        BuildInfo info = { .skip_hash = live_hash };
+        LoadAndBuildProgramFromFiles(vpath, fpath, &r->program, &info, r->log, sizeof(r->log));
+        CopyBuildInfo(r, &info);
+        r->ready_at = NowSeconds();
+        PublishResult(c, r);
+    } break;
+    }
+}
+
+bool ShaderCompilerPoll(ShaderCompiler* c, CompileResult* out) {
+    if (c->mode == COMPILER_PARALLEL_KHR) KhrAdvance(c);
+    if (!AtomicLoad32(&c->result_ready)) return false;
+    MutexLock(&c->lock);
+    CompileResult* r = NULL;
+    for (int i = 0; i < COMPILER_MAX_TAGS && !r; ++i) {
+        if (!c->results[i]) continue;
+        r = c->results[i];
+        c->results[i] = NULL;
+    }
+    if (r) AtomicAdd32(&c->result_ready, -1);
+    MutexUnlock(&c->lock);
+    if (!r) return false;
+    *out = *r;
+    free(r);
+    return true;
+}
+
+void ShaderCompilerSetNotify(ShaderCompiler* c, void (*fn)(void* user), void* user) {
+    MutexLock(&c->lock);
+    c->notify = fn;
+    c->notify_user = user;
+    MutexUnlock(&c->lock);
+}
+
+bool ShaderCompilerNeedsPolling(const ShaderCompiler* c) { return c->mode == COMPILER_PARALLEL_KHR && c->khr_busy; }
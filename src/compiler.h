@@ -0,0 +1,69 @@
+// compiler.h — off-render-thread shader builds with a stall-free program swap
+//
+// Three backends, picked at creation:
+//   worker thread — a second GL context sharing objects with the render context
+//                   compiles, links and warms the program (one draw) off-thread;
+//   parallel KHR  — GL_KHR_parallel_shader_compile: submit on the render thread,
+//                   poll GL_COMPLETION_STATUS_KHR each frame without blocking;
+//   sync          — the old blocking path, for drivers with neither.
+// In every mode the render thread keeps drawing the old program until Poll hands
+// over a finished one; only the newest request per tag is delivered (latest wins),
+// so independent programs (render graph passes) can rebuild side by side.
+
+#ifndef SHADERDEVEL_COMPILER_H
+#define SHADERDEVEL_COMPILER_H
+
+#include "platform.h"
+#include <glad/gl.h>
+
+#define COMPILE_LOG_SIZE  4096
+#define COMPILER_MAX_TAGS 64 // graph passes or grid tiles
+
+typedef enum {
+    COMPILER_WORKER_THREAD,
+    COMPILER_PARALLEL_KHR,
+    COMPILER_SYNC,
+} CompilerMode;
+
+typedef struct {
+    int    tag;                   // as passed to ShaderCompilerSubmitTagged (0 for Submit)
+    GLuint program;               // 0 when the build failed
+    char   log[COMPILE_LOG_SIZE]; // driver/info log on failure
+    double requested_at;          // NowSeconds() of the change that asked for this build
+    double ready_at;              // NowSeconds() when it became swappable
+    bool   cache_hit;             // came from the program binary cache
+    bool   unchanged;             // sources hash to the live_hash submitted: nothing built, program 0
+    uint64_t source_hash;         // ProgramSourceHash of what was built
+    int    stages_compiled;       // stages not found in the stage cache
+} CompileResult;
+
+// Called on the worker thread: bind=true makes the shared context current, false releases it.
+typedef bool (*ContextBindFn)(void* user, bool bind);
+
+typedef struct ShaderCompiler ShaderCompiler;
+
+// bind_worker may be NULL (no shared context available); then KHR or sync is used.
+// Must be called on the render thread with its context current. NULL when out of memory.
+ShaderCompiler* ShaderCompilerCreate(ContextBindFn bind_worker, void* user);
+void            ShaderCompilerDestroy(ShaderCompiler* c);
+CompilerMode    ShaderCompilerGetMode(const ShaderCompiler* c);
+const char*     CompilerModeName(CompilerMode mode);
+
+// Queues a build of the two files. Never blocks in worker/KHR mode. live_hash is the
+// source hash of the program currently shown (0 if none): when the expanded sources
+// still hash to it the result comes back unchanged and nothing is compiled.
+void ShaderCompilerSubmit(ShaderCompiler* c, const char* vpath, const char* fpath, uint64_t live_hash, double requested_at);
+// Same, for program number tag (0..COMPILER_MAX_TAGS-1); a newer request with the same
+// tag supersedes an older one, different tags don't affect each other.
+void ShaderCompilerSubmitTagged(ShaderCompiler* c, int tag, const char* vpath, const char* fpath, uint64_t live_hash, double requested_at);
+// Render thread, once per frame (call until false to drain): one atomic load when
+// nothing finished. On true the caller owns out->program (if non-zero) and should
+// swap it in for out->tag.
+bool ShaderCompilerPoll(ShaderCompiler* c, CompileResult* out);
+// fn(user) runs whenever a result becomes ready, on whichever thread finished it, so a
+// loop that sleeps between frames can wake up for it (NULL to stop).
+void ShaderCompilerSetNotify(ShaderCompiler* c, void (*fn)(void* user), void* user);
+// A parallel-KHR build is in flight: it only finishes through Poll, so keep polling.
+bool ShaderCompilerNeedsPolling(const ShaderCompiler* c);
+
+#endif // SHADERDEVEL_COMPILER_H
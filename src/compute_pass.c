@@ -0,0 +1,90 @@
+// compute_pass.c — see compute_pass.h
+#include "compute_pass.h"
+#include "shader.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Fullscreen triangle from gl_VertexID, no vertex buffer needed.
+static const char* kBlitVert =
+    "#version 330 core\n"
+    "void main() {\n"
+    "    vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+    "    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);\n"
+    "}\n";
+
+// The viewport starts at the image's origin, so pixels map one to one.
+static const char* kBlitFrag =
+    "#version 330 core\n"
+    "out vec4 FragColor;\n"
+    "uniform sampler2D uSource;\n"
+    "void main() {\n"
+    "    FragColor = texelFetch(uSource, ivec2(gl_FragCoord.xy), 0);\n"
+    "}\n";
+
+bool ComputeShadersSupported(void) {
+    // The loader is generated for 3.3 core; 4.3 contexts list both extensions too.
+    return GLAD_GL_ARB_compute_shader && GLAD_GL_ARB_shader_image_load_store;
+}
+
+bool ComputePassInit(ComputePass* cp, char* log, int logsz) {
+    memset(cp, 0, sizeof(*cp));
+    if (!ComputeShadersSupported()) {
+        snprintf(log, logsz, "Compute shaders need ARB_compute_shader and ARB_shader_image_load_store (OpenGL 4.3); this context is %s.",
+                 (const char*)glGetString(GL_VERSION));
+        return false;
+    }
+    GLuint vs = CompileShader(GL_VERTEX_SHADER, kBlitVert, log, logsz);
+    if (!vs) return false;
+    GLuint fs = CompileShader(GL_FRAGMENT_SHADER, kBlitFrag, log, logsz);
+    if (!fs) { glDeleteShader(vs); return false; }
+    cp->blit_prog = LinkProgram(vs, fs, log, logsz);
+    glDeleteShader(vs); glDeleteShader(fs);
+    if (!cp->blit_prog) return false;
+
+    glUseProgram(cp->blit_prog);
+    glUniform1i(glGetUniformLocation(cp->blit_prog, "uSource"), 0);
+    glGenVertexArrays(1, &cp->empty_vao); // core profile draws need a VAO bound
+    cp->local_size[0] = cp->local_size[1] = cp->local_size[2] = 1;
+    return true;
+}
+
+void ComputePassShutdown(ComputePass* cp) {
+    DestroyRenderTarget(&cp->image);
+    if (cp->blit_prog) { glDeleteProgram(cp->blit_prog); cp->blit_prog = 0; }
+    if (cp->empty_vao) { glDeleteVertexArrays(1, &cp->empty_vao); cp->empty_vao = 0; }
+}
+
+void ComputePassSetProgram(ComputePass* cp, GLuint prog) {
+    cp->local_size[0] = cp->local_size[1] = cp->local_size[2] = 1;
+    if (prog) glGetProgramiv(prog, GL_COMPUTE_WORK_GROUP_SIZE, cp->local_size);
+}
+
+bool ComputePassDispatch(ComputePass* cp, int width, int height) {
+    if (width > cp->image.width || height > cp->image.height) {
+        int w = width > cp->image.width ? width : cp->image.width;
+        int h = height > cp->image.height ? height : cp->image.height;
+        GLint dst = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &dst); // creating a target unbinds it
+        DestroyRenderTarget(&cp->image);
+        bool ok = CreateRenderTarget(&cp->image, w, h, GL_RGBA8);
+        glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)dst);
+        if (!ok) return false;
+    }
+    glBindImageTexture(COMPUTE_OUTPUT_UNIT, cp->image.color, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    GLuint gx = (GLuint)((width + cp->local_size[0] - 1) / cp->local_size[0]);
+    GLuint gy = (GLuint)((height + cp->local_size[1] - 1) / cp->local_size[1]);
+    glDispatchCompute(gx, gy, 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT); // the blit reads what the stores wrote
+    return true;
+}
+
+void ComputePassPresent(ComputePass* cp, int width, int height) {
+    if (!cp->image.color) return;
+    glViewport(0, 0, width, height);
+    glUseProgram(cp->blit_prog);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, cp->image.color);
+    glBindVertexArray(cp->empty_vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
@@ -0,0 +1,57 @@
+// compute_pass.h — a compute shader as the scene: dispatched into an image, then blitted
+//
+// A program built from a .comp file (IsComputeShaderPath) stands in for the fullscreen
+// quad. Each frame it is dispatched over ceil(width / local_size_x) x ceil(height /
+// local_size_y) workgroups and writes its pixels at gl_GlobalInvocationID.xy into
+//
+//   layout(rgba8, binding = 0) uniform writeonly image2D uOutput;
+//
+// and a trivial blit copies the width x height corner of that image into the bound
+// framebuffer, so whatever follows a draw (dynamic resolution, the accumulation blend,
+// capture) works as before. The image only grows; invocations past the frame's edge
+// land outside it or outside what is blitted, so a shader needs no bounds check unless
+// it skips work. Inputs are the fragment path's: the FrameInputs block (uTileOffset and
+// uJitter apply to gl_GlobalInvocationID like to gl_FragCoord), the loose uniforms, the
+// user parameters and iChannelN.
+//
+// The local size is declared as
+//
+//   layout(local_size_x = LOCAL_SIZE_X, local_size_y = LOCAL_SIZE_Y) in;
+//
+// with both defined by the loader (shader.h) unless --variant or a tuning run defines
+// them, which is how LocalSizeVariantSpace (variants.h) rebuilds it at other shapes.
+// Needs ARB_compute_shader and ARB_shader_image_load_store (core in GL 4.3).
+
+#ifndef SHADERDEVEL_COMPUTE_PASS_H
+#define SHADERDEVEL_COMPUTE_PASS_H
+
+#include "platform.h"
+#include "render_target.h"
+#include <glad/gl.h>
+
+#define COMPUTE_OUTPUT_UNIT 0 // image unit of uOutput
+
+typedef struct {
+    RenderTarget image;         // GL_RGBA8, at least the largest frame so far
+    int          local_size[3]; // of the current program, from GL_COMPUTE_WORK_GROUP_SIZE
+    GLuint       blit_prog, empty_vao;
+} ComputePass;
+
+// The context can run compute shaders and store to images.
+bool ComputeShadersSupported(void);
+
+// Needs a current context. False (with log) without compute support or if the blit
+// shader fails to build.
+bool ComputePassInit(ComputePass* cp, char* log, int logsz);
+void ComputePassShutdown(ComputePass* cp);
+
+// After every new program: reads its local size.
+void ComputePassSetProgram(ComputePass* cp, GLuint prog);
+// Dispatches the current program (bound, uniforms set) over width x height of the
+// image, growing it first if needed. False if the image could not be allocated.
+bool ComputePassDispatch(ComputePass* cp, int width, int height);
+// Copies (0, 0, width, height) of the image to the same place in the bound framebuffer.
+// Leaves the blit program and an empty VAO bound.
+void ComputePassPresent(ComputePass* cp, int width, int height);
+
+#endif // SHADERDEVEL_COMPUTE_PASS_H
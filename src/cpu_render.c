@@ -0,0 +1,149 @@
+// cpu_render.c — see cpu_render.h
+#include "cpu_render.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    CpuRenderer* r;
+    Thread       thread;
+    float*       regs;
+    int          nregs;
+} Worker;
+
+struct CpuRenderer {
+    int      threads;
+    Worker*  worker;       // [0] is the calling thread
+    Mutex    lock;
+    CondVar  start, done;
+    int      generation;   // bumped per frame, under lock
+    int      running;      // workers still on the current frame
+    bool     quit;
+
+    // The current frame, fixed while it renders.
+    const CpuShader* shader;
+    int      width, height, tiles_x, tiles;
+    uint8_t* rgba;
+    volatile int32_t next_tile;
+    volatile int32_t failed;
+};
+
+static uint8_t ToByte(float v) {
+    v = v < 0.f ? 0.f : v > 1.f ? 1.f : v;
+    return (uint8_t)(v * 255.f + 0.5f);
+}
+
+static void RenderTiles(CpuRenderer* r, Worker* w) {
+    const CpuShader* s = r->shader;
+    CpuShaderInfo info;
+    CpuShaderGetInfo(s, &info);
+    if (w->nregs < info.registers) {
+        free(w->regs);
+        w->regs = CpuShaderAllocRegisters(s);
+        w->nregs = w->regs ? info.registers : 0;
+        if (!w->regs) { AtomicStore32(&r->failed, 1); return; }
+    }
+    CpuShaderBeginFrame(s, w->regs);
+    float rgba[4][CPU_LANES];
+    for (;;) {
+        int tile = AtomicAdd32(&r->next_tile, 1) - 1;
+        if (tile >= r->tiles) break;
+        int x0 = (tile % r->tiles_x) * CPU_RENDER_TILE, y0 = (tile / r->tiles_x) * CPU_RENDER_TILE;
+        int x1 = x0 + CPU_RENDER_TILE < r->width ? x0 + CPU_RENDER_TILE : r->width;
+        int y1 = y0 + CPU_RENDER_TILE < r->height ? y0 + CPU_RENDER_TILE : r->height;
+        for (int by = y0; by < y1; by += CPU_BLOCK) {
+            for (int bx = x0; bx < x1; bx += CPU_BLOCK) {
+                CpuShaderShadeBlock(s, w->regs, bx, by, r->width, r->height, rgba);
+                // Edge blocks hang over the frame; their extra lanes are dropped.
+                for (int lane = 0; lane < CPU_LANES; ++lane) {
+                    int x = bx + lane % CPU_BLOCK, y = by + lane / CPU_BLOCK;
+                    if (x >= x1 || y >= y1) continue;
+                    uint8_t* p = r->rgba + ((size_t)y * (size_t)r->width + (size_t)x) * 4;
+                    for (int k = 0; k < 4; ++k) p[k] = ToByte(rgba[k][lane]);
+                }
+            }
+        }
+    }
+}
+
+static void WorkerMain(void* arg) {
+    Worker* w = (Worker*)arg;
+    CpuRenderer* r = w->r;
+    int seen = 0;
+    for (;;) {
+        MutexLock(&r->lock);
+        while (!r->quit && r->generation == seen) CondWait(&r->start, &r->lock);
+        if (r->quit) { MutexUnlock(&r->lock); break; }
+        seen = r->generation;
+        MutexUnlock(&r->lock);
+
+        RenderTiles(r, w);
+
+        MutexLock(&r->lock);
+        if (--r->running == 0) CondSignal(&r->done);
+        MutexUnlock(&r->lock);
+    }
+    free(w->regs);
+}
+
+CpuRenderer* CpuRendererCreate(int threads) {
+    if (threads <= 0) threads = CpuCount();
+    if (threads < 1) threads = 1;
+    CpuRenderer* r = (CpuRenderer*)calloc(1, sizeof(CpuRenderer));
+    if (!r) return NULL;
+    r->worker = (Worker*)calloc((size_t)threads, sizeof(Worker));
+    if (!r->worker) { free(r); return NULL; }
+    MutexInit(&r->lock);
+    CondInit(&r->start);
+    CondInit(&r->done);
+    r->threads = 1;
+    r->worker[0].r = r;
+    for (int i = 1; i < threads; ++i) {
+        r->worker[i].r = r;
+        if (!ThreadStart(&r->worker[i].thread, WorkerMain, &r->worker[i])) break;
+        r->threads = i + 1;
+    }
+    return r;
+}
+
+void CpuRendererDestroy(CpuRenderer* r) {
+    if (!r) return;
+    MutexLock(&r->lock);
+    r->quit = true;
+    CondBroadcast(&r->start);
+    MutexUnlock(&r->lock);
+    for (int i = 1; i < r->threads; ++i) ThreadJoin(r->worker[i].thread);
+    free(r->worker[0].regs);
+    CondDestroy(&r->done);
+    CondDestroy(&r->start);
+    MutexDestroy(&r->lock);
+    free(r->worker);
+    free(r);
+}
+
+int CpuRendererThreads(const CpuRenderer* r) { return r->threads; }
+
+bool CpuRenderFrame(CpuRenderer* r, const CpuShader* shader, int width, int height, uint8_t* rgba) {
+    if (width <= 0 || height <= 0) return true;
+    r->shader = shader;
+    r->width = width;
+    r->height = height;
+    r->tiles_x = (width + CPU_RENDER_TILE - 1) / CPU_RENDER_TILE;
+    r->tiles = r->tiles_x * ((height + CPU_RENDER_TILE - 1) / CPU_RENDER_TILE);
+    r->rgba = rgba;
+    AtomicStore32(&r->next_tile, 0);
+    AtomicStore32(&r->failed, 0);
+
+    MutexLock(&r->lock);
+    r->running = r->threads - 1;
+    ++r->generation;
+    CondBroadcast(&r->start);
+    MutexUnlock(&r->lock);
+
+    RenderTiles(r, &r->worker[0]);
+
+    MutexLock(&r->lock);
+    while (r->running > 0) CondWait(&r->done, &r->lock);
+    MutexUnlock(&r->lock);
+    return !AtomicLoad32(&r->failed);
+}
@@ -0,0 +1,26 @@
+// cpu_render.h — renders a CpuShader over a frame on a pool of worker threads
+//
+// The frame is cut into CPU_RENDER_TILE square tiles that the workers (and the calling
+// thread) take from a shared counter until none are left, so a slow region of the
+// image doesn't hold up the rest. Each thread owns a register file; the shader is
+// shared read-only.
+
+#ifndef SHADERDEVEL_CPU_RENDER_H
+#define SHADERDEVEL_CPU_RENDER_H
+
+#include "cpu_shader.h"
+
+#define CPU_RENDER_TILE 32 // pixels, a multiple of CPU_BLOCK
+
+typedef struct CpuRenderer CpuRenderer;
+
+// threads <= 0: one per logical CPU. The calling thread counts as one of them.
+CpuRenderer* CpuRendererCreate(int threads);
+void         CpuRendererDestroy(CpuRenderer* r);
+int          CpuRendererThreads(const CpuRenderer* r);
+
+// Shades every pixel into rgba (width * height * 4 bytes, rows bottom-up like
+// glReadPixels) with the shader's current uniforms. Returns false if out of memory.
+bool CpuRenderFrame(CpuRenderer* r, const CpuShader* shader, int width, int height, uint8_t* rgba);
+
+#endif // SHADERDEVEL_CPU_RENDER_H
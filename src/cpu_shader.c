@@ -0,0 +1,2317 @@
+// cpu_shader.c — see cpu_shader.h
+//
+// Compilation is a single recursive-descent pass over the token stream that emits IR
+// directly; there is no syntax tree. A function call re-parses the callee's body at
+// the call site (inlining it with fresh registers), and a for loop re-parses its step
+// expression after the body. Operations on constants are folded as they are emitted.
+#include "cpu_shader.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define SIMD_NAME "AVX"
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#define SIMD_NAME "SSE4.1"
+#else
+#define SIMD_NAME "SSE2"
+#endif
+#define USE_SSE 1
+#else
+#define SIMD_NAME "scalar"
+#endif
+
+#define MAX_COMPONENTS 16  // a mat4
+#define MAX_PARAMS     16
+#define MAX_FRAMES     256
+#define MAX_CALLS      64  // inlining depth; GLSL has no recursion, so deeper means a cycle
+#define MAX_EXITS      256
+#define MAX_UNIFORMS   128
+#define MAX_MACROS     256
+#define MAX_COND_DEPTH 32
+#define ARITH_IMOD     0xFFFF // Arith(): int %, which has no IR op of its own
+
+// ============================ IR ===================================
+typedef enum {
+    OP_MOV, OP_SEL,                               // d = a; d = c ? a : b
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MAD,       // MAD: d = a * b + c
+    OP_MIN, OP_MAX, OP_NEG, OP_ABS, OP_FLOOR, OP_TRUNC, OP_SQRT, OP_RSQ,
+    OP_SIN, OP_COS, OP_TAN, OP_ASIN, OP_ACOS, OP_ATAN, OP_ATAN2,
+    OP_EXP, OP_EXP2, OP_LOG, OP_LOG2, OP_POW,
+    OP_LT, OP_LE, OP_EQ, OP_NE,                   // 1.0 or 0.0
+    OP_AND, OP_OR, OP_NOT, OP_ANDNOT,             // on 0/1 values; ANDNOT: a && !b
+    OP_DDX, OP_DDY,                               // across the 2x2 quads of the block
+    OP_JMP, OP_JZ, OP_JNZ,                        // to d; JZ/JNZ: when no / any lane of a is set
+} Op;
+
+typedef struct {
+    uint32_t op, d, a, b, c;
+} CpuInstr;
+
+typedef struct {
+    char     name[64];
+    int      size;
+    uint8_t  base;      // BT_*
+    uint32_t reg;       // first of size consecutive registers
+    float    value[MAX_COMPONENTS];
+} CpuUniform;
+
+struct CpuShader {
+    CpuInstr*  code;
+    int        ncode;
+    int        nreg;       // dynamic registers, then constants
+    float*     consts;
+    int        nconst;
+    CpuUniform uniforms[MAX_UNIFORMS];
+    int        nuniform;
+    uint32_t   uv_reg, frag_coord_reg; // 2 and 4 consecutive registers
+    bool       uses_uv, uses_frag_coord;
+    uint32_t   out_reg[4];
+    int        out_size;
+    uint32_t   discard_reg;
+    bool       uses_discard;
+};
+
+typedef float Lanes[CPU_LANES];
+
+static float EvalScalar(uint32_t op, float a, float b, float c) {
+    switch (op) {
+    case OP_MOV:    return a;
+    case OP_SEL:    return c != 0.f ? a : b;
+    case OP_ADD:    return a + b;
+    case OP_SUB:    return a - b;
+    case OP_MUL:    return a * b;
+    case OP_DIV:    return a / b;
+    case OP_MAD:    return a * b + c;
+    case OP_MIN:    return a < b ? a : b; // same operand order as minps/maxps
+    case OP_MAX:    return a > b ? a : b;
+    case OP_NEG:    return -a;
+    case OP_ABS:    return fabsf(a);
+    case OP_FLOOR:  return floorf(a);
+    case OP_TRUNC:  return truncf(a);
+    case OP_SQRT:   return sqrtf(a);
+    case OP_RSQ:    return 1.f / sqrtf(a);
+    case OP_SIN:    return sinf(a);
+    case OP_COS:    return cosf(a);
+    case OP_TAN:    return tanf(a);
+    case OP_ASIN:   return asinf(a);
+    case OP_ACOS:   return acosf(a);
+    case OP_ATAN:   return atanf(a);
+    case OP_ATAN2:  return atan2f(a, b);
+    case OP_EXP:    return expf(a);
+    case OP_EXP2:   return exp2f(a);
+    case OP_LOG:    return logf(a);
+    case OP_LOG2:   return log2f(a);
+    case OP_POW:    return powf(a, b);
+    case OP_LT:     return a <  b ? 1.f : 0.f;
+    case OP_LE:     return a <= b ? 1.f : 0.f;
+    case OP_EQ:     return a == b ? 1.f : 0.f;
+    case OP_NE:     return a != b ? 1.f : 0.f;
+    case OP_AND:    return a < b ? a : b;
+    case OP_OR:     return a > b ? a : b;
+    case OP_NOT:    return 1.f - a;
+    case OP_ANDNOT: return a - (a < b ? a : b);
+    default:        return 0.f;
+    }
+}
+
+// ======================= Lane-parallel execution ====================
+#if defined(__AVX__)
+typedef __m256 VF;
+#define VW         8
+#define VLD        _mm256_loadu_ps
+#define VST        _mm256_storeu_ps
+#define VSET1      _mm256_set1_ps
+#define VADD       _mm256_add_ps
+#define VSUB       _mm256_sub_ps
+#define VMUL       _mm256_mul_ps
+#define VDIV       _mm256_div_ps
+#define VMIN       _mm256_min_ps
+#define VMAX       _mm256_max_ps
+#define VSQRT      _mm256_sqrt_ps
+#define VAND       _mm256_and_ps
+#define VANDN      _mm256_andnot_ps
+#define VOR        _mm256_or_ps
+#define VXOR       _mm256_xor_ps
+#define VLT(a, b)  _mm256_cmp_ps(a, b, _CMP_LT_OQ)
+#define VLE(a, b)  _mm256_cmp_ps(a, b, _CMP_LE_OQ)
+#define VEQ(a, b)  _mm256_cmp_ps(a, b, _CMP_EQ_OQ)
+#define VNE(a, b)  _mm256_cmp_ps(a, b, _CMP_NEQ_UQ)
+#define VFLOOR(a)  _mm256_floor_ps(a)
+#define VTRUNC(a)  _mm256_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC)
+#define VANY(m)    (_mm256_movemask_ps(m) != 0)
+#elif defined(USE_SSE)
+typedef __m128 VF;
+#define VW         4
+#define VLD        _mm_loadu_ps
+#define VST        _mm_storeu_ps
+#define VSET1      _mm_set1_ps
+#define VADD       _mm_add_ps
+#define VSUB       _mm_sub_ps
+#define VMUL       _mm_mul_ps
+#define VDIV       _mm_div_ps
+#define VMIN       _mm_min_ps
+#define VMAX       _mm_max_ps
+#define VSQRT      _mm_sqrt_ps
+#define VAND       _mm_and_ps
+#define VANDN      _mm_andnot_ps
+#define VOR        _mm_or_ps
+#define VXOR       _mm_xor_ps
+#define VLT        _mm_cmplt_ps
+#define VLE        _mm_cmple_ps
+#define VEQ        _mm_cmpeq_ps
+#define VNE        _mm_cmpneq_ps
+#define VANY(m)    (_mm_movemask_ps(m) != 0)
+#if defined(__SSE4_1__)
+#define VFLOOR(a)  _mm_floor_ps(a)
+#define VTRUNC(a)  _mm_round_ps(a, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC)
+#else
+// Through int32 where that is exact; from 2^23 up every float is already an integer.
+static inline VF VTRUNC(VF a) {
+    VF t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+    VF small = _mm_cmplt_ps(_mm_andnot_ps(_mm_set1_ps(-0.f), a), _mm_set1_ps(8388608.f));
+    return _mm_or_ps(_mm_and_ps(small, t), _mm_andnot_ps(small, a));
+}
+static inline VF VFLOOR(VF a) {
+    VF t = VTRUNC(a);
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.f)));
+}
+#endif
+#endif
+
+#ifdef VW
+#define LANES1(expr) for (int i = 0; i < CPU_LANES; i += VW) { VF x = VLD(a + i); VST(d + i, (expr)); }
+#define LANES2(expr) for (int i = 0; i < CPU_LANES; i += VW) { VF x = VLD(a + i), y = VLD(b + i); VST(d + i, (expr)); }
+#define LANES3(expr) for (int i = 0; i < CPU_LANES; i += VW) { VF x = VLD(a + i), y = VLD(b + i), z = VLD(c + i); VST(d + i, (expr)); }
+#endif
+#define LANES_SCALAR(fn) for (int i = 0; i < CPU_LANES; ++i) d[i] = fn
+
+static void RunProgram(const CpuShader* s, Lanes* R) {
+    const CpuInstr* code = s->code;
+    const int n = s->ncode;
+#ifdef VW
+    const VF zero = VSET1(0.f), one = VSET1(1.f), sign = VSET1(-0.f);
+#endif
+    for (int pc = 0; pc < n; ++pc) {
+        const CpuInstr* in = &code[pc];
+        if (in->op >= OP_JMP) {
+            if (in->op == OP_JMP) { pc = (int)in->d - 1; continue; }
+            const float* m = R[in->a];
+            bool any = false;
+#ifdef VW
+            for (int i = 0; i < CPU_LANES; i += VW) any |= VANY(VNE(VLD(m + i), zero));
+#else
+            for (int i = 0; i < CPU_LANES; ++i) any |= m[i] != 0.f;
+#endif
+            if (any == (in->op == OP_JNZ)) pc = (int)in->d - 1;
+            continue;
+        }
+        float* d = R[in->d];
+        const float* a = R[in->a];
+        const float* b = R[in->b];
+        const float* c = R[in->c];
+        switch (in->op) {
+#ifdef VW
+        case OP_MOV:    LANES1(x); break;
+        case OP_SEL:
+            for (int i = 0; i < CPU_LANES; i += VW) {
+                VF m = VNE(VLD(c + i), zero);
+                VST(d + i, VOR(VAND(m, VLD(a + i)), VANDN(m, VLD(b + i))));
+            }
+            break;
+        case OP_ADD:    LANES2(VADD(x, y)); break;
+        case OP_SUB:    LANES2(VSUB(x, y)); break;
+        case OP_MUL:    LANES2(VMUL(x, y)); break;
+        case OP_DIV:    LANES2(VDIV(x, y)); break;
+        case OP_MAD:    LANES3(VADD(VMUL(x, y), z)); break;
+        case OP_MIN:    LANES2(VMIN(x, y)); break;
+        case OP_MAX:    LANES2(VMAX(x, y)); break;
+        case OP_NEG:    LANES1(VXOR(x, sign)); break;
+        case OP_ABS:    LANES1(VANDN(sign, x)); break;
+        case OP_FLOOR:  LANES1(VFLOOR(x)); break;
+        case OP_TRUNC:  LANES1(VTRUNC(x)); break;
+        case OP_SQRT:   LANES1(VSQRT(x)); break;
+        case OP_RSQ:    LANES1(VDIV(one, VSQRT(x))); break;
+        case OP_LT:     LANES2(VAND(VLT(x, y), one)); break;
+        case OP_LE:     LANES2(VAND(VLE(x, y), one)); break;
+        case OP_EQ:     LANES2(VAND(VEQ(x, y), one)); break;
+        case OP_NE:     LANES2(VAND(VNE(x, y), one)); break;
+        case OP_AND:    LANES2(VMIN(x, y)); break;
+        case OP_OR:     LANES2(VMAX(x, y)); break;
+        case OP_NOT:    LANES1(VSUB(one, x)); break;
+        case OP_ANDNOT: LANES2(VSUB(x, VMIN(x, y))); break;
+#endif
+        case OP_DDX: case OP_DDY: {
+            // Lanes are rows of CPU_BLOCK; pairs (0,1), (2,3) form the quads, as on a GPU.
+            float t[CPU_LANES];
+            for (int i = 0; i < CPU_LANES; ++i) {
+                int x = i % CPU_BLOCK, y = i / CPU_BLOCK;
+                t[i] = in->op == OP_DDX ? a[y * CPU_BLOCK + (x | 1)] - a[y * CPU_BLOCK + (x & ~1)]
+                                        : a[(y | 1) * CPU_BLOCK + x] - a[(y & ~1) * CPU_BLOCK + x];
+            }
+            memcpy(d, t, sizeof(t));
+        } break;
+        case OP_SIN:    LANES_SCALAR(sinf(a[i])); break;
+        case OP_COS:    LANES_SCALAR(cosf(a[i])); break;
+        case OP_EXP2:   LANES_SCALAR(exp2f(a[i])); break;
+        case OP_POW:    LANES_SCALAR(powf(a[i], b[i])); break;
+        default:        LANES_SCALAR(EvalScalar(in->op, a[i], b[i], c[i])); break;
+        }
+    }
+}
+
+// ============================ Tokens ===============================
+typedef enum { TOK_EOF, TOK_IDENT, TOK_NUMBER, TOK_PUNCT } TokKind;
+
+typedef struct {
+    uint8_t     kind;
+    bool        is_int;      // a number without '.', exponent or f suffix
+    int         len;
+    const char* s;
+    double      num;
+    int         source, line, col;
+} Token;
+
+typedef struct {
+    const char* name;
+    int         len;
+    int         first, count; // body in Compiler.mtok
+} Macro;
+
+typedef struct {
+    bool active, taken, parent;
+} CondState;
+
+// ============================ Types ================================
+enum { BT_VOID, BT_BOOL, BT_INT, BT_FLOAT };
+
+typedef struct {
+    uint8_t base, cols, rows; // scalar 1x1, vecN 1xN, matCxR; column-major components
+} Type;
+
+#define MASK_ALL  0xFFFFFFFFu // "every lane of the enclosing code", no register needed
+#define REG_CONST 0x80000000u // constant pool index until the program is finalized
+
+typedef struct {
+    Type     t;
+    uint32_t r[MAX_COMPONENTS];
+    uint8_t  lv; // 0 value, 1 local variable, 2 global variable (assignable registers)
+} Value;
+
+typedef struct {
+    const char* name;
+    int         len;
+    Type        t;
+    uint32_t    r[MAX_COMPONENTS];
+    uint8_t     lv;
+} Symbol;
+
+enum { Q_IN, Q_OUT, Q_INOUT };
+
+typedef struct {
+    const char* name;
+    int         len;
+    Type        ret;
+    int         nparam;
+    Type        ptype[MAX_PARAMS];
+    uint8_t     pqual[MAX_PARAMS];
+    const Token* pname[MAX_PARAMS];
+    int         body, body_end;   // token indices of its braces
+    bool        needs_mask;       // returns from inside control flow
+    bool        scanned;
+    bool        pmodified[MAX_PARAMS];
+} Function;
+
+enum { FRAME_IF, FRAME_LOOP, FRAME_BODY, FRAME_FUNC };
+
+typedef struct {
+    uint8_t  kind;
+    uint32_t mask; // lanes executing this region
+} MaskFrame;
+
+typedef struct {
+    const Function* f;
+    uint32_t ret[MAX_COMPONENTS];
+    int      frame;      // its FRAME_FUNC
+    int      exits[MAX_EXITS];
+    int      nexit;
+} CallCtx;
+
+typedef struct {
+    char*  log;
+    int    logsz;
+    bool   failed;
+
+    char*  text;        // source with comments blanked
+    Token* tok;
+    int    ntok, captok, pos;
+    Token  eof;
+    Token* mtok;        // macro bodies
+    int    nmtok, capmtok;
+    Macro  macro[MAX_MACROS];
+    int    nmacro;
+    Token* line;        // scratch for one directive line
+    int    nline, capline;
+    int    expanding[32];
+    int    nexpanding;
+
+    CpuInstr* code;
+    int    ncode, capcode;
+    int    last_label;  // highest instruction index that is a jump target
+    float* consts;
+    int    nconst, capconst;
+    uint32_t next_reg, max_reg, capreg;
+    int*   write_count;
+    int*   last_writer;
+    int    stmt_code_base;
+    uint32_t stmt_reg_base;
+
+    Symbol* sym;
+    int    nsym, capsym, nglobal, scope_floor;
+    Function* fn;
+    int    nfn, capfn;
+    bool   any_out_params;
+    bool   any_discard;
+
+    MaskFrame frame[MAX_FRAMES];
+    int    nframe;
+    CallCtx* call;
+    int    ncall;
+
+    CpuShader* s;
+    bool   have_out;
+} Compiler;
+
+// ============================ Errors ===============================
+static void ErrorAt(Compiler* c, const Token* t, const char* fmt, ...) {
+    if (c->failed) return;
+    c->failed = true;
+    if (!t) t = c->ntok ? &c->tok[c->ntok - 1] : &c->eof;
+    int n = snprintf(c->log, (size_t)c->logsz, "%d:%d(%d): error: ", t->source, t->line, t->col);
+    if (n < 0 || n >= c->logsz) return;
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(c->log + n, (size_t)(c->logsz - n), fmt, ap);
+    va_end(ap);
+}
+
+static void* Grow(void* p, int* cap, int need, size_t elem) {
+    if (need <= *cap) return p;
+    int n = *cap ? *cap : 64;
+    while (n < need) n *= 2;
+    void* q = realloc(p, (size_t)n * elem);
+    if (!q) { fprintf(stderr, "cpu_shader: out of memory\n"); abort(); }
+    *cap = n;
+    return q;
+}
+
+// ========================= Preprocessor ============================
+static bool IsIdentStart(char ch) { return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_'; }
+static bool IsIdentChar(char ch)  { return IsIdentStart(ch) || (ch >= '0' && ch <= '9'); }
+static bool IsDigit(char ch)      { return ch >= '0' && ch <= '9'; }
+
+static bool TokIs(const Token* t, const char* s) {
+    int n = (int)strlen(s);
+    return t->kind != TOK_EOF && t->kind != TOK_NUMBER && t->len == n && !memcmp(t->s, s, (size_t)n);
+}
+
+// Lexes [p, end) into c->line.
+static void LexLine(Compiler* c, const char* line_start, const char* p, const char* end, int source, int lineno) {
+    static const char* const punct3[] = { "<<=", ">>=" };
+    static const char* const punct2[] = { "++", "--", "+=", "-=", "*=", "/=", "%=", "==", "!=", "<=", ">=",
+                                          "&&", "||", "^^", "<<", ">>", "&=", "|=", "^=" };
+    c->nline = 0;
+    while (p < end && !c->failed) {
+        if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\f' || *p == '\v') { ++p; continue; }
+        Token t;
+        memset(&t, 0, sizeof(t));
+        t.s = p; t.source = source; t.line = lineno; t.col = (int)(p - line_start) + 1;
+        if (IsIdentStart(*p)) {
+            while (p < end && IsIdentChar(*p)) ++p;
+            t.kind = TOK_IDENT;
+        } else if (IsDigit(*p) || (*p == '.' && p + 1 < end && IsDigit(p[1]))) {
+            t.kind = TOK_NUMBER;
+            char* stop = NULL;
+            if (*p == '0' && p + 1 < end && (p[1] == 'x' || p[1] == 'X')) {
+                t.num = (double)strtoul(p, &stop, 16);
+                t.is_int = true;
+            } else {
+                const char* q = p;
+                while (q < end && IsDigit(*q)) ++q;
+                t.is_int = !(q < end && (*q == '.' || *q == 'e' || *q == 'E'));
+                t.num = strtod(p, &stop);
+            }
+            p = stop;
+            if (p < end && (*p == 'f' || *p == 'F')) { t.is_int = false; ++p; }
+            else if (p < end && (*p == 'u' || *p == 'U')) ++p;
+            if (p < end && IsIdentChar(*p)) { t.len = (int)(p - t.s); ErrorAt(c, &t, "malformed number"); return; }
+        } else {
+            t.kind = TOK_PUNCT;
+            int len = 1;
+            for (size_t i = 0; i < sizeof(punct3) / sizeof(punct3[0]) && len == 1; ++i)
+                if (end - p >= 3 && !memcmp(p, punct3[i], 3)) len = 3;
+            for (size_t i = 0; i < sizeof(punct2) / sizeof(punct2[0]) && len == 1; ++i)
+                if (end - p >= 2 && !memcmp(p, punct2[i], 2)) len = 2;
+            p += len;
+        }
+        t.len = (int)(p - t.s);
+        c->line = (Token*)Grow(c->line, &c->capline, c->nline + 1, sizeof(Token));
+        c->line[c->nline++] = t;
+    }
+}
+
+static int FindMacro(const Compiler* c, const Token* t) {
+    if (t->kind != TOK_IDENT) return -1;
+    for (int i = c->nmacro - 1; i >= 0; --i)
+        if (c->macro[i].len == t->len && !memcmp(c->macro[i].name, t->s, (size_t)t->len)) return i;
+    return -1;
+}
+
+// Appends t to the program, expanding object-like macros (at the position of use).
+static void EmitToken(Compiler* c, const Token* t) {
+    int m = FindMacro(c, t);
+    for (int i = 0; i < c->nexpanding && m >= 0; ++i) if (c->expanding[i] == m) m = -1;
+    if (m >= 0 && c->nexpanding < (int)(sizeof(c->expanding) / sizeof(c->expanding[0]))) {
+        c->expanding[c->nexpanding++] = m;
+        for (int i = 0; i < c->macro[m].count; ++i) {
+            Token b = c->mtok[c->macro[m].first + i];
+            b.source = t->source; b.line = t->line; b.col = t->col;
+            EmitToken(c, &b);
+        }
+        --c->nexpanding;
+        return;
+    }
+    c->tok = (Token*)Grow(c->tok, &c->captok, c->ntok + 1, sizeof(Token));
+    c->tok[c->ntok++] = *t;
+}
+
+// ---- #if expressions: integers, defined(), macros; unknown identifiers are 0 ----
+typedef struct {
+    Compiler* c;
+    Token*    t;
+    int       n, i;
+} IfExpr;
+
+static long long IfTernary(IfExpr* e);
+
+static long long IfPrimary(IfExpr* e) {
+    if (e->i >= e->n) { ErrorAt(e->c, NULL, "incomplete #if expression"); return 0; }
+    Token* t = &e->t[e->i++];
+    if (TokIs(t, "(")) {
+        long long v = IfTernary(e);
+        if (e->i < e->n && TokIs(&e->t[e->i], ")")) ++e->i;
+        else ErrorAt(e->c, t, "expected ')' in #if");
+        return v;
+    }
+    if (TokIs(t, "!")) return !IfPrimary(e);
+    if (TokIs(t, "-")) return -IfPrimary(e);
+    if (TokIs(t, "+")) return IfPrimary(e);
+    if (TokIs(t, "~")) return ~IfPrimary(e);
+    if (t->kind == TOK_NUMBER) return (long long)t->num;
+    if (t->kind == TOK_IDENT) return 0;
+    ErrorAt(e->c, t, "unexpected '%.*s' in #if", t->len, t->s);
+    return 0;
+}
+
+static int IfPrec(const Token* t) {
+    static const struct { const char* op; int prec; } ops[] = {
+        { "||", 1 }, { "&&", 2 }, { "|", 3 }, { "^", 4 }, { "&", 5 }, { "==", 6 }, { "!=", 6 },
+        { "<", 7 }, { ">", 7 }, { "<=", 7 }, { ">=", 7 }, { "<<", 8 }, { ">>", 8 },
+        { "+", 9 }, { "-", 9 }, { "*", 10 }, { "/", 10 }, { "%", 10 },
+    };
+    if (t->kind != TOK_PUNCT) return 0;
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); ++i) if (TokIs(t, ops[i].op)) return ops[i].prec;
+    return 0;
+}
+
+static long long IfBinary(IfExpr* e, int min_prec) {
+    long long l = IfPrimary(e);
+    while (e->i < e->n && !e->c->failed) {
+        const Token* op = &e->t[e->i];
+        int p = IfPrec(op);
+        if (!p || p < min_prec) break;
+        ++e->i;
+        long long r = IfBinary(e, p + 1);
+        if      (TokIs(op, "||")) l = l || r;
+        else if (TokIs(op, "&&")) l = l && r;
+        else if (TokIs(op, "|"))  l = l | r;
+        else if (TokIs(op, "^"))  l = l ^ r;
+        else if (TokIs(op, "&"))  l = l & r;
+        else if (TokIs(op, "==")) l = l == r;
+        else if (TokIs(op, "!=")) l = l != r;
+        else if (TokIs(op, "<"))  l = l < r;
+        else if (TokIs(op, ">"))  l = l > r;
+        else if (TokIs(op, "<=")) l = l <= r;
+        else if (TokIs(op, ">=")) l = l >= r;
+        else if (TokIs(op, "<<")) l = l << r;
+        else if (TokIs(op, ">>")) l = l >> r;
+        else if (TokIs(op, "+"))  l = l + r;
+        else if (TokIs(op, "-"))  l = l - r;
+        else if (TokIs(op, "*"))  l = l * r;
+        else if (r == 0) { ErrorAt(e->c, op, "division by zero in #if"); return 0; }
+        else if (TokIs(op, "/"))  l = l / r;
+        else                      l = l % r;
+    }
+    return l;
+}
+
+static long long IfTernary(IfExpr* e) {
+    long long v = IfBinary(e, 1);
+    if (e->i < e->n && TokIs(&e->t[e->i], "?")) {
+        ++e->i;
+        long long a = IfTernary(e);
+        if (e->i < e->n && TokIs(&e->t[e->i], ":")) ++e->i;
+        else ErrorAt(e->c, NULL, "expected ':' in #if");
+        long long b = IfTernary(e);
+        v = v ? a : b;
+    }
+    return v;
+}
+
+// Resolves defined() and expands macros in the line's tokens [from, nline).
+static void IfExpand(Compiler* c, const Token* in, int n, Token** out, int* nout, int* cap, int depth) {
+    for (int i = 0; i < n; ++i) {
+        Token t = in[i];
+        if (TokIs(&t, "defined")) {
+            bool paren = i + 1 < n && TokIs(&in[i + 1], "(");
+            int at = i + 1 + paren;
+            if (at >= n || in[at].kind != TOK_IDENT) { ErrorAt(c, &t, "expected a name after defined"); return; }
+            t.kind = TOK_NUMBER; t.num = FindMacro(c, &in[at]) >= 0;
+            i = at + (paren && at + 1 < n && TokIs(&in[at + 1], ")"));
+        } else if (depth < 32 && FindMacro(c, &t) >= 0) {
+            const Macro* m = &c->macro[FindMacro(c, &t)];
+            IfExpand(c, c->mtok + m->first, m->count, out, nout, cap, depth + 1);
+            continue;
+        }
+        *out = (Token*)Grow(*out, cap, *nout + 1, sizeof(Token));
+        (*out)[(*nout)++] = t;
+    }
+}
+
+static bool EvalIf(Compiler* c, const Token* at) {
+    Token* ex = NULL;
+    int n = 0, cap = 0;
+    IfExpand(c, c->line + 2, c->nline - 2, &ex, &n, &cap, 0);
+    IfExpr e = { c, ex, n, 0 };
+    long long v = 0;
+    if (!n) ErrorAt(c, at, "#if with no expression");
+    else {
+        v = IfTernary(&e);
+        if (e.i < e.n) ErrorAt(c, &ex[e.i], "unexpected '%.*s' in #if", ex[e.i].len, ex[e.i].s);
+    }
+    free(ex);
+    return v != 0;
+}
+
+static void Directive(Compiler* c, CondState* cond, int* ncond, int* source, int* next_line) {
+    if (c->nline < 2 || c->line[1].kind != TOK_IDENT) return; // "#" alone
+    const Token* d = &c->line[1];
+    bool active = *ncond == 0 || cond[*ncond - 1].active;
+    if (TokIs(d, "ifdef") || TokIs(d, "ifndef") || TokIs(d, "if")) {
+        if (*ncond == MAX_COND_DEPTH) { ErrorAt(c, d, "#if nesting too deep"); return; }
+        bool v = false;
+        if (active) {
+            if (TokIs(d, "if")) v = EvalIf(c, d);
+            else if (c->nline < 3) ErrorAt(c, d, "expected a macro name");
+            else v = (FindMacro(c, &c->line[2]) >= 0) == TokIs(d, "ifdef");
+        }
+        cond[(*ncond)++] = (CondState){ active && v, v, active };
+    } else if (TokIs(d, "elif") || TokIs(d, "else") || TokIs(d, "endif")) {
+        if (*ncond == 0) { ErrorAt(c, d, "#%.*s without #if", d->len, d->s); return; }
+        CondState* top = &cond[*ncond - 1];
+        if (TokIs(d, "endif")) { --*ncond; return; }
+        bool v = !top->taken && top->parent && (TokIs(d, "else") || EvalIf(c, d));
+        top->active = v;
+        top->taken |= v;
+    } else if (!active) {
+        return;
+    } else if (TokIs(d, "define")) {
+        if (c->nline < 3 || c->line[2].kind != TOK_IDENT) { ErrorAt(c, d, "expected a macro name"); return; }
+        const Token* name = &c->line[2];
+        if (c->nline > 3 && TokIs(&c->line[3], "(") && c->line[3].s == name->s + name->len) {
+            ErrorAt(c, name, "function-like macros are not supported by the CPU renderer");
+            return;
+        }
+        int m = FindMacro(c, name);
+        if (m < 0) {
+            if (c->nmacro == MAX_MACROS) { ErrorAt(c, name, "too many macros"); return; }
+            m = c->nmacro++;
+        }
+        c->mtok = (Token*)Grow(c->mtok, &c->capmtok, c->nmtok + c->nline - 3, sizeof(Token));
+        memcpy(c->mtok + c->nmtok, c->line + 3, (size_t)(c->nline - 3) * sizeof(Token));
+        c->macro[m] = (Macro){ name->s, name->len, c->nmtok, c->nline - 3 };
+        c->nmtok += c->nline - 3;
+    } else if (TokIs(d, "undef")) {
+        int m = c->nline >= 3 ? FindMacro(c, &c->line[2]) : -1;
+        if (m >= 0) c->macro[m] = c->macro[--c->nmacro];
+    } else if (TokIs(d, "line")) {
+        if (c->nline >= 3 && c->line[2].kind == TOK_NUMBER) *next_line = (int)c->line[2].num;
+        if (c->nline >= 4 && c->line[3].kind == TOK_NUMBER) *source = (int)c->line[3].num;
+    } else if (TokIs(d, "error")) {
+        ErrorAt(c, d, "#error%.*s", (int)(c->line[c->nline - 1].s + c->line[c->nline - 1].len - d->s - d->len),
+                d->s + d->len);
+    }
+    // #version, #extension and #pragma don't change what the CPU runs.
+}
+
+// Blanks comments (keeping newlines), then lexes line by line through the directives.
+static void Tokenize(Compiler* c, const char* src) {
+    size_t n = strlen(src);
+    c->text = (char*)malloc(n + 1);
+    memcpy(c->text, src, n + 1);
+    for (char* p = c->text; *p; ++p) {
+        if (p[0] == '/' && p[1] == '/') { while (*p && *p != '\n') *p++ = ' '; if (!*p) break; }
+        else if (p[0] == '/' && p[1] == '*') {
+            p[0] = p[1] = ' ';
+            p += 2;
+            while (*p && !(p[0] == '*' && p[1] == '/')) { if (*p != '\n') *p = ' '; ++p; }
+            if (*p) { p[0] = p[1] = ' '; ++p; }
+            else break;
+        }
+    }
+
+    CondState cond[MAX_COND_DEPTH];
+    int ncond = 0, source = 0, lineno = 1;
+    for (const char* p = c->text; *p && !c->failed;) {
+        const char* end = strchr(p, '\n');
+        if (!end) end = p + strlen(p);
+        const char* q = p;
+        while (q < end && (*q == ' ' || *q == '\t')) ++q;
+        int next_line = lineno + 1;
+        LexLine(c, p, q, end, source, lineno);
+        if (q < end && *q == '#') {
+            Directive(c, cond, &ncond, &source, &next_line);
+        } else if (ncond == 0 || cond[ncond - 1].active) {
+            for (int i = 0; i < c->nline && !c->failed; ++i) EmitToken(c, &c->line[i]);
+        }
+        lineno = next_line;
+        p = *end ? end + 1 : end;
+    }
+    if (ncond && !c->failed) ErrorAt(c, NULL, "missing #endif");
+    memset(&c->eof, 0, sizeof(c->eof));
+    c->eof.kind = TOK_EOF;
+    if (c->ntok) { c->eof.source = c->tok[c->ntok - 1].source; c->eof.line = c->tok[c->ntok - 1].line; }
+    c->tok = (Token*)Grow(c->tok, &c->captok, c->ntok + 1, sizeof(Token));
+    c->tok[c->ntok] = c->eof;
+}
+
+// ======================== Token cursor =============================
+// Once an error is recorded the stream reads as EOF, so every parse loop unwinds.
+static const Token* Peek(Compiler* c) { return c->failed ? &c->eof : &c->tok[c->pos]; }
+static const Token* PeekAt(Compiler* c, int k) {
+    return c->failed || c->pos + k >= c->ntok ? &c->eof : &c->tok[c->pos + k];
+}
+static const Token* Next(Compiler* c) {
+    const Token* t = Peek(c);
+    if (t->kind != TOK_EOF) ++c->pos;
+    return t;
+}
+static bool Accept(Compiler* c, const char* p) {
+    if (!TokIs(Peek(c), p)) return false;
+    ++c->pos;
+    return true;
+}
+static bool Expect(Compiler* c, const char* p) {
+    if (Accept(c, p)) return true;
+    const Token* t = Peek(c);
+    if (t->kind == TOK_EOF) ErrorAt(c, t, "expected '%s' before end of file", p);
+    else ErrorAt(c, t, "expected '%s' before '%.*s'", p, t->len, t->s);
+    return false;
+}
+static bool SameName(const Token* t, const char* name, int len) {
+    return t->kind == TOK_IDENT && t->len == len && !memcmp(t->s, name, (size_t)len);
+}
+
+// Index of the token closing the bracket at index open.
+static int MatchingClose(Compiler* c, int open) {
+    int depth = 0;
+    for (int i = open; i < c->ntok; ++i) {
+        const Token* t = &c->tok[i];
+        if (TokIs(t, "(") || TokIs(t, "[") || TokIs(t, "{")) ++depth;
+        else if ((TokIs(t, ")") || TokIs(t, "]") || TokIs(t, "}")) && --depth == 0) return i;
+    }
+    ErrorAt(c, &c->tok[open], "unbalanced '%.*s'", c->tok[open].len, c->tok[open].s);
+    return c->ntok;
+}
+
+// ============================ Types ================================
+static Type MakeType(int base, int cols, int rows) { Type t = { (uint8_t)base, (uint8_t)cols, (uint8_t)rows }; return t; }
+static int  TypeSize(Type t)      { return t.cols * t.rows; }
+static bool IsScalar(Type t)      { return t.cols == 1 && t.rows == 1; }
+static bool IsMatrix(Type t)      { return t.cols > 1; }
+static bool SameType(Type a, Type b) { return a.base == b.base && a.cols == b.cols && a.rows == b.rows; }
+
+static bool ParseTypeName(const Token* t, Type* out) {
+    static const struct { const char* name; int base, cols, rows; } types[] = {
+        { "void", BT_VOID, 0, 0 }, { "bool", BT_BOOL, 1, 1 }, { "int", BT_INT, 1, 1 }, { "uint", BT_INT, 1, 1 },
+        { "float", BT_FLOAT, 1, 1 },
+        { "vec2", BT_FLOAT, 1, 2 }, { "vec3", BT_FLOAT, 1, 3 }, { "vec4", BT_FLOAT, 1, 4 },
+        { "ivec2", BT_INT, 1, 2 }, { "ivec3", BT_INT, 1, 3 }, { "ivec4", BT_INT, 1, 4 },
+        { "uvec2", BT_INT, 1, 2 }, { "uvec3", BT_INT, 1, 3 }, { "uvec4", BT_INT, 1, 4 },
+        { "bvec2", BT_BOOL, 1, 2 }, { "bvec3", BT_BOOL, 1, 3 }, { "bvec4", BT_BOOL, 1, 4 },
+        { "mat2", BT_FLOAT, 2, 2 }, { "mat3", BT_FLOAT, 3, 3 }, { "mat4", BT_FLOAT, 4, 4 },
+        { "mat2x2", BT_FLOAT, 2, 2 }, { "mat2x3", BT_FLOAT, 2, 3 }, { "mat2x4", BT_FLOAT, 2, 4 },
+        { "mat3x2", BT_FLOAT, 3, 2 }, { "mat3x3", BT_FLOAT, 3, 3 }, { "mat3x4", BT_FLOAT, 3, 4 },
+        { "mat4x2", BT_FLOAT, 4, 2 }, { "mat4x3", BT_FLOAT, 4, 3 }, { "mat4x4", BT_FLOAT, 4, 4 },
+    };
+    if (t->kind != TOK_IDENT) return false;
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); ++i) {
+        if (!TokIs(t, types[i].name)) continue;
+        *out = MakeType(types[i].base, types[i].cols, types[i].rows);
+        return true;
+    }
+    return false;
+}
+
+static const char* TypeName(Type t, char* buf, size_t n) {
+    static const char* const scalar[] = { "void", "bool", "int", "float" };
+    static const char* const prefix[] = { "", "b", "i", "" };
+    if (t.base == BT_VOID || IsScalar(t)) snprintf(buf, n, "%s", scalar[t.base]);
+    else if (IsMatrix(t) && t.cols == t.rows) snprintf(buf, n, "mat%d", t.cols);
+    else if (IsMatrix(t)) snprintf(buf, n, "mat%dx%d", t.cols, t.rows);
+    else snprintf(buf, n, "%svec%d", prefix[t.base], t.rows);
+    return buf;
+}
+
+static bool IsQualifier(const Token* t) {
+    static const char* const q[] = { "const", "highp", "mediump", "lowp", "flat", "smooth", "noperspective",
+                                     "centroid", "invariant", "precise" };
+    for (size_t i = 0; i < sizeof(q) / sizeof(q[0]); ++i) if (TokIs(t, q[i])) return true;
+    return false;
+}
+
+// ====================== Registers and emission =====================
+static uint32_t NewRegs(Compiler* c, int n) {
+    uint32_t r = c->next_reg;
+    c->next_reg += (uint32_t)n;
+    if (c->next_reg > c->max_reg) c->max_reg = c->next_reg;
+    int cap = (int)c->capreg;
+    c->write_count = (int*)Grow(c->write_count, &cap, (int)c->next_reg, sizeof(int));
+    int cap2 = (int)c->capreg;
+    c->last_writer = (int*)Grow(c->last_writer, &cap2, (int)c->next_reg, sizeof(int));
+    c->capreg = (uint32_t)cap;
+    for (uint32_t i = r; i < c->next_reg; ++i) { c->write_count[i] = 0; c->last_writer[i] = -1; }
+    return r;
+}
+static uint32_t NewReg(Compiler* c) { return NewRegs(c, 1); }
+
+static bool  IsConstReg(uint32_t r) { return (r & REG_CONST) != 0; }
+static float ConstValue(const Compiler* c, uint32_t r) { return c->consts[r & ~REG_CONST]; }
+
+static uint32_t Const(Compiler* c, float v) {
+    for (int i = 0; i < c->nconst; ++i)
+        if (!memcmp(&c->consts[i], &v, sizeof(float))) return REG_CONST | (uint32_t)i;
+    c->consts = (float*)Grow(c->consts, &c->capconst, c->nconst + 1, sizeof(float));
+    c->consts[c->nconst] = v;
+    return REG_CONST | (uint32_t)c->nconst++;
+}
+
+static int Emit(Compiler* c, uint32_t op, uint32_t d, uint32_t a, uint32_t b, uint32_t cc) {
+    c->code = (CpuInstr*)Grow(c->code, &c->capcode, c->ncode + 1, sizeof(CpuInstr));
+    c->code[c->ncode] = (CpuInstr){ op, d, a, b, cc };
+    if (op < OP_JMP && !IsConstReg(d)) { c->write_count[d]++; c->last_writer[d] = c->ncode; }
+    return c->ncode++;
+}
+
+static void Label(Compiler* c) { c->last_label = c->ncode; }
+static int  EmitJump(Compiler* c, uint32_t op, uint32_t mask) { return Emit(c, op, 0, mask, 0, 0); }
+static void PatchJump(Compiler* c, int at) { c->code[at].d = (uint32_t)c->ncode; Label(c); }
+
+static int Arity(uint32_t op) {
+    switch (op) {
+    case OP_SEL: case OP_MAD: return 3;
+    case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_MIN: case OP_MAX: case OP_ATAN2: case OP_POW:
+    case OP_LT: case OP_LE: case OP_EQ: case OP_NE: case OP_AND: case OP_OR: case OP_ANDNOT: return 2;
+    default: return 1;
+    }
+}
+
+// A fresh temporary holding op(a, b, cc), or a constant when every operand is one.
+static uint32_t Op3(Compiler* c, uint32_t op, uint32_t a, uint32_t b, uint32_t cc) {
+    int n = Arity(op);
+    bool ka = IsConstReg(a), kb = n < 2 || IsConstReg(b), kc = n < 3 || IsConstReg(cc);
+    if (op == OP_DDX || op == OP_DDY) {
+        if (ka) return Const(c, 0.f);
+    } else if (ka && kb && kc) {
+        return Const(c, EvalScalar(op, ConstValue(c, a), n > 1 ? ConstValue(c, b) : 0.f, n > 2 ? ConstValue(c, cc) : 0.f));
+    }
+    if (op == OP_MUL && ka && ConstValue(c, a) == 1.f) return b;
+    if ((op == OP_MUL || op == OP_DIV) && kb && ConstValue(c, b) == 1.f) return a;
+    if (op == OP_ADD && ka && ConstValue(c, a) == 0.f) return b;
+    if ((op == OP_ADD || op == OP_SUB) && kb && ConstValue(c, b) == 0.f) return a;
+    if (op == OP_SEL && IsConstReg(cc)) return ConstValue(c, cc) != 0.f ? a : b;
+    if (op == OP_MAD && kc && ConstValue(c, cc) == 0.f) return Op3(c, OP_MUL, a, b, 0);
+    uint32_t d = NewReg(c);
+    Emit(c, op, d, a, n > 1 ? b : 0, n > 2 ? cc : 0);
+    return d;
+}
+static uint32_t Op2(Compiler* c, uint32_t op, uint32_t a, uint32_t b) { return Op3(c, op, a, b, 0); }
+static uint32_t Op1(Compiler* c, uint32_t op, uint32_t a) { return Op3(c, op, a, 0, 0); }
+
+static uint32_t CurMask(const Compiler* c) { return c->nframe ? c->frame[c->nframe - 1].mask : MASK_ALL; }
+
+static void PushFrame(Compiler* c, int kind, uint32_t mask) {
+    if (c->nframe == MAX_FRAMES) { ErrorAt(c, Peek(c), "control flow nested too deeply"); return; }
+    c->frame[c->nframe++] = (MaskFrame){ (uint8_t)kind, mask };
+}
+static void PopFrame(Compiler* c) { if (c->nframe) --c->nframe; }
+
+// A register of our own holding the current mask (all ones at top level).
+static uint32_t CopyMask(Compiler* c) {
+    uint32_t m = NewReg(c);
+    uint32_t cur = CurMask(c);
+    Emit(c, OP_MOV, m, cur == MASK_ALL ? Const(c, 1.f) : cur, 0, 0);
+    return m;
+}
+
+// Writes src to dst in the lanes of mask. Unmasked, a temporary computed by the
+// statement being compiled is renamed to dst instead of copied.
+static void StoreReg(Compiler* c, uint32_t dst, uint32_t src, uint32_t mask, bool src_shared) {
+    if (dst == src) return;
+    if (mask != MASK_ALL) { Emit(c, OP_SEL, dst, src, dst, mask); return; }
+    if (!src_shared && !IsConstReg(src) && src >= c->stmt_reg_base && src < c->next_reg && c->write_count[src] == 1) {
+        int w = c->last_writer[src];
+        CpuInstr* in = w >= 0 ? &c->code[w] : NULL;
+        if (in && w >= c->stmt_code_base && w >= c->last_label && in->d == src &&
+            in->a != src && in->b != src && in->c != src && in->op != OP_DDX && in->op != OP_DDY) {
+            in->d = dst;
+            c->write_count[src] = 0;
+            c->write_count[dst]++;
+            c->last_writer[dst] = w;
+            return;
+        }
+    }
+    Emit(c, OP_MOV, dst, src, 0, 0);
+}
+
+static void StoreValue(Compiler* c, const Value* dst, const Value* src, uint32_t mask) {
+    int n = TypeSize(dst->t);
+    Value v = *src;
+    // A permuting self-assignment (v.yx = v.xy) must read everything before writing.
+    bool overlap = false;
+    for (int i = 0; i < n && !overlap; ++i)
+        for (int j = 0; j < i && !overlap; ++j) overlap = dst->r[j] == src->r[i];
+    for (int i = 0; i < n && overlap; ++i) {
+        v.r[i] = NewReg(c);
+        Emit(c, OP_MOV, v.r[i], src->r[i], 0, 0);
+    }
+    for (int i = 0; i < n; ++i) {
+        bool shared = false;
+        for (int j = 0; j < n && !shared; ++j) shared = j != i && v.r[j] == v.r[i];
+        StoreReg(c, dst->r[i], v.r[i], mask, shared);
+    }
+}
+
+// Turns off the current lanes in every mask from the top frame down to frame lowest:
+// what break (to the loop), continue (to the body), return and discard do.
+static void KillLanes(Compiler* c, int lowest) {
+    uint32_t cur = CurMask(c);
+    if (cur == MASK_ALL) { ErrorAt(c, Peek(c), "internal error: unmasked jump"); return; }
+    uint32_t t = NewReg(c);
+    Emit(c, OP_MOV, t, cur, 0, 0);
+    for (int i = c->nframe - 1; i >= lowest; --i) {
+        uint32_t m = c->frame[i].mask;
+        bool done = m == MASK_ALL;
+        for (int j = c->nframe - 1; j > i && !done; --j) done = c->frame[j].mask == m;
+        if (!done) Emit(c, OP_ANDNOT, m, m, t, 0);
+    }
+}
+
+// ============================ Values ===============================
+static Value MakeValue(Type t) { Value v; memset(&v, 0, sizeof(v)); v.t = t; return v; }
+
+static Value ConstScalar(Compiler* c, int base, float f) {
+    Value v = MakeValue(MakeType(base, 1, 1));
+    v.r[0] = Const(c, f);
+    return v;
+}
+
+static bool IsConstValue(const Value* v) {
+    for (int i = 0; i < TypeSize(v->t); ++i) if (!IsConstReg(v->r[i])) return false;
+    return true;
+}
+
+static Value ConvertBase(Compiler* c, Value v, int base) {
+    if (v.t.base == base) return v;
+    Value o = v;
+    o.t.base = (uint8_t)base;
+    o.lv = 0;
+    for (int i = 0; i < TypeSize(v.t); ++i) {
+        if (base == BT_BOOL) o.r[i] = Op2(c, OP_NE, v.r[i], Const(c, 0.f));
+        else if (base == BT_INT && v.t.base == BT_FLOAT) o.r[i] = Op1(c, OP_TRUNC, v.r[i]);
+    }
+    return o;
+}
+
+// The conversions GLSL does without being asked: int (vector) to float (vector).
+static bool Coerce(Compiler* c, Value* v, Type to, const Token* at, const char* what) {
+    if (SameType(v->t, to)) return true;
+    if (v->t.base == BT_INT && to.base == BT_FLOAT && v->t.cols == to.cols && v->t.rows == to.rows) {
+        *v = ConvertBase(c, *v, BT_FLOAT);
+        return true;
+    }
+    char a[16], b[16];
+    ErrorAt(c, at, "cannot convert %s to %s in %s", TypeName(v->t, a, sizeof(a)), TypeName(to, b, sizeof(b)), what);
+    return false;
+}
+
+// ========================== Symbols ================================
+static Symbol* Lookup(Compiler* c, const Token* name) {
+    for (int i = c->nsym - 1; i >= c->scope_floor; --i)
+        if (SameName(name, c->sym[i].name, c->sym[i].len)) return &c->sym[i];
+    for (int i = c->nglobal - 1; i >= 0; --i)
+        if (SameName(name, c->sym[i].name, c->sym[i].len)) return &c->sym[i];
+    return NULL;
+}
+
+static Symbol* AddSymbol(Compiler* c, const Token* name, Type t, const uint32_t* regs, int lv) {
+    c->sym = (Symbol*)Grow(c->sym, &c->capsym, c->nsym + 1, sizeof(Symbol));
+    Symbol* s = &c->sym[c->nsym++];
+    memset(s, 0, sizeof(*s));
+    s->name = name->s; s->len = name->len; s->t = t; s->lv = (uint8_t)lv;
+    memcpy(s->r, regs, (size_t)TypeSize(t) * sizeof(uint32_t));
+    return s;
+}
+
+static Function* FindFunction(Compiler* c, const Token* name) {
+    for (int i = 0; i < c->nfn; ++i) if (SameName(name, c->fn[i].name, c->fn[i].len)) return &c->fn[i];
+    return NULL;
+}
+
+typedef struct { int nsym; uint32_t next_reg; } ScopeMark;
+static ScopeMark EnterScope(const Compiler* c) { ScopeMark m = { c->nsym, c->next_reg }; return m; }
+static void LeaveScope(Compiler* c, ScopeMark m) { c->nsym = m.nsym; c->next_reg = m.next_reg; }
+
+// ========================== Arithmetic =============================
+static Value Expression(Compiler* c);
+static Value Assignment(Compiler* c);
+static void  Statement(Compiler* c);
+
+static bool Numeric(Compiler* c, const Value* v, const Token* at) {
+    if (v->t.base == BT_INT || v->t.base == BT_FLOAT) return true;
+    char n[16];
+    ErrorAt(c, at, "'%.*s' needs a numeric operand, not %s", at->len, at->s, TypeName(v->t, n, sizeof(n)));
+    return false;
+}
+
+static Value MatMul(Compiler* c, const Value* a, const Value* b, const Token* at) {
+    // Both as matrices: a vector on the left is a row (1 x n), on the right a column.
+    int ac = IsMatrix(a->t) ? a->t.cols : a->t.rows, ar = IsMatrix(a->t) ? a->t.rows : 1;
+    int bc = IsMatrix(b->t) ? b->t.cols : 1,         br = IsMatrix(b->t) ? b->t.rows : b->t.rows;
+    if (ac != br) { ErrorAt(c, at, "matrix dimensions don't match"); return MakeValue(a->t); }
+    Value o = MakeValue(ar == 1 ? MakeType(BT_FLOAT, 1, bc) : bc == 1 ? MakeType(BT_FLOAT, 1, ar) : MakeType(BT_FLOAT, bc, ar));
+    for (int col = 0; col < bc; ++col) {
+        for (int row = 0; row < ar; ++row) {
+            uint32_t acc = 0;
+            for (int k = 0; k < ac; ++k) {
+                uint32_t x = a->r[k * ar + row], y = b->r[col * br + k];
+                acc = k == 0 ? Op2(c, OP_MUL, x, y) : Op3(c, OP_MAD, x, y, acc);
+            }
+            o.r[col * ar + row] = acc;
+        }
+    }
+    return o;
+}
+
+static Value Arith(Compiler* c, uint32_t op, Value a, Value b, const Token* at) {
+    if (!Numeric(c, &a, at) || !Numeric(c, &b, at)) return a;
+    if (a.t.base != b.t.base) { a = ConvertBase(c, a, BT_FLOAT); b = ConvertBase(c, b, BT_FLOAT); }
+    a.lv = b.lv = 0;
+    if (op == OP_MUL && ((IsMatrix(a.t) && !IsScalar(b.t)) || (IsMatrix(b.t) && !IsScalar(a.t))))
+        return MatMul(c, &a, &b, at);
+    int na = TypeSize(a.t), nb = TypeSize(b.t);
+    if (na != nb && na != 1 && nb != 1) {
+        char x[16], y[16];
+        ErrorAt(c, at, "'%.*s' between %s and %s", at->len, at->s, TypeName(a.t, x, sizeof(x)), TypeName(b.t, y, sizeof(y)));
+        return a;
+    }
+    Value o = MakeValue(na >= nb ? a.t : b.t);
+    bool is_int = o.t.base == BT_INT;
+    for (int i = 0; i < TypeSize(o.t); ++i) {
+        uint32_t x = a.r[na == 1 ? 0 : i], y = b.r[nb == 1 ? 0 : i];
+        if (op == ARITH_IMOD) { // int %
+            o.r[i] = Op2(c, OP_SUB, x, Op2(c, OP_MUL, y, Op1(c, OP_TRUNC, Op2(c, OP_DIV, x, y))));
+        } else {
+            o.r[i] = Op2(c, op, x, y);
+            if (op == OP_DIV && is_int) o.r[i] = Op1(c, OP_TRUNC, o.r[i]);
+        }
+    }
+    return o;
+}
+
+static uint32_t AllOf(Compiler* c, const uint32_t* r, int n, uint32_t op) {
+    uint32_t acc = r[0];
+    for (int i = 1; i < n; ++i) acc = Op2(c, op, acc, r[i]);
+    return acc;
+}
+
+static Value Compare(Compiler* c, const Token* at, Value a, Value b) {
+    if (a.t.base != b.t.base && a.t.base != BT_BOOL && b.t.base != BT_BOOL) {
+        a = ConvertBase(c, a, BT_FLOAT); b = ConvertBase(c, b, BT_FLOAT);
+    }
+    Value o = MakeValue(MakeType(BT_BOOL, 1, 1));
+    bool eq = TokIs(at, "==") || TokIs(at, "!=");
+    if (!SameType(a.t, b.t) || (!eq && (!IsScalar(a.t) || a.t.base == BT_BOOL))) {
+        char x[16], y[16];
+        ErrorAt(c, at, "'%.*s' between %s and %s", at->len, at->s, TypeName(a.t, x, sizeof(x)), TypeName(b.t, y, sizeof(y)));
+        return o;
+    }
+    if (eq) {
+        uint32_t r[MAX_COMPONENTS] = { 0 };
+        for (int i = 0; i < TypeSize(a.t); ++i) r[i] = Op2(c, OP_EQ, a.r[i], b.r[i]);
+        o.r[0] = AllOf(c, r, TypeSize(a.t), OP_AND);
+        if (TokIs(at, "!=")) o.r[0] = Op1(c, OP_NOT, o.r[0]);
+    } else if (TokIs(at, "<"))  o.r[0] = Op2(c, OP_LT, a.r[0], b.r[0]);
+    else if (TokIs(at, "<="))   o.r[0] = Op2(c, OP_LE, a.r[0], b.r[0]);
+    else if (TokIs(at, ">"))    o.r[0] = Op2(c, OP_LT, b.r[0], a.r[0]);
+    else                        o.r[0] = Op2(c, OP_LE, b.r[0], a.r[0]);
+    return o;
+}
+
+static bool CheckBool(Compiler* c, const Value* v, const Token* at) {
+    if (v->t.base == BT_BOOL && IsScalar(v->t)) return true;
+    char n[16];
+    ErrorAt(c, at, "expected a bool, got %s", TypeName(v->t, n, sizeof(n)));
+    return false;
+}
+
+// ========================= Constructors ============================
+static Value Construct(Compiler* c, Type t, Value* args, int nargs, const Token* at) {
+    Value o = MakeValue(t);
+    int n = TypeSize(t);
+    if (nargs == 0) { ErrorAt(c, at, "constructor needs arguments"); return o; }
+    for (int i = 0; i < nargs; ++i) {
+        args[i] = ConvertBase(c, args[i], t.base);
+        args[i].lv = 0;
+    }
+    if (IsMatrix(t) && nargs == 1 && IsScalar(args[0].t)) {
+        for (int i = 0; i < n; ++i) o.r[i] = (i / t.rows == i % t.rows) ? args[0].r[0] : Const(c, 0.f);
+        return o;
+    }
+    if (IsMatrix(t) && nargs == 1 && IsMatrix(args[0].t)) {
+        const Value* m = &args[0];
+        for (int col = 0; col < t.cols; ++col)
+            for (int row = 0; row < t.rows; ++row)
+                o.r[col * t.rows + row] = col < m->t.cols && row < m->t.rows ? m->r[col * m->t.rows + row]
+                                                                            : Const(c, col == row ? 1.f : 0.f);
+        return o;
+    }
+    if (!IsMatrix(t) && nargs == 1 && IsScalar(args[0].t)) {
+        for (int i = 0; i < n; ++i) o.r[i] = args[0].r[0];
+        return o;
+    }
+    int k = 0;
+    for (int i = 0; i < nargs && k < n; ++i)
+        for (int j = 0; j < TypeSize(args[i].t) && k < n; ++j) o.r[k++] = args[i].r[j];
+    if (k < n) { char name[16]; ErrorAt(c, at, "not enough data for %s", TypeName(t, name, sizeof(name))); }
+    return o;
+}
+
+// ========================== Built-ins ==============================
+typedef enum {
+    B_RADIANS, B_DEGREES, B_SIN, B_COS, B_TAN, B_ASIN, B_ACOS, B_ATAN, B_SINH, B_COSH, B_TANH,
+    B_POW, B_EXP, B_LOG, B_EXP2, B_LOG2, B_SQRT, B_INVERSESQRT,
+    B_ABS, B_SIGN, B_FLOOR, B_CEIL, B_FRACT, B_TRUNC, B_ROUND, B_MOD, B_MIN, B_MAX, B_CLAMP,
+    B_MIX, B_STEP, B_SMOOTHSTEP, B_DFDX, B_DFDY, B_FWIDTH,
+    B_LENGTH, B_DISTANCE, B_DOT, B_CROSS, B_NORMALIZE, B_REFLECT, B_REFRACT, B_FACEFORWARD,
+    B_LESSTHAN, B_LESSTHANEQUAL, B_GREATERTHAN, B_GREATERTHANEQUAL, B_EQUAL, B_NOTEQUAL,
+    B_ANY, B_ALL, B_NOT, B_MATRIXCOMPMULT, B_TRANSPOSE, B_DETERMINANT, B_OUTERPRODUCT,
+} Builtin;
+
+static const struct { const char* name; Builtin id; int min_args, max_args; } s_builtins[] = {
+    { "radians", B_RADIANS, 1, 1 }, { "degrees", B_DEGREES, 1, 1 }, { "sin", B_SIN, 1, 1 }, { "cos", B_COS, 1, 1 },
+    { "tan", B_TAN, 1, 1 }, { "asin", B_ASIN, 1, 1 }, { "acos", B_ACOS, 1, 1 }, { "atan", B_ATAN, 1, 2 },
+    { "sinh", B_SINH, 1, 1 }, { "cosh", B_COSH, 1, 1 }, { "tanh", B_TANH, 1, 1 },
+    { "pow", B_POW, 2, 2 }, { "exp", B_EXP, 1, 1 }, { "log", B_LOG, 1, 1 }, { "exp2", B_EXP2, 1, 1 },
+    { "log2", B_LOG2, 1, 1 }, { "sqrt", B_SQRT, 1, 1 }, { "inversesqrt", B_INVERSESQRT, 1, 1 },
+    { "abs", B_ABS, 1, 1 }, { "sign", B_SIGN, 1, 1 }, { "floor", B_FLOOR, 1, 1 }, { "ceil", B_CEIL, 1, 1 },
+    { "fract", B_FRACT, 1, 1 }, { "trunc", B_TRUNC, 1, 1 }, { "round", B_ROUND, 1, 1 },
+    { "roundEven", B_ROUND, 1, 1 }, { "mod", B_MOD, 2, 2 }, { "min", B_MIN, 2, 2 }, { "max", B_MAX, 2, 2 },
+    { "clamp", B_CLAMP, 3, 3 }, { "mix", B_MIX, 3, 3 }, { "step", B_STEP, 2, 2 },
+    { "smoothstep", B_SMOOTHSTEP, 3, 3 }, { "dFdx", B_DFDX, 1, 1 }, { "dFdy", B_DFDY, 1, 1 },
+    { "fwidth", B_FWIDTH, 1, 1 }, { "length", B_LENGTH, 1, 1 }, { "distance", B_DISTANCE, 2, 2 },
+    { "dot", B_DOT, 2, 2 }, { "cross", B_CROSS, 2, 2 }, { "normalize", B_NORMALIZE, 1, 1 },
+    { "reflect", B_REFLECT, 2, 2 }, { "refract", B_REFRACT, 3, 3 }, { "faceforward", B_FACEFORWARD, 3, 3 },
+    { "lessThan", B_LESSTHAN, 2, 2 }, { "lessThanEqual", B_LESSTHANEQUAL, 2, 2 },
+    { "greaterThan", B_GREATERTHAN, 2, 2 }, { "greaterThanEqual", B_GREATERTHANEQUAL, 2, 2 },
+    { "equal", B_EQUAL, 2, 2 }, { "notEqual", B_NOTEQUAL, 2, 2 }, { "any", B_ANY, 1, 1 }, { "all", B_ALL, 1, 1 },
+    { "not", B_NOT, 1, 1 }, { "matrixCompMult", B_MATRIXCOMPMULT, 2, 2 }, { "transpose", B_TRANSPOSE, 1, 1 },
+    { "determinant", B_DETERMINANT, 1, 1 }, { "outerProduct", B_OUTERPRODUCT, 2, 2 },
+};
+
+// One component of a component-wise built-in.
+static uint32_t BuiltinComponent(Compiler* c, Builtin id, int nargs, uint32_t x, uint32_t y, uint32_t z) {
+    switch (id) {
+    case B_RADIANS:     return Op2(c, OP_MUL, x, Const(c, 0.017453292519943295f));
+    case B_DEGREES:     return Op2(c, OP_MUL, x, Const(c, 57.29577951308232f));
+    case B_SIN:         return Op1(c, OP_SIN, x);
+    case B_COS:         return Op1(c, OP_COS, x);
+    case B_TAN:         return Op1(c, OP_TAN, x);
+    case B_ASIN:        return Op1(c, OP_ASIN, x);
+    case B_ACOS:        return Op1(c, OP_ACOS, x);
+    case B_ATAN:        return nargs == 2 ? Op2(c, OP_ATAN2, x, y) : Op1(c, OP_ATAN, x);
+    case B_SINH: case B_COSH: case B_TANH: {
+        uint32_t e = Op1(c, OP_EXP, x), ie = Op2(c, OP_DIV, Const(c, 1.f), e);
+        if (id == B_TANH) return Op2(c, OP_DIV, Op2(c, OP_SUB, e, ie), Op2(c, OP_ADD, e, ie));
+        return Op2(c, OP_MUL, Op2(c, id == B_SINH ? OP_SUB : OP_ADD, e, ie), Const(c, 0.5f));
+    }
+    case B_POW:         return Op2(c, OP_POW, x, y);
+    case B_EXP:         return Op1(c, OP_EXP, x);
+    case B_LOG:         return Op1(c, OP_LOG, x);
+    case B_EXP2:        return Op1(c, OP_EXP2, x);
+    case B_LOG2:        return Op1(c, OP_LOG2, x);
+    case B_SQRT:        return Op1(c, OP_SQRT, x);
+    case B_INVERSESQRT: return Op1(c, OP_RSQ, x);
+    case B_ABS:         return Op1(c, OP_ABS, x);
+    case B_SIGN:        return Op2(c, OP_SUB, Op2(c, OP_LT, Const(c, 0.f), x), Op2(c, OP_LT, x, Const(c, 0.f)));
+    case B_FLOOR:       return Op1(c, OP_FLOOR, x);
+    case B_CEIL:        return Op1(c, OP_NEG, Op1(c, OP_FLOOR, Op1(c, OP_NEG, x)));
+    case B_FRACT:       return Op2(c, OP_SUB, x, Op1(c, OP_FLOOR, x));
+    case B_TRUNC:       return Op1(c, OP_TRUNC, x);
+    case B_ROUND:       return Op1(c, OP_FLOOR, Op2(c, OP_ADD, x, Const(c, 0.5f)));
+    case B_MOD:         return Op2(c, OP_SUB, x, Op2(c, OP_MUL, y, Op1(c, OP_FLOOR, Op2(c, OP_DIV, x, y))));
+    case B_MIN:         return Op2(c, OP_MIN, x, y);
+    case B_MAX:         return Op2(c, OP_MAX, x, y);
+    case B_CLAMP:       return Op2(c, OP_MIN, Op2(c, OP_MAX, x, y), z);
+    case B_MIX:         return Op3(c, OP_MAD, Op2(c, OP_SUB, y, x), z, x);
+    case B_STEP:        return Op2(c, OP_LE, x, y);
+    case B_SMOOTHSTEP: {
+        uint32_t t = Op2(c, OP_DIV, Op2(c, OP_SUB, z, x), Op2(c, OP_SUB, y, x));
+        t = Op2(c, OP_MIN, Op2(c, OP_MAX, t, Const(c, 0.f)), Const(c, 1.f));
+        return Op2(c, OP_MUL, Op2(c, OP_MUL, t, t), Op3(c, OP_MAD, t, Const(c, -2.f), Const(c, 3.f)));
+    }
+    case B_DFDX:        return Op1(c, OP_DDX, x);
+    case B_DFDY:        return Op1(c, OP_DDY, x);
+    case B_FWIDTH:      return Op2(c, OP_ADD, Op1(c, OP_ABS, Op1(c, OP_DDX, x)), Op1(c, OP_ABS, Op1(c, OP_DDY, x)));
+    default:            return x;
+    }
+}
+
+static uint32_t Dot(Compiler* c, const Value* a, const Value* b) {
+    uint32_t acc = Op2(c, OP_MUL, a->r[0], b->r[0]);
+    for (int i = 1; i < TypeSize(a->t); ++i) acc = Op3(c, OP_MAD, a->r[i], b->r[i], acc);
+    return acc;
+}
+
+static Value Scale(Compiler* c, const Value* v, uint32_t s) {
+    Value o = MakeValue(v->t);
+    for (int i = 0; i < TypeSize(v->t); ++i) o.r[i] = Op2(c, OP_MUL, v->r[i], s);
+    return o;
+}
+
+static bool CallBuiltin(Compiler* c, const Token* name, Value* a, int n, Value* out) {
+    int idx = -1;
+    for (size_t i = 0; i < sizeof(s_builtins) / sizeof(s_builtins[0]) && idx < 0; ++i)
+        if (TokIs(name, s_builtins[i].name)) idx = (int)i;
+    if (idx < 0) return false;
+    Builtin id = s_builtins[idx].id;
+    if (n < s_builtins[idx].min_args || n > s_builtins[idx].max_args) {
+        ErrorAt(c, name, "wrong number of arguments to %.*s", name->len, name->s);
+        return true;
+    }
+    for (int i = 0; i < n; ++i) a[i].lv = 0;
+
+    if (id <= B_FWIDTH) {
+        // Component-wise; scalar arguments are spread over the others' size.
+        bool bool_mix = id == B_MIX && a[2].t.base == BT_BOOL;
+        int size = 1, keep_int = id == B_ABS || id == B_SIGN || id == B_MIN || id == B_MAX || id == B_CLAMP;
+        for (int i = 0; i < n; ++i) {
+            if (IsMatrix(a[i].t) || (a[i].t.base == BT_BOOL && !(bool_mix && i == 2))) {
+                ErrorAt(c, name, "bad argument %d to %.*s", i + 1, name->len, name->s);
+                return true;
+            }
+            int s = TypeSize(a[i].t);
+            if (s > 1 && size > 1 && s != size) { ErrorAt(c, name, "mismatched argument sizes to %.*s", name->len, name->s); return true; }
+            if (s > size) size = s;
+            if (a[i].t.base != BT_INT) keep_int = false;
+        }
+        *out = MakeValue(MakeType(keep_int ? BT_INT : BT_FLOAT, 1, size));
+        for (int k = 0; k < size; ++k) {
+            uint32_t r[3] = { 0, 0, 0 };
+            for (int i = 0; i < n; ++i) r[i] = a[i].r[TypeSize(a[i].t) == 1 ? 0 : k];
+            out->r[k] = bool_mix ? Op3(c, OP_SEL, r[1], r[0], r[2]) : BuiltinComponent(c, id, n, r[0], r[1], r[2]);
+        }
+        return true;
+    }
+
+    if (id >= B_LESSTHAN && id <= B_NOTEQUAL) {
+        if (!SameType(a[0].t, a[1].t) || IsScalar(a[0].t) || IsMatrix(a[0].t)) {
+            ErrorAt(c, name, "%.*s needs two vectors of the same type", name->len, name->s);
+            return true;
+        }
+        *out = MakeValue(MakeType(BT_BOOL, 1, a[0].t.rows));
+        for (int i = 0; i < a[0].t.rows; ++i) {
+            uint32_t x = a[0].r[i], y = a[1].r[i];
+            switch (id) {
+            case B_LESSTHAN:         out->r[i] = Op2(c, OP_LT, x, y); break;
+            case B_LESSTHANEQUAL:    out->r[i] = Op2(c, OP_LE, x, y); break;
+            case B_GREATERTHAN:      out->r[i] = Op2(c, OP_LT, y, x); break;
+            case B_GREATERTHANEQUAL: out->r[i] = Op2(c, OP_LE, y, x); break;
+            case B_EQUAL:            out->r[i] = Op2(c, OP_EQ, x, y); break;
+            default:                 out->r[i] = Op2(c, OP_NE, x, y); break;
+            }
+        }
+        return true;
+    }
+    if (id == B_ANY || id == B_ALL || id == B_NOT) {
+        if (a[0].t.base != BT_BOOL || IsScalar(a[0].t)) { ErrorAt(c, name, "%.*s needs a bvec", name->len, name->s); return true; }
+        if (id == B_NOT) {
+            *out = MakeValue(a[0].t);
+            for (int i = 0; i < a[0].t.rows; ++i) out->r[i] = Op1(c, OP_NOT, a[0].r[i]);
+        } else {
+            *out = MakeValue(MakeType(BT_BOOL, 1, 1));
+            out->r[0] = AllOf(c, a[0].r, a[0].t.rows, id == B_ANY ? OP_OR : OP_AND);
+        }
+        return true;
+    }
+    if (id == B_MATRIXCOMPMULT || id == B_TRANSPOSE || id == B_DETERMINANT) {
+        if (!IsMatrix(a[0].t) || (id == B_MATRIXCOMPMULT && !SameType(a[0].t, a[1].t)) ||
+            (id == B_DETERMINANT && (a[0].t.cols != a[0].t.rows || a[0].t.cols > 3))) {
+            ErrorAt(c, name, "unsupported arguments to %.*s", name->len, name->s);
+            return true;
+        }
+        const Value* m = &a[0];
+        int R = m->t.rows;
+        if (id == B_MATRIXCOMPMULT) {
+            *out = MakeValue(m->t);
+            for (int i = 0; i < TypeSize(m->t); ++i) out->r[i] = Op2(c, OP_MUL, m->r[i], a[1].r[i]);
+        } else if (id == B_TRANSPOSE) {
+            *out = MakeValue(MakeType(BT_FLOAT, R, m->t.cols));
+            for (int col = 0; col < m->t.cols; ++col)
+                for (int row = 0; row < R; ++row) out->r[row * m->t.cols + col] = m->r[col * R + row];
+        } else {
+            *out = MakeValue(MakeType(BT_FLOAT, 1, 1));
+            #define M(col, row) m->r[(col) * R + (row)]
+            if (R == 2) {
+                out->r[0] = Op2(c, OP_SUB, Op2(c, OP_MUL, M(0, 0), M(1, 1)), Op2(c, OP_MUL, M(1, 0), M(0, 1)));
+            } else {
+                uint32_t c0 = Op2(c, OP_SUB, Op2(c, OP_MUL, M(1, 1), M(2, 2)), Op2(c, OP_MUL, M(2, 1), M(1, 2)));
+                uint32_t c1 = Op2(c, OP_SUB, Op2(c, OP_MUL, M(2, 1), M(0, 2)), Op2(c, OP_MUL, M(0, 1), M(2, 2)));
+                uint32_t c2 = Op2(c, OP_SUB, Op2(c, OP_MUL, M(0, 1), M(1, 2)), Op2(c, OP_MUL, M(1, 1), M(0, 2)));
+                out->r[0] = Op3(c, OP_MAD, M(2, 0), c2, Op3(c, OP_MAD, M(1, 0), c1, Op2(c, OP_MUL, M(0, 0), c0)));
+            }
+            #undef M
+        }
+        return true;
+    }
+
+    // Geometric: float vectors (or scalars) only.
+    for (int i = 0; i < n; ++i) {
+        if (a[i].t.base == BT_INT) a[i] = ConvertBase(c, a[i], BT_FLOAT);
+        if (a[i].t.base != BT_FLOAT || IsMatrix(a[i].t)) {
+            ErrorAt(c, name, "bad argument %d to %.*s", i + 1, name->len, name->s);
+            return true;
+        }
+    }
+    if (id == B_OUTERPRODUCT) {
+        *out = MakeValue(MakeType(BT_FLOAT, a[1].t.rows, a[0].t.rows));
+        for (int col = 0; col < a[1].t.rows; ++col)
+            for (int row = 0; row < a[0].t.rows; ++row)
+                out->r[col * a[0].t.rows + row] = Op2(c, OP_MUL, a[0].r[row], a[1].r[col]);
+        return true;
+    }
+    bool pair = id == B_DISTANCE || id == B_DOT || id == B_CROSS || id == B_REFLECT || id == B_REFRACT || id == B_FACEFORWARD;
+    if (pair && !SameType(a[0].t, a[1].t)) { ErrorAt(c, name, "mismatched arguments to %.*s", name->len, name->s); return true; }
+    switch (id) {
+    case B_LENGTH:
+        *out = MakeValue(MakeType(BT_FLOAT, 1, 1));
+        out->r[0] = IsScalar(a[0].t) ? Op1(c, OP_ABS, a[0].r[0]) : Op1(c, OP_SQRT, Dot(c, &a[0], &a[0]));
+        break;
+    case B_DISTANCE: {
+        Value d = Arith(c, OP_SUB, a[0], a[1], name);
+        *out = MakeValue(MakeType(BT_FLOAT, 1, 1));
+        out->r[0] = IsScalar(d.t) ? Op1(c, OP_ABS, d.r[0]) : Op1(c, OP_SQRT, Dot(c, &d, &d));
+    } break;
+    case B_DOT:
+        *out = MakeValue(MakeType(BT_FLOAT, 1, 1));
+        out->r[0] = Dot(c, &a[0], &a[1]);
+        break;
+    case B_CROSS:
+        if (a[0].t.rows != 3) { ErrorAt(c, name, "cross needs vec3 arguments"); return true; }
+        *out = MakeValue(a[0].t);
+        for (int i = 0; i < 3; ++i) {
+            int j = (i + 1) % 3, k = (i + 2) % 3;
+            out->r[i] = Op2(c, OP_SUB, Op2(c, OP_MUL, a[0].r[j], a[1].r[k]), Op2(c, OP_MUL, a[0].r[k], a[1].r[j]));
+        }
+        break;
+    case B_NORMALIZE:
+        *out = Scale(c, &a[0], Op1(c, OP_RSQ, Dot(c, &a[0], &a[0])));
+        break;
+    case B_REFLECT: { // I - 2 dot(N, I) N
+        uint32_t k = Op2(c, OP_MUL, Dot(c, &a[1], &a[0]), Const(c, -2.f));
+        *out = MakeValue(a[0].t);
+        for (int i = 0; i < TypeSize(a[0].t); ++i) out->r[i] = Op3(c, OP_MAD, a[1].r[i], k, a[0].r[i]);
+    } break;
+    case B_REFRACT: { // k = 1 - eta^2 (1 - dot(N,I)^2); k < 0 ? 0 : eta I - (eta dot(N,I) + sqrt(k)) N
+        if (!IsScalar(a[2].t)) { ErrorAt(c, name, "refract needs a float eta"); return true; }
+        uint32_t eta = a[2].r[0], ni = Dot(c, &a[1], &a[0]);
+        uint32_t k = Op2(c, OP_SUB, Const(c, 1.f),
+                         Op2(c, OP_MUL, Op2(c, OP_MUL, eta, eta), Op2(c, OP_SUB, Const(c, 1.f), Op2(c, OP_MUL, ni, ni))));
+        uint32_t ok = Op2(c, OP_LE, Const(c, 0.f), k);
+        uint32_t f = Op3(c, OP_MAD, eta, ni, Op1(c, OP_SQRT, Op2(c, OP_MAX, k, Const(c, 0.f))));
+        *out = MakeValue(a[0].t);
+        for (int i = 0; i < TypeSize(a[0].t); ++i) {
+            uint32_t v = Op2(c, OP_SUB, Op2(c, OP_MUL, eta, a[0].r[i]), Op2(c, OP_MUL, f, a[1].r[i]));
+            out->r[i] = Op2(c, OP_MUL, v, ok);
+        }
+    } break;
+    case B_FACEFORWARD: { // dot(Nref, I) < 0 ? N : -N
+        uint32_t s = Op2(c, OP_LT, Dot(c, &a[2], &a[1]), Const(c, 0.f));
+        *out = MakeValue(a[0].t);
+        for (int i = 0; i < TypeSize(a[0].t); ++i) out->r[i] = Op3(c, OP_SEL, a[0].r[i], Op1(c, OP_NEG, a[0].r[i]), s);
+    } break;
+    default: break;
+    }
+    return true;
+}
+
+// ======================= Function inlining =========================
+static bool IsAssignOp(const Token* t) {
+    return TokIs(t, "=") || TokIs(t, "+=") || TokIs(t, "-=") || TokIs(t, "*=") || TokIs(t, "/=") || TokIs(t, "%=") ||
+           TokIs(t, "++") || TokIs(t, "--");
+}
+
+// Which in-parameters the body may write (then they need their own registers; the rest
+// read the argument's registers directly). Conservative: a name passed on to another
+// call counts as written when any function has out parameters.
+static void ScanFunction(Compiler* c, Function* f) {
+    if (f->scanned) return;
+    f->scanned = true;
+    for (int p = 0; p < f->nparam; ++p) {
+        const Token* name = f->pname[p];
+        for (int i = f->body + 1; i < f->body_end && !f->pmodified[p]; ++i) {
+            const Token* t = &c->tok[i];
+            if (!name || !SameName(t, name->s, name->len) || TokIs(&c->tok[i - 1], ".")) continue;
+            if (TokIs(&c->tok[i - 1], "++") || TokIs(&c->tok[i - 1], "--")) { f->pmodified[p] = true; break; }
+            int j = i + 1;
+            while (j < f->body_end) {
+                if (TokIs(&c->tok[j], ".") && c->tok[j + 1].kind == TOK_IDENT) j += 2;
+                else if (TokIs(&c->tok[j], "[")) j = MatchingClose(c, j) + 1;
+                else break;
+            }
+            const Token* after = &c->tok[j];
+            if (IsAssignOp(after) || (c->any_out_params && (TokIs(after, ",") || TokIs(after, ")"))))
+                f->pmodified[p] = true;
+        }
+    }
+}
+
+static Value InlineCall(Compiler* c, Function* f, Value* args, int nargs, const Token* at) {
+    Value result = MakeValue(f->ret);
+    if (c->ncall == MAX_CALLS) { ErrorAt(c, at, "calls nested too deeply (recursion?)"); return result; }
+    if (f->body < 0) { ErrorAt(c, at, "'%.*s' is declared but never defined", f->len, f->name); return result; }
+    ScanFunction(c, f);
+    for (int i = 0; i < nargs; ++i) {
+        if (f->pqual[i] != Q_IN && !args[i].lv) { ErrorAt(c, at, "argument %d of %.*s must be assignable", i + 1, f->len, f->name); return result; }
+    }
+    if (f->ret.base != BT_VOID) {
+        uint32_t r = NewRegs(c, TypeSize(f->ret));
+        for (int i = 0; i < TypeSize(f->ret); ++i) result.r[i] = r + (uint32_t)i;
+    }
+    uint32_t caller_mask = CurMask(c);
+    ScopeMark scope = EnterScope(c);
+    int caller_floor = c->scope_floor;
+    int save_code_base = c->stmt_code_base;
+    uint32_t save_reg_base = c->stmt_reg_base;
+
+    // Parameters: copies, except for inputs the body never writes.
+    Value param[MAX_PARAMS];
+    for (int i = 0; i < nargs; ++i) {
+        param[i] = MakeValue(f->ptype[i]);
+        bool alias = f->pqual[i] == Q_IN && !f->pmodified[i] && args[i].lv != 2;
+        if (alias) { memcpy(param[i].r, args[i].r, sizeof(param[i].r)); continue; }
+        uint32_t r = NewRegs(c, TypeSize(f->ptype[i]));
+        for (int k = 0; k < TypeSize(f->ptype[i]); ++k) {
+            param[i].r[k] = r + (uint32_t)k;
+            if (f->pqual[i] != Q_OUT) Emit(c, OP_MOV, r + (uint32_t)k, args[i].r[k], 0, 0);
+        }
+    }
+    c->scope_floor = c->nsym;
+    for (int i = 0; i < nargs; ++i)
+        if (f->pname[i]) AddSymbol(c, f->pname[i], f->ptype[i], param[i].r, f->pqual[i] == Q_IN && !f->pmodified[i] ? 0 : 1);
+
+    CallCtx* cx = &c->call[c->ncall++];
+    cx->f = f;
+    memcpy(cx->ret, result.r, sizeof(cx->ret));
+    cx->nexit = 0;
+    cx->frame = c->nframe;
+    PushFrame(c, FRAME_FUNC, f->needs_mask || c->any_discard ? CopyMask(c) : caller_mask);
+
+    int resume = c->pos;
+    c->pos = f->body;
+    Statement(c); // the body block
+    c->pos = resume;
+
+    for (int i = 0; i < cx->nexit; ++i) PatchJump(c, cx->exits[i]);
+    PopFrame(c);
+    --c->ncall;
+    c->scope_floor = caller_floor;
+    c->stmt_code_base = save_code_base;
+    c->stmt_reg_base = save_reg_base;
+    // Write back out/inout parameters in the caller's lanes.
+    for (int i = 0; i < nargs; ++i) {
+        if (f->pqual[i] == Q_IN) continue;
+        Value src = param[i];
+        StoreValue(c, &args[i], &src, caller_mask);
+    }
+    LeaveScope(c, scope);
+    return result;
+}
+
+static int MatchCost(Type want, Type have) {
+    if (SameType(want, have)) return 0;
+    if (want.base == BT_FLOAT && have.base == BT_INT && want.cols == have.cols && want.rows == have.rows) return 1;
+    return -1;
+}
+
+static Value Call(Compiler* c, const Token* name, Value* args, int nargs) {
+    Function* best = NULL;
+    int best_cost = 1 << 30;
+    for (int i = 0; i < c->nfn; ++i) {
+        Function* f = &c->fn[i];
+        if (!SameName(name, f->name, f->len) || f->nparam != nargs) continue;
+        int cost = 0;
+        for (int k = 0; k < nargs && cost >= 0; ++k) {
+            int m = MatchCost(f->ptype[k], args[k].t);
+            if (f->pqual[k] != Q_IN && m) m = -1;
+            cost = m < 0 ? -1 : cost + m;
+        }
+        if (cost >= 0 && cost < best_cost) { best = f; best_cost = cost; }
+    }
+    if (best) {
+        for (int k = 0; k < nargs; ++k) if (best->pqual[k] == Q_IN) Coerce(c, &args[k], best->ptype[k], name, "argument");
+        return InlineCall(c, best, args, nargs, name);
+    }
+    Value out = MakeValue(MakeType(BT_FLOAT, 1, 1));
+    if (CallBuiltin(c, name, args, nargs, &out)) return out;
+    if (FindFunction(c, name)) ErrorAt(c, name, "no overload of %.*s matches the arguments", name->len, name->s);
+    else if (TokIs(name, "texture") || TokIs(name, "texelFetch") || TokIs(name, "textureLod"))
+        ErrorAt(c, name, "samplers are not supported by the CPU renderer");
+    else ErrorAt(c, name, "unknown function '%.*s'", name->len, name->s);
+    return out;
+}
+
+// ========================== Expressions ============================
+static Value Swizzle(Compiler* c, Value v, const Token* sw) {
+    static const char* const sets[] = { "xyzw", "rgba", "stpq" };
+    Value o = MakeValue(v.t);
+    if (IsMatrix(v.t) || sw->kind != TOK_IDENT || sw->len > 4) { ErrorAt(c, sw, "bad swizzle '%.*s'", sw->len, sw->s); return o; }
+    int set = -1;
+    for (int s = 0; s < 3 && set < 0; ++s) if (strchr(sets[s], sw->s[0])) set = s;
+    o.t = MakeType(v.t.base, 1, sw->len);
+    o.lv = v.lv;
+    for (int i = 0; i < sw->len; ++i) {
+        const char* p = set >= 0 ? strchr(sets[set], sw->s[i]) : NULL;
+        int k = p ? (int)(p - sets[set]) : 99;
+        if (k >= TypeSize(v.t)) { ErrorAt(c, sw, "bad swizzle '%.*s'", sw->len, sw->s); return o; }
+        o.r[i] = v.r[k];
+        for (int j = 0; j < i; ++j) if (o.r[j] == o.r[i]) o.lv = 0; // not assignable with repeats
+    }
+    return o;
+}
+
+static Value Index(Compiler* c, Value v, Value idx, const Token* at) {
+    if (IsScalar(v.t) || idx.t.base == BT_BOOL || !IsScalar(idx.t)) { ErrorAt(c, at, "bad index"); return v; }
+    int count = IsMatrix(v.t) ? v.t.cols : v.t.rows, stride = IsMatrix(v.t) ? v.t.rows : 1;
+    Value o = MakeValue(IsMatrix(v.t) ? MakeType(BT_FLOAT, 1, v.t.rows) : MakeType(v.t.base, 1, 1));
+    if (IsConstReg(idx.r[0])) {
+        int k = (int)ConstValue(c, idx.r[0]);
+        if (k < 0 || k >= count) { ErrorAt(c, at, "index %d out of range", k); return o; }
+        for (int i = 0; i < stride; ++i) o.r[i] = v.r[k * stride + i];
+        o.lv = v.lv;
+        return o;
+    }
+    // Dynamic: select across the candidates (reads only).
+    for (int i = 0; i < stride; ++i) o.r[i] = v.r[i];
+    for (int k = 1; k < count; ++k) {
+        uint32_t hit = Op2(c, OP_EQ, idx.r[0], Const(c, (float)k));
+        for (int i = 0; i < stride; ++i) o.r[i] = Op3(c, OP_SEL, v.r[k * stride + i], o.r[i], hit);
+    }
+    return o;
+}
+
+static int ParseArgs(Compiler* c, Value* args) {
+    int n = 0;
+    if (Accept(c, ")")) return 0;
+    do {
+        if (n == MAX_PARAMS) { ErrorAt(c, Peek(c), "too many arguments"); return n; }
+        args[n++] = Assignment(c);
+    } while (Accept(c, ","));
+    Expect(c, ")");
+    return n;
+}
+
+static Value Primary(Compiler* c) {
+    const Token* t = Next(c);
+    Type type;
+    if (t->kind == TOK_NUMBER) return ConstScalar(c, t->is_int ? BT_INT : BT_FLOAT, (float)t->num);
+    if (TokIs(t, "true"))  return ConstScalar(c, BT_BOOL, 1.f);
+    if (TokIs(t, "false")) return ConstScalar(c, BT_BOOL, 0.f);
+    if (TokIs(t, "(")) {
+        Value v = Expression(c);
+        Expect(c, ")");
+        return v;
+    }
+    if (ParseTypeName(t, &type) && TokIs(Peek(c), "(")) {
+        Next(c);
+        Value args[MAX_PARAMS];
+        int n = ParseArgs(c, args);
+        if (type.base == BT_VOID) { ErrorAt(c, t, "cannot construct void"); return MakeValue(type); }
+        return Construct(c, type, args, n, t);
+    }
+    if (t->kind == TOK_IDENT && TokIs(Peek(c), "(")) {
+        Next(c);
+        Value args[MAX_PARAMS];
+        int n = ParseArgs(c, args);
+        return Call(c, t, args, n);
+    }
+    if (t->kind == TOK_IDENT) {
+        Symbol* s = Lookup(c, t);
+        if (s) {
+            Value v = MakeValue(s->t);
+            memcpy(v.r, s->r, sizeof(v.r));
+            v.lv = s->lv;
+            return v;
+        }
+        if (TokIs(t, "gl_FragCoord")) {
+            c->s->uses_frag_coord = true;
+            Value v = MakeValue(MakeType(BT_FLOAT, 1, 4));
+            for (int i = 0; i < 4; ++i) v.r[i] = c->s->frag_coord_reg + (uint32_t)i;
+            return v;
+        }
+        ErrorAt(c, t, "'%.*s' is not declared", t->len, t->s);
+        return ConstScalar(c, BT_FLOAT, 0.f);
+    }
+    if (t->kind == TOK_EOF) ErrorAt(c, t, "unexpected end of file");
+    else ErrorAt(c, t, "unexpected '%.*s'", t->len, t->s);
+    return ConstScalar(c, BT_FLOAT, 0.f);
+}
+
+static Value IncDec(Compiler* c, Value v, const Token* op, bool postfix) {
+    if (!v.lv) { ErrorAt(c, op, "'%.*s' needs an assignable operand", op->len, op->s); return v; }
+    if (!Numeric(c, &v, op)) return v;
+    Value old = v;
+    if (postfix) {
+        uint32_t r = NewRegs(c, TypeSize(v.t));
+        for (int i = 0; i < TypeSize(v.t); ++i) { Emit(c, OP_MOV, r + (uint32_t)i, v.r[i], 0, 0); old.r[i] = r + (uint32_t)i; }
+        old.lv = 0;
+    }
+    Value one = ConstScalar(c, v.t.base, 1.f);
+    Value nv = Arith(c, TokIs(op, "++") ? OP_ADD : OP_SUB, v, one, op);
+    StoreValue(c, &v, &nv, CurMask(c));
+    return postfix ? old : v;
+}
+
+static Value Postfix(Compiler* c) {
+    Value v = Primary(c);
+    for (;;) {
+        const Token* t = Peek(c);
+        if (TokIs(t, ".")) {
+            Next(c);
+            const Token* sw = Next(c);
+            if (TokIs(sw, "length") && Accept(c, "(")) {
+                Expect(c, ")");
+                v = ConstScalar(c, BT_INT, (float)(IsMatrix(v.t) ? v.t.cols : v.t.rows));
+            } else {
+                v = Swizzle(c, v, sw);
+            }
+        } else if (TokIs(t, "[")) {
+            Next(c);
+            Value idx = Expression(c);
+            Expect(c, "]");
+            v = Index(c, v, idx, t);
+        } else if (TokIs(t, "++") || TokIs(t, "--")) {
+            Next(c);
+            v = IncDec(c, v, t, true);
+        } else {
+            return v;
+        }
+    }
+}
+
+static Value Unary(Compiler* c) {
+    const Token* t = Peek(c);
+    if (TokIs(t, "-") || TokIs(t, "+") || TokIs(t, "!") || TokIs(t, "~") || TokIs(t, "++") || TokIs(t, "--")) {
+        Next(c);
+        Value v = Unary(c);
+        if (TokIs(t, "++") || TokIs(t, "--")) return IncDec(c, v, t, false);
+        if (TokIs(t, "~")) { ErrorAt(c, t, "bitwise operators are not supported by the CPU renderer"); return v; }
+        if (TokIs(t, "!")) {
+            if (!CheckBool(c, &v, t)) return v;
+            Value o = MakeValue(v.t);
+            o.r[0] = Op1(c, OP_NOT, v.r[0]);
+            return o;
+        }
+        if (!Numeric(c, &v, t)) return v;
+        v.lv = 0;
+        if (TokIs(t, "-")) for (int i = 0; i < TypeSize(v.t); ++i) v.r[i] = Op1(c, OP_NEG, v.r[i]);
+        return v;
+    }
+    return Postfix(c);
+}
+
+static int BinaryPrec(const Token* t) {
+    static const struct { const char* op; int prec; } ops[] = {
+        { "||", 1 }, { "^^", 2 }, { "&&", 3 }, { "|", 4 }, { "^", 5 }, { "&", 6 }, { "==", 7 }, { "!=", 7 },
+        { "<", 8 }, { ">", 8 }, { "<=", 8 }, { ">=", 8 }, { "<<", 9 }, { ">>", 9 },
+        { "+", 10 }, { "-", 10 }, { "*", 11 }, { "/", 11 }, { "%", 11 },
+    };
+    if (t->kind != TOK_PUNCT) return 0;
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); ++i) if (TokIs(t, ops[i].op)) return ops[i].prec;
+    return 0;
+}
+
+static Value Binary(Compiler* c, int min_prec) {
+    Value l = Unary(c);
+    for (;;) {
+        const Token* op = Peek(c);
+        int p = BinaryPrec(op);
+        if (!p || p < min_prec) return l;
+        Next(c);
+        Value r = Binary(c, p + 1);
+        if (p == 4 || p == 5 || p == 6 || p == 9) {
+            ErrorAt(c, op, "bitwise operators are not supported by the CPU renderer");
+        } else if (p <= 3) {
+            if (!CheckBool(c, &l, op) || !CheckBool(c, &r, op)) return l;
+            Value o = MakeValue(l.t);
+            o.r[0] = p == 1 ? Op2(c, OP_OR, l.r[0], r.r[0]) : p == 3 ? Op2(c, OP_AND, l.r[0], r.r[0])
+                                                                 : Op2(c, OP_NE, l.r[0], r.r[0]);
+            l = o;
+        } else if (p == 7 || p == 8) {
+            l = Compare(c, op, l, r);
+        } else if (TokIs(op, "%")) {
+            if (l.t.base != BT_INT || r.t.base != BT_INT) { ErrorAt(c, op, "'%%' needs int operands (use mod())"); return l; }
+            l = Arith(c, ARITH_IMOD, l, r, op);
+        } else {
+            l = Arith(c, TokIs(op, "+") ? OP_ADD : TokIs(op, "-") ? OP_SUB : TokIs(op, "*") ? OP_MUL : OP_DIV, l, r, op);
+        }
+    }
+}
+
+static Value Ternary(Compiler* c) {
+    Value cond = Binary(c, 1);
+    const Token* q = Peek(c);
+    if (!Accept(c, "?")) return cond;
+    Value a = Assignment(c);
+    Expect(c, ":");
+    Value b = Assignment(c);
+    if (!CheckBool(c, &cond, q)) return a;
+    if (a.t.base == BT_INT && b.t.base == BT_FLOAT) a = ConvertBase(c, a, BT_FLOAT);
+    if (b.t.base == BT_INT && a.t.base == BT_FLOAT) b = ConvertBase(c, b, BT_FLOAT);
+    if (!SameType(a.t, b.t)) { ErrorAt(c, q, "'?:' branches have different types"); return a; }
+    Value o = MakeValue(a.t);
+    for (int i = 0; i < TypeSize(a.t); ++i) o.r[i] = Op3(c, OP_SEL, a.r[i], b.r[i], cond.r[0]);
+    return o;
+}
+
+static Value Assignment(Compiler* c) {
+    Value l = Ternary(c);
+    const Token* op = Peek(c);
+    if (!IsAssignOp(op) || TokIs(op, "++") || TokIs(op, "--")) return l;
+    Next(c);
+    Value r = Assignment(c);
+    if (!l.lv) { ErrorAt(c, op, "left side of '%.*s' is not assignable", op->len, op->s); return l; }
+    if (!TokIs(op, "=")) {
+        static const char* const ops[] = { "+=", "-=", "*=", "/=", "%=" };
+        static const uint32_t codes[] = { OP_ADD, OP_SUB, OP_MUL, OP_DIV, ARITH_IMOD };
+        for (int i = 0; i < 5; ++i) if (TokIs(op, ops[i])) r = Arith(c, codes[i], l, r, op);
+    }
+    if (!Coerce(c, &r, l.t, op, "assignment")) return l;
+    StoreValue(c, &l, &r, CurMask(c));
+    return l;
+}
+
+static Value Expression(Compiler* c) {
+    Value v = Assignment(c);
+    while (Accept(c, ",")) v = Assignment(c);
+    return v;
+}
+
+// =========================== Statements ============================
+static bool AtDeclaration(Compiler* c) {
+    const Token* t = Peek(c);
+    Type type;
+    if (IsQualifier(t)) return true;
+    return ParseTypeName(t, &type) && PeekAt(c, 1)->kind == TOK_IDENT;
+}
+
+// [const] type name [= init] {, name [= init]} ;   Globals live for the whole program.
+static void Declaration(Compiler* c, bool global) {
+    bool is_const = false;
+    while (IsQualifier(Peek(c))) is_const |= TokIs(Next(c), "const");
+    const Token* tt = Next(c);
+    Type t;
+    if (!ParseTypeName(tt, &t) || t.base == BT_VOID) { ErrorAt(c, tt, "expected a type"); return; }
+    do {
+        const Token* name = Next(c);
+        if (name->kind != TOK_IDENT) { ErrorAt(c, name, "expected a name"); return; }
+        if (TokIs(Peek(c), "[")) { ErrorAt(c, name, "arrays are not supported by the CPU renderer"); return; }
+        const Token* eq = Peek(c);
+        uint32_t regs = NewRegs(c, TypeSize(t));
+        Value var = MakeValue(t);
+        for (int i = 0; i < TypeSize(t); ++i) var.r[i] = regs + (uint32_t)i;
+        var.lv = global ? 2 : 1;
+        if (Accept(c, "=")) {
+            uint32_t mark = c->next_reg;
+            Value init = Assignment(c);
+            if (!Coerce(c, &init, t, eq, "initialization")) return;
+            if (is_const && IsConstValue(&init)) {
+                // Folded: the name stands for the constants, no registers needed.
+                c->next_reg = regs;
+                var = init;
+                var.lv = 0;
+            } else {
+                // Fresh registers: lanes outside the current mask never read them.
+                StoreValue(c, &var, &init, MASK_ALL);
+                c->next_reg = mark;
+                if (is_const) var.lv = 0;
+            }
+        } else if (is_const) {
+            ErrorAt(c, name, "const '%.*s' needs an initializer", name->len, name->s);
+        }
+        AddSymbol(c, name, t, var.r, var.lv);
+        c->stmt_reg_base = c->next_reg;
+    } while (Accept(c, ","));
+    Expect(c, ";");
+}
+
+static void Block(Compiler* c) {
+    ScopeMark m = EnterScope(c);
+    while (!TokIs(Peek(c), "}") && Peek(c)->kind != TOK_EOF) Statement(c);
+    Expect(c, "}");
+    LeaveScope(c, m);
+}
+
+static Value Condition(Compiler* c) {
+    const Token* at = Peek(c);
+    Value v = Expression(c);
+    CheckBool(c, &v, at);
+    return v;
+}
+
+static int FindFrame(Compiler* c, int kind) {
+    for (int i = c->nframe - 1; i >= 0; --i) {
+        if (c->frame[i].kind == kind) return i;
+        if (c->frame[i].kind == FRAME_FUNC) break;
+    }
+    return -1;
+}
+
+static void IfStatement(Compiler* c) {
+    Expect(c, "(");
+    Value cond = Condition(c);
+    Expect(c, ")");
+    uint32_t cur = CurMask(c);
+    uint32_t cv = cond.r[0];
+    if (cond.lv) { uint32_t t = NewReg(c); Emit(c, OP_MOV, t, cv, 0, 0); cv = t; } // the branch may assign it
+    uint32_t mt = NewReg(c);
+    if (cur == MASK_ALL) Emit(c, OP_MOV, mt, cv, 0, 0);
+    else Emit(c, OP_AND, mt, cur, cv, 0);
+    int skip = EmitJump(c, OP_JZ, mt);
+    PushFrame(c, FRAME_IF, mt);
+    Statement(c);
+    PopFrame(c);
+    PatchJump(c, skip);
+    if (!Accept(c, "else")) return;
+    cur = CurMask(c);
+    uint32_t me = NewReg(c);
+    if (cur == MASK_ALL) Emit(c, OP_NOT, me, cv, 0, 0);
+    else Emit(c, OP_ANDNOT, me, cur, cv, 0);
+    skip = EmitJump(c, OP_JZ, me);
+    PushFrame(c, FRAME_IF, me);
+    Statement(c);
+    PopFrame(c);
+    PatchJump(c, skip);
+}
+
+// Lanes stay in the loop mask until their condition fails or they break; the body
+// mask additionally drops lanes that continue, until the next iteration.
+static void LoopStatement(Compiler* c, const Token* kw) {
+    ScopeMark scope = EnterScope(c);
+    bool is_for = TokIs(kw, "for"), is_do = TokIs(kw, "do");
+    int open = c->pos, step = -1, close = -1;
+    if (is_for) {
+        Expect(c, "(");
+        if (AtDeclaration(c)) Declaration(c, false);
+        else { if (!TokIs(Peek(c), ";")) Expression(c); Expect(c, ";"); }
+    }
+    uint32_t lm = CopyMask(c);
+    PushFrame(c, FRAME_LOOP, lm);
+    Label(c);
+    int top = c->ncode, exit_jump = -1;
+    if (!is_do) {
+        if (!is_for) Expect(c, "(");
+        if (!TokIs(Peek(c), is_for ? ";" : ")")) {
+            uint32_t mark = c->next_reg;
+            Value cond = Condition(c);
+            Emit(c, OP_AND, lm, lm, cond.r[0], 0);
+            c->next_reg = mark;
+        }
+        if (is_for) {
+            Expect(c, ";");
+            step = c->pos;
+            close = MatchingClose(c, open);
+            c->pos = close;
+        }
+        Expect(c, ")");
+        exit_jump = EmitJump(c, OP_JZ, lm);
+    }
+    uint32_t bm = NewReg(c);
+    Emit(c, OP_MOV, bm, lm, 0, 0);
+    PushFrame(c, FRAME_BODY, bm);
+    Statement(c);
+    PopFrame(c);
+    if (is_do) {
+        if (TokIs(Next(c), "while") && Expect(c, "(")) {
+            Value cond = Condition(c);
+            Emit(c, OP_AND, lm, lm, cond.r[0], 0);
+            Expect(c, ")");
+            Expect(c, ";");
+        } else {
+            ErrorAt(c, Peek(c), "expected 'while' after do body");
+        }
+        Emit(c, OP_JNZ, (uint32_t)top, lm, 0, 0);
+    } else {
+        if (step >= 0 && step < close && !c->failed) {
+            int resume = c->pos;
+            c->pos = step;
+            Expression(c);
+            if (c->pos != close) ErrorAt(c, Peek(c), "expected ')' after the loop step");
+            c->pos = resume;
+        }
+        Emit(c, OP_JMP, (uint32_t)top, 0, 0, 0);
+        PatchJump(c, exit_jump);
+    }
+    Label(c);
+    PopFrame(c);
+    LeaveScope(c, scope);
+}
+
+static void ReturnStatement(Compiler* c, const Token* kw) {
+    if (!c->ncall) { ErrorAt(c, kw, "return outside a function"); return; }
+    CallCtx* cx = &c->call[c->ncall - 1];
+    const Function* f = cx->f;
+    if (!TokIs(Peek(c), ";")) {
+        const Token* at = Peek(c);
+        Value v = Expression(c);
+        if (f->ret.base == BT_VOID) { ErrorAt(c, at, "void function %.*s returns a value", f->len, f->name); return; }
+        if (!Coerce(c, &v, f->ret, at, "return")) return;
+        Value dst = MakeValue(f->ret);
+        memcpy(dst.r, cx->ret, sizeof(dst.r));
+        StoreValue(c, &dst, &v, CurMask(c));
+    } else if (f->ret.base != BT_VOID) {
+        ErrorAt(c, kw, "%.*s must return a value", f->len, f->name);
+        return;
+    }
+    Expect(c, ";");
+    if (c->nframe - 1 == cx->frame && c->pos == f->body_end) return; // falls off the end anyway
+    KillLanes(c, cx->frame);
+    if (cx->nexit < MAX_EXITS) cx->exits[cx->nexit++] = EmitJump(c, OP_JZ, c->frame[cx->frame].mask);
+}
+
+static void Statement(Compiler* c) {
+    const Token* t = Peek(c);
+    int save_code_base = c->stmt_code_base;
+    uint32_t save_reg_base = c->stmt_reg_base;
+    uint32_t mark = c->next_reg;
+    c->stmt_code_base = c->ncode;
+    c->stmt_reg_base = c->next_reg;
+    bool declared = false;
+
+    if (Accept(c, "{")) {
+        Block(c);
+    } else if (Accept(c, ";")) {
+    } else if (TokIs(t, "if")) {
+        Next(c);
+        IfStatement(c);
+    } else if (TokIs(t, "for") || TokIs(t, "while") || TokIs(t, "do")) {
+        Next(c);
+        LoopStatement(c, t);
+    } else if (TokIs(t, "return")) {
+        Next(c);
+        ReturnStatement(c, t);
+    } else if (TokIs(t, "break") || TokIs(t, "continue")) {
+        Next(c);
+        int f = FindFrame(c, TokIs(t, "break") ? FRAME_LOOP : FRAME_BODY);
+        if (f < 0) ErrorAt(c, t, "'%.*s' outside a loop", t->len, t->s);
+        else KillLanes(c, f);
+        Expect(c, ";");
+    } else if (TokIs(t, "discard")) {
+        Next(c);
+        Expect(c, ";");
+        uint32_t cur = CurMask(c);
+        Emit(c, OP_SEL, c->s->discard_reg, Const(c, 1.f), c->s->discard_reg, cur == MASK_ALL ? Const(c, 1.f) : cur);
+        KillLanes(c, 0);
+        CallCtx* main_cx = &c->call[0];
+        if (main_cx->nexit < MAX_EXITS) main_cx->exits[main_cx->nexit++] = EmitJump(c, OP_JZ, c->frame[0].mask);
+    } else if (AtDeclaration(c)) {
+        Declaration(c, false);
+        declared = true;
+    } else {
+        Expression(c);
+        Expect(c, ";");
+    }
+    if (!declared) c->next_reg = mark;
+    c->stmt_code_base = save_code_base;
+    c->stmt_reg_base = save_reg_base;
+}
+
+// ========================== Top level ==============================
+static void SkipPast(Compiler* c, const char* p) {
+    while (Peek(c)->kind != TOK_EOF && !TokIs(Peek(c), p)) Next(c);
+    Accept(c, p);
+}
+
+static void AddUniform(Compiler* c, const Token* name, Type t) {
+    CpuShader* s = c->s;
+    if (s->nuniform == MAX_UNIFORMS) { ErrorAt(c, name, "too many uniforms"); return; }
+    if (name->len >= (int)sizeof(s->uniforms[0].name)) { ErrorAt(c, name, "uniform name too long"); return; }
+    CpuUniform* u = &s->uniforms[s->nuniform++];
+    memset(u, 0, sizeof(*u));
+    memcpy(u->name, name->s, (size_t)name->len);
+    u->size = TypeSize(t);
+    u->base = t.base;
+    u->reg = NewRegs(c, u->size);
+    uint32_t regs[MAX_COMPONENTS];
+    for (int i = 0; i < u->size; ++i) regs[i] = u->reg + (uint32_t)i;
+    AddSymbol(c, name, t, regs, 0);
+}
+
+// uniform T a, b;   or   uniform Block { T a; ... };  (members become plain uniforms)
+static void UniformDeclaration(Compiler* c) {
+    Type t;
+    if (Peek(c)->kind == TOK_IDENT && TokIs(PeekAt(c, 1), "{")) {
+        Next(c);
+        Next(c);
+        while (!c->failed && !Accept(c, "}")) {
+            while (IsQualifier(Peek(c))) Next(c);
+            const Token* tt = Next(c);
+            if (!ParseTypeName(tt, &t) || t.base == BT_VOID) { ErrorAt(c, tt, "unsupported uniform block member"); return; }
+            do {
+                const Token* name = Next(c);
+                if (name->kind != TOK_IDENT || TokIs(Peek(c), "[")) { ErrorAt(c, name, "unsupported uniform block member"); return; }
+                AddUniform(c, name, t);
+            } while (Accept(c, ","));
+            Expect(c, ";");
+        }
+        if (Peek(c)->kind == TOK_IDENT) { ErrorAt(c, Peek(c), "named uniform blocks are not supported by the CPU renderer"); return; }
+        Expect(c, ";");
+        return;
+    }
+    while (IsQualifier(Peek(c))) Next(c);
+    const Token* tt = Next(c);
+    if (TokIs(tt, "sampler2D") || TokIs(tt, "samplerCube") || TokIs(tt, "sampler3D")) {
+        ErrorAt(c, tt, "samplers are not supported by the CPU renderer");
+        return;
+    }
+    if (!ParseTypeName(tt, &t) || t.base == BT_VOID) { ErrorAt(c, tt, "unsupported uniform type '%.*s'", tt->len, tt->s); return; }
+    do {
+        const Token* name = Next(c);
+        if (name->kind != TOK_IDENT) { ErrorAt(c, name, "expected a name"); return; }
+        if (TokIs(Peek(c), "[")) { ErrorAt(c, name, "arrays are not supported by the CPU renderer"); return; }
+        AddUniform(c, name, t);
+    } while (Accept(c, ","));
+    Expect(c, ";");
+}
+
+static void InOutDeclaration(Compiler* c, bool is_in) {
+    while (IsQualifier(Peek(c))) Next(c);
+    const Token* tt = Next(c);
+    Type t;
+    if (!ParseTypeName(tt, &t) || t.base == BT_VOID) { ErrorAt(c, tt, "expected a type"); return; }
+    const Token* name = Next(c);
+    if (name->kind != TOK_IDENT || TokIs(Peek(c), "[")) { ErrorAt(c, name, "unsupported declaration"); return; }
+    CpuShader* s = c->s;
+    if (is_in) {
+        if (!TokIs(name, "vUV") || !SameType(t, MakeType(BT_FLOAT, 1, 2))) {
+            ErrorAt(c, name, "input '%.*s' is not provided by the CPU renderer (only vec2 vUV)", name->len, name->s);
+            return;
+        }
+        uint32_t regs[2] = { s->uv_reg, s->uv_reg + 1 };
+        AddSymbol(c, name, t, regs, 0);
+        s->uses_uv = true;
+    } else if (!c->have_out && t.base == BT_FLOAT && !IsMatrix(t) && t.rows >= 3) {
+        c->have_out = true;
+        s->out_size = t.rows;
+        AddSymbol(c, name, t, s->out_reg, 2);
+    } else {
+        uint32_t r = NewRegs(c, TypeSize(t)), regs[MAX_COMPONENTS];
+        for (int i = 0; i < TypeSize(t); ++i) regs[i] = r + (uint32_t)i;
+        AddSymbol(c, name, t, regs, 2); // a second output: written, never read back
+    }
+    Expect(c, ";");
+}
+
+// A return inside control flow, or followed by more code, needs the function's own mask.
+static bool ReturnsEarly(Compiler* c, const Function* f) {
+    int depth = 0;
+    for (int i = f->body + 1; i < f->body_end; ++i) {
+        const Token* t = &c->tok[i];
+        if (TokIs(t, "{")) ++depth;
+        else if (TokIs(t, "}")) --depth;
+        else if (TokIs(t, "return")) {
+            const Token* prev = &c->tok[i - 1];
+            int end = i;
+            while (end < f->body_end && !TokIs(&c->tok[end], ";")) ++end;
+            bool at_statement = TokIs(prev, ";") || TokIs(prev, "{") || TokIs(prev, "}");
+            if (depth != 0 || !at_statement || end + 1 != f->body_end) return true;
+        }
+    }
+    return false;
+}
+
+static void FunctionDefinition(Compiler* c, Type ret, const Token* name) {
+    Function f;
+    memset(&f, 0, sizeof(f));
+    f.name = name->s; f.len = name->len; f.ret = ret;
+    Expect(c, "(");
+    if (TokIs(Peek(c), "void") && TokIs(PeekAt(c, 1), ")")) Next(c);
+    if (!Accept(c, ")")) {
+        do {
+            if (f.nparam == MAX_PARAMS) { ErrorAt(c, Peek(c), "too many parameters"); return; }
+            uint8_t q = Q_IN;
+            for (;;) {
+                const Token* t = Peek(c);
+                if (TokIs(t, "in")) q = Q_IN;
+                else if (TokIs(t, "out")) q = Q_OUT;
+                else if (TokIs(t, "inout")) q = Q_INOUT;
+                else if (!IsQualifier(t)) break;
+                Next(c);
+            }
+            const Token* tt = Next(c);
+            Type t;
+            if (!ParseTypeName(tt, &t) || t.base == BT_VOID) {
+                ErrorAt(c, tt, TokIs(tt, "struct") || tt->kind == TOK_IDENT ? "unsupported parameter type '%.*s'" : "expected a type", tt->len, tt->s);
+                return;
+            }
+            f.ptype[f.nparam] = t;
+            f.pqual[f.nparam] = q;
+            if (Peek(c)->kind == TOK_IDENT) f.pname[f.nparam] = Next(c);
+            if (TokIs(Peek(c), "[")) { ErrorAt(c, Peek(c), "arrays are not supported by the CPU renderer"); return; }
+            if (q != Q_IN) c->any_out_params = true;
+            ++f.nparam;
+        } while (Accept(c, ","));
+        Expect(c, ")");
+    }
+    Function* existing = NULL;
+    for (int i = 0; i < c->nfn && !existing; ++i) {
+        Function* g = &c->fn[i];
+        bool same = SameName(name, g->name, g->len) && g->nparam == f.nparam;
+        for (int k = 0; k < f.nparam && same; ++k) same = SameType(g->ptype[k], f.ptype[k]);
+        if (same) existing = g;
+    }
+    if (Accept(c, ";")) { // prototype
+        if (!existing) {
+            c->fn = (Function*)Grow(c->fn, &c->capfn, c->nfn + 1, sizeof(Function));
+            f.body = -1;
+            c->fn[c->nfn++] = f;
+        }
+        return;
+    }
+    if (!TokIs(Peek(c), "{")) { Expect(c, "{"); return; }
+    if (existing && existing->body >= 0) { ErrorAt(c, name, "'%.*s' is already defined", name->len, name->s); return; }
+    f.body = c->pos;
+    f.body_end = MatchingClose(c, c->pos);
+    c->pos = f.body_end + 1;
+    f.needs_mask = ReturnsEarly(c, &f);
+    if (!existing) {
+        c->fn = (Function*)Grow(c->fn, &c->capfn, c->nfn + 1, sizeof(Function));
+        existing = &c->fn[c->nfn++];
+    }
+    *existing = f;
+}
+
+static void TopLevel(Compiler* c) {
+    while (Peek(c)->kind != TOK_EOF) {
+        c->nglobal = c->nsym;
+        const Token* t = Peek(c);
+        if (TokIs(t, "precision")) { SkipPast(c, ";"); continue; }
+        if (TokIs(t, "layout")) {
+            Next(c);
+            if (TokIs(Peek(c), "(")) c->pos = MatchingClose(c, c->pos) + 1;
+            continue;
+        }
+        if (TokIs(t, "struct")) { ErrorAt(c, t, "structs are not supported by the CPU renderer"); return; }
+        if (TokIs(t, "uniform")) { Next(c); UniformDeclaration(c); continue; }
+        if (TokIs(t, "in") || TokIs(t, "out")) { Next(c); InOutDeclaration(c, TokIs(t, "in")); continue; }
+        if (Accept(c, ";")) continue;
+
+        int start = c->pos;
+        while (IsQualifier(Peek(c))) Next(c);
+        const Token* tt = Next(c);
+        Type type;
+        if (!ParseTypeName(tt, &type)) { ErrorAt(c, tt, "unexpected '%.*s'", tt->len, tt->s); return; }
+        const Token* name = Next(c);
+        if (name->kind != TOK_IDENT) { ErrorAt(c, name, "expected a name"); return; }
+        if (TokIs(Peek(c), "(")) {
+            FunctionDefinition(c, type, name);
+        } else {
+            c->pos = start;
+            c->stmt_code_base = c->ncode;
+            c->stmt_reg_base = c->next_reg;
+            Declaration(c, true);
+        }
+    }
+}
+
+static void Finalize(Compiler* c) {
+    CpuShader* s = c->s;
+    uint32_t ndyn = c->max_reg;
+    for (int i = 0; i < c->ncode; ++i) {
+        CpuInstr* in = &c->code[i];
+        uint32_t* ops[4] = { &in->d, &in->a, &in->b, &in->c };
+        for (int k = in->op >= OP_JMP ? 1 : 0; k < 4; ++k)
+            if (IsConstReg(*ops[k])) *ops[k] = ndyn + (*ops[k] & ~REG_CONST);
+    }
+    s->code = c->code;
+    s->ncode = c->ncode;
+    c->code = NULL;
+    s->consts = c->consts;
+    s->nconst = c->nconst;
+    c->consts = NULL;
+    s->nreg = (int)ndyn + s->nconst;
+}
+
+// ============================== API ================================
+CpuShader* CpuShaderCompile(const char* src, char* log, int logsz) {
+    if (logsz > 0) log[0] = '\0';
+    Compiler* c = (Compiler*)calloc(1, sizeof(Compiler));
+    CpuShader* s = (CpuShader*)calloc(1, sizeof(CpuShader));
+    c->call = (CallCtx*)calloc(MAX_CALLS, sizeof(CallCtx));
+    if (!c || !s || !c->call) { free(c ? c->call : NULL); free(c); free(s); return NULL; }
+    c->log = log;
+    c->logsz = logsz;
+    c->s = s;
+
+    Tokenize(c, src);
+    for (int i = 0; i < c->ntok; ++i) c->any_discard |= TokIs(&c->tok[i], "discard");
+    s->uv_reg = NewRegs(c, 2);
+    s->frag_coord_reg = NewRegs(c, 4);
+    uint32_t out = NewRegs(c, 4);
+    for (int i = 0; i < 4; ++i) { s->out_reg[i] = out + (uint32_t)i; Emit(c, OP_MOV, s->out_reg[i], Const(c, 0.f), 0, 0); }
+    s->discard_reg = NewReg(c);
+    s->uses_discard = c->any_discard;
+    if (s->uses_discard) Emit(c, OP_MOV, s->discard_reg, Const(c, 0.f), 0, 0);
+    // Globals are visible everywhere: keep the symbol table's global part separate.
+    TopLevel(c);
+    c->nglobal = c->nsym;
+    c->scope_floor = c->nsym;
+
+    Function* main_fn = NULL;
+    for (int i = 0; i < c->nfn && !c->failed; ++i) {
+        Function* f = &c->fn[i];
+        if (f->body < 0) continue;
+        if (f->len == 4 && !memcmp(f->name, "main", 4)) main_fn = f;
+    }
+    if (!c->failed && !main_fn) ErrorAt(c, NULL, "no main() function");
+    if (!c->failed && !c->have_out) ErrorAt(c, NULL, "no 'out vec4' color output");
+    if (!c->failed) {
+        Token at = c->tok[main_fn->body];
+        InlineCall(c, main_fn, NULL, 0, &at);
+    }
+    if (!c->failed) Finalize(c);
+
+    bool ok = !c->failed;
+    free(c->text); free(c->tok); free(c->mtok); free(c->line); free(c->code); free(c->consts);
+    free(c->write_count); free(c->last_writer); free(c->sym); free(c->fn); free(c->call);
+    free(c);
+    if (!ok) { CpuShaderDestroy(s); return NULL; }
+    return s;
+}
+
+void CpuShaderDestroy(CpuShader* s) {
+    if (!s) return;
+    free(s->code);
+    free(s->consts);
+    free(s);
+}
+
+void CpuShaderGetInfo(const CpuShader* s, CpuShaderInfo* out) {
+    out->instructions = s->ncode;
+    out->registers = s->nreg;
+    out->constants = s->nconst;
+    out->uniforms = s->nuniform;
+    out->simd = SIMD_NAME;
+}
+
+int CpuShaderSetUniforms(CpuShader* s, const FrameInputs* in, const UserParams* params) {
+    const struct { const char* name; int count; float v[4]; } builtins[] = {
+        { "uResolution",   2, { in->resolution[0], in->resolution[1] } },
+        { "uMouse",        2, { in->mouse[0], in->mouse[1] } },
+        { "uDate",         4, { in->date[0], in->date[1], in->date[2], in->date[3] } },
+        { "uTime",         1, { in->time } },
+        { "uTimeDelta",    1, { in->time_delta } },
+        { "uFrame",        1, { (float)in->frame } },
+        { "uMouseButtons", 1, { (float)in->mouse_buttons } },
+        { "uTileOffset",   2, { in->tile_offset[0], in->tile_offset[1] } },
+        { "uJitter",       2, { in->jitter[0], in->jitter[1] } },
+    };
+    int matched = 0;
+    for (int i = 0; i < s->nuniform; ++i) {
+        CpuUniform* u = &s->uniforms[i];
+        memset(u->value, 0, sizeof(u->value));
+        bool found = false;
+        for (size_t k = 0; k < sizeof(builtins) / sizeof(builtins[0]) && !found; ++k) {
+            if (strcmp(u->name, builtins[k].name)) continue;
+            for (int j = 0; j < u->size && j < builtins[k].count; ++j) u->value[j] = builtins[k].v[j];
+            found = true;
+        }
+        for (int k = 0; params && !found && k < params->count; ++k) {
+            const UserParam* p = &params->p[k];
+            if (strcmp(u->name, p->name)) continue;
+            for (int j = 0; j < u->size && j < p->count; ++j) u->value[j] = p->v[j];
+            found = true;
+            ++matched;
+        }
+        for (int j = 0; j < u->size; ++j) {
+            if (u->base == BT_INT) u->value[j] = truncf(u->value[j]);
+            else if (u->base == BT_BOOL) u->value[j] = u->value[j] != 0.f ? 1.f : 0.f;
+        }
+    }
+    return matched;
+}
+
+float* CpuShaderAllocRegisters(const CpuShader* s) {
+    return (float*)calloc((size_t)s->nreg, sizeof(Lanes));
+}
+
+static void Broadcast(float* lanes, float v) {
+    for (int i = 0; i < CPU_LANES; ++i) lanes[i] = v;
+}
+
+void CpuShaderBeginFrame(const CpuShader* s, float* regs) {
+    Lanes* R = (Lanes*)regs;
+    uint32_t first_const = (uint32_t)(s->nreg - s->nconst);
+    for (int i = 0; i < s->nconst; ++i) Broadcast(R[first_const + (uint32_t)i], s->consts[i]);
+    for (int i = 0; i < s->nuniform; ++i)
+        for (int j = 0; j < s->uniforms[i].size; ++j) Broadcast(R[s->uniforms[i].reg + (uint32_t)j], s->uniforms[i].value[j]);
+    Broadcast(R[s->frag_coord_reg + 2], 0.5f);
+    Broadcast(R[s->frag_coord_reg + 3], 1.f);
+}
+
+void CpuShaderShadeBlock(const CpuShader* s, float* regs, int x, int y, int width, int height,
+                         float rgba[4][CPU_LANES]) {
+    Lanes* R = (Lanes*)regs;
+    for (int i = 0; i < CPU_LANES; ++i) {
+        float px = (float)(x + i % CPU_BLOCK) + 0.5f, py = (float)(y + i / CPU_BLOCK) + 0.5f;
+        R[s->frag_coord_reg][i] = px;
+        R[s->frag_coord_reg + 1][i] = py;
+        R[s->uv_reg][i] = px / (float)width;
+        R[s->uv_reg + 1][i] = py / (float)height;
+    }
+    RunProgram(s, R);
+    for (int k = 0; k < 4; ++k) {
+        if (k < s->out_size) memcpy(rgba[k], R[s->out_reg[k]], sizeof(Lanes));
+        else Broadcast(rgba[k], k == 3 ? 1.f : 0.f);
+    }
+    if (s->uses_discard)
+        for (int i = 0; i < CPU_LANES; ++i)
+            if (R[s->discard_reg][i] != 0.f) rgba[0][i] = rgba[1][i] = rgba[2][i] = rgba[3][i] = 0.f;
+}
@@ -0,0 +1,61 @@
+// cpu_shader.h — GLSL fragment shaders on the CPU, no GL driver involved
+//
+// A practical subset of GLSL 3.30 is compiled into a flat register IR and interpreted
+// over CPU_LANES pixels at once (a 4x4 block), each IR op running as SSE2/AVX vector
+// instructions across the lanes. The IR is scalarized: a vec3 is three registers and
+// swizzles cost nothing. Every user function is inlined; divergent control flow
+// (if/else, loops with break/continue, early return, discard) runs under per-lane
+// execution masks, and a branch or loop no lane takes is skipped.
+//
+// Supported: float/int/bool scalars, vec/ivec/bvec 2-4, mat2-4; the usual operators
+// and constructors; swizzles and indexing of vectors and matrices (dynamic indices
+// for reads only); if, for, while, do, break, continue, return, discard; functions with
+// in/out/inout parameters and overloads; the common math, geometric, vector
+// relational and derivative built-ins; #define/#undef/#if/#ifdef/#else/#endif.
+// Not supported: arrays, structs, samplers, bitwise operators, function-like macros.
+// Ints are exact up to 2^24 (they share the float lanes).
+//
+// Inputs match what Render() gives a program: the FrameInputs block members (or loose
+// uniforms of the same names), user uniforms set from a UserParams file, vUV as the
+// stock quad interpolates it, and gl_FragCoord. The vertex stage is not run. The first
+// "out vec4" (or vec3) is the color.
+
+#ifndef SHADERDEVEL_CPU_SHADER_H
+#define SHADERDEVEL_CPU_SHADER_H
+
+#include "platform.h"
+#include "uniforms.h"
+
+#define CPU_BLOCK 4                       // lanes are a CPU_BLOCK x CPU_BLOCK pixel block
+#define CPU_LANES (CPU_BLOCK * CPU_BLOCK)
+
+typedef struct CpuShader CpuShader;
+
+typedef struct {
+    int         instructions;
+    int         registers;   // per thread, each CPU_LANES floats
+    int         constants;
+    int         uniforms;
+    const char* simd;        // "AVX", "SSE4.1", "SSE2" or "scalar"
+} CpuShaderInfo;
+
+// src is the expanded fragment source (PreprocessShaderFile); errors are reported as
+// "<source>:<line>(<col>): error: ..." so MapShaderLog can name the file.
+CpuShader* CpuShaderCompile(const char* src, char* log, int logsz);
+void       CpuShaderDestroy(CpuShader* s);
+void       CpuShaderGetInfo(const CpuShader* s, CpuShaderInfo* out);
+
+// Sets the uniforms for the following blocks (not while any are being shaded).
+// params may be NULL. Returns how many user uniforms the params named.
+int        CpuShaderSetUniforms(CpuShader* s, const FrameInputs* in, const UserParams* params);
+
+// Per-thread register file, CpuShaderGetInfo().registers * CPU_LANES floats.
+float*     CpuShaderAllocRegisters(const CpuShader* s);
+// Once per frame per register file: loads constants and the current uniforms.
+void       CpuShaderBeginFrame(const CpuShader* s, float* regs);
+// Shades the block whose bottom-left pixel is (x, y) in GL window coordinates of a
+// width x height target; rgba[c][lane], lane = row * CPU_BLOCK + column, rows upward.
+void       CpuShaderShadeBlock(const CpuShader* s, float* regs, int x, int y, int width, int height,
+                               float rgba[4][CPU_LANES]);
+
+#endif // SHADERDEVEL_CPU_SHADER_H
@@ -0,0 +1,122 @@
+// dynres.c — see dynres.h
+#include "dynres.h"
+#include "shader.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DYNRES_GAIN      0.15f // fraction of the correction applied per sample; results lag a few frames
+#define DYNRES_DEAD_BAND 0.04f // relative scale error ignored, keeps the image from breathing
+
+// Fullscreen triangle from gl_VertexID, no vertex buffer needed.
+static const char* kUpscaleVert =
+    "#version 330 core\n"
+    "out vec2 vUV;\n"
+    "void main() {\n"
+    "    vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+    "    vUV = p;\n"
+    "    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);\n"
+    "}\n";
+
+// Bilinear fetch from the used corner of the target, plus an optional 5-tap unsharp mask.
+static const char* kUpscaleFrag =
+    "#version 330 core\n"
+    "in vec2 vUV;\n"
+    "out vec4 FragColor;\n"
+    "uniform sampler2D uSource;\n"
+    "uniform vec2  uUvScale;\n"
+    "uniform vec2  uTexel;\n"
+    "uniform float uSharpness;\n"
+    "vec3 Tap(vec2 uv) { return texture(uSource, clamp(uv, 0.5 * uTexel, uUvScale - 0.5 * uTexel)).rgb; }\n"
+    "void main() {\n"
+    "    vec2 uv = vUV * uUvScale;\n"
+    "    vec3 c = Tap(uv);\n"
+    "    if (uSharpness > 0.0) {\n"
+    "        vec3 n = Tap(uv + vec2(0.0, uTexel.y)) + Tap(uv - vec2(0.0, uTexel.y))\n"
+    "               + Tap(uv + vec2(uTexel.x, 0.0)) + Tap(uv - vec2(uTexel.x, 0.0));\n"
+    "        c = clamp(c + uSharpness * (4.0 * c - n), 0.0, 1.0);\n"
+    "    }\n"
+    "    FragColor = vec4(c, 1.0);\n"
+    "}\n";
+
+void DynResDefaultOptions(DynResOptions* opt, double target_ms) {
+    opt->target_ms = target_ms;
+    opt->min_scale = 0.25f;
+    opt->max_scale = 1.0f;
+    opt->sharpness = 0.2f;
+}
+
+bool DynResInit(DynamicResolution* dr, const DynResOptions* opt, char* log, int logsz) {
+    memset(dr, 0, sizeof(*dr));
+    dr->opt = *opt;
+    if (dr->opt.max_scale < dr->opt.min_scale) dr->opt.max_scale = dr->opt.min_scale;
+    dr->scale = dr->opt.max_scale < 1.0f ? dr->opt.max_scale : 1.0f;
+
+    GLuint vs = CompileShader(GL_VERTEX_SHADER, kUpscaleVert, log, logsz);
+    if (!vs) return false;
+    GLuint fs = CompileShader(GL_FRAGMENT_SHADER, kUpscaleFrag, log, logsz);
+    if (!fs) { glDeleteShader(vs); return false; }
+    dr->upscale_prog = LinkProgram(vs, fs, log, logsz);
+    glDeleteShader(vs); glDeleteShader(fs);
+    if (!dr->upscale_prog) return false;
+
+    glUseProgram(dr->upscale_prog);
+    glUniform1i(glGetUniformLocation(dr->upscale_prog, "uSource"), 0);
+    dr->uUvScale   = glGetUniformLocation(dr->upscale_prog, "uUvScale");
+    dr->uTexel     = glGetUniformLocation(dr->upscale_prog, "uTexel");
+    dr->uSharpness = glGetUniformLocation(dr->upscale_prog, "uSharpness");
+    glGenVertexArrays(1, &dr->empty_vao); // core profile draws need a VAO bound
+    return true;
+}
+
+void DynResShutdown(DynamicResolution* dr) {
+    DestroyRenderTarget(&dr->target);
+    if (dr->upscale_prog) { glDeleteProgram(dr->upscale_prog); dr->upscale_prog = 0; }
+    if (dr->empty_vao) { glDeleteVertexArrays(1, &dr->empty_vao); dr->empty_vao = 0; }
+}
+
+void DynResUpdate(DynamicResolution* dr, double scene_ms) {
+    if (scene_ms <= 0.0 || dr->opt.target_ms <= 0.0) return;
+    float desired = dr->scale * (float)sqrt(dr->opt.target_ms / scene_ms);
+    if (desired < dr->opt.min_scale) desired = dr->opt.min_scale;
+    if (desired > dr->opt.max_scale) desired = dr->opt.max_scale;
+    if (fabsf(desired - dr->scale) < DYNRES_DEAD_BAND * dr->scale) return;
+    dr->scale += DYNRES_GAIN * (desired - dr->scale);
+}
+
+static int ScaledSize(int size, float scale) {
+    int s = (int)((float)size * scale + 0.5f);
+    return s < 1 ? 1 : s;
+}
+
+bool DynResBegin(DynamicResolution* dr, int out_w, int out_h, int* render_w, int* render_h) {
+    if (out_w != dr->out_width || out_h != dr->out_height || !dr->target.fbo) {
+        DestroyRenderTarget(&dr->target);
+        int tw = ScaledSize(out_w, dr->opt.max_scale), th = ScaledSize(out_h, dr->opt.max_scale);
+        if (!CreateRenderTarget(&dr->target, tw, th, GL_RGBA8)) return false;
+        dr->out_width = out_w; dr->out_height = out_h;
+    }
+    dr->render_width  = ScaledSize(out_w, dr->scale);
+    dr->render_height = ScaledSize(out_h, dr->scale);
+    if (dr->render_width  > dr->target.width)  dr->render_width  = dr->target.width;
+    if (dr->render_height > dr->target.height) dr->render_height = dr->target.height;
+    *render_w = dr->render_width;
+    *render_h = dr->render_height;
+    glBindFramebuffer(GL_FRAMEBUFFER, dr->target.fbo);
+    return true;
+}
+
+void DynResEnd(DynamicResolution* dr, GLuint dst_fbo) {
+    float rw = (float)dr->render_width, rh = (float)dr->render_height;
+    glBindFramebuffer(GL_FRAMEBUFFER, dst_fbo);
+    glViewport(0, 0, dr->out_width, dr->out_height);
+    glUseProgram(dr->upscale_prog);
+    glUniform2f(dr->uUvScale, rw / (float)dr->target.width, rh / (float)dr->target.height);
+    glUniform2f(dr->uTexel, 1.0f / (float)dr->target.width, 1.0f / (float)dr->target.height);
+    glUniform1f(dr->uSharpness, dr->opt.sharpness);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, dr->target.color);
+    glBindVertexArray(dr->empty_vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
@@ -0,0 +1,48 @@
+// dynres.h — dynamic resolution: render the scene smaller, upscale to the output
+//
+// The scene pass draws into an offscreen target at scale * output size; a final
+// pass upscales it into the output framebuffer (bilinear, optionally with a light
+// unsharp mask). The target is allocated once at max_scale, so changing the scale
+// only changes the viewport and never reallocates.
+//
+// The controller adjusts the scale from the measured scene time (GPU timer samples,
+// a few frames late) toward target_ms. Cost is taken as proportional to pixel count,
+// so the step is sqrt(target / measured), damped and with a small dead band.
+
+#ifndef SHADERDEVEL_DYNRES_H
+#define SHADERDEVEL_DYNRES_H
+
+#include "platform.h"
+#include "render_target.h"
+#include <glad/gl.h>
+
+typedef struct {
+    double target_ms;  // scene pass budget, e.g. 16.6 for 60 Hz
+    float  min_scale;  // per axis
+    float  max_scale;  // per axis; >1 supersamples when there is headroom
+    float  sharpness;  // 0 = plain bilinear upscale, ~0.2 recovers some detail
+} DynResOptions;
+
+typedef struct {
+    DynResOptions opt;
+    float         scale;
+    RenderTarget  target;     // sized for max_scale at the current output size
+    int           out_width, out_height;
+    int           render_width, render_height; // this frame's internal size
+    GLuint        upscale_prog, empty_vao;
+    GLint         uUvScale, uTexel, uSharpness;
+} DynamicResolution;
+
+void DynResDefaultOptions(DynResOptions* opt, double target_ms);
+// Needs a current context. False (with log) if the upscale shader fails to build.
+bool DynResInit(DynamicResolution* dr, const DynResOptions* opt, char* log, int logsz);
+void DynResShutdown(DynamicResolution* dr);
+
+// Feeds one measured scene time into the controller.
+void DynResUpdate(DynamicResolution* dr, double scene_ms);
+// Binds the offscreen target for an output of out_w x out_h and returns the internal size.
+bool DynResBegin(DynamicResolution* dr, int out_w, int out_h, int* render_w, int* render_h);
+// Upscales the internal image into dst_fbo (out_w x out_h from DynResBegin).
+void DynResEnd(DynamicResolution* dr, GLuint dst_fbo);
+
+#endif // SHADERDEVEL_DYNRES_H
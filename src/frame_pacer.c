@@ -0,0 +1,187 @@
+// frame_pacer.c — see frame_pacer.h
+#include "frame_pacer.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAME_PACER_RING (FRAME_PACER_MAX_IN_FLIGHT + 1)
+#define FRAME_PACER_CALIBRATE_SECONDS 1.0
+#define FRAME_PACER_WAIT_NS 1000000000ull // a frame stuck this long is the driver's problem
+
+typedef struct {
+    GLsync fence;
+    GLuint query[2];  // GPU timestamps: draw done, swap done
+    double input;     // NowSeconds when its input was sampled
+    double deadline;  // just-in-time frames, 0 otherwise
+    int    generation;
+} PacerSlot;
+
+struct FramePacer {
+    FramePacerOptions opt;
+    PacerSlot slot[FRAME_PACER_RING];
+    int       head, tail, in_flight;
+    int       generation; // bumped by ResetStats; older frames aren't counted
+    double    gpu_offset; // NowSeconds - GPU timestamp seconds
+    double    calibrated_at;
+
+    double    latency[FRAME_PACER_WINDOW], cost[FRAME_PACER_WINDOW];
+    int       window_count, window_next;
+    double    cost_estimate; // p95 cost in seconds, 0 = no sample yet
+    double    wait_total, sleep_total;
+    int       frames, missed;
+    bool      begun;
+};
+
+static void Calibrate(FramePacer* p) {
+    double t0 = NowSeconds();
+    GLint64 gpu = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpu);
+    double t1 = NowSeconds();
+    p->gpu_offset = 0.5 * (t0 + t1) - (double)gpu * 1e-9;
+    p->calibrated_at = t1;
+}
+
+FramePacer* FramePacerCreate(const FramePacerOptions* opt) {
+    FramePacer* p = (FramePacer*)calloc(1, sizeof(FramePacer));
+    if (!p) return NULL;
+    p->opt = *opt;
+    if (p->opt.max_in_flight < 1) p->opt.max_in_flight = 1;
+    if (p->opt.max_in_flight > FRAME_PACER_MAX_IN_FLIGHT) p->opt.max_in_flight = FRAME_PACER_MAX_IN_FLIGHT;
+    for (int i = 0; i < FRAME_PACER_RING; ++i) glGenQueries(2, p->slot[i].query);
+    Calibrate(p);
+    return p;
+}
+
+void FramePacerDestroy(FramePacer* p) {
+    if (!p) return;
+    for (int i = 0; i < FRAME_PACER_RING; ++i) {
+        if (p->slot[i].fence) glDeleteSync(p->slot[i].fence);
+        glDeleteQueries(2, p->slot[i].query);
+    }
+    free(p);
+}
+
+static void AddSample(FramePacer* p, double latency_ms, double cost_ms) {
+    p->latency[p->window_next] = latency_ms;
+    p->cost[p->window_next] = cost_ms;
+    p->window_next = (p->window_next + 1) % FRAME_PACER_WINDOW;
+    if (p->window_count < FRAME_PACER_WINDOW) p->window_count++;
+}
+
+// Retires the oldest frame; its timestamps are read if the GPU has them.
+static void Retire(FramePacer* p) {
+    PacerSlot* s = &p->slot[p->tail];
+    glDeleteSync(s->fence);
+    s->fence = NULL;
+    p->tail = (p->tail + 1) % FRAME_PACER_RING;
+    p->in_flight--;
+    GLint available = 0;
+    glGetQueryObjectiv(s->query[1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available || s->generation != p->generation) return;
+    GLuint64 drawn = 0, presented = 0;
+    glGetQueryObjectui64v(s->query[0], GL_QUERY_RESULT, &drawn);
+    glGetQueryObjectui64v(s->query[1], GL_QUERY_RESULT, &presented);
+    double drawn_at = (double)drawn * 1e-9 + p->gpu_offset;
+    double presented_at = (double)presented * 1e-9 + p->gpu_offset;
+    if (s->deadline > 0.0 && drawn_at > s->deadline) p->missed++;
+    // Clock jitter can put a cheap frame's GPU time a hair before its input.
+    AddSample(p, fmax(presented_at - s->input, 0.0) * 1000.0, fmax(drawn_at - s->input, 0.0) * 1000.0);
+}
+
+// Retires frames as long as their fences have signaled; wait=true blocks on the oldest.
+static void Harvest(FramePacer* p, bool wait) {
+    while (p->in_flight > 0) {
+        PacerSlot* s = &p->slot[p->tail];
+        GLenum r = glClientWaitSync(s->fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? FRAME_PACER_WAIT_NS : 0);
+        if (r == GL_TIMEOUT_EXPIRED && !wait) return;
+        Retire(p);
+        wait = false;
+    }
+}
+
+// Sleeps in whole milliseconds while more than one is left, then spins to the target.
+static void SleepUntil(double target) {
+    for (;;) {
+        double left = target - NowSeconds();
+        if (left <= 0.0) return;
+        if (left > 0.002) SleepMilliseconds((int)(left * 1000.0) - 1);
+    }
+}
+
+double FramePacerBeginFrame(FramePacer* p, double deadline) {
+    double t0 = NowSeconds();
+    if (t0 - p->calibrated_at > FRAME_PACER_CALIBRATE_SECONDS) Calibrate(p); // the clocks drift apart
+    Harvest(p, false);
+    while (p->in_flight >= p->opt.max_in_flight) Harvest(p, true);
+    double t1 = NowSeconds();
+    p->wait_total += t1 - t0;
+
+    PacerSlot* s = &p->slot[p->head];
+    s->deadline = 0.0;
+    if (p->opt.jit_margin_ms > 0.0 && deadline > 0.0 && p->window_count > 0) {
+        if (p->cost_estimate == 0.0 || p->frames % 16 == 0) { // the p95 moves slowly
+            FrameStats cost;
+            ComputeFrameStats(p->cost, p->window_count, &cost);
+            p->cost_estimate = cost.p95_ms * 1e-3;
+        }
+        double start = deadline - p->cost_estimate - p->opt.jit_margin_ms * 1e-3;
+        if (start > t1) {
+            SleepUntil(start);
+            p->sleep_total += NowSeconds() - t1;
+        }
+        s->deadline = deadline;
+    }
+    p->frames++;
+    p->begun = true;
+    s->input = NowSeconds();
+    return s->input;
+}
+
+void FramePacerDrawn(FramePacer* p) {
+    if (!p->begun) return;
+    glQueryCounter(p->slot[p->head].query[0], GL_TIMESTAMP);
+}
+
+void FramePacerEndFrame(FramePacer* p) {
+    if (!p->begun) return;
+    PacerSlot* s = &p->slot[p->head];
+    glQueryCounter(s->query[1], GL_TIMESTAMP);
+    s->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    s->generation = p->generation;
+    p->head = (p->head + 1) % FRAME_PACER_RING;
+    p->in_flight++;
+    p->begun = false;
+}
+
+void FramePacerFinish(FramePacer* p) {
+    while (p->in_flight > 0) Harvest(p, true);
+}
+
+bool FramePacerGetStats(FramePacer* p, FramePacerStats* out) {
+    memset(out, 0, sizeof(*out));
+    ComputeFrameStats(p->latency, p->window_count, &out->latency);
+    ComputeFrameStats(p->cost, p->window_count, &out->cost);
+    if (p->frames > 0) {
+        out->wait_ms = p->wait_total * 1000.0 / p->frames;
+        out->sleep_ms = p->sleep_total * 1000.0 / p->frames;
+    }
+    out->missed = p->missed;
+    return p->window_count > 0;
+}
+
+void FramePacerResetStats(FramePacer* p) {
+    p->generation++;
+    p->window_count = p->window_next = 0;
+    p->wait_total = p->sleep_total = 0.0;
+    p->frames = p->missed = 0;
+    p->cost_estimate = 0.0;
+}
+
+void FramePacerDescribe(const FramePacer* p, char* out, size_t outsz) {
+    if (p->opt.jit_margin_ms > 0.0)
+        snprintf(out, outsz, "%d in flight, just-in-time %.1f ms", p->opt.max_in_flight, p->opt.jit_margin_ms);
+    else
+        snprintf(out, outsz, "%d in flight", p->opt.max_in_flight);
+}
@@ -0,0 +1,69 @@
+// frame_pacer.h — bounds the frames in flight with fences and measures input-to-present latency
+//
+// The driver may queue several frames behind SwapBuffers, and input sampled for the
+// newest of them reaches the screen that many refreshes later. The pacer puts a fence
+// after every frame's swap; before the next frame samples its input it waits until at
+// most max_in_flight - 1 earlier frames are unfinished. With 1 the CPU never runs ahead
+// of the GPU; 2 and 3 trade latency for throughput.
+//
+// Just-in-time mode also delays the frame's start until its predicted cost (input
+// sample to the GPU finishing the draw, p95 of recent frames) plus a margin before
+// the deadline the caller gives, normally the next vblank, so input is as fresh as it
+// can be and the frame still makes that vblank. A frame that misses it widens nothing
+// by itself; the cost estimate follows within a few frames.
+//
+// Timestamp queries before and after the swap, mapped onto the NowSeconds clock,
+// give per frame: cost (input to the draw done on the GPU) and latency (input to the
+// swap done on the GPU, which is when the compositor or display can have it; a scanout
+// adds up to one refresh more). Results are read when the fences say so, never waited
+// for, except by the in-flight bound itself.
+
+#ifndef SHADERDEVEL_FRAME_PACER_H
+#define SHADERDEVEL_FRAME_PACER_H
+
+#include "platform.h"
+#include "frame_stats.h"
+#include <glad/gl.h>
+
+#define FRAME_PACER_MAX_IN_FLIGHT 3
+#define FRAME_PACER_WINDOW        240 // frames kept for the statistics
+
+typedef struct {
+    int    max_in_flight; // 1 .. FRAME_PACER_MAX_IN_FLIGHT
+    double jit_margin_ms; // > 0: just-in-time starts, this much before the deadline; 0 = off
+} FramePacerOptions;
+
+typedef struct {
+    FrameStats latency;      // input to present, ms
+    FrameStats cost;         // input to the draw done, ms
+    double     wait_ms;      // mean time blocked on fences per frame
+    double     sleep_ms;     // mean just-in-time delay per frame
+    int        missed;       // just-in-time frames done after their deadline
+} FramePacerStats;
+
+typedef struct FramePacer FramePacer;
+
+// Needs a current context (sync objects and timestamp queries are core in 3.3). NULL when
+// out of memory; callers then draw unpaced.
+FramePacer* FramePacerCreate(const FramePacerOptions* opt);
+void        FramePacerDestroy(FramePacer* p);
+
+// Before sampling input: harvests finished frames, waits for the in-flight bound and,
+// in just-in-time mode with deadline > 0 (NowSeconds clock), sleeps until the start
+// the estimate allows. Returns the input timestamp: sample input right after.
+double FramePacerBeginFrame(FramePacer* p, double deadline);
+// After the frame's draw calls, before the swap.
+void   FramePacerDrawn(FramePacer* p);
+// After the swap.
+void   FramePacerEndFrame(FramePacer* p);
+// Waits for every frame in flight and counts them (end of a run).
+void   FramePacerFinish(FramePacer* p);
+
+// Over the last FRAME_PACER_WINDOW measured frames; false while there are none.
+bool   FramePacerGetStats(FramePacer* p, FramePacerStats* out);
+// Drops the statistics (new program, new options); frames in flight stay tracked.
+void   FramePacerResetStats(FramePacer* p);
+// "2 in flight" or "1 in flight, just-in-time 2.0 ms", for titles and banners.
+void   FramePacerDescribe(const FramePacer* p, char* out, size_t outsz);
+
+#endif // SHADERDEVEL_FRAME_PACER_H
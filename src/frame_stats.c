@@ -0,0 +1,42 @@
+// frame_stats.c — see frame_stats.h
+#include "frame_stats.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static int CompareDouble(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static double NearestRank(const double* sorted, int count, double pct) {
+    int rank = (int)(pct / 100.0 * (double)count + 0.999999); // ceil
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return sorted[rank - 1];
+}
+
+// Rolling windows (the GPU timer's 512, the pacer's 240) sort on the stack, so the
+// pacer's per-frame use allocates nothing; longer runs take the heap.
+#define FRAME_STATS_STACK_SAMPLES 512
+
+void ComputeFrameStats(const double* samples_ms, int count, FrameStats* out) {
+    memset(out, 0, sizeof(*out));
+    if (count <= 0) return;
+    double scratch[FRAME_STATS_STACK_SAMPLES];
+    double* sorted = count <= FRAME_STATS_STACK_SAMPLES ? scratch : (double*)malloc((size_t)count * sizeof(double));
+    if (!sorted) return;
+    memcpy(sorted, samples_ms, (size_t)count * sizeof(double));
+    qsort(sorted, (size_t)count, sizeof(double), CompareDouble);
+
+    double sum = 0.0;
+    for (int i = 0; i < count; ++i) sum += sorted[i];
+    out->frames    = count;
+    out->min_ms    = sorted[0];
+    out->max_ms    = sorted[count - 1];
+    out->median_ms = NearestRank(sorted, count, 50.0);
+    out->p95_ms    = NearestRank(sorted, count, 95.0);
+    out->p99_ms    = NearestRank(sorted, count, 99.0);
+    out->mean_ms   = sum / (double)count;
+    if (sorted != scratch) free(sorted);
+}
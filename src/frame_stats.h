@@ -0,0 +1,16 @@
+// frame_stats.h — summary statistics over a set of frame time samples
+#ifndef SHADERDEVEL_FRAME_STATS_H
+#define SHADERDEVEL_FRAME_STATS_H
+
+#include "platform.h"
+
+typedef struct {
+    int    frames;
+    double min_ms, median_ms, p95_ms, p99_ms, mean_ms, max_ms;
+} FrameStats;
+
+// Sorts a copy of the samples; percentiles use the nearest-rank method. out is all
+// zeros when count <= 0, or when a copy past 512 samples can't be allocated.
+void ComputeFrameStats(const double* samples_ms, int count, FrameStats* out);
+
+#endif // SHADERDEVEL_FRAME_STATS_H
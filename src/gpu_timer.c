@@ -0,0 +1,132 @@
+// gpu_timer.c — see gpu_timer.h
+#include "gpu_timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// No real frame takes this long (the OS would reset the GPU first); some drivers
+// (llvmpipe) report a bogus first interval, which would wreck every statistic.
+#define GPU_TIMER_MAX_PLAUSIBLE_MS 10000.0
+
+typedef struct {
+    GLuint   query;
+    bool     pending;
+    int      version; // GpuTimer version the frame was drawn with
+    uint64_t frame;
+} TimerSlot;
+
+struct GpuTimer {
+    TimerSlot slots[GPU_TIMER_RING];
+    int       head;     // next slot to issue
+    int       tail;     // oldest pending slot
+    int       active;   // slot between Begin and End, -1 if this frame is untimed
+    uint64_t  frame;
+    int       version;
+
+    double    window[GPU_TIMER_WINDOW];
+    int       window_count, window_next;
+    double    latest_ms;
+    bool      latest_fresh;
+
+    FILE*     csv;
+    void    (*sink)(void* user, double ms);
+    void*     sink_user;
+};
+
+GpuTimer* GpuTimerCreate(void) {
+    GpuTimer* t = (GpuTimer*)calloc(1, sizeof(GpuTimer));
+    if (!t) return NULL;
+    for (int i = 0; i < GPU_TIMER_RING; ++i) glGenQueries(1, &t->slots[i].query);
+    t->active = -1;
+    return t;
+}
+
+void GpuTimerDestroy(GpuTimer* t) {
+    if (!t) return;
+    for (int i = 0; i < GPU_TIMER_RING; ++i) glDeleteQueries(1, &t->slots[i].query);
+    if (t->csv) fclose(t->csv);
+    free(t);
+}
+
+bool GpuTimerOpenCsv(GpuTimer* t, const char* path) {
+    if (t->csv) fclose(t->csv);
+    t->csv = fopen(path, "w");
+    if (!t->csv) return false;
+    fprintf(t->csv, "frame,version,gpu_ms\n");
+    return true;
+}
+
+void GpuTimerSetSink(GpuTimer* t, void (*fn)(void* user, double ms), void* user) {
+    t->sink = fn;
+    t->sink_user = user;
+}
+
+static void AddSample(GpuTimer* t, const TimerSlot* s, double ms) {
+    if (t->csv) fprintf(t->csv, "%llu,%d,%.4f\n", (unsigned long long)s->frame, s->version, ms);
+    if (t->sink) t->sink(t->sink_user, ms);
+    if (s->version != t->version) return; // drawn with the previous program
+    t->window[t->window_next] = ms;
+    t->window_next = (t->window_next + 1) % GPU_TIMER_WINDOW;
+    if (t->window_count < GPU_TIMER_WINDOW) t->window_count++;
+    t->latest_ms = ms;
+    t->latest_fresh = true;
+}
+
+void GpuTimerCollect(GpuTimer* t, bool wait) {
+    // Results complete in submission order, so stop at the first one not ready.
+    while (t->slots[t->tail].pending) {
+        TimerSlot* s = &t->slots[t->tail];
+        if (!wait) {
+            GLint available = 0;
+            glGetQueryObjectiv(s->query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) break;
+        }
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(s->query, GL_QUERY_RESULT, &ns);
+        s->pending = false;
+        double ms = (double)ns * 1e-6;
+        if (ms < GPU_TIMER_MAX_PLAUSIBLE_MS) AddSample(t, s, ms);
+        t->tail = (t->tail + 1) % GPU_TIMER_RING;
+    }
+}
+
+void GpuTimerBegin(GpuTimer* t) {
+    GpuTimerCollect(t, false);
+    t->frame++;
+    TimerSlot* s = &t->slots[t->head];
+    if (s->pending) { t->active = -1; return; } // GPU is a full ring behind
+    s->version = t->version;
+    s->frame   = t->frame;
+    glBeginQuery(GL_TIME_ELAPSED, s->query);
+    t->active = t->head;
+}
+
+void GpuTimerEnd(GpuTimer* t) {
+    if (t->active < 0) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    t->slots[t->active].pending = true;
+    t->head = (t->head + 1) % GPU_TIMER_RING;
+    t->active = -1;
+}
+
+void GpuTimerReset(GpuTimer* t) {
+    t->version++;
+    t->window_count = 0;
+    t->window_next  = 0;
+    t->latest_fresh = false;
+}
+
+int GpuTimerVersion(const GpuTimer* t) { return t->version; }
+
+bool GpuTimerTakeLatest(GpuTimer* t, double* out_ms) {
+    if (!t->latest_fresh) return false;
+    t->latest_fresh = false;
+    *out_ms = t->latest_ms;
+    return true;
+}
+
+bool GpuTimerGetStats(GpuTimer* t, FrameStats* out) {
+    ComputeFrameStats(t->window, t->window_count, out);
+    return t->window_count > 0;
+}
@@ -0,0 +1,48 @@
+// gpu_timer.h — per-frame GPU time from GL_TIME_ELAPSED queries, without stalling
+//
+// Queries live in a small ring: a frame's result is read back GPU_TIMER_RING-1
+// frames later, once GL_QUERY_RESULT_AVAILABLE says so, so the CPU never waits on
+// the GPU. If every slot is still in flight the frame simply goes untimed.
+// Samples feed a rolling window for mean/p50/p95/p99 and optionally a CSV file.
+
+#ifndef SHADERDEVEL_GPU_TIMER_H
+#define SHADERDEVEL_GPU_TIMER_H
+
+#include "platform.h"
+#include "frame_stats.h"
+#include <glad/gl.h>
+
+#define GPU_TIMER_RING   6   // queries in flight
+#define GPU_TIMER_WINDOW 512 // samples kept for the rolling statistics
+
+typedef struct GpuTimer GpuTimer;
+
+// Needs a current context (timer queries are core in 3.3). NULL when out of memory;
+// callers then draw untimed.
+GpuTimer* GpuTimerCreate(void);
+void      GpuTimerDestroy(GpuTimer* t);
+
+// Streams "frame,version,gpu_ms" rows as results arrive. Returns false if the file
+// can't be opened; timing still works.
+bool GpuTimerOpenCsv(GpuTimer* t, const char* path);
+// Also hands every sample (any version) to fn, on the thread that calls Begin/Collect.
+void GpuTimerSetSink(GpuTimer* t, void (*fn)(void* user, double ms), void* user);
+
+// Bracket the draw. Begin first harvests whatever earlier queries have finished.
+void GpuTimerBegin(GpuTimer* t);
+void GpuTimerEnd(GpuTimer* t);
+// Harvests finished queries; wait=true blocks until all in-flight ones are done
+// (end of a benchmark run, not per frame).
+void GpuTimerCollect(GpuTimer* t, bool wait);
+
+// Starts a new shader version: clears the window and drops results still in flight.
+void GpuTimerReset(GpuTimer* t);
+int  GpuTimerVersion(const GpuTimer* t);
+
+// Newest sample of the current version not taken yet (feedback controllers); false if none.
+bool GpuTimerTakeLatest(GpuTimer* t, double* out_ms);
+
+// Rolling statistics over the current version; false while there are no samples.
+bool GpuTimerGetStats(GpuTimer* t, FrameStats* out);
+
+#endif // SHADERDEVEL_GPU_TIMER_H
@@ -0,0 +1,18 @@
+#version 330 core
+in vec2 vUV;
+out vec4 FragColor;
+
+uniform float uTime;
+uniform vec2  uResolution;
+uniform vec2  uMouse;
+uniform sampler2D iChannel0; // BufferA, previous frame
+
+void main() {
+    vec2 p = vUV * uResolution;
+    // uMouse is in window pixels with y down; fall back to a moving point headless
+    vec2 m = uMouse.x + uMouse.y > 0.0 ? vec2(uMouse.x, uResolution.y - uMouse.y)
+                                       : uResolution * (0.5 + 0.35 * vec2(cos(uTime), sin(1.3 * uTime)));
+    float dot = smoothstep(12.0, 0.0, length(p - m));
+    vec3 prev = texture(iChannel0, vUV).rgb * 0.97;
+    FragColor = vec4(max(prev, vec3(dot)), 1.0);
+}
@@ -0,0 +1,15 @@
+#version 330 core
+in vec2 vUV;
+out vec4 FragColor;
+
+uniform vec2  uResolution;
+uniform sampler2D iChannel0; // BufferA
+
+void main() {
+    vec2 px = 1.0 / uResolution;
+    vec3 sum = vec3(0.0);
+    for (int y = -2; y <= 2; ++y)
+        for (int x = -2; x <= 2; ++x)
+            sum += texture(iChannel0, vUV + vec2(x, y) * 2.0 * px).rgb;
+    FragColor = vec4(sum / 25.0, 1.0);
+}
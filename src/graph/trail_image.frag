@@ -0,0 +1,14 @@
+#version 330 core
+in vec2 vUV;
+out vec4 FragColor;
+
+uniform float uTime;
+uniform sampler2D iChannel0; // BufferB (glow)
+uniform sampler2D iChannel1; // BufferA (sharp trail)
+
+void main() {
+    vec3 glow  = texture(iChannel0, vUV).rgb;
+    vec3 trail = texture(iChannel1, vUV).rgb;
+    vec3 tint  = 0.5 + 0.5 * cos(uTime + vec3(0.0, 2.0, 4.0));
+    FragColor = vec4(trail + 2.0 * glow * tint, 1.0);
+}
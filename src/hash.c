@@ -0,0 +1,77 @@
+// hash.c — see hash.h
+#include "hash.h"
+
+#include <string.h>
+
+#define PRIME64_1 0x9E3779B185EBCA87ull
+#define PRIME64_2 0xC2B2AE3D27D4EB4Full
+#define PRIME64_3 0x165667B19E3779F9ull
+#define PRIME64_4 0x85EBCA77C2B2AE63ull
+#define PRIME64_5 0x27D4EB2F165667C5ull
+
+static inline uint64_t Rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+// Unaligned little-endian reads (every target we build for is little-endian).
+static inline uint64_t Read64(const uint8_t* p) { uint64_t v; memcpy(&v, p, 8); return v; }
+static inline uint32_t Read32(const uint8_t* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+static inline uint64_t Round(uint64_t acc, uint64_t input) {
+    acc += input * PRIME64_2;
+    acc  = Rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+static inline uint64_t MergeRound(uint64_t acc, uint64_t val) {
+    acc ^= Round(0, val);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+uint64_t Hash64(const void* data, size_t len, uint64_t seed) {
+    const uint8_t* p   = (const uint8_t*)data;
+    const uint8_t* end = p + len;
+    uint64_t h;
+
+    if (len >= 32) {
+        const uint8_t* limit = end - 32;
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+        do {
+            v1 = Round(v1, Read64(p)); p += 8;
+            v2 = Round(v2, Read64(p)); p += 8;
+            v3 = Round(v3, Read64(p)); p += 8;
+            v4 = Round(v4, Read64(p)); p += 8;
+        } while (p <= limit);
+        h = Rotl64(v1, 1) + Rotl64(v2, 7) + Rotl64(v3, 12) + Rotl64(v4, 18);
+        h = MergeRound(h, v1);
+        h = MergeRound(h, v2);
+        h = MergeRound(h, v3);
+        h = MergeRound(h, v4);
+    } else {
+        h = seed + PRIME64_5;
+    }
+    h += (uint64_t)len;
+
+    while (p + 8 <= end) {
+        h ^= Round(0, Read64(p));
+        h  = Rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)Read32(p) * PRIME64_1;
+        h  = Rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (uint64_t)(*p) * PRIME64_5;
+        h  = Rotl64(h, 11) * PRIME64_1;
+        ++p;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
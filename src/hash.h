@@ -0,0 +1,14 @@
+// hash.h — 64-bit non-cryptographic content hash (XXH64)
+#ifndef SHADERDEVEL_HASH_H
+#define SHADERDEVEL_HASH_H
+
+#include "platform.h"
+
+// Bit-compatible with xxHash's XXH64, so values can be checked against the reference tool.
+uint64_t Hash64(const void* data, size_t len, uint64_t seed);
+static inline uint64_t Hash64String(const char* s, uint64_t seed) {
+    size_t n = 0; while (s[n]) ++n;
+    return Hash64(s, n, seed);
+}
+
+#endif // SHADERDEVEL_HASH_H
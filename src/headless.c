@@ -0,0 +1,56 @@
+// headless.c — see headless.h
+#include "headless.h"
+#include "app.h"
+#include "render_target.h"
+#include "profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool RunHeadlessBenchmark(const HeadlessOptions* opt, FrameStats* out, char* log, int logsz) {
+    memset(out, 0, sizeof(*out));
+    RenderTarget rt;
+    if (!CreateRenderTarget(&rt, opt->width, opt->height, GL_RGBA8)) {
+        snprintf(log, logsz, "Could not create a %dx%d offscreen framebuffer.", opt->width, opt->height);
+        return false;
+    }
+    g_app.width  = opt->width;
+    g_app.height = opt->height;
+
+    double* samples = (double*)malloc((size_t)(opt->frames > 0 ? opt->frames : 1) * sizeof(double));
+    g_app.start_seconds = NowSeconds();
+    for (int i = -opt->warmup_frames; i < opt->frames; ++i) {
+        if (i == 0 && g_app.gpu_timer) GpuTimerReset(g_app.gpu_timer); // drop warmup frames
+        double t0 = NowSeconds();
+        if (g_app.pacer) {
+            if (i == 0) FramePacerResetStats(g_app.pacer);
+            PROFILE_BEGIN("FramePacerBeginFrame");
+            FramePacerBeginFrame(g_app.pacer, 0.0);
+            PROFILE_END();
+        }
+        PROFILE_BEGIN("RenderFrame");
+        RenderFrame((float)(NowSeconds() - g_app.start_seconds), rt.fbo);
+        PROFILE_END();
+        if (g_app.pacer) {
+            FramePacerDrawn(g_app.pacer);
+            FramePacerEndFrame(g_app.pacer);
+        } else {
+            // No swap to pace us: block until the frame is actually done so the
+            // sample is the real cost, not the cost of queueing commands.
+            PROFILE_BEGIN("glFinish");
+            glFinish();
+            PROFILE_END();
+        }
+        double t1 = NowSeconds();
+        if (i >= 0) samples[i] = (t1 - t0) * 1000.0;
+        TelemetryFrame(g_app.telemetry_thread, (t1 - t0) * 1000.0);
+    }
+
+    if (g_app.pacer) FramePacerFinish(g_app.pacer);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    DestroyRenderTarget(&rt);
+    ComputeFrameStats(samples, opt->frames, out);
+    free(samples);
+    return true;
+}
@@ -0,0 +1,20 @@
+// headless.h — offscreen render loop + frame time statistics
+#ifndef SHADERDEVEL_HEADLESS_H
+#define SHADERDEVEL_HEADLESS_H
+
+#include "platform.h"
+#include "frame_stats.h"
+
+typedef struct {
+    int width, height;
+    int frames;        // timed frames
+    int warmup_frames; // rendered first and discarded (driver JIT, caches)
+} HeadlessOptions;
+
+// Renders g_app's program into an FBO opt->frames times and fills *out.
+// Needs a current context with g_app.program and g_app.vao already set up. Each frame
+// is waited for with glFinish, or with g_app.pacer set, only as far as its bound on
+// frames in flight says; a sample is then the loop's time per frame, wait included.
+bool RunHeadlessBenchmark(const HeadlessOptions* opt, FrameStats* out, char* log, int logsz);
+
+#endif // SHADERDEVEL_HEADLESS_H
@@ -0,0 +1,87 @@
+// headless_context.c — see headless_context.h
+#include "headless_context.h"
+
+#include <glad/gl.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <stdio.h>
+
+static EGLDisplay g_egl_display = EGL_NO_DISPLAY;
+static EGLContext g_egl_context = EGL_NO_CONTEXT;
+static EGLContext g_egl_worker  = EGL_NO_CONTEXT;
+
+static const EGLint g_ctx_attribs[] = {
+    EGL_CONTEXT_MAJOR_VERSION,       3,
+    EGL_CONTEXT_MINOR_VERSION,       3,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_NONE
+};
+
+static GLADapiproc LoadGLProc(const char* name) {
+    return (GLADapiproc)eglGetProcAddress(name);
+}
+
+static EGLDisplay OpenSurfacelessDisplay(void) {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    EGLDisplay dpy = EGL_NO_DISPLAY;
+    if (getPlatformDisplay) dpy = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    if (dpy == EGL_NO_DISPLAY) dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    return dpy;
+}
+
+bool CreateHeadlessContext(char* log, int logsz) {
+    log[0] = 0;
+    g_egl_display = OpenSurfacelessDisplay();
+    EGLint major = 0, minor = 0;
+    if (g_egl_display == EGL_NO_DISPLAY || !eglInitialize(g_egl_display, &major, &minor)) {
+        snprintf(log, logsz, "Could not initialize an EGL display (0x%04x).", eglGetError());
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        snprintf(log, logsz, "EGL display has no desktop OpenGL support.");
+        DestroyHeadlessContext();
+        return false;
+    }
+
+    // Configless + surfaceless: the context never gets a default framebuffer.
+    g_egl_context = eglCreateContext(g_egl_display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, g_ctx_attribs);
+    if (g_egl_context == EGL_NO_CONTEXT) {
+        snprintf(log, logsz, "Could not create a GL 3.3 core context (0x%04x).", eglGetError());
+        DestroyHeadlessContext();
+        return false;
+    }
+    if (!eglMakeCurrent(g_egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, g_egl_context)) {
+        snprintf(log, logsz, "eglMakeCurrent failed (0x%04x).", eglGetError());
+        DestroyHeadlessContext();
+        return false;
+    }
+    if (!gladLoadGL(LoadGLProc)) {
+        snprintf(log, logsz, "Some required modern OpenGL functions are missing.");
+        DestroyHeadlessContext();
+        return false;
+    }
+    return true;
+}
+
+bool CreateHeadlessWorkerContext(void) {
+    if (g_egl_context == EGL_NO_CONTEXT) return false;
+    g_egl_worker = eglCreateContext(g_egl_display, EGL_NO_CONFIG_KHR, g_egl_context, g_ctx_attribs);
+    return g_egl_worker != EGL_NO_CONTEXT;
+}
+
+bool BindHeadlessWorkerContext(void* user, bool bind) {
+    (void)user;
+    if (!bind) return eglMakeCurrent(g_egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT) == EGL_TRUE;
+    // EGL binds the API per thread.
+    return eglBindAPI(EGL_OPENGL_API) && eglMakeCurrent(g_egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, g_egl_worker) == EGL_TRUE;
+}
+
+void DestroyHeadlessContext(void) {
+    if (g_egl_display == EGL_NO_DISPLAY) return;
+    eglMakeCurrent(g_egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (g_egl_worker != EGL_NO_CONTEXT) { eglDestroyContext(g_egl_display, g_egl_worker); g_egl_worker = EGL_NO_CONTEXT; }
+    if (g_egl_context != EGL_NO_CONTEXT) { eglDestroyContext(g_egl_display, g_egl_context); g_egl_context = EGL_NO_CONTEXT; }
+    eglTerminate(g_egl_display);
+    g_egl_display = EGL_NO_DISPLAY;
+}
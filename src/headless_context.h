@@ -0,0 +1,18 @@
+// headless_context.h — surfaceless GL context (EGL, Mesa llvmpipe is fine) for GPU-less boxes
+#ifndef SHADERDEVEL_HEADLESS_CONTEXT_H
+#define SHADERDEVEL_HEADLESS_CONTEXT_H
+
+#include "platform.h"
+
+// Creates a core-profile context with no window surface, makes it current on the
+// calling thread and loads GL entry points. Rendering must go to an FBO.
+bool CreateHeadlessContext(char* log, int logsz);
+void DestroyHeadlessContext(void);
+
+// Optional second context sharing objects with the first, for ShaderCompiler's
+// worker thread. Create on the main thread; bind/unbind from the worker
+// (matches ContextBindFn).
+bool CreateHeadlessWorkerContext(void);
+bool BindHeadlessWorkerContext(void* user, bool bind);
+
+#endif // SHADERDEVEL_HEADLESS_CONTEXT_H
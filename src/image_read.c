@@ -0,0 +1,498 @@
+// image_read.c — see image_read.h
+#include "image_read.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t Get32(const uint8_t* p) {
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static bool CheckSize(int w, int h, char* log, int logsz) {
+    if (w > 0 && h > 0 && w <= IMAGE_MAX_DIMENSION && h <= IMAGE_MAX_DIMENSION) return true;
+    snprintf(log, (size_t)logsz, "unsupported size %dx%d (at most %d either way)", w, h, IMAGE_MAX_DIMENSION);
+    return false;
+}
+
+// Destination of the image's row y.
+static uint8_t* DstRow(uint8_t* rgba, const ImageInfo* info, int y, bool bottom_up) {
+    return rgba + (size_t)(bottom_up ? info->height - 1 - y : y) * (size_t)info->width * 4;
+}
+
+// ============================ Inflate ==============================
+// RFC 1951 with a 9-bit first-level table; codes longer than that take the slow path.
+#define FAST_BITS 9
+
+typedef struct {
+    uint16_t fast[1 << FAST_BITS]; // (length << 9) | symbol, 0 when longer than FAST_BITS
+    uint16_t first_code[16];
+    uint16_t first_symbol[16];
+    int      max_code[17];         // exclusive, pre-shifted to 16 bits
+    uint8_t  size[288];
+    uint16_t value[288];
+} Huffman;
+
+typedef struct {
+    const uint8_t* p;
+    const uint8_t* end;
+    uint32_t       bits;
+    int            count;
+    int            overrun; // bytes of zero padding read past the end
+} BitReader;
+
+static void Fill(BitReader* b) {
+    while (b->count <= 24) {
+        uint32_t byte = 0;
+        if (b->p < b->end) byte = *b->p++;
+        else ++b->overrun;
+        b->bits |= byte << b->count;
+        b->count += 8;
+    }
+}
+
+static uint32_t Bits(BitReader* b, int n) {
+    if (b->count < n) Fill(b);
+    uint32_t v = b->bits & ((1u << n) - 1);
+    b->bits >>= n;
+    b->count -= n;
+    return v;
+}
+
+static int Reverse(int v, int bits) {
+    int r = 0;
+    for (int i = 0; i < bits; ++i) { r = (r << 1) | (v & 1); v >>= 1; }
+    return r;
+}
+
+static bool BuildHuffman(Huffman* h, const uint8_t* lengths, int n) {
+    int sizes[17] = { 0 }, next[16];
+    memset(h->fast, 0, sizeof(h->fast));
+    for (int i = 0; i < n; ++i) ++sizes[lengths[i]];
+    sizes[0] = 0;
+    int code = 0, k = 0;
+    for (int i = 1; i < 16; ++i) {
+        next[i] = code;
+        h->first_code[i] = (uint16_t)code;
+        h->first_symbol[i] = (uint16_t)k;
+        code += sizes[i];
+        if (sizes[i] && code - 1 >= (1 << i)) return false; // over-subscribed
+        h->max_code[i] = code << (16 - i);
+        code <<= 1;
+        k += sizes[i];
+    }
+    h->max_code[16] = 0x10000;
+    for (int i = 0; i < n; ++i) {
+        int s = lengths[i];
+        if (!s) continue;
+        int c = next[s] - h->first_code[s] + h->first_symbol[s];
+        h->size[c] = (uint8_t)s;
+        h->value[c] = (uint16_t)i;
+        if (s <= FAST_BITS)
+            for (int j = Reverse(next[s], s); j < (1 << FAST_BITS); j += 1 << s) h->fast[j] = (uint16_t)(s << 9 | i);
+        ++next[s];
+    }
+    return true;
+}
+
+static int DecodeSymbol(BitReader* b, const Huffman* h) {
+    if (b->count < 16) Fill(b);
+    int f = h->fast[b->bits & ((1 << FAST_BITS) - 1)];
+    if (f) {
+        b->bits >>= f >> 9;
+        b->count -= f >> 9;
+        return f & 511;
+    }
+    int k = Reverse((int)(b->bits & 0xFFFF), 16), s;
+    for (s = FAST_BITS + 1; s < 16 && k >= h->max_code[s]; ++s) {}
+    if (s >= 16) return -1;
+    int c = (k >> (16 - s)) - h->first_code[s] + h->first_symbol[s];
+    if (c < 0 || c >= 288 || h->size[c] != s) return -1;
+    b->bits >>= s;
+    b->count -= s;
+    return h->value[c];
+}
+
+static const uint16_t s_length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t  s_length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                             3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t s_dist_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                          257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                          8193, 12289, 16385, 24577 };
+static const uint8_t  s_dist_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                           7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static bool DynamicTables(BitReader* b, Huffman* lit, Huffman* dist) {
+    static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+    int hlit = (int)Bits(b, 5) + 257, hdist = (int)Bits(b, 5) + 1, hclen = (int)Bits(b, 4) + 4;
+    uint8_t cl[19] = { 0 }, lengths[286 + 32];
+    for (int i = 0; i < hclen; ++i) cl[order[i]] = (uint8_t)Bits(b, 3);
+    Huffman h;
+    if (!BuildHuffman(&h, cl, 19)) return false;
+    int n = 0;
+    while (n < hlit + hdist) {
+        int sym = DecodeSymbol(b, &h), rep = 0;
+        uint8_t fill = 0;
+        if (sym < 0 || sym > 18) return false;
+        if (sym < 16) { lengths[n++] = (uint8_t)sym; continue; }
+        if (sym == 16) { if (n == 0) return false; fill = lengths[n - 1]; rep = 3 + (int)Bits(b, 2); }
+        else if (sym == 17) rep = 3 + (int)Bits(b, 3);
+        else rep = 11 + (int)Bits(b, 7);
+        if (n + rep > hlit + hdist) return false;
+        memset(lengths + n, fill, (size_t)rep);
+        n += rep;
+    }
+    return BuildHuffman(lit, lengths, hlit) && BuildHuffman(dist, lengths + hlit, hdist);
+}
+
+// A zlib stream into exactly out_size bytes.
+static bool Inflate(const uint8_t* src, size_t size, uint8_t* out, size_t out_size, char* log, int logsz) {
+    if (size < 2 || (src[0] & 0x0F) != 8 || ((src[0] << 8) | src[1]) % 31 || (src[1] & 0x20)) {
+        snprintf(log, (size_t)logsz, "bad zlib header");
+        return false;
+    }
+    BitReader b = { src + 2, src + size, 0, 0, 0 };
+    Huffman* lit = (Huffman*)malloc(2 * sizeof(Huffman));
+    if (!lit) { snprintf(log, (size_t)logsz, "out of memory"); return false; }
+    Huffman* dist = lit + 1;
+    size_t o = 0;
+    bool last = false, ok = true;
+    while (ok && !last) {
+        last = Bits(&b, 1) != 0;
+        int type = (int)Bits(&b, 2);
+        if (type == 0) {
+            Bits(&b, b.count & 7);
+            uint32_t len = Bits(&b, 16), nlen = Bits(&b, 16);
+            if ((len ^ 0xFFFF) != nlen || len > out_size - o) { ok = false; break; }
+            while (len && b.count > 0) { out[o++] = (uint8_t)Bits(&b, 8); --len; }
+            if (len > (size_t)(b.end - b.p)) { ok = false; break; }
+            memcpy(out + o, b.p, len);
+            b.p += len;
+            o += len;
+            continue;
+        }
+        if (type == 1) {
+            uint8_t lengths[288 + 32];
+            memset(lengths, 8, 144);
+            memset(lengths + 144, 9, 112);
+            memset(lengths + 256, 7, 24);
+            memset(lengths + 280, 8, 8);
+            memset(lengths + 288, 5, 32);
+            ok = BuildHuffman(lit, lengths, 288) && BuildHuffman(dist, lengths + 288, 32);
+        } else if (type == 2) {
+            ok = DynamicTables(&b, lit, dist);
+        } else {
+            ok = false;
+        }
+        while (ok) {
+            int sym = DecodeSymbol(&b, lit);
+            if (sym < 256) {
+                if (sym < 0 || o == out_size) { ok = false; break; }
+                out[o++] = (uint8_t)sym;
+                continue;
+            }
+            if (sym == 256) break;
+            sym -= 257;
+            if (sym >= 29) { ok = false; break; }
+            size_t len = s_length_base[sym] + Bits(&b, s_length_extra[sym]);
+            int d = DecodeSymbol(&b, dist);
+            if (d < 0 || d >= 30) { ok = false; break; }
+            size_t back = s_dist_base[d] + Bits(&b, s_dist_extra[d]);
+            if (back > o || len > out_size - o) { ok = false; break; }
+            const uint8_t* from = out + o - back;
+            if (back >= len) memcpy(out + o, from, len);
+            else for (size_t i = 0; i < len; ++i) out[o + i] = from[i]; // overlapping run
+            o += len;
+        }
+        if (b.overrun > 4) ok = false;
+    }
+    free(lit);
+    if (!ok || o != out_size) {
+        snprintf(log, (size_t)logsz, ok ? "image data is %zu bytes short" : "corrupt deflate stream", out_size - o);
+        return false;
+    }
+    return true;
+}
+
+// ============================== PNG ================================
+typedef struct {
+    int      width, height, depth, color, interlace;
+    int      channels;
+    uint8_t  palette[256][4];
+    bool     has_key;      // tRNS on a gray or RGB image: this exact value is transparent
+    uint16_t key[3];
+    size_t   idat_bytes;
+} Png;
+
+static const uint8_t s_png_sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+static bool ParsePng(const uint8_t* d, size_t size, Png* png, char* log, int logsz) {
+    memset(png, 0, sizeof(*png));
+    for (int i = 0; i < 256; ++i) png->palette[i][3] = 255;
+    size_t pos = 8;
+    bool header = false;
+    while (pos + 12 <= size) {
+        uint32_t len = Get32(d + pos);
+        const uint8_t* type = d + pos + 4;
+        const uint8_t* body = d + pos + 8;
+        if (len > size - pos - 12) { snprintf(log, (size_t)logsz, "truncated PNG chunk"); return false; }
+        if (!memcmp(type, "IHDR", 4) && len >= 13) {
+            png->width = (int)Get32(body);
+            png->height = (int)Get32(body + 4);
+            png->depth = body[8];
+            png->color = body[9];
+            png->interlace = body[12];
+            static const int channels[7] = { 1, 0, 3, 1, 2, 0, 4 };
+            png->channels = png->color <= 6 ? channels[png->color] : 0;
+            bool depth_ok = png->depth == 8 || png->depth == 16 ||
+                            ((png->color == 0 || png->color == 3) && (png->depth == 1 || png->depth == 2 || png->depth == 4));
+            if (!png->channels || !depth_ok || (png->color == 3 && png->depth == 16) || body[10] || body[11] || png->interlace > 1) {
+                snprintf(log, (size_t)logsz, "unsupported PNG (color type %d, depth %d)", png->color, png->depth);
+                return false;
+            }
+            if (!CheckSize(png->width, png->height, log, logsz)) return false;
+            header = true;
+        } else if (!memcmp(type, "PLTE", 4)) {
+            for (uint32_t i = 0; i < len / 3 && i < 256; ++i) memcpy(png->palette[i], body + i * 3, 3);
+        } else if (!memcmp(type, "tRNS", 4)) {
+            if (png->color == 3) {
+                for (uint32_t i = 0; i < len && i < 256; ++i) png->palette[i][3] = body[i];
+            } else if (png->color == 0 && len >= 2) {
+                png->has_key = true;
+                png->key[0] = (uint16_t)(body[0] << 8 | body[1]);
+            } else if (png->color == 2 && len >= 6) {
+                png->has_key = true;
+                for (int c = 0; c < 3; ++c) png->key[c] = (uint16_t)(body[c * 2] << 8 | body[c * 2 + 1]);
+            }
+        } else if (!memcmp(type, "IDAT", 4)) {
+            png->idat_bytes += len;
+        } else if (!memcmp(type, "IEND", 4)) {
+            break;
+        }
+        pos += 12 + (size_t)len;
+    }
+    if (!header) { snprintf(log, (size_t)logsz, "PNG without IHDR"); return false; }
+    if (!png->idat_bytes) { snprintf(log, (size_t)logsz, "PNG without image data"); return false; }
+    return true;
+}
+
+static size_t RowBytes(const Png* png, int width) {
+    return ((size_t)width * (size_t)png->channels * (size_t)png->depth + 7) / 8;
+}
+
+static uint8_t Paeth(int a, int b, int c) {
+    int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    return (uint8_t)(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+}
+
+// Undoes the filter of each row of a (sub)image in place.
+static bool Unfilter(const Png* png, uint8_t* raw, int width, int height) {
+    size_t stride = RowBytes(png, width);
+    size_t bpp = ((size_t)png->channels * (size_t)png->depth + 7) / 8;
+    uint8_t* prev = NULL;
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = raw + (size_t)y * (stride + 1);
+        int filter = row[0];
+        uint8_t* p = row + 1;
+        for (size_t i = 0; i < stride; ++i) {
+            int a = i >= bpp ? p[i - bpp] : 0, b = prev ? prev[i] : 0, c = prev && i >= bpp ? prev[i - bpp] : 0;
+            switch (filter) {
+            case 0: break;
+            case 1: p[i] = (uint8_t)(p[i] + a); break;
+            case 2: p[i] = (uint8_t)(p[i] + b); break;
+            case 3: p[i] = (uint8_t)(p[i] + ((a + b) >> 1)); break;
+            case 4: p[i] = (uint8_t)(p[i] + Paeth(a, b, c)); break;
+            default: return false;
+            }
+        }
+        prev = p;
+    }
+    return true;
+}
+
+// One unfiltered row of count pixels to RGBA.
+static void ExpandRow(const Png* png, const uint8_t* p, int count, uint8_t* out) {
+    int depth = png->depth;
+    if (depth == 8 && png->color == 6) { memcpy(out, p, (size_t)count * 4); return; }
+    for (int i = 0; i < count; ++i, out += 4) {
+        uint16_t s[4]; // samples at full precision, for the tRNS key
+        for (int c = 0; c < png->channels; ++c) {
+            size_t k = (size_t)i * (size_t)png->channels + (size_t)c;
+            if (depth == 16) s[c] = (uint16_t)(p[k * 2] << 8 | p[k * 2 + 1]);
+            else if (depth == 8) s[c] = p[k];
+            else s[c] = (uint16_t)((p[k * (size_t)depth / 8] >> (8 - depth - (int)(k * (size_t)depth % 8))) & ((1 << depth) - 1));
+        }
+        int shift = depth == 16 ? 8 : 0;
+        switch (png->color) {
+        case 0: {
+            uint8_t g = depth < 8 ? (uint8_t)(s[0] * 255 / ((1 << depth) - 1)) : (uint8_t)(s[0] >> shift);
+            out[0] = out[1] = out[2] = g;
+            out[3] = png->has_key && s[0] == png->key[0] ? 0 : 255;
+            break;
+        }
+        case 2:
+            for (int c = 0; c < 3; ++c) out[c] = (uint8_t)(s[c] >> shift);
+            out[3] = png->has_key && s[0] == png->key[0] && s[1] == png->key[1] && s[2] == png->key[2] ? 0 : 255;
+            break;
+        case 3:
+            memcpy(out, png->palette[s[0]], 4);
+            break;
+        case 4:
+            out[0] = out[1] = out[2] = (uint8_t)(s[0] >> shift);
+            out[3] = (uint8_t)(s[1] >> shift);
+            break;
+        default:
+            for (int c = 0; c < 4; ++c) out[c] = (uint8_t)(s[c] >> shift);
+            break;
+        }
+    }
+}
+
+static bool DecodePng(const uint8_t* d, size_t size, const ImageInfo* info, uint8_t* rgba, bool bottom_up, char* log, int logsz) {
+    Png png;
+    if (!ParsePng(d, size, &png, log, logsz)) return false;
+    static const int adam7[7][4] = { { 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 },
+                                     { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 } }; // x0, y0, dx, dy
+    static const int whole[1][4] = { { 0, 0, 1, 1 } };
+    const int (*passes)[4] = png.interlace ? adam7 : whole;
+    int npass = png.interlace ? 7 : 1;
+    size_t raw_size = 0;
+    for (int i = 0; i < npass; ++i) {
+        int pw = (png.width - passes[i][0] + passes[i][2] - 1) / passes[i][2];
+        int ph = (png.height - passes[i][1] + passes[i][3] - 1) / passes[i][3];
+        if (pw > 0 && ph > 0) raw_size += (RowBytes(&png, pw) + 1) * (size_t)ph;
+    }
+
+    uint8_t* idat = (uint8_t*)malloc(png.idat_bytes);
+    uint8_t* raw = (uint8_t*)malloc(raw_size);
+    uint8_t* row = (uint8_t*)malloc((size_t)png.width * 4);
+    bool ok = idat && raw && row;
+    if (!ok) snprintf(log, (size_t)logsz, "out of memory");
+    size_t n = 0;
+    for (size_t pos = 8; ok && pos + 12 <= size;) { // ParsePng checked the chunk lengths
+        uint32_t len = Get32(d + pos);
+        if (!memcmp(d + pos + 4, "IDAT", 4)) { memcpy(idat + n, d + pos + 8, len); n += len; }
+        if (!memcmp(d + pos + 4, "IEND", 4)) break;
+        pos += 12 + (size_t)len;
+    }
+    ok = ok && Inflate(idat, n, raw, raw_size, log, logsz);
+    uint8_t* p = raw;
+    for (int i = 0; ok && i < npass; ++i) {
+        int x0 = passes[i][0], y0 = passes[i][1], dx = passes[i][2], dy = passes[i][3];
+        int pw = (png.width - x0 + dx - 1) / dx, ph = (png.height - y0 + dy - 1) / dy;
+        if (pw <= 0 || ph <= 0) continue;
+        size_t stride = RowBytes(&png, pw) + 1;
+        if (!Unfilter(&png, p, pw, ph)) { snprintf(log, (size_t)logsz, "bad PNG row filter"); ok = false; break; }
+        for (int y = 0; y < ph; ++y) {
+            uint8_t* dst = DstRow(rgba, info, y0 + y * dy, bottom_up);
+            if (dx == 1) { ExpandRow(&png, p + (size_t)y * stride + 1, pw, dst); continue; }
+            ExpandRow(&png, p + (size_t)y * stride + 1, pw, row);
+            for (int x = 0; x < pw; ++x) memcpy(dst + (size_t)(x0 + x * dx) * 4, row + (size_t)x * 4, 4);
+        }
+        p += stride * (size_t)ph;
+    }
+    free(idat);
+    free(raw);
+    free(row);
+    return ok;
+}
+
+// ============================== PNM ================================
+typedef struct {
+    int    width, height, maxval, channels;
+    size_t offset; // of the pixels
+} Pnm;
+
+static bool ParsePnm(const uint8_t* d, size_t size, Pnm* pnm, char* log, int logsz) {
+    pnm->channels = d[1] == '5' ? 1 : 3;
+    int v[3];
+    size_t pos = 2;
+    for (int i = 0; i < 3; ++i) {
+        for (;;) { // whitespace and comments
+            while (pos < size && (d[pos] == ' ' || d[pos] == '\t' || d[pos] == '\r' || d[pos] == '\n')) ++pos;
+            if (pos < size && d[pos] == '#') { while (pos < size && d[pos] != '\n') ++pos; continue; }
+            break;
+        }
+        if (pos >= size || d[pos] < '0' || d[pos] > '9') { snprintf(log, (size_t)logsz, "bad PNM header"); return false; }
+        long n = 0;
+        while (pos < size && d[pos] >= '0' && d[pos] <= '9' && n < 1000000) n = n * 10 + (d[pos++] - '0');
+        v[i] = (int)n;
+    }
+    ++pos; // the single whitespace before the pixels
+    pnm->width = v[0]; pnm->height = v[1]; pnm->maxval = v[2];
+    pnm->offset = pos;
+    if (!CheckSize(pnm->width, pnm->height, log, logsz)) return false;
+    if (pnm->maxval < 1 || pnm->maxval > 65535) { snprintf(log, (size_t)logsz, "bad PNM maxval %d", pnm->maxval); return false; }
+    size_t need = (size_t)pnm->width * (size_t)pnm->height * (size_t)pnm->channels * (pnm->maxval > 255 ? 2 : 1);
+    if (pos > size || size - pos < need) { snprintf(log, (size_t)logsz, "truncated PNM"); return false; }
+    return true;
+}
+
+static bool DecodePnm(const uint8_t* d, size_t size, const ImageInfo* info, uint8_t* rgba, bool bottom_up, char* log, int logsz) {
+    Pnm pnm;
+    if (!ParsePnm(d, size, &pnm, log, logsz)) return false;
+    const uint8_t* p = d + pnm.offset;
+    bool wide = pnm.maxval > 255;
+    for (int y = 0; y < pnm.height; ++y) {
+        uint8_t* dst = DstRow(rgba, info, y, bottom_up);
+        for (int x = 0; x < pnm.width; ++x, dst += 4) {
+            for (int c = 0; c < pnm.channels; ++c, p += wide ? 2 : 1) {
+                int s = wide ? (p[0] << 8 | p[1]) : p[0];
+                dst[c] = (uint8_t)(pnm.maxval == 255 ? s : s * 255 / pnm.maxval);
+            }
+            if (pnm.channels == 1) dst[1] = dst[2] = dst[0];
+            dst[3] = 255;
+        }
+    }
+    return true;
+}
+
+// ============================== API ================================
+static bool IsPnm(const uint8_t* d, size_t size) { return size >= 3 && d[0] == 'P' && (d[1] == '5' || d[1] == '6'); }
+static bool IsPng(const uint8_t* d, size_t size) { return size >= 8 && !memcmp(d, s_png_sig, 8); }
+
+bool ReadImageInfo(const void* data, size_t size, ImageInfo* out, char* log, int logsz) {
+    const uint8_t* d = (const uint8_t*)data;
+    if (IsPng(d, size)) {
+        Png png;
+        if (!ParsePng(d, size, &png, log, logsz)) return false;
+        out->width = png.width;
+        out->height = png.height;
+        return true;
+    }
+    if (IsPnm(d, size)) {
+        Pnm pnm;
+        if (!ParsePnm(d, size, &pnm, log, logsz)) return false;
+        out->width = pnm.width;
+        out->height = pnm.height;
+        return true;
+    }
+    snprintf(log, (size_t)logsz, "not a PNG or binary PGM/PPM image");
+    return false;
+}
+
+bool DecodeImage(const void* data, size_t size, const ImageInfo* info, uint8_t* rgba, bool bottom_up, char* log, int logsz) {
+    const uint8_t* d = (const uint8_t*)data;
+    if (IsPng(d, size)) return DecodePng(d, size, info, rgba, bottom_up, log, logsz);
+    if (IsPnm(d, size)) return DecodePnm(d, size, info, rgba, bottom_up, log, logsz);
+    snprintf(log, (size_t)logsz, "not a PNG or binary PGM/PPM image");
+    return false;
+}
+
+// =========================== Comparison ============================
+void CompareImages(const uint8_t* a, const uint8_t* b, size_t pixels, double* psnr, int* max_diff) {
+    double sum = 0.0;
+    int worst = 0;
+    for (size_t i = 0; i < pixels * 4; ++i) {
+        if ((i & 3) == 3) continue;
+        int d = (int)a[i] - (int)b[i];
+        if (d < 0) d = -d;
+        if (d > worst) worst = d;
+        sum += (double)(d * d);
+    }
+    double mse = sum / (double)(pixels * 3);
+    *psnr = mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : INFINITY;
+    *max_diff = worst;
+}
@@ -0,0 +1,31 @@
+// image_read.h — PNG and binary PGM/PPM images decoded to 8-bit RGBA
+//
+// Decoding is split in two so the caller can size the destination (a mapped pixel
+// buffer, say) from the header before any pixel is produced. PNG: every color type
+// and bit depth, palettes with tRNS, Adam7; 16-bit channels keep their high byte.
+// PGM/PPM: P5/P6 with maxval up to 65535. Gray fills RGB; missing alpha is 255.
+// CompareImages scores one decoded frame against another (variant tuning, --cpu
+// --reference). Nothing here touches files or GL, so it runs on any thread.
+
+#ifndef SHADERDEVEL_IMAGE_READ_H
+#define SHADERDEVEL_IMAGE_READ_H
+
+#include "platform.h"
+
+#define IMAGE_MAX_DIMENSION 16384
+
+typedef struct {
+    int width, height;
+} ImageInfo;
+
+// Parses the header of an image in memory. False with a reason in log if it is not
+// a supported image or is larger than IMAGE_MAX_DIMENSION either way.
+bool ReadImageInfo(const void* data, size_t size, ImageInfo* out, char* log, int logsz);
+// Decodes into rgba (width * height * 4 bytes), top row first unless bottom_up
+// (GL's order: the first row is the bottom of the image).
+bool DecodeImage(const void* data, size_t size, const ImageInfo* info, uint8_t* rgba, bool bottom_up, char* log, int logsz);
+// PSNR over RGB in dB (INFINITY when identical) and the largest channel difference;
+// alpha is left out since most shaders write 1.
+void CompareImages(const uint8_t* a, const uint8_t* b, size_t pixels, double* psnr, int* max_diff);
+
+#endif // SHADERDEVEL_IMAGE_READ_H
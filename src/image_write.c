@@ -0,0 +1,141 @@
+// image_write.c — see image_write.h
+#include "image_write.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const uint8_t* SourceRow(const uint8_t* rgba, int width, int height, int y, bool top_down) {
+    return rgba + (size_t)(top_down ? y : height - 1 - y) * (size_t)width * 4;
+}
+
+bool WritePPM(const char* path, int width, int height, const uint8_t* rgba, bool top_down) {
+    char header[64];
+    int hlen = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height);
+    size_t size = (size_t)hlen + (size_t)width * (size_t)height * 3;
+    uint8_t* buf = (uint8_t*)malloc(size);
+    if (!buf) return false;
+    memcpy(buf, header, (size_t)hlen);
+    uint8_t* d = buf + hlen;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* s = SourceRow(rgba, width, height, y, top_down);
+        for (int x = 0; x < width; ++x, s += 4, d += 3) { d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; }
+    }
+    bool ok = WriteFileAtomic(path, buf, size);
+    free(buf);
+    return ok;
+}
+
+bool WritePPMRows(const char* path, int width, int height, int y0, int rows, const uint8_t* rgba) {
+    char header[64];
+    int hlen = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height);
+    size_t size = (size_t)width * (size_t)rows * 3;
+    uint8_t* buf = (uint8_t*)malloc(size);
+    if (!buf) return false;
+    // The band's top row comes first in the file.
+    uint8_t* d = buf;
+    for (int y = rows - 1; y >= 0; --y) {
+        const uint8_t* s = rgba + (size_t)y * (size_t)width * 4;
+        for (int x = 0; x < width; ++x, s += 4, d += 3) { d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; }
+    }
+    FILE* f = fopen(path, "r+b");
+    if (!f && (f = fopen(path, "ab")) != NULL) { fclose(f); f = fopen(path, "r+b"); }
+    bool ok = f != NULL;
+    int64_t offset = (int64_t)hlen + (int64_t)(height - y0 - rows) * width * 3;
+#ifdef _WIN32
+    ok = ok && fwrite(header, 1, (size_t)hlen, f) == (size_t)hlen && _fseeki64(f, offset, SEEK_SET) == 0;
+#else
+    ok = ok && fwrite(header, 1, (size_t)hlen, f) == (size_t)hlen && fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+    ok = ok && fwrite(buf, 1, size, f) == size;
+    if (f && fclose(f) != 0) ok = false;
+    free(buf);
+    return ok;
+}
+
+// ============================== PNG ================================
+static uint32_t s_crc_table[256];
+
+static uint32_t Crc32(uint32_t crc, const uint8_t* p, size_t n) {
+    if (!s_crc_table[1]) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            s_crc_table[i] = c;
+        }
+    }
+    crc = ~crc;
+    while (n--) crc = s_crc_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static uint8_t* Put32(uint8_t* d, uint32_t v) {
+    d[0] = (uint8_t)(v >> 24); d[1] = (uint8_t)(v >> 16); d[2] = (uint8_t)(v >> 8); d[3] = (uint8_t)v;
+    return d + 4;
+}
+
+// Length, type, data (already in place after the type), CRC over type + data.
+static uint8_t* FinishChunk(uint8_t* chunk, uint32_t len) {
+    Put32(chunk, len);
+    return Put32(chunk + 8 + len, Crc32(0, chunk + 4, 4 + (size_t)len));
+}
+
+bool WritePNG(const char* path, int width, int height, const uint8_t* rgba, bool top_down) {
+    const size_t row = (size_t)width * 4 + 1; // filter byte + pixels
+    const size_t raw = row * (size_t)height;
+    const size_t blocks = raw / 65535 + 1;
+    const size_t zlen = 2 + raw + blocks * 5 + 4;
+    const size_t size = 8 + (12 + 13) + (12 + zlen) + 12;
+    uint8_t* buf = (uint8_t*)malloc(size);
+    if (!buf) return false;
+
+    static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    memcpy(buf, sig, 8);
+    uint8_t* d = buf + 8;
+
+    uint8_t* ihdr = d;
+    memcpy(ihdr + 4, "IHDR", 4);
+    uint8_t* p = Put32(ihdr + 8, (uint32_t)width);
+    p = Put32(p, (uint32_t)height);
+    p[0] = 8; p[1] = 6; p[2] = 0; p[3] = 0; p[4] = 0; // 8-bit RGBA, deflate, no filter, no interlace
+    d = FinishChunk(ihdr, 13);
+
+    // zlib stream of stored blocks; the Adler-32 covers the uncompressed bytes.
+    uint8_t* idat = d;
+    memcpy(idat + 4, "IDAT", 4);
+    p = idat + 8;
+    *p++ = 0x78; *p++ = 0x01;
+    uint32_t s1 = 1, s2 = 0;
+    size_t left = raw, x = 0;
+    int y = 0;
+    do {
+        uint16_t n = (uint16_t)(left < 65535 ? left : 65535);
+        left -= n;
+        *p++ = left ? 0 : 1; // BFINAL, BTYPE 00
+        p[0] = (uint8_t)n; p[1] = (uint8_t)(n >> 8); p[2] = (uint8_t)~n; p[3] = (uint8_t)(~n >> 8);
+        p += 4;
+        for (uint16_t i = 0; i < n; ++i) {
+            // x walks the current scanline: 0 is its filter byte.
+            uint8_t b = x == 0 ? 0 : SourceRow(rgba, width, height, y, top_down)[x - 1];
+            if (++x == row) { x = 0; ++y; }
+            *p++ = b;
+            s1 += b; if (s1 >= 65521) s1 -= 65521;
+            s2 += s1; if (s2 >= 65521) s2 -= 65521;
+        }
+    } while (left);
+    p = Put32(p, (s2 << 16) | s1);
+    d = FinishChunk(idat, (uint32_t)(p - (idat + 8)));
+
+    memcpy(d + 4, "IEND", 4);
+    d = FinishChunk(d, 0);
+
+    bool ok = WriteFileAtomic(path, buf, (size_t)(d - buf));
+    free(buf);
+    return ok;
+}
+
+bool WriteImage(const char* path, int width, int height, const uint8_t* rgba, bool top_down) {
+    size_t n = strlen(path);
+    bool png = n >= 4 && (!strcmp(path + n - 4, ".png") || !strcmp(path + n - 4, ".PNG"));
+    return png ? WritePNG(path, width, height, rgba, top_down) : WritePPM(path, width, height, rgba, top_down);
+}
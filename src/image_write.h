@@ -0,0 +1,23 @@
+// image_write.h — 8-bit RGBA frames to PPM or PNG files
+//
+// Pixels come in glReadPixels order (rows bottom-up) unless top_down is set. PNG
+// output is uncompressed (stored deflate blocks): bigger files, but no zlib and
+// byte-exact output for a given frame.
+
+#ifndef SHADERDEVEL_IMAGE_WRITE_H
+#define SHADERDEVEL_IMAGE_WRITE_H
+
+#include "platform.h"
+
+// Binary P6; alpha is dropped.
+bool WritePPM(const char* path, int width, int height, const uint8_t* rgba, bool top_down);
+// Rows y0 .. y0+rows-1 (numbered bottom-up, rgba holding just those) of a width x height
+// PPM, written in place: the file is created if missing, never truncated, so several
+// processes can each fill a band of the same image. Not atomic.
+bool WritePPMRows(const char* path, int width, int height, int y0, int rows, const uint8_t* rgba);
+// RGBA, 8 bits per channel.
+bool WritePNG(const char* path, int width, int height, const uint8_t* rgba, bool top_down);
+// PNG for a ".png" path, PPM otherwise.
+bool WriteImage(const char* path, int width, int height, const uint8_t* rgba, bool top_down);
+
+#endif // SHADERDEVEL_IMAGE_WRITE_H
@@ -1,33 +1,37 @@
 // main.c — Win32 + WGL + OpenGL core shader playground with live reload (quad)
-// Build (MSVC):
-//   cl /Zi /W3 /DUNICODE /D_UNICODE main.c user32.lib gdi32.lib opengl32.lib
+// Build: the CMake project (README.md), which compiles this with app.c, the shared
+// modules under src/ and the vendored glad loader (third_party/glad).
 //
-// Files watched (same dir as EXE, override via command line):
-//   shader.vert
-//   shader.frag
+// Draws src\shader.vert + src\shader.frag (relative to the working directory; override
+// via command line, or one *.comp for a compute shader) through the drawing path in
+// app.c, shared with the headless front end. Saving a shader or anything it #includes
+// rebuilds it on a worker thread while the old program keeps drawing; errors go to the
+// title bar and the debugger output.
 //
-// Hotkeys: F5 = recompile, ESC = quit, Space = pause time
-// Uniforms: uTime (float), uResolution (vec2), uMouse (vec2, pixels)
-
-#define UNICODE
-#define _CRT_SECURE_NO_WARNINGS
-#define WIN32_LEAN_AND_MEAN
-#define STRICT
-#include <windows.h>
+// Every option is described in README.md and the header of the module that implements it.
+//
+// Hotkeys: F5 = recompile, F9 = write a CPU trace, ESC = quit, Space = pause time
+
+#include "platform.h"
+#include "app.h"
+#include "shader.h"
+#include "scheduler.h"
+#include "profiler.h"
 #include <wingdi.h>
-#include <gl/GL.h>
-#include <stdint.h>
-#include <stdbool.h>
+#include <shellapi.h>
+#include <dwmapi.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <stddef.h>
 #include <math.h>
 
 #pragma comment(lib, "opengl32.lib")
+#pragma comment(lib, "dwmapi.lib")
 
 // ============================= Config ==============================
 static const bool  g_vsync_enabled = true;
+static const int   g_reload_debounce_ms = 50; // editor save bursts (write temp, rename) collapse into one reload
+static const double g_title_refresh_seconds = 0.5; // GPU stats in the title bar
 
 // =================== Minimal WGL extension defs ====================
 #define WGL_DRAW_TO_WINDOW_ARB           0x2001
@@ -55,120 +59,118 @@ static PFNWGLCHOOSEPIXELFORMATARBPROC    p_wglChoosePixelFormatARB    = NULL;
 static PFNWGLCREATECONTEXTATTRIBSARBPROC p_wglCreateContextAttribsARB = NULL;
 static PFNWGLSWAPINTERVALEXTPROC         p_wglSwapIntervalEXT         = NULL;
 
-// ======= Minimal modern GL function pointers (no loader libs) ======
-#ifndef GL_ARRAY_BUFFER
-#define GL_ARRAY_BUFFER                0x8892
-#endif
-#ifndef GL_STATIC_DRAW
-#define GL_STATIC_DRAW                 0x88E4
-#endif
-#ifndef GL_VERTEX_SHADER
-#define GL_VERTEX_SHADER               0x8B31
-#endif
-#ifndef GL_FRAGMENT_SHADER
-#define GL_FRAGMENT_SHADER             0x8B30
-#endif
-#ifndef GL_COMPILE_STATUS
-#define GL_COMPILE_STATUS              0x8B81
-#endif
-#ifndef GL_LINK_STATUS
-#define GL_LINK_STATUS                 0x8B82
-#endif
-#ifndef GL_INFO_LOG_LENGTH
-#define GL_INFO_LOG_LENGTH             0x8B84
-#endif
-
-typedef char GLchar;
-typedef void   (APIENTRY *PFNGLGENVERTEXARRAYSPROC)(GLsizei, GLuint*);
-typedef void   (APIENTRY *PFNGLBINDVERTEXARRAYPROC)(GLuint);
-typedef void   (APIENTRY *PFNGLDELETEVERTEXARRAYSPROC)(GLsizei,const GLuint*);
-typedef void   (APIENTRY *PFNGLGENBUFFERSPROC)(GLsizei, GLuint*);
-typedef void   (APIENTRY *PFNGLBINDBUFFERPROC)(GLenum, GLuint);
-typedef void   (APIENTRY *PFNGLBUFFERDATAPROC)(GLenum, ptrdiff_t, const void*, GLenum);
-typedef void   (APIENTRY *PFNGLDELETEBUFFERSPROC)(GLsizei,const GLuint*);
-typedef GLuint (APIENTRY *PFNGLCREATESHADERPROC)(GLenum);
-typedef void   (APIENTRY *PFNGLSHADERSOURCEPROC)(GLuint, GLsizei, const GLchar* const*, const GLint*);
-typedef void   (APIENTRY *PFNGLCOMPILESHADERPROC)(GLuint);
-typedef void   (APIENTRY *PFNGLGETSHADERIVPROC)(GLuint, GLenum, GLint*);
-typedef void   (APIENTRY *PFNGLGETSHADERINFOLOGPROC)(GLuint, GLsizei, GLsizei*, GLchar*);
-typedef GLuint (APIENTRY *PFNGLCREATEPROGRAMPROC)(void);
-typedef void   (APIENTRY *PFNGLATTACHSHADERPROC)(GLuint, GLuint);
-typedef void   (APIENTRY *PFNGLLINKPROGRAMPROC)(GLuint);
-typedef void   (APIENTRY *PFNGLGETPROGRAMIVPROC)(GLuint, GLenum, GLint*);
-typedef void   (APIENTRY *PFNGLGETPROGRAMINFOLOGPROC)(GLuint, GLsizei, GLsizei*, GLchar*);
-typedef void   (APIENTRY *PFNGLDELETEPROGRAMPROC)(GLuint);
-typedef void   (APIENTRY *PFNGLDELETESHADERPROC)(GLuint);
-typedef void   (APIENTRY *PFNGLUSEPROGRAMPROC)(GLuint);
-typedef void   (APIENTRY *PFNGLVERTEXATTRIBPOINTERPROC)(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*);
-typedef void   (APIENTRY *PFNGLENABLEVERTEXATTRIBARRAYPROC)(GLuint);
-typedef GLint  (APIENTRY *PFNGLGETATTRIBLOCATIONPROC)(GLuint, const GLchar*);
-typedef GLint  (APIENTRY *PFNGLGETUNIFORMLOCATIONPROC)(GLuint, const GLchar*);
-typedef void   (APIENTRY *PFNGLUNIFORM1FPROC)(GLint, float);
-typedef void   (APIENTRY *PFNGLUNIFORM2FPROC)(GLint, float, float);
-
-static PFNGLGENVERTEXARRAYSPROC         glGenVertexArrays     = NULL;
-static PFNGLBINDVERTEXARRAYPROC         glBindVertexArray     = NULL;
-static PFNGLDELETEVERTEXARRAYSPROC      glDeleteVertexArrays  = NULL;
-static PFNGLGENBUFFERSPROC              glGenBuffers          = NULL;
-static PFNGLBINDBUFFERPROC              glBindBuffer          = NULL;
-static PFNGLBUFFERDATAPROC              glBufferData          = NULL;
-static PFNGLDELETEBUFFERSPROC           glDeleteBuffers       = NULL;
-static PFNGLCREATESHADERPROC            glCreateShader        = NULL;
-static PFNGLSHADERSOURCEPROC            glShaderSource        = NULL;
-static PFNGLCOMPILESHADERPROC           glCompileShader       = NULL;
-static PFNGLGETSHADERIVPROC             glGetShaderiv         = NULL;
-static PFNGLGETSHADERINFOLOGPROC        glGetShaderInfoLog    = NULL;
-static PFNGLCREATEPROGRAMPROC           glCreateProgram       = NULL;
-static PFNGLATTACHSHADERPROC            glAttachShader        = NULL;
-static PFNGLLINKPROGRAMPROC             glLinkProgram         = NULL;
-static PFNGLGETPROGRAMIVPROC            glGetProgramiv        = NULL;
-static PFNGLGETPROGRAMINFOLOGPROC       glGetProgramInfoLog   = NULL;
-static PFNGLDELETEPROGRAMPROC           glDeleteProgram       = NULL;
-static PFNGLDELETESHADERPROC            glDeleteShader        = NULL;
-static PFNGLUSEPROGRAMPROC              glUseProgram          = NULL;
-static PFNGLVERTEXATTRIBPOINTERPROC     glVertexAttribPointer = NULL;
-static PFNGLENABLEVERTEXATTRIBARRAYPROC glEnableVertexAttribArray = NULL;
-static PFNGLGETATTRIBLOCATIONPROC       glGetAttribLocation   = NULL;
-static PFNGLGETUNIFORMLOCATIONPROC      glGetUniformLocation  = NULL;
-static PFNGLUNIFORM1FPROC               glUniform1f           = NULL;
-static PFNGLUNIFORM2FPROC               glUniform2f           = NULL;
-// glViewport is core 1.1 in opengl32.dll — don’t load via wglGetProcAddress.
-
-// ============================ App State ============================
+static int ctxAttribs[] = {
+    WGL_CONTEXT_MAJOR_VERSION_ARB, 4,
+    WGL_CONTEXT_MINOR_VERSION_ARB, 0,
+    WGL_CONTEXT_PROFILE_MASK_ARB,  WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
+    0
+};
+
+// Shared-context worker for async shader builds (hidden window, same pixel format).
 typedef struct {
-    HINSTANCE hinst;
-    HWND      hwnd;
-    HDC       hdc;
-    HGLRC     glrc;
-    int       width, height;
-    bool      running;
-    bool      key_down[256];
-    bool      paused;
-
-    GLuint    program;
-    GLuint    vao, vbo;
-
-    // uniforms
-    GLint     uTime, uResolution, uMouse;
-
-    // shader files + mtimes
-    WCHAR     vert_path[MAX_PATH];
-    WCHAR     frag_path[MAX_PATH];
-    FILETIME  vert_time;
-    FILETIME  frag_time;
-
-    POINT     mouse; // in window client coords
-    LARGE_INTEGER qpf;
-    double    start_seconds;
-    double    paused_offset;
-} App;
-
-static App g_app = {0};
+    int   pixel_format;
+    HWND  hwnd;
+    HDC   hdc;
+    HGLRC glrc;
+} WorkerGL;
+static WorkerGL g_worker = {0};
 
 // Forward decls
 static LRESULT CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 
+static CompileResult g_compile_result; // 4KB log, keep it off the stack
+static bool g_reload_cache_hit;
+static int  g_reload_stages;
+static char g_reload_cost[200];   // the rebuilt shader's cost, or its first cost warning
+static TextureCache* g_textures;
+static char g_title_status[400]; // last reload/compile message; GPU stats are appended
+static double g_title_refreshed_at;
+static FrameScheduler* g_scheduler;
+static char   g_profile_path[APP_PATH_MAX] = "shaderdevel_trace.json";
+static double g_profile_seconds = PROFILER_DEFAULT_SECONDS;
+
 // ==================== Small helpers ================================
+static void InvalidateFrame(void) {
+    if (g_scheduler) FrameSchedulerInvalidate(g_scheduler);
+}
+static void SetTitleUTF8(const char* text) {
+    WCHAR wtext[512];
+    if (MultiByteToWideChar(CP_UTF8, 0, text, -1, wtext, 512) > 0) SetWindowTextW(g_app.hwnd, wtext);
+}
+static void RefreshTitle(void) {
+    char title[512];
+    FrameStats gpu;
+    g_title_refreshed_at = NowSeconds();
+    int n = snprintf(title, sizeof(title), "Shader Playground — %s", g_title_status);
+    if (g_app.gpu_timer && GpuTimerGetStats(g_app.gpu_timer, &gpu) && n < (int)sizeof(title)) {
+        n += snprintf(title + n, sizeof(title) - n, " | GPU ms mean %.2f p50 %.2f p95 %.2f p99 %.2f",
+                      gpu.mean_ms, gpu.median_ms, gpu.p95_ms, gpu.p99_ms);
+    }
+    if (g_app.dynres && n < (int)sizeof(title)) {
+        n += snprintf(title + n, sizeof(title) - n, " | scale %.2f (%dx%d)",
+                      g_app.dynres->scale, g_app.render_width, g_app.render_height);
+    }
+    if (g_app.progressive && !g_app.graph && n < (int)sizeof(title)) {
+        const ProgressiveRender* p = g_app.progressive;
+        if (p->passes)
+            n += snprintf(title + n, sizeof(title) - n, " | progressive %.0f%%, pass %.2f s",
+                          ProgressiveProgress(p) * 100.0, p->last_pass_seconds);
+        else
+            n += snprintf(title + n, sizeof(title) - n, " | progressive %.0f%%", ProgressiveProgress(p) * 100.0);
+    }
+    if (g_app.accum && g_app.paused && g_app.accum->started && n < (int)sizeof(title)) {
+        n += snprintf(title + n, sizeof(title) - n, " | still %d/%d", g_app.accum->samples, g_app.accum->max_samples);
+    }
+    if (g_app.graph && n < (int)sizeof(title)) {
+        n += snprintf(title + n, sizeof(title) - n, " | passes %d/%d", g_app.graph->passes_rendered, g_app.graph->count);
+    }
+    if (g_app.grid && n < (int)sizeof(title)) {
+        const ShaderGrid* g = g_app.grid;
+        int hover = ShaderGridTileAt(g, g_app.mouse_x, g_app.mouse_y);
+        n += snprintf(title + n, sizeof(title) - n, " | grid %d tiles drawn", g->tiles_drawn);
+        if (hover >= 0 && !g->tile[hover].program && n < (int)sizeof(title))
+            n += snprintf(title + n, sizeof(title) - n, ", %s not built", g->tile[hover].name);
+        else if (hover >= 0 && n < (int)sizeof(title))
+            n += snprintf(title + n, sizeof(title) - n, ", %s %.2f ms every %d", g->tile[hover].name,
+                          g->tile[hover].gpu_ms, g->tile[hover].interval);
+    }
+    FramePacerStats ps;
+    if (g_app.pacer && FramePacerGetStats(g_app.pacer, &ps) && n < (int)sizeof(title)) {
+        char how[64];
+        FramePacerDescribe(g_app.pacer, how, sizeof(how));
+        n += snprintf(title + n, sizeof(title) - n, " | input to present ms p50 %.1f p95 %.1f (%s",
+                      ps.latency.median_ms, ps.latency.p95_ms, how);
+        if (ps.missed && n < (int)sizeof(title)) n += snprintf(title + n, sizeof(title) - n, ", %d missed", ps.missed);
+        if (n < (int)sizeof(title)) n += snprintf(title + n, sizeof(title) - n, ")");
+    }
+    if (g_app.textures && n < (int)sizeof(title)) {
+        char mem[64];
+        FormatTextureMemory(mem, sizeof(mem));
+        n += snprintf(title + n, sizeof(title) - n, " | %s", mem);
+    }
+    if (g_app.capture && n < (int)sizeof(title)) {
+        CaptureStats cs;
+        FrameCaptureGetStats(g_app.capture, &cs);
+        snprintf(title + n, sizeof(title) - n, " | capture %llu written, %llu dropped%s",
+                 (unsigned long long)cs.written, (unsigned long long)FrameCaptureDropped(&cs),
+                 cs.write_error ? " (write error)" : "");
+    }
+    if (g_scheduler && n < (int)sizeof(title)) {
+        SchedulerStats st;
+        FrameSchedulerTakeStats(g_scheduler, &st);
+        double gpu_percent = 0.0;
+        if (g_app.gpu_timer && GpuTimerGetStats(g_app.gpu_timer, &gpu) && st.seconds > 0.0)
+            gpu_percent = gpu.mean_ms * st.frames / (st.seconds * 10.0);
+        snprintf(title + n, sizeof(title) - n, " | %s %.0f fps, cpu %.0f%% gpu ~%.0f%% idle %.0f%%",
+                 FrameSchedulerModeName(g_scheduler), st.seconds > 0.0 ? st.frames / st.seconds : 0.0,
+                 st.cpu_percent, gpu_percent, st.idle_percent);
+    }
+    SetTitleUTF8(title);
+}
+static void SetTitleStatus(const char* status) {
+    snprintf(g_title_status, sizeof(g_title_status), "%s", status);
+    RefreshTitle();
+}
 static void WinMsgBoxUTF8(const char* title, const char* msg) {
     int wlen = MultiByteToWideChar(CP_UTF8, 0, msg, -1, NULL, 0);
     int tlen = MultiByteToWideChar(CP_UTF8, 0, title, -1, NULL, 0);
@@ -179,31 +181,6 @@ static void WinMsgBoxUTF8(const char* title, const char* msg) {
     MessageBoxW(NULL, wmsg, wttl, MB_OK | MB_ICONERROR);
     free(wmsg); free(wttl);
 }
-static bool ReadFileUTF8(const WCHAR* path, char** out_data, size_t* out_size) {
-    *out_data = NULL; *out_size = 0;
-    HANDLE f = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-    if (f == INVALID_HANDLE_VALUE) return false;
-    LARGE_INTEGER size;
-    if (!GetFileSizeEx(f, &size)) { CloseHandle(f); return false; }
-    if (size.QuadPart <= 0 || size.QuadPart > 10485760) { CloseHandle(f); return false; } // <=10MB
-    char* buf = (char*)malloc((size_t)size.QuadPart + 1);
-    DWORD read = 0; BOOL ok = ReadFile(f, buf, (DWORD)size.QuadPart, &read, NULL);
-    CloseHandle(f);
-    if (!ok) { free(buf); return false; }
-    buf[read] = 0;
-    *out_data = buf; *out_size = read;
-    return true;
-}
-static bool GetFileWriteTime(const WCHAR* path, FILETIME* ft) {
-    WIN32_FILE_ATTRIBUTE_DATA fad;
-    if (!GetFileAttributesExW(path, GetFileExInfoStandard, &fad)) return false;
-    *ft = fad.ftLastWriteTime;
-    return true;
-}
-static double NowSeconds(void) {
-    LARGE_INTEGER qpc; QueryPerformanceCounter(&qpc);
-    return (double)qpc.QuadPart / (double)g_app.qpf.QuadPart;
-}
 
 // ==================== Temp context to load extensions ==============
 static bool CreateHiddenTempWindowAndLoadExtensions(void) {
@@ -259,43 +236,19 @@ static bool CreateHiddenTempWindowAndLoadExtensions(void) {
 }
 
 // ============ Load modern GL funcs after a real context is current =
+static GLADapiproc LoadGLProc(const char* name) {
+    // wglGetProcAddress only knows post-1.1 entry points (and may return small
+    // sentinel values instead of NULL); core 1.1 lives in opengl32.dll.
+    static HMODULE opengl32 = NULL;
+    PROC p = wglGetProcAddress(name);
+    if (p == NULL || p == (PROC)1 || p == (PROC)2 || p == (PROC)3 || p == (PROC)-1) {
+        if (!opengl32) opengl32 = LoadLibraryW(L"opengl32.dll");
+        p = opengl32 ? GetProcAddress(opengl32, name) : NULL;
+    }
+    return (GLADapiproc)p;
+}
 static bool LoadModernGLFunctions(void) {
-    // Load via wglGetProcAddress
-    glGenVertexArrays         = (PFNGLGENVERTEXARRAYSPROC)         wglGetProcAddress("glGenVertexArrays");
-    glBindVertexArray         = (PFNGLBINDVERTEXARRAYPROC)         wglGetProcAddress("glBindVertexArray");
-    glDeleteVertexArrays      = (PFNGLDELETEVERTEXARRAYSPROC)      wglGetProcAddress("glDeleteVertexArrays");
-    glGenBuffers              = (PFNGLGENBUFFERSPROC)              wglGetProcAddress("glGenBuffers");
-    glBindBuffer              = (PFNGLBINDBUFFERPROC)              wglGetProcAddress("glBindBuffer");
-    glBufferData              = (PFNGLBUFFERDATAPROC)              wglGetProcAddress("glBufferData");
-    glDeleteBuffers           = (PFNGLDELETEBUFFERSPROC)           wglGetProcAddress("glDeleteBuffers");
-    glCreateShader            = (PFNGLCREATESHADERPROC)            wglGetProcAddress("glCreateShader");
-    glShaderSource            = (PFNGLSHADERSOURCEPROC)            wglGetProcAddress("glShaderSource");
-    glCompileShader           = (PFNGLCOMPILESHADERPROC)           wglGetProcAddress("glCompileShader");
-    glGetShaderiv             = (PFNGLGETSHADERIVPROC)             wglGetProcAddress("glGetShaderiv");
-    glGetShaderInfoLog        = (PFNGLGETSHADERINFOLOGPROC)        wglGetProcAddress("glGetShaderInfoLog");
-    glCreateProgram           = (PFNGLCREATEPROGRAMPROC)           wglGetProcAddress("glCreateProgram");
-    glAttachShader            = (PFNGLATTACHSHADERPROC)            wglGetProcAddress("glAttachShader");
-    glLinkProgram             = (PFNGLLINKPROGRAMPROC)             wglGetProcAddress("glLinkProgram");
-    glGetProgramiv            = (PFNGLGETPROGRAMIVPROC)            wglGetProcAddress("glGetProgramiv");
-    glGetProgramInfoLog       = (PFNGLGETPROGRAMINFOLOGPROC)       wglGetProcAddress("glGetProgramInfoLog");
-    glDeleteProgram           = (PFNGLDELETEPROGRAMPROC)           wglGetProcAddress("glDeleteProgram");
-    glDeleteShader            = (PFNGLDELETESHADERPROC)            wglGetProcAddress("glDeleteShader");
-    glUseProgram              = (PFNGLUSEPROGRAMPROC)              wglGetProcAddress("glUseProgram");
-    glVertexAttribPointer     = (PFNGLVERTEXATTRIBPOINTERPROC)     wglGetProcAddress("glVertexAttribPointer");
-    glEnableVertexAttribArray = (PFNGLENABLEVERTEXATTRIBARRAYPROC) wglGetProcAddress("glEnableVertexAttribArray");
-    glGetAttribLocation       = (PFNGLGETATTRIBLOCATIONPROC)       wglGetProcAddress("glGetAttribLocation");
-    glGetUniformLocation      = (PFNGLGETUNIFORMLOCATIONPROC)      wglGetProcAddress("glGetUniformLocation");
-    glUniform1f               = (PFNGLUNIFORM1FPROC)               wglGetProcAddress("glUniform1f");
-    glUniform2f               = (PFNGLUNIFORM2FPROC)               wglGetProcAddress("glUniform2f");
-
-    if(!glGenVertexArrays || !glBindVertexArray || !glDeleteVertexArrays ||
-       !glGenBuffers || !glBindBuffer || !glBufferData || !glDeleteBuffers ||
-       !glCreateShader || !glShaderSource || !glCompileShader ||
-       !glGetShaderiv || !glGetShaderInfoLog || !glCreateProgram || !glAttachShader ||
-       !glLinkProgram || !glGetProgramiv || !glGetProgramInfoLog ||
-       !glDeleteProgram || !glDeleteShader || !glUseProgram ||
-       !glVertexAttribPointer || !glEnableVertexAttribArray || !glGetAttribLocation ||
-       !glGetUniformLocation || !glUniform1f || !glUniform2f) {
+    if(!gladLoadGL(LoadGLProc)) {
         WinMsgBoxUTF8("OpenGL function load failed",
                       "Some required modern OpenGL functions are missing.");
         return false;
@@ -328,13 +281,8 @@ static bool InitOpenGLRealContext(HWND hwnd, int w, int h, bool vsync) {
     PIXELFORMATDESCRIPTOR desc;
     if(!DescribePixelFormat(g_app.hdc, pixelFormat, sizeof(desc), &desc)) return false;
     if(!SetPixelFormat(g_app.hdc, pixelFormat, &desc)) return false;
+    g_worker.pixel_format = pixelFormat;
 
-    int ctxAttribs[] = {
-        WGL_CONTEXT_MAJOR_VERSION_ARB, 4,
-        WGL_CONTEXT_MINOR_VERSION_ARB, 0,
-        WGL_CONTEXT_PROFILE_MASK_ARB,  WGL_CONTEXT_CORE_PROFILE_BIT_ARB,
-        0
-    };
     g_app.glrc = p_wglCreateContextAttribsARB(g_app.hdc, 0, ctxAttribs);
     if(!g_app.glrc) return false;
 
@@ -347,160 +295,170 @@ static bool InitOpenGLRealContext(HWND hwnd, int w, int h, bool vsync) {
     return true;
 }
 
+// Second context sharing objects with g_app.glrc. It gets its own hidden window so
+// the worker never touches the DC the render thread presents with.
+static bool CreateWorkerContext(void) {
+    WNDCLASSW wc = {0};
+    wc.style         = CS_OWNDC;
+    wc.lpfnWndProc   = DefWindowProcW;
+    wc.hInstance     = g_app.hinst;
+    wc.lpszClassName = L"ShaderPlaygroundWorker";
+    if(!RegisterClassW(&wc)) return false;
+    g_worker.hwnd = CreateWindowW(wc.lpszClassName, L"", WS_OVERLAPPEDWINDOW, 0, 0, 16, 16, NULL, NULL, g_app.hinst, NULL);
+    if(!g_worker.hwnd) return false;
+    g_worker.hdc = GetDC(g_worker.hwnd);
+
+    PIXELFORMATDESCRIPTOR desc;
+    if(!DescribePixelFormat(g_worker.hdc, g_worker.pixel_format, sizeof(desc), &desc)) return false;
+    if(!SetPixelFormat(g_worker.hdc, g_worker.pixel_format, &desc)) return false;
+    g_worker.glrc = p_wglCreateContextAttribsARB(g_worker.hdc, g_app.glrc, ctxAttribs);
+    return g_worker.glrc != NULL;
+}
+static bool BindWorkerContext(void* user, bool bind) {
+    (void)user;
+    if (!bind) { wglMakeCurrent(NULL, NULL); return true; }
+    return wglMakeCurrent(g_worker.hdc, g_worker.glrc) != FALSE;
+}
+static void DestroyWorkerContext(void) {
+    if(g_worker.glrc) { wglDeleteContext(g_worker.glrc); g_worker.glrc = NULL; }
+    if(g_worker.hdc) { ReleaseDC(g_worker.hwnd, g_worker.hdc); g_worker.hdc = NULL; }
+    if(g_worker.hwnd) { DestroyWindow(g_worker.hwnd); g_worker.hwnd = NULL; }
+    UnregisterClassW(L"ShaderPlaygroundWorker", g_app.hinst);
+}
+
 static void ShutdownOpenGL(void) {
     if(g_app.program) { glDeleteProgram(g_app.program); g_app.program = 0; }
+    if(g_app.compute) { ComputePassShutdown(g_app.compute); g_app.compute = NULL; }
+    RenderGraphDestroy(g_app.graph); g_app.graph = NULL;
+    ShaderGridDestroy(g_app.grid); g_app.grid = NULL;
+    DetachChannelTextures();
+    TextureCacheDestroy(g_textures); g_textures = NULL;
     if(g_app.vbo) { glDeleteBuffers(1, &g_app.vbo); g_app.vbo = 0; }
     if(g_app.vao) { glDeleteVertexArrays(1, &g_app.vao); g_app.vao = 0; }
     if(g_app.glrc) { wglMakeCurrent(NULL, NULL); wglDeleteContext(g_app.glrc); g_app.glrc = NULL; }
     if(g_app.hdc) { ReleaseDC(g_app.hwnd, g_app.hdc); g_app.hdc = NULL; }
 }
 
-// =================== Shader compile/link + program swap ============
-static GLuint CompileShader(GLenum type, const char* src, char* logbuf, int logbufsz) {
-    GLuint sh = glCreateShader(type);
-    glShaderSource(sh, 1, &src, NULL);
-    glCompileShader(sh);
-    GLint ok = 0;
-    glGetShaderiv(sh, GL_COMPILE_STATUS, &ok);
-    if(!ok) {
-        GLsizei got=0;
-        glGetShaderInfoLog(sh, logbufsz, &got, logbuf);
-        glDeleteShader(sh);
-        return 0;
-    }
-    return sh;
+// ============== Hot reload (watcher thread events) =================
+static void ReloadShaders(double requested_at) {
+    SubmitChangedPrograms(true, requested_at);
 }
-static GLuint LinkProgram(GLuint vs, GLuint fs, char* logbuf, int logbufsz) {
-    GLuint p = glCreateProgram();
-    glAttachShader(p, vs);
-    glAttachShader(p, fs);
-    glLinkProgram(p);
-    GLint ok = 0;
-    glGetProgramiv(p, GL_LINK_STATUS, &ok);
-    if(!ok) {
-        GLsizei got=0;
-        glGetProgramInfoLog(p, logbufsz, &got, logbuf);
-        glDeleteProgram(p);
-        return 0;
+// Static cost of a rebuilt program (shader_cost.h): the summary and diff go to the
+// debugger, the first warning (or the summary) into the title with the reload time.
+static void ReportShaderCost(int tag) {
+    static char text[4096];
+    int warnings = UpdateShaderCost(tag, text, sizeof(text));
+    OutputDebugStringA(text);
+    OutputDebugStringA("\n");
+    const char* line = text;
+    if (warnings > 0) { // rather what got costlier than the total
+        const char* w = strstr(text, "\nwarning: ");
+        if (w && !strncmp(w + 1, "warning: cost ", 14) && strstr(w + 1, "\nwarning: ")) w = strstr(w + 1, "\nwarning: ");
+        if (w) line = w + 1;
     }
-    return p;
+    int eol = 0;
+    while (line[eol] && line[eol] != '\n') ++eol;
+    snprintf(g_reload_cost, sizeof(g_reload_cost), "%.*s", eol, line);
 }
-
-static bool LoadAndBuildProgramFromFiles(const WCHAR* vpath, const WCHAR* fpath, GLuint* outProg, char* outLog, int outLogSz) {
-    *outProg = 0; outLog[0] = 0;
-
-    char *vsrc=NULL,*fsrc=NULL; size_t vsz=0, fsz=0;
-    if(!ReadFileUTF8(vpath, &vsrc, &vsz)) { snprintf(outLog,outLogSz,"Failed to read vertex shader file."); return false; }
-    if(!ReadFileUTF8(fpath, &fsrc, &fsz)) { snprintf(outLog,outLogSz,"Failed to read fragment shader file."); free(vsrc); return false; }
-
-    GLuint vs = CompileShader(GL_VERTEX_SHADER,   vsrc, outLog, outLogSz);
-    if(!vs) { free(vsrc); free(fsrc); return false; }
-    GLuint fs = CompileShader(GL_FRAGMENT_SHADER, fsrc, outLog, outLogSz);
-    if(!fs) { glDeleteShader(vs); free(vsrc); free(fsrc); return false; }
-
-    GLuint prog = LinkProgram(vs, fs, outLog, outLogSz);
-    glDeleteShader(vs); glDeleteShader(fs);
-    free(vsrc); free(fsrc);
-    if(!prog) return false;
-
-    *outProg = prog;
-    return true;
-}
-
-static void ApplyProgram(GLuint prog) {
-    if (g_app.program) glDeleteProgram(g_app.program);
-    g_app.program = prog;
-    glUseProgram(g_app.program);
-    g_app.uTime       = glGetUniformLocation(g_app.program, "uTime");
-    g_app.uResolution = glGetUniformLocation(g_app.program, "uResolution");
-    g_app.uMouse      = glGetUniformLocation(g_app.program, "uMouse");
-}
-
-// ============== Quad (pos,uv) =====================================
-static void CreateFullscreenQuad(void) {
-    // Triangle strip: (-1, -1) .. (1, 1)
-    // pos.xy, uv.xy
-    const float verts[] = {
-        -1.f, -1.f,   0.f, 0.f,
-         1.f, -1.f,   1.f, 0.f,
-        -1.f,  1.f,   0.f, 1.f,
-         1.f,  1.f,   1.f, 1.f,
-    };
-    glGenVertexArrays(1, &g_app.vao);
-    glBindVertexArray(g_app.vao);
-    glGenBuffers(1, &g_app.vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, g_app.vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
-
-    GLint locPos = glGetAttribLocation(g_app.program, "aPos");
-    GLint locUV  = glGetAttribLocation(g_app.program, "aUV");
-
-    // In case shader uses layout(location=...), these are typically 0 and 1,
-    // but we query to be robust.
-    if (locPos < 0) locPos = 0;
-    if (locUV  < 0) locUV  = 1;
-
-    glVertexAttribPointer((GLuint)locPos, 2, GL_FLOAT, GL_FALSE, 4*(GLsizei)sizeof(float), (const void*)(0));
-    glEnableVertexAttribArray((GLuint)locPos);
-    glVertexAttribPointer((GLuint)locUV,  2, GL_FLOAT, GL_FALSE, 4*(GLsizei)sizeof(float), (const void*)(2*sizeof(float)));
-    glEnableVertexAttribArray((GLuint)locUV);
-    glBindVertexArray(0);
-}
-
-// ============== File watching (mtime polling) ======================
-static bool TimesEqual(const FILETIME* a, const FILETIME* b) {
-    return (a->dwLowDateTime==b->dwLowDateTime && a->dwHighDateTime==b->dwHighDateTime);
+// Finished texture loads: details to the debugger, the picture needs a redraw.
+static void CheckTextureLoads(void) {
+    static char text[4096];
+    if (!UpdateTextures(text, sizeof(text))) return;
+    OutputDebugStringA(text);
+    OutputDebugStringA("\n");
+    InvalidateFrame();
 }
 static bool CheckAndHotReload(void) {
-    FILETIME vt={0}, ft={0};
-    bool v_ok = GetFileWriteTime(g_app.vert_path, &vt);
-    bool f_ok = GetFileWriteTime(g_app.frag_path, &ft);
-    if(!v_ok || !f_ok) return false;
-
-    bool changed = (!TimesEqual(&vt, &g_app.vert_time) || !TimesEqual(&ft,&g_app.frag_time));
-    if (!changed) return false;
+    double changed_at = 0.0;
+    if (g_app.watcher && FileWatcherPoll(g_app.watcher, &changed_at)) {
+        char plog[512];
+        if (ReloadChangedParams(plog, sizeof(plog))) {
+            SetTitleStatus(plog[0] ? plog : "parameters reloaded");
+            InvalidateFrame();
+        }
+        SubmitChangedPrograms(false, changed_at);
+    }
 
-    char logbuf[4096];
-    GLuint newProg=0;
-    if (LoadAndBuildProgramFromFiles(g_app.vert_path, g_app.frag_path, &newProg, logbuf, sizeof(logbuf))) {
-        g_app.vert_time = vt; g_app.frag_time = ft;
-        ApplyProgram(newProg);
-        // Rebind VAO because attrib locations could have changed
-        if (g_app.vao) { glDeleteVertexArrays(1, &g_app.vao); g_app.vao = 0; }
-        if (g_app.vbo) { glDeleteBuffers(1, &g_app.vbo); g_app.vbo = 0; }
-        CreateFullscreenQuad();
-
-        WCHAR title[512];
-        swprintf(title, 512, L"Shader Playground — OK");
-        SetWindowTextW(g_app.hwnd, title);
-    } else {
-        WCHAR title[512];
-        swprintf(title, 512, L"Shader Playground — COMPILE ERROR");
-        SetWindowTextW(g_app.hwnd, title);
-        WinMsgBoxUTF8("Shader Error", logbuf[0]?logbuf:"Compile/link failed.");
+    // Graph passes finish independently; drain everything that is ready.
+    bool any = false;
+    CompileResult* r = &g_compile_result;
+    while (ShaderCompilerPoll(g_app.compiler, r)) {
+        any = true;
+        if (ApplyCompileResult(r)) {
+            if (r->unchanged) {
+                char status[64];
+                snprintf(status, sizeof(status), "unchanged, reload skipped (%d)", g_app.reloads_skipped);
+                SetTitleStatus(status);
+                continue;
+            }
+            g_app.reload_requested_at = r->requested_at; // title is set once the first frame is out
+            InvalidateFrame();
+            g_reload_cache_hit = r->cache_hit;
+            g_reload_stages = r->stages_compiled;
+            ReportShaderCost(r->tag);
+        } else {
+            // Keep drawing the last good program; never block the loop on an error.
+            char status[400];
+            int eol = 0;
+            while (r->log[eol] && r->log[eol] != '\n' && eol < 300) ++eol;
+            bool named = g_app.graph || g_app.grid;
+            snprintf(status, sizeof(status), "COMPILE ERROR%s%s: %.*s", named ? " in " : "",
+                     named ? ProgramName(r->tag) : "", eol, r->log[0] ? r->log : "Compile/link failed.");
+            SetTitleStatus(status);
+            OutputDebugStringA(r->log);
+            OutputDebugStringA("\n");
+        }
     }
-    return true;
+    return any;
 }
-
-// ============================ Drawing ==============================
-static void Render(float timeSec) {
-    glViewport(0,0,g_app.width,g_app.height);
-    glUseProgram(g_app.program);
-    if (g_app.uTime >= 0)       glUniform1f(g_app.uTime, g_app.paused ? (float)g_app.paused_offset : timeSec);
-    if (g_app.uResolution >= 0) glUniform2f(g_app.uResolution, (float)g_app.width, (float)g_app.height);
-    if (g_app.uMouse >= 0)      glUniform2f(g_app.uMouse, (float)g_app.mouse.x, (float)g_app.mouse.y);
-
-    glBindVertexArray(g_app.vao);
-    // using triangle strip; 4 verts
-    glDrawArrays(0x0005 /*GL_TRIANGLE_STRIP*/, 0, 4);
-    SwapBuffers(g_app.hdc);
+static void WriteTrace(void) {
+    char log[APP_PATH_MAX + 64], status[APP_PATH_MAX + 64];
+    int events = 0;
+    if (ProfilerWriteTrace(g_profile_path, g_profile_seconds, &events, log, sizeof(log)))
+        snprintf(status, sizeof(status), "trace of the last %.0f s (%d events) in %s", g_profile_seconds, events, g_profile_path);
+    else
+        snprintf(status, sizeof(status), "no trace: %s", log);
+    SetTitleStatus(status);
+}
+static void ReportReloadLatency(void) {
+    if (g_app.reload_requested_at <= 0.0) return;
+    g_app.last_reload_ms = (NowSeconds() - g_app.reload_requested_at) * 1000.0;
+    g_app.reload_requested_at = 0.0;
+    TelemetryReload(g_app.telemetry_thread, g_app.last_reload_ms);
+    char status[400];
+    char how[32];
+    if (g_reload_cache_hit) snprintf(how, sizeof(how), "cached");
+    else snprintf(how, sizeof(how), "%d/%d stages compiled", g_reload_stages, g_app.compute ? 1 : 2);
+    if (g_app.compute) {
+        size_t n = strlen(how);
+        snprintf(how + n, sizeof(how) - n, ", %dx%d", g_app.compute->local_size[0], g_app.compute->local_size[1]);
+    }
+    snprintf(status, sizeof(status), "OK (reload %.1f ms, %s, %s) %s",
+             g_app.last_reload_ms, CompilerModeName(ShaderCompilerGetMode(g_app.compiler)), how, g_reload_cost);
+    SetTitleStatus(status);
 }
 
 // ============================ Windowing ============================
-static void UpdateMouse(void) {
+// The next vblank on the NowSeconds clock (both are QPC), 0 if DWM can't tell.
+static double NextVblankSeconds(void) {
+    DWM_TIMING_INFO ti;
+    ZeroMemory(&ti, sizeof(ti));
+    ti.cbSize = sizeof(ti);
+    if (FAILED(DwmGetCompositionTimingInfo(NULL, &ti)) || !ti.qpcRefreshPeriod) return 0.0;
+    LARGE_INTEGER f, now;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&now);
+    ULONGLONG next = ti.qpcVBlank;
+    if ((ULONGLONG)now.QuadPart >= next) next += ((now.QuadPart - next) / ti.qpcRefreshPeriod + 1) * ti.qpcRefreshPeriod;
+    return (double)next / (double)f.QuadPart;
+}
+// True if the cursor moved.
+static bool UpdateMouse(void) {
     POINT p; GetCursorPos(&p);
     ScreenToClient(g_app.hwnd, &p);
-    g_app.mouse = p;
+    bool moved = p.x != g_app.mouse_x || p.y != g_app.mouse_y;
+    g_app.mouse_x = p.x; g_app.mouse_y = p.y;
+    return moved;
 }
 static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
     switch(msg) {
@@ -508,10 +466,13 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lpara
         g_app.width  = LOWORD(lparam);
         g_app.height = HIWORD(lparam);
         if(g_app.width>0 && g_app.height>0 && g_app.hdc) glViewport(0,0,g_app.width,g_app.height);
+        InvalidateFrame();
     } return 0;
     case WM_KEYDOWN:
         if (wparam < 256) g_app.key_down[wparam] = true;
-        if (wparam == VK_F5) CheckAndHotReload();
+        InvalidateFrame();
+        if (wparam == VK_F5) ReloadShaders(NowSeconds());
+        if (wparam == VK_F9 && !(lparam & (1 << 30))) WriteTrace(); // not on auto-repeat
         if (wparam == VK_SPACE) {
             g_app.paused = !g_app.paused;
             if (g_app.paused) {
@@ -526,6 +487,13 @@ static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lpara
     case WM_KEYUP:
         if (wparam < 256) g_app.key_down[wparam] = false;
         return 0;
+    case WM_LBUTTONDOWN: g_app.mouse_buttons |=  1; InvalidateFrame(); return 0;
+    case WM_LBUTTONUP:   g_app.mouse_buttons &= ~1; InvalidateFrame(); return 0;
+    case WM_RBUTTONDOWN: g_app.mouse_buttons |=  2; InvalidateFrame(); return 0;
+    case WM_RBUTTONUP:   g_app.mouse_buttons &= ~2; InvalidateFrame(); return 0;
+    case WM_MBUTTONDOWN: g_app.mouse_buttons |=  4; InvalidateFrame(); return 0;
+    case WM_MBUTTONUP:   g_app.mouse_buttons &= ~4; InvalidateFrame(); return 0;
+    case WM_KILLFOCUS:   g_app.mouse_buttons = 0;   return 0; // ups are lost once focus moves away
     case WM_CLOSE:
         PostQuitMessage(0);
         return 0;
@@ -574,79 +542,385 @@ static bool CreateMainWindowAndInitGL(int w, int h) {
     return true;
 }
 
-static void ResolveDefaultPathsFromExe(void) {
-    WCHAR exe[MAX_PATH];
-    GetModuleFileNameW(NULL, exe, MAX_PATH);
-    // strip filename
-    WCHAR dir[MAX_PATH];
-    wcscpy(dir, exe);
-    for (int i=(int)wcslen(dir)-1; i>=0; --i) { if (dir[i]==L'\\' || dir[i]==L'/') { dir[i]=0; break; } }
+// Relative to the working directory: the repo root when run as README.md says.
+static void SetDefaultShaderPaths(void) {
+    snprintf(g_app.vert_path, APP_PATH_MAX, "src\\shader.vert");
+    snprintf(g_app.frag_path, APP_PATH_MAX, "src\\shader.frag");
+}
 
-    swprintf(g_app.vert_path, MAX_PATH, L"src\\shader.vert", dir);
-    swprintf(g_app.frag_path, MAX_PATH, L"src\\shader.frag", dir);
+static const char* kUsage =
+    "Usage: shaderdevel [options] [vert frag | comp]\n"
+    "  --no-cache  --gpu-csv FILE  --dynres TARGET_MS  --graph FILE  --params FILE\n"
+    "  --grid PATH (repeatable)  --grid-budget MS  --progressive BUDGET_MS  --accumulate N\n"
+    "  --capture FILE  --capture-fps N  --on-demand  --fps-cap N  --variant NAME=VALUE,...\n"
+    "  --texture-budget MB  --telemetry ENDPOINT  --frames-in-flight N  --jit MS\n"
+    "  --profile FILE  --profile-seconds N\n"
+    "Defaults: src\\shader.vert src\\shader.frag. See README.md.";
+
+static void ShowUsage(const WCHAR* arg, const char* problem) {
+    char a[256], msg[1024];
+    WideCharToMultiByte(CP_UTF8, 0, arg, -1, a, sizeof(a), NULL, NULL);
+    snprintf(msg, sizeof(msg), "%s: %s\n\n%s", a, problem, kUsage);
+    WinMsgBoxUTF8("Invalid command line", msg);
 }
 
-static void SeedTimes(void) {
-    FILETIME t;
-    if (GetFileWriteTime(g_app.vert_path, &t)) g_app.vert_time = t;
-    if (GetFileWriteTime(g_app.frag_path, &t)) g_app.frag_time = t;
+static void StartWatchingShaders(void) {
+    g_app.watcher = FileWatcherCreate(g_reload_debounce_ms);
+    if (!g_app.watcher) {
+        SetTitleStatus("file watcher unavailable (F5 to reload)");
+        return;
+    }
+    WatchShaderFiles();
+    g_app.params_watch = GetUserParams() ? FileWatcherAddFile(g_app.watcher, GetUserParams()->path) : -1;
 }
 
 int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE hPrevInstance, PWSTR cmd, int nCmdShow) {
     (void)hPrevInstance; (void)cmd; (void)nCmdShow;
     g_app.hinst = hInst;
-    QueryPerformanceFrequency(&g_app.qpf);
-
-    // default shader paths (override via command line: first token vert, second frag)
-    ResolveDefaultPathsFromExe();
-    int argc = 0;
+    PROFILE_THREAD("main");
+
+    // Command line: kUsage; unknown options stop here rather than run with the defaults.
+    SetDefaultShaderPaths();
+    bool no_cache = false;
+    char gpu_csv[APP_PATH_MAX] = {0};
+    double dynres_ms = 0.0;
+    double progressive_ms = 0.0;
+    int accumulate = 0;
+    char graph_path[APP_PATH_MAX] = {0};
+    static char grid_paths[SHADER_GRID_MAX_TILES][APP_PATH_MAX];
+    const char* grid[SHADER_GRID_MAX_TILES];
+    int grid_count = 0;
+    double grid_budget_ms = SHADER_GRID_DEFAULT_BUDGET_MS;
+    char capture_path[APP_PATH_MAX] = {0};
+    int capture_fps = 60;
+    SchedulerOptions sched = { false, 0.0 };
+    char variant[512] = {0};
+    int texture_budget_mb = 0;
+    char telemetry_endpoint[APP_PATH_MAX] = {0};
+    bool profile_at_exit = false;
+    FramePacerOptions pacing = { 0, 0.0 };
+    static UserParams params;
+    int argc = 0, positional = 0;
     LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
-    if (argv && argc >= 2) wcsncpy(g_app.vert_path, argv[1], MAX_PATH);
-    if (argv && argc >= 3) wcsncpy(g_app.frag_path, argv[2], MAX_PATH);
+    for (int i = 1; argv && i < argc; ++i) {
+        if (!wcscmp(argv[i], L"--no-cache")) { no_cache = true; continue; }
+        if (!wcscmp(argv[i], L"--gpu-csv") && i + 1 < argc) {
+            WideCharToMultiByte(CP_UTF8, 0, argv[++i], -1, gpu_csv, APP_PATH_MAX, NULL, NULL);
+            continue;
+        }
+        if (!wcscmp(argv[i], L"--dynres") && i + 1 < argc) { dynres_ms = _wtof(argv[++i]); continue; }
+        if (!wcscmp(argv[i], L"--progressive") && i + 1 < argc) { progressive_ms = _wtof(argv[++i]); continue; }
+        if (!wcscmp(argv[i], L"--accumulate") && i + 1 < argc) { accumulate = _wtoi(argv[++i]); continue; }
+        if (!wcscmp(argv[i], L"--graph") && i + 1 < argc) {
+            WideCharToMultiByte(CP_UTF8, 0, argv[++i], -1, graph_path, APP_PATH_MAX, NULL, NULL);
+            continue;
+        }
+        if (!wcscmp(argv[i], L"--grid") && i + 1 < argc) {
+            ++i;
+            if (grid_count == SHADER_GRID_MAX_TILES) continue; // ShaderGridLoad reports too many shaders anyway
+            WideCharToMultiByte(CP_UTF8, 0, argv[i], -1, grid_paths[grid_count], APP_PATH_MAX, NULL, NULL);
+            grid[grid_count] = grid_paths[grid_count];
+            ++grid_count;
+            continue;
+        }
+        if (!wcscmp(argv[i], L"--grid-budget") && i + 1 < argc) { grid_budget_ms = _wtof(argv[++i]); continue; }
+        if (!wcscmp(argv[i], L"--capture") && i + 1 < argc) {
+            WideCharToMultiByte(CP_UTF8, 0, argv[++i], -1, capture_path, APP_PATH_MAX, NULL, NULL);
+            continue;
+        }
+        if (!wcscmp(argv[i], L"--capture-fps") && i + 1 < argc) { capture_fps = _wtoi(argv[++i]); continue; }
+        if (!wcscmp(argv[i], L"--variant") && i + 1 < argc) {
+            WideCharToMultiByte(CP_UTF8, 0, argv[++i], -1, variant, sizeof(variant), NULL, NULL);
+            continue;
+        }
+        if (!wcscmp(argv[i], L"--telemetry") && i + 1 < argc) {
+            WideCharToMultiByte(CP_UTF8, 0, argv[++i], -1, telemetry_endpoint, APP_PATH_MAX, NULL, NULL);
+            continue;
+        }
+        if (!wcscmp(argv[i], L"--profile") && i + 1 < argc) {
+            WideCharToMultiByte(CP_UTF8, 0, argv[++i], -1, g_profile_path, APP_PATH_MAX, NULL, NULL);
+            profile_at_exit = true;
+            continue;
+        }
+        if (!wcscmp(argv[i], L"--profile-seconds") && i + 1 < argc) { g_profile_seconds = _wtof(argv[++i]); continue; }
+        if (!wcscmp(argv[i], L"--frames-in-flight") && i + 1 < argc) { pacing.max_in_flight = _wtoi(argv[++i]); continue; }
+        if (!wcscmp(argv[i], L"--jit") && i + 1 < argc) { pacing.jit_margin_ms = _wtof(argv[++i]); continue; }
+        if (!wcscmp(argv[i], L"--on-demand")) { sched.on_demand = true; continue; }
+        if (!wcscmp(argv[i], L"--texture-budget") && i + 1 < argc) { texture_budget_mb = _wtoi(argv[++i]); continue; }
+        if (!wcscmp(argv[i], L"--fps-cap") && i + 1 < argc) { sched.fps_cap = _wtof(argv[++i]); continue; }
+        if (!wcscmp(argv[i], L"--params") && i + 1 < argc) {
+            WideCharToMultiByte(CP_UTF8, 0, argv[++i], -1, params.path, APP_PATH_MAX, NULL, NULL);
+            continue;
+        }
+        if (argv[i][0] == L'-' && argv[i][1] == L'-') {
+            ShowUsage(argv[i], i + 1 < argc ? "unknown option" : "unknown option or missing value");
+            LocalFree(argv);
+            return 1;
+        }
+        if (positional >= 2) {
+            ShowUsage(argv[i], "too many shader files");
+            LocalFree(argv);
+            return 1;
+        }
+        char* dst = positional == 0 ? g_app.vert_path : g_app.frag_path;
+        WideCharToMultiByte(CP_UTF8, 0, argv[i], -1, dst, APP_PATH_MAX, NULL, NULL);
+        ++positional;
+        if (positional == 1 && IsComputeShaderPath(g_app.vert_path)) { // a compute shader takes both places
+            snprintf(g_app.frag_path, APP_PATH_MAX, "%s", g_app.vert_path);
+            snprintf(g_app.vert_path, APP_PATH_MAX, "src\\shader.vert");
+            positional = 2;
+        }
+    }
     if (argv) LocalFree(argv);
 
     // Create window + GL
     g_app.width=1280; g_app.height=720;
     if(!CreateMainWindowAndInitGL(g_app.width, g_app.height)) return 0;
 
-    // First compile/link
+    // Program binary cache (optional; a driver without binary formats just compiles)
     char logbuf[4096];
+    ProgramCache* cache = NULL;
+    char cache_dir[APP_PATH_MAX];
+    if (!no_cache && GetUserCacheDir(cache_dir, sizeof(cache_dir))) {
+        strncat(cache_dir, "\\programs", sizeof(cache_dir) - strlen(cache_dir) - 1);
+        cache = ProgramCacheOpen(cache_dir, PROGRAM_CACHE_DEFAULT_BUDGET, logbuf, sizeof(logbuf));
+        if (!cache) { OutputDebugStringA(logbuf); OutputDebugStringA("\n"); }
+    }
+    SetProgramCache(cache);
+    IncludeCache* includes = IncludeCacheCreate();
+    SetIncludeCache(includes);
+    StageCache* stages = StageCacheCreate(STAGE_CACHE_DEFAULT_CAPACITY);
+    SetStageCache(stages);
+    if (variant[0]) {
+        ShaderDefines defines;
+        if (ParseShaderDefines(variant, &defines, logbuf, sizeof(logbuf))) SetShaderDefines(&defines);
+        else WinMsgBoxUTF8("Variant ignored", logbuf);
+    }
+    if (params.path[0]) {
+        if (LoadUserParams(params.path, &params, logbuf, sizeof(logbuf))) SetUserParams(&params);
+        else WinMsgBoxUTF8("Parameters ignored", logbuf);
+    }
+
+    // First compile/link
+    static ComputePass compute;
     GLuint prog=0;
-    if (!LoadAndBuildProgramFromFiles(g_app.vert_path, g_app.frag_path, &prog, logbuf, sizeof(logbuf))) {
+    BuildInfo info = {0};
+    double build_t0 = NowSeconds();
+    bool built;
+    if (graph_path[0]) {
+        if (grid_count) WinMsgBoxUTF8("Grid ignored", "--grid does not combine with --graph.");
+        g_app.graph = RenderGraphLoad(graph_path, logbuf, sizeof(logbuf));
+        built = g_app.graph && RenderGraphBuildPrograms(g_app.graph, g_app.vert_path, logbuf, sizeof(logbuf));
+    } else if (grid_count) {
+        g_app.grid = ShaderGridLoad(grid, grid_count, grid_budget_ms, logbuf, sizeof(logbuf));
+        built = g_app.grid && ShaderGridBuildPrograms(g_app.grid, g_app.vert_path, logbuf, sizeof(logbuf)) > 0;
+        if (built && logbuf[0]) WinMsgBoxUTF8("Grid tiles that did not build", logbuf); // they show black
+    } else if (IsComputeShaderPath(g_app.frag_path) && !ComputePassInit(&compute, logbuf, sizeof(logbuf))) {
+        built = false;
+    } else {
+        if (IsComputeShaderPath(g_app.frag_path)) g_app.compute = &compute;
+        built = LoadAndBuildProgramFromFiles(g_app.vert_path, g_app.frag_path, &prog, &info, logbuf, sizeof(logbuf));
+    }
+    if (!built) {
         WinMsgBoxUTF8("Initial compile failed", logbuf[0]?logbuf:"Could not build shaders.");
+        SetUserParams(NULL);
+        SetStageCache(NULL);
+        StageCacheDestroy(stages);
+        SetIncludeCache(NULL);
+        IncludeCacheDestroy(includes);
+        SetProgramCache(NULL);
+        ProgramCacheClose(cache);
         ShutdownOpenGL();
         DestroyWindow(g_app.hwnd);
         return 0;
     }
-    ApplyProgram(prog);
+    char status[256];
+    if (g_app.graph) {
+        snprintf(status, sizeof(status), "startup %.1f ms, %d passes (cache %s)",
+                 (NowSeconds() - build_t0) * 1000.0, g_app.graph->count, cache ? "on" : "off");
+    } else if (g_app.grid) {
+        int ok = 0;
+        for (int i = 0; i < g_app.grid->count; ++i) ok += g_app.grid->tile[i].program != 0;
+        snprintf(status, sizeof(status), "startup %.1f ms, %d of %d grid shaders (cache %s)",
+                 (NowSeconds() - build_t0) * 1000.0, ok, g_app.grid->count, cache ? "on" : "off");
+    } else {
+        snprintf(status, sizeof(status), "startup %.1f ms (cache %s)",
+                 (NowSeconds() - build_t0) * 1000.0, !cache ? "off" : info.cache_hit ? "hit" : "miss");
+        ApplyProgram(prog);
+        g_app.program_hash = info.source_hash;
+        if (g_app.compute) {
+            size_t n = strlen(status);
+            snprintf(status + n, sizeof(status) - n, ", local size %dx%d", g_app.compute->local_size[0], g_app.compute->local_size[1]);
+        }
+    }
+    for (int i = 0; i < ProgramCount(); ++i) ReportShaderCost(i); // the first diff's baseline
+    SetTitleStatus(status);
     CreateFullscreenQuad();
-    SeedTimes();
+    g_app.frame_uniforms = FrameUniformsCreate();
+    g_app.gpu_timer = GpuTimerCreate();
+    if (pacing.max_in_flight > 0 || pacing.jit_margin_ms > 0.0) {
+        if (pacing.max_in_flight <= 0) pacing.max_in_flight = 1; // --jit alone: the lowest latency
+        g_app.pacer = FramePacerCreate(&pacing);
+        if (!g_app.pacer) WinMsgBoxUTF8("Out of memory", "Could not create the frame pacer: frames are not paced.");
+    }
+    g_textures = TextureCacheCreate(texture_budget_mb > 0 ? (size_t)texture_budget_mb << 20 : 0);
+    if (!g_textures) WinMsgBoxUTF8("Out of memory", "Could not create the texture cache: iChannel images stay black.");
+    AttachChannelTextures(g_textures);
+    if (gpu_csv[0] && !g_app.gpu_timer) WinMsgBoxUTF8("GPU timing", "Out of memory: frames are not timed.");
+    else if (gpu_csv[0] && !GpuTimerOpenCsv(g_app.gpu_timer, gpu_csv)) WinMsgBoxUTF8("GPU timing", "Could not open the --gpu-csv file for writing.");
+    static DynamicResolution dynres;
+    if (dynres_ms > 0.0 && g_app.grid) {
+        WinMsgBoxUTF8("Dynamic resolution disabled", "--grid budgets GPU time per tile; it does not combine with --dynres.");
+    } else if (dynres_ms > 0.0) {
+        DynResOptions dopt;
+        DynResDefaultOptions(&dopt, dynres_ms);
+        if (DynResInit(&dynres, &dopt, logbuf, sizeof(logbuf))) g_app.dynres = &dynres;
+        else WinMsgBoxUTF8("Dynamic resolution disabled", logbuf);
+    }
+    static ProgressiveRender progressive;
+    if (progressive_ms > 0.0 && (g_app.graph || g_app.grid || g_app.dynres || g_app.compute)) {
+        WinMsgBoxUTF8("Progressive rendering disabled", "--progressive draws a single fragment shader at full resolution; it does not combine with --graph, --grid, --dynres or a compute shader.");
+    } else if (progressive_ms > 0.0) {
+        ProgressiveOptions popt;
+        ProgressiveDefaultOptions(&popt, progressive_ms);
+        ProgressiveInit(&progressive, &popt);
+        g_app.progressive = &progressive;
+    }
+    static TemporalAccumulation accum;
+    if (accumulate > 0 && g_app.grid) {
+        WinMsgBoxUTF8("Accumulation disabled", "--accumulate makes stills of a single shader; it does not combine with --grid.");
+    } else if (accumulate > 0) {
+        if (AccumInit(&accum, accumulate, logbuf, sizeof(logbuf))) g_app.accum = &accum;
+        else WinMsgBoxUTF8("Accumulation disabled", logbuf);
+    }
+    if (capture_path[0]) {
+        // Fixed to the client size at startup; frames after a resize count as dropped.
+        bool y4m;
+        FILE* out = CaptureOpenStream(capture_path, &y4m);
+        if (out) g_app.capture = FrameCaptureCreate(out, y4m, g_app.width, g_app.height, capture_fps, logbuf, sizeof(logbuf));
+        else snprintf(logbuf, sizeof(logbuf), "Could not open %s for writing.", capture_path);
+        if (!g_app.capture) WinMsgBoxUTF8("Capture disabled", logbuf);
+    }
+    Telemetry* telemetry = NULL;
+    if (telemetry_endpoint[0]) {
+        telemetry = TelemetryCreate(telemetry_endpoint, logbuf, sizeof(logbuf));
+        if (telemetry) {
+            AttachTelemetry(telemetry);
+            snprintf(logbuf, sizeof(logbuf), "telemetry on %s (GET /metrics, /stream)\n", TelemetryEndpoint(telemetry));
+            OutputDebugStringA(logbuf);
+        } else {
+            WinMsgBoxUTF8("Telemetry disabled", logbuf);
+        }
+    }
+    g_app.compiler = ShaderCompilerCreate(CreateWorkerContext() ? BindWorkerContext : NULL, NULL);
+    if (!g_app.compiler) WinMsgBoxUTF8("Out of memory", "Could not create the shader compiler.");
+    StartWatchingShaders();
+    if (sched.fps_cap < 0.0) sched.fps_cap = 0.0;
+    g_scheduler = FrameSchedulerCreate(&sched);
+    if (g_scheduler && g_app.compiler) {
+        // Their threads only wake the loop; CheckAndHotReload decides whether to redraw.
+        ShaderCompilerSetNotify(g_app.compiler, FrameSchedulerNotify, g_scheduler);
+        if (g_app.watcher) FileWatcherSetNotify(g_app.watcher, FrameSchedulerNotify, g_scheduler);
+        TextureCacheSetNotify(g_textures, FrameSchedulerNotify, g_scheduler);
+    } else {
+        OutputDebugStringA("Frame scheduler unavailable, rendering continuously.\n");
+    }
 
-    g_app.running = true;
+    g_app.running = g_app.compiler != NULL; // else straight to the teardown
     g_app.paused = false;
     g_app.start_seconds = NowSeconds();
 
     MSG msg; ZeroMemory(&msg, sizeof(msg));
     while(g_app.running) {
+        PROFILE_BEGIN("message pump");
         while(PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE)) {
             TranslateMessage(&msg);
             DispatchMessageW(&msg);
             if(msg.message == WM_QUIT) g_app.running = false;
         }
+        PROFILE_END();
         if(!g_app.running) break;
         if (g_app.key_down[VK_ESCAPE]) g_app.running = false;
 
-        // Poll mouse & hot-reload files (if modified)
-        UpdateMouse();
+        // Poll mouse & hot-reload files (if the watcher saw a change)
+        PROFILE_BEGIN("UpdateMouse");
+        if (UpdateMouse()) InvalidateFrame();
+        PROFILE_END();
+        PROFILE_BEGIN("CheckAndHotReload");
         CheckAndHotReload();
+        PROFILE_END();
+        PROFILE_BEGIN("CheckTextureLoads");
+        CheckTextureLoads();
+        PROFILE_END();
+
+        // Nothing to draw yet: sleep until input, a reload, the cap or the next title refresh.
+        bool animating = !g_app.paused || SceneNeedsFrames();
+        if (g_scheduler && !FrameSchedulerBeginFrame(g_scheduler, animating)) {
+            double until_title = g_title_refresh_seconds - (NowSeconds() - g_title_refreshed_at);
+            if (until_title <= 0.0) { RefreshTitle(); until_title = g_title_refresh_seconds; }
+            int wait_ms = (int)(until_title * 1000.0) + 1;
+            if (ShaderCompilerNeedsPolling(g_app.compiler) && wait_ms > 5) wait_ms = 5;
+            PROFILE_BEGIN("FrameSchedulerWait");
+            FrameSchedulerWait(g_scheduler, animating, wait_ms);
+            PROFILE_END();
+            continue;
+        }
 
         // Time
-        double t = NowSeconds() - g_app.start_seconds;
-        Render((float)t);
+        double frame_start = NowSeconds(), t0 = frame_start;
+        if (g_app.pacer) {
+            // Wait for the in-flight bound (and the just-in-time start) first, then read
+            // the cursor: the draw sees input as fresh as the frame can have.
+            PROFILE_BEGIN("FramePacerBeginFrame");
+            t0 = FramePacerBeginFrame(g_app.pacer, pacing.jit_margin_ms > 0.0 ? NextVblankSeconds() : 0.0);
+            PROFILE_END();
+            UpdateMouse();
+        }
+        PROFILE_BEGIN("RenderFrame");
+        RenderFrame((float)(t0 - g_app.start_seconds), 0);
+        PROFILE_END();
+        if (g_app.pacer) FramePacerDrawn(g_app.pacer);
+        PROFILE_BEGIN("SwapBuffers");
+        SwapBuffers(g_app.hdc);
+        PROFILE_END();
+        if (g_app.pacer) FramePacerEndFrame(g_app.pacer);
+        TelemetryFrame(g_app.telemetry_thread, (NowSeconds() - frame_start) * 1000.0); // includes the vsync wait
+        ReportReloadLatency();
+        if (NowSeconds() - g_title_refreshed_at >= g_title_refresh_seconds) RefreshTitle();
     }
 
+    TextureCacheSetNotify(g_textures, NULL, NULL);
+    FileWatcherDestroy(g_app.watcher);
+    ShaderCompilerDestroy(g_app.compiler);
+    FrameSchedulerDestroy(g_scheduler); g_scheduler = NULL;
+    FrameCaptureDestroy(g_app.capture, NULL); g_app.capture = NULL;
+    if (g_app.dynres) { DynResShutdown(g_app.dynres); g_app.dynres = NULL; }
+    if (g_app.progressive) { ProgressiveShutdown(g_app.progressive); g_app.progressive = NULL; }
+    if (g_app.accum) { AccumShutdown(g_app.accum); g_app.accum = NULL; }
+    DetachTelemetry();
+    TelemetryDestroy(telemetry);
+    FramePacerDestroy(g_app.pacer); g_app.pacer = NULL;
+    GpuTimerDestroy(g_app.gpu_timer); g_app.gpu_timer = NULL;
+    FrameUniformsDestroy(g_app.frame_uniforms); g_app.frame_uniforms = NULL;
+    DestroyWorkerContext();
+    FreeShaderCosts();
+    SetUserParams(NULL);
+    SetStageCache(NULL);
+    StageCacheDestroy(stages);
+    SetIncludeCache(NULL);
+    IncludeCacheDestroy(includes);
+    SetProgramCache(NULL);
+    ProgramCacheClose(cache);
     ShutdownOpenGL();
     if (g_app.hwnd) DestroyWindow(g_app.hwnd);
     UnregisterClassW(L"ShaderPlayground", g_app.hinst);
+    if (profile_at_exit) {
+        char plog[APP_PATH_MAX + 64];
+        if (!ProfilerWriteTrace(g_profile_path, g_profile_seconds, NULL, plog, sizeof(plog))) {
+            OutputDebugStringA(plog);
+            OutputDebugStringA("\n");
+        }
+    }
+    ProfilerShutdown();
     return 0;
 }
@@ -0,0 +1,351 @@
+// main_bench.c — shaderbench: frame-time regression benchmark over a shader corpus
+//
+// Usage: shaderbench [--corpus DIR] [--only NAME] [--size WxH] [--frames N] [--warmup N]
+//                    [--runs N] [--time T] [--baseline FILE] [--tolerance F] [--out FILE]
+// Defaults: src/bench, 256x144, 40 frames, 3 warmup, 3 runs, uTime 1, tolerance 0.25
+//
+// Every *.frag in the corpus (or only NAME.frag) is built with src/shader.vert and
+// drawn into an offscreen target on a surfaceless context (software GL is fine), with
+// fixed inputs: uTime = --time, frame 0, no mouse. The harness binds a 512x512 RGBA8
+// noise texture with mipmaps to unit 0 for texture-bound shaders (uBenchTex). Each
+// frame is timed from the draw to glFinish, which on software GL is the rasterization
+// itself; the GPU timer query result is recorded next to it. A shader's score is the
+// best of --runs run medians, so one run disturbed by other load doesn't count.
+//
+// --out writes every shader's distribution (all samples of all runs) as JSON. With
+// --baseline, a shader fails when its score exceeds the baseline's by more than
+// --tolerance (a fraction) plus BENCH_SLACK_MS, and the exit code is 1; CMake registers
+// one CTest per corpus shader this way. Shaders missing from the baseline pass with a
+// note. Refresh the baseline by running without --baseline and --out onto it (the
+// shaderbench_baseline target), on the machine the tests run on.
+
+#include "platform.h"
+#include "app.h"
+#include "shader.h"
+#include "headless_context.h"
+#include "render_target.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_MAX_SHADERS 64
+#define BENCH_SLACK_MS    0.05 // absolute allowance on top of the tolerance, for tiny scores
+#define BENCH_TEX_SIZE    512
+
+typedef struct {
+    char   corpus[APP_PATH_MAX];
+    char   only[64];              // empty = every shader
+    int    width, height;
+    int    frames, warmup, runs;
+    float  time;
+    char   baseline[APP_PATH_MAX]; // empty = no comparison
+    double tolerance;
+    char   out[APP_PATH_MAX];      // empty = no JSON
+} BenchOptions;
+
+typedef struct {
+    char       name[64];
+    bool       built;
+    double     score_ms;        // best run median
+    FrameStats wall;            // every timed frame of every run
+    double     gpu_median_ms;   // 0 without timer results
+    double     baseline_ms;     // < 0: not in the baseline
+    const char* status;         // "ok", "slower", "new", "failed"
+} BenchResult;
+
+static char s_names[BENCH_MAX_SHADERS][64];
+static int  s_name_count;
+
+static void PrintUsage(const char* exe) {
+    fprintf(stderr, "Usage: %s [--corpus DIR] [--only NAME] [--size WxH] [--frames N] [--warmup N]\n"
+                    "          [--runs N] [--time T] [--baseline FILE] [--tolerance F] [--out FILE]\n", exe);
+}
+
+static bool ParseArgs(int argc, char** argv, BenchOptions* opt) {
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (!strcmp(a, "--corpus") && i + 1 < argc)         snprintf(opt->corpus, APP_PATH_MAX, "%s", argv[++i]);
+        else if (!strcmp(a, "--only") && i + 1 < argc)      snprintf(opt->only, sizeof(opt->only), "%s", argv[++i]);
+        else if (!strcmp(a, "--size") && i + 1 < argc)      { if (sscanf(argv[++i], "%dx%d", &opt->width, &opt->height) != 2) return false; }
+        else if (!strcmp(a, "--frames") && i + 1 < argc)    opt->frames = atoi(argv[++i]);
+        else if (!strcmp(a, "--warmup") && i + 1 < argc)    opt->warmup = atoi(argv[++i]);
+        else if (!strcmp(a, "--runs") && i + 1 < argc)      opt->runs = atoi(argv[++i]);
+        else if (!strcmp(a, "--time") && i + 1 < argc)      opt->time = (float)atof(argv[++i]);
+        else if (!strcmp(a, "--baseline") && i + 1 < argc)  snprintf(opt->baseline, APP_PATH_MAX, "%s", argv[++i]);
+        else if (!strcmp(a, "--tolerance") && i + 1 < argc) opt->tolerance = atof(argv[++i]);
+        else if (!strcmp(a, "--out") && i + 1 < argc)       snprintf(opt->out, APP_PATH_MAX, "%s", argv[++i]);
+        else return false;
+    }
+    return opt->width > 0 && opt->height > 0 && opt->frames > 0 && opt->warmup >= 0 && opt->runs > 0 && opt->tolerance >= 0.0;
+}
+
+// ============================= Corpus ==============================
+static void CollectShader(const DirEntry* e, void* user) {
+    const BenchOptions* opt = (const BenchOptions*)user;
+    size_t n = strlen(e->name);
+    if (n < 6 || n - 5 >= sizeof(s_names[0]) || strcmp(e->name + n - 5, ".frag") || s_name_count == BENCH_MAX_SHADERS) return;
+    char name[64];
+    snprintf(name, sizeof(name), "%.*s", (int)(n - 5), e->name);
+    if (opt->only[0] && strcmp(opt->only, name)) return;
+    snprintf(s_names[s_name_count++], sizeof(s_names[0]), "%s", name);
+}
+
+static int CompareNames(const void* a, const void* b) { return strcmp((const char*)a, (const char*)b); }
+
+// White noise with real mip levels, so minified lookups read averaged data.
+static GLuint CreateNoiseTexture(void) {
+    uint8_t* px = (uint8_t*)malloc((size_t)BENCH_TEX_SIZE * BENCH_TEX_SIZE * 4);
+    if (!px) return 0;
+    uint32_t state = 0x9E3779B9u;
+    for (int i = 0; i < BENCH_TEX_SIZE * BENCH_TEX_SIZE * 4; ++i) {
+        state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+        px[i] = (uint8_t)(state >> 24);
+    }
+    GLuint tex = 0;
+    glGenTextures(1, &tex);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, BENCH_TEX_SIZE, BENCH_TEX_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, px);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    free(px);
+    return tex;
+}
+
+// ============================ Baseline =============================
+// Reads back what WriteJson wrote: each shader object's "name" and the "score_ms"
+// after it. Not a general JSON parser.
+static double BaselineScore(const char* json, const char* name) {
+    char key[96];
+    snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+    const char* at = json ? strstr(json, key) : NULL;
+    if (!at) return -1.0;
+    const char* next = strstr(at + 1, "\"name\":");
+    const char* score = strstr(at, "\"score_ms\":");
+    if (!score || (next && score > next)) return -1.0;
+    return atof(score + 11);
+}
+
+// Scores only compare at the size they were taken at.
+static bool BaselineSizeMatches(const char* json, const BenchOptions* opt) {
+    const char* at = strstr(json, "\"width\":");
+    int w = 0, h = 0;
+    return at && sscanf(at, "\"width\": %d, \"height\": %d", &w, &h) == 2 && w == opt->width && h == opt->height;
+}
+
+static void BaselineRenderer(const char* json, char* out, size_t outsz) {
+    out[0] = 0;
+    const char* at = json ? strstr(json, "\"renderer\": \"") : NULL;
+    if (!at) return;
+    at += 13;
+    size_t n = strcspn(at, "\"");
+    snprintf(out, outsz, "%.*s", (int)n, at);
+}
+
+// ============================== JSON ===============================
+typedef struct {
+    char*  data;
+    size_t len, cap;
+} Text;
+
+static void Appendf(Text* t, const char* fmt, ...) {
+    va_list ap;
+    for (;;) {
+        va_start(ap, fmt);
+        int n = vsnprintf(t->data ? t->data + t->len : NULL, t->data ? t->cap - t->len : 0, fmt, ap);
+        va_end(ap);
+        if (n < 0) return;
+        if (t->data && t->len + (size_t)n < t->cap) { t->len += (size_t)n; return; }
+        size_t cap = t->cap ? t->cap * 2 : 4096;
+        while (cap <= t->len + (size_t)n) cap *= 2;
+        char* grown = (char*)realloc(t->data, cap);
+        if (!grown) return;
+        t->data = grown;
+        t->cap = cap;
+    }
+}
+
+// JSON string contents: the renderer string is the only free text.
+static void AppendEscaped(Text* t, const char* s) {
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') Appendf(t, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20) Appendf(t, "\\u%04x", (unsigned char)*s);
+        else Appendf(t, "%c", *s);
+    }
+}
+
+static bool WriteJson(const char* path, const BenchOptions* opt, const char* renderer, const BenchResult* r, int count) {
+    Text t = { 0 };
+    Appendf(&t, "{\n  \"renderer\": \"");
+    AppendEscaped(&t, renderer);
+    Appendf(&t, "\",\n  \"width\": %d, \"height\": %d, \"frames\": %d, \"warmup\": %d, \"runs\": %d, \"time\": %g,\n",
+            opt->width, opt->height, opt->frames, opt->warmup, opt->runs, opt->time);
+    Appendf(&t, "  \"shaders\": [\n");
+    for (int i = 0; i < count; ++i) {
+        const BenchResult* b = &r[i];
+        Appendf(&t, "    { \"name\": \"%s\", \"status\": \"%s\"", b->name, b->status);
+        if (b->built) {
+            Appendf(&t, ", \"score_ms\": %.4f,\n      \"min_ms\": %.4f, \"median_ms\": %.4f, \"p95_ms\": %.4f, \"p99_ms\": %.4f,"
+                        " \"mean_ms\": %.4f, \"max_ms\": %.4f, \"samples\": %d, \"gpu_median_ms\": %.4f",
+                    b->score_ms, b->wall.min_ms, b->wall.median_ms, b->wall.p95_ms, b->wall.p99_ms,
+                    b->wall.mean_ms, b->wall.max_ms, b->wall.frames, b->gpu_median_ms);
+            if (b->baseline_ms >= 0.0) Appendf(&t, ", \"baseline_ms\": %.4f", b->baseline_ms);
+        }
+        Appendf(&t, " }%s\n", i + 1 < count ? "," : "");
+    }
+    Appendf(&t, "  ]\n}\n");
+    bool ok = t.data && WriteFileAtomic(path, t.data, t.len);
+    free(t.data);
+    return ok;
+}
+
+// ============================== Bench ==============================
+static void BenchShader(const BenchOptions* opt, GLuint fbo, double* samples, BenchResult* r) {
+    char fpath[APP_PATH_MAX + 80], log[COMPILE_LOG_SIZE];
+    snprintf(fpath, sizeof(fpath), "%s/%s.frag", opt->corpus, r->name);
+    GLuint prog = 0;
+    if (!LoadAndBuildProgramFromFiles(g_app.vert_path, fpath, &prog, NULL, log, sizeof(log))) {
+        fprintf(stderr, "%s: build failed:\n%s\n", r->name, log);
+        r->status = "failed";
+        return;
+    }
+    ApplyProgram(prog);
+    r->built = true;
+
+    FrameInputs in;
+    memset(&in, 0, sizeof(in));
+    in.resolution[0] = (float)opt->width;
+    in.resolution[1] = (float)opt->height;
+    in.time = opt->time;
+    in.time_delta = 1.0f / 60.0f;
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    r->score_ms = 0.0;
+    for (int run = 0; run < opt->runs; ++run) {
+        double* s = samples + (size_t)run * opt->frames;
+        for (int f = -opt->warmup; f < opt->frames; ++f) {
+            if (run == 0 && f == 0 && g_app.gpu_timer) GpuTimerReset(g_app.gpu_timer);
+            double t0 = NowSeconds();
+            RenderRegion(&in, opt->width, opt->height);
+            glFinish();
+            if (f >= 0) s[f] = (NowSeconds() - t0) * 1000.0;
+        }
+        FrameStats st;
+        ComputeFrameStats(s, opt->frames, &st);
+        if (run == 0 || st.median_ms < r->score_ms) r->score_ms = st.median_ms;
+    }
+    ComputeFrameStats(samples, opt->frames * opt->runs, &r->wall);
+    FrameStats gpu;
+    if (g_app.gpu_timer) {
+        GpuTimerCollect(g_app.gpu_timer, true);
+        if (GpuTimerGetStats(g_app.gpu_timer, &gpu)) r->gpu_median_ms = gpu.median_ms;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opt = { .width = 256, .height = 144, .frames = 40, .warmup = 3, .runs = 3, .time = 1.0f, .tolerance = 0.25 };
+    snprintf(opt.corpus, APP_PATH_MAX, "src/bench");
+    snprintf(g_app.vert_path, APP_PATH_MAX, "src/shader.vert");
+    if (!ParseArgs(argc, argv, &opt)) { PrintUsage(argv[0]); return 2; }
+
+    if (!ListDirectory(opt.corpus, CollectShader, &opt) || s_name_count == 0) {
+        fprintf(stderr, "No %s.frag in %s.\n", opt.only[0] ? opt.only : "*", opt.corpus);
+        return 2;
+    }
+    qsort(s_names, (size_t)s_name_count, sizeof(s_names[0]), CompareNames);
+    char* baseline = NULL;
+    size_t baseline_size = 0;
+    if (opt.baseline[0] && !ReadWholeFile(opt.baseline, 1u << 20, &baseline, &baseline_size)) {
+        fprintf(stderr, "Could not read the baseline %s.\n", opt.baseline);
+        return 2;
+    }
+    if (baseline && !BaselineSizeMatches(baseline, &opt)) {
+        fprintf(stderr, "%s was not recorded at %dx%d.\n", opt.baseline, opt.width, opt.height);
+        free(baseline);
+        return 2;
+    }
+
+    char log[1024];
+    if (!CreateHeadlessContext(log, sizeof(log))) {
+        fprintf(stderr, "Could not initialize OpenGL: %s\n", log);
+        free(baseline);
+        return 1;
+    }
+    char renderer[256], base_renderer[256];
+    snprintf(renderer, sizeof(renderer), "%s", (const char*)glGetString(GL_RENDERER));
+    BaselineRenderer(baseline, base_renderer, sizeof(base_renderer));
+    printf("GL: %s | %s\n", renderer, (const char*)glGetString(GL_VERSION));
+    if (baseline && strcmp(renderer, base_renderer))
+        printf("note: the baseline was recorded on \"%s\"\n", base_renderer);
+
+    IncludeCache* includes = IncludeCacheCreate();
+    SetIncludeCache(includes);
+    RenderTarget rt;
+    BenchResult* results = (BenchResult*)calloc((size_t)s_name_count, sizeof(BenchResult));
+    double* samples = (double*)malloc((size_t)opt.frames * (size_t)opt.runs * sizeof(double));
+    if (!results || !samples || !CreateRenderTarget(&rt, opt.width, opt.height, GL_RGBA8)) {
+        fprintf(stderr, "Could not set up a %dx%d benchmark.\n", opt.width, opt.height);
+        free(samples); free(results); free(baseline);
+        SetIncludeCache(NULL); IncludeCacheDestroy(includes);
+        DestroyHeadlessContext();
+        return 1;
+    }
+    GLuint tex = CreateNoiseTexture();
+    g_app.frame_uniforms = FrameUniformsCreate();
+    g_app.gpu_timer = GpuTimerCreate();
+    g_app.width = opt.width; g_app.height = opt.height;
+    CreateFullscreenQuad(); // aPos/aUV at 0/1, as shader.vert declares them
+
+    printf("%d shaders @ %dx%d, best of %d runs x %d frames (+%d warmup) at uTime %g\n",
+           s_name_count, opt.width, opt.height, opt.runs, opt.frames, opt.warmup, opt.time);
+    int failed = 0;
+    for (int i = 0; i < s_name_count; ++i) {
+        BenchResult* r = &results[i];
+        snprintf(r->name, sizeof(r->name), "%s", s_names[i]);
+        r->status = "ok";
+        r->baseline_ms = BaselineScore(baseline, r->name);
+        BenchShader(&opt, rt.fbo, samples, r);
+        if (!r->built) { ++failed; continue; }
+
+        char verdict[96] = "";
+        if (baseline && r->baseline_ms < 0.0) {
+            r->status = "new";
+            snprintf(verdict, sizeof(verdict), "  (not in the baseline)");
+        } else if (baseline) {
+            double limit = r->baseline_ms * (1.0 + opt.tolerance) + BENCH_SLACK_MS;
+            if (r->score_ms > limit) { r->status = "slower"; ++failed; }
+            snprintf(verdict, sizeof(verdict), "  baseline %.3f, %+.1f%%%s", r->baseline_ms,
+                     r->baseline_ms > 0.0 ? (r->score_ms / r->baseline_ms - 1.0) * 100.0 : 0.0,
+                     r->score_ms > limit ? "  SLOWER" : "");
+        }
+        printf("%-12s score %8.3f ms  (median %.3f  p95 %.3f  p99 %.3f, gpu %.3f)%s\n", r->name, r->score_ms,
+               r->wall.median_ms, r->wall.p95_ms, r->wall.p99_ms, r->gpu_median_ms, verdict);
+        fflush(stdout);
+    }
+    if (baseline) printf("%s: %d of %d over the baseline + %.0f%% (or failed to build)\n",
+                         failed ? "FAIL" : "PASS", failed, s_name_count, opt.tolerance * 100.0);
+    if (opt.out[0] && !WriteJson(opt.out, &opt, renderer, results, s_name_count)) {
+        fprintf(stderr, "Could not write %s.\n", opt.out);
+        failed = failed ? failed : 1;
+    }
+
+    if (tex) glDeleteTextures(1, &tex);
+    if (g_app.program) { glDeleteProgram(g_app.program); g_app.program = 0; }
+    if (g_app.vbo) { glDeleteBuffers(1, &g_app.vbo); g_app.vbo = 0; }
+    if (g_app.vao) { glDeleteVertexArrays(1, &g_app.vao); g_app.vao = 0; }
+    GpuTimerDestroy(g_app.gpu_timer); g_app.gpu_timer = NULL;
+    FrameUniformsDestroy(g_app.frame_uniforms); g_app.frame_uniforms = NULL;
+    DestroyRenderTarget(&rt);
+    free(samples);
+    free(results);
+    free(baseline);
+    SetIncludeCache(NULL);
+    IncludeCacheDestroy(includes);
+    DestroyHeadlessContext();
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,1042 @@
+// main_headless.c — surfaceless EGL front end for Linux build/CI boxes (no window, no GPU needed)
+//
+// Renders the same shader.vert/shader.frag quad as the Win32 playground into an
+// offscreen FBO for N frames and reports min/median/p99 frame time.
+// Other modes (--watch, --offline, --tune, --cpu, --cost, ...) replace the benchmark
+// loop; PrintUsage lists the options and README.md describes them, with the details in
+// the header of the module each one drives.
+//
+// Usage: shaderdevel [options] [vert frag | comp]
+// Defaults: 300 frames, 10 warmup, 1280x720, src/shader.vert src/shader.frag
+
+#include "platform.h"
+#include "app.h"
+#include "shader.h"
+#include "headless.h"
+#include "headless_context.h"
+#include "render_target.h"
+#include "cpu_render.h"
+#include "image_read.h"
+#include "image_write.h"
+#include "offline.h"
+#include "scheduler.h"
+#include "profiler.h"
+#include "variants.h"
+
+#include <math.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define WATCH_MAX_SAMPLES 100000
+
+static volatile sig_atomic_t g_interrupted = 0;
+static void OnInterrupt(int sig) { (void)sig; g_interrupted = 1; }
+
+static void PrintUsage(const char* exe) {
+    fprintf(stderr, "Usage: %s [--frames N] [--warmup N] [--size WxH] [--watch]\n"
+                    "          [--on-demand] [--fps-cap N] [--no-cache] [--cache-dir DIR] [--gpu-csv FILE]\n"
+                    "          [--dynres TARGET_MS] [--graph FILE] [--params FILE] [--texture-budget MB]\n"
+                    "          [--grid PATH]... [--grid-budget MS]\n"
+                    "          [--progressive BUDGET_MS] [--progressive-tile N] [--accumulate N]\n"
+                    "          [--capture FILE] [--capture-fps N] [--telemetry ENDPOINT]\n"
+                    "          [--profile FILE] [--profile-seconds N] [--frames-in-flight N]\n"
+                    "          [--offline PATTERN] [--fps F] [--start N] [--tile N]\n"
+                    "          [--shard I/N] [--shard-tiles] [--jobs N]\n"
+                    "          [--tune FILE] [--tune-min-psnr DB] [--variant DEFS] [--local-size-sweep]\n"
+                    "          [--cpu] [--threads N] [--time T] [--out FILE] [--reference FILE] [--min-psnr DB]\n"
+                    "          [--cost] [--cost-lines N] [vert frag | comp]\n", exe);
+}
+
+typedef struct {
+    bool watch;
+    SchedulerOptions sched;       // --watch pacing
+    bool no_cache;
+    char cache_dir[APP_PATH_MAX]; // empty = default
+    char gpu_csv[APP_PATH_MAX];   // empty = no CSV
+    double dynres_ms;             // 0 = full resolution
+    char graph[APP_PATH_MAX];     // empty = single pass
+    const char* grid[SHADER_GRID_MAX_TILES]; // --grid paths (argv), none = no grid
+    int grid_count;
+    double grid_budget_ms;        // 0 = default
+    char params[APP_PATH_MAX];    // empty = no user parameter file
+    int texture_budget_mb;        // 0 = default
+    double progressive_ms;        // 0 = whole frames
+    int progressive_tile;         // 0 = default
+    int accumulate;               // samples of the paused still, 0 = time runs
+    char capture[APP_PATH_MAX];   // empty = no capture, "-" = stdout
+    int capture_fps;
+    char telemetry[APP_PATH_MAX]; // endpoint, empty = none
+    char profile[APP_PATH_MAX];   // Chrome trace written at exit, empty = none
+    double profile_seconds;       // 0 = default
+    int frames_in_flight;         // 0 = glFinish every frame
+    OfflineOptions offline;       // pattern empty = no offline render
+    int jobs;                     // offline child processes, 0 = render in this one
+    char tune[APP_PATH_MAX];      // variant sidecar, empty = no tuning
+    double tune_min_psnr;
+    char variant[512];            // --variant defines, empty = none
+    bool local_size_sweep;        // tune a compute shader's workgroup shape
+    bool cpu;
+    int threads;                  // --cpu workers, 0 = one per CPU
+    double time;                  // --cpu uTime
+    char out[APP_PATH_MAX];       // empty = no image
+    char reference[APP_PATH_MAX]; // --cpu image to compare against, empty = none
+    double min_psnr;              // --reference below this fails, 0 = report only
+    bool cost;
+    int cost_lines;               // 0 = default
+} CliOptions;
+
+static bool ParseArgs(int argc, char** argv, HeadlessOptions* opt, CliOptions* cli) {
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (!strcmp(a, "--watch")) {
+            cli->watch = true;
+        } else if (!strcmp(a, "--on-demand")) {
+            cli->sched.on_demand = true;
+        } else if (!strcmp(a, "--fps-cap") && i + 1 < argc) {
+            cli->sched.fps_cap = atof(argv[++i]);
+            if (cli->sched.fps_cap <= 0.0) return false;
+        } else if (!strcmp(a, "--no-cache")) {
+            cli->no_cache = true;
+        } else if (!strcmp(a, "--cache-dir") && i + 1 < argc) {
+            snprintf(cli->cache_dir, APP_PATH_MAX, "%s", argv[++i]);
+        } else if (!strcmp(a, "--gpu-csv") && i + 1 < argc) {
+            snprintf(cli->gpu_csv, APP_PATH_MAX, "%s", argv[++i]);
+        } else if (!strcmp(a, "--dynres") && i + 1 < argc) {
+            cli->dynres_ms = atof(argv[++i]);
+            if (cli->dynres_ms <= 0.0) return false;
+        } else if (!strcmp(a, "--graph") && i + 1 < argc) {
+            snprintf(cli->graph, APP_PATH_MAX, "%s", argv[++i]);
+        } else if (!strcmp(a, "--grid") && i + 1 < argc) {
+            if (cli->grid_count == SHADER_GRID_MAX_TILES) return false;
+            cli->grid[cli->grid_count++] = argv[++i];
+        } else if (!strcmp(a, "--grid-budget") && i + 1 < argc) {
+            cli->grid_budget_ms = atof(argv[++i]);
+            if (cli->grid_budget_ms <= 0.0) return false;
+        } else if (!strcmp(a, "--params") && i + 1 < argc) {
+            snprintf(cli->params, APP_PATH_MAX, "%s", argv[++i]);
+        } else if (!strcmp(a, "--texture-budget") && i + 1 < argc) {
+            cli->texture_budget_mb = atoi(argv[++i]);
+            if (cli->texture_budget_mb <= 0) return false;
+        } else if (!strcmp(a, "--progressive") && i + 1 < argc) {
+            cli->progressive_ms = atof(argv[++i]);
+            if (cli->progressive_ms <= 0.0) return false;
+        } else if (!strcmp(a, "--progressive-tile") && i + 1 < argc) {
+            cli->progressive_tile = atoi(argv[++i]);
+            if (cli->progressive_tile < PROGRESSIVE_MIN_TILE) return false;
+        } else if (!strcmp(a, "--accumulate") && i + 1 < argc) {
+            cli->accumulate = atoi(argv[++i]);
+            if (cli->accumulate <= 0) return false;
+        } else if (!strcmp(a, "--capture") && i + 1 < argc) {
+            snprintf(cli->capture, APP_PATH_MAX, "%s", argv[++i]);
+        } else if (!strcmp(a, "--capture-fps") && i + 1 < argc) {
+            cli->capture_fps = atoi(argv[++i]);
+            if (cli->capture_fps <= 0) return false;
+        } else if (!strcmp(a, "--offline") && i + 1 < argc) {
+            snprintf(cli->offline.pattern, APP_PATH_MAX, "%s", argv[++i]);
+        } else if (!strcmp(a, "--fps") && i + 1 < argc) {
+            cli->offline.fps = atof(argv[++i]);
+            if (cli->offline.fps <= 0.0) return false;
+        } else if (!strcmp(a, "--start") && i + 1 < argc) {
+            cli->offline.first = atoi(argv[++i]);
+            if (cli->offline.first < 0) return false;
+        } else if (!strcmp(a, "--tile") && i + 1 < argc) {
+            cli->offline.tile = atoi(argv[++i]);
+            if (cli->offline.tile <= 0) return false;
+        } else if (!strcmp(a, "--shard") && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d/%d", &cli->offline.shard, &cli->offline.shards) != 2) return false;
+            if (cli->offline.shards < 1 || cli->offline.shard < 0 || cli->offline.shard >= cli->offline.shards) return false;
+        } else if (!strcmp(a, "--shard-tiles")) {
+            cli->offline.shard_tiles = true;
+        } else if (!strcmp(a, "--jobs") && i + 1 < argc) {
+            cli->jobs = atoi(argv[++i]);
+            if (cli->jobs <= 0) return false;
+        } else if (!strcmp(a, "--tune") && i + 1 < argc) {
+            snprintf(cli->tune, APP_PATH_MAX, "%s", argv[++i]);
+        } else if (!strcmp(a, "--tune-min-psnr") && i + 1 < argc) {
+            cli->tune_min_psnr = atof(argv[++i]);
+            if (cli->tune_min_psnr <= 0.0) return false;
+        } else if (!strcmp(a, "--variant") && i + 1 < argc) {
+            snprintf(cli->variant, sizeof(cli->variant), "%s", argv[++i]);
+        } else if (!strcmp(a, "--local-size-sweep")) {
+            cli->local_size_sweep = true;
+        } else if (!strcmp(a, "--cpu")) {
+            cli->cpu = true;
+        } else if (!strcmp(a, "--threads") && i + 1 < argc) {
+            cli->threads = atoi(argv[++i]);
+            if (cli->threads <= 0) return false;
+        } else if (!strcmp(a, "--time") && i + 1 < argc) {
+            cli->time = atof(argv[++i]);
+        } else if (!strcmp(a, "--out") && i + 1 < argc) {
+            snprintf(cli->out, APP_PATH_MAX, "%s", argv[++i]);
+        } else if (!strcmp(a, "--reference") && i + 1 < argc) {
+            snprintf(cli->reference, APP_PATH_MAX, "%s", argv[++i]);
+        } else if (!strcmp(a, "--min-psnr") && i + 1 < argc) {
+            cli->min_psnr = atof(argv[++i]);
+            if (cli->min_psnr <= 0.0) return false;
+        } else if (!strcmp(a, "--telemetry") && i + 1 < argc) {
+            snprintf(cli->telemetry, APP_PATH_MAX, "%s", argv[++i]);
+        } else if (!strcmp(a, "--profile") && i + 1 < argc) {
+            snprintf(cli->profile, APP_PATH_MAX, "%s", argv[++i]);
+        } else if (!strcmp(a, "--profile-seconds") && i + 1 < argc) {
+            cli->profile_seconds = atof(argv[++i]);
+            if (cli->profile_seconds <= 0.0) return false;
+        } else if (!strcmp(a, "--frames-in-flight") && i + 1 < argc) {
+            cli->frames_in_flight = atoi(argv[++i]);
+            if (cli->frames_in_flight < 1 || cli->frames_in_flight > FRAME_PACER_MAX_IN_FLIGHT) return false;
+        } else if (!strcmp(a, "--cost")) {
+            cli->cost = true;
+        } else if (!strcmp(a, "--cost-lines") && i + 1 < argc) {
+            cli->cost_lines = atoi(argv[++i]);
+            if (cli->cost_lines <= 0) return false;
+        } else if (!strcmp(a, "--frames") && i + 1 < argc) {
+            opt->frames = atoi(argv[++i]);
+        } else if (!strcmp(a, "--warmup") && i + 1 < argc) {
+            opt->warmup_frames = atoi(argv[++i]);
+        } else if (!strcmp(a, "--size") && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &opt->width, &opt->height) != 2) return false;
+        } else if (a[0] == '-' && a[1] == '-') {
+            return false;
+        } else if (positional < 2 && IsComputeShaderPath(a)) {
+            snprintf(g_app.frag_path, APP_PATH_MAX, "%s", a); positional = 2; // no vertex shader
+        } else if (positional == 0) {
+            snprintf(g_app.vert_path, APP_PATH_MAX, "%s", a); ++positional;
+        } else if (positional == 1) {
+            snprintf(g_app.frag_path, APP_PATH_MAX, "%s", a); ++positional;
+        } else {
+            return false;
+        }
+    }
+    if (!cli->cpu && (cli->threads || cli->out[0] || cli->reference[0])) return false;
+    if (cli->min_psnr > 0.0 && !cli->reference[0]) return false;
+    if (cli->cpu && (cli->watch || cli->graph[0] || cli->dynres_ms > 0.0 || cli->gpu_csv[0] || cli->capture[0])) return false;
+    if (cli->capture_fps && !cli->capture[0]) return false;
+    if (!cli->watch && (cli->sched.on_demand || cli->sched.fps_cap > 0.0)) return false;
+    OfflineOptions* off = &cli->offline;
+    if (!off->pattern[0] && (off->fps > 0.0 || off->first || off->tile || off->shards || off->shard_tiles || cli->jobs)) return false;
+    if (off->pattern[0] && (cli->watch || cli->cpu || cli->graph[0] || cli->dynres_ms > 0.0 || cli->capture[0])) return false;
+    if (cli->jobs && off->shards) return false;
+    bool tuning = cli->tune[0] || cli->local_size_sweep;
+    if (!tuning && cli->tune_min_psnr > 0.0) return false;
+    if (tuning && (cli->watch || cli->cpu || cli->graph[0] || cli->dynres_ms > 0.0 || cli->capture[0] ||
+                   off->pattern[0] || cli->variant[0])) return false;
+    if (!cli->cost && cli->cost_lines) return false;
+    if (cli->cost && (cli->watch || cli->cpu || cli->graph[0] || tuning || off->pattern[0] || cli->capture[0] ||
+                      cli->dynres_ms > 0.0)) return false;
+    if (cli->grid_budget_ms > 0.0 && !cli->grid_count) return false;
+    if (cli->grid_count && (cli->cpu || cli->graph[0] || cli->dynres_ms > 0.0 || cli->progressive_ms > 0.0 ||
+                            cli->accumulate || tuning || off->pattern[0] || cli->cost)) return false;
+    if (cli->telemetry[0] && (cli->cpu || off->pattern[0] || tuning || cli->cost)) return false;
+    if (cli->profile_seconds > 0.0 && !cli->profile[0]) return false;
+    if (cli->frames_in_flight && (cli->cpu || cli->cost || tuning || off->pattern[0])) return false;
+    if (cli->profile[0] && (cli->cpu || cli->cost || cli->jobs)) return false;
+    if (cli->progressive_tile && cli->progressive_ms <= 0.0) return false;
+    if (cli->progressive_ms > 0.0 && (cli->cpu || cli->graph[0] || cli->dynres_ms > 0.0 || tuning ||
+                                      off->pattern[0] || cli->cost)) return false;
+    if (cli->accumulate && (cli->cpu || cli->graph[0] || cli->dynres_ms > 0.0 || cli->progressive_ms > 0.0 ||
+                            tuning || off->pattern[0] || cli->cost)) return false;
+    bool compute = IsComputeShaderPath(g_app.frag_path);
+    if (compute && (cli->cpu || cli->graph[0] || cli->grid_count || cli->progressive_ms > 0.0)) return false;
+    if (cli->local_size_sweep && (!compute || cli->tune[0])) return false;
+    return opt->frames > 0 && opt->warmup_frames >= 0 && opt->width > 0 && opt->height > 0;
+}
+
+static void PrintGpuStats(const char* prefix) {
+    FrameStats gpu;
+    if (!g_app.gpu_timer) return;
+    GpuTimerCollect(g_app.gpu_timer, true);
+    if (!GpuTimerGetStats(g_app.gpu_timer, &gpu)) return;
+    printf("%sgpu ms: mean %.3f  p50 %.3f  p95 %.3f  p99 %.3f  (%d frames)\n",
+           prefix, gpu.mean_ms, gpu.median_ms, gpu.p95_ms, gpu.p99_ms, gpu.frames);
+    if (g_app.dynres)
+        printf("%sdynres scale %.2f, scene %dx%d\n", prefix, g_app.dynres->scale, g_app.render_width, g_app.render_height);
+}
+
+static void PrintProgressiveStats(const char* prefix) {
+    const ProgressiveRender* p = g_app.progressive;
+    if (!p) return;
+    if (!p->passes) {
+        printf("%sprogressive: no pass finished, %.0f%% of the first drawn, %d px tiles\n",
+               prefix, ProgressiveProgress(p) * 100.0, p->tile);
+        return;
+    }
+    printf("%sprogressive: %d passes, last %.2f s (%.1f ms GPU) in %d tiles of up to %d px\n", prefix,
+           p->passes, p->last_pass_seconds, p->last_pass_gpu_ms, p->last_pass_tiles, p->tile);
+}
+
+static void PrintStill(const char* prefix) {
+    const TemporalAccumulation* a = g_app.accum;
+    if (!a) return;
+    if (AccumDone(a)) printf("%sstill: %d samples in %.2f s\n", prefix, a->samples, a->done_seconds);
+    else printf("%sstill: %d of %d samples\n", prefix, a->samples, a->max_samples);
+}
+
+// Per tile: smoothed GPU time of one draw and how often it drew with its current program.
+static void PrintGridStats(const char* prefix) {
+    ShaderGrid* g = g_app.grid;
+    if (!g) return;
+    printf("%sgrid %dx%d of %dx%d cells, budget %.1f ms, last frame %d tiles (~%.2f ms)\n", prefix, g->cols, g->rows,
+           g->cell_width, g->cell_height, g->budget_ms, g->tiles_drawn, g->planned_ms);
+    for (int i = 0; i < g->count; ++i) {
+        const GridTile* t = &g->tile[i];
+        uint64_t frames = g->frame - t->since;
+        if (!t->program) { printf("%s  %-32s not built\n", prefix, t->name); continue; }
+        printf("%s  %-32s gpu %8.3f ms  every %2d frames  drew %5.1f%%\n", prefix, t->name, t->gpu_ms, t->interval,
+               frames ? 100.0 * (double)t->draws / (double)frames : 0.0);
+    }
+}
+
+static void PrintLocalSize(const char* prefix) {
+    if (!g_app.compute) return;
+    const int* ls = g_app.compute->local_size;
+    printf("%scompute local size %dx%d (%d invocations per workgroup)\n", prefix, ls[0], ls[1], ls[0] * ls[1] * ls[2]);
+}
+
+static void PrintUserUniforms(const char* prefix, GLuint prog) {
+    static UserUniforms uu;
+    if (!prog || ReflectUserUniforms(prog, &uu) == 0) return;
+    printf("%suser uniforms:", prefix);
+    for (int i = 0; i < uu.count; ++i) {
+        if (uu.u[i].size > 1) printf(" %s %s[%d]", UniformTypeName(uu.u[i].type), uu.u[i].name, uu.u[i].size);
+        else                  printf(" %s %s", UniformTypeName(uu.u[i].type), uu.u[i].name);
+    }
+    printf("\n");
+}
+
+static void PrintLines(const char* prefix, char* text) {
+    for (char* line = text; *line;) {
+        char* end = strchr(line, '\n');
+        if (end) *end = 0;
+        printf("%s%s\n", prefix, line);
+        if (!end) break;
+        line = end + 1;
+    }
+}
+
+// The static cost of a program's fragment shader and what changed since the last one.
+static void PrintShaderCost(const char* prefix, int tag) {
+    char text[4096];
+    UpdateShaderCost(tag, text, sizeof(text));
+    PrintLines(prefix, text);
+}
+
+// Texture loads finished since the last call; true if there were any.
+static bool PrintTextureLoads(const char* prefix) {
+    char text[4096];
+    if (!UpdateTextures(text, sizeof(text))) return false;
+    PrintLines(prefix, text);
+    return true;
+}
+
+static void PrintTextureStats(void) {
+    TextureCacheStats st;
+    if (!g_app.textures) return;
+    TextureCacheGetStats(g_app.textures, &st);
+    if (!st.loads && !st.hits) return;
+    printf("textures: %d loaded (%d failed, %.1f ms total), %d cache hits, %d evicted, %.1f of %.0f MB resident\n",
+           st.loads, st.failures, st.total_load_ms, st.hits, st.evictions,
+           (double)st.resident_bytes / (1 << 20), (double)st.budget_bytes / (1 << 20));
+}
+
+static void PrintPacerStats(const char* prefix) {
+    FramePacerStats ps;
+    if (!g_app.pacer || !FramePacerGetStats(g_app.pacer, &ps)) return;
+    char how[64];
+    FramePacerDescribe(g_app.pacer, how, sizeof(how));
+    printf("%sinput to present ms (%s): p50 %.3f  p95 %.3f  p99 %.3f  (%d frames)\n",
+           prefix, how, ps.latency.median_ms, ps.latency.p95_ms, ps.latency.p99_ms, ps.latency.frames);
+    printf("%sfence wait %.3f ms/frame\n", prefix, ps.wait_ms);
+}
+
+static void PrintVersionStats(int version, const double* samples, int count) {
+    if (count <= 0) return;
+    FrameStats stats;
+    ComputeFrameStats(samples, count, &stats);
+    printf("v%d: %d frames, ms min %.3f  median %.3f  p99 %.3f\n",
+           version, stats.frames, stats.min_ms, stats.median_ms, stats.p99_ms);
+    char prefix[32];
+    snprintf(prefix, sizeof(prefix), "v%d: ", version);
+    PrintGpuStats(prefix);
+    PrintPacerStats(prefix);
+}
+
+static void PrintSchedulerStats(FrameScheduler* sched, const SchedulerOptions* so) {
+    SchedulerStats st;
+    FrameSchedulerTakeStats(sched, &st);
+    FrameStats gpu;
+    double gpu_percent = 0.0;
+    if (g_app.gpu_timer && GpuTimerGetStats(g_app.gpu_timer, &gpu) && st.seconds > 0.0)
+        gpu_percent = gpu.mean_ms * st.frames / (st.seconds * 10.0); // mean of the last version's window
+    char cap[32] = "uncapped";
+    if (so->fps_cap > 0.0) snprintf(cap, sizeof(cap), "capped at %g fps", so->fps_cap);
+    printf("%s, %s: %d frames in %.1f s (%.1f fps), cpu %.1f%%  gpu ~%.1f%%  idle %.1f%%\n",
+           FrameSchedulerModeName(sched), cap, st.frames, st.seconds, st.seconds > 0.0 ? st.frames / st.seconds : 0.0,
+           st.cpu_percent, gpu_percent, st.idle_percent);
+}
+
+// Renders continuously (or on demand, see scheduler.h); file changes go through the
+// watcher + async compiler the same way the Win32 loop does, so reload latency can be
+// measured without a window.
+static int RunWatchMode(const HeadlessOptions* opt, const SchedulerOptions* so) {
+    RenderTarget rt;
+    if (!CreateRenderTarget(&rt, opt->width, opt->height, GL_RGBA8)) {
+        fprintf(stderr, "Could not create a %dx%d offscreen framebuffer.\n", opt->width, opt->height);
+        return 1;
+    }
+    g_app.width = opt->width; g_app.height = opt->height;
+    g_app.watcher = FileWatcherCreate(50);
+    if (!g_app.watcher) { fprintf(stderr, "Could not start the file watcher.\n"); DestroyRenderTarget(&rt); return 1; }
+    WatchShaderFiles();
+    g_app.params_watch = GetUserParams() ? FileWatcherAddFile(g_app.watcher, GetUserParams()->path) : -1;
+    g_app.compiler = ShaderCompilerCreate(CreateHeadlessWorkerContext() ? BindHeadlessWorkerContext : NULL, NULL);
+    FrameScheduler* sched = g_app.compiler ? FrameSchedulerCreate(so) : NULL;
+    if (!sched) {
+        fprintf(stderr, "Could not create the %s.\n", g_app.compiler ? "frame scheduler" : "shader compiler");
+        ShaderCompilerDestroy(g_app.compiler);
+        FileWatcherDestroy(g_app.watcher);
+        DestroyRenderTarget(&rt);
+        return 1;
+    }
+    FileWatcherSetNotify(g_app.watcher, FrameSchedulerNotify, sched);
+    ShaderCompilerSetNotify(g_app.compiler, FrameSchedulerNotify, sched);
+    TextureCacheSetNotify(g_app.textures, FrameSchedulerNotify, sched);
+    if (g_app.compute)
+        printf("watching %s (compile: %s), Ctrl-C to stop\n", g_app.frag_path, CompilerModeName(ShaderCompilerGetMode(g_app.compiler)));
+    else
+        printf("watching %s + %s (compile: %s), Ctrl-C to stop\n", g_app.vert_path,
+               g_app.graph ? g_app.graph->path : g_app.grid ? "grid" : g_app.frag_path, CompilerModeName(ShaderCompilerGetMode(g_app.compiler)));
+    for (int i = 0; i < ProgramCount(); ++i) {
+        char prefix[96];
+        if (g_app.graph || g_app.grid) snprintf(prefix, sizeof(prefix), "v0: %s: ", ProgramName(i));
+        else snprintf(prefix, sizeof(prefix), "v0: ");
+        PrintShaderCost(prefix, i);
+    }
+    fflush(stdout);
+
+    signal(SIGINT, OnInterrupt);
+    signal(SIGTERM, OnInterrupt);
+    static CompileResult result;
+    double* samples = (double*)malloc(WATCH_MAX_SAMPLES * sizeof(double));
+    int count = 0, version = 0, passes = 0;
+    bool still_done = false;
+    g_app.start_seconds = NowSeconds();
+    while (!g_interrupted) {
+        double changed_at = 0.0;
+        PROFILE_BEGIN("hot reload");
+        if (FileWatcherPoll(g_app.watcher, &changed_at)) {
+            char plog[512];
+            if (ReloadChangedParams(plog, sizeof(plog))) {
+                printf("v%d: parameters %s%s\n", version, plog[0] ? "kept, " : "reloaded", plog);
+                FrameSchedulerInvalidate(sched);
+            }
+            SubmitChangedPrograms(false, changed_at);
+        }
+        char prefix[32];
+        snprintf(prefix, sizeof(prefix), "v%d: ", version);
+        if (PrintTextureLoads(prefix)) { fflush(stdout); FrameSchedulerInvalidate(sched); }
+        while (ShaderCompilerPoll(g_app.compiler, &result)) {
+            const char* what = ProgramName(result.tag);
+            if (result.program) {
+                PrintVersionStats(version++, samples, count); // before the GPU timer restarts
+                count = 0;
+            }
+            if (ApplyCompileResult(&result)) {
+                FrameSchedulerInvalidate(sched);
+                if (result.unchanged) {
+                    printf("v%d: %s unchanged, reload skipped (%d so far)\n", version, what, g_app.reloads_skipped);
+                    fflush(stdout);
+                    continue;
+                }
+                if (g_app.graph) printf("v%d: rebuilt pass %s\n", version, what);
+                if (g_app.grid) printf("v%d: rebuilt tile %s\n", version, what);
+                if (result.cache_hit) printf("v%d: program binary cache hit\n", version);
+                else printf("v%d: compiled %d of %d stages\n", version, result.stages_compiled, g_app.compute ? 1 : 2);
+                snprintf(prefix, sizeof(prefix), "v%d: ", version);
+                PrintUserUniforms(prefix, result.program);
+                PrintLocalSize(prefix);
+                PrintShaderCost(prefix, result.tag);
+                g_app.reload_requested_at = result.requested_at;
+            } else {
+                fprintf(stderr, "COMPILE ERROR in %s (still drawing v%d):\n%s\n", what, version, result.log);
+            }
+        }
+        PROFILE_END();
+
+        bool animating = !so->on_demand || SceneNeedsFrames();
+        if (!FrameSchedulerBeginFrame(sched, animating)) {
+            // The timeout only bounds how long a Ctrl-C landing just before the wait goes unseen.
+            PROFILE_BEGIN("FrameSchedulerWait");
+            FrameSchedulerWait(sched, animating, ShaderCompilerNeedsPolling(g_app.compiler) ? 5 : 250);
+            PROFILE_END();
+            continue;
+        }
+        double t0 = NowSeconds();
+        if (g_app.pacer) {
+            PROFILE_BEGIN("FramePacerBeginFrame");
+            FramePacerBeginFrame(g_app.pacer, 0.0);
+            PROFILE_END();
+        }
+        PROFILE_BEGIN("RenderFrame");
+        RenderFrame(so->on_demand ? 0.0f : (float)(NowSeconds() - g_app.start_seconds), rt.fbo);
+        PROFILE_END();
+        if (g_app.pacer) {
+            FramePacerDrawn(g_app.pacer);
+            FramePacerEndFrame(g_app.pacer);
+        } else {
+            PROFILE_BEGIN("glFinish");
+            glFinish();
+            PROFILE_END();
+        }
+        double t1 = NowSeconds();
+        if (g_app.progressive && g_app.progressive->passes != passes) {
+            passes = g_app.progressive->passes;
+            printf("v%d: progressive pass %.2f s, %d tiles\n", version, g_app.progressive->last_pass_seconds,
+                   g_app.progressive->last_pass_tiles);
+            fflush(stdout);
+        }
+        if (g_app.accum && AccumDone(g_app.accum) != still_done) {
+            still_done = !still_done;
+            if (still_done) { PrintStill(prefix); fflush(stdout); }
+        }
+        if (count == WATCH_MAX_SAMPLES) { PrintVersionStats(version, samples, count); count = 0; }
+        samples[count++] = (t1 - t0) * 1000.0;
+        TelemetryFrame(g_app.telemetry_thread, (t1 - t0) * 1000.0);
+
+        if (g_app.reload_requested_at > 0.0) {
+            g_app.last_reload_ms = (t1 - g_app.reload_requested_at) * 1000.0;
+            printf("v%d: OK, reload %.1f ms from file change to first frame\n", version, g_app.last_reload_ms);
+            fflush(stdout);
+            TelemetryReload(g_app.telemetry_thread, g_app.last_reload_ms);
+            g_app.reload_requested_at = 0.0;
+        }
+    }
+    if (g_app.pacer) FramePacerFinish(g_app.pacer);
+    PrintVersionStats(version, samples, count);
+    PrintSchedulerStats(sched, so);
+    PrintProgressiveStats("");
+    PrintStill("");
+    PrintGridStats("");
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    free(samples);
+    ShaderCompilerSetNotify(g_app.compiler, NULL, NULL);
+    FileWatcherSetNotify(g_app.watcher, NULL, NULL);
+    TextureCacheSetNotify(g_app.textures, NULL, NULL);
+    FrameSchedulerDestroy(sched);
+    FileWatcherDestroy(g_app.watcher);
+    ShaderCompilerDestroy(g_app.compiler);
+    DestroyRenderTarget(&rt);
+    FreeShaderCosts();
+    return 0;
+}
+
+// The static cost estimate of the fragment shader; no GL context is created.
+static int RunCostMode(const CliOptions* cli) {
+    static ShaderFileTable files[2];
+    char log[4096];
+    char* vsrc = NULL;
+    char* fsrc = NULL;
+    if (!LoadShaderSources(g_app.vert_path, g_app.frag_path, &vsrc, &fsrc, files, log, sizeof(log))) {
+        fprintf(stderr, "%s\n", log);
+        return 1;
+    }
+    ShaderCostReport report;
+    bool ok = AnalyzeShaderCost(fsrc, &files[1], &report, log, sizeof(log));
+    free(vsrc);
+    free(fsrc);
+    if (!ok) { fprintf(stderr, "%s: %s\n", g_app.frag_path, log); return 1; }
+    printf("%s\n", g_app.frag_path);
+    PrintShaderCostReport(stdout, &report, cli->cost_lines ? cli->cost_lines : 12);
+    FreeShaderCostReport(&report);
+    return 0;
+}
+
+// The last --cpu frame against an image of the same size (the GL render of the same
+// frame, say); false if it can't be read or scores under min_psnr.
+static bool CompareWithReference(const char* path, int width, int height, const uint8_t* rgba, double min_psnr) {
+    char log[256];
+    MappedFile file;
+    ImageInfo info;
+    if (!MapFileReadOnly(path, (size_t)1 << 30, &file)) { fprintf(stderr, "Could not read %s.\n", path); return false; }
+    bool ok = ReadImageInfo(file.data, file.size, &info, log, sizeof(log));
+    if (ok && (info.width != width || info.height != height)) {
+        snprintf(log, sizeof(log), "%dx%d, not the rendered %dx%d", info.width, info.height, width, height);
+        ok = false;
+    }
+    uint8_t* ref = ok ? (uint8_t*)malloc((size_t)width * (size_t)height * 4) : NULL;
+    if (ok && !ref) { snprintf(log, sizeof(log), "out of memory"); ok = false; }
+    ok = ok && DecodeImage(file.data, file.size, &info, ref, true, log, sizeof(log));
+    UnmapFile(&file);
+    if (!ok) { fprintf(stderr, "%s: %s\n", path, log); free(ref); return false; }
+    double psnr;
+    int max_diff;
+    CompareImages(rgba, ref, (size_t)width * (size_t)height, &psnr, &max_diff);
+    free(ref);
+    if (isinf(psnr)) printf("reference %s: identical\n", path);
+    else printf("reference %s: psnr %.2f dB, max difference %d\n", path, psnr, max_diff);
+    if (min_psnr > 0.0 && psnr < min_psnr) {
+        fprintf(stderr, "%s: PSNR below the --min-psnr %.2f dB.\n", path, min_psnr);
+        return false;
+    }
+    return true;
+}
+
+// The fragment shader on the CPU renderer; no GL context is created.
+static int RunCpuMode(const HeadlessOptions* opt, const CliOptions* cli, const UserParams* params) {
+    static char log[4096];
+    static ShaderFileTable files;
+    IncludeCache* includes = IncludeCacheCreate();
+    char* src = NULL;
+    CpuShader* shader = NULL;
+    if (PreprocessShaderFile(includes, g_app.frag_path, &files, &src, log, sizeof(log))) {
+        double t0 = NowSeconds();
+        shader = CpuShaderCompile(src, log, sizeof(log));
+        if (shader) printf("cpu compile %.2f ms\n", (NowSeconds() - t0) * 1000.0);
+        else MapShaderLog(&files, log, sizeof(log));
+    }
+    free(src);
+    IncludeCacheDestroy(includes);
+    if (!shader) { fprintf(stderr, "Initial compile failed:\n%s\n", log); return 1; }
+
+    CpuRenderer* renderer = CpuRendererCreate(cli->threads);
+    uint8_t* rgba = (uint8_t*)malloc((size_t)opt->width * (size_t)opt->height * 4);
+    double* samples = (double*)malloc((size_t)opt->frames * sizeof(double));
+    if (!renderer || !rgba || !samples) {
+        fprintf(stderr, "Out of memory.\n");
+        free(samples); free(rgba); CpuRendererDestroy(renderer); CpuShaderDestroy(shader);
+        return 1;
+    }
+    CpuShaderInfo info;
+    CpuShaderGetInfo(shader, &info);
+    int threads = CpuRendererThreads(renderer);
+    printf("CPU: %s, %d threads | %d instructions, %d registers, %d uniforms\n",
+           info.simd, threads, info.instructions, info.registers, info.uniforms);
+
+    FrameInputs in;
+    memset(&in, 0, sizeof(in));
+    in.resolution[0] = (float)opt->width;
+    in.resolution[1] = (float)opt->height;
+    in.time = (float)cli->time;
+    if (params && params->count) printf("%d user parameters applied\n", CpuShaderSetUniforms(shader, &in, params));
+    int rc = 0;
+    for (int i = 0; i < opt->warmup_frames + opt->frames && rc == 0; ++i) {
+        in.frame = i;
+        CpuShaderSetUniforms(shader, &in, params);
+        double t0 = NowSeconds();
+        if (!CpuRenderFrame(renderer, shader, opt->width, opt->height, rgba)) { fprintf(stderr, "Out of memory.\n"); rc = 1; }
+        if (i >= opt->warmup_frames) samples[i - opt->warmup_frames] = (NowSeconds() - t0) * 1000.0;
+    }
+    if (rc == 0) {
+        FrameStats stats;
+        ComputeFrameStats(samples, opt->frames, &stats);
+        double mpix = (double)opt->width * (double)opt->height / (stats.median_ms * 1000.0);
+        printf("%s @ %dx%d, %d frames (+%d warmup)\n", g_app.frag_path, opt->width, opt->height,
+               opt->frames, opt->warmup_frames);
+        printf("frame ms: min %.3f  median %.3f  p99 %.3f  (mean %.3f, max %.3f)\n",
+               stats.min_ms, stats.median_ms, stats.p99_ms, stats.mean_ms, stats.max_ms);
+        printf("throughput: %.2f Mpix/s, %.2f Mpix/s per thread\n", mpix, mpix / threads);
+        if (cli->out[0]) {
+            if (WriteImage(cli->out, opt->width, opt->height, rgba, false)) printf("wrote %s\n", cli->out);
+            else { fprintf(stderr, "Could not write %s.\n", cli->out); rc = 1; }
+        }
+        if (cli->reference[0] && !CompareWithReference(cli->reference, opt->width, opt->height, rgba, cli->min_psnr)) rc = 1;
+    }
+    free(samples);
+    free(rgba);
+    CpuRendererDestroy(renderer);
+    CpuShaderDestroy(shader);
+    return rc;
+}
+
+// Stops the capture (writing what is still in flight) and reports it; false on a write error.
+static bool FinishCapture(const char* path) {
+    CaptureStats cs;
+    FrameCaptureDestroy(g_app.capture, &cs);
+    g_app.capture = NULL;
+    printf("capture: %llu of %llu frames written to %s (%.1f MB), dropped %llu (gpu %llu, writer %llu, size %llu)\n",
+           (unsigned long long)cs.written, (unsigned long long)cs.grabbed, strcmp(path, "-") ? path : "stdout",
+           (double)cs.bytes / (1024.0 * 1024.0), (unsigned long long)FrameCaptureDropped(&cs),
+           (unsigned long long)cs.dropped_gpu, (unsigned long long)cs.dropped_writer, (unsigned long long)cs.dropped_size);
+    if (cs.write_error) fprintf(stderr, "Capture stopped early: could not write to %s.\n", path);
+    return !cs.write_error;
+}
+
+// Frames (or rows of tiles) rendered to image files at a fixed timestep.
+static int RunOfflineMode(const OfflineOptions* off) {
+    OfflineResult res;
+    char log[512];
+    if (!RunOfflineRender(off, &res, log, sizeof(log))) { fprintf(stderr, "%s\n", log); return 1; }
+    char shard[32] = "";
+    if (off->shards > 1) snprintf(shard, sizeof(shard), "shard %d/%d: ", off->shard, off->shards);
+    printf("%s%d frames (%d tiles of %dx%d) @ %dx%d in %.2f s: %.0f frames/hour\n", shard, res.frames, res.tiles,
+           res.tile_w, res.tile_h, off->width, off->height, res.seconds, res.frames_per_hour);
+    if (res.frames > 0)
+        printf("%sframe ms: min %.3f  median %.3f  p99 %.3f  (mean %.3f, max %.3f)\n", shard,
+               res.stats.min_ms, res.stats.median_ms, res.stats.p99_ms, res.stats.mean_ms, res.stats.max_ms);
+    return 0;
+}
+
+// Every permutation of the sidecar's defines, built and benchmarked (variants.h).
+static int RunTuneMode(const VariantSpace* space, const HeadlessOptions* opt, const CliOptions* cli) {
+    TuneOptions to = { opt->width, opt->height, opt->frames, opt->warmup_frames, (float)cli->time, cli->tune_min_psnr };
+    TuneResult res;
+    char log[COMPILE_LOG_SIZE];
+    printf("tuning %d variants of %s (%s) @ %dx%d, %d frames (+%d warmup) at uTime %.2f\n", VariantCount(space),
+           g_app.frag_path, space->path, opt->width, opt->height, opt->frames, opt->warmup_frames, cli->time);
+    fflush(stdout);
+    if (!RunVariantTuning(space, &to, &res, log, sizeof(log))) {
+        fprintf(stderr, "%s\n", log);
+        FreeTuneResult(&res);
+        return 1;
+    }
+    printf("built %d variants in %.1f ms (%s)\n", res.count, res.compile_ms,
+           res.parallel ? "driver compiles in parallel" : "driver compiles one at a time");
+    printf("rank   gpu p50   gpu p95  wall p50      psnr  variant\n");
+    char defs[512], psnr[16];
+    for (int i = 0; i < res.count; ++i) {
+        const VariantResult* r = &res.v[i];
+        FormatShaderDefines(&r->defines, defs, sizeof(defs));
+        if (!r->ok) { printf("   -  failed: %s: %s\n", defs, r->error); continue; }
+        if (r->reference) snprintf(psnr, sizeof(psnr), "ref");
+        else if (r->psnr < 0.0) snprintf(psnr, sizeof(psnr), "-");
+        else if (isinf(r->psnr)) snprintf(psnr, sizeof(psnr), "exact");
+        else snprintf(psnr, sizeof(psnr), "%.1f dB", r->psnr);
+        printf("%4d  %8.3f  %8.3f  %8.3f  %8s  %s%s\n", i + 1, r->gpu.median_ms, r->gpu.p95_ms, r->wall.median_ms,
+               psnr, defs, i == res.best ? "  <- best" : "");
+    }
+    int rc = 0;
+    if (res.best >= 0) {
+        FormatShaderDefines(&res.v[res.best].defines, defs, sizeof(defs));
+        printf("best: --variant %s\n", defs);
+    } else {
+        fprintf(stderr, "No variant built%s.\n", cli->tune_min_psnr > 0.0 ? " within --tune-min-psnr of the reference" : "");
+        rc = 1;
+    }
+    FreeTuneResult(&res);
+    return rc;
+}
+
+// Re-runs this command line as `jobs` children, each with --shard i/jobs in place of
+// --jobs, and waits for all of them.
+static int RunOfflineJobs(int argc, char** argv, int jobs, int frames) {
+    char** args = (char**)calloc((size_t)argc + 3, sizeof(char*));
+    pid_t* pids = (pid_t*)calloc((size_t)jobs, sizeof(pid_t));
+    if (!args || !pids) { free(pids); free(args); fprintf(stderr, "Out of memory.\n"); return 1; }
+    int n = 0;
+    for (int i = 0; i < argc; ++i) {
+        if (!strcmp(argv[i], "--jobs") && i + 1 < argc) { ++i; continue; }
+        args[n++] = argv[i];
+    }
+    char shard[32];
+    args[n++] = "--shard";
+    args[n++] = shard;
+    args[n] = NULL;
+
+    fflush(stdout);
+    double t0 = NowSeconds();
+    int started = 0, rc = 0;
+    for (; started < jobs; ++started) {
+        snprintf(shard, sizeof(shard), "%d/%d", started, jobs);
+        if (posix_spawn(&pids[started], "/proc/self/exe", NULL, NULL, args, environ) != 0) {
+            fprintf(stderr, "Could not start offline job %d.\n", started);
+            rc = 1;
+            break;
+        }
+    }
+    for (int i = 0; i < started; ++i) {
+        int status = 0;
+        if (waitpid(pids[i], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) rc = 1;
+    }
+    double seconds = NowSeconds() - t0;
+    if (rc == 0)
+        printf("%d jobs: %d frames in %.2f s: %.0f frames/hour\n", jobs, frames, seconds, frames * 3600.0 / seconds);
+    else
+        fprintf(stderr, "An offline job failed.\n");
+    free(pids);
+    free(args);
+    return rc;
+}
+
+static ProgramCache* OpenCache(const CliOptions* cli) {
+    if (cli->no_cache) return NULL;
+    char dir[APP_PATH_MAX + 16], log[256];
+    if (cli->cache_dir[0]) {
+        snprintf(dir, sizeof(dir), "%s", cli->cache_dir);
+    } else {
+        char base[APP_PATH_MAX];
+        if (!GetUserCacheDir(base, sizeof(base))) return NULL;
+        snprintf(dir, sizeof(dir), "%s/programs", base);
+    }
+    ProgramCache* cache = ProgramCacheOpen(dir, PROGRAM_CACHE_DEFAULT_BUDGET, log, sizeof(log));
+    if (!cache) fprintf(stderr, "Program cache disabled: %s\n", log);
+    return cache;
+}
+
+int main(int argc, char** argv) {
+    HeadlessOptions opt = { 1280, 720, 300, 10 };
+    CliOptions cli = { 0 };
+    PROFILE_THREAD("main");
+    snprintf(g_app.vert_path, APP_PATH_MAX, "src/shader.vert");
+    snprintf(g_app.frag_path, APP_PATH_MAX, "src/shader.frag");
+    if (!ParseArgs(argc, argv, &opt, &cli)) { PrintUsage(argv[0]); return 2; }
+    if (cli.offline.pattern[0]) {
+        OfflineOptions* off = &cli.offline;
+        off->width = opt.width;
+        off->height = opt.height;
+        off->count = opt.frames;
+        if (off->fps <= 0.0) off->fps = 60.0;
+        if (off->shards < 1) { off->shard = 0; off->shards = 1; }
+        char log[256];
+        if (!OfflineCheckPattern(off, log, sizeof(log))) { fprintf(stderr, "%s\n", log); return 2; }
+    }
+    // Defines for every build; tuning starts from its reference (or first) variant.
+    static VariantSpace space;
+    ShaderDefines defines = { 0 };
+    if (cli.variant[0] || cli.tune[0] || cli.local_size_sweep) {
+        char log[512];
+        if (cli.variant[0] && !ParseShaderDefines(cli.variant, &defines, log, sizeof(log))) {
+            fprintf(stderr, "--variant: %s\n", log);
+            return 2;
+        }
+        if (cli.tune[0] || cli.local_size_sweep) {
+            if (cli.local_size_sweep) LocalSizeVariantSpace(&space);
+            else if (!LoadVariantSpace(cli.tune, &space, log, sizeof(log))) { fprintf(stderr, "%s\n", log); return 2; }
+            int ref = VariantReferenceIndex(&space);
+            VariantDefines(&space, ref >= 0 ? ref : 0, &defines);
+        }
+        SetShaderDefines(&defines);
+    }
+
+    char logbuf[4096];
+    static UserParams params;
+    if (cli.params[0]) {
+        if (LoadUserParams(cli.params, &params, logbuf, sizeof(logbuf))) SetUserParams(&params);
+        else fprintf(stderr, "Parameters ignored: %s\n", logbuf);
+    }
+    bool capture_y4m = false;
+    FILE* capture_out = NULL;
+    if (cli.capture[0] && !(capture_out = CaptureOpenStream(cli.capture, &capture_y4m))) {
+        fprintf(stderr, "Could not open %s for writing.\n", strcmp(cli.capture, "-") ? cli.capture : "stdout");
+        SetUserParams(NULL);
+        return 1;
+    }
+    if (cli.jobs) {
+        int rc = RunOfflineJobs(argc, argv, cli.jobs, opt.frames);
+        SetUserParams(NULL);
+        return rc;
+    }
+    if (cli.cost) {
+        int rc = RunCostMode(&cli);
+        SetUserParams(NULL);
+        return rc;
+    }
+    if (cli.cpu) {
+        int rc = RunCpuMode(&opt, &cli, GetUserParams());
+        SetUserParams(NULL);
+        return rc;
+    }
+    if (!CreateHeadlessContext(logbuf, sizeof(logbuf))) {
+        fprintf(stderr, "Could not initialize OpenGL: %s\n", logbuf);
+        if (capture_out) fclose(capture_out);
+        return 1;
+    }
+    printf("GL: %s | %s\n", (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+
+    ProgramCache* cache = OpenCache(&cli);
+    SetProgramCache(cache);
+    IncludeCache* includes = IncludeCacheCreate();
+    SetIncludeCache(includes);
+    StageCache* stages = StageCacheCreate(STAGE_CACHE_DEFAULT_CAPACITY);
+    SetStageCache(stages);
+    static ComputePass compute;
+    if (IsComputeShaderPath(g_app.frag_path)) {
+        if (!ComputePassInit(&compute, logbuf, sizeof(logbuf))) {
+            fprintf(stderr, "%s\n", logbuf);
+            if (capture_out) fclose(capture_out);
+            SetStageCache(NULL);
+            StageCacheDestroy(stages);
+            SetIncludeCache(NULL);
+            IncludeCacheDestroy(includes);
+            SetProgramCache(NULL);
+            ProgramCacheClose(cache);
+            DestroyHeadlessContext();
+            return 1;
+        }
+        g_app.compute = &compute;
+    }
+
+    GLuint prog = 0;
+    BuildInfo info = {0};
+    double build_t0 = NowSeconds();
+    bool built;
+    if (cli.graph[0]) {
+        g_app.graph = RenderGraphLoad(cli.graph, logbuf, sizeof(logbuf));
+        built = g_app.graph && RenderGraphBuildPrograms(g_app.graph, g_app.vert_path, logbuf, sizeof(logbuf));
+    } else if (cli.grid_count) {
+        double budget = cli.grid_budget_ms > 0.0 ? cli.grid_budget_ms : SHADER_GRID_DEFAULT_BUDGET_MS;
+        g_app.grid = ShaderGridLoad(cli.grid, cli.grid_count, budget, logbuf, sizeof(logbuf));
+        built = g_app.grid && ShaderGridBuildPrograms(g_app.grid, g_app.vert_path, logbuf, sizeof(logbuf)) > 0;
+        if (built && logbuf[0]) fprintf(stderr, "Grid tiles that did not build:\n%s", logbuf); // they show black
+    } else {
+        built = LoadAndBuildProgramFromFiles(g_app.vert_path, g_app.frag_path, &prog, &info, logbuf, sizeof(logbuf));
+    }
+    if (!built) {
+        RenderGraphDestroy(g_app.graph); g_app.graph = NULL;
+        ShaderGridDestroy(g_app.grid); g_app.grid = NULL;
+        fprintf(stderr, "Initial compile failed:\n%s\n", logbuf[0] ? logbuf : "Could not build shaders.");
+        if (capture_out) fclose(capture_out);
+        if (g_app.compute) { ComputePassShutdown(g_app.compute); g_app.compute = NULL; }
+        SetStageCache(NULL);
+        StageCacheDestroy(stages);
+        SetIncludeCache(NULL);
+        IncludeCacheDestroy(includes);
+        SetProgramCache(NULL);
+        ProgramCacheClose(cache);
+        DestroyHeadlessContext();
+        return 1;
+    }
+    if (g_app.graph) {
+        printf("startup build %.1f ms, %d passes (cache %s)\n", (NowSeconds() - build_t0) * 1000.0,
+               g_app.graph->count, cache ? "on" : "off");
+    } else if (g_app.grid) {
+        int ok = 0;
+        for (int i = 0; i < g_app.grid->count; ++i) ok += g_app.grid->tile[i].program != 0;
+        printf("startup build %.1f ms, %d of %d grid shaders (cache %s)\n", (NowSeconds() - build_t0) * 1000.0,
+               ok, g_app.grid->count, cache ? "on" : "off");
+    } else {
+        printf("startup build %.1f ms (cache %s)\n", (NowSeconds() - build_t0) * 1000.0,
+               !cache ? "off" : info.cache_hit ? "hit" : "miss");
+        ApplyProgram(prog);
+        g_app.program_hash = info.source_hash;
+        PrintUserUniforms("", g_app.program);
+        PrintLocalSize("");
+    }
+    CreateFullscreenQuad();
+    g_app.frame_uniforms = FrameUniformsCreate();
+    if (g_app.frame_uniforms)
+        printf("frame inputs: uniform block, %s\n", FrameUniformsPersistent(g_app.frame_uniforms)
+               ? "persistently mapped ring" : "glBufferSubData ring");
+    else
+        printf("frame inputs: loose uniforms only (out of memory for the uniform block)\n");
+    g_app.gpu_timer = GpuTimerCreate();
+    if (cli.frames_in_flight) {
+        FramePacerOptions po = { cli.frames_in_flight, 0.0 };
+        g_app.pacer = FramePacerCreate(&po);
+        if (!g_app.pacer) fprintf(stderr, "Could not create the frame pacer: frames are not paced.\n");
+    }
+    TextureCache* textures = TextureCacheCreate((size_t)cli.texture_budget_mb << 20);
+    if (!textures) fprintf(stderr, "Could not create the texture cache: iChannel images stay black.\n");
+    AttachChannelTextures(textures);
+    if (!cli.watch) {
+        TextureCacheFinish(textures); // the images are part of what is measured or rendered
+        PrintTextureLoads("");
+    }
+    if (!g_app.gpu_timer)
+        fprintf(stderr, "Out of memory: frames are not GPU-timed.\n");
+    else if (cli.gpu_csv[0] && !GpuTimerOpenCsv(g_app.gpu_timer, cli.gpu_csv))
+        fprintf(stderr, "Could not open %s for writing.\n", cli.gpu_csv);
+    static DynamicResolution dynres;
+    if (cli.dynres_ms > 0.0) {
+        DynResOptions dopt;
+        DynResDefaultOptions(&dopt, cli.dynres_ms);
+        if (DynResInit(&dynres, &dopt, logbuf, sizeof(logbuf))) g_app.dynres = &dynres;
+        else fprintf(stderr, "Dynamic resolution disabled:\n%s\n", logbuf);
+    }
+    static ProgressiveRender progressive;
+    if (cli.progressive_ms > 0.0) {
+        ProgressiveOptions popt;
+        ProgressiveDefaultOptions(&popt, cli.progressive_ms);
+        if (cli.progressive_tile) popt.max_tile = cli.progressive_tile;
+        ProgressiveInit(&progressive, &popt);
+        g_app.progressive = &progressive;
+    }
+    static TemporalAccumulation accum;
+    if (cli.accumulate) {
+        if (AccumInit(&accum, cli.accumulate, logbuf, sizeof(logbuf))) g_app.accum = &accum;
+        else fprintf(stderr, "Accumulation disabled:\n%s\n", logbuf);
+        g_app.paused = true; // the still is of one moment either way
+        g_app.paused_offset = cli.time;
+    }
+    Telemetry* telemetry = NULL;
+    if (cli.telemetry[0]) {
+        telemetry = TelemetryCreate(cli.telemetry, logbuf, sizeof(logbuf));
+        if (telemetry) {
+            AttachTelemetry(telemetry);
+            printf("telemetry on %s (GET /metrics, /stream)\n", TelemetryEndpoint(telemetry));
+        } else {
+            fprintf(stderr, "Telemetry disabled: %s\n", logbuf);
+        }
+    }
+    if (capture_out) {
+        g_app.capture = FrameCaptureCreate(capture_out, capture_y4m, opt.width, opt.height,
+                                           cli.capture_fps ? cli.capture_fps : 60, logbuf, sizeof(logbuf));
+        if (!g_app.capture) fprintf(stderr, "Capture disabled: %s\n", logbuf);
+    }
+
+    FrameStats stats;
+    int rc = 0;
+    if (cli.offline.pattern[0]) {
+        rc = RunOfflineMode(&cli.offline);
+    } else if (cli.tune[0] || cli.local_size_sweep) {
+        rc = RunTuneMode(&space, &opt, &cli);
+    } else if (cli.watch) {
+        rc = RunWatchMode(&opt, &cli.sched);
+    } else if (RunHeadlessBenchmark(&opt, &stats, logbuf, sizeof(logbuf))) {
+        printf("%s @ %dx%d, %d frames (+%d warmup)\n", g_app.graph ? g_app.graph->path : g_app.grid ? "grid" : g_app.frag_path,
+               opt.width, opt.height, opt.frames, opt.warmup_frames);
+        printf("frame ms: min %.3f  median %.3f  p99 %.3f  (mean %.3f, max %.3f)\n",
+               stats.min_ms, stats.median_ms, stats.p99_ms, stats.mean_ms, stats.max_ms);
+        PrintGpuStats("");
+        PrintPacerStats("");
+        PrintProgressiveStats("");
+        PrintStill("");
+        PrintGridStats("");
+    } else {
+        fprintf(stderr, "%s\n", logbuf);
+        rc = 1;
+    }
+    if (g_app.capture && !FinishCapture(cli.capture)) rc = 1;
+    PrintTextureStats();
+
+    if (g_app.program) { glDeleteProgram(g_app.program); g_app.program = 0; }
+    RenderGraphDestroy(g_app.graph); g_app.graph = NULL;
+    ShaderGridDestroy(g_app.grid); g_app.grid = NULL;
+    DetachChannelTextures();
+    TextureCacheDestroy(textures);
+    if (g_app.vbo) { glDeleteBuffers(1, &g_app.vbo); g_app.vbo = 0; }
+    if (g_app.vao) { glDeleteVertexArrays(1, &g_app.vao); g_app.vao = 0; }
+    if (g_app.dynres) { DynResShutdown(g_app.dynres); g_app.dynres = NULL; }
+    if (g_app.progressive) { ProgressiveShutdown(g_app.progressive); g_app.progressive = NULL; }
+    if (g_app.accum) { AccumShutdown(g_app.accum); g_app.accum = NULL; }
+    if (g_app.compute) { ComputePassShutdown(g_app.compute); g_app.compute = NULL; }
+    DetachTelemetry();
+    TelemetryDestroy(telemetry);
+    FramePacerDestroy(g_app.pacer); g_app.pacer = NULL;
+    GpuTimerDestroy(g_app.gpu_timer); g_app.gpu_timer = NULL;
+    FrameUniformsDestroy(g_app.frame_uniforms); g_app.frame_uniforms = NULL;
+    SetUserParams(NULL);
+    SetStageCache(NULL);
+    StageCacheDestroy(stages);
+    SetIncludeCache(NULL);
+    IncludeCacheDestroy(includes);
+    SetProgramCache(NULL);
+    ProgramCacheClose(cache);
+    DestroyHeadlessContext();
+    if (cli.profile[0]) {
+        int events = 0;
+        double seconds = cli.profile_seconds > 0.0 ? cli.profile_seconds : PROFILER_DEFAULT_SECONDS;
+        if (ProfilerWriteTrace(cli.profile, seconds, &events, logbuf, sizeof(logbuf)))
+            fprintf(stderr, "trace of the last %.0f s (%d events) in %s\n", seconds, events, cli.profile);
+        else {
+            fprintf(stderr, "--profile: %s\n", logbuf);
+            rc = 1;
+        }
+    }
+    ProfilerShutdown();
+    return rc;
+}
@@ -0,0 +1,134 @@
+// offline.c — see offline.h
+#include "offline.h"
+#include "app.h"
+#include "image_write.h"
+#include "render_target.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool IsPng(const char* path) {
+    size_t n = strlen(path);
+    return n >= 4 && (!strcmp(path + n - 4, ".png") || !strcmp(path + n - 4, ".PNG"));
+}
+
+bool OfflineCheckPattern(const OfflineOptions* opt, char* log, int logsz) {
+    int conversions = 0;
+    for (const char* p = opt->pattern; *p; ++p) {
+        if (*p != '%') continue;
+        if (p[1] == '%') { ++p; continue; }
+        ++p;
+        while (*p && strchr("-+ 0#", *p)) ++p;
+        while (*p >= '0' && *p <= '9') ++p;
+        if (*p != 'd') { snprintf(log, logsz, "%s: only %%d conversions (like %%05d) are allowed.", opt->pattern); return false; }
+        ++conversions;
+    }
+    if (conversions > 1 || (conversions == 0 && opt->count > 1)) {
+        snprintf(log, logsz, "%s: needs one %%d for the frame number.", opt->pattern);
+        return false;
+    }
+    if (opt->shard_tiles && IsPng(opt->pattern)) {
+        snprintf(log, logsz, "%s: tile shards write their rows in place, which needs .ppm.", opt->pattern);
+        return false;
+    }
+    return true;
+}
+
+// Largest framebuffer edge the driver renders and reads back in one piece.
+static int MaxTileEdge(void) {
+    GLint rb = 0, tex = 0, vp[2] = { 0, 0 };
+    glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &rb);
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &tex);
+    glGetIntegerv(GL_MAX_VIEWPORT_DIMS, vp);
+    int m = rb;
+    if (tex < m) m = tex;
+    if (vp[0] < m) m = vp[0];
+    if (vp[1] < m) m = vp[1];
+    return m > 0 ? m : 4096;
+}
+
+bool RunOfflineRender(const OfflineOptions* opt, OfflineResult* out, char* log, int logsz) {
+    memset(out, 0, sizeof(*out));
+    if (!OfflineCheckPattern(opt, log, logsz)) return false;
+    int W = opt->width, H = opt->height;
+    int limit = MaxTileEdge();
+    int tw = opt->tile > 0 ? opt->tile : W, th = opt->tile > 0 ? opt->tile : H;
+    if (tw > limit) tw = limit;
+    if (th > limit) th = limit;
+    if (tw > W) tw = W;
+    if (th > H) th = H;
+    int tiles_x = (W + tw - 1) / tw, tiles_y = (H + th - 1) / th;
+    out->tile_w = tw;
+    out->tile_h = th;
+
+    RenderTarget rt;
+    if (!CreateRenderTarget(&rt, tw, th, GL_RGBA8)) {
+        snprintf(log, logsz, "Could not create a %dx%d offscreen framebuffer.", tw, th);
+        return false;
+    }
+    // Whole frames go out as one image; a tile shard only ever holds one row of tiles.
+    size_t image_bytes = (size_t)W * (size_t)(opt->shard_tiles ? th : H) * 4;
+    uint8_t* image = (uint8_t*)malloc(image_bytes);
+    double* samples = (double*)malloc((size_t)(opt->count > 0 ? opt->count : 1) * sizeof(double));
+    if (!image || !samples) {
+        snprintf(log, logsz, "Out of memory for a %dx%d frame.", W, H);
+        free(samples); free(image); DestroyRenderTarget(&rt);
+        return false;
+    }
+
+    bool ok = true;
+    char path[APP_PATH_MAX];
+    double start = NowSeconds();
+    glBindFramebuffer(GL_FRAMEBUFFER, rt.fbo);
+    glPixelStorei(GL_PACK_ROW_LENGTH, W);
+    for (int i = 0; i < opt->count && ok; ++i) {
+        int f = opt->first + i;
+        if (!opt->shard_tiles && f % opt->shards != opt->shard) continue;
+        FrameInputs in;
+        memset(&in, 0, sizeof(in));
+        in.resolution[0] = (float)W;
+        in.resolution[1] = (float)H;
+        in.time = (float)((double)f / opt->fps);
+        in.time_delta = (float)(1.0 / opt->fps);
+        in.frame = f;
+        snprintf(path, sizeof(path), opt->pattern, f);
+
+        double t0 = NowSeconds();
+        int drawn = 0;
+        for (int ty = 0; ty < tiles_y && ok; ++ty) {
+            if (opt->shard_tiles && (i * tiles_y + ty) % opt->shards != opt->shard) continue;
+            int y0 = ty * th, h = H - y0 < th ? H - y0 : th;
+            uint8_t* row = opt->shard_tiles ? image : image + (size_t)y0 * W * 4;
+            for (int tx = 0; tx < tiles_x; ++tx) {
+                int x0 = tx * tw, w = W - x0 < tw ? W - x0 : tw;
+                in.tile_offset[0] = (float)x0;
+                in.tile_offset[1] = (float)y0;
+                RenderRegion(&in, w, h);
+                glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, row + (size_t)x0 * 4);
+                ++drawn;
+            }
+            if (opt->shard_tiles && !WritePPMRows(path, W, H, y0, h, image)) {
+                snprintf(log, logsz, "Could not write rows %d-%d of %s.", y0, y0 + h - 1, path);
+                ok = false;
+            }
+        }
+        if (!drawn) continue;
+        if (!opt->shard_tiles && !WriteImage(path, W, H, image, false)) {
+            snprintf(log, logsz, "Could not write %s.", path);
+            ok = false;
+        }
+        samples[out->frames++] = (NowSeconds() - t0) * 1000.0;
+        out->tiles += drawn;
+    }
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    out->seconds = NowSeconds() - start;
+    if (out->seconds > 0.0)
+        out->frames_per_hour = (double)out->tiles / (double)(tiles_x * tiles_y) * 3600.0 / out->seconds;
+    ComputeFrameStats(samples, out->frames, &out->stats);
+    free(samples);
+    free(image);
+    DestroyRenderTarget(&rt);
+    return ok;
+}
@@ -0,0 +1,45 @@
+// offline.h — deterministic image-sequence rendering at a fixed timestep
+//
+// Frame f gets uTime = f / fps, uTimeDelta = 1 / fps and uFrame = f, with the mouse
+// and uDate zeroed, so the output depends only on the shader, its parameters, the
+// size and the tile size: the same run on the same driver is bit-identical, however
+// the work is split. Frames larger than the GL limits (or than --tile) are drawn tile
+// by tile into one framebuffer-sized target via RenderRegion().
+//
+// Sharding splits a range between processes that each have their own context: by
+// whole frames, or by rows of tiles, which every shard writes into the same .ppm in
+// place (WritePPMRows) so a single large frame can be spread over a farm.
+
+#ifndef SHADERDEVEL_OFFLINE_H
+#define SHADERDEVEL_OFFLINE_H
+
+#include "platform.h"
+#include "frame_stats.h"
+
+typedef struct {
+    char   pattern[APP_PATH_MAX]; // printf pattern with one integer conversion; .png or .ppm
+    int    width, height;
+    double fps;
+    int    first, count;          // frame range
+    int    tile;                  // tile edge in pixels, 0 = as large as the GL limits allow
+    int    shard, shards;         // render units where unit % shards == shard
+    bool   shard_tiles;           // units are tile rows of every frame instead of frames
+} OfflineOptions;
+
+typedef struct {
+    int        frames;          // frames this process rendered all or part of
+    int        tiles;           // tiles drawn
+    int        tile_w, tile_h;
+    double     seconds;         // wall time, including readback and file writes
+    double     frames_per_hour; // in whole frames (tiles / tiles per frame)
+    FrameStats stats;           // ms per frame, this shard's part of it
+} OfflineResult;
+
+// Checks the pattern: one %d-style conversion (none allowed for a single frame) and a
+// writer for the extension. False with a message in log.
+bool OfflineCheckPattern(const OfflineOptions* opt, char* log, int logsz);
+
+// Needs a current context with g_app.program (no graph) and g_app.vao set up.
+bool RunOfflineRender(const OfflineOptions* opt, OfflineResult* out, char* log, int logsz);
+
+#endif // SHADERDEVEL_OFFLINE_H
@@ -0,0 +1,413 @@
+// platform.c — see platform.h
+#include "platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SHADER_FILE_SIZE 10485760 // 10MB
+
+#ifdef _WIN32
+
+#include <fcntl.h>
+#include <io.h>
+
+static bool Utf8ToWide(const char* src, WCHAR* dst, int dst_count) {
+    return MultiByteToWideChar(CP_UTF8, 0, src, -1, dst, dst_count) > 0;
+}
+
+double NowSeconds(void) {
+    static LARGE_INTEGER qpf;
+    if (!qpf.QuadPart) QueryPerformanceFrequency(&qpf);
+    LARGE_INTEGER qpc; QueryPerformanceCounter(&qpc);
+    return (double)qpc.QuadPart / (double)qpf.QuadPart;
+}
+
+double ProcessCpuSeconds(void) {
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0.0;
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime; k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;   u.HighPart = user.dwHighDateTime;
+    return (double)(k.QuadPart + u.QuadPart) * 1e-7; // 100 ns units
+}
+
+bool ReadWholeFile(const char* path, size_t max_size, char** out_data, size_t* out_size) {
+    *out_data = NULL; *out_size = 0;
+    WCHAR wpath[APP_PATH_MAX];
+    if (!Utf8ToWide(path, wpath, APP_PATH_MAX)) return false;
+    HANDLE f = CreateFileW(wpath, GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(f, &size)) { CloseHandle(f); return false; }
+    if (size.QuadPart <= 0 || (uint64_t)size.QuadPart > (uint64_t)max_size) { CloseHandle(f); return false; }
+    char* buf = (char*)malloc((size_t)size.QuadPart + 1);
+    DWORD read = 0; BOOL ok = ReadFile(f, buf, (DWORD)size.QuadPart, &read, NULL);
+    CloseHandle(f);
+    if (!ok) { free(buf); return false; }
+    buf[read] = 0;
+    *out_data = buf; *out_size = read;
+    return true;
+}
+
+bool ReadFileUTF8(const char* path, char** out_data, size_t* out_size) {
+    return ReadWholeFile(path, MAX_SHADER_FILE_SIZE, out_data, out_size);
+}
+
+bool MapFileReadOnly(const char* path, size_t max_size, MappedFile* out) {
+    memset(out, 0, sizeof(*out));
+    WCHAR wpath[APP_PATH_MAX];
+    if (!Utf8ToWide(path, wpath, APP_PATH_MAX)) return false;
+    HANDLE f = CreateFileW(wpath, GENERIC_READ, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(f, &size) || (uint64_t)size.QuadPart > (uint64_t)max_size) { CloseHandle(f); return false; }
+    if (size.QuadPart == 0) { CloseHandle(f); out->data = ""; return true; }
+    // The view keeps the file open; the handles aren't needed past this point.
+    out->mapping = CreateFileMappingW(f, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(f);
+    if (!out->mapping) return false;
+    out->data = (const char*)MapViewOfFile(out->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!out->data) { CloseHandle(out->mapping); out->mapping = NULL; return false; }
+    out->size = (size_t)size.QuadPart;
+    return true;
+}
+
+void UnmapFile(MappedFile* m) {
+    if (m->mapping) {
+        UnmapViewOfFile(m->data);
+        CloseHandle(m->mapping);
+    }
+    memset(m, 0, sizeof(*m));
+}
+
+bool MapShaderFile(const char* path, MappedFile* out) {
+    return MapFileReadOnly(path, MAX_SHADER_FILE_SIZE, out);
+}
+
+bool GetFileWriteTime(const char* path, uint64_t* out_time) {
+    WCHAR wpath[APP_PATH_MAX];
+    if (!Utf8ToWide(path, wpath, APP_PATH_MAX)) return false;
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (!GetFileAttributesExW(wpath, GetFileExInfoStandard, &fad)) return false;
+    *out_time = ((uint64_t)fad.ftLastWriteTime.dwHighDateTime << 32) | fad.ftLastWriteTime.dwLowDateTime;
+    return true;
+}
+
+bool WriteFileAtomic(const char* path, const void* data, size_t size) {
+    char tmp[APP_PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    WCHAR wpath[APP_PATH_MAX], wtmp[APP_PATH_MAX];
+    if (!Utf8ToWide(path, wpath, APP_PATH_MAX) || !Utf8ToWide(tmp, wtmp, APP_PATH_MAX)) return false;
+    HANDLE f = CreateFileW(wtmp, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE) return false;
+    DWORD written = 0;
+    BOOL ok = WriteFile(f, data, (DWORD)size, &written, NULL) && written == (DWORD)size;
+    CloseHandle(f);
+    if (!ok || !MoveFileExW(wtmp, wpath, MOVEFILE_REPLACE_EXISTING)) { DeleteFileW(wtmp); return false; }
+    return true;
+}
+
+bool DeleteFileUTF8(const char* path) {
+    WCHAR wpath[APP_PATH_MAX];
+    return Utf8ToWide(path, wpath, APP_PATH_MAX) && DeleteFileW(wpath);
+}
+
+bool MakeDirectories(const char* dir) {
+    char buf[APP_PATH_MAX];
+    snprintf(buf, sizeof(buf), "%s", dir);
+    for (char* p = buf + 1; *p; ++p) {
+        if (*p != '\\' && *p != '/') continue;
+        if (p[-1] == ':') continue; // drive root
+        char c = *p; *p = 0;
+        WCHAR w[APP_PATH_MAX];
+        if (Utf8ToWide(buf, w, APP_PATH_MAX)) CreateDirectoryW(w, NULL);
+        *p = c;
+    }
+    WCHAR w[APP_PATH_MAX];
+    if (!Utf8ToWide(buf, w, APP_PATH_MAX)) return false;
+    CreateDirectoryW(w, NULL);
+    DWORD attr = GetFileAttributesW(w);
+    return attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+bool TouchFile(const char* path) {
+    WCHAR wpath[APP_PATH_MAX];
+    if (!Utf8ToWide(path, wpath, APP_PATH_MAX)) return false;
+    HANDLE f = CreateFileW(wpath, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE) return false;
+    FILETIME now; GetSystemTimeAsFileTime(&now);
+    BOOL ok = SetFileTime(f, NULL, NULL, &now);
+    CloseHandle(f);
+    return ok != FALSE;
+}
+
+bool ListDirectory(const char* dir, void (*fn)(const DirEntry* e, void* user), void* user) {
+    char pattern[APP_PATH_MAX];
+    snprintf(pattern, sizeof(pattern), "%s\\*", dir);
+    WCHAR wpattern[APP_PATH_MAX];
+    if (!Utf8ToWide(pattern, wpattern, APP_PATH_MAX)) return false;
+    WIN32_FIND_DATAW fd;
+    HANDLE h = FindFirstFileW(wpattern, &fd);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    do {
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+        char name[APP_PATH_MAX];
+        if (!WideCharToMultiByte(CP_UTF8, 0, fd.cFileName, -1, name, sizeof(name), NULL, NULL)) continue;
+        DirEntry e;
+        e.name       = name;
+        e.size       = ((uint64_t)fd.nFileSizeHigh << 32) | fd.nFileSizeLow;
+        e.write_time = ((uint64_t)fd.ftLastWriteTime.dwHighDateTime << 32) | fd.ftLastWriteTime.dwLowDateTime;
+        fn(&e, user);
+    } while (FindNextFileW(h, &fd));
+    FindClose(h);
+    return true;
+}
+
+bool GetUserCacheDir(char* out, size_t outsz) {
+    WCHAR wbase[APP_PATH_MAX];
+    DWORD n = GetEnvironmentVariableW(L"LOCALAPPDATA", wbase, APP_PATH_MAX);
+    if (n == 0 || n >= APP_PATH_MAX) return false;
+    char base[APP_PATH_MAX];
+    if (!WideCharToMultiByte(CP_UTF8, 0, wbase, -1, base, sizeof(base), NULL, NULL)) return false;
+    snprintf(out, outsz, "%s\\shaderdevel", base);
+    return true;
+}
+
+void SleepMilliseconds(int ms) { Sleep(ms > 0 ? (DWORD)ms : 0); }
+
+FILE* OpenWriteStream(const char* path) {
+    if (strcmp(path, "-") != 0) {
+        WCHAR wpath[APP_PATH_MAX];
+        return Utf8ToWide(path, wpath, APP_PATH_MAX) ? _wfopen(wpath, L"wb") : NULL;
+    }
+    fflush(stdout);
+    int fd = _dup(_fileno(stdout));
+    if (fd < 0) return NULL; // a GUI process started without a pipe has no stdout
+    _setmode(fd, _O_BINARY);
+    FILE* f = _fdopen(fd, "wb");
+    if (!f) { _close(fd); return NULL; }
+    _dup2(_fileno(stderr), _fileno(stdout));
+    return f;
+}
+
+typedef struct { void (*fn)(void*); void* arg; } ThreadTrampoline;
+static DWORD WINAPI ThreadEntry(LPVOID p) {
+    ThreadTrampoline tt = *(ThreadTrampoline*)p;
+    free(p);
+    tt.fn(tt.arg);
+    return 0;
+}
+bool ThreadStart(Thread* t, void (*fn)(void* arg), void* arg) {
+    ThreadTrampoline* tt = (ThreadTrampoline*)malloc(sizeof(*tt));
+    tt->fn = fn; tt->arg = arg;
+    *t = CreateThread(NULL, 0, ThreadEntry, tt, 0, NULL);
+    if (!*t) { free(tt); return false; }
+    return true;
+}
+void ThreadJoin(Thread t) { WaitForSingleObject(t, INFINITE); CloseHandle(t); }
+int CpuCount(void) {
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors > 0 ? (int)si.dwNumberOfProcessors : 1;
+}
+
+void MutexInit(Mutex* m)    { InitializeCriticalSection(m); }
+void MutexDestroy(Mutex* m) { DeleteCriticalSection(m); }
+void MutexLock(Mutex* m)    { EnterCriticalSection(m); }
+void MutexUnlock(Mutex* m)  { LeaveCriticalSection(m); }
+
+void CondInit(CondVar* c)            { InitializeConditionVariable(c); }
+void CondDestroy(CondVar* c)         { (void)c; }
+void CondWait(CondVar* c, Mutex* m)  { SleepConditionVariableCS(c, m, INFINITE); }
+void CondSignal(CondVar* c)          { WakeConditionVariable(c); }
+void CondBroadcast(CondVar* c)       { WakeAllConditionVariable(c); }
+
+#else // POSIX
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+double NowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+double ProcessCpuSeconds(void) {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) return 0.0;
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+bool ReadWholeFile(const char* path, size_t max_size, char** out_data, size_t* out_size) {
+    *out_data = NULL; *out_size = 0;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) { close(fd); return false; }
+    if (st.st_size <= 0 || (uint64_t)st.st_size > (uint64_t)max_size) { close(fd); return false; }
+    char* buf = (char*)malloc((size_t)st.st_size + 1);
+    size_t got = 0;
+    while (got < (size_t)st.st_size) {
+        ssize_t n = read(fd, buf + got, (size_t)st.st_size - got);
+        if (n < 0) { free(buf); close(fd); return false; }
+        if (n == 0) break;
+        got += (size_t)n;
+    }
+    close(fd);
+    buf[got] = 0;
+    *out_data = buf; *out_size = got;
+    return true;
+}
+
+bool ReadFileUTF8(const char* path, char** out_data, size_t* out_size) {
+    return ReadWholeFile(path, MAX_SHADER_FILE_SIZE, out_data, out_size);
+}
+
+bool MapFileReadOnly(const char* path, size_t max_size, MappedFile* out) {
+    memset(out, 0, sizeof(*out));
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size > (uint64_t)max_size) { close(fd); return false; }
+    if (st.st_size == 0) { close(fd); out->data = ""; return true; }
+    void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping holds its own reference
+    if (p == MAP_FAILED) return false;
+    out->data = (const char*)p;
+    out->size = (size_t)st.st_size;
+    return true;
+}
+
+void UnmapFile(MappedFile* m) {
+    if (m->size) munmap((void*)m->data, m->size);
+    memset(m, 0, sizeof(*m));
+}
+
+bool MapShaderFile(const char* path, MappedFile* out) {
+    return MapFileReadOnly(path, MAX_SHADER_FILE_SIZE, out);
+}
+
+bool GetFileWriteTime(const char* path, uint64_t* out_time) {
+    struct stat st;
+    if (stat(path, &st) != 0) return false;
+    *out_time = (uint64_t)st.st_mtim.tv_sec * 1000000000ull + (uint64_t)st.st_mtim.tv_nsec;
+    return true;
+}
+
+bool WriteFileAtomic(const char* path, const void* data, size_t size) {
+    char tmp[APP_PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    const char* p = (const char*)data;
+    size_t left = size;
+    while (left > 0) {
+        ssize_t n = write(fd, p, left);
+        if (n <= 0) { close(fd); unlink(tmp); return false; }
+        p += n; left -= (size_t)n;
+    }
+    close(fd);
+    if (rename(tmp, path) != 0) { unlink(tmp); return false; }
+    return true;
+}
+
+bool DeleteFileUTF8(const char* path) { return unlink(path) == 0; }
+
+bool MakeDirectories(const char* dir) {
+    char buf[APP_PATH_MAX];
+    snprintf(buf, sizeof(buf), "%s", dir);
+    for (char* p = buf + 1; *p; ++p) {
+        if (*p != '/') continue;
+        *p = 0; mkdir(buf, 0755); *p = '/';
+    }
+    mkdir(buf, 0755);
+    struct stat st;
+    return stat(buf, &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool TouchFile(const char* path) { return utimensat(AT_FDCWD, path, NULL, 0) == 0; }
+
+bool ListDirectory(const char* dir, void (*fn)(const DirEntry* e, void* user), void* user) {
+    DIR* d = opendir(dir);
+    if (!d) return false;
+    struct dirent* de;
+    while ((de = readdir(d)) != NULL) {
+        char path[APP_PATH_MAX];
+        snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+        struct stat st;
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        DirEntry e;
+        e.name       = de->d_name;
+        e.size       = (uint64_t)st.st_size;
+        e.write_time = (uint64_t)st.st_mtim.tv_sec * 1000000000ull + (uint64_t)st.st_mtim.tv_nsec;
+        fn(&e, user);
+    }
+    closedir(d);
+    return true;
+}
+
+bool GetUserCacheDir(char* out, size_t outsz) {
+    const char* xdg = getenv("XDG_CACHE_HOME");
+    if (xdg && xdg[0]) { snprintf(out, outsz, "%s/shaderdevel", xdg); return true; }
+    const char* home = getenv("HOME");
+    if (!home || !home[0]) return false;
+    snprintf(out, outsz, "%s/.cache/shaderdevel", home);
+    return true;
+}
+
+void SleepMilliseconds(int ms) {
+    if (ms <= 0) return;
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    while (nanosleep(&ts, &ts) != 0) {}
+}
+
+FILE* OpenWriteStream(const char* path) {
+    if (strcmp(path, "-") != 0) return fopen(path, "wb");
+    fflush(stdout);
+    int fd = dup(STDOUT_FILENO);
+    if (fd < 0) return NULL;
+    FILE* f = fdopen(fd, "wb");
+    if (!f) { close(fd); return NULL; }
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    signal(SIGPIPE, SIG_IGN); // a reader that quits early is a write error, not a kill
+    return f;
+}
+
+typedef struct { void (*fn)(void*); void* arg; } ThreadTrampoline;
+static void* ThreadEntry(void* p) {
+    ThreadTrampoline tt = *(ThreadTrampoline*)p;
+    free(p);
+    tt.fn(tt.arg);
+    return NULL;
+}
+bool ThreadStart(Thread* t, void (*fn)(void* arg), void* arg) {
+    ThreadTrampoline* tt = (ThreadTrampoline*)malloc(sizeof(*tt));
+    tt->fn = fn; tt->arg = arg;
+    if (pthread_create(t, NULL, ThreadEntry, tt) != 0) { free(tt); return false; }
+    return true;
+}
+void ThreadJoin(Thread t) { pthread_join(t, NULL); }
+int CpuCount(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+void MutexInit(Mutex* m)    { pthread_mutex_init(m, NULL); }
+void MutexDestroy(Mutex* m) { pthread_mutex_destroy(m); }
+void MutexLock(Mutex* m)    { pthread_mutex_lock(m); }
+void MutexUnlock(Mutex* m)  { pthread_mutex_unlock(m); }
+
+void CondInit(CondVar* c)            { pthread_cond_init(c, NULL); }
+void CondDestroy(CondVar* c)         { pthread_cond_destroy(c); }
+void CondWait(CondVar* c, Mutex* m)  { pthread_cond_wait(c, m); }
+void CondSignal(CondVar* c)          { pthread_cond_signal(c); }
+void CondBroadcast(CondVar* c)       { pthread_cond_broadcast(c); }
+
+#endif
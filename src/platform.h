@@ -0,0 +1,143 @@
+// platform.h — tiny OS layer shared by the Win32 playground and the headless runner
+//
+// Paths are UTF-8 everywhere; the Win32 side converts to UTF-16 at the API boundary.
+// Include this header first in every translation unit so the Win32 defines below
+// are seen before any system header.
+
+#ifndef SHADERDEVEL_PLATFORM_H
+#define SHADERDEVEL_PLATFORM_H
+
+#ifdef _WIN32
+#ifndef UNICODE
+#define UNICODE
+#endif
+#ifndef _UNICODE
+#define _UNICODE
+#endif
+#ifndef _CRT_SECURE_NO_WARNINGS
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef STRICT
+#define STRICT
+#endif
+#include <windows.h>
+#include <intrin.h>
+#else
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <pthread.h>
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define APP_PATH_MAX 1024
+
+// Monotonic clock in seconds (QPC on Win32, CLOCK_MONOTONIC elsewhere).
+double NowSeconds(void);
+// CPU time used by the whole process so far (all threads, user + kernel), in seconds.
+double ProcessCpuSeconds(void);
+
+// Whole-file read into a malloc'd, NUL-terminated buffer. Refuses empty files and
+// anything over max_size.
+bool   ReadWholeFile(const char* path, size_t max_size, char** out_data, size_t* out_size);
+// Shader sources: ReadWholeFile capped at 10MB.
+bool   ReadFileUTF8(const char* path, char** out_data, size_t* out_size);
+
+// Read-only view of a whole file, without the copy (mmap / MapViewOfFile). Keep it
+// short-lived: on Win32 a mapped file can't be rewritten in place. An empty file maps
+// to data "" and size 0; anything over max_size is refused.
+typedef struct {
+    const char* data;
+    size_t      size;
+#ifdef _WIN32
+    HANDLE      mapping;
+#endif
+} MappedFile;
+bool   MapFileReadOnly(const char* path, size_t max_size, MappedFile* out);
+void   UnmapFile(MappedFile* m);
+// Shader sources: MapFileReadOnly capped at 10MB.
+bool   MapShaderFile(const char* path, MappedFile* out);
+
+// Last write time in an opaque, monotonically comparable unit.
+bool   GetFileWriteTime(const char* path, uint64_t* out_time);
+
+// Writes to path.tmp then renames over path, so readers never see a partial file.
+bool   WriteFileAtomic(const char* path, const void* data, size_t size);
+bool   DeleteFileUTF8(const char* path);
+// Creates dir and any missing parents; true if it exists afterwards.
+bool   MakeDirectories(const char* dir);
+// Sets the last write time to now.
+bool   TouchFile(const char* path);
+
+typedef struct {
+    const char* name;       // file name only
+    uint64_t    size;
+    uint64_t    write_time; // same unit as GetFileWriteTime
+} DirEntry;
+// Calls fn for each regular file directly inside dir.
+bool   ListDirectory(const char* dir, void (*fn)(const DirEntry* e, void* user), void* user);
+
+// Per-user cache root: %LOCALAPPDATA%\shaderdevel or $XDG_CACHE_HOME/shaderdevel (~/.cache).
+bool   GetUserCacheDir(char* out, size_t outsz);
+
+void   SleepMilliseconds(int ms);
+
+// Binary output stream for a UTF-8 path, or "-" for the process's stdout. Taking
+// stdout moves its descriptor to the stream and points stdout itself at stderr, so
+// later printf output can't interleave with the data. NULL on failure.
+FILE*  OpenWriteStream(const char* path);
+
+// ============================ Threads ==============================
+#ifdef _WIN32
+typedef HANDLE             Thread;
+typedef CRITICAL_SECTION   Mutex;
+typedef CONDITION_VARIABLE CondVar;
+#else
+typedef pthread_t          Thread;
+typedef pthread_mutex_t    Mutex;
+typedef pthread_cond_t     CondVar;
+#endif
+
+bool ThreadStart(Thread* t, void (*fn)(void* arg), void* arg);
+void ThreadJoin(Thread t);
+// Logical processors available to this process (at least 1).
+int  CpuCount(void);
+
+void MutexInit(Mutex* m);
+void MutexDestroy(Mutex* m);
+void MutexLock(Mutex* m);
+void MutexUnlock(Mutex* m);
+
+void CondInit(CondVar* c);
+void CondDestroy(CondVar* c);
+void CondWait(CondVar* c, Mutex* m); // m must be locked
+void CondSignal(CondVar* c);
+void CondBroadcast(CondVar* c);
+
+// ============================ Atomics ==============================
+// Acquire loads / release stores / full-barrier RMW on naturally aligned int32; untorn
+// loads and stores of int64 (also on 32-bit x86) for counters with a single writer.
+#ifdef _WIN32
+static inline int32_t AtomicLoad32(volatile int32_t* p) { int32_t v = *p; _ReadWriteBarrier(); return v; }
+static inline void    AtomicStore32(volatile int32_t* p, int32_t v) { _ReadWriteBarrier(); *p = v; }
+static inline int32_t AtomicExchange32(volatile int32_t* p, int32_t v) { return (int32_t)InterlockedExchange((volatile LONG*)p, (LONG)v); }
+static inline int32_t AtomicAdd32(volatile int32_t* p, int32_t v) { return (int32_t)InterlockedExchangeAdd((volatile LONG*)p, (LONG)v) + v; }
+static inline int64_t AtomicLoad64(volatile int64_t* p) { return InterlockedCompareExchange64((volatile LONG64*)p, 0, 0); }
+static inline void    AtomicStore64(volatile int64_t* p, int64_t v) { InterlockedExchange64((volatile LONG64*)p, v); }
+#else
+static inline int32_t AtomicLoad32(volatile int32_t* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline void    AtomicStore32(volatile int32_t* p, int32_t v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+static inline int32_t AtomicExchange32(volatile int32_t* p, int32_t v) { return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST); }
+static inline int32_t AtomicAdd32(volatile int32_t* p, int32_t v) { return __atomic_add_fetch(p, v, __ATOMIC_SEQ_CST); }
+static inline int64_t AtomicLoad64(volatile int64_t* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline void    AtomicStore64(volatile int64_t* p, int64_t v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+#endif
+
+#endif // SHADERDEVEL_PLATFORM_H
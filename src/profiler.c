@@ -0,0 +1,205 @@
+// profiler.c — see profiler.h
+#include "profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef SHADERDEVEL_PROFILE
+bool ProfilerWriteTrace(const char* path, double seconds, int* out_events, char* log, int logsz) {
+    (void)path; (void)seconds;
+    if (out_events) *out_events = 0;
+    snprintf(log, logsz, "this build has no profiler markers (a Release or MinSizeRel configuration)");
+    return false;
+}
+void ProfilerShutdown(void) {}
+#else
+
+#ifdef _MSC_VER
+#define PROFILER_TLS __declspec(thread)
+#else
+#define PROFILER_TLS _Thread_local
+#endif
+
+typedef struct {
+    const char* name;
+    double      start, end;
+} ProfileEvent;
+
+typedef struct {
+    ProfileEvent     ring[PROFILER_RING_EVENTS];
+    volatile int64_t head;  // events written; only the owning thread stores it
+    ProfileEvent     open[PROFILER_MAX_DEPTH];
+    int              depth; // may exceed PROFILER_MAX_DEPTH: those levels aren't recorded
+    int              index; // tid in the trace
+    char             name[48];
+} ProfileThread;
+
+static ProfileThread* volatile s_threads[PROFILER_MAX_THREADS];
+static volatile int32_t        s_thread_count;
+static PROFILER_TLS ProfileThread* s_self;
+static PROFILER_TLS bool           s_no_slot; // all slots taken: this thread doesn't record
+static PROFILER_TLS const char*    s_pending_name; // named before its first marker
+
+static void PublishThread(int idx, ProfileThread* t) {
+#ifdef _WIN32
+    InterlockedExchangePointer((PVOID volatile*)&s_threads[idx], t);
+#else
+    __atomic_store_n(&s_threads[idx], t, __ATOMIC_RELEASE);
+#endif
+}
+
+static ProfileThread* LoadThread(int idx) {
+#ifdef _WIN32
+    return (ProfileThread*)InterlockedCompareExchangePointer((PVOID volatile*)&s_threads[idx], NULL, NULL);
+#else
+    return __atomic_load_n(&s_threads[idx], __ATOMIC_ACQUIRE);
+#endif
+}
+
+static ProfileThread* RegisterThread(const char* name) {
+    if (s_no_slot) return NULL;
+    int idx = AtomicAdd32(&s_thread_count, 1) - 1;
+    if (idx >= PROFILER_MAX_THREADS) { s_no_slot = true; return NULL; }
+    ProfileThread* t = (ProfileThread*)calloc(1, sizeof(ProfileThread));
+    if (!t) { s_no_slot = true; return NULL; }
+    t->index = idx;
+    if (name) snprintf(t->name, sizeof(t->name), "%s", name);
+    else if (idx == 0) snprintf(t->name, sizeof(t->name), "main");
+    else snprintf(t->name, sizeof(t->name), "thread %d", idx);
+    PublishThread(idx, t);
+    s_self = t;
+    return t;
+}
+
+// The ring is claimed by the first marker, so a named thread that never marks costs nothing.
+void ProfilerThreadName(const char* name) {
+    if (s_self) snprintf(s_self->name, sizeof(s_self->name), "%s", name);
+    else s_pending_name = name;
+}
+
+void ProfilerBegin(const char* name) {
+    ProfileThread* t = s_self;
+    if (!t && !(t = RegisterThread(s_pending_name))) return;
+    if (t->depth < PROFILER_MAX_DEPTH) {
+        t->open[t->depth].name = name;
+        t->open[t->depth].start = NowSeconds();
+    }
+    t->depth++;
+}
+
+void ProfilerEnd(void) {
+    ProfileThread* t = s_self;
+    if (!t || t->depth == 0) return;
+    if (--t->depth >= PROFILER_MAX_DEPTH) return;
+    int64_t head = t->head;
+    ProfileEvent* e = &t->ring[head & (PROFILER_RING_EVENTS - 1)];
+    e->name  = t->open[t->depth].name;
+    e->start = t->open[t->depth].start;
+    e->end   = NowSeconds();
+    AtomicStore64(&t->head, head + 1);
+}
+
+// ============================== Export =============================
+static void WriteJsonString(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') fprintf(f, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20) fprintf(f, "\\u%04x", *s);
+        else fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+// Copies t's events that end after since into kept[*count..], grown as needed. The
+// owner stores ring[head & mask] before it publishes head + 1, so once head reads
+// `after`, everything from after - PROFILER_RING_EVENTS on may be mid-overwrite: only
+// events copied from a later index are kept.
+static bool SnapshotThread(ProfileThread* t, double since, ProfileEvent* scratch, ProfileEvent** kept, int64_t* count, int64_t* cap) {
+    int64_t head = AtomicLoad64(&t->head);
+    int64_t first = head > PROFILER_RING_EVENTS ? head - PROFILER_RING_EVENTS : 0;
+    for (int64_t k = first; k < head; ++k) scratch[k - first] = t->ring[k & (PROFILER_RING_EVENTS - 1)];
+    int64_t after = AtomicLoad64(&t->head);
+    int64_t valid = after >= PROFILER_RING_EVENTS ? after - PROFILER_RING_EVENTS + 1 : 0;
+    for (int64_t k = first > valid ? first : valid; k < head; ++k) {
+        const ProfileEvent* e = &scratch[k - first];
+        if (e->end < since) continue;
+        if (*count == *cap) {
+            int64_t grown = *cap ? *cap * 2 : 4096;
+            ProfileEvent* p = (ProfileEvent*)realloc(*kept, sizeof(ProfileEvent) * (size_t)grown);
+            if (!p) return false;
+            *kept = p;
+            *cap = grown;
+        }
+        (*kept)[(*count)++] = *e;
+    }
+    return true;
+}
+
+bool ProfilerWriteTrace(const char* path, double seconds, int* out_events, char* log, int logsz) {
+    if (out_events) *out_events = 0;
+    double now = NowSeconds(), since = now - seconds;
+    int threads = AtomicLoad32(&s_thread_count);
+    if (threads > PROFILER_MAX_THREADS) threads = PROFILER_MAX_THREADS;
+
+    // Snapshot every thread first: the origin has to come from validated copies too.
+    ProfileEvent* scratch = (ProfileEvent*)malloc(sizeof(ProfileEvent) * PROFILER_RING_EVENTS);
+    ProfileEvent* kept = NULL;
+    int64_t count = 0, cap = 0, end[PROFILER_MAX_THREADS];
+    ProfileThread* thread[PROFILER_MAX_THREADS];
+    bool ok = scratch != NULL;
+    for (int i = 0; ok && i < threads; ++i) {
+        thread[i] = LoadThread(i);
+        if (thread[i]) ok = SnapshotThread(thread[i], since, scratch, &kept, &count, &cap);
+        end[i] = count;
+    }
+    free(scratch);
+    if (!ok) { free(kept); snprintf(log, logsz, "out of memory"); return false; }
+
+    FILE* f = OpenWriteStream(path);
+    if (!f) { free(kept); snprintf(log, logsz, "cannot open %s for writing", path); return false; }
+    // ts is in microseconds, from the oldest event written
+    double origin = now;
+    for (int64_t k = 0; k < count; ++k) if (kept[k].start < origin) origin = kept[k].start;
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"shaderdevel\"}}");
+    int64_t k = 0;
+    for (int i = 0; i < threads; ++i) {
+        ProfileThread* t = thread[i];
+        if (!t) continue;
+        fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", t->index);
+        WriteJsonString(f, t->name);
+        fprintf(f, "}}");
+        fprintf(f, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"sort_index\":%d}}", t->index, t->index);
+        for (; k < end[i]; ++k) {
+            const ProfileEvent* e = &kept[k];
+            fprintf(f, ",\n{\"name\":");
+            WriteJsonString(f, e->name);
+            fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    t->index, (e->start - origin) * 1e6, (e->end - e->start) * 1e6);
+        }
+    }
+    fprintf(f, "\n]}\n");
+    free(kept);
+    ok = !ferror(f);
+    if (fclose(f) != 0) ok = false;
+    if (!ok) { snprintf(log, logsz, "write error on %s", path); return false; }
+    if (out_events) *out_events = (int)count;
+    return true;
+}
+
+void ProfilerShutdown(void) {
+    int threads = AtomicLoad32(&s_thread_count);
+    if (threads > PROFILER_MAX_THREADS) threads = PROFILER_MAX_THREADS;
+    for (int i = 0; i < threads; ++i) {
+        free(LoadThread(i));
+        PublishThread(i, NULL);
+    }
+    AtomicStore32(&s_thread_count, 0);
+    s_self = NULL;
+    s_no_slot = false;
+    s_pending_name = NULL;
+}
+
+#endif // SHADERDEVEL_PROFILE
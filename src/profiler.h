@@ -0,0 +1,50 @@
+// profiler.h — scoped CPU timing markers, dumped as a Chrome trace
+//
+// PROFILE_BEGIN("name") ... PROFILE_END() brackets a region on the calling thread;
+// regions nest (up to PROFILER_MAX_DEPTH deep). Each thread writes complete events
+// (name, start, end on the NowSeconds clock) into a ring of its own, allocated on its
+// first marker, so a marker pair costs two clock reads and a store: no lock, no
+// allocation after the first. Names are stored by pointer and must be string literals.
+// PROFILE_THREAD("name") labels the calling thread in the trace (a literal too).
+//
+// ProfilerWriteTrace dumps what the rings hold of the last N seconds, every thread, as
+// Chrome trace JSON for chrome://tracing or ui.perfetto.dev. The writer may run while
+// other threads keep marking; an event the ring may have been overwriting while it was
+// copied is dropped, never written torn, and the trace origin comes from the same copies.
+//
+// Markers exist only when SHADERDEVEL_PROFILE is defined (CMake defines it in every
+// configuration but Release and MinSizeRel); otherwise they expand to nothing and
+// ProfilerWriteTrace reports that the build has no markers.
+
+#ifndef SHADERDEVEL_PROFILER_H
+#define SHADERDEVEL_PROFILER_H
+
+#include "platform.h"
+
+#define PROFILER_RING_EVENTS     (1 << 15) // per thread, a power of two
+#define PROFILER_MAX_THREADS     32
+#define PROFILER_MAX_DEPTH       32
+#define PROFILER_DEFAULT_SECONDS 10.0
+
+#ifdef SHADERDEVEL_PROFILE
+#define PROFILE_BEGIN(name)  ProfilerBegin(name)
+#define PROFILE_END()        ProfilerEnd()
+#define PROFILE_THREAD(name) ProfilerThreadName(name)
+void ProfilerBegin(const char* name);
+void ProfilerEnd(void);
+void ProfilerThreadName(const char* name);
+#else
+#define PROFILE_BEGIN(name)  ((void)0)
+#define PROFILE_END()        ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
+
+// Writes the events that ended in the last `seconds` to path ("-" for stdout).
+// out_events (may be NULL) gets how many. False with log on an I/O error, or when the
+// markers were compiled out.
+bool ProfilerWriteTrace(const char* path, double seconds, int* out_events, char* log, int logsz);
+// Frees every ring. Only once the threads that marked have been joined; the calling
+// thread may mark again afterwards and gets a new ring.
+void ProfilerShutdown(void);
+
+#endif // SHADERDEVEL_PROFILER_H
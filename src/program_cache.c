@@ -0,0 +1,233 @@
+// program_cache.c — see program_cache.h
+#include "program_cache.h"
+#include "hash.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOB_MAGIC      0x42504453u // "SDPB"
+#define BLOB_VERSION    1u
+#define BLOB_EXT        ".glbin"
+#define MAX_BLOB_SIZE   (256u * 1024 * 1024)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format; // GLenum from glGetProgramBinary
+    uint32_t length; // bytes of binary following the header
+} BlobHeader;
+
+typedef struct {
+    uint64_t key;
+    uint64_t size;
+    uint64_t last_used; // file write time; hits touch the file so LRU survives restarts
+} CacheEntry;
+
+struct ProgramCache {
+    Mutex             lock;
+    char              dir[APP_PATH_MAX];
+    uint64_t          driver_hash;
+    uint64_t          max_bytes;
+    CacheEntry*       entries;
+    int               count, cap;
+    ProgramCacheStats stats;
+};
+
+static void EntryPath(const ProgramCache* c, uint64_t key, char* out, size_t outsz) {
+#ifdef _WIN32
+    snprintf(out, outsz, "%s\\%016llx" BLOB_EXT, c->dir, (unsigned long long)key);
+#else
+    snprintf(out, outsz, "%s/%016llx" BLOB_EXT, c->dir, (unsigned long long)key);
+#endif
+}
+
+// Caller holds c->lock for everything below that touches entries/stats.
+static CacheEntry* FindEntry(ProgramCache* c, uint64_t key) {
+    for (int i = 0; i < c->count; ++i) if (c->entries[i].key == key) return &c->entries[i];
+    return NULL;
+}
+
+static void RemoveEntry(ProgramCache* c, CacheEntry* e) {
+    c->stats.bytes -= e->size;
+    *e = c->entries[--c->count];
+}
+
+// False when out of memory; the entry is then not tracked.
+static bool AddEntry(ProgramCache* c, uint64_t key, uint64_t size, uint64_t last_used) {
+    CacheEntry* e = FindEntry(c, key);
+    if (e) { c->stats.bytes -= e->size; }
+    else {
+        if (c->count == c->cap) {
+            int cap = c->cap ? c->cap * 2 : 64;
+            CacheEntry* grown = (CacheEntry*)realloc(c->entries, (size_t)cap * sizeof(CacheEntry));
+            if (!grown) return false;
+            c->entries = grown;
+            c->cap = cap;
+        }
+        e = &c->entries[c->count++];
+    }
+    e->key = key; e->size = size; e->last_used = last_used;
+    c->stats.bytes += size;
+    return true;
+}
+
+static void EvictToBudget(ProgramCache* c, uint64_t keep_key) {
+    while (c->stats.bytes > c->max_bytes && c->count > 1) {
+        CacheEntry* oldest = NULL;
+        for (int i = 0; i < c->count; ++i) {
+            CacheEntry* e = &c->entries[i];
+            if (e->key == keep_key) continue;
+            if (!oldest || e->last_used < oldest->last_used) oldest = e;
+        }
+        if (!oldest) break;
+        char path[APP_PATH_MAX];
+        EntryPath(c, oldest->key, path, sizeof(path));
+        DeleteFileUTF8(path);
+        RemoveEntry(c, oldest);
+        c->stats.evictions++;
+    }
+}
+
+static void ScanEntry(const DirEntry* de, void* user) {
+    ProgramCache* c = (ProgramCache*)user;
+    size_t n = strlen(de->name);
+    size_t ext = sizeof(BLOB_EXT) - 1;
+    if (n != 16 + ext || strcmp(de->name + 16, BLOB_EXT) != 0) return;
+    char hex[17];
+    memcpy(hex, de->name, 16); hex[16] = 0;
+    char* end = NULL;
+    uint64_t key = strtoull(hex, &end, 16);
+    if (end != hex + 16) return;
+    AddEntry(c, key, de->size, de->write_time); // untracked, it stays on disk unevicted
+}
+
+ProgramCache* ProgramCacheOpen(const char* dir, uint64_t max_bytes, char* log, int logsz) {
+    log[0] = 0;
+    if (!GLAD_GL_ARB_get_program_binary) {
+        snprintf(log, logsz, "driver has no ARB_get_program_binary");
+        return NULL;
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0) {
+        snprintf(log, logsz, "driver exposes no program binary formats");
+        return NULL;
+    }
+    if (!MakeDirectories(dir)) {
+        snprintf(log, logsz, "could not create %s", dir);
+        return NULL;
+    }
+
+    ProgramCache* c = (ProgramCache*)calloc(1, sizeof(ProgramCache));
+    if (!c) {
+        snprintf(log, logsz, "out of memory");
+        return NULL;
+    }
+    MutexInit(&c->lock);
+    snprintf(c->dir, sizeof(c->dir), "%s", dir);
+    c->max_bytes = max_bytes;
+    const char* vendor   = (const char*)glGetString(GL_VENDOR);
+    const char* renderer = (const char*)glGetString(GL_RENDERER);
+    const char* version  = (const char*)glGetString(GL_VERSION);
+    c->driver_hash = Hash64String(vendor ? vendor : "", BLOB_VERSION);
+    c->driver_hash = Hash64String(renderer ? renderer : "", c->driver_hash);
+    c->driver_hash = Hash64String(version ? version : "", c->driver_hash);
+
+    ListDirectory(c->dir, ScanEntry, c);
+    EvictToBudget(c, 0);
+    return c;
+}
+
+void ProgramCacheClose(ProgramCache* c) {
+    if (!c) return;
+    MutexDestroy(&c->lock);
+    free(c->entries);
+    free(c);
+}
+
+uint64_t ProgramCacheKey(const ProgramCache* c, const char* vsrc, const char* fsrc) {
+    // A compute program has no vertex stage; its key differs from any vertex + fragment pair's.
+    uint64_t h = vsrc ? Hash64String(vsrc, c->driver_hash) : Hash64String("", c->driver_hash ^ GL_COMPUTE_SHADER);
+    return Hash64String(fsrc, h);
+}
+
+GLuint ProgramCacheLoad(ProgramCache* c, uint64_t key) {
+    char path[APP_PATH_MAX];
+    EntryPath(c, key, path, sizeof(path));
+
+    MutexLock(&c->lock);
+    bool known = FindEntry(c, key) != NULL;
+    if (!known) c->stats.misses++;
+    MutexUnlock(&c->lock);
+    if (!known) return 0;
+
+    char* data = NULL; size_t size = 0;
+    GLuint prog = 0;
+    if (ReadWholeFile(path, MAX_BLOB_SIZE, &data, &size) && size > sizeof(BlobHeader)) {
+        BlobHeader hdr;
+        memcpy(&hdr, data, sizeof(hdr));
+        if (hdr.magic == BLOB_MAGIC && hdr.version == BLOB_VERSION && hdr.key == key &&
+            (size_t)hdr.length == size - sizeof(hdr)) {
+            prog = glCreateProgram();
+            glProgramBinary(prog, (GLenum)hdr.format, data + sizeof(hdr), (GLsizei)hdr.length);
+            GLint ok = 0;
+            glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+            if (!ok) { glDeleteProgram(prog); prog = 0; }
+        }
+    }
+    free(data);
+
+    MutexLock(&c->lock);
+    CacheEntry* e = FindEntry(c, key);
+    if (prog) {
+        c->stats.hits++;
+        uint64_t t = 0;
+        if (TouchFile(path) && GetFileWriteTime(path, &t) && e) e->last_used = t;
+    } else {
+        // Corrupt, truncated or rejected by this driver build: drop it, caller compiles.
+        c->stats.rejected++;
+        DeleteFileUTF8(path);
+        if (e) RemoveEntry(c, e);
+    }
+    MutexUnlock(&c->lock);
+    return prog;
+}
+
+void ProgramCacheStore(ProgramCache* c, uint64_t key, GLuint prog) {
+    GLint length = 0;
+    glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0 || (uint64_t)length > MAX_BLOB_SIZE) return;
+
+    char* blob = (char*)malloc(sizeof(BlobHeader) + (size_t)length);
+    if (!blob) return;
+    GLsizei got = 0; GLenum format = 0;
+    glGetProgramBinary(prog, length, &got, &format, blob + sizeof(BlobHeader));
+    if (got <= 0) { free(blob); return; }
+    BlobHeader hdr = { BLOB_MAGIC, BLOB_VERSION, key, (uint32_t)format, (uint32_t)got };
+    memcpy(blob, &hdr, sizeof(hdr));
+
+    char path[APP_PATH_MAX];
+    EntryPath(c, key, path, sizeof(path));
+    size_t total = sizeof(hdr) + (size_t)got;
+    MutexLock(&c->lock);
+    uint64_t t = 0;
+    if (WriteFileAtomic(path, blob, total) && GetFileWriteTime(path, &t)) {
+        if (AddEntry(c, key, total, t)) {
+            c->stats.stores++;
+            EvictToBudget(c, key);
+        } else {
+            DeleteFileUTF8(path); // untracked, nothing would ever evict it
+        }
+    }
+    MutexUnlock(&c->lock);
+    free(blob);
+}
+
+void ProgramCacheGetStats(ProgramCache* c, ProgramCacheStats* out) {
+    MutexLock(&c->lock);
+    *out = c->stats;
+    out->entries = c->count;
+    MutexUnlock(&c->lock);
+}
@@ -0,0 +1,37 @@
+// program_cache.h — persistent on-disk program binary cache (ARB_get_program_binary)
+//
+// Entries are keyed by a hash of both stage sources (as handed to the driver) plus
+// GL_VENDOR/GL_RENDERER/GL_VERSION, so a driver update never loads a stale blob.
+// The directory is kept under a byte budget by evicting least recently used
+// entries (a hit touches the file). A blob the driver rejects is deleted and the
+// caller falls back to compiling from source.
+
+#ifndef SHADERDEVEL_PROGRAM_CACHE_H
+#define SHADERDEVEL_PROGRAM_CACHE_H
+
+#include "platform.h"
+#include <glad/gl.h>
+
+#define PROGRAM_CACHE_DEFAULT_BUDGET (64ull * 1024 * 1024)
+
+typedef struct ProgramCache ProgramCache;
+
+typedef struct {
+    uint32_t hits, misses, rejected, stores, evictions;
+    uint64_t bytes; // current size on disk
+    int      entries;
+} ProgramCacheStats;
+
+// Needs a current context (reads the driver strings). NULL if the driver exposes no
+// binary formats, the directory can't be created or memory runs out; log says why.
+ProgramCache* ProgramCacheOpen(const char* dir, uint64_t max_bytes, char* log, int logsz);
+void          ProgramCacheClose(ProgramCache* c);
+
+// Thread-safe; the GL calls go to whatever context is current on the caller.
+// vsrc is NULL for a compute program.
+uint64_t ProgramCacheKey(const ProgramCache* c, const char* vsrc, const char* fsrc);
+GLuint   ProgramCacheLoad(ProgramCache* c, uint64_t key);           // 0 on miss/reject
+void     ProgramCacheStore(ProgramCache* c, uint64_t key, GLuint prog); // link with the retrievable hint first
+void     ProgramCacheGetStats(ProgramCache* c, ProgramCacheStats* out);
+
+#endif // SHADERDEVEL_PROGRAM_CACHE_H
@@ -0,0 +1,240 @@
+// progressive.c — see progressive.h
+#include "progressive.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PROGRESSIVE_FIRST_TILE 32   // edge while the cost is unknown
+#define PROGRESSIVE_DECAY      0.1  // weight of a cheaper cost sample; dearer ones count fully
+#define PROGRESSIVE_TILE_SHARE 0.5  // of the budget one tile should cost
+
+void ProgressiveDefaultOptions(ProgressiveOptions* opt, double budget_ms) {
+    opt->budget_ms = budget_ms;
+    opt->max_tile = 256;
+}
+
+static int FirstTile(const ProgressiveRender* p) {
+    return PROGRESSIVE_FIRST_TILE < p->opt.max_tile ? PROGRESSIVE_FIRST_TILE : p->opt.max_tile;
+}
+
+void ProgressiveInit(ProgressiveRender* p, const ProgressiveOptions* opt) {
+    memset(p, 0, sizeof(*p));
+    p->opt = *opt;
+    if (p->opt.max_tile < PROGRESSIVE_MIN_TILE) p->opt.max_tile = PROGRESSIVE_MIN_TILE;
+    p->tile = FirstTile(p);
+    for (int i = 0; i < PROGRESSIVE_QUERY_RING; ++i) glGenQueries(PROGRESSIVE_FRAME_TILES + 1, p->slot[i].query);
+}
+
+void ProgressiveShutdown(ProgressiveRender* p) {
+    for (int i = 0; i < PROGRESSIVE_QUERY_RING; ++i) glDeleteQueries(PROGRESSIVE_FRAME_TILES + 1, p->slot[i].query);
+    if (p->fence) glDeleteSync(p->fence);
+    DestroyRenderTarget(&p->target);
+    free(p->cell_cost);
+    memset(p, 0, sizeof(*p));
+}
+
+void ProgressiveRestart(ProgressiveRender* p, bool forget_cost) {
+    p->started = false;
+    if (!forget_cost) return;
+    p->ms_per_pixel = 0.0;
+    p->pixel_cap = 0;
+    p->cost_generation = p->generation + 1;
+    p->tile = FirstTile(p);
+    if (p->cell_cost) memset(p->cell_cost, 0, (size_t)p->cells_x * p->cells_y * sizeof(float));
+}
+
+// Highest measured cost per pixel of the cells in a rectangle, 0 if none is measured.
+static double MapCost(const ProgressiveRender* p, int x, int y, int w, int h) {
+    double worst = 0.0;
+    int cx1 = (x + w - 1) / PROGRESSIVE_CELL, cy1 = (y + h - 1) / PROGRESSIVE_CELL;
+    for (int cy = y / PROGRESSIVE_CELL; cy <= cy1 && cy < p->cells_y; ++cy)
+        for (int cx = x / PROGRESSIVE_CELL; cx <= cx1 && cx < p->cells_x; ++cx)
+            if (p->cell_cost[cy * p->cells_x + cx] > worst) worst = p->cell_cost[cy * p->cells_x + cx];
+    return worst;
+}
+
+// Cells whose center the rectangle covers take its cost.
+static void MarkCost(ProgressiveRender* p, const int r[4], double cost) {
+    int half = PROGRESSIVE_CELL / 2;
+    for (int cy = (r[1] + half) / PROGRESSIVE_CELL; cy < p->cells_y && cy * PROGRESSIVE_CELL + half < r[1] + r[3]; ++cy)
+        for (int cx = (r[0] + half) / PROGRESSIVE_CELL; cx < p->cells_x && cx * PROGRESSIVE_CELL + half < r[0] + r[2]; ++cx)
+            p->cell_cost[cy * p->cells_x + cx] = (float)cost;
+}
+
+// Tile edge for a cost per pixel: about a tile share of the budget.
+static int EdgeFor(const ProgressiveRender* p, double ms_per_pixel, int limit) {
+    int edge = limit;
+    if (ms_per_pixel > 0.0) {
+        double e = sqrt(p->opt.budget_ms * PROGRESSIVE_TILE_SHARE / ms_per_pixel);
+        if (e < edge) edge = (int)e & ~7;
+    }
+    if (edge > p->opt.max_tile) edge = p->opt.max_tile;
+    return edge < PROGRESSIVE_MIN_TILE ? PROGRESSIVE_MIN_TILE : edge;
+}
+
+// Finished query sets into the cost estimates and the pass's GPU time.
+static void Harvest(ProgressiveRender* p) {
+    bool grow = false;
+    for (int i = 0; i < PROGRESSIVE_QUERY_RING; ++i) {
+        if (!p->slot[i].pending) continue;
+        int n = p->slot[i].tiles;
+        GLint available = 0;
+        glGetQueryObjectiv(p->slot[i].query[n], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+        p->slot[i].pending = false;
+        bool counts = p->slot[i].generation >= p->cost_generation;
+        GLuint64 prev = 0, t = 0;
+        glGetQueryObjectui64v(p->slot[i].query[0], GL_QUERY_RESULT, &prev);
+        double ms = 0.0;
+        uint64_t pixels = 0;
+        for (int k = 0; k < n; ++k, prev = t) {
+            glGetQueryObjectui64v(p->slot[i].query[k + 1], GL_QUERY_RESULT, &t);
+            const int* r = p->slot[i].rect[k];
+            double tile_ms = t > prev ? (double)(t - prev) * 1e-6 : 0.0;
+            ms += tile_ms;
+            pixels += (uint64_t)r[2] * (uint64_t)r[3];
+            if (counts && tile_ms > 0.0) MarkCost(p, r, tile_ms / ((double)r[2] * (double)r[3]));
+        }
+        if (p->slot[i].generation == p->done_generation) p->last_pass_gpu_ms += ms;
+        else if (p->slot[i].generation == p->generation) p->pass_gpu_ms += ms;
+        if (!counts || !pixels || ms <= 0.0) continue;
+
+        double sample = ms / (double)pixels;
+        if (sample > p->ms_per_pixel) p->ms_per_pixel = sample;
+        else p->ms_per_pixel += PROGRESSIVE_DECAY * (sample - p->ms_per_pixel);
+        // Slow start: a frame may draw twice what one that fit the budget drew.
+        uint64_t fit = ms <= p->opt.budget_ms ? 2 * pixels : (uint64_t)((double)pixels * p->opt.budget_ms / ms);
+        if (ms > p->opt.budget_ms || fit > p->pixel_cap) p->pixel_cap = fit;
+        grow = true;
+    }
+    // Regions not measured yet may cost more than the measured ones: at most double.
+    if (grow && p->ms_per_pixel > 0.0) p->tile = EdgeFor(p, p->ms_per_pixel, 2 * p->tile);
+}
+
+static bool SameView(const FrameInputs* a, const FrameInputs* b) {
+    return a->mouse[0] == b->mouse[0] && a->mouse[1] == b->mouse[1] && a->mouse_buttons == b->mouse_buttons &&
+           a->resolution[0] == b->resolution[0] && a->resolution[1] == b->resolution[1];
+}
+
+static void StartPass(ProgressiveRender* p, const FrameInputs* now) {
+    p->inputs = *now;
+    p->started = true;
+    p->complete = false;
+    p->cursor_x = p->cursor_y = 0;
+    p->band = 0;
+    p->pixels_done = 0;
+    p->generation++;
+    p->pass_started_at = NowSeconds();
+    p->pass_gpu_ms = 0.0;
+    p->pass_tiles = 0;
+}
+
+static bool Resize(ProgressiveRender* p, int w, int h) {
+    DestroyRenderTarget(&p->target);
+    free(p->cell_cost);
+    p->cells_x = (w + PROGRESSIVE_CELL - 1) / PROGRESSIVE_CELL;
+    p->cells_y = (h + PROGRESSIVE_CELL - 1) / PROGRESSIVE_CELL;
+    p->cell_cost = (float*)calloc((size_t)p->cells_x * p->cells_y, sizeof(float));
+    if (!p->cell_cost || !CreateRenderTarget(&p->target, w, h, GL_RGBA8)) {
+        DestroyRenderTarget(&p->target);
+        free(p->cell_cost);
+        p->cell_cost = NULL;
+        return false;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, p->target.fbo);
+    glClearColor(0.f, 0.f, 0.f, 1.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    p->started = false;
+    return true;
+}
+
+bool ProgressiveBegin(ProgressiveRender* p, int w, int h, const FrameInputs* now, bool animating) {
+    p->frame_tiles = 0;
+    if ((p->target.width != w || p->target.height != h) && !Resize(p, w, h)) return false;
+    Harvest(p);
+    bool seek = !animating && now->time != p->inputs.time;
+    if (!p->started || !SameView(now, &p->inputs) || seek) StartPass(p, now);
+    else if (p->complete && now->time != p->inputs.time) StartPass(p, now); // running time: next image
+    if (p->complete) return false;
+    if (p->fence) {
+        // The previous frame's tiles are still running: queue nothing behind them.
+        if (glClientWaitSync(p->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED) return false;
+        glDeleteSync(p->fence);
+        p->fence = NULL;
+    }
+    return !p->slot[p->next_slot].pending; // else its results come back first
+}
+
+int ProgressiveDrawTiles(ProgressiveRender* p) {
+    int slot = p->next_slot;
+    p->next_slot = (slot + 1) % PROGRESSIVE_QUERY_RING;
+
+    int W = p->target.width, H = p->target.height;
+    glBindFramebuffer(GL_FRAMEBUFFER, p->target.fbo);
+    glViewport(0, 0, W, H);
+    glEnable(GL_SCISSOR_TEST);
+    glQueryCounter(p->slot[slot].query[0], GL_TIMESTAMP);
+    double predicted = 0.0;
+    uint64_t pixels = 0;
+    int drawn = 0;
+    while (!p->complete && drawn < PROGRESSIVE_FRAME_TILES) {
+        // A band is as tall as its costliest measured cells allow.
+        if (p->cursor_x == 0)
+            p->band = EdgeFor(p, MapCost(p, 0, p->cursor_y, W, p->tile < H - p->cursor_y ? p->tile : H - p->cursor_y), p->tile);
+        int tw = W - p->cursor_x < p->band ? W - p->cursor_x : p->band;
+        int th = H - p->cursor_y < p->band ? H - p->cursor_y : p->band;
+        double rate = MapCost(p, p->cursor_x, p->cursor_y, tw, th);
+        double cost = (rate > p->ms_per_pixel ? rate : p->ms_per_pixel) * (double)tw * (double)th;
+        // At least one tile per frame; only one while the cost is unknown.
+        if (drawn && (p->ms_per_pixel <= 0.0 || predicted + cost > p->opt.budget_ms ||
+                      pixels + (uint64_t)tw * (uint64_t)th > p->pixel_cap)) break;
+        // Bands go top to bottom; GL's y is up.
+        int* r = p->slot[slot].rect[drawn];
+        r[0] = p->cursor_x; r[1] = p->cursor_y; r[2] = tw; r[3] = th;
+        glScissor(p->cursor_x, H - p->cursor_y - th, tw, th);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glQueryCounter(p->slot[slot].query[drawn + 1], GL_TIMESTAMP);
+        glFlush(); // one submission per tile, so none is longer than a tile
+        predicted += cost;
+        pixels += (uint64_t)tw * (uint64_t)th;
+        ++drawn;
+        p->cursor_x += tw;
+        if (p->cursor_x >= W) {
+            p->cursor_x = 0;
+            p->cursor_y += th;
+            p->complete = p->cursor_y >= H;
+        }
+    }
+    glDisable(GL_SCISSOR_TEST);
+    p->slot[slot].tiles = drawn;
+    p->slot[slot].generation = p->generation;
+    p->slot[slot].pending = true;
+    p->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    p->pixels_done += pixels;
+    p->pass_tiles += drawn;
+    p->frame_tiles = drawn;
+    if (p->complete) {
+        p->passes++;
+        p->done_generation = p->generation;
+        p->last_pass_seconds = NowSeconds() - p->pass_started_at;
+        p->last_pass_gpu_ms = p->pass_gpu_ms; // this frame's tiles are added as they come back
+        p->last_pass_tiles = p->pass_tiles;
+    }
+    return drawn;
+}
+
+void ProgressivePresent(ProgressiveRender* p, GLuint dst_fbo) {
+    int W = p->target.width, H = p->target.height;
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, p->target.fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst_fbo);
+    glBlitFramebuffer(0, 0, W, H, 0, 0, W, H, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, dst_fbo);
+}
+
+double ProgressiveProgress(const ProgressiveRender* p) {
+    uint64_t total = (uint64_t)p->target.width * (uint64_t)p->target.height;
+    if (!p->started || !total) return 0.0;
+    return p->complete ? 1.0 : (double)p->pixels_done / (double)total;
+}
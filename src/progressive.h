@@ -0,0 +1,102 @@
+// progressive.h — very expensive shaders drawn a few scissor tiles per frame
+//
+// A pass draws the image into a persistent target tile by tile, and every frame
+// presents the target as it is: finished tiles of this pass over the previous
+// pass's image. Each frame only draws as many tiles as fit in budget_ms of GPU time,
+// so a shader that needs seconds per image never holds one submission long enough
+// for the driver watchdog, and the loop keeps handling input and reloads.
+//
+// GPU time comes from GL_TIMESTAMP queries between the tiles (they nest inside the
+// frame's GL_TIME_ELAPSED query), read back without waiting. Cost differs across the
+// image (a cheap sky, an expensive surface), so each tile's cost per pixel goes into a
+// coarse map of PROGRESSIVE_CELL px cells, and the next pass sizes its bands and
+// predicts its tiles from the map where it knows the region. Elsewhere a global
+// estimate that rises at once and falls slowly stands in, and a frame draws at most
+// twice the pixels of the last one that fit (a slow start). Tiles aim for about half
+// the budget each, so one can't blow it by much. Until the first measurement, and
+// after a program change, one small tile per frame goes out. While the previous
+// frame's tiles are still on the GPU no new ones are queued.
+//
+// A pass renders with the inputs it started with. A new pass starts when the size,
+// the mouse or the program changes, or when time is paused and moved (a seek); with
+// time running, the next pass picks up the new time once the current one completes.
+
+#ifndef SHADERDEVEL_PROGRESSIVE_H
+#define SHADERDEVEL_PROGRESSIVE_H
+
+#include "platform.h"
+#include "render_target.h"
+#include "uniforms.h"
+#include <glad/gl.h>
+
+#define PROGRESSIVE_QUERY_RING  4
+#define PROGRESSIVE_FRAME_TILES 32 // drawn per frame at most
+#define PROGRESSIVE_MIN_TILE    16
+#define PROGRESSIVE_CELL        16 // cost map resolution in pixels
+
+typedef struct {
+    double budget_ms; // GPU time per frame for tiles
+    int    max_tile;  // tile edge limit in pixels
+} ProgressiveOptions;
+
+typedef struct {
+    ProgressiveOptions opt;
+    RenderTarget target;
+    FrameInputs  inputs;       // of the pass in flight
+    bool         started;      // inputs hold a pass
+    bool         complete;     // every tile of the pass is drawn
+    int          cursor_x, cursor_y; // next tile, in bands from the top
+    int          band;         // edge of the tiles in the current band
+    int          tile;         // edge for the next band
+    double       ms_per_pixel; // smoothed GPU cost, 0 = unknown
+    uint64_t     pixel_cap;    // per frame, from what recent frames managed in budget
+    float*       cell_cost;    // ms per pixel by cell, 0 = not measured
+    int          cells_x, cells_y;
+    uint64_t     pixels_done;  // this pass
+    int          generation;   // counts passes, to attribute query results that arrive late
+    int          cost_generation; // first pass whose results count toward the cost
+
+    struct {
+        GLuint query[PROGRESSIVE_FRAME_TILES + 1]; // timestamps before, between and after the tiles
+        int    rect[PROGRESSIVE_FRAME_TILES][4];   // x, y, w, h
+        int    tiles;
+        int    generation;
+        bool   pending;
+    } slot[PROGRESSIVE_QUERY_RING];
+    int          next_slot;
+    GLsync       fence;        // after the last frame's tiles
+
+    double       pass_started_at;
+    double       pass_gpu_ms;
+    int          pass_tiles;
+    int          frame_tiles;  // drawn in the last frame
+    // the last completed pass
+    int          passes;
+    int          done_generation;
+    double       last_pass_seconds;
+    double       last_pass_gpu_ms;  // grows for a frame or two after completion, as results arrive
+    int          last_pass_tiles;
+} ProgressiveRender;
+
+void ProgressiveDefaultOptions(ProgressiveOptions* opt, double budget_ms);
+// Needs a current context.
+void ProgressiveInit(ProgressiveRender* p, const ProgressiveOptions* opt);
+void ProgressiveShutdown(ProgressiveRender* p);
+
+// The next Begin starts a new pass; forget_cost drops the cost estimate too (a new program).
+void ProgressiveRestart(ProgressiveRender* p, bool forget_cost);
+// Sizes the target for w x h and decides which pass to draw given this frame's inputs
+// (now; animating = time is running). Returns false when there is nothing to draw:
+// the pass is complete and nothing changed, or the GPU is still on the last frame's
+// tiles. Otherwise the caller uploads p->inputs, binds the program and quad VAO and
+// calls DrawTiles.
+bool ProgressiveBegin(ProgressiveRender* p, int w, int h, const FrameInputs* now, bool animating);
+// Draws this frame's tiles (at least one) into the target with the caller's program;
+// returns how many.
+int  ProgressiveDrawTiles(ProgressiveRender* p);
+// Copies the target to dst_fbo.
+void ProgressivePresent(ProgressiveRender* p, GLuint dst_fbo);
+// Share of the pass in flight that is drawn, 0..1.
+double ProgressiveProgress(const ProgressiveRender* p);
+
+#endif // SHADERDEVEL_PROGRESSIVE_H
@@ -0,0 +1,338 @@
+// render_graph.c — see render_graph.h
+#include "render_graph.h"
+#include "shader.h"
+#include "uniforms.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================ Parsing ==============================
+static bool ParseFormat(const char* s, GLenum* out) {
+    if (!strcmp(s, "rgba8"))   { *out = GL_RGBA8;   return true; }
+    if (!strcmp(s, "rgba16f")) { *out = GL_RGBA16F; return true; }
+    if (!strcmp(s, "rgba32f")) { *out = GL_RGBA32F; return true; }
+    return false;
+}
+
+static bool IsImageFile(const char* s) {
+    static const char* const ext[] = { ".png", ".ppm", ".pgm", ".pnm" };
+    size_t n = strlen(s);
+    for (size_t i = 0; i < sizeof(ext) / sizeof(ext[0]); ++i)
+        if (n > 4 && !strcmp(s + n - 4, ext[i])) return true;
+    return false;
+}
+
+static int FindPass(const RenderGraph* g, const char* name) {
+    for (int i = 0; i < g->count; ++i) if (!strcmp(g->pass[i].name, name)) return i;
+    return -1;
+}
+
+// Inputs name passes that may be declared later, so they are resolved after parsing.
+typedef struct {
+    char ref[RENDER_GRAPH_MAX_PASSES][RENDER_GRAPH_CHANNELS][40];
+    int  line[RENDER_GRAPH_MAX_PASSES];
+} PendingInputs;
+
+static bool ParseLine(RenderGraph* g, PendingInputs* pending, char* line, int lineno, const char* dir, char* log, int logsz) {
+    char* hash = strchr(line, '#');
+    if (hash) *hash = 0;
+    char* tok[3 + RENDER_GRAPH_CHANNELS + 1];
+    int ntok = 0;
+    for (char* t = strtok(line, " \t\r\n"); t; t = strtok(NULL, " \t\r\n")) {
+        if (ntok == (int)(sizeof(tok) / sizeof(tok[0]))) { snprintf(log, logsz, "%s:%d: too many fields", g->path, lineno); return false; }
+        tok[ntok++] = t;
+    }
+    if (ntok == 0) return true;
+    if (strcmp(tok[0], "pass") || ntok < 3) {
+        snprintf(log, logsz, "%s:%d: expected 'pass <name> <fragment shader> [options]'", g->path, lineno);
+        return false;
+    }
+    if (g->count == RENDER_GRAPH_MAX_PASSES) { snprintf(log, logsz, "%s:%d: more than %d passes", g->path, lineno, RENDER_GRAPH_MAX_PASSES); return false; }
+    if (strlen(tok[1]) >= sizeof(g->pass[0].name) || FindPass(g, tok[1]) >= 0) {
+        snprintf(log, logsz, "%s:%d: pass name '%s' is too long or already used", g->path, lineno, tok[1]);
+        return false;
+    }
+
+    int idx = g->count++;
+    RenderPass* p = &g->pass[idx];
+    snprintf(p->name, sizeof(p->name), "%s", tok[1]);
+    if (dir[0]) snprintf(p->frag_path, sizeof(p->frag_path), "%s%s", dir, tok[2]);
+    else        snprintf(p->frag_path, sizeof(p->frag_path), "%s", tok[2]);
+    p->format = GL_RGBA8;
+    for (int c = 0; c < RENDER_GRAPH_CHANNELS; ++c) p->input[c] = p->image_handle[c] = -1;
+    pending->line[idx] = lineno;
+
+    for (int i = 3; i < ntok; ++i) {
+        char* eq = strchr(tok[i], '=');
+        if (!eq) { snprintf(log, logsz, "%s:%d: expected key=value, got '%s'", g->path, lineno, tok[i]); return false; }
+        *eq = 0;
+        const char* key = tok[i];
+        const char* val = eq + 1;
+        int ch = -1;
+        if (!strcmp(key, "format")) {
+            if (!ParseFormat(val, &p->format)) { snprintf(log, logsz, "%s:%d: unknown format '%s'", g->path, lineno, val); return false; }
+        } else if (!strncmp(key, "iChannel", 8) && isdigit((unsigned char)key[8]) && !key[9] &&
+                   (ch = key[8] - '0') < RENDER_GRAPH_CHANNELS) {
+            if (IsImageFile(val)) snprintf(p->image[ch], sizeof(p->image[ch]), "%s%s", dir, val);
+            else snprintf(pending->ref[idx][ch], sizeof(pending->ref[idx][ch]), "%s", val);
+        } else {
+            snprintf(log, logsz, "%s:%d: unknown option '%s'", g->path, lineno, key);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool ResolveInputs(RenderGraph* g, const PendingInputs* pending, char* log, int logsz) {
+    for (int i = 0; i < g->count; ++i) {
+        RenderPass* p = &g->pass[i];
+        for (int c = 0; c < RENDER_GRAPH_CHANNELS; ++c) {
+            const char* ref = pending->ref[i][c];
+            if (!ref[0]) continue;
+            char name[40];
+            snprintf(name, sizeof(name), "%s", ref);
+            size_t n = strlen(name);
+            bool prev = n > 5 && !strcmp(name + n - 5, ".prev");
+            if (prev) name[n - 5] = 0;
+            int src = FindPass(g, name);
+            if (src < 0) { snprintf(log, logsz, "%s:%d: iChannel%d names unknown pass '%s'", g->path, pending->line[i], c, name); return false; }
+            if (src == i) prev = true; // a pass can only see its own last frame
+            p->input[c] = src;
+            p->input_prev[c] = prev;
+            if (prev) g->pass[src].feedback = true;
+        }
+    }
+    return true;
+}
+
+// Kahn's algorithm over this-frame edges; .prev reads don't constrain the order.
+static bool SortPasses(RenderGraph* g, char* log, int logsz) {
+    int indegree[RENDER_GRAPH_MAX_PASSES] = {0};
+    for (int i = 0; i < g->count; ++i)
+        for (int c = 0; c < RENDER_GRAPH_CHANNELS; ++c)
+            if (g->pass[i].input[c] >= 0 && !g->pass[i].input_prev[c]) indegree[i]++;
+
+    int n = 0;
+    bool placed[RENDER_GRAPH_MAX_PASSES] = {0};
+    while (n < g->count) {
+        int next = -1;
+        for (int i = 0; i < g->count && next < 0; ++i) if (!placed[i] && indegree[i] == 0) next = i; // keeps file order among ready passes
+        if (next < 0) {
+            snprintf(log, logsz, "%s: passes form a cycle; read one of them as <pass>.prev", g->path);
+            return false;
+        }
+        placed[next] = true;
+        g->order[n++] = next;
+        for (int i = 0; i < g->count; ++i)
+            for (int c = 0; c < RENDER_GRAPH_CHANNELS; ++c)
+                if (g->pass[i].input[c] == next && !g->pass[i].input_prev[c]) indegree[i]--;
+    }
+    return true;
+}
+
+RenderGraph* RenderGraphLoad(const char* path, char* log, int logsz) {
+    log[0] = 0;
+    char* text = NULL; size_t size = 0;
+    if (!ReadFileUTF8(path, &text, &size)) { snprintf(log, logsz, "Failed to read render graph %s.", path); return NULL; }
+
+    RenderGraph* g = (RenderGraph*)calloc(1, sizeof(RenderGraph));
+    PendingInputs* pending = (PendingInputs*)calloc(1, sizeof(PendingInputs));
+    if (!g || !pending) {
+        free(g); free(pending); free(text);
+        snprintf(log, logsz, "Out of memory loading render graph %s.", path);
+        return NULL;
+    }
+    snprintf(g->path, sizeof(g->path), "%s", path);
+    char dir[APP_PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char* slash = NULL;
+    for (char* s = dir; *s; ++s) if (*s == '/' || *s == '\\') slash = s;
+    if (slash) slash[1] = 0; else dir[0] = 0;
+
+    bool ok = true;
+    int lineno = 0;
+    for (char* line = text; ok && line; ) {
+        char* nl = strchr(line, '\n');
+        if (nl) *nl = 0;
+        ok = ParseLine(g, pending, line, ++lineno, dir, log, logsz);
+        line = nl ? nl + 1 : NULL;
+    }
+    free(text);
+    if (ok && g->count == 0) { snprintf(log, logsz, "%s: no passes declared", path); ok = false; }
+    ok = ok && ResolveInputs(g, pending, log, logsz) && SortPasses(g, log, logsz);
+    free(pending);
+    if (!ok) { free(g); return NULL; }
+
+    g->output = FindPass(g, "Image");
+    if (g->output < 0) g->output = g->count - 1;
+    return g;
+}
+
+void RenderGraphDestroy(RenderGraph* g) {
+    if (!g) return;
+    for (int i = 0; i < g->count; ++i) {
+        RenderPass* p = &g->pass[i];
+        if (p->program) glDeleteProgram(p->program);
+        for (int c = 0; c < RENDER_GRAPH_CHANNELS && g->textures; ++c)
+            if (p->image_handle[c] >= 0) TextureCacheRelease(g->textures, p->image_handle[c]);
+        DestroyRenderTarget(&p->target[0]);
+        DestroyRenderTarget(&p->target[1]);
+    }
+    free(g);
+}
+
+void RenderGraphAttachTextures(RenderGraph* g, TextureCache* c) {
+    g->textures = c;
+    for (int i = 0; i < g->count; ++i)
+        for (int ch = 0; ch < RENDER_GRAPH_CHANNELS; ++ch)
+            if (g->pass[i].image[ch][0]) g->pass[i].image_handle[ch] = TextureCacheAcquire(c, g->pass[i].image[ch]);
+}
+
+// ============================ Programs =============================
+static void InstallProgram(RenderPass* p, GLuint prog) {
+    if (p->program) glDeleteProgram(p->program);
+    p->program = prog;
+    p->uTime       = glGetUniformLocation(prog, "uTime");
+    p->uResolution = glGetUniformLocation(prog, "uResolution");
+    p->uMouse      = glGetUniformLocation(prog, "uMouse");
+    p->frame_inputs = SetupProgramUniforms(prog);
+    glUseProgram(prog);
+    for (int c = 0; c < RENDER_GRAPH_CHANNELS; ++c) {
+        char name[16];
+        snprintf(name, sizeof(name), "iChannel%d", c);
+        p->uChannel[c] = glGetUniformLocation(prog, name);
+        if (p->uChannel[c] >= 0) glUniform1i(p->uChannel[c], c); // texture unit == channel
+    }
+    p->uChannelResolution = glGetUniformLocation(prog, "iChannelResolution");
+    p->dirty = true;
+}
+
+bool RenderGraphBuildPrograms(RenderGraph* g, const char* vert_path, char* log, int logsz) {
+    for (int i = 0; i < g->count; ++i) {
+        GLuint prog = 0;
+        BuildInfo info = {0};
+        if (!LoadAndBuildProgramFromFiles(vert_path, g->pass[i].frag_path, &prog, &info, log, logsz)) {
+            size_t n = strlen(log);
+            snprintf(log + n, (size_t)logsz - n, "%s(pass %s, %s)", n ? "\n" : "", g->pass[i].name, g->pass[i].frag_path);
+            return false;
+        }
+        InstallProgram(&g->pass[i], prog);
+        g->pass[i].source_hash = info.source_hash;
+    }
+    return true;
+}
+
+int RenderGraphSubmitChanged(RenderGraph* g, ShaderCompiler* c, const char* vert_path, const char* const* changed, int changed_count, bool all, double requested_at) {
+    IncludeCache* includes = GetIncludeCache();
+    // The vertex stage is shared by every pass.
+    all = all || ShaderDependsOnAny(includes, vert_path, changed, changed_count);
+    int queued = 0;
+    for (int i = 0; i < g->count; ++i) {
+        RenderPass* p = &g->pass[i];
+        if (!all && !ShaderDependsOnAny(includes, p->frag_path, changed, changed_count)) continue;
+        ShaderCompilerSubmitTagged(c, i, vert_path, p->frag_path, all ? 0 : p->source_hash, requested_at);
+        ++queued;
+    }
+    return queued;
+}
+
+void RenderGraphSwapProgram(RenderGraph* g, int tag, GLuint prog, uint64_t source_hash) {
+    if (tag < 0 || tag >= g->count) { glDeleteProgram(prog); return; }
+    InstallProgram(&g->pass[tag], prog);
+    g->pass[tag].source_hash = source_hash;
+}
+
+// ============================ Rendering ============================
+static bool EnsureTargets(RenderGraph* g, int w, int h) {
+    if (w == g->width && h == g->height && g->pass[0].target[0].fbo) return true;
+    for (int i = 0; i < g->count; ++i) {
+        RenderPass* p = &g->pass[i];
+        for (int k = 0; k < 2; ++k) {
+            DestroyRenderTarget(&p->target[k]);
+            if (k == 1 && !p->feedback) continue;
+            if (!CreateRenderTarget(&p->target[k], w, h, p->format)) return false;
+            // Feedback starts from black, not whatever the allocation held.
+            glBindFramebuffer(GL_FRAMEBUFFER, p->target[k].fbo);
+            glClearColor(0.f, 0.f, 0.f, 0.f);
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+        p->current = 0;
+        p->dirty = true;
+    }
+    g->width = w; g->height = h;
+    return true;
+}
+
+// Channel c's image (the cache's placeholder until it loads), 0 if it has none.
+static GLuint ImageTexture(const RenderGraph* g, const RenderPass* p, int c, int* w, int* h) {
+    if (p->image_handle[c] < 0) { *w = *h = 0; return 0; }
+    return TextureCacheTexture(g->textures, p->image_handle[c], w, h);
+}
+
+// Only uniforms the program actually declares count (an unused one has location -1).
+// std140 block members are all active, so a FrameInputs reader counts as using both.
+static bool PassNeedsRender(const RenderGraph* g, const RenderPass* p, bool time_changed, bool mouse_changed) {
+    if (p->dirty) return true;
+    int w, h;
+    for (int c = 0; c < RENDER_GRAPH_CHANNELS; ++c)
+        if (ImageTexture(g, p, c, &w, &h) != p->image_bound[c]) return true; // arrived or reloaded
+    if (time_changed && (p->uTime >= 0 || p->frame_inputs)) return true;
+    if (mouse_changed && (p->uMouse >= 0 || p->frame_inputs)) return true;
+    for (int c = 0; c < RENDER_GRAPH_CHANNELS; ++c)
+        if (p->input[c] >= 0 && !p->input_prev[c] && g->pass[p->input[c]].rendered) return true;
+    return false;
+}
+
+void RenderGraphRender(RenderGraph* g, float time, float mouse_x, float mouse_y, int w, int h, GLuint dst_fbo) {
+    if (!EnsureTargets(g, w, h)) return;
+    bool time_changed  = time != g->last_time;
+    bool mouse_changed = mouse_x != g->last_mouse_x || mouse_y != g->last_mouse_y;
+    g->last_time = time; g->last_mouse_x = mouse_x; g->last_mouse_y = mouse_y;
+
+    for (int i = 0; i < g->count; ++i) { g->pass[i].frame_start = g->pass[i].current; g->pass[i].rendered = false; }
+    g->passes_rendered = 0;
+    glViewport(0, 0, w, h);
+    for (int n = 0; n < g->count; ++n) {
+        RenderPass* p = &g->pass[g->order[n]];
+        if (!p->program || !PassNeedsRender(g, p, time_changed, mouse_changed)) continue;
+
+        int write = p->feedback ? 1 - p->frame_start : 0;
+        float res[RENDER_GRAPH_CHANNELS][3] = { { 0 } };
+        for (int c = 0; c < RENDER_GRAPH_CHANNELS; ++c) {
+            glActiveTexture(GL_TEXTURE0 + c);
+            if (p->input[c] < 0) {
+                int iw, ih;
+                p->image_bound[c] = ImageTexture(g, p, c, &iw, &ih);
+                glBindTexture(GL_TEXTURE_2D, p->image_bound[c]);
+                res[c][0] = (float)iw; res[c][1] = (float)ih; res[c][2] = iw ? 1.f : 0.f;
+                continue;
+            }
+            const RenderPass* src = &g->pass[p->input[c]];
+            int read = p->input_prev[c] ? src->frame_start : src->current;
+            glBindTexture(GL_TEXTURE_2D, src->target[read].color);
+            res[c][0] = (float)w; res[c][1] = (float)h; res[c][2] = 1.f;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, p->target[write].fbo);
+        glUseProgram(p->program);
+        if (p->uTime >= 0)       glUniform1f(p->uTime, time);
+        if (p->uResolution >= 0) glUniform2f(p->uResolution, (float)w, (float)h);
+        if (p->uMouse >= 0)      glUniform2f(p->uMouse, mouse_x, mouse_y);
+        if (p->uChannelResolution >= 0) glUniform3fv(p->uChannelResolution, RENDER_GRAPH_CHANNELS, res[0]);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+        p->current = write;
+        p->dirty = false;
+        p->rendered = true;
+        g->passes_rendered++;
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    // The output is kept in its own target so an idle frame is just this copy.
+    const RenderPass* out = &g->pass[g->output];
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, out->target[out->current].fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst_fbo);
+    glBlitFramebuffer(0, 0, w, h, 0, 0, w, h, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, dst_fbo);
+}
@@ -0,0 +1,89 @@
+// render_graph.h — multi-pass rendering described by a small text file
+//
+// One line per pass, Shadertoy style (Buffer A-D feeding Image):
+//
+//   # name     fragment shader   [format=rgba8|rgba16f|rgba32f]  [iChannelN=<pass>[.prev]|<image>]
+//   pass BufferA  bufferA.frag   format=rgba16f  iChannel0=BufferA.prev  iChannel1=noise.png
+//   pass Image    image.frag     iChannel0=BufferA
+//
+// Paths are relative to the graph file; every pass shares the front end's vertex
+// shader. iChannelN=X samples X's output from this frame (X runs first), X.prev the
+// previous frame's, which gives X a ping-pong pair of targets; a pass reading itself
+// always means .prev. A .png, .ppm, .pgm or .pnm file is an image input, loaded by
+// the texture cache given to RenderGraphAttachTextures (black until it arrives). The
+// pass named Image (else the last one) is shown. Passes declaring uniform vec3
+// iChannelResolution[4] get their inputs' sizes there.
+//
+// Passes run in topological order. A pass is re-rendered only when something it sees
+// changed: uTime/uMouse (if it declares them; any FrameInputs block reader counts as
+// both), the size, its program, a this-frame input that re-rendered, or an image
+// input that finished loading.
+// While time is paused that leaves idle passes (and frozen feedback) untouched.
+// Each pass is its own compile tag, so reloading one shader rebuilds one program.
+
+#ifndef SHADERDEVEL_RENDER_GRAPH_H
+#define SHADERDEVEL_RENDER_GRAPH_H
+
+#include "platform.h"
+#include "compiler.h"
+#include "render_target.h"
+#include "texture_cache.h"
+#include <glad/gl.h>
+
+#define RENDER_GRAPH_MAX_PASSES 8
+#define RENDER_GRAPH_CHANNELS   4
+
+typedef struct {
+    char         name[32];
+    char         frag_path[APP_PATH_MAX];
+    GLenum       format;
+    int          input[RENDER_GRAPH_CHANNELS];      // pass index, -1 = unbound
+    bool         input_prev[RENDER_GRAPH_CHANNELS]; // previous frame's output
+    char         image[RENDER_GRAPH_CHANNELS][APP_PATH_MAX]; // image inputs, "" = none
+    int          image_handle[RENDER_GRAPH_CHANNELS];        // in the attached cache, -1 = none
+    GLuint       image_bound[RENDER_GRAPH_CHANNELS];         // texture the last render read
+    bool         feedback;   // read as .prev by someone: two targets
+    RenderTarget target[2];
+    int          current;    // target holding the newest output
+    int          frame_start;// current at the start of this frame (what .prev reads)
+    GLuint       program;
+    uint64_t     source_hash; // ProgramSourceHash of program; rebuilds to the same sources are skipped
+    GLint        uTime, uResolution, uMouse, uChannel[RENDER_GRAPH_CHANNELS], uChannelResolution;
+    bool         frame_inputs; // reads the FrameInputs block (uniforms.h)
+    bool         dirty;      // program or targets changed since it last rendered
+    bool         rendered;   // this frame
+} RenderPass;
+
+typedef struct {
+    char       path[APP_PATH_MAX];
+    RenderPass pass[RENDER_GRAPH_MAX_PASSES];
+    int        count;
+    int        order[RENDER_GRAPH_MAX_PASSES]; // topological
+    int        output;
+    int        width, height;                  // target size
+    float      last_time, last_mouse_x, last_mouse_y;
+    int        passes_rendered;                // last frame, for stats
+    TextureCache* textures;                    // image inputs, NULL until attached
+} RenderGraph;
+
+// Parses and orders the graph; no GL. NULL with a "file:line: reason" log on error.
+RenderGraph* RenderGraphLoad(const char* path, char* log, int logsz);
+// Releases the image inputs too; the cache must outlive the graph.
+void         RenderGraphDestroy(RenderGraph* g);
+// Acquires every image input from c (loads them in the background). Once, before rendering.
+void         RenderGraphAttachTextures(RenderGraph* g, TextureCache* c);
+
+// Blocking build of every pass (startup). On failure log names the pass.
+bool RenderGraphBuildPrograms(RenderGraph* g, const char* vert_path, char* log, int logsz);
+// Queues a rebuild (tag = pass index) of every pass whose shaders, or anything they
+// include, are among the changed paths (normalized, see shader_include.h), or of all
+// of them when all is set. Returns the number queued.
+int  RenderGraphSubmitChanged(RenderGraph* g, ShaderCompiler* c, const char* vert_path, const char* const* changed, int changed_count, bool all, double requested_at);
+// Installs a finished program for the pass the result's tag names; deletes it if stale.
+void RenderGraphSwapProgram(RenderGraph* g, int tag, GLuint prog, uint64_t source_hash);
+
+// Runs the dirty passes at w x h and copies the output pass into dst_fbo. Uses the
+// quad VAO bound by the caller.
+void RenderGraphRender(RenderGraph* g, float time, float mouse_x, float mouse_y, int w, int h, GLuint dst_fbo);
+
+#endif // SHADERDEVEL_RENDER_GRAPH_H
@@ -0,0 +1,36 @@
+// render_target.c — see render_target.h
+#include "render_target.h"
+
+#include <string.h>
+
+bool CreateRenderTarget(RenderTarget* rt, int width, int height, GLenum internal_format) {
+    memset(rt, 0, sizeof(*rt));
+    if (width <= 0 || height <= 0) return false;
+
+    glGenTextures(1, &rt->color);
+    glBindTexture(GL_TEXTURE_2D, rt->color);
+    // format/type only describe the (absent) client data, any matching pair will do
+    glTexImage2D(GL_TEXTURE_2D, 0, (GLint)internal_format, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &rt->fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, rt->fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, rt->color, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE) { DestroyRenderTarget(rt); return false; }
+
+    rt->internal_format = internal_format;
+    rt->width = width; rt->height = height;
+    return true;
+}
+
+void DestroyRenderTarget(RenderTarget* rt) {
+    if (rt->fbo)   { glDeleteFramebuffers(1, &rt->fbo); }
+    if (rt->color) { glDeleteTextures(1, &rt->color); }
+    memset(rt, 0, sizeof(*rt));
+}
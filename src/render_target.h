@@ -0,0 +1,18 @@
+// render_target.h — single-attachment offscreen framebuffer
+#ifndef SHADERDEVEL_RENDER_TARGET_H
+#define SHADERDEVEL_RENDER_TARGET_H
+
+#include "platform.h"
+#include <glad/gl.h>
+
+typedef struct {
+    GLuint fbo;
+    GLuint color;           // GL_TEXTURE_2D, linear filtered, clamped
+    GLenum internal_format; // e.g. GL_RGBA8, GL_RGBA16F
+    int    width, height;
+} RenderTarget;
+
+bool CreateRenderTarget(RenderTarget* rt, int width, int height, GLenum internal_format);
+void DestroyRenderTarget(RenderTarget* rt);
+
+#endif // SHADERDEVEL_RENDER_TARGET_H
@@ -0,0 +1,174 @@
+// scheduler.c — see scheduler.h
+#include "scheduler.h"
+
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+struct FrameScheduler {
+    SchedulerOptions opt;
+    double           interval;  // seconds between frame starts under the cap, 0 = none
+    double           next_due;  // NowSeconds() the next capped frame may start
+    volatile int32_t dirty;
+
+    int              frames;    // since the last TakeStats
+    double           stats_since, stats_cpu, waited;
+
+#ifdef _WIN32
+    HANDLE           wake_event;
+    HANDLE           timer;
+#else
+    int              wake_pipe[2];
+    int              timer_fd;
+#endif
+};
+
+// ============================== Win32 ==============================
+#ifdef _WIN32
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+static bool PlatformInit(FrameScheduler* s) {
+    s->wake_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    if (!s->wake_event) return false;
+    // High-resolution timers need Windows 10 1803; older systems get the ordinary kind.
+    s->timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!s->timer) s->timer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+    if (!s->timer) { CloseHandle(s->wake_event); return false; }
+    return true;
+}
+static void PlatformShutdown(FrameScheduler* s) { CloseHandle(s->timer); CloseHandle(s->wake_event); }
+static void PlatformWake(FrameScheduler* s) { SetEvent(s->wake_event); }
+
+// deadline 0 = none. Window messages end the wait too, so the caller can pump them.
+static void PlatformWait(FrameScheduler* s, double deadline, int max_wait_ms) {
+    HANDLE handles[2] = { s->wake_event, s->timer };
+    DWORD count = 1;
+    if (deadline > 0.0) {
+        LARGE_INTEGER due;
+        due.QuadPart = -(LONGLONG)((deadline - NowSeconds()) * 1e7); // relative, 100 ns units
+        if (due.QuadPart >= 0) return;
+        if (SetWaitableTimer(s->timer, &due, 0, NULL, NULL, FALSE)) count = 2;
+    }
+    MsgWaitForMultipleObjectsEx(count, handles, max_wait_ms < 0 ? INFINITE : (DWORD)max_wait_ms,
+                                QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+    if (count == 2) CancelWaitableTimer(s->timer);
+}
+
+// ============================== Linux ==============================
+#else
+
+static bool PlatformInit(FrameScheduler* s) {
+    if (pipe2(s->wake_pipe, O_NONBLOCK | O_CLOEXEC) != 0) return false;
+    s->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (s->timer_fd < 0) { close(s->wake_pipe[0]); close(s->wake_pipe[1]); return false; }
+    return true;
+}
+static void PlatformShutdown(FrameScheduler* s) {
+    close(s->timer_fd);
+    close(s->wake_pipe[0]);
+    close(s->wake_pipe[1]);
+}
+static void PlatformWake(FrameScheduler* s) { char c = 1; ssize_t r = write(s->wake_pipe[1], &c, 1); (void)r; }
+
+static void PlatformWait(FrameScheduler* s, double deadline, int max_wait_ms) {
+    bool timed = false;
+    if (deadline > 0.0) {
+        if (deadline <= NowSeconds()) return;
+        // NowSeconds() is CLOCK_MONOTONIC, so the deadline can be armed as absolute time.
+        struct itimerspec its = { { 0, 0 }, { (time_t)deadline, (long)((deadline - (double)(time_t)deadline) * 1e9) } };
+        timed = timerfd_settime(s->timer_fd, TFD_TIMER_ABSTIME, &its, NULL) == 0;
+    }
+    struct pollfd fds[2] = {
+        { s->wake_pipe[0], POLLIN, 0 },
+        { s->timer_fd,     POLLIN, 0 },
+    };
+    int r = poll(fds, timed ? 2 : 1, max_wait_ms);
+    if (r > 0 && (fds[0].revents & POLLIN)) { char c[16]; while (read(s->wake_pipe[0], c, sizeof(c)) > 0) {} }
+    if (timed) {
+        uint64_t expirations;
+        ssize_t n = read(s->timer_fd, &expirations, sizeof(expirations));
+        (void)n;
+        struct itimerspec off = { { 0, 0 }, { 0, 0 } };
+        timerfd_settime(s->timer_fd, 0, &off, NULL);
+    }
+}
+
+#endif
+
+// ============================ Public API ===========================
+FrameScheduler* FrameSchedulerCreate(const SchedulerOptions* opt) {
+    FrameScheduler* s = (FrameScheduler*)calloc(1, sizeof(FrameScheduler));
+    if (!s) return NULL;
+    s->opt = *opt;
+    s->interval = opt->fps_cap > 0.0 ? 1.0 / opt->fps_cap : 0.0;
+    s->dirty = 1; // the first frame
+    s->stats_since = NowSeconds();
+    s->stats_cpu = ProcessCpuSeconds();
+    if (!PlatformInit(s)) { free(s); return NULL; }
+    return s;
+}
+
+void FrameSchedulerDestroy(FrameScheduler* s) {
+    if (!s) return;
+    PlatformShutdown(s);
+    free(s);
+}
+
+const char* FrameSchedulerModeName(const FrameScheduler* s) {
+    return s->opt.on_demand ? "on demand" : "continuous";
+}
+
+void FrameSchedulerInvalidate(FrameScheduler* s) {
+    AtomicStore32(&s->dirty, 1);
+    PlatformWake(s);
+}
+
+void FrameSchedulerNotify(void* scheduler) { PlatformWake((FrameScheduler*)scheduler); }
+
+static bool Wanted(FrameScheduler* s, bool animating) {
+    return !s->opt.on_demand || animating || AtomicLoad32(&s->dirty);
+}
+
+bool FrameSchedulerBeginFrame(FrameScheduler* s, bool animating) {
+    if (!Wanted(s, animating)) return false;
+    double now = NowSeconds();
+    if (s->interval > 0.0) {
+        if (now < s->next_due) return false;
+        // Keep the cadence, unless a stall left it more than a frame behind.
+        s->next_due = now - s->next_due > s->interval ? now + s->interval : s->next_due + s->interval;
+    }
+    AtomicExchange32(&s->dirty, 0);
+    ++s->frames;
+    return true;
+}
+
+void FrameSchedulerWait(FrameScheduler* s, bool animating, int max_wait_ms) {
+    double deadline = 0.0;
+    if (Wanted(s, animating)) {
+        if (s->interval <= 0.0) return; // due right away
+        deadline = s->next_due;
+    }
+    double t0 = NowSeconds();
+    PlatformWait(s, deadline, max_wait_ms);
+    s->waited += NowSeconds() - t0;
+}
+
+void FrameSchedulerTakeStats(FrameScheduler* s, SchedulerStats* out) {
+    double now = NowSeconds(), cpu = ProcessCpuSeconds();
+    out->frames = s->frames;
+    out->seconds = now - s->stats_since;
+    out->cpu_percent  = out->seconds > 0.0 ? (cpu - s->stats_cpu) / out->seconds * 100.0 : 0.0;
+    out->idle_percent = out->seconds > 0.0 ? s->waited / out->seconds * 100.0 : 0.0;
+    s->frames = 0;
+    s->stats_since = now;
+    s->stats_cpu = cpu;
+    s->waited = 0.0;
+}
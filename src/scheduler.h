@@ -0,0 +1,52 @@
+// scheduler.h — decides when the interactive loop renders, and sleeps in between
+//
+// Continuous mode renders every iteration (vsync, if on, does the pacing). On-demand
+// mode renders only while time is running or after something invalidated the frame:
+// mouse input, a resize, a reload. Otherwise the loop blocks in the OS until there is
+// input (MsgWaitForMultipleObjectsEx on Win32) or another thread wakes it, e.g. the
+// file watcher or compile worker through FrameSchedulerNotify. An FPS cap spaces
+// frame starts with a high-resolution waitable timer (timerfd on Linux) instead of
+// sleeping in whole milliseconds.
+
+#ifndef SHADERDEVEL_SCHEDULER_H
+#define SHADERDEVEL_SCHEDULER_H
+
+#include "platform.h"
+
+typedef struct {
+    bool   on_demand; // false: render every iteration
+    double fps_cap;   // frames per second, 0 = uncapped
+} SchedulerOptions;
+
+typedef struct {
+    int    frames;
+    double seconds;     // wall time covered
+    double cpu_percent; // process CPU time over wall time, 100 = one core busy
+    double idle_percent; // share of the wall time spent blocked in FrameSchedulerWait
+} SchedulerStats;
+
+typedef struct FrameScheduler FrameScheduler;
+
+FrameScheduler* FrameSchedulerCreate(const SchedulerOptions* opt);
+void            FrameSchedulerDestroy(FrameScheduler* s);
+const char*     FrameSchedulerModeName(const FrameScheduler* s);
+
+// The next iteration renders (on-demand mode) and any wait ends. Any thread.
+void FrameSchedulerInvalidate(FrameScheduler* s);
+// Only ends the wait, for FileWatcherSetNotify / ShaderCompilerSetNotify: the loop
+// polls them and invalidates if what arrived changes the picture. Any thread.
+void FrameSchedulerNotify(void* scheduler);
+
+// True if a frame is due now: always in continuous mode, while animating or after an
+// invalidation in on-demand mode, and in both only once the cap's interval since the
+// previous frame is up. Counts the frame and clears the invalidation.
+bool FrameSchedulerBeginFrame(FrameScheduler* s, bool animating);
+// After BeginFrame said no: blocks until a frame could be due, Invalidate is called,
+// window input arrives (Win32), or max_wait_ms passes (-1 = no limit) for work that
+// can only be polled.
+void FrameSchedulerWait(FrameScheduler* s, bool animating, int max_wait_ms);
+
+// Totals since the previous call (or creation).
+void FrameSchedulerTakeStats(FrameScheduler* s, SchedulerStats* out);
+
+#endif // SHADERDEVEL_SCHEDULER_H
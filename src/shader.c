@@ -0,0 +1,282 @@
+// shader.c — see shader.h
+#include "shader.h"
+#include "hash.h"
+#include "profiler.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+GLuint CompileShader(GLenum type, const char* src, char* logbuf, int logbufsz) {
+    PROFILE_BEGIN(type == GL_VERTEX_SHADER ? "compile vertex" : type == GL_COMPUTE_SHADER ? "compile compute" : "compile fragment");
+    GLuint sh = glCreateShader(type);
+    glShaderSource(sh, 1, &src, NULL);
+    glCompileShader(sh);
+    GLint ok = 0;
+    glGetShaderiv(sh, GL_COMPILE_STATUS, &ok); // waits for the driver
+    PROFILE_END();
+    if(!ok) {
+        GLsizei got=0;
+        glGetShaderInfoLog(sh, logbufsz, &got, logbuf);
+        glDeleteShader(sh);
+        return 0;
+    }
+    return sh;
+}
+static ProgramCache* s_program_cache = NULL;
+static IncludeCache* s_include_cache = NULL;
+static StageCache*   s_stage_cache = NULL;
+
+void SetProgramCache(ProgramCache* cache) { s_program_cache = cache; }
+ProgramCache* GetProgramCache(void) { return s_program_cache; }
+void SetStageCache(StageCache* cache) { s_stage_cache = cache; }
+StageCache* GetStageCache(void) { return s_stage_cache; }
+void SetIncludeCache(IncludeCache* cache) { s_include_cache = cache; }
+IncludeCache* GetIncludeCache(void) { return s_include_cache; }
+
+GLuint LinkProgram(GLuint vs, GLuint fs, char* logbuf, int logbufsz) {
+    return LinkProgramEx(vs, fs, false, logbuf, logbufsz);
+}
+GLuint LinkProgramEx(GLuint vs, GLuint fs, bool retrievable, char* logbuf, int logbufsz) {
+    GLuint p = glCreateProgram();
+    if (retrievable && GLAD_GL_ARB_get_program_binary) glProgramParameteri(p, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    if (vs) glAttachShader(p, vs);
+    glAttachShader(p, fs);
+    PROFILE_BEGIN("link");
+    glLinkProgram(p);
+    GLint ok = 0;
+    glGetProgramiv(p, GL_LINK_STATUS, &ok);
+    PROFILE_END();
+    if(!ok) {
+        GLsizei got=0;
+        glGetProgramInfoLog(p, logbufsz, &got, logbuf);
+        glDeleteProgram(p);
+        return 0;
+    }
+    return p;
+}
+
+bool IsComputeShaderPath(const char* path) {
+    size_t n = strlen(path);
+    return n > 5 && !strcmp(path + n - 5, ".comp");
+}
+
+uint64_t ProgramSourceHash(const char* vsrc, const char* fsrc) {
+    if (!vsrc) return StageSourceHash(GL_COMPUTE_SHADER, fsrc);
+    uint64_t h[2] = { StageSourceHash(GL_VERTEX_SHADER, vsrc), StageSourceHash(GL_FRAGMENT_SHADER, fsrc) };
+    return Hash64(h, sizeof(h), 0);
+}
+
+// From the stage cache, else compiled (and handed to the cache when there is one). With
+// a cache the stage is pinned until ReleaseStage, so another thread can't evict it first.
+static GLuint GetStage(GLenum type, const char* src, BuildInfo* info, char* logbuf, int logbufsz) {
+    StageCache* sc = s_stage_cache;
+    uint64_t h = sc ? StageSourceHash(type, src) : 0;
+    GLuint sh = sc ? StageCacheFind(sc, type, h) : 0;
+    if (sh) return sh;
+    sh = CompileShader(type, src, logbuf, logbufsz);
+    if (!sh) { info->failed_stage = type; return 0; }
+    info->stages_compiled++;
+    if (sc) StageCacheInsert(sc, type, h, sh);
+    return sh;
+}
+
+// Once the stage is attached (or the build gave up): the cache's pin, or the object.
+static void ReleaseStage(GLuint sh) {
+    if (!sh) return;
+    if (s_stage_cache) StageCacheRelease(s_stage_cache, sh);
+    else glDeleteShader(sh);
+}
+
+bool BuildProgramFromSources(const char* vsrc, const char* fsrc, GLuint* outProg, BuildInfo* info, char* outLog, int outLogSz) {
+    BuildInfo local = {0};
+    if (!info) info = &local;
+    *outProg = 0; outLog[0] = 0;
+    info->source_hash = ProgramSourceHash(vsrc, fsrc);
+    info->unchanged = info->cache_hit = false;
+    info->stages_compiled = 0;
+    info->failed_stage = 0;
+    if (info->skip_hash && info->source_hash == info->skip_hash) { info->unchanged = true; return true; }
+
+    ProgramCache* cache = s_program_cache;
+    uint64_t key = 0;
+    if (cache) {
+        PROFILE_BEGIN("program cache load");
+        key = ProgramCacheKey(cache, vsrc, fsrc);
+        GLuint cached = ProgramCacheLoad(cache, key);
+        PROFILE_END();
+        if (cached) {
+            info->cache_hit = true;
+            *outProg = cached;
+            return true;
+        }
+    }
+
+    GLuint vs = vsrc ? GetStage(GL_VERTEX_SHADER, vsrc, info, outLog, outLogSz) : 0;
+    if(vsrc && !vs) return false;
+    GLuint fs = GetStage(vsrc ? GL_FRAGMENT_SHADER : GL_COMPUTE_SHADER, fsrc, info, outLog, outLogSz);
+    if(!fs) { ReleaseStage(vs); return false; }
+
+    GLuint prog = LinkProgramEx(vs, fs, cache != NULL, outLog, outLogSz);
+    if (s_stage_cache && prog) { if (vs) glDetachShader(prog, vs); glDetachShader(prog, fs); } // the cache owns them
+    ReleaseStage(vs);
+    ReleaseStage(fs);
+    if(!prog) return false;
+
+    if (cache) {
+        PROFILE_BEGIN("program cache store");
+        ProgramCacheStore(cache, key, prog);
+        PROFILE_END();
+    }
+    *outProg = prog;
+    return true;
+}
+
+// ============================ Defines ==============================
+static ShaderDefines s_defines;
+static bool          s_has_defines = false;
+
+void SetShaderDefines(const ShaderDefines* d) {
+    s_has_defines = d && d->count > 0;
+    if (s_has_defines) s_defines = *d;
+}
+const ShaderDefines* GetShaderDefines(void) { return s_has_defines ? &s_defines : NULL; }
+
+static bool IsIdentifier(const char* s) {
+    if (!isalpha((unsigned char)*s) && *s != '_') return false;
+    for (; *s; ++s) if (!isalnum((unsigned char)*s) && *s != '_') return false;
+    return true;
+}
+
+bool AddShaderDefine(ShaderDefines* d, const char* name, const char* value) {
+    if (strlen(name) >= sizeof(d->name[0]) || strlen(value) >= sizeof(d->value[0]) || !IsIdentifier(name)) return false;
+    if (strchr(value, '\n') || strchr(value, '\r')) return false;
+    int i = 0;
+    while (i < d->count && strcmp(d->name[i], name)) ++i;
+    if (i == SHADER_MAX_DEFINES) return false;
+    if (i == d->count) d->count++;
+    snprintf(d->name[i], sizeof(d->name[i]), "%s", name);
+    snprintf(d->value[i], sizeof(d->value[i]), "%s", value);
+    return true;
+}
+
+bool ParseShaderDefines(const char* text, ShaderDefines* out, char* log, int logsz) {
+    ShaderDefines d;
+    d.count = 0;
+    while (*text) {
+        const char* end = strchr(text, ',');
+        size_t len = end ? (size_t)(end - text) : strlen(text);
+        char item[160], *eq;
+        if (len >= sizeof(item)) { snprintf(log, logsz, "\"%.40s...\" is too long", text); return false; }
+        memcpy(item, text, len);
+        item[len] = 0;
+        if ((eq = strchr(item, '='))) *eq++ = 0;
+        if (!AddShaderDefine(&d, item, eq ? eq : "")) {
+            snprintf(log, logsz, "\"%s\": need NAME=VALUE with an identifier, at most %d of them", item, SHADER_MAX_DEFINES);
+            return false;
+        }
+        text += len + (end ? 1 : 0);
+    }
+    *out = d;
+    return true;
+}
+
+void FormatShaderDefines(const ShaderDefines* d, char* out, size_t outsz) {
+    size_t n = 0;
+    out[0] = 0;
+    for (int i = 0; i < d->count && n < outsz; ++i) {
+        int w = snprintf(out + n, outsz - n, "%s%s%s%s", i ? "," : "", d->name[i], d->value[i][0] ? "=" : "", d->value[i]);
+        if (w < 0) break;
+        n += (size_t)w;
+    }
+}
+
+// malloc'd copy of src with text put after the #version line (only comments may
+// precede it), else at the very top.
+static char* InsertAfterVersion(const char* src, const char* text) {
+    const char* at = src;
+    for (const char* line = src; *line; ) {
+        const char* p = line;
+        while (*p == ' ' || *p == '\t') ++p;
+        const char* eol = strchr(line, '\n');
+        if (!strncmp(p, "#version", 8)) { at = eol ? eol + 1 : p + strlen(p); break; }
+        if (!eol) break;
+        line = eol + 1;
+    }
+    size_t head = (size_t)(at - src), len = strlen(text), tail = strlen(at);
+    char* out = (char*)malloc(head + len + tail + 2);
+    if (!out) return NULL;
+    memcpy(out, src, head);
+    size_t n = head;
+    if (head && out[head - 1] != '\n') out[n++] = '\n';
+    memcpy(out + n, text, len);
+    memcpy(out + n + len, at, tail + 1);
+    return out;
+}
+
+char* InsertShaderDefines(const char* src, const ShaderDefines* d) {
+    size_t extra = 1;
+    for (int i = 0; i < d->count; ++i) extra += strlen(d->name[i]) + strlen(d->value[i]) + 10;
+    char* text = (char*)malloc(extra);
+    if (!text) return NULL;
+    size_t n = 0;
+    text[0] = 0;
+    for (int i = 0; i < d->count; ++i)
+        n += (size_t)sprintf(text + n, "#define %s %s\n", d->name[i], d->value[i]);
+    char* out = InsertAfterVersion(src, text);
+    free(text);
+    return out;
+}
+
+// ============================ Loading ==============================
+bool LoadShaderSources(const char* vpath, const char* fpath, char** outVsrc, char** outFsrc, ShaderFileTable files[2], char* outLog, int outLogSz) {
+    return LoadShaderSourcesEx(vpath, fpath, GetShaderDefines(), outVsrc, outFsrc, files, outLog, outLogSz);
+}
+
+bool LoadShaderSourcesEx(const char* vpath, const char* fpath, const ShaderDefines* defines, char** outVsrc, char** outFsrc, ShaderFileTable files[2], char* outLog, int outLogSz) {
+    *outVsrc = *outFsrc = NULL;
+    files[0].count = files[1].count = 0;
+    PROFILE_BEGIN("read sources");
+    IncludeCache* cache = s_include_cache ? s_include_cache : IncludeCacheCreate();
+    bool compute = IsComputeShaderPath(fpath);
+    bool ok = (compute || PreprocessShaderFile(cache, vpath, &files[0], outVsrc, outLog, outLogSz)) &&
+              PreprocessShaderFile(cache, fpath, &files[1], outFsrc, outLog, outLogSz);
+    if (cache != s_include_cache) IncludeCacheDestroy(cache);
+    PROFILE_END();
+    if (ok && compute) {
+        // Guarded, so the defines inserted below (ahead of these) win.
+        char text[160];
+        snprintf(text, sizeof(text), "#ifndef LOCAL_SIZE_X\n#define LOCAL_SIZE_X %d\n#endif\n#ifndef LOCAL_SIZE_Y\n#define LOCAL_SIZE_Y %d\n#endif\n",
+                 COMPUTE_DEFAULT_LOCAL_SIZE, COMPUTE_DEFAULT_LOCAL_SIZE);
+        char* with = InsertAfterVersion(*outFsrc, text);
+        if (!with) { snprintf(outLog, outLogSz, "Out of memory."); ok = false; }
+        else { free(*outFsrc); *outFsrc = with; }
+    }
+    if (ok && defines && defines->count > 0) {
+        char* with = InsertShaderDefines(*outFsrc, defines);
+        if (!with) { snprintf(outLog, outLogSz, "Out of memory."); ok = false; }
+        else { free(*outFsrc); *outFsrc = with; }
+    }
+    if (!ok) { free(*outVsrc); free(*outFsrc); *outVsrc = *outFsrc = NULL; }
+    return ok;
+}
+
+void MapBuildLog(const ShaderFileTable files[2], GLenum failed_stage, char* log, int logsz) {
+    if (failed_stage) MapShaderLog(&files[failed_stage == GL_VERTEX_SHADER ? 0 : 1], log, logsz);
+}
+
+bool LoadAndBuildProgramFromFiles(const char* vpath, const char* fpath, GLuint* outProg, BuildInfo* info, char* outLog, int outLogSz) {
+    *outProg = 0; outLog[0] = 0;
+    BuildInfo local = {0};
+    if (!info) info = &local;
+
+    char *vsrc=NULL,*fsrc=NULL;
+    ShaderFileTable* files = (ShaderFileTable*)malloc(2 * sizeof(ShaderFileTable)); // 64KB, keep it off worker stacks
+    if (!files) { snprintf(outLog, outLogSz, "Out of memory building %s.", fpath); return false; }
+    bool loaded = LoadShaderSources(vpath, fpath, &vsrc, &fsrc, files, outLog, outLogSz);
+    bool ok = loaded && BuildProgramFromSources(vsrc, fsrc, outProg, info, outLog, outLogSz);
+    if (!ok && loaded) MapBuildLog(files, info->failed_stage, outLog, outLogSz);
+    free(vsrc); free(fsrc); free(files);
+    return ok;
+}
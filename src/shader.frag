@@ -2,9 +2,15 @@
 in vec2 vUV;
 out vec4 FragColor;
 
-uniform float uTime;
-uniform vec2  uResolution;
-uniform vec2  uMouse;
+layout(std140) uniform FrameInputs {
+    vec2  uResolution;
+    vec2  uMouse;
+    vec4  uDate;
+    float uTime;
+    float uTimeDelta;
+    int   uFrame;
+    int   uMouseButtons;
+};
 
 void main() {
     FragColor = vec4(vUV, 0.0, 1.0);
@@ -0,0 +1,99 @@
+// shader.h — GLSL compile/link helpers shared by every front end
+#ifndef SHADERDEVEL_SHADER_H
+#define SHADERDEVEL_SHADER_H
+
+#include "platform.h"
+#include "program_cache.h"
+#include "shader_include.h"
+#include "stage_cache.h"
+#include <glad/gl.h>
+
+// Each returns 0 on failure and writes the driver info log into logbuf.
+GLuint CompileShader(GLenum type, const char* src, char* logbuf, int logbufsz);
+GLuint LinkProgram(GLuint vs, GLuint fs, char* logbuf, int logbufsz);
+// retrievable: set GL_PROGRAM_BINARY_RETRIEVABLE_HINT so the binary can be cached.
+// vs 0 links fs alone (a compute stage).
+GLuint LinkProgramEx(GLuint vs, GLuint fs, bool retrievable, char* logbuf, int logbufsz);
+
+// A "fragment" file named *.comp is a compute shader (compute_pass.h): its program has
+// that one stage, the vertex file is not read, and the loaders below define
+// LOCAL_SIZE_X / LOCAL_SIZE_Y (COMPUTE_DEFAULT_LOCAL_SIZE) unless defines set them.
+bool   IsComputeShaderPath(const char* path);
+#define COMPUTE_DEFAULT_LOCAL_SIZE 8
+
+// Optional binary cache consulted by the builders below. Set it once at startup,
+// before any worker thread builds; NULL disables caching.
+void          SetProgramCache(ProgramCache* cache);
+ProgramCache* GetProgramCache(void);
+
+// Compiled stages reused across builds; NULL compiles both stages every time.
+void        SetStageCache(StageCache* cache);
+StageCache* GetStageCache(void);
+
+// #include resolution for the file loaders below; NULL keeps nothing between builds
+// (includes still work, but every build re-reads every file and no dependencies are
+// known). Set once at startup like the program cache.
+void          SetIncludeCache(IncludeCache* cache);
+IncludeCache* GetIncludeCache(void);
+
+#define SHADER_MAX_DEFINES 16
+
+// "#define name value" lines put at the top of a fragment stage, right after its
+// #version: how the variants of one shader are built (variants.h).
+typedef struct {
+    int  count;
+    char name[SHADER_MAX_DEFINES][64];
+    char value[SHADER_MAX_DEFINES][64];
+} ShaderDefines;
+
+// Parses "NAME=VALUE,NAME=VALUE" (a bare NAME is defined empty). False with a reason in log.
+bool  ParseShaderDefines(const char* text, ShaderDefines* out, char* log, int logsz);
+// Adds or replaces name; false if the name is not an identifier or the table is full.
+bool  AddShaderDefine(ShaderDefines* d, const char* name, const char* value);
+// Back to the ParseShaderDefines form ("" for none).
+void  FormatShaderDefines(const ShaderDefines* d, char* out, size_t outsz);
+// malloc'd copy of src with the defines inserted; the #line directives the include
+// expansion put after #version keep log line numbers as they were.
+char* InsertShaderDefines(const char* src, const ShaderDefines* d);
+
+// Defines for every fragment stage LoadShaderSources reads from now on (copied; NULL
+// for none), so hot reloads and worker builds get them too. Set once at startup like
+// the caches.
+void                 SetShaderDefines(const ShaderDefines* d);
+const ShaderDefines* GetShaderDefines(void);
+
+// Reads both stages with their includes expanded (malloc'd; free both). files[0] and
+// files[1] get the vertex and fragment (or compute) stage's source numbers for
+// MapShaderLog / MapBuildLog. On failure the log names the file.
+// Applies GetShaderDefines() to the fragment stage. For a compute fpath *outVsrc stays
+// NULL and *outFsrc is the compute stage.
+bool LoadShaderSources(const char* vpath, const char* fpath, char** outVsrc, char** outFsrc, ShaderFileTable files[2], char* outLog, int outLogSz);
+// Same with explicit fragment defines (NULL for none).
+bool LoadShaderSourcesEx(const char* vpath, const char* fpath, const ShaderDefines* defines, char** outVsrc, char** outFsrc, ShaderFileTable files[2], char* outLog, int outLogSz);
+
+// Identity of a program's expanded sources: equal hashes build equal programs. vsrc
+// NULL: fsrc is a compute stage, here and in BuildProgramFromSources.
+uint64_t ProgramSourceHash(const char* vsrc, const char* fsrc);
+
+typedef struct {
+    uint64_t skip_hash;       // in: the live program's ProgramSourceHash; 0 = always build
+    uint64_t source_hash;     // out
+    bool     unchanged;       // out: sources hash to skip_hash, nothing built (*outProg 0, returns true)
+    bool     cache_hit;       // out: came from the program binary cache
+    int      stages_compiled; // out: stages not found in the stage cache (0-2, 0-1 for compute)
+    GLenum   failed_stage;    // out: the stage whose compile failed; 0 for a link failure (or none)
+} BuildInfo;
+
+// Compiles (only the stages the stage cache lacks) and links, or loads from the program
+// cache. info may be NULL.
+bool BuildProgramFromSources(const char* vsrc, const char* fsrc, GLuint* outProg, BuildInfo* info, char* outLog, int outLogSz);
+
+// MapShaderLog with the table of the stage whose compile failed; a link log, which
+// may mention either stage, is left as it is.
+void MapBuildLog(const ShaderFileTable files[2], GLenum failed_stage, char* log, int logsz);
+
+// LoadShaderSources, then BuildProgramFromSources. On failure *outProg is 0 and
+// outLog holds a human-readable reason with file names in place of source numbers.
+bool LoadAndBuildProgramFromFiles(const char* vpath, const char* fpath, GLuint* outProg, BuildInfo* info, char* outLog, int outLogSz);
+
+#endif // SHADERDEVEL_SHADER_H
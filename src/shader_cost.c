@@ -0,0 +1,2106 @@
+// shader_cost.c — see shader_cost.h
+//
+// Like cpu_shader.c this is a recursive-descent pass over the token stream with no
+// syntax tree, but it only counts: an expression yields its type, whether it varies
+// per pixel and its value when it is a compile-time scalar. A call re-walks the
+// callee's body at the call site; a loop walks its body once with the multiplier
+// raised to the trip count (after a silent walk that lets per-pixel values carried
+// around the loop reach the condition); the arms of an if are walked separately and
+// combined by whether the condition diverges.
+#include "shader_cost.h"
+#include "hash.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_MACROS       256
+#define MAX_MACRO_PARAMS 16
+#define MAX_COND_DEPTH   32
+#define MAX_EXPAND_DEPTH 32
+#define MAX_PARAMS       16
+#define MAX_CALLS        64 // GLSL has no recursion, so deeper means a cycle
+#define MAX_LOOPS        64
+#define MAX_MEMBERS      32
+#define MAX_ARGS         16
+
+static const double s_weight[COST_CATEGORIES] = { 1.0, 4.0, 8.0, 1.0 };
+static const char* const s_category[COST_CATEGORIES] = { "alu", "transcendental", "texture", "branch" };
+
+double      ShaderCostWeight(CostCategory c)       { return s_weight[c]; }
+const char* ShaderCostCategoryName(CostCategory c) { return s_category[c]; }
+
+// ============================ Tokens ===============================
+typedef enum { TOK_EOF, TOK_IDENT, TOK_NUMBER, TOK_PUNCT } TokKind;
+
+typedef struct {
+    uint8_t     kind;
+    bool        is_int;
+    int         len;
+    const char* s;
+    double      num;
+    int         source, line;
+    const char* line_text; // the token's line (the use's, in a macro expansion)
+} Token;
+
+typedef struct {
+    Token* t;
+    int    n, cap;
+} TokenList;
+
+typedef struct {
+    const char* name;
+    int         len;
+    bool        function_like;
+    int         nparam;
+    const char* param[MAX_MACRO_PARAMS];
+    int         param_len[MAX_MACRO_PARAMS];
+    int         first, count;             // body in Analyzer.mtok
+    int         defined_at, undefined_at; // raw token indices it applies to
+} Macro;
+
+typedef struct {
+    bool active, taken, parent;
+} CondState;
+
+// ============================ Types ================================
+enum { BT_VOID, BT_BOOL, BT_INT, BT_FLOAT, BT_SAMPLER, BT_STRUCT };
+
+typedef struct {
+    uint8_t base, cols, rows; // scalar 1x1, vecN 1xN, matCxR
+    int16_t strct;            // BT_STRUCT: index into Analyzer.st
+    int16_t array;            // element count, 0 not an array, -1 unsized
+} Type;
+
+typedef struct {
+    const char* name;
+    int         len;
+    int         nmember;
+    const char* member[MAX_MEMBERS];
+    int         member_len[MAX_MEMBERS];
+    Type        member_type[MAX_MEMBERS];
+} Struct;
+
+typedef struct {
+    const char* name;
+    int         len;
+    Type        t;
+    bool        varying;    // differs between pixels
+    bool        known;      // k is its value
+    double      k;
+    bool        readonly;   // uniform, in or const
+    int         loop_level; // Analyzer.nloop where it was declared
+} Symbol;
+
+enum { Q_IN, Q_OUT, Q_INOUT };
+
+typedef struct {
+    const char* name;
+    int         len;
+    Type        ret;
+    int         nparam;
+    Type        ptype[MAX_PARAMS];
+    uint8_t     pqual[MAX_PARAMS];
+    const Token* pname[MAX_PARAMS]; // NULL when unnamed
+    int         body;               // token index of its '{'
+    int         stat;               // FnStat
+} Function;
+
+typedef struct {
+    Type   t;
+    bool   varying;
+    bool   known;   // a scalar whose value is k
+    double k;
+    int    sym;     // variable it reads, -1 if none
+    bool   partial; // ... through a swizzle, index or member
+} Val;
+
+typedef struct { double n[COST_CATEGORIES]; } CostVec;
+
+// ========================== Statistics =============================
+typedef struct {
+    double      n[COST_CATEGORIES];
+    double      cost, runs;
+    const char* text;
+} LineStat;
+
+typedef struct {
+    const char* name;
+    int         len;
+    double      calls, cost, children;
+} FnStat;
+
+typedef struct {
+    int    tok;                 // of the for/while/do
+    int    fn, ordinal, depth;
+    int    trips;
+    bool   early_exit, divergent;
+    double body, cost;
+} LoopStat;
+
+typedef struct {
+    int         tok;
+    const char* kind;
+    double      cost;
+} HotStat;
+
+typedef struct {
+    int  stat;        // LoopStat, -1 for a switch (a break target that is not a loop)
+    int  divergent;   // Analyzer.divergent when it was entered
+    bool early_exit, divergent_exit;
+} LoopCtx;
+
+typedef struct {
+    int  fn;
+    int  loop_base;   // Analyzer.nloop at the call
+    int  divergent;   // Analyzer.divergent at the call
+    bool ret_varying;
+} CallFrame;
+
+typedef struct {
+    char*  log;
+    int    logsz;
+    bool   failed;
+
+    char*  text;        // source with comments blanked
+    TokenList raw;      // after directives, before macro expansion
+    TokenList tok;
+    TokenList mtok;     // macro bodies
+    TokenList line;     // scratch for one line
+    Token  eof;
+    int    pos;
+    Macro  macro[MAX_MACROS];
+    int    nmacro;
+    int    hide[MAX_EXPAND_DEPTH];
+    int    nhide;
+
+    Struct* st;   int nst, capst;
+    Symbol* sym;  int nsym, capsym, nglobal, scope_floor;
+    Function* fn; int nfn, capfn;
+    FnStat* fs;   int nfs, capfs;
+
+    CostVec* acc;       // where the code being walked is counted, once per execution
+    double mult;        // executions per pixel of the code being walked
+    int    silent;      // > 0: walk without counting
+    int    divergent;   // divergent branches around the code
+    const Token* stmt;  // first token of the statement being walked: its line is charged
+    LoopCtx loop[MAX_LOOPS];
+    int    nloop;
+    CallFrame call[MAX_CALLS];
+    int    ncall;
+    struct { int sym, from, to; const char* op; double k; bool sym_left; } cmp; // last "var < const"
+
+    LineStat* lines[SHADER_MAX_FILES];
+    int    nlines[SHADER_MAX_FILES];
+    LoopStat* loops; int nloops, caploops;
+    HotStat* hot;    int nhot, caphot;
+} Analyzer;
+
+// ============================ Errors ===============================
+static void Fail(Analyzer* a, const Token* t, const char* fmt, ...) {
+    if (a->failed) return;
+    a->failed = true;
+    int n = t ? snprintf(a->log, (size_t)a->logsz, "%d:%d: ", t->source, t->line) : 0;
+    if (n < 0 || n >= a->logsz) return;
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(a->log + n, (size_t)(a->logsz - n), fmt, ap);
+    va_end(ap);
+}
+
+static void* Grow(void* p, int* cap, int need, size_t elem) {
+    if (need <= *cap) return p;
+    int n = *cap ? *cap : 64;
+    while (n < need) n *= 2;
+    void* q = realloc(p, (size_t)n * elem);
+    if (!q) { fprintf(stderr, "shader_cost: out of memory\n"); abort(); }
+    *cap = n;
+    return q;
+}
+
+static void Push(TokenList* l, const Token* t) {
+    l->t = (Token*)Grow(l->t, &l->cap, l->n + 1, sizeof(Token));
+    l->t[l->n++] = *t;
+}
+
+// ========================= Preprocessor ============================
+static bool IsIdentStart(char ch) { return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_'; }
+static bool IsIdentChar(char ch)  { return IsIdentStart(ch) || (ch >= '0' && ch <= '9'); }
+static bool IsDigit(char ch)      { return ch >= '0' && ch <= '9'; }
+
+static bool NameIs(const char* s, int len, const char* lit) {
+    return (int)strlen(lit) == len && !memcmp(s, lit, (size_t)len);
+}
+static bool TokIs(const Token* t, const char* s) {
+    return (t->kind == TOK_IDENT || t->kind == TOK_PUNCT) && NameIs(t->s, t->len, s);
+}
+static bool SameName(const Token* t, const char* name, int len) {
+    return t->kind == TOK_IDENT && t->len == len && !memcmp(t->s, name, (size_t)len);
+}
+
+static void LexLine(Analyzer* a, const char* line_start, const char* p, const char* end, int source, int lineno) {
+    static const char* const punct2[] = { "++", "--", "+=", "-=", "*=", "/=", "%=", "==", "!=", "<=", ">=",
+                                          "&&", "||", "^^", "<<", ">>", "&=", "|=", "^=" };
+    a->line.n = 0;
+    while (p < end) {
+        if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\f' || *p == '\v') { ++p; continue; }
+        Token t;
+        memset(&t, 0, sizeof(t));
+        t.s = p; t.source = source; t.line = lineno; t.line_text = line_start;
+        if (IsIdentStart(*p)) {
+            while (p < end && IsIdentChar(*p)) ++p;
+            t.kind = TOK_IDENT;
+        } else if (IsDigit(*p) || (*p == '.' && p + 1 < end && IsDigit(p[1]))) {
+            t.kind = TOK_NUMBER;
+            char* stop = NULL;
+            if (*p == '0' && p + 1 < end && (p[1] == 'x' || p[1] == 'X')) {
+                t.num = (double)strtoul(p, &stop, 16);
+                t.is_int = true;
+            } else {
+                const char* q = p;
+                while (q < end && IsDigit(*q)) ++q;
+                t.is_int = !(q < end && (*q == '.' || *q == 'e' || *q == 'E'));
+                t.num = strtod(p, &stop);
+            }
+            p = stop > p ? stop : p + 1;
+            while (p < end && IsIdentChar(*p)) { if (*p == 'f' || *p == 'F') t.is_int = false; ++p; } // suffixes
+        } else {
+            t.kind = TOK_PUNCT;
+            int len = 1;
+            if (end - p >= 3 && (!memcmp(p, "<<=", 3) || !memcmp(p, ">>=", 3))) len = 3;
+            for (size_t i = 0; i < sizeof(punct2) / sizeof(punct2[0]) && len == 1; ++i)
+                if (end - p >= 2 && !memcmp(p, punct2[i], 2)) len = 2;
+            p += len;
+        }
+        t.len = (int)(p - t.s);
+        Push(&a->line, &t);
+    }
+}
+
+// The macro named t that applies at raw token index at, or -1.
+static int FindMacro(const Analyzer* a, const Token* t, int at) {
+    if (t->kind != TOK_IDENT) return -1;
+    for (int i = a->nmacro - 1; i >= 0; --i) {
+        const Macro* m = &a->macro[i];
+        if (m->len == t->len && !memcmp(m->name, t->s, (size_t)t->len) && m->defined_at <= at && at < m->undefined_at)
+            return i;
+    }
+    return -1;
+}
+
+// ---- #if expressions: integers, defined(), macros; unknown identifiers are 0 ----
+typedef struct {
+    const Token* t;
+    int          n, i;
+} IfExpr;
+
+static long long IfTernary(IfExpr* e);
+
+static long long IfPrimary(IfExpr* e) {
+    if (e->i >= e->n) return 0;
+    const Token* t = &e->t[e->i++];
+    if (TokIs(t, "(")) {
+        long long v = IfTernary(e);
+        if (e->i < e->n && TokIs(&e->t[e->i], ")")) ++e->i;
+        return v;
+    }
+    if (TokIs(t, "!")) return !IfPrimary(e);
+    if (TokIs(t, "-")) return -IfPrimary(e);
+    if (TokIs(t, "+")) return IfPrimary(e);
+    if (TokIs(t, "~")) return ~IfPrimary(e);
+    if (t->kind == TOK_NUMBER) return (long long)t->num;
+    return 0;
+}
+
+static int IfPrec(const Token* t) {
+    static const struct { const char* op; int prec; } ops[] = {
+        { "||", 1 }, { "&&", 2 }, { "|", 3 }, { "^", 4 }, { "&", 5 }, { "==", 6 }, { "!=", 6 },
+        { "<", 7 }, { ">", 7 }, { "<=", 7 }, { ">=", 7 }, { "<<", 8 }, { ">>", 8 },
+        { "+", 9 }, { "-", 9 }, { "*", 10 }, { "/", 10 }, { "%", 10 },
+    };
+    if (t->kind != TOK_PUNCT) return 0;
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); ++i) if (TokIs(t, ops[i].op)) return ops[i].prec;
+    return 0;
+}
+
+static long long IfBinary(IfExpr* e, int min_prec) {
+    long long l = IfPrimary(e);
+    while (e->i < e->n) {
+        const Token* op = &e->t[e->i];
+        int p = IfPrec(op);
+        if (!p || p < min_prec) break;
+        ++e->i;
+        long long r = IfBinary(e, p + 1);
+        if      (TokIs(op, "||")) l = l || r;
+        else if (TokIs(op, "&&")) l = l && r;
+        else if (TokIs(op, "|"))  l = l | r;
+        else if (TokIs(op, "^"))  l = l ^ r;
+        else if (TokIs(op, "&"))  l = l & r;
+        else if (TokIs(op, "==")) l = l == r;
+        else if (TokIs(op, "!=")) l = l != r;
+        else if (TokIs(op, "<"))  l = l < r;
+        else if (TokIs(op, ">"))  l = l > r;
+        else if (TokIs(op, "<=")) l = l <= r;
+        else if (TokIs(op, ">=")) l = l >= r;
+        else if (TokIs(op, "<<")) l = l << r;
+        else if (TokIs(op, ">>")) l = l >> r;
+        else if (TokIs(op, "+"))  l = l + r;
+        else if (TokIs(op, "-"))  l = l - r;
+        else if (TokIs(op, "*"))  l = l * r;
+        else if (r == 0)          l = 0;
+        else if (TokIs(op, "/"))  l = l / r;
+        else                      l = l % r;
+    }
+    return l;
+}
+
+static long long IfTernary(IfExpr* e) {
+    long long v = IfBinary(e, 1);
+    if (e->i < e->n && TokIs(&e->t[e->i], "?")) {
+        ++e->i;
+        long long x = IfTernary(e);
+        if (e->i < e->n && TokIs(&e->t[e->i], ":")) ++e->i;
+        long long y = IfTernary(e);
+        v = v ? x : y;
+    }
+    return v;
+}
+
+// Resolves defined() and expands object-like macros.
+static void IfExpand(Analyzer* a, const Token* in, int n, TokenList* out, int depth) {
+    for (int i = 0; i < n; ++i) {
+        Token t = in[i];
+        int m;
+        if (TokIs(&t, "defined")) {
+            bool paren = i + 1 < n && TokIs(&in[i + 1], "(");
+            int at = i + 1 + paren;
+            if (at >= n) return;
+            t.kind = TOK_NUMBER; t.num = FindMacro(a, &in[at], a->raw.n) >= 0;
+            i = at + (paren && at + 1 < n && TokIs(&in[at + 1], ")"));
+        } else if (depth < MAX_EXPAND_DEPTH && (m = FindMacro(a, &t, a->raw.n)) >= 0 && !a->macro[m].function_like) {
+            IfExpand(a, a->mtok.t + a->macro[m].first, a->macro[m].count, out, depth + 1);
+            continue;
+        }
+        Push(out, &t);
+    }
+}
+
+static bool EvalIf(Analyzer* a) {
+    TokenList ex = { 0 };
+    IfExpand(a, a->line.t + 2, a->line.n - 2, &ex, 0);
+    IfExpr e = { ex.t, ex.n, 0 };
+    long long v = ex.n ? IfTernary(&e) : 0;
+    free(ex.t);
+    return v != 0;
+}
+
+static void Define(Analyzer* a) {
+    const Token* name = &a->line.t[2];
+    int old = FindMacro(a, name, a->raw.n);
+    if (old >= 0) a->macro[old].undefined_at = a->raw.n;
+    if (a->nmacro == MAX_MACROS) { Fail(a, name, "more than %d macros", MAX_MACROS); return; }
+    Macro* m = &a->macro[a->nmacro++];
+    memset(m, 0, sizeof(*m));
+    m->name = name->s; m->len = name->len;
+    m->defined_at = a->raw.n; m->undefined_at = 0x7FFFFFFF;
+    int body = 3;
+    if (a->line.n > 3 && TokIs(&a->line.t[3], "(") && a->line.t[3].s == name->s + name->len) {
+        m->function_like = true;
+        for (body = 4; body < a->line.n && !TokIs(&a->line.t[body], ")"); ++body) {
+            const Token* p = &a->line.t[body];
+            if (p->kind == TOK_IDENT && m->nparam < MAX_MACRO_PARAMS) {
+                m->param[m->nparam] = p->s;
+                m->param_len[m->nparam++] = p->len;
+            }
+        }
+        ++body;
+    }
+    m->first = a->mtok.n;
+    for (int i = body; i < a->line.n; ++i) Push(&a->mtok, &a->line.t[i]);
+    m->count = a->mtok.n - m->first;
+}
+
+static void Directive(Analyzer* a, CondState* cond, int* ncond, int* source, int* next_line) {
+    if (a->line.n < 2 || a->line.t[1].kind != TOK_IDENT) return;
+    const Token* d = &a->line.t[1];
+    bool active = *ncond == 0 || cond[*ncond - 1].active;
+    if (TokIs(d, "ifdef") || TokIs(d, "ifndef") || TokIs(d, "if")) {
+        if (*ncond == MAX_COND_DEPTH) { Fail(a, d, "#if nested deeper than %d", MAX_COND_DEPTH); return; }
+        bool v = false;
+        if (active) {
+            if (TokIs(d, "if")) v = EvalIf(a);
+            else v = a->line.n > 2 && (FindMacro(a, &a->line.t[2], a->raw.n) >= 0) == TokIs(d, "ifdef");
+        }
+        cond[(*ncond)++] = (CondState){ active && v, v, active };
+    } else if (TokIs(d, "elif") || TokIs(d, "else") || TokIs(d, "endif")) {
+        if (*ncond == 0) return;
+        CondState* top = &cond[*ncond - 1];
+        if (TokIs(d, "endif")) { --*ncond; return; }
+        bool v = !top->taken && top->parent && (TokIs(d, "else") || EvalIf(a));
+        top->active = v;
+        top->taken |= v;
+    } else if (!active) {
+        return;
+    } else if (TokIs(d, "define")) {
+        if (a->line.n >= 3 && a->line.t[2].kind == TOK_IDENT) Define(a);
+    } else if (TokIs(d, "undef")) {
+        int m = a->line.n >= 3 ? FindMacro(a, &a->line.t[2], a->raw.n) : -1;
+        if (m >= 0) a->macro[m].undefined_at = a->raw.n;
+    } else if (TokIs(d, "line")) {
+        if (a->line.n >= 3 && a->line.t[2].kind == TOK_NUMBER) *next_line = (int)a->line.t[2].num;
+        if (a->line.n >= 4 && a->line.t[3].kind == TOK_NUMBER) *source = (int)a->line.t[3].num;
+    }
+}
+
+// Blanks comments (keeping newlines), then lexes line by line through the directives into a->raw.
+static void Tokenize(Analyzer* a, const char* src) {
+    size_t n = strlen(src);
+    a->text = (char*)malloc(n + 1);
+    if (!a->text) { fprintf(stderr, "shader_cost: out of memory\n"); abort(); }
+    memcpy(a->text, src, n + 1);
+    for (char* p = a->text; *p; ++p) {
+        if (p[0] == '/' && p[1] == '/') { while (*p && *p != '\n') *p++ = ' '; if (!*p) break; }
+        else if (p[0] == '/' && p[1] == '*') {
+            p[0] = p[1] = ' ';
+            p += 2;
+            while (*p && !(p[0] == '*' && p[1] == '/')) { if (*p != '\n') *p = ' '; ++p; }
+            if (*p) { p[0] = p[1] = ' '; ++p; }
+            else break;
+        }
+    }
+
+    CondState cond[MAX_COND_DEPTH];
+    int ncond = 0, source = 0, lineno = 1;
+    for (const char* p = a->text; *p && !a->failed;) {
+        const char* end = strchr(p, '\n');
+        if (!end) end = p + strlen(p);
+        const char* q = p;
+        while (q < end && (*q == ' ' || *q == '\t')) ++q;
+        int next_line = lineno + 1;
+        LexLine(a, p, q, end, source, lineno);
+        if (q < end && *q == '#') {
+            Directive(a, cond, &ncond, &source, &next_line);
+        } else if (ncond == 0 || cond[ncond - 1].active) {
+            for (int i = 0; i < a->line.n; ++i) Push(&a->raw, &a->line.t[i]);
+        }
+        lineno = next_line;
+        p = *end ? end + 1 : end;
+    }
+}
+
+static bool Hidden(const Analyzer* a, int m) {
+    for (int i = 0; i < a->nhide; ++i) if (a->hide[i] == m) return true;
+    return false;
+}
+
+static void EmitAt(TokenList* out, const Token* t, const Token* site) {
+    Token e = *t;
+    if (site) { e.source = site->source; e.line = site->line; e.line_text = site->line_text; }
+    Push(out, &e);
+}
+
+// Expands the macros in in[0, n) into out. Raw token i is at raw index base + i; inside
+// an expansion every token is at the raw index of the use and counts on the use's line.
+static void Expand(Analyzer* a, const Token* in, int n, int base, const Token* site, TokenList* out) {
+    for (int i = 0; i < n; ++i) {
+        const Token* t = &in[i];
+        int at = site ? base : base + i;
+        int m = FindMacro(a, t, at);
+        if (m < 0 || Hidden(a, m) || a->nhide == MAX_EXPAND_DEPTH) { EmitAt(out, t, site); continue; }
+        const Macro* mac = &a->macro[m];
+        const Token* use = site ? site : t;
+        if (!mac->function_like) {
+            a->hide[a->nhide++] = m;
+            Expand(a, a->mtok.t + mac->first, mac->count, at, use, out);
+            --a->nhide;
+            continue;
+        }
+        if (i + 1 >= n || !TokIs(&in[i + 1], "(")) { EmitAt(out, t, site); continue; }
+
+        // Arguments are expanded first, then substituted and the result expanded again.
+        int from[MAX_MACRO_PARAMS], to[MAX_MACRO_PARAMS], nargs = 0, depth = 0, j;
+        from[0] = i + 2;
+        for (j = i + 2; j < n; ++j) {
+            if (TokIs(&in[j], "(")) ++depth;
+            else if (TokIs(&in[j], ")") && depth-- == 0) break;
+            else if (TokIs(&in[j], ",") && depth == 0 && nargs + 1 < MAX_MACRO_PARAMS) { to[nargs++] = j; from[nargs] = j + 1; }
+        }
+        if (j >= n) { EmitAt(out, t, site); continue; }
+        to[nargs++] = j;
+        TokenList args[MAX_MACRO_PARAMS];
+        memset(args, 0, sizeof(args));
+        for (int k = 0; k < nargs; ++k) Expand(a, in + from[k], to[k] - from[k], at, use, &args[k]);
+        TokenList sub = { 0 };
+        for (int b = 0; b < mac->count; ++b) {
+            const Token* bt = &a->mtok.t[mac->first + b];
+            int p = -1;
+            for (int k = 0; k < mac->nparam && p < 0; ++k)
+                if (SameName(bt, mac->param[k], mac->param_len[k])) p = k;
+            if (p < 0 || p >= nargs) { Push(&sub, bt); continue; }
+            for (int k = 0; k < args[p].n; ++k) Push(&sub, &args[p].t[k]);
+        }
+        a->hide[a->nhide++] = m;
+        Expand(a, sub.t, sub.n, at, use, out);
+        --a->nhide;
+        free(sub.t);
+        for (int k = 0; k < nargs; ++k) free(args[k].t);
+        i = j;
+    }
+}
+
+// ======================== Token cursor =============================
+static const Token* Peek(Analyzer* a) { return a->failed || a->pos >= a->tok.n ? &a->eof : &a->tok.t[a->pos]; }
+static const Token* PeekAt(Analyzer* a, int k) {
+    return a->failed || a->pos + k >= a->tok.n ? &a->eof : &a->tok.t[a->pos + k];
+}
+static const Token* Next(Analyzer* a) {
+    const Token* t = Peek(a);
+    if (t->kind != TOK_EOF) ++a->pos;
+    return t;
+}
+static bool Accept(Analyzer* a, const char* p) {
+    if (!TokIs(Peek(a), p)) return false;
+    ++a->pos;
+    return true;
+}
+// A driver compiled this source already, so a missing token means the analyzer fell
+// out of step; skip to where it was expected instead of failing.
+static void Expect(Analyzer* a, const char* p) {
+    int depth = 0;
+    while (Peek(a)->kind != TOK_EOF) {
+        const Token* t = Next(a);
+        if (depth == 0 && TokIs(t, p)) return;
+        if (TokIs(t, "(") || TokIs(t, "{") || TokIs(t, "[")) ++depth;
+        else if ((TokIs(t, ")") || TokIs(t, "}") || TokIs(t, "]")) && --depth < 0) { --a->pos; return; }
+    }
+}
+
+// Token index of the bracket closing the one at open (the EOF index if unbalanced).
+static int MatchingClose(Analyzer* a, int open) {
+    int depth = 0;
+    for (int i = open; i < a->tok.n; ++i) {
+        const Token* t = &a->tok.t[i];
+        if (TokIs(t, "(") || TokIs(t, "{") || TokIs(t, "[")) ++depth;
+        else if ((TokIs(t, ")") || TokIs(t, "}") || TokIs(t, "]")) && --depth == 0) return i;
+    }
+    return a->tok.n;
+}
+
+// First ';' at bracket depth 0 from the cursor (or the closing bracket it runs into).
+static int FindSemicolon(Analyzer* a) {
+    int depth = 0;
+    for (int i = a->pos; i < a->tok.n; ++i) {
+        const Token* t = &a->tok.t[i];
+        if (TokIs(t, "(") || TokIs(t, "{") || TokIs(t, "[")) ++depth;
+        else if ((TokIs(t, ")") || TokIs(t, "}") || TokIs(t, "]")) && --depth < 0) return i;
+        else if (depth == 0 && TokIs(t, ";")) return i;
+    }
+    return a->tok.n;
+}
+
+// ============================ Types ================================
+static Type MakeType(int base, int cols, int rows) {
+    Type t = { (uint8_t)base, (uint8_t)cols, (uint8_t)rows, -1, 0 };
+    return t;
+}
+static int  Width(Type t)     { return t.cols * t.rows; }
+static bool IsScalar(Type t)  { return t.cols == 1 && t.rows == 1 && !t.array && t.base != BT_STRUCT; }
+static bool IsMatrix(Type t)  { return t.cols > 1; }
+
+static int FindStruct(const Analyzer* a, const Token* t) {
+    if (t->kind != TOK_IDENT) return -1;
+    for (int i = a->nst - 1; i >= 0; --i)
+        if (SameName(t, a->st[i].name, a->st[i].len)) return i;
+    return -1;
+}
+
+static bool BuiltinType(const Token* t, Type* out) {
+    if (t->kind != TOK_IDENT || t->len >= 16) return false;
+    char b[16];
+    memcpy(b, t->s, (size_t)t->len);
+    b[t->len] = 0;
+    if (!strcmp(b, "void"))                        { *out = MakeType(BT_VOID, 1, 1); return true; }
+    if (!strcmp(b, "float") || !strcmp(b, "double")) { *out = MakeType(BT_FLOAT, 1, 1); return true; }
+    if (!strcmp(b, "int") || !strcmp(b, "uint"))   { *out = MakeType(BT_INT, 1, 1); return true; }
+    if (!strcmp(b, "bool"))                        { *out = MakeType(BT_BOOL, 1, 1); return true; }
+    static const char* const samplers[] = { "sampler", "isampler", "usampler", "image", "iimage", "uimage", "atomic_uint" };
+    for (size_t i = 0; i < sizeof(samplers) / sizeof(samplers[0]); ++i)
+        if (!strncmp(b, samplers[i], strlen(samplers[i]))) { *out = MakeType(BT_SAMPLER, 1, 1); return true; }
+    static const struct { const char* prefix; int base; } vecs[] = {
+        { "vec", BT_FLOAT }, { "dvec", BT_FLOAT }, { "ivec", BT_INT }, { "uvec", BT_INT }, { "bvec", BT_BOOL },
+    };
+    for (size_t i = 0; i < sizeof(vecs) / sizeof(vecs[0]); ++i) {
+        size_t pl = strlen(vecs[i].prefix);
+        if (!strncmp(b, vecs[i].prefix, pl) && b[pl] >= '2' && b[pl] <= '4' && !b[pl + 1]) {
+            *out = MakeType(vecs[i].base, 1, b[pl] - '0');
+            return true;
+        }
+    }
+    const char* m = !strncmp(b, "mat", 3) ? b + 3 : !strncmp(b, "dmat", 4) ? b + 4 : NULL;
+    if (m && m[0] >= '2' && m[0] <= '4') {
+        if (!m[1]) { *out = MakeType(BT_FLOAT, m[0] - '0', m[0] - '0'); return true; }
+        if (m[1] == 'x' && m[2] >= '2' && m[2] <= '4' && !m[3]) { *out = MakeType(BT_FLOAT, m[0] - '0', m[2] - '0'); return true; }
+    }
+    return false;
+}
+
+static bool IsTypeName(const Analyzer* a, const Token* t) {
+    Type ty;
+    return BuiltinType(t, &ty) || FindStruct(a, t) >= 0;
+}
+
+static bool IsQualifier(const Token* t) {
+    static const char* const q[] = { "const", "in", "out", "inout", "uniform", "buffer", "shared", "attribute",
+                                     "varying", "flat", "smooth", "noperspective", "centroid", "sample", "patch",
+                                     "invariant", "precise", "highp", "mediump", "lowp", "readonly", "writeonly",
+                                     "coherent", "volatile", "restrict", "layout" };
+    for (size_t i = 0; i < sizeof(q) / sizeof(q[0]); ++i) if (TokIs(t, q[i])) return true;
+    return false;
+}
+
+typedef struct {
+    bool in, out, uniform, constant;
+} Qualifiers;
+
+static Qualifiers ParseQualifiers(Analyzer* a) {
+    Qualifiers q = { false, false, false, false };
+    while (IsQualifier(Peek(a))) {
+        const Token* t = Next(a);
+        if (TokIs(t, "layout")) { if (TokIs(Peek(a), "(")) a->pos = MatchingClose(a, a->pos) + 1; }
+        else if (TokIs(t, "in") || TokIs(t, "varying") || TokIs(t, "attribute")) q.in = true;
+        else if (TokIs(t, "inout")) q.in = q.out = true;
+        else if (TokIs(t, "out")) q.out = true;
+        else if (TokIs(t, "uniform") || TokIs(t, "buffer")) q.uniform = true;
+        else if (TokIs(t, "const")) q.constant = true;
+    }
+    return q;
+}
+
+static Val Expression(Analyzer* a);
+static Val Assignment(Analyzer* a);
+static void Statement(Analyzer* a);
+static bool ConstRange(Analyzer* a, int from, int to, double* k);
+
+// "[N]" / "[]" after a type or a name.
+static void ArraySuffix(Analyzer* a, Type* t) {
+    while (TokIs(Peek(a), "[")) {
+        int close = MatchingClose(a, a->pos);
+        double k = 0.0;
+        t->array = close > a->pos + 1 && ConstRange(a, a->pos + 1, close, &k) ? (int16_t)k : -1;
+        a->pos = close + 1;
+    }
+}
+
+static bool ParseStruct(Analyzer* a, Type* out);
+
+// A type name with an optional array suffix; false (cursor unmoved) if there is none.
+static bool ParseType(Analyzer* a, Type* out) {
+    const Token* t = Peek(a);
+    if (TokIs(t, "struct")) return ParseStruct(a, out);
+    int s = FindStruct(a, t);
+    if (s >= 0) { *out = MakeType(BT_STRUCT, 1, 1); out->strct = (int16_t)s; }
+    else if (!BuiltinType(t, out)) return false;
+    Next(a);
+    ArraySuffix(a, out);
+    return true;
+}
+
+// "struct Name { members }", also the member list of an interface block.
+static int ParseMembers(Analyzer* a, const Token* name) {
+    a->st = (Struct*)Grow(a->st, &a->capst, a->nst + 1, sizeof(Struct));
+    Struct* st = &a->st[a->nst];
+    memset(st, 0, sizeof(*st));
+    if (name) { st->name = name->s; st->len = name->len; }
+    Expect(a, "{");
+    while (!TokIs(Peek(a), "}") && Peek(a)->kind != TOK_EOF) {
+        ParseQualifiers(a);
+        Type mt;
+        if (!ParseType(a, &mt)) { Expect(a, ";"); continue; }
+        st = &a->st[a->nst]; // a nested struct may have moved the table
+        do {
+            const Token* m = Next(a);
+            Type t = mt;
+            ArraySuffix(a, &t);
+            if (m->kind == TOK_IDENT && st->nmember < MAX_MEMBERS) {
+                st->member[st->nmember] = m->s;
+                st->member_len[st->nmember] = m->len;
+                st->member_type[st->nmember++] = t;
+            }
+        } while (Accept(a, ","));
+        Expect(a, ";");
+    }
+    Accept(a, "}");
+    return a->nst++;
+}
+
+static bool ParseStruct(Analyzer* a, Type* out) {
+    Next(a); // struct
+    const Token* name = Peek(a)->kind == TOK_IDENT ? Next(a) : NULL;
+    if (name && !TokIs(Peek(a), "{")) { // "struct S x;"
+        int s = FindStruct(a, name);
+        *out = MakeType(BT_STRUCT, 1, 1);
+        out->strct = (int16_t)s;
+        return s >= 0;
+    }
+    *out = MakeType(BT_STRUCT, 1, 1);
+    out->strct = (int16_t)ParseMembers(a, name);
+    ArraySuffix(a, out);
+    return true;
+}
+
+// ========================== Symbols ================================
+static int AddSymbolNamed(Analyzer* a, const char* name, int len, Type t, bool varying) {
+    a->sym = (Symbol*)Grow(a->sym, &a->capsym, a->nsym + 1, sizeof(Symbol));
+    Symbol* s = &a->sym[a->nsym];
+    memset(s, 0, sizeof(*s));
+    s->name = name; s->len = len; s->t = t;
+    s->varying = varying;
+    s->loop_level = a->nloop;
+    return a->nsym++;
+}
+
+static int Lookup(const Analyzer* a, const Token* name) {
+    for (int i = a->nsym - 1; i >= a->scope_floor; --i)
+        if (SameName(name, a->sym[i].name, a->sym[i].len)) return i;
+    for (int i = a->nglobal - 1; i >= 0; --i)
+        if (SameName(name, a->sym[i].name, a->sym[i].len)) return i;
+    return -1;
+}
+
+static int FnStatFor(Analyzer* a, const char* name, int len) {
+    for (int i = 0; i < a->nfs; ++i)
+        if (a->fs[i].len == len && !memcmp(a->fs[i].name, name, (size_t)len)) return i;
+    a->fs = (FnStat*)Grow(a->fs, &a->capfs, a->nfs + 1, sizeof(FnStat));
+    FnStat* s = &a->fs[a->nfs];
+    memset(s, 0, sizeof(*s));
+    s->name = name; s->len = len;
+    return a->nfs++;
+}
+
+// ========================== Counting ===============================
+static double Weighted(const CostVec* v) {
+    double w = 0.0;
+    for (int c = 0; c < COST_CATEGORIES; ++c) w += v->n[c] * s_weight[c];
+    return w;
+}
+
+static void AddScaled(CostVec* dst, const CostVec* src, double s) {
+    for (int c = 0; c < COST_CATEGORIES; ++c) dst->n[c] += src->n[c] * s;
+}
+
+static LineStat* LineAt(Analyzer* a, const Token* t) {
+    if (t->source < 0 || t->source >= SHADER_MAX_FILES || t->line < 1 || t->line > 1000000) return NULL;
+    int s = t->source;
+    if (t->line > a->nlines[s]) {
+        int n = a->nlines[s] ? a->nlines[s] : 64;
+        while (n < t->line) n *= 2;
+        LineStat* grown = (LineStat*)realloc(a->lines[s], (size_t)(n + 1) * sizeof(LineStat));
+        if (!grown) { fprintf(stderr, "shader_cost: out of memory\n"); abort(); }
+        memset(grown + a->nlines[s] + (a->nlines[s] ? 1 : 0), 0,
+               (size_t)(n + 1 - a->nlines[s] - (a->nlines[s] ? 1 : 0)) * sizeof(LineStat));
+        a->lines[s] = grown;
+        a->nlines[s] = n;
+    }
+    LineStat* l = &a->lines[s][t->line];
+    if (!l->text) l->text = t->line_text;
+    return l;
+}
+
+static void Charge(Analyzer* a, CostCategory c, double count, const Token* at) {
+    if (a->silent || count <= 0.0) return;
+    a->acc->n[c] += count;
+    LineStat* l = LineAt(a, a->stmt ? a->stmt : at);
+    if (!l) return;
+    l->n[c] += count * a->mult;
+    l->cost += count * s_weight[c] * a->mult;
+}
+
+static int TokIndex(const Analyzer* a, const Token* t) { return (int)(t - a->tok.t); }
+
+static LoopStat* LoopAt(Analyzer* a, int tok) {
+    for (int i = 0; i < a->nloops; ++i) if (a->loops[i].tok == tok) return &a->loops[i];
+    a->loops = (LoopStat*)Grow(a->loops, &a->caploops, a->nloops + 1, sizeof(LoopStat));
+    LoopStat* l = &a->loops[a->nloops++];
+    memset(l, 0, sizeof(*l));
+    l->tok = tok;
+    l->fn = a->ncall ? a->call[a->ncall - 1].fn : -1;
+    l->depth = a->nloop;
+    if (l->fn >= 0) // loop keywords before it in the function
+        for (int i = a->fn[l->fn].body; i < tok; ++i)
+            l->ordinal += TokIs(&a->tok.t[i], "for") || TokIs(&a->tok.t[i], "while") || TokIs(&a->tok.t[i], "do");
+    return l;
+}
+
+static void Hotspot(Analyzer* a, int tok, const char* kind, double cost) {
+    if (a->silent || cost <= 0.0) return;
+    for (int i = 0; i < a->nhot; ++i) if (a->hot[i].tok == tok) { a->hot[i].cost += cost; return; }
+    a->hot = (HotStat*)Grow(a->hot, &a->caphot, a->nhot + 1, sizeof(HotStat));
+    a->hot[a->nhot++] = (HotStat){ tok, kind, cost };
+}
+
+// ============================ Values ===============================
+static Val MakeVal(Type t) {
+    Val v;
+    memset(&v, 0, sizeof(v));
+    v.t = t;
+    v.sym = -1;
+    return v;
+}
+
+static Val KnownVal(int base, double k) {
+    Val v = MakeVal(MakeType(base, 1, 1));
+    v.known = true;
+    v.k = base == BT_INT ? trunc(k) : base == BT_BOOL ? (k != 0.0) : k;
+    return v;
+}
+
+static int WiderBase(Type a, Type b) {
+    if (a.base == BT_FLOAT || b.base == BT_FLOAT) return BT_FLOAT;
+    if (a.base == BT_INT || b.base == BT_INT) return BT_INT;
+    return a.base;
+}
+
+// Component-wise result of l op r: the non-scalar side decides.
+static Type Wider(Type l, Type r) {
+    Type t = Width(r) > Width(l) ? r : l;
+    t.base = (uint8_t)WiderBase(l, r);
+    t.array = 0;
+    return t;
+}
+
+// Whether the bounds of [from, to) parse as one constant expression (nothing is counted).
+static bool ConstRange(Analyzer* a, int from, int to, double* k) {
+    if (from >= to) return false;
+    int saved = a->pos;
+    a->pos = from;
+    a->silent++;
+    Val v = Expression(a);
+    a->silent--;
+    bool ok = v.known && a->pos == to;
+    a->pos = saved;
+    if (ok) *k = v.k;
+    return ok;
+}
+
+// ========================== Arithmetic =============================
+static Val Arith(Analyzer* a, const char* op, Val l, Val r, const Token* at) {
+    if (l.known && r.known) {
+        double x = l.k, y = r.k, v = 0.0;
+        int base = WiderBase(l.t, r.t);
+        switch (op[0]) {
+        case '+': v = x + y; break;
+        case '-': v = x - y; break;
+        case '*': v = x * y; break;
+        case '/': v = y != 0.0 ? (base == BT_INT ? trunc(x / y) : x / y) : 0.0; break;
+        case '%': v = y != 0.0 ? fmod(x, y) : 0.0; break;
+        case '<': v = op[1] == '<' ? (double)((long long)x << (long long)y) : op[1] == '=' ? x <= y : x < y; break;
+        case '>': v = op[1] == '>' ? (double)((long long)x >> (long long)y) : op[1] == '=' ? x >= y : x > y; break;
+        case '=': v = x == y; break;
+        case '!': v = x != y; break;
+        case '&': v = op[1] == '&' ? (x != 0.0 && y != 0.0) : (double)((long long)x & (long long)y); break;
+        case '|': v = op[1] == '|' ? (x != 0.0 || y != 0.0) : (double)((long long)x | (long long)y); break;
+        case '^': v = op[1] == '^' ? ((x != 0.0) != (y != 0.0)) : (double)((long long)x ^ (long long)y); break;
+        }
+        bool logic = strchr("<>=!", op[0]) || !strcmp(op, "&&") || !strcmp(op, "||") || !strcmp(op, "^^");
+        if ((op[0] == '<' && op[1] == '<') || (op[0] == '>' && op[1] == '>')) logic = false;
+        return KnownVal(logic ? BT_BOOL : base, v);
+    }
+    Val v = MakeVal(Wider(l.t, r.t));
+    v.varying = l.varying || r.varying;
+    double ops = Width(v.t);
+    if (!strcmp(op, "*") && (IsMatrix(l.t) || IsMatrix(r.t)) && Width(l.t) > 1 && Width(r.t) > 1) {
+        if (IsMatrix(l.t) && IsMatrix(r.t)) { v.t = MakeType(BT_FLOAT, r.t.cols, l.t.rows); ops = r.t.cols * l.t.rows * l.t.cols; }
+        else if (IsMatrix(l.t)) { v.t = MakeType(BT_FLOAT, 1, l.t.rows); ops = l.t.cols * l.t.rows; }
+        else { v.t = MakeType(BT_FLOAT, 1, r.t.cols); ops = r.t.cols * r.t.rows; }
+    }
+    if (!strcmp(op, "/")) {
+        // A constant divisor becomes a multiply; otherwise a reciprocal per divisor component.
+        if (!r.known) Charge(a, COST_TRANSCENDENTAL, Width(r.t), at);
+        Charge(a, COST_ALU, ops, at);
+    } else if (!strcmp(op, "%")) {
+        if (!r.known) Charge(a, COST_TRANSCENDENTAL, Width(r.t), at);
+        Charge(a, COST_ALU, 3.0 * ops, at);
+    } else if (!strcmp(op, "==") || !strcmp(op, "!=")) {
+        Charge(a, COST_ALU, 2.0 * Width(l.t) - 1.0, at);
+        v.t = MakeType(BT_BOOL, 1, 1);
+    } else if (op[0] == '<' || op[0] == '>') {
+        bool shift = op[1] == op[0];
+        Charge(a, COST_ALU, shift ? ops : 1.0, at);
+        if (!shift) v.t = MakeType(BT_BOOL, 1, 1);
+    } else if (!strcmp(op, "&&") || !strcmp(op, "||") || !strcmp(op, "^^")) {
+        Charge(a, COST_ALU, 1.0, at);
+        v.t = MakeType(BT_BOOL, 1, 1);
+    } else {
+        Charge(a, COST_ALU, ops, at);
+    }
+    return v;
+}
+
+// Writes r (already combined for op=) to the variable behind lhs.
+static Val Assign(Analyzer* a, Val lhs, Val r, bool plain) {
+    if (lhs.sym < 0) return r;
+    Symbol* s = &a->sym[lhs.sym];
+    if (s->readonly) return r;
+    // Per-pixel control flow makes the value per-pixel too.
+    s->varying |= r.varying || a->divergent > 0;
+    // A variable from outside the enclosing loop changes between iterations.
+    s->known = plain && !lhs.partial && r.known && s->loop_level == a->nloop && IsScalar(s->t);
+    s->k = r.k;
+    Val v = MakeVal(lhs.t);
+    v.varying = s->varying;
+    v.known = s->known && !lhs.partial;
+    v.k = s->k;
+    v.sym = lhs.sym;
+    v.partial = lhs.partial;
+    return v;
+}
+
+// ========================== Built-ins ==============================
+enum { R_GEN, R_FLOAT, R_BOOL_GEN, R_BOOL, R_VEC3, R_VEC4, R_IVEC2, R_INT, R_TRANSPOSE };
+
+// Cost per component of the widest argument (c) and per call (k).
+static const struct {
+    const char* name;
+    uint8_t     ret;
+    float       alu_c, alu_k, trans_c, trans_k, tex;
+} s_builtins[] = {
+    { "radians", R_GEN, 1, 0, 0, 0, 0 },      { "degrees", R_GEN, 1, 0, 0, 0, 0 },
+    { "sin", R_GEN, 0, 0, 1, 0, 0 },          { "cos", R_GEN, 0, 0, 1, 0, 0 },
+    { "tan", R_GEN, 1, 0, 3, 0, 0 },          { "asin", R_GEN, 8, 0, 1, 0, 0 },
+    { "acos", R_GEN, 8, 0, 1, 0, 0 },         { "atan", R_GEN, 10, 0, 1, 0, 0 },
+    { "sinh", R_GEN, 3, 0, 2, 0, 0 },         { "cosh", R_GEN, 3, 0, 2, 0, 0 },
+    { "tanh", R_GEN, 3, 0, 2, 0, 0 },         { "asinh", R_GEN, 3, 0, 2, 0, 0 },
+    { "acosh", R_GEN, 3, 0, 2, 0, 0 },        { "atanh", R_GEN, 3, 0, 2, 0, 0 },
+    { "pow", R_GEN, 1, 0, 2, 0, 0 },          { "exp", R_GEN, 1, 0, 1, 0, 0 },
+    { "log", R_GEN, 1, 0, 1, 0, 0 },          { "exp2", R_GEN, 0, 0, 1, 0, 0 },
+    { "log2", R_GEN, 0, 0, 1, 0, 0 },         { "sqrt", R_GEN, 0, 0, 1, 0, 0 },
+    { "inversesqrt", R_GEN, 0, 0, 1, 0, 0 },
+    { "abs", R_GEN, 1, 0, 0, 0, 0 },          { "sign", R_GEN, 1, 0, 0, 0, 0 },
+    { "floor", R_GEN, 1, 0, 0, 0, 0 },        { "ceil", R_GEN, 1, 0, 0, 0, 0 },
+    { "trunc", R_GEN, 1, 0, 0, 0, 0 },        { "round", R_GEN, 1, 0, 0, 0, 0 },
+    { "roundEven", R_GEN, 1, 0, 0, 0, 0 },    { "fract", R_GEN, 1, 0, 0, 0, 0 },
+    { "mod", R_GEN, 3, 0, 1, 0, 0 },          { "modf", R_GEN, 2, 0, 0, 0, 0 },
+    { "min", R_GEN, 1, 0, 0, 0, 0 },          { "max", R_GEN, 1, 0, 0, 0, 0 },
+    { "clamp", R_GEN, 2, 0, 0, 0, 0 },        { "mix", R_GEN, 2, 0, 0, 0, 0 },
+    { "step", R_GEN, 1, 0, 0, 0, 0 },         { "smoothstep", R_GEN, 6, 0, 1, 0, 0 },
+    { "fma", R_GEN, 1, 0, 0, 0, 0 },          { "isnan", R_BOOL_GEN, 1, 0, 0, 0, 0 },
+    { "isinf", R_BOOL_GEN, 1, 0, 0, 0, 0 },
+    { "length", R_FLOAT, 1, 0, 0, 1, 0 },     { "distance", R_FLOAT, 2, 0, 0, 1, 0 },
+    { "dot", R_FLOAT, 1, 0, 0, 0, 0 },        { "cross", R_VEC3, 0, 6, 0, 0, 0 },
+    { "normalize", R_GEN, 2, 0, 0, 1, 0 },    { "faceforward", R_GEN, 2, 0, 0, 0, 0 },
+    { "reflect", R_GEN, 3, 0, 0, 0, 0 },      { "refract", R_GEN, 4, 6, 0, 1, 0 },
+    { "matrixCompMult", R_GEN, 1, 0, 0, 0, 0 }, { "transpose", R_TRANSPOSE, 0, 0, 0, 0, 0 },
+    { "determinant", R_FLOAT, 3, 0, 0, 0, 0 }, { "inverse", R_GEN, 10, 0, 0, 1, 0 },
+    { "lessThan", R_BOOL_GEN, 1, 0, 0, 0, 0 }, { "lessThanEqual", R_BOOL_GEN, 1, 0, 0, 0, 0 },
+    { "greaterThan", R_BOOL_GEN, 1, 0, 0, 0, 0 }, { "greaterThanEqual", R_BOOL_GEN, 1, 0, 0, 0, 0 },
+    { "equal", R_BOOL_GEN, 1, 0, 0, 0, 0 },   { "notEqual", R_BOOL_GEN, 1, 0, 0, 0, 0 },
+    { "any", R_BOOL, 1, 0, 0, 0, 0 },         { "all", R_BOOL, 1, 0, 0, 0, 0 },
+    { "not", R_BOOL_GEN, 1, 0, 0, 0, 0 },
+    { "dFdx", R_GEN, 1, 0, 0, 0, 0 },         { "dFdy", R_GEN, 1, 0, 0, 0, 0 },
+    { "dFdxFine", R_GEN, 1, 0, 0, 0, 0 },     { "dFdyFine", R_GEN, 1, 0, 0, 0, 0 },
+    { "dFdxCoarse", R_GEN, 1, 0, 0, 0, 0 },   { "dFdyCoarse", R_GEN, 1, 0, 0, 0, 0 },
+    { "fwidth", R_GEN, 3, 0, 0, 0, 0 },
+    { "floatBitsToInt", R_GEN, 0, 0, 0, 0, 0 }, { "floatBitsToUint", R_GEN, 0, 0, 0, 0, 0 },
+    { "intBitsToFloat", R_GEN, 0, 0, 0, 0, 0 }, { "uintBitsToFloat", R_GEN, 0, 0, 0, 0, 0 },
+    { "texture", R_VEC4, 0, 0, 0, 0, 1 },     { "textureLod", R_VEC4, 0, 0, 0, 0, 1 },
+    { "textureGrad", R_VEC4, 0, 0, 0, 0, 1 }, { "textureProj", R_VEC4, 0, 0, 0, 0, 1 },
+    { "textureOffset", R_VEC4, 0, 0, 0, 0, 1 }, { "textureLodOffset", R_VEC4, 0, 0, 0, 0, 1 },
+    { "textureGradOffset", R_VEC4, 0, 0, 0, 0, 1 }, { "textureProjLod", R_VEC4, 0, 0, 0, 0, 1 },
+    { "texelFetch", R_VEC4, 0, 0, 0, 0, 1 },  { "texelFetchOffset", R_VEC4, 0, 0, 0, 0, 1 },
+    { "textureGather", R_VEC4, 0, 0, 0, 0, 1 }, { "textureGatherOffset", R_VEC4, 0, 0, 0, 0, 1 },
+    { "texture2D", R_VEC4, 0, 0, 0, 0, 1 },   { "texture2DLod", R_VEC4, 0, 0, 0, 0, 1 },
+    { "textureCube", R_VEC4, 0, 0, 0, 0, 1 },
+    { "textureSize", R_IVEC2, 0, 0, 0, 0, 0 }, { "textureQueryLevels", R_INT, 0, 0, 0, 0, 0 },
+};
+
+// Folds a built-in over known scalars; false for the ones not worth folding.
+static bool FoldBuiltin(const char* n, const Val* v, int nargs, double* out) {
+    double x = v[0].k, y = nargs > 1 ? v[1].k : 0.0, z = nargs > 2 ? v[2].k : 0.0;
+    if      (!strcmp(n, "abs"))   *out = fabs(x);
+    else if (!strcmp(n, "floor")) *out = floor(x);
+    else if (!strcmp(n, "ceil"))  *out = ceil(x);
+    else if (!strcmp(n, "fract")) *out = x - floor(x);
+    else if (!strcmp(n, "sqrt"))  *out = sqrt(x);
+    else if (!strcmp(n, "exp2"))  *out = exp2(x);
+    else if (!strcmp(n, "log2"))  *out = log2(x);
+    else if (!strcmp(n, "sin"))   *out = sin(x);
+    else if (!strcmp(n, "cos"))   *out = cos(x);
+    else if (!strcmp(n, "min") && nargs == 2) *out = fmin(x, y);
+    else if (!strcmp(n, "max") && nargs == 2) *out = fmax(x, y);
+    else if (!strcmp(n, "pow") && nargs == 2) *out = pow(x, y);
+    else if (!strcmp(n, "mod") && nargs == 2) *out = y != 0.0 ? x - y * floor(x / y) : 0.0;
+    else if (!strcmp(n, "clamp") && nargs == 3) *out = fmin(fmax(x, y), z);
+    else return false;
+    return true;
+}
+
+static bool CallBuiltin(Analyzer* a, const Token* name, const Val* args, int nargs, Val* out) {
+    int b = -1;
+    for (size_t i = 0; i < sizeof(s_builtins) / sizeof(s_builtins[0]) && b < 0; ++i)
+        if (SameName(name, s_builtins[i].name, (int)strlen(s_builtins[i].name))) b = (int)i;
+    if (b < 0) return false;
+    Type wide = nargs ? args[0].t : MakeType(BT_FLOAT, 1, 1);
+    bool varying = false, known = nargs > 0;
+    for (int i = 0; i < nargs; ++i) {
+        if (args[i].t.base != BT_SAMPLER && Width(args[i].t) > Width(wide)) wide = args[i].t;
+        varying |= args[i].varying;
+        known &= args[i].known;
+    }
+    wide.array = 0;
+    char nm[32];
+    snprintf(nm, sizeof(nm), "%s", s_builtins[b].name);
+    double k;
+    if (known && FoldBuiltin(nm, args, nargs, &k)) { *out = KnownVal(BT_FLOAT, k); return true; }
+
+    double w = Width(wide);
+    Charge(a, COST_ALU, s_builtins[b].alu_c * w + s_builtins[b].alu_k, name);
+    Charge(a, COST_TRANSCENDENTAL, s_builtins[b].trans_c * w + s_builtins[b].trans_k, name);
+    Charge(a, COST_TEXTURE, s_builtins[b].tex, name);
+    switch (s_builtins[b].ret) {
+    case R_GEN:       *out = MakeVal(wide); break;
+    case R_FLOAT:     *out = MakeVal(MakeType(BT_FLOAT, 1, 1)); break;
+    case R_BOOL_GEN:  *out = MakeVal(MakeType(BT_BOOL, 1, wide.rows)); break;
+    case R_BOOL:      *out = MakeVal(MakeType(BT_BOOL, 1, 1)); break;
+    case R_VEC3:      *out = MakeVal(MakeType(BT_FLOAT, 1, 3)); break;
+    case R_VEC4:      *out = MakeVal(MakeType(BT_FLOAT, 1, 4)); break;
+    case R_IVEC2:     *out = MakeVal(MakeType(BT_INT, 1, 2)); break;
+    case R_INT:       *out = MakeVal(MakeType(BT_INT, 1, 1)); break;
+    case R_TRANSPOSE: *out = MakeVal(MakeType(BT_FLOAT, wide.rows, wide.cols)); break;
+    }
+    if (!strcmp(nm, "floatBitsToInt") || !strcmp(nm, "floatBitsToUint")) out->t.base = BT_INT;
+    if (!strcmp(nm, "intBitsToFloat") || !strcmp(nm, "uintBitsToFloat")) out->t.base = BT_FLOAT;
+    out->varying = varying;
+    return true;
+}
+
+// ======================= Function inlining =========================
+static void Block(Analyzer* a);
+
+static int FindFunction(Analyzer* a, const Token* name, const Val* args, int nargs) {
+    int best = -1;
+    for (int i = 0; i < a->nfn; ++i) {
+        const Function* f = &a->fn[i];
+        if (!SameName(name, f->name, f->len) || f->nparam != nargs) continue;
+        bool exact = true;
+        for (int p = 0; p < nargs; ++p)
+            exact &= Width(f->ptype[p]) == Width(args[p].t) && f->ptype[p].base == args[p].t.base;
+        if (exact) return i;
+        if (best < 0) best = i;
+    }
+    return best;
+}
+
+static Val CallFunction(Analyzer* a, int fi, const Val* args, int nargs, const Token* at) {
+    const Function* f = &a->fn[fi];
+    Val ret = MakeVal(f->ret);
+    for (int i = 0; i < a->ncall; ++i)
+        if (a->call[i].fn == fi) { // a cycle; the driver would not have linked it
+            for (int p = 0; p < nargs; ++p) ret.varying |= args[p].varying;
+            return ret;
+        }
+    if (a->ncall == MAX_CALLS) { Fail(a, at, "calls nested deeper than %d", MAX_CALLS); return ret; }
+
+    int saved_pos = a->pos, saved_floor = a->scope_floor, saved_nsym = a->nsym;
+    a->scope_floor = a->nsym;
+    int psym[MAX_PARAMS];
+    for (int p = 0; p < f->nparam; ++p) {
+        const Token* pn = f->pname[p];
+        psym[p] = AddSymbolNamed(a, pn ? pn->s : "", pn ? pn->len : 0, f->ptype[p],
+                                 p < nargs && f->pqual[p] != Q_OUT && args[p].varying);
+        if (p < nargs && f->pqual[p] == Q_IN && args[p].known) { a->sym[psym[p]].known = true; a->sym[psym[p]].k = args[p].k; }
+    }
+    a->call[a->ncall++] = (CallFrame){ fi, a->nloop, a->divergent, false };
+    CostVec body = { { 0 } };
+    CostVec* saved_acc = a->acc;
+    a->acc = &body;
+    a->pos = f->body;
+    Block(a);
+    a->acc = saved_acc;
+    AddScaled(a->acc, &body, 1.0);
+    ret.varying = a->call[--a->ncall].ret_varying;
+
+    for (int p = 0; p < f->nparam && p < nargs; ++p) {
+        if (f->pqual[p] == Q_IN || args[p].sym < 0 || a->sym[args[p].sym].readonly) continue;
+        Symbol* s = &a->sym[args[p].sym];
+        s->varying |= a->sym[psym[p]].varying || a->divergent > 0;
+        s->known = false;
+    }
+    if (!a->silent) {
+        double w = Weighted(&body) * a->mult;
+        FnStat* s = &a->fs[f->stat];
+        s->calls += a->mult;
+        s->cost += w;
+        if (a->ncall) a->fs[a->fn[a->call[a->ncall - 1].fn].stat].children += w;
+    }
+    a->nsym = saved_nsym;
+    a->scope_floor = saved_floor;
+    a->pos = saved_pos;
+    return ret;
+}
+
+// ========================== Expressions ============================
+// Arguments up to the closing ')' (the cursor is after the '(').
+static int Arguments(Analyzer* a, Val* args) {
+    int n = 0;
+    if (Accept(a, ")")) return 0;
+    if (TokIs(Peek(a), "void") && TokIs(PeekAt(a, 1), ")")) { a->pos += 2; return 0; }
+    do {
+        Val v = Assignment(a);
+        if (n < MAX_ARGS) args[n++] = v;
+    } while (Accept(a, ","));
+    Expect(a, ")");
+    return n;
+}
+
+static Val Construct(Analyzer* a, Type t, const Val* args, int nargs, const Token* at) {
+    Val v = MakeVal(t);
+    for (int i = 0; i < nargs; ++i) v.varying |= args[i].varying;
+    if (IsScalar(t) && nargs == 1 && args[0].known) return KnownVal(t.base, args[0].k);
+    // Conversions cost a op per component; building vectors is free.
+    if (nargs == 1 && t.base != BT_STRUCT && args[0].t.base != t.base && !args[0].known)
+        Charge(a, COST_ALU, Width(t), at);
+    return v;
+}
+
+static Val Primary(Analyzer* a) {
+    const Token* t = Next(a);
+    if (t->kind == TOK_NUMBER) return KnownVal(t->is_int ? BT_INT : BT_FLOAT, t->num);
+    if (TokIs(t, "true"))  return KnownVal(BT_BOOL, 1.0);
+    if (TokIs(t, "false")) return KnownVal(BT_BOOL, 0.0);
+    if (TokIs(t, "(")) {
+        Val v = Expression(a);
+        Expect(a, ")");
+        return v;
+    }
+    if (t->kind != TOK_IDENT) return MakeVal(MakeType(BT_FLOAT, 1, 1));
+
+    Type ty;
+    --a->pos;
+    if (IsTypeName(a, t) && ParseType(a, &ty)) { // constructor
+        Val args[MAX_ARGS];
+        if (!Accept(a, "(")) return MakeVal(ty);
+        int n = Arguments(a, args);
+        if (ty.array < 0) ty.array = (int16_t)n;
+        return Construct(a, ty, args, n, t);
+    }
+    ++a->pos;
+    if (Accept(a, "(")) {
+        Val args[MAX_ARGS];
+        int n = Arguments(a, args);
+        int fi = FindFunction(a, t, args, n);
+        if (fi >= 0) return CallFunction(a, fi, args, n, t);
+        Val v;
+        if (CallBuiltin(a, t, args, n, &v)) return v;
+        // Some other built-in: one op per component of its widest argument.
+        v = MakeVal(n ? args[0].t : MakeType(BT_FLOAT, 1, 1));
+        for (int i = 0; i < n; ++i) {
+            if (Width(args[i].t) > Width(v.t)) v.t = args[i].t;
+            v.varying |= args[i].varying;
+        }
+        Charge(a, COST_ALU, Width(v.t), t);
+        return v;
+    }
+    int s = Lookup(a, t);
+    if (s < 0) return MakeVal(MakeType(BT_FLOAT, 1, 1));
+    Val v = MakeVal(a->sym[s].t);
+    v.varying = a->sym[s].varying;
+    v.known = a->sym[s].known;
+    v.k = a->sym[s].k;
+    v.sym = s;
+    return v;
+}
+
+static Val Postfix(Analyzer* a) {
+    Val v = Primary(a);
+    for (;;) {
+        const Token* t = Peek(a);
+        if (TokIs(t, ".")) {
+            Next(a);
+            const Token* m = Next(a);
+            if (TokIs(m, "length") && TokIs(Peek(a), "(")) { // array.length()
+                a->pos = MatchingClose(a, a->pos) + 1;
+                Val n = KnownVal(BT_INT, v.t.array > 0 ? v.t.array : Width(v.t));
+                n.known = v.t.array >= 0;
+                v = n;
+                continue;
+            }
+            if (v.t.base == BT_STRUCT && v.t.strct >= 0 && !v.t.array) {
+                const Struct* st = &a->st[v.t.strct];
+                Type mt = MakeType(BT_FLOAT, 1, 1);
+                for (int i = 0; i < st->nmember; ++i)
+                    if (SameName(m, st->member[i], st->member_len[i])) mt = st->member_type[i];
+                v.t = mt;
+            } else {
+                v.t = MakeType(v.t.base, 1, m->len >= 1 && m->len <= 4 ? m->len : 1);
+            }
+            v.known = v.known && m->len == 1;
+            v.partial = true;
+        } else if (TokIs(t, "[")) {
+            Next(a);
+            Val i = Expression(a);
+            Expect(a, "]");
+            if (v.t.array) v.t.array = 0;
+            else if (IsMatrix(v.t)) v.t = MakeType(v.t.base, 1, v.t.rows);
+            else v.t = MakeType(v.t.base, 1, 1);
+            v.varying |= i.varying;
+            v.known = false;
+            v.partial = true;
+        } else if (TokIs(t, "++") || TokIs(t, "--")) {
+            Next(a);
+            Charge(a, COST_ALU, Width(v.t), t);
+            Val r = v;
+            r.known = false;
+            Assign(a, v, r, false);
+            v.known = false;
+            v.sym = -1;
+        } else {
+            return v;
+        }
+    }
+}
+
+static Val Unary(Analyzer* a) {
+    const Token* t = Peek(a);
+    if (TokIs(t, "-") || TokIs(t, "+")) { // a source modifier, free
+        Next(a);
+        Val v = Unary(a);
+        if (TokIs(t, "-")) v.k = -v.k;
+        v.sym = -1;
+        return v;
+    }
+    if (TokIs(t, "!") || TokIs(t, "~")) {
+        Next(a);
+        Val v = Unary(a);
+        if (v.known) return KnownVal(TokIs(t, "!") ? BT_BOOL : BT_INT, TokIs(t, "!") ? !v.k : (double)~(long long)v.k);
+        Charge(a, COST_ALU, Width(v.t), t);
+        v.sym = -1;
+        return v;
+    }
+    if (TokIs(t, "++") || TokIs(t, "--")) {
+        Next(a);
+        Val v = Unary(a);
+        Charge(a, COST_ALU, Width(v.t), t);
+        Val r = v;
+        r.known = false;
+        return Assign(a, v, r, false);
+    }
+    return Postfix(a);
+}
+
+static int BinaryPrec(const Token* t) {
+    static const struct { const char* op; int prec; } ops[] = {
+        { "||", 1 }, { "^^", 2 }, { "&&", 3 }, { "|", 4 }, { "^", 5 }, { "&", 6 }, { "==", 7 }, { "!=", 7 },
+        { "<", 8 }, { ">", 8 }, { "<=", 8 }, { ">=", 8 }, { "<<", 9 }, { ">>", 9 },
+        { "+", 10 }, { "-", 10 }, { "*", 11 }, { "/", 11 }, { "%", 11 },
+    };
+    if (t->kind != TOK_PUNCT) return 0;
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); ++i) if (TokIs(t, ops[i].op)) return ops[i].prec;
+    return 0;
+}
+
+static Val Binary(Analyzer* a, int min_prec) {
+    int from = a->pos;
+    Val l = Unary(a);
+    for (;;) {
+        const Token* op = Peek(a);
+        int p = BinaryPrec(op);
+        if (!p || p < min_prec) return l;
+        Next(a);
+        Val r = Binary(a, p + 1);
+        char o[3] = { op->s[0], op->len > 1 ? op->s[1] : 0, 0 };
+        // Remember "var < const" for the trip count of the loop being parsed.
+        if (p == 8) {
+            bool lvar = l.sym >= 0 && !l.partial, rvar = r.sym >= 0 && !r.partial;
+            if ((lvar && r.known) || (rvar && l.known)) {
+                a->cmp.sym = lvar ? l.sym : r.sym;
+                a->cmp.k = lvar ? r.k : l.k;
+                a->cmp.sym_left = lvar;
+                a->cmp.op = TokIs(op, "<") ? "<" : TokIs(op, "<=") ? "<=" : TokIs(op, ">") ? ">" : ">=";
+                a->cmp.from = from;
+                a->cmp.to = a->pos;
+            }
+            if (lvar && !a->sym[l.sym].known) l.known = false;
+        }
+        l = Arith(a, o, l, r, op);
+        l.sym = -1;
+    }
+}
+
+static Val Ternary(Analyzer* a) {
+    Val c = Binary(a, 1);
+    const Token* q = Peek(a);
+    if (!Accept(a, "?")) return c;
+    Val x = Expression(a);
+    Expect(a, ":");
+    Val y = Assignment(a);
+    if (c.known) return c.k != 0.0 ? x : y;
+    Val v = MakeVal(Width(y.t) > Width(x.t) ? y.t : x.t);
+    v.varying = c.varying || x.varying || y.varying;
+    Charge(a, COST_ALU, Width(v.t), q); // a select; both sides were counted
+    return v;
+}
+
+static Val Assignment(Analyzer* a) {
+    Val l = Ternary(a);
+    const Token* op = Peek(a);
+    if (op->kind != TOK_PUNCT || op->s[op->len - 1] != '=' || TokIs(op, "==") || TokIs(op, "!=") ||
+        TokIs(op, "<=") || TokIs(op, ">=")) return l;
+    Next(a);
+    Val r = Assignment(a);
+    if (!TokIs(op, "=")) {
+        char o[3] = { op->s[0], op->len > 2 ? op->s[1] : 0, 0 };
+        r = Arith(a, o, l, r, op);
+    }
+    return Assign(a, l, r, TokIs(op, "="));
+}
+
+static Val Expression(Analyzer* a) {
+    Val v = Assignment(a);
+    while (Accept(a, ",")) v = Assignment(a);
+    return v;
+}
+
+// ========================== Statements =============================
+static bool DeclarationAhead(Analyzer* a) {
+    const Token* t = Peek(a);
+    if (IsQualifier(t) || TokIs(t, "struct")) return true;
+    if (!IsTypeName(a, t)) return false;
+    const Token* n = PeekAt(a, 1);
+    return n->kind == TOK_IDENT || TokIs(n, "[");
+}
+
+// Declarators after the type up to the ';'. Returns the first variable's symbol.
+static int Declarators(Analyzer* a, Type base, Qualifiers q) {
+    int first = -1;
+    do {
+        const Token* name = Next(a);
+        if (name->kind != TOK_IDENT) break;
+        Type t = base;
+        ArraySuffix(a, &t);
+        Val init = MakeVal(t);
+        bool has_init = Accept(a, "=");
+        if (has_init) init = Assignment(a);
+        int s = AddSymbolNamed(a, name->s, name->len, t, q.in || init.varying || (has_init && a->divergent > 0));
+        a->sym[s].readonly = q.in || q.uniform || q.constant;
+        a->sym[s].known = has_init && init.known && IsScalar(t);
+        a->sym[s].k = init.k;
+        if (first < 0) first = s;
+    } while (Accept(a, ","));
+    Expect(a, ";");
+    return first;
+}
+
+static int Declaration(Analyzer* a) {
+    Qualifiers q = ParseQualifiers(a);
+    Type t;
+    if (!ParseType(a, &t)) { Expect(a, ";"); return -1; }
+    if (Accept(a, ";")) return -1; // a struct declaration
+    return Declarators(a, t, q);
+}
+
+// Moves the cursor past one statement without counting it.
+static void SkipStatement(Analyzer* a) {
+    const Token* t = Peek(a);
+    if (TokIs(t, "{")) { a->pos = MatchingClose(a, a->pos) + 1; return; }
+    if (TokIs(t, "if")) {
+        Next(a);
+        a->pos = MatchingClose(a, a->pos) + 1;
+        SkipStatement(a);
+        if (Accept(a, "else")) SkipStatement(a);
+        return;
+    }
+    if (TokIs(t, "for") || TokIs(t, "while") || TokIs(t, "switch")) {
+        Next(a);
+        a->pos = MatchingClose(a, a->pos) + 1;
+        SkipStatement(a);
+        return;
+    }
+    if (TokIs(t, "do")) {
+        Next(a);
+        SkipStatement(a);
+        Accept(a, "while");
+        a->pos = MatchingClose(a, a->pos) + 1;
+        Accept(a, ";");
+        return;
+    }
+    a->pos = FindSemicolon(a) + 1;
+    if (a->pos > a->tok.n) a->pos = a->tok.n;
+}
+
+static CostVec Arm(Analyzer* a, bool divergent) {
+    CostVec v = { { 0 } };
+    CostVec* saved = a->acc;
+    a->acc = &v;
+    a->divergent += divergent;
+    Statement(a);
+    a->divergent -= divergent;
+    a->acc = saved;
+    return v;
+}
+
+static void IfStatement(Analyzer* a) {
+    const Token* kw = Next(a);
+    Expect(a, "(");
+    Val c = Expression(a);
+    Expect(a, ")");
+    if (c.known) { // decided at compile time
+        if (c.k != 0.0) Statement(a); else SkipStatement(a);
+        if (Accept(a, "else")) { if (c.k != 0.0) SkipStatement(a); else Statement(a); }
+        return;
+    }
+    Charge(a, COST_BRANCH, 1.0, kw);
+    CostVec t = Arm(a, c.varying), e = { { 0 } };
+    if (Accept(a, "else")) e = Arm(a, c.varying);
+    if (c.varying) {
+        // Lanes split: the group runs both sides.
+        AddScaled(a->acc, &t, 1.0);
+        AddScaled(a->acc, &e, 1.0);
+        Hotspot(a, TokIndex(a, kw), "if", (Weighted(&t) + Weighted(&e)) * a->mult);
+    } else {
+        AddScaled(a->acc, Weighted(&t) >= Weighted(&e) ? &t : &e, 1.0);
+    }
+}
+
+// Trip count of "for (v = A; v op B; v += C)" or -1.
+static int StaticTrips(Analyzer* a, int counter, double start, int cond_from, int cond_to, int incr_from, int incr_to) {
+    if (counter < 0 || a->cmp.sym != counter || a->cmp.from != cond_from || a->cmp.to != cond_to) return -1;
+    const Symbol* s = &a->sym[counter];
+    const Token* t = &a->tok.t[incr_from];
+    double step = 0.0, k;
+    int n = incr_to - incr_from;
+    if (n == 2 && SameName(t, s->name, s->len) && (TokIs(t + 1, "++") || TokIs(t + 1, "--")))
+        step = TokIs(t + 1, "++") ? 1.0 : -1.0;
+    else if (n == 2 && SameName(t + 1, s->name, s->len) && (TokIs(t, "++") || TokIs(t, "--")))
+        step = TokIs(t, "++") ? 1.0 : -1.0;
+    else if (n >= 3 && SameName(t, s->name, s->len) && (TokIs(t + 1, "+=") || TokIs(t + 1, "-=")) &&
+             ConstRange(a, incr_from + 2, incr_to, &k))
+        step = TokIs(t + 1, "+=") ? k : -k;
+    else if (n >= 5 && SameName(t, s->name, s->len) && TokIs(t + 1, "=") && SameName(t + 2, s->name, s->len) &&
+             (TokIs(t + 3, "+") || TokIs(t + 3, "-")) && ConstRange(a, incr_from + 4, incr_to, &k))
+        step = TokIs(t + 3, "+") ? k : -k;
+    else if (n >= 3 && SameName(t, s->name, s->len) && TokIs(t + 1, "*=") && ConstRange(a, incr_from + 2, incr_to, &k) &&
+             k > 1.0 && start > 0.0) { // geometric: v *= K
+        const char* op = a->cmp.op;
+        if (!a->cmp.sym_left || op[0] != '<') return -1;
+        double trips = ceil(log(a->cmp.k / start) / log(k) - 1e-9) + (op[1] == '=');
+        return trips < 0.0 ? 0 : trips > 1e7 ? -1 : (int)trips;
+    }
+    if (step == 0.0) return -1;
+    char op[3];
+    snprintf(op, sizeof(op), "%s", a->cmp.op);
+    if (!a->cmp.sym_left) op[0] = op[0] == '<' ? '>' : '<'; // "B > v" is "v < B"
+    double span = a->cmp.k - start, trips;
+    if (op[0] == '<' && step > 0.0)      trips = op[1] ? floor(span / step + 1e-9) + 1.0 : ceil(span / step - 1e-9);
+    else if (op[0] == '>' && step < 0.0) trips = op[1] ? floor(span / step + 1e-9) + 1.0 : ceil(span / step - 1e-9);
+    else return -1; // runs away from its bound
+    return trips < 0.0 ? 0 : trips > 1e7 ? -1 : (int)trips;
+}
+
+// One iteration: [cond), body, [incr), times n. Returns the cost of one iteration.
+static CostVec Iteration(Analyzer* a, const Token* kw, double n, int cond_from, int cond_to, int body_from,
+                         int incr_from, int incr_to, bool* cond_varying) {
+    CostVec v = { { 0 } };
+    CostVec* saved = a->acc;
+    double saved_mult = a->mult;
+    a->acc = &v;
+    a->mult *= n;
+    *cond_varying = false;
+    if (cond_from < cond_to) {
+        a->pos = cond_from;
+        *cond_varying = Expression(a).varying;
+    }
+    Charge(a, COST_BRANCH, 1.0, kw);
+    a->pos = body_from;
+    Statement(a);
+    if (incr_from < incr_to) {
+        a->pos = incr_from;
+        Expression(a);
+    }
+    a->acc = saved;
+    a->mult = saved_mult;
+    return v;
+}
+
+static void Loop(Analyzer* a) {
+    const Token* kw = Next(a);
+    int saved_nsym = a->nsym;
+    int counter = -1, trips = -1;
+    double start = 0.0;
+    int cond_from, cond_to, body_from, body_to, incr_from = 0, incr_to = 0;
+    if (TokIs(kw, "do")) {
+        body_from = a->pos;
+        SkipStatement(a);
+        Accept(a, "while");
+        cond_from = a->pos + 1;
+        cond_to = MatchingClose(a, a->pos);
+        a->pos = cond_to + 1;
+        Accept(a, ";");
+        body_to = a->pos;
+    } else {
+        int close = MatchingClose(a, a->pos);
+        Expect(a, "(");
+        if (TokIs(kw, "for")) {
+            if (DeclarationAhead(a)) counter = Declaration(a);
+            else if (!Accept(a, ";")) { counter = Expression(a).sym; Expect(a, ";"); }
+            if (counter >= 0) { // its value goes into the trip count, not into the condition
+                start = a->sym[counter].k;
+                if (!a->sym[counter].known) counter = -1;
+                else a->sym[counter].known = false;
+            }
+            cond_from = a->pos;
+            cond_to = FindSemicolon(a);
+            incr_from = cond_to + 1;
+            incr_to = close;
+        } else {
+            cond_from = a->pos;
+            cond_to = close;
+        }
+        body_from = close + 1;
+        a->pos = body_from;
+        SkipStatement(a);
+        body_to = a->pos;
+    }
+
+    if (a->nloop == MAX_LOOPS) { Fail(a, kw, "loops nested deeper than %d", MAX_LOOPS); return; }
+    bool cond_varying = false;
+    if (TokIs(kw, "for") && counter >= 0) {
+        a->cmp.sym = -1;
+        a->pos = cond_from;
+        a->silent++;
+        Expression(a); // for a->cmp
+        a->silent--;
+        trips = StaticTrips(a, counter, start, cond_from, cond_to, incr_from, incr_to);
+    }
+    double n = trips >= 0 ? trips : 1.0;
+    LoopCtx ctx = { -1, a->divergent, false, false };
+    if (!a->silent) { // let per-pixel values carried around the loop reach everything first
+        a->loop[a->nloop++] = ctx;
+        a->silent++;
+        Iteration(a, kw, n, cond_from, cond_to, body_from, incr_from, incr_to, &cond_varying);
+        a->silent--;
+        --a->nloop;
+    }
+    a->loop[a->nloop++] = ctx;
+    CostVec body = Iteration(a, kw, n, cond_from, cond_to, body_from, incr_from, incr_to, &cond_varying);
+    ctx = a->loop[--a->nloop];
+    AddScaled(a->acc, &body, n);
+
+    if (!a->silent) {
+        LoopStat* l = LoopAt(a, TokIndex(a, kw));
+        bool divergent = ctx.divergent_exit || (cond_varying && trips < 0);
+        double w = Weighted(&body);
+        l->trips = trips;
+        l->early_exit |= ctx.early_exit;
+        l->divergent |= divergent;
+        if (w > l->body) l->body = w;
+        l->cost += w * n * a->mult;
+        if (divergent) Hotspot(a, l->tok, "loop exit", w * n * a->mult);
+    }
+    a->nsym = saved_nsym;
+    a->pos = body_to;
+}
+
+static void Switch(Analyzer* a) {
+    const Token* kw = Next(a);
+    Expect(a, "(");
+    Val c = Expression(a);
+    Expect(a, ")");
+    Charge(a, COST_BRANCH, 1.0, kw);
+    if (a->nloop == MAX_LOOPS) { Fail(a, kw, "loops nested deeper than %d", MAX_LOOPS); return; }
+    a->loop[a->nloop++] = (LoopCtx){ -1, a->divergent, false, false };
+    a->divergent += c.varying;
+    int saved_nsym = a->nsym;
+    Expect(a, "{");
+    while (!TokIs(Peek(a), "}") && Peek(a)->kind != TOK_EOF) { // every case counts
+        if (TokIs(Peek(a), "case") || TokIs(Peek(a), "default")) { Expect(a, ":"); continue; }
+        Statement(a);
+    }
+    Accept(a, "}");
+    a->nsym = saved_nsym;
+    a->divergent -= c.varying;
+    --a->nloop;
+}
+
+// Marks the loops a break or return leaves early.
+static void ExitLoops(Analyzer* a, int from) {
+    for (int i = from; i < a->nloop; ++i) {
+        a->loop[i].early_exit = true;
+        if (a->divergent > a->loop[i].divergent) a->loop[i].divergent_exit = true;
+    }
+}
+
+static void StatementOn(Analyzer* a) {
+    const Token* t = Peek(a);
+    int start = a->pos;
+    if (t->kind == TOK_EOF) return;
+    if (!a->silent) { LineStat* l = LineAt(a, t); if (l) l->runs += a->mult; }
+    if (TokIs(t, "{")) { Block(a); return; }
+    if (TokIs(t, "if")) { IfStatement(a); return; }
+    if (TokIs(t, "for") || TokIs(t, "while") || TokIs(t, "do")) { Loop(a); return; }
+    if (TokIs(t, "switch")) { Switch(a); return; }
+    if (TokIs(t, "break") || TokIs(t, "continue")) {
+        Next(a);
+        if (TokIs(t, "break") && a->nloop) ExitLoops(a, a->nloop - 1);
+        Expect(a, ";");
+        return;
+    }
+    if (TokIs(t, "return")) {
+        Next(a);
+        bool varying = !TokIs(Peek(a), ";") && Expression(a).varying;
+        if (a->ncall) {
+            CallFrame* f = &a->call[a->ncall - 1];
+            f->ret_varying |= varying || a->divergent > f->divergent;
+            ExitLoops(a, f->loop_base);
+        }
+        Expect(a, ";");
+        return;
+    }
+    if (TokIs(t, "discard")) { Next(a); Expect(a, ";"); return; }
+    if (Accept(a, ";")) return;
+    if (DeclarationAhead(a)) { Declaration(a); return; }
+    Expression(a);
+    Expect(a, ";");
+    if (a->pos == start) Next(a);
+}
+
+// Runs and cost both land on the statement's first line, so continuation lines of a call
+// or an expression are never listed with cost but no runs.
+static void Statement(Analyzer* a) {
+    const Token* outer = a->stmt;
+    a->stmt = Peek(a);
+    StatementOn(a);
+    a->stmt = outer;
+}
+
+static void Block(Analyzer* a) {
+    int saved_nsym = a->nsym;
+    Expect(a, "{");
+    while (!TokIs(Peek(a), "}") && Peek(a)->kind != TOK_EOF) Statement(a);
+    Accept(a, "}");
+    a->nsym = saved_nsym;
+}
+
+// ========================== Top level ==============================
+static void FunctionDefinition(Analyzer* a, Type ret) {
+    const Token* name = Next(a);
+    Expect(a, "(");
+    Function f;
+    memset(&f, 0, sizeof(f));
+    f.name = name->s; f.len = name->len; f.ret = ret;
+    if (TokIs(Peek(a), "void") && TokIs(PeekAt(a, 1), ")")) Next(a);
+    while (!TokIs(Peek(a), ")") && Peek(a)->kind != TOK_EOF) {
+        Qualifiers q = ParseQualifiers(a);
+        Type pt;
+        if (!ParseType(a, &pt)) { Expect(a, ")"); --a->pos; break; }
+        const Token* pn = Peek(a)->kind == TOK_IDENT ? Next(a) : NULL;
+        ArraySuffix(a, &pt);
+        if (f.nparam < MAX_PARAMS) {
+            f.ptype[f.nparam] = pt;
+            f.pqual[f.nparam] = q.out ? (q.in ? Q_INOUT : Q_OUT) : Q_IN;
+            f.pname[f.nparam++] = pn;
+        }
+        if (!Accept(a, ",")) break;
+    }
+    Expect(a, ")");
+    if (!TokIs(Peek(a), "{")) { Accept(a, ";"); return; } // a prototype
+    f.body = a->pos;
+    f.stat = FnStatFor(a, f.name, f.len);
+    a->fn = (Function*)Grow(a->fn, &a->capfn, a->nfn + 1, sizeof(Function));
+    a->fn[a->nfn++] = f;
+    a->pos = MatchingClose(a, a->pos) + 1;
+}
+
+// Interface block: "uniform Name { members } [instance];"
+static void InterfaceBlock(Analyzer* a, Qualifiers q) {
+    const Token* name = Next(a);
+    int s = ParseMembers(a, name);
+    if (Peek(a)->kind == TOK_IDENT) {
+        Type t = MakeType(BT_STRUCT, 1, 1);
+        t.strct = (int16_t)s;
+        Declarators(a, t, q);
+        return;
+    }
+    const Struct* st = &a->st[s];
+    for (int i = 0; i < st->nmember; ++i) {
+        int v = AddSymbolNamed(a, st->member[i], st->member_len[i], st->member_type[i], q.in);
+        a->sym[v].readonly = q.in || q.uniform;
+    }
+    Expect(a, ";");
+}
+
+static void TopLevel(Analyzer* a) {
+    static const struct { const char* name; int base, rows; bool varying; } builtins[] = {
+        { "gl_FragCoord", BT_FLOAT, 4, true },  { "gl_FrontFacing", BT_BOOL, 1, true },
+        { "gl_PointCoord", BT_FLOAT, 2, true }, { "gl_SampleID", BT_INT, 1, true },
+        { "gl_SamplePosition", BT_FLOAT, 2, true }, { "gl_PrimitiveID", BT_INT, 1, true },
+        { "gl_FragDepth", BT_FLOAT, 1, false },
+    };
+    for (size_t i = 0; i < sizeof(builtins) / sizeof(builtins[0]); ++i)
+        AddSymbolNamed(a, builtins[i].name, (int)strlen(builtins[i].name),
+                       MakeType(builtins[i].base, 1, builtins[i].rows), builtins[i].varying);
+
+    a->silent++; // global initializers
+    while (Peek(a)->kind != TOK_EOF && !a->failed) {
+        int start = a->pos;
+        if (Accept(a, ";")) continue;
+        if (TokIs(Peek(a), "precision")) { Expect(a, ";"); continue; }
+        Qualifiers q = ParseQualifiers(a);
+        const Token* t = Peek(a);
+        if (t->kind == TOK_IDENT && TokIs(PeekAt(a, 1), "{") && !IsTypeName(a, t) && !TokIs(t, "struct")) {
+            InterfaceBlock(a, q);
+        } else {
+            Type ty;
+            if (!ParseType(a, &ty)) Expect(a, ";");
+            else if (Accept(a, ";")) {} // struct declaration or a lone layout
+            else if (Peek(a)->kind == TOK_IDENT && TokIs(PeekAt(a, 1), "(")) FunctionDefinition(a, ty);
+            else Declarators(a, ty, q);
+        }
+        if (a->pos == start) Next(a);
+        a->nglobal = a->nsym;
+    }
+    a->silent--;
+}
+
+// ============================ Report ===============================
+static void LineText(const char* s, char* out, size_t outsz) {
+    while (*s == ' ' || *s == '\t') ++s;
+    size_t n = 0;
+    while (s[n] && s[n] != '\n' && s[n] != '\r') ++n;
+    while (n && (s[n - 1] == ' ' || s[n - 1] == '\t')) --n;
+    size_t o = 0;
+    for (size_t i = 0; i < n && o + 1 < outsz; ++i) {
+        char ch = s[i] == '\t' ? ' ' : s[i];
+        if (ch == ' ' && o && out[o - 1] == ' ') continue; // blanked comments leave runs of spaces
+        out[o++] = ch;
+    }
+    while (o && out[o - 1] == ' ') --o;
+    out[o] = 0;
+}
+
+static uint64_t LineKey(const ShaderFileTable* files, int file, const char* text) {
+    return Hash64String(text, file < files->count ? Hash64String(files->path[file], 0) : (uint64_t)file);
+}
+
+static int CompareFunctions(const void* x, const void* y) {
+    double a = ((const CostFunction*)x)->cost, b = ((const CostFunction*)y)->cost;
+    return a < b ? 1 : a > b ? -1 : 0;
+}
+static int CompareLines(const void* x, const void* y) {
+    const CostLine* a = (const CostLine*)x;
+    const CostLine* b = (const CostLine*)y;
+    if (a->cost != b->cost) return a->cost < b->cost ? 1 : -1;
+    return a->file != b->file ? a->file - b->file : a->line - b->line;
+}
+static int CompareHotspots(const void* x, const void* y) {
+    double a = ((const CostHotspot*)x)->cost, b = ((const CostHotspot*)y)->cost;
+    return a < b ? 1 : a > b ? -1 : 0;
+}
+
+static void BuildReport(Analyzer* a, const ShaderFileTable* files, const CostVec* total, ShaderCostReport* out) {
+    out->files = *files;
+    for (int c = 0; c < COST_CATEGORIES; ++c) out->count[c] = total->n[c];
+    out->total = Weighted(total);
+
+    out->functions = (CostFunction*)calloc((size_t)(a->nfs + 1), sizeof(CostFunction));
+    for (int i = 0; i < a->nfs; ++i) {
+        const FnStat* s = &a->fs[i];
+        if (s->calls <= 0.0) continue;
+        CostFunction* f = &out->functions[out->function_count++];
+        snprintf(f->name, sizeof(f->name), "%.*s", s->len, s->name);
+        f->calls = s->calls;
+        f->cost = s->cost;
+        f->self = s->cost - s->children;
+    }
+    qsort(out->functions, (size_t)out->function_count, sizeof(CostFunction), CompareFunctions);
+
+    int nlines = 0;
+    for (int s = 0; s < SHADER_MAX_FILES; ++s)
+        for (int l = 1; l <= a->nlines[s]; ++l) nlines += a->lines[s][l].cost > 0.0;
+    out->lines = (CostLine*)calloc((size_t)(nlines + 1), sizeof(CostLine));
+    for (int s = 0; s < SHADER_MAX_FILES; ++s)
+        for (int l = 1; l <= a->nlines[s]; ++l) {
+            const LineStat* st = &a->lines[s][l];
+            if (st->cost <= 0.0) continue;
+            CostLine* cl = &out->lines[out->line_count++];
+            cl->file = s;
+            cl->line = l;
+            LineText(st->text ? st->text : "", cl->text, sizeof(cl->text));
+            cl->key = LineKey(files, s, cl->text);
+            for (int c = 0; c < COST_CATEGORIES; ++c) cl->count[c] = st->n[c];
+            cl->cost = st->cost;
+            cl->runs = st->runs;
+        }
+    qsort(out->lines, (size_t)out->line_count, sizeof(CostLine), CompareLines);
+
+    out->loops = (CostLoop*)calloc((size_t)(a->nloops + 1), sizeof(CostLoop));
+    for (int i = 0; i < a->nloops; ++i) { // in token order
+        int best = i;
+        for (int j = i + 1; j < a->nloops; ++j) if (a->loops[j].tok < a->loops[best].tok) best = j;
+        LoopStat tmp = a->loops[i]; a->loops[i] = a->loops[best]; a->loops[best] = tmp;
+        const LoopStat* s = &a->loops[i];
+        const Token* t = &a->tok.t[s->tok];
+        CostLoop* l = &out->loops[out->loop_count++];
+        if (s->fn >= 0) snprintf(l->function, sizeof(l->function), "%.*s", a->fn[s->fn].len, a->fn[s->fn].name);
+        l->ordinal = s->ordinal;
+        l->file = t->source;
+        l->line = t->line;
+        l->depth = s->depth;
+        l->trips = s->trips;
+        l->early_exit = s->early_exit;
+        l->divergent = s->divergent;
+        l->body = s->body;
+        l->cost = s->cost;
+        out->dynamic_loops += s->trips < 0;
+    }
+
+    out->hotspots = (CostHotspot*)calloc((size_t)(a->nhot + 1), sizeof(CostHotspot));
+    for (int i = 0; i < a->nhot; ++i) {
+        const Token* t = &a->tok.t[a->hot[i].tok];
+        CostHotspot* h = &out->hotspots[out->hotspot_count++];
+        char text[72];
+        LineText(t->line_text, text, sizeof(text));
+        h->file = t->source;
+        h->line = t->line;
+        h->key = LineKey(files, t->source, text);
+        h->kind = a->hot[i].kind;
+        h->cost = a->hot[i].cost;
+    }
+    qsort(out->hotspots, (size_t)out->hotspot_count, sizeof(CostHotspot), CompareHotspots);
+}
+
+bool AnalyzeShaderCost(const char* fsrc, const ShaderFileTable* files, ShaderCostReport* out, char* log, int logsz) {
+    memset(out, 0, sizeof(*out));
+    if (logsz > 0) log[0] = 0;
+    Analyzer* a = (Analyzer*)calloc(1, sizeof(Analyzer));
+    if (!a) { snprintf(log, (size_t)logsz, "out of memory"); return false; }
+    a->log = log;
+    a->logsz = logsz;
+    a->mult = 1.0;
+    a->cmp.sym = -1;
+    a->eof.kind = TOK_EOF;
+
+    Tokenize(a, fsrc);
+    Expand(a, a->raw.t, a->raw.n, 0, NULL, &a->tok);
+    if (a->tok.n) { a->eof.source = a->tok.t[a->tok.n - 1].source; a->eof.line = a->tok.t[a->tok.n - 1].line; }
+
+    CostVec total = { { 0 } };
+    a->acc = &total;
+    if (!a->failed) TopLevel(a);
+    a->pos = 0;
+    int main_fn = -1;
+    for (int i = 0; i < a->nfn && main_fn < 0; ++i) if (NameIs(a->fn[i].name, a->fn[i].len, "main")) main_fn = i;
+    if (!a->failed && main_fn < 0) Fail(a, NULL, "no main() in the fragment shader");
+    if (!a->failed) CallFunction(a, main_fn, NULL, 0, &a->tok.t[a->fn[main_fn].body]);
+    bool ok = !a->failed;
+    if (ok) BuildReport(a, files, &total, out);
+
+    for (int s = 0; s < SHADER_MAX_FILES; ++s) free(a->lines[s]);
+    free(a->loops); free(a->hot);
+    free(a->st); free(a->sym); free(a->fn); free(a->fs);
+    free(a->raw.t); free(a->tok.t); free(a->mtok.t); free(a->line.t);
+    free(a->text);
+    free(a);
+    return ok;
+}
+
+void FreeShaderCostReport(ShaderCostReport* r) {
+    free(r->functions);
+    free(r->lines);
+    free(r->loops);
+    free(r->hotspots);
+    memset(r, 0, sizeof(*r));
+}
+
+// ============================ Output ===============================
+static const char* FileName(const ShaderCostReport* r, int file) {
+    if (file < 0 || file >= r->files.count) return "?";
+    const char* p = r->files.path[file];
+    for (const char* s = p; *s; ++s) if (*s == '/' || *s == '\\') p = s + 1;
+    return p;
+}
+
+static void Appendf(char* out, size_t outsz, size_t* n, const char* fmt, ...) {
+    if (*n + 1 >= outsz) return;
+    va_list ap;
+    va_start(ap, fmt);
+    int w = vsnprintf(out + *n, outsz - *n, fmt, ap);
+    va_end(ap);
+    if (w > 0) *n = *n + (size_t)w < outsz ? *n + (size_t)w : outsz - 1;
+}
+
+void FormatShaderCostSummary(const ShaderCostReport* r, char* out, size_t outsz) {
+    size_t n = 0;
+    out[0] = 0;
+    Appendf(out, outsz, &n, "~%.0f/px:", r->total);
+    for (int c = 0; c < COST_CATEGORIES; ++c)
+        Appendf(out, outsz, &n, "%s %s %.0f", c ? "," : "", s_category[c], r->count[c]);
+    if (r->dynamic_loops)
+        Appendf(out, outsz, &n, " (%d dynamic loop%s counted once)", r->dynamic_loops, r->dynamic_loops > 1 ? "s" : "");
+}
+
+static void LoopName(const ShaderCostReport* r, const CostLoop* l, char* out, size_t outsz) {
+    snprintf(out, outsz, "%sloop in %s() at %s:%d", l->depth ? "inner " : "", l->function[0] ? l->function : "?",
+             FileName(r, l->file), l->line);
+}
+
+static void TripsText(const CostLoop* l, char* out, size_t outsz) {
+    if (l->trips >= 0) snprintf(out, outsz, "%d iterations", l->trips);
+    else snprintf(out, outsz, "dynamic bound");
+}
+
+void PrintShaderCostReport(FILE* f, const ShaderCostReport* r, int top_lines) {
+    char buf[512];
+    FormatShaderCostSummary(r, buf, sizeof(buf));
+    fprintf(f, "cost %s\n", buf);
+    double total = r->total > 0.0 ? r->total : 1.0;
+    if (r->function_count) {
+        fprintf(f, "functions:%26s %10s %10s\n", "calls/px", "cost", "self");
+        for (int i = 0; i < r->function_count; ++i) {
+            const CostFunction* fn = &r->functions[i];
+            fprintf(f, "  %-32s %10.1f %10.1f %10.1f  %5.1f%%\n", fn->name, fn->calls, fn->cost, fn->self,
+                    fn->cost * 100.0 / total);
+        }
+    }
+    if (r->loop_count) {
+        fprintf(f, "loops:\n");
+        for (int i = 0; i < r->loop_count; ++i) {
+            const CostLoop* l = &r->loops[i];
+            char name[160], trips[32];
+            LoopName(r, l, name, sizeof(name));
+            TripsText(l, trips, sizeof(trips));
+            fprintf(f, "  %s: %s%s%s, body %.1f, cost %.1f (%.1f%%)\n", name, trips,
+                    l->early_exit ? ", early exit" : "", l->divergent ? ", divergent" : "",
+                    l->body, l->cost, l->cost * 100.0 / total);
+        }
+    }
+    if (r->hotspot_count) {
+        fprintf(f, "divergent hotspots:\n");
+        for (int i = 0; i < r->hotspot_count && i < 8; ++i) {
+            const CostHotspot* h = &r->hotspots[i];
+            fprintf(f, "  %s:%d %s, %.1f under it (%.1f%%)\n", FileName(r, h->file), h->line, h->kind, h->cost,
+                    h->cost * 100.0 / total);
+        }
+    }
+    if (r->line_count && top_lines > 0) {
+        fprintf(f, "lines:%*s %8s %8s  %s\n", 22, "runs/px", "cost", "share", "source");
+        for (int i = 0; i < r->line_count && i < top_lines; ++i) {
+            const CostLine* l = &r->lines[i];
+            char where[96];
+            snprintf(where, sizeof(where), "%s:%d", FileName(r, l->file), l->line);
+            fprintf(f, "  %-24s %8.1f %8.1f %7.1f%%  %s\n", where, l->runs, l->cost, l->cost * 100.0 / total, l->text);
+        }
+    }
+}
+
+// ============================== Diff ===============================
+static bool Significant(const ShaderCostReport* prev, const ShaderCostReport* cur, double cost) {
+    double total = prev->total > cur->total ? prev->total : cur->total;
+    return total > 0.0 && cost >= total * SHADER_COST_MIN_SHARE;
+}
+
+static bool Grew(double before, double after) {
+    return after > before * SHADER_COST_WARN_RATIO + 1e-9;
+}
+static bool Shrank(double before, double after) {
+    return after * SHADER_COST_WARN_RATIO < before - 1e-9;
+}
+
+// The same line (by key) as the occurrence-th one with that key in lines.
+static const CostLine* MatchLine(const ShaderCostReport* r, uint64_t key, int occurrence) {
+    for (int i = 0; i < r->line_count; ++i)
+        if (r->lines[i].key == key && occurrence-- == 0) return &r->lines[i];
+    return NULL;
+}
+
+int DiffShaderCost(const ShaderCostReport* prev, const ShaderCostReport* cur, char* out, size_t outsz) {
+    size_t n = 0;
+    int warnings = 0;
+    out[0] = 0;
+    if (fabs(cur->total - prev->total) >= 0.5) {
+        Appendf(out, outsz, &n, "%scost ~%.0f -> ~%.0f/px (x%.2f):", Grew(prev->total, cur->total) ? "warning: " : "",
+                prev->total, cur->total, prev->total > 0.0 ? cur->total / prev->total : 0.0);
+        warnings += Grew(prev->total, cur->total);
+        const char* sep = "";
+        for (int c = 0; c < COST_CATEGORIES; ++c) {
+            if (fabs(cur->count[c] - prev->count[c]) < 0.5) continue;
+            Appendf(out, outsz, &n, "%s %s %.0f -> %.0f", sep, s_category[c], prev->count[c], cur->count[c]);
+            sep = ",";
+        }
+        Appendf(out, outsz, &n, "\n");
+    }
+    if (cur->dynamic_loops > prev->dynamic_loops)
+        Appendf(out, outsz, &n, "%d more loop%s with a dynamic bound (counted once)\n",
+                cur->dynamic_loops - prev->dynamic_loops, cur->dynamic_loops - prev->dynamic_loops > 1 ? "s" : "");
+
+    // Loops are matched by function and position within it, so moving them is no change.
+    for (int i = 0; i < cur->loop_count; ++i) {
+        const CostLoop* l = &cur->loops[i];
+        const CostLoop* p = NULL;
+        for (int j = 0; j < prev->loop_count && !p; ++j)
+            if (!strcmp(prev->loops[j].function, l->function) && prev->loops[j].ordinal == l->ordinal) p = &prev->loops[j];
+        char name[160], why[96];
+        LoopName(cur, l, name, sizeof(name));
+        if (!p) {
+            if (!Significant(prev, cur, l->cost)) continue;
+            char trips[32];
+            TripsText(l, trips, sizeof(trips));
+            Appendf(out, outsz, &n, "new %s: %s, %.0f/px (%.0f%%)\n", name, trips, l->cost, l->cost * 100.0 / cur->total);
+            continue;
+        }
+        bool grew = Grew(p->cost, l->cost), shrank = Shrank(p->cost, l->cost);
+        if (!(grew || shrank) || !Significant(prev, cur, grew ? l->cost : p->cost)) continue;
+        if (p->trips != l->trips && p->trips >= 0 && l->trips >= 0)
+            snprintf(why, sizeof(why), "%d -> %d iterations", p->trips, l->trips);
+        else if (p->trips != l->trips)
+            snprintf(why, sizeof(why), "bound now %s", l->trips < 0 ? "dynamic" : "static");
+        else
+            snprintf(why, sizeof(why), "body %.1f -> %.1f", p->body, l->body);
+        Appendf(out, outsz, &n, "%s%s costs x%.2f: %.0f -> %.0f/px (%s)\n", grew ? "warning: " : "", name,
+                p->cost > 0.0 ? l->cost / p->cost : 0.0, p->cost, l->cost, why);
+        warnings += grew;
+    }
+
+    int shown = 0;
+    for (int i = 0; i < cur->function_count && shown < 3; ++i) {
+        const CostFunction* f = &cur->functions[i];
+        const CostFunction* p = NULL;
+        for (int j = 0; j < prev->function_count && !p; ++j) if (!strcmp(prev->functions[j].name, f->name)) p = &prev->functions[j];
+        if (!p || !strcmp(f->name, "main")) continue; // main is the total
+        bool grew = Grew(p->cost, f->cost), shrank = Shrank(p->cost, f->cost);
+        if (!(grew || shrank) || !Significant(prev, cur, grew ? f->cost : p->cost)) continue;
+        Appendf(out, outsz, &n, "%s%s() costs x%.2f: %.0f -> %.0f/px (%.1f -> %.1f calls)\n", grew ? "warning: " : "",
+                f->name, p->cost > 0.0 ? f->cost / p->cost : 0.0, p->cost, f->cost, p->calls, f->calls);
+        warnings += grew;
+        ++shown;
+    }
+
+    // Lines are matched by file and text, so edits elsewhere don't shift them.
+    shown = 0;
+    for (int i = 0; i < cur->line_count && shown < 3; ++i) {
+        const CostLine* l = &cur->lines[i];
+        int occurrence = 0;
+        for (int j = 0; j < i; ++j) occurrence += cur->lines[j].key == l->key;
+        const CostLine* p = MatchLine(prev, l->key, occurrence);
+        if (!p || !Grew(p->cost, l->cost) || !Significant(prev, cur, l->cost)) continue;
+        Appendf(out, outsz, &n, "warning: %s:%d costs x%.2f: %.0f -> %.0f/px: %s\n", FileName(cur, l->file), l->line,
+                p->cost > 0.0 ? l->cost / p->cost : 0.0, p->cost, l->cost, l->text);
+        ++warnings;
+        ++shown;
+    }
+
+    for (int i = 0; i < cur->hotspot_count; ++i) {
+        const CostHotspot* h = &cur->hotspots[i];
+        bool seen = false;
+        for (int j = 0; j < prev->hotspot_count && !seen; ++j) { // edited in place, or moved
+            const CostHotspot* p = &prev->hotspots[j];
+            seen = p->key == h->key || (p->file == h->file && p->line == h->line && !strcmp(p->kind, h->kind));
+        }
+        if (seen || !Significant(prev, cur, h->cost)) continue;
+        Appendf(out, outsz, &n, "warning: new divergent %s at %s:%d, %.0f/px (%.0f%%) runs for every lane\n", h->kind,
+                FileName(cur, h->file), h->line, h->cost, h->cost * 100.0 / cur->total);
+        ++warnings;
+    }
+    if (n && out[n - 1] == '\n') out[n - 1] = 0;
+    return warnings;
+}
@@ -0,0 +1,107 @@
+// shader_cost.h — static per-pixel cost estimate of a fragment shader, and what an edit changed
+//
+// Reads the expanded fragment source (LoadShaderSources) without any driver: runs the
+// preprocessor (object- and function-like macros, #if), then walks main() the way it
+// executes, inlining every call at its call site so constant arguments and loop bounds
+// carry through. Each operation is counted per component by category:
+//
+//   alu            add, mul, mad, compare, min/max, floor, mix ...       weight 1
+//   transcendental sin, exp, log, pow, sqrt, and the reciprocal of '/'  weight 4
+//   texture        texture(), texelFetch() and friends                  weight 8
+//   branch         if, and the exit test of every loop iteration        weight 1
+//
+// The weights are relative throughput on a typical GPU, not cycles of any one part;
+// the numbers are for comparing versions of the same shader. A for loop of the usual
+// form ("int i = A; i < B; i += C" with constant A, B, C, through macros and const
+// variables) runs its static count; any other loop is dynamic and counted once, which
+// makes the total a lower bound. Values derived from inputs, gl_FragCoord or textures
+// are per-pixel: an if on one is divergent and both sides are charged (the costlier
+// side of a uniform one), and such branches and loop exits are the hotspots.
+//
+// Lines and functions add up every path as often as it runs per pixel; a statement
+// spanning several lines is charged to its first.
+
+#ifndef SHADERDEVEL_SHADER_COST_H
+#define SHADERDEVEL_SHADER_COST_H
+
+#include "platform.h"
+#include "shader_include.h"
+
+#include <stdio.h>
+
+typedef enum {
+    COST_ALU,
+    COST_TRANSCENDENTAL,
+    COST_TEXTURE,
+    COST_BRANCH,
+    COST_CATEGORIES
+} CostCategory;
+
+#define SHADER_COST_WARN_RATIO 1.5 // a loop, function or line this much costlier is a warning
+#define SHADER_COST_MIN_SHARE  0.05 // ... if it is at least this share of the pixel
+
+typedef struct {
+    char   name[64];
+    double calls;   // per pixel
+    double cost;    // weighted per pixel, including callees
+    double self;    // without callees
+} CostFunction;
+
+typedef struct {
+    int      file;   // ShaderFileTable index
+    int      line;
+    char     text[72]; // the line, trimmed
+    uint64_t key;      // file and text: matches the line across edits that move it
+    double   count[COST_CATEGORIES]; // per pixel
+    double   cost;     // weighted per pixel
+    double   runs;     // per pixel
+} CostLine;
+
+typedef struct {
+    char   function[64];
+    int    ordinal;    // loops before it in the function: matches it across edits
+    int    file, line;
+    int    depth;      // loops around it, counting through calls
+    int    trips;      // static iteration count, -1 dynamic
+    bool   early_exit; // break or return inside
+    bool   divergent;  // ... or a loop condition, on per-pixel values
+    double body;       // weighted cost of one iteration
+    double cost;       // weighted per pixel
+} CostLoop;
+
+typedef struct {
+    int         file, line;
+    uint64_t    key;   // as CostLine.key
+    const char* kind;  // "if" or "loop exit"
+    double      cost;  // weighted per pixel of the code whose lanes diverge
+} CostHotspot;
+
+typedef struct {
+    ShaderFileTable files;
+    double        count[COST_CATEGORIES]; // per pixel
+    double        total;                  // weighted
+    int           dynamic_loops;          // total is a lower bound when > 0
+    CostFunction* functions; int function_count; // costliest first
+    CostLine*     lines;     int line_count;     // costliest first
+    CostLoop*     loops;     int loop_count;     // in source order
+    CostHotspot*  hotspots;  int hotspot_count;  // costliest first
+} ShaderCostReport;
+
+// fsrc as LoadShaderSources returns it, files its source numbers (files[1] there). On
+// failure (no main, or nesting beyond the analyzer's limits) the log says why and *out
+// is empty.
+bool AnalyzeShaderCost(const char* fsrc, const ShaderFileTable* files, ShaderCostReport* out, char* log, int logsz);
+void FreeShaderCostReport(ShaderCostReport* r);
+
+double      ShaderCostWeight(CostCategory c);
+const char* ShaderCostCategoryName(CostCategory c);
+
+// "~640/px: alu 402, transcendental 31, texture 4, branch 110 (2 dynamic loops)"
+void FormatShaderCostSummary(const ShaderCostReport* r, char* out, size_t outsz);
+// The summary, then the top functions, loops, hotspots and the top_lines costliest lines.
+void PrintShaderCostReport(FILE* f, const ShaderCostReport* r, int top_lines);
+// What changed from prev to cur, one item per line ("" when nothing did). Items that
+// got SHADER_COST_WARN_RATIO costlier start with "warning: "; returns how many.
+int  DiffShaderCost(const ShaderCostReport* prev, const ShaderCostReport* cur, char* out, size_t outsz);
+
+#endif // SHADERDEVEL_SHADER_COST_H
@@ -0,0 +1,355 @@
+// shader_grid.c — see shader_grid.h
+#include "shader_grid.h"
+#include "shader.h"
+#include "shader_include.h"
+#include "uniforms.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================= Loading =============================
+typedef struct {
+    char names[SHADER_GRID_MAX_TILES + 1][64]; // one more than fits, to tell "too many"
+    int  count;
+} FragList;
+
+static bool EndsWith(const char* s, const char* suffix) {
+    size_t n = strlen(s), m = strlen(suffix);
+    return n > m && !strcmp(s + n - m, suffix);
+}
+
+static void CollectFrag(const DirEntry* e, void* user) {
+    FragList* list = (FragList*)user;
+    if (!EndsWith(e->name, ".frag") || strlen(e->name) >= sizeof(list->names[0])) return;
+    if (list->count <= SHADER_GRID_MAX_TILES) snprintf(list->names[list->count++], sizeof(list->names[0]), "%s", e->name);
+}
+
+static int CompareNames(const void* a, const void* b) {
+    return strcmp((const char*)a, (const char*)b);
+}
+
+static const char* FileName(const char* path) {
+    const char* name = path;
+    for (const char* s = path; *s; ++s) if (*s == '/' || *s == '\\') name = s + 1;
+    return name;
+}
+
+static bool AddTile(ShaderGrid* g, const char* path, char* log, int logsz) {
+    if (g->count == SHADER_GRID_MAX_TILES) {
+        snprintf(log, logsz, "more than %d shaders in the grid", SHADER_GRID_MAX_TILES);
+        return false;
+    }
+    GridTile* t = &g->tile[g->count++];
+    snprintf(t->frag_path, sizeof(t->frag_path), "%s", path);
+    snprintf(t->name, sizeof(t->name), "%s", FileName(path));
+    t->interval = 1;
+    return true;
+}
+
+ShaderGrid* ShaderGridLoad(const char* const* paths, int count, double budget_ms, char* log, int logsz) {
+    log[0] = 0;
+    ShaderGrid* g = (ShaderGrid*)calloc(1, sizeof(ShaderGrid));
+    FragList* list = (FragList*)malloc(sizeof(FragList));
+    if (!g || !list) {
+        free(g); free(list);
+        snprintf(log, logsz, "out of memory");
+        return NULL;
+    }
+    g->budget_ms = budget_ms;
+    bool ok = true;
+    for (int i = 0; ok && i < count; ++i) {
+        list->count = 0;
+        if (!ListDirectory(paths[i], CollectFrag, list)) {
+            uint64_t t;
+            if (!GetFileWriteTime(paths[i], &t)) { snprintf(log, logsz, "%s: no such shader or directory", paths[i]); ok = false; }
+            else ok = AddTile(g, paths[i], log, logsz);
+            continue;
+        }
+        qsort(list->names, (size_t)list->count, sizeof(list->names[0]), CompareNames);
+        for (int k = 0; ok && k < list->count; ++k) {
+            char path[APP_PATH_MAX];
+            size_t n = strlen(paths[i]);
+            bool sep = n && (paths[i][n - 1] == '/' || paths[i][n - 1] == '\\');
+            snprintf(path, sizeof(path), "%s%s%s", paths[i], sep ? "" : "/", list->names[k]);
+            ok = AddTile(g, path, log, logsz);
+        }
+    }
+    free(list);
+    if (ok && g->count == 0) { snprintf(log, logsz, "no .frag files in the grid"); ok = false; }
+    if (!ok) { free(g); return NULL; }
+    return g;
+}
+
+void ShaderGridDestroy(ShaderGrid* g) {
+    if (!g) return;
+    for (int i = 0; i < g->count; ++i) {
+        if (g->tile[i].program) glDeleteProgram(g->tile[i].program);
+        DestroyRenderTarget(&g->tile[i].target);
+    }
+    for (int s = 0; s < SHADER_GRID_QUERY_RING; ++s)
+        if (g->slot[s].query[0]) glDeleteQueries(SHADER_GRID_MAX_TILES + 1, g->slot[s].query);
+    free(g);
+}
+
+// ============================ Programs =============================
+static void InstallProgram(ShaderGrid* g, int idx, GLuint prog) {
+    GridTile* t = &g->tile[idx];
+    if (t->program) glDeleteProgram(t->program);
+    t->program = prog;
+    t->uTime       = glGetUniformLocation(prog, "uTime");
+    t->uResolution = glGetUniformLocation(prog, "uResolution");
+    t->uMouse      = glGetUniformLocation(prog, "uMouse");
+    t->uChannelResolution = glGetUniformLocation(prog, "iChannelResolution");
+    t->frame_inputs = SetupProgramUniforms(prog);
+    t->dirty = t->stale = true;
+    // A new program has a new cost: measure it before slowing it down.
+    t->gpu_ms = 0.0;
+    t->interval = 1;
+    t->since = g->frame;
+    t->draws = 0;
+    for (int s = 0; s < SHADER_GRID_QUERY_RING; ++s)
+        for (int k = 0; k < g->slot[s].draws; ++k)
+            if (g->slot[s].tile[k] == idx) g->slot[s].tile[k] = -1;
+}
+
+int ShaderGridBuildPrograms(ShaderGrid* g, const char* vert_path, char* log, int logsz) {
+    if (!g->slot[0].query[0])
+        for (int s = 0; s < SHADER_GRID_QUERY_RING; ++s) glGenQueries(SHADER_GRID_MAX_TILES + 1, g->slot[s].query);
+    log[0] = 0;
+    int built = 0, len = 0;
+    char tlog[COMPILE_LOG_SIZE];
+    for (int i = 0; i < g->count; ++i) {
+        GLuint prog = 0;
+        BuildInfo info = {0};
+        if (!LoadAndBuildProgramFromFiles(vert_path, g->tile[i].frag_path, &prog, &info, tlog, sizeof(tlog))) {
+            if (len < logsz)
+                len += snprintf(log + len, (size_t)(logsz - len), "%s: %s%s", g->tile[i].name,
+                                tlog[0] ? tlog : "could not build", EndsWith(tlog, "\n") ? "" : "\n");
+            continue;
+        }
+        InstallProgram(g, i, prog);
+        g->tile[i].source_hash = info.source_hash;
+        ++built;
+    }
+    return built;
+}
+
+int ShaderGridSubmitChanged(ShaderGrid* g, ShaderCompiler* c, const char* vert_path, const char* const* changed, int changed_count, bool all, double requested_at) {
+    IncludeCache* includes = GetIncludeCache();
+    all = all || ShaderDependsOnAny(includes, vert_path, changed, changed_count); // shared by every tile
+    int queued = 0;
+    for (int i = 0; i < g->count; ++i) {
+        GridTile* t = &g->tile[i];
+        if (!all && !ShaderDependsOnAny(includes, t->frag_path, changed, changed_count)) continue;
+        ShaderCompilerSubmitTagged(c, i, vert_path, t->frag_path, all ? 0 : t->source_hash, requested_at);
+        ++queued;
+    }
+    return queued;
+}
+
+void ShaderGridSwapProgram(ShaderGrid* g, int tag, GLuint prog, uint64_t source_hash) {
+    if (tag < 0 || tag >= g->count) { glDeleteProgram(prog); return; }
+    InstallProgram(g, tag, prog);
+    g->tile[tag].source_hash = source_hash;
+}
+
+void ShaderGridInvalidate(ShaderGrid* g) {
+    for (int i = 0; i < g->count; ++i) g->tile[i].dirty = g->tile[i].stale = true;
+}
+
+// ============================== Layout =============================
+// Cells keep the output's aspect: as many columns as rows, give or take one.
+static void Layout(ShaderGrid* g, int w, int h) {
+    if (w == g->width && h == g->height) return;
+    g->cols = (int)ceil(sqrt((double)g->count));
+    g->rows = (g->count + g->cols - 1) / g->cols;
+    g->cell_width  = w / g->cols;
+    g->cell_height = h / g->rows;
+    g->width = w; g->height = h;
+    int tw = g->cell_width - SHADER_GRID_GAP, th = g->cell_height - SHADER_GRID_GAP;
+    if (tw < 1) tw = 1;
+    if (th < 1) th = 1;
+    for (int i = 0; i < g->count; ++i) {
+        GridTile* t = &g->tile[i];
+        DestroyRenderTarget(&t->target);
+        if (!CreateRenderTarget(&t->target, tw, th, GL_RGBA8)) continue;
+        glBindFramebuffer(GL_FRAMEBUFFER, t->target.fbo);
+        glClearColor(0.f, 0.f, 0.f, 1.f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        t->dirty = t->stale = true;
+    }
+}
+
+void ShaderGridCellInputs(ShaderGrid* g, int w, int h, float mouse_x, float mouse_y, float out_resolution[2], float out_mouse[2]) {
+    Layout(g, w, h);
+    int tw = g->cell_width - SHADER_GRID_GAP, th = g->cell_height - SHADER_GRID_GAP;
+    out_resolution[0] = (float)(tw < 1 ? 1 : tw);
+    out_resolution[1] = (float)(th < 1 ? 1 : th);
+    int col = g->cell_width  > 0 ? (int)mouse_x / g->cell_width  : 0;
+    int row = g->cell_height > 0 ? (int)mouse_y / g->cell_height : 0;
+    if (col >= g->cols) col = g->cols - 1;
+    if (row >= g->rows) row = g->rows - 1;
+    if (col < 0) col = 0;
+    if (row < 0) row = 0;
+    out_mouse[0] = mouse_x - (float)(col * g->cell_width  + SHADER_GRID_GAP / 2);
+    out_mouse[1] = mouse_y - (float)(row * g->cell_height + SHADER_GRID_GAP / 2);
+}
+
+int ShaderGridTileAt(const ShaderGrid* g, int x, int y) {
+    if (x < 0 || y < 0 || g->cell_width <= 0 || g->cell_height <= 0) return -1;
+    int col = x / g->cell_width, row = y / g->cell_height;
+    if (col >= g->cols || row >= g->rows) return -1;
+    int i = row * g->cols + col;
+    return i < g->count ? i : -1;
+}
+
+// ============================ Scheduling ===========================
+static bool Animated(const GridTile* t) {
+    return t->program && (t->uTime >= 0 || t->uMouse >= 0 || t->frame_inputs);
+}
+
+// Timestamps of earlier frames, oldest first, as far as they are available.
+static void Harvest(ShaderGrid* g) {
+    for (int n = 0; n < SHADER_GRID_QUERY_RING; ++n) {
+        GridQuerySlot* s = &g->slot[(g->next_slot + n) % SHADER_GRID_QUERY_RING];
+        if (!s->pending) continue;
+        GLint ready = 0;
+        glGetQueryObjectiv(s->query[s->draws], GL_QUERY_RESULT_AVAILABLE, &ready);
+        if (!ready) break; // later ones finish later still
+        GLuint64 prev = 0, ts = 0;
+        glGetQueryObjectui64v(s->query[0], GL_QUERY_RESULT, &prev);
+        for (int k = 0; k < s->draws; ++k, prev = ts) {
+            glGetQueryObjectui64v(s->query[k + 1], GL_QUERY_RESULT, &ts);
+            if (s->tile[k] < 0) continue;
+            GridTile* t = &g->tile[s->tile[k]];
+            double ms = (double)(ts - prev) * 1e-6;
+            t->gpu_ms = t->gpu_ms > 0.0 ? t->gpu_ms * 0.75 + ms * 0.25 : ms;
+        }
+        s->pending = false;
+    }
+}
+
+// Halves the rate of the tile costing the most per frame until the total fits.
+static void Schedule(ShaderGrid* g) {
+    double total = 0.0;
+    for (int i = 0; i < g->count; ++i) {
+        g->tile[i].interval = 1;
+        if (Animated(&g->tile[i])) total += g->tile[i].gpu_ms;
+    }
+    while (g->budget_ms > 0.0 && total > g->budget_ms) {
+        int worst = -1;
+        double worst_ms = 0.0;
+        for (int i = 0; i < g->count; ++i) {
+            const GridTile* t = &g->tile[i];
+            double per_frame = t->gpu_ms / (double)t->interval;
+            if (Animated(t) && t->interval < SHADER_GRID_MAX_INTERVAL && per_frame > worst_ms) { worst = i; worst_ms = per_frame; }
+        }
+        if (worst < 0) break; // everything at the slowest rate
+        g->tile[worst].interval *= 2;
+        total -= worst_ms * 0.5;
+    }
+}
+
+// Draw order for this frame: dirty tiles, then the most overdue.
+static int Overdue(const ShaderGrid* g, const GridTile* t) {
+    if (t->dirty) return 1 << 30;
+    return (int)(g->frame - t->last_drawn) - t->interval;
+}
+
+static const ShaderGrid* s_sort_grid;
+static int CompareOverdue(const void* a, const void* b) {
+    int ia = *(const int*)a, ib = *(const int*)b;
+    int oa = Overdue(s_sort_grid, &s_sort_grid->tile[ia]), ob = Overdue(s_sort_grid, &s_sort_grid->tile[ib]);
+    if (oa != ob) return oa > ob ? -1 : 1;
+    return ia - ib;
+}
+
+// ============================ Rendering ============================
+void ShaderGridRender(ShaderGrid* g, float time, const float mouse[2], const float* channel_res, GLuint dst_fbo) {
+    bool time_changed  = time != g->last_time;
+    bool mouse_changed = mouse[0] != g->last_mouse_x || mouse[1] != g->last_mouse_y;
+    g->last_time = time; g->last_mouse_x = mouse[0]; g->last_mouse_y = mouse[1];
+    g->frame++;
+    Harvest(g);
+    Schedule(g);
+
+    int pick[SHADER_GRID_MAX_TILES], n = 0;
+    for (int i = 0; i < g->count; ++i) {
+        GridTile* t = &g->tile[i];
+        if (!t->program || !t->target.fbo) continue;
+        if (time_changed && (t->uTime >= 0 || t->frame_inputs)) t->stale = true;
+        if (mouse_changed && (t->uMouse >= 0 || t->frame_inputs)) t->stale = true;
+        if (t->dirty || (t->stale && g->frame - t->last_drawn >= (uint64_t)t->interval)) pick[n++] = i;
+    }
+    s_sort_grid = g;
+    qsort(pick, (size_t)n, sizeof(pick[0]), CompareOverdue);
+
+    GridQuerySlot* slot = &g->slot[g->next_slot];
+    bool timed = slot->query[0] && !slot->pending; // else the GPU is a full ring behind: untimed
+    if (timed) slot->draws = 0;
+    g->tiles_drawn = 0;
+    g->planned_ms = 0.0;
+    // A tile over the budget on its own can't be split: at most one per frame, on top
+    // of the others, so it doesn't crowd out the cheap ones.
+    double small_ms = 0.0;
+    bool big_drawn = false;
+    for (int k = 0; k < n; ++k) {
+        GridTile* t = &g->tile[pick[k]];
+        if (g->budget_ms > 0.0 && !t->dirty) {
+            if (t->gpu_ms > g->budget_ms) {
+                if (big_drawn) continue;
+                big_drawn = true;
+            } else {
+                if (small_ms + t->gpu_ms > g->budget_ms) continue;
+                small_ms += t->gpu_ms;
+            }
+        }
+        if (timed && slot->draws == 0) glQueryCounter(slot->query[0], GL_TIMESTAMP);
+        glBindFramebuffer(GL_FRAMEBUFFER, t->target.fbo);
+        glViewport(0, 0, t->target.width, t->target.height);
+        glUseProgram(t->program);
+        if (t->uTime >= 0)       glUniform1f(t->uTime, time);
+        if (t->uResolution >= 0) glUniform2f(t->uResolution, (float)t->target.width, (float)t->target.height);
+        if (t->uMouse >= 0)      glUniform2f(t->uMouse, mouse[0], mouse[1]);
+        if (t->uChannelResolution >= 0 && channel_res) glUniform3fv(t->uChannelResolution, 4, channel_res);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        if (timed) {
+            slot->tile[slot->draws++] = pick[k];
+            glQueryCounter(slot->query[slot->draws], GL_TIMESTAMP);
+        }
+        t->dirty = t->stale = false;
+        t->last_drawn = g->frame;
+        t->draws++;
+        g->tiles_drawn++;
+        g->planned_ms += t->gpu_ms;
+    }
+    if (timed && slot->draws > 0) {
+        slot->pending = true;
+        g->next_slot = (g->next_slot + 1) % SHADER_GRID_QUERY_RING;
+    }
+
+    // Compose: every tile's latest image in its cell, row 0 at the top.
+    glBindFramebuffer(GL_FRAMEBUFFER, dst_fbo);
+    glViewport(0, 0, g->width, g->height);
+    glClearColor(0.08f, 0.08f, 0.08f, 1.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst_fbo);
+    for (int i = 0; i < g->count; ++i) {
+        const GridTile* t = &g->tile[i];
+        if (!t->target.fbo) continue;
+        int x = (i % g->cols) * g->cell_width + SHADER_GRID_GAP / 2;
+        int y = g->height - (i / g->cols + 1) * g->cell_height + SHADER_GRID_GAP / 2;
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, t->target.fbo);
+        glBlitFramebuffer(0, 0, t->target.width, t->target.height, x, y, x + t->target.width, y + t->target.height,
+                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, dst_fbo);
+}
+
+bool ShaderGridPending(const ShaderGrid* g) {
+    for (int i = 0; i < g->count; ++i)
+        if (g->tile[i].program && g->tile[i].stale) return true;
+    return false;
+}
@@ -0,0 +1,106 @@
+// shader_grid.h — many fragment shaders side by side in one context
+//
+// Reviewing candidates one process (and one context) at a time doesn't scale, so a
+// grid lays them out in cells of one output: the shaders of a directory (every .frag
+// in it, by name) and/or files given one by one. Each tile has its own program,
+// loose uniform locations and a target holding its last image; they share the
+// context, the quad VAO, the watcher and the FrameInputs block, where uResolution is
+// the cell size and uMouse is relative to the cell under the cursor, so each shader
+// runs as if it had the whole window. Each tile is its own compile tag, so saving one
+// shader rebuilds one program; a tile that doesn't build stays black until it does.
+//
+// A budget of GPU time per frame keeps the grid interactive. Each tile's draw is
+// bracketed with timestamp queries, read back a few frames later without stalling.
+// The scheduler halves the update rate of whichever tile costs the most per frame
+// (its GPU time over its interval) until the estimated total fits, so cheap tiles
+// keep the full rate and expensive ones update every 2nd, 4th, ... frame. Within a
+// frame, tiles that are due draw most overdue first until the budget is spent, which
+// spreads tiles with the same interval over frames; a tile costing more than the
+// whole budget can't be split, so one of those may draw per frame on top. Tiles not
+// drawn show their previous image. A tile whose inputs didn't change (time
+// paused, or the shader reads neither time nor mouse) isn't drawn at all.
+
+#ifndef SHADERDEVEL_SHADER_GRID_H
+#define SHADERDEVEL_SHADER_GRID_H
+
+#include "platform.h"
+#include "compiler.h"
+#include "render_target.h"
+#include <glad/gl.h>
+
+#define SHADER_GRID_MAX_TILES     COMPILER_MAX_TAGS
+#define SHADER_GRID_MAX_INTERVAL  64 // slowest rate: every 64th frame
+#define SHADER_GRID_QUERY_RING    4
+#define SHADER_GRID_GAP           2  // pixels between cells
+#define SHADER_GRID_DEFAULT_BUDGET_MS 12.0
+
+typedef struct {
+    char         name[64];   // file name
+    char         frag_path[APP_PATH_MAX];
+    GLuint       program;    // 0 until it builds
+    uint64_t     source_hash;
+    GLint        uTime, uResolution, uMouse, uChannelResolution;
+    bool         frame_inputs; // reads the FrameInputs block
+    RenderTarget target;
+    bool         dirty;      // program, size or parameters changed: draw as soon as possible
+    bool         stale;      // its inputs changed since it last drew: draw when due
+    double       gpu_ms;     // smoothed GPU time of one draw, 0 = not measured yet
+    int          interval;   // draws every interval-th frame at most
+    uint64_t     last_drawn; // grid frame
+    uint64_t     since;      // grid frame its program was installed
+    int          draws;      // since then
+} GridTile;
+
+typedef struct {
+    GLuint   query[SHADER_GRID_MAX_TILES + 1]; // timestamps before and after each draw
+    int      tile[SHADER_GRID_MAX_TILES];      // tile of each draw, -1 if it was swapped since
+    int      draws;
+    bool     pending;
+} GridQuerySlot;
+
+typedef struct {
+    GridTile      tile[SHADER_GRID_MAX_TILES];
+    int           count;
+    int           cols, rows;
+    int           width, height;       // output size the cells were laid out for
+    int           cell_width, cell_height;
+    double        budget_ms;           // GPU time per frame for all tiles, <= 0 = draw every tile every frame
+    uint64_t      frame;
+    float         last_time, last_mouse_x, last_mouse_y;
+    GridQuerySlot slot[SHADER_GRID_QUERY_RING];
+    int           next_slot;
+    // last frame, for stats
+    int           tiles_drawn;
+    double        planned_ms;          // estimated GPU time of the draws
+} ShaderGrid;
+
+// paths: directories (their .frag files, sorted by name) and single fragment shaders.
+// No GL. NULL with a log on error (nothing found, too many tiles, an unreadable directory).
+ShaderGrid* ShaderGridLoad(const char* const* paths, int count, double budget_ms, char* log, int logsz);
+void        ShaderGridDestroy(ShaderGrid* g);
+
+// Blocking build of every tile (startup). Tiles that fail stay black; their logs are
+// appended to log, one "name: error" block each. Returns how many built.
+int  ShaderGridBuildPrograms(ShaderGrid* g, const char* vert_path, char* log, int logsz);
+// As RenderGraphSubmitChanged, with tag = tile index.
+int  ShaderGridSubmitChanged(ShaderGrid* g, ShaderCompiler* c, const char* vert_path, const char* const* changed, int changed_count, bool all, double requested_at);
+// Installs a finished program for the tile the tag names; deletes it if stale.
+void ShaderGridSwapProgram(ShaderGrid* g, int tag, GLuint prog, uint64_t source_hash);
+// Every tile draws on the next frame (new parameters or images).
+void ShaderGridInvalidate(ShaderGrid* g);
+
+// Lays the cells out for w x h and returns the tile inputs derived from the output's:
+// uResolution the cell size, uMouse relative to the cell under the cursor.
+void ShaderGridCellInputs(ShaderGrid* g, int w, int h, float mouse_x, float mouse_y, float out_resolution[2], float out_mouse[2]);
+// Draws the tiles this frame's schedule picks (FrameInputs already uploaded with
+// ShaderGridCellInputs' values; time and the cell mouse are for the loose uniforms
+// and for telling what changed), then composes every tile into dst_fbo. Uses the
+// quad VAO and the channel textures bound by the caller; channel_res (4 x vec3, may
+// be NULL) goes to iChannelResolution.
+void ShaderGridRender(ShaderGrid* g, float time, const float mouse[2], const float* channel_res, GLuint dst_fbo);
+// True while some tile that should show a change hasn't drawn it yet.
+bool ShaderGridPending(const ShaderGrid* g);
+// The tile under output pixel (x, y down), -1 if none.
+int  ShaderGridTileAt(const ShaderGrid* g, int x, int y);
+
+#endif // SHADERDEVEL_SHADER_GRID_H
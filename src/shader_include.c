@@ -0,0 +1,398 @@
+// shader_include.c — see shader_include.h
+#include "shader_include.h"
+#include "hash.h"
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INCLUDE_CACHE_MAX 128
+#define DEPENDENCY_MAX    256
+
+typedef struct {
+    int   line; // 0-based line of the #include
+    char* path; // resolved and normalized
+} IncludeRef;
+
+typedef struct {
+    char        path[APP_PATH_MAX];
+    uint64_t    write_time;
+    uint64_t    content_hash; // of the file as read
+    char*       text;         // NUL-separated lines
+    int*        line_start;
+    int         line_count;
+    IncludeRef* refs;         // in line order
+    int         ref_count;
+    int         version_line; // -1 if none
+    int         once_line;    // -1 if no #pragma once
+    uint64_t    last_used;    // IncludeCache.generation
+} SourceFile;
+
+typedef struct {
+    const char* path[DEPENDENCY_MAX];
+    int         count;
+} Visited;
+
+struct IncludeCache {
+    Mutex       lock;
+    SourceFile* files[INCLUDE_CACHE_MAX];
+    int         count;
+    uint64_t    generation;   // one per PreprocessShaderFile call
+    Visited     walk;         // ForEachShaderDependency scratch
+};
+
+static bool PathsEqual(const char* a, const char* b) {
+#ifdef _WIN32
+    return _stricmp(a, b) == 0;
+#else
+    return strcmp(a, b) == 0;
+#endif
+}
+
+void NormalizeShaderPath(const char* in, char* out, size_t outsz) {
+    const char* seg[128];
+    int len[128], n = 0;
+    bool absolute = in[0] == '/' || in[0] == '\\';
+    for (const char* p = in; *p; ) {
+        while (*p == '/' || *p == '\\') ++p;
+        if (!*p) break;
+        const char* s = p;
+        while (*p && *p != '/' && *p != '\\') ++p;
+        int l = (int)(p - s);
+        if (l == 1 && s[0] == '.') continue;
+        if (l == 2 && s[0] == '.' && s[1] == '.' && n > 0 && !(len[n - 1] == 2 && !strncmp(seg[n - 1], "..", 2))) { --n; continue; }
+        if (n < 128) { seg[n] = s; len[n] = l; ++n; }
+    }
+    size_t o = 0;
+    if (absolute && o + 1 < outsz) out[o++] = '/';
+    for (int i = 0; i < n; ++i) {
+        if (i > 0 && o + 1 < outsz) out[o++] = '/';
+        for (int k = 0; k < len[i] && o + 1 < outsz; ++k) out[o++] = seg[i][k];
+    }
+    if (o == 0 && o + 1 < outsz) out[o++] = '.';
+    out[o] = 0;
+}
+
+static void ResolveInclude(const char* from, const char* name, char* out, size_t outsz) {
+    bool absolute = name[0] == '/' || name[0] == '\\' || (name[0] && name[1] == ':');
+    char joined[APP_PATH_MAX * 2];
+    if (absolute) {
+        snprintf(joined, sizeof(joined), "%s", name);
+    } else {
+        const char* slash = NULL;
+        for (const char* p = from; *p; ++p) if (*p == '/' || *p == '\\') slash = p;
+        snprintf(joined, sizeof(joined), "%.*s%s", slash ? (int)(slash - from + 1) : 0, from, name);
+    }
+    NormalizeShaderPath(joined, out, outsz);
+}
+
+// ============================ Parsing ==============================
+static void FreeSourceFile(SourceFile* f) {
+    if (!f) return;
+    for (int i = 0; i < f->ref_count; ++i) free(f->refs[i].path);
+    free(f->refs);
+    free(f->line_start);
+    free(f->text);
+    free(f);
+}
+
+// "#  word" at the start of a line: returns what follows word, else NULL.
+static const char* MatchDirective(const char* line, const char* word) {
+    while (*line == ' ' || *line == '\t') ++line;
+    if (*line != '#') return NULL;
+    ++line;
+    while (*line == ' ' || *line == '\t') ++line;
+    size_t n = strlen(word);
+    if (strncmp(line, word, n)) return NULL;
+    if (line[n] && !isspace((unsigned char)line[n]) && line[n] != '"' && line[n] != '<') return NULL;
+    return line + n;
+}
+
+static SourceFile* ParseSourceFile(const char* path, char* text, size_t size, char* log, int logsz) {
+    SourceFile* f = (SourceFile*)calloc(1, sizeof(SourceFile));
+    snprintf(f->path, sizeof(f->path), "%s", path);
+    f->text = text;
+    f->version_line = f->once_line = -1;
+    int lines = 1;
+    for (size_t i = 0; i < size; ++i) if (text[i] == '\n') ++lines;
+    f->line_start = (int*)malloc((size_t)lines * sizeof(int));
+    f->refs = (IncludeRef*)calloc((size_t)lines, sizeof(IncludeRef));
+
+    bool in_comment = false;
+    for (size_t i = 0, start = 0; i <= size; ++i) {
+        if (i < size && text[i] != '\n') continue;
+        text[i] = 0;
+        if (i > start && text[i - 1] == '\r') text[i - 1] = 0;
+        char* line = text + start;
+        int lineno = f->line_count;
+        f->line_start[f->line_count++] = (int)start;
+        start = i + 1;
+
+        const char* rest;
+        if (!in_comment && (rest = MatchDirective(line, "include")) != NULL) {
+            while (*rest == ' ' || *rest == '\t') ++rest;
+            char close = *rest == '"' ? '"' : *rest == '<' ? '>' : 0;
+            const char* end = close ? strchr(rest + 1, close) : NULL;
+            if (!end || end == rest + 1 || end - rest - 1 >= APP_PATH_MAX) {
+                snprintf(log, logsz, "%s:%d: expected #include \"file\"", path, lineno + 1);
+                FreeSourceFile(f);
+                return NULL;
+            }
+            char name[APP_PATH_MAX], resolved[APP_PATH_MAX];
+            snprintf(name, sizeof(name), "%.*s", (int)(end - rest - 1), rest + 1);
+            ResolveInclude(path, name, resolved, sizeof(resolved));
+            f->refs[f->ref_count].line = lineno;
+            size_t n = strlen(resolved) + 1;
+            f->refs[f->ref_count].path = (char*)malloc(n);
+            memcpy(f->refs[f->ref_count].path, resolved, n);
+            f->ref_count++;
+            continue;
+        }
+        if (!in_comment && f->version_line < 0 && MatchDirective(line, "version")) f->version_line = lineno;
+        if (!in_comment && (rest = MatchDirective(line, "pragma")) != NULL) {
+            while (*rest == ' ' || *rest == '\t') ++rest;
+            if (!strncmp(rest, "once", 4) && (!rest[4] || isspace((unsigned char)rest[4]))) f->once_line = lineno;
+        }
+        for (const char* p = line; *p; ++p) {
+            if (in_comment) { if (p[0] == '*' && p[1] == '/') { in_comment = false; ++p; } }
+            else if (p[0] == '/' && p[1] == '/') break;
+            else if (p[0] == '/' && p[1] == '*') { in_comment = true; ++p; }
+        }
+    }
+    return f;
+}
+
+static SourceFile* FindFile(IncludeCache* c, const char* path) {
+    for (int i = 0; i < c->count; ++i) if (PathsEqual(c->files[i]->path, path)) return c->files[i];
+    return NULL;
+}
+
+// Current parse of path: the cached one if the file hasn't been written since, or was
+// rewritten with the same bytes (touch, checkout, save without edits). Caller holds
+// c->lock. NULL if unreadable or malformed (log says why).
+static SourceFile* LookupFile(IncludeCache* c, const char* path, char* log, int logsz) {
+    SourceFile* f = FindFile(c, path);
+    uint64_t wt = 0;
+    if (!GetFileWriteTime(path, &wt)) return NULL;
+    if (f && f->write_time == wt) { f->last_used = c->generation; return f; }
+
+    // Hash straight from the mapping; only new content is copied and parsed.
+    MappedFile m;
+    if (!MapShaderFile(path, &m)) return NULL;
+    uint64_t hash = Hash64(m.data, m.size, 0);
+    if (f && f->content_hash == hash) {
+        UnmapFile(&m);
+        f->write_time = wt;
+        f->last_used = c->generation;
+        return f;
+    }
+    size_t size = m.size;
+    char* text = (char*)malloc(size + 1);
+    memcpy(text, m.data, size);
+    text[size] = 0;
+    UnmapFile(&m);
+    SourceFile* parsed = ParseSourceFile(path, text, size, log, logsz);
+    if (!parsed) return NULL;
+    parsed->write_time = wt;
+    parsed->content_hash = hash;
+    parsed->last_used = c->generation;
+
+    int slot = -1;
+    for (int i = 0; i < c->count && slot < 0; ++i) if (c->files[i] == f) slot = i;
+    if (slot < 0 && c->count < INCLUDE_CACHE_MAX) slot = c->count++;
+    if (slot < 0) {
+        // Full: drop the least recently used file not part of this expansion.
+        for (int i = 0; i < c->count; ++i)
+            if (c->files[i]->last_used != c->generation && (slot < 0 || c->files[i]->last_used < c->files[slot]->last_used)) slot = i;
+        if (slot < 0) { snprintf(log, logsz, "more than %d shader files in use", INCLUDE_CACHE_MAX); FreeSourceFile(parsed); return NULL; }
+        f = c->files[slot];
+    }
+    FreeSourceFile(f);
+    c->files[slot] = parsed;
+    return parsed;
+}
+
+// ============================ Expansion ============================
+typedef struct {
+    IncludeCache*    cache;
+    ShaderFileTable* files;
+    char*            out;
+    size_t           len, cap;
+    const char*      stack[SHADER_INCLUDE_DEPTH];
+    int              depth;
+    bool             expanded[SHADER_MAX_FILES];
+    char*            log;
+    int              logsz;
+} Expansion;
+
+static void Emit(Expansion* x, const char* s, size_t n) {
+    if (x->len + n + 1 > x->cap) {
+        while (x->len + n + 1 > x->cap) x->cap = x->cap ? x->cap * 2 : 4096;
+        x->out = (char*)realloc(x->out, x->cap);
+    }
+    memcpy(x->out + x->len, s, n);
+    x->len += n;
+    x->out[x->len] = 0;
+}
+
+static void EmitLine(Expansion* x, int line, int source) {
+    char buf[48];
+    int n = snprintf(buf, sizeof(buf), "#line %d %d\n", line, source);
+    Emit(x, buf, (size_t)n);
+}
+
+static int FileNumber(ShaderFileTable* t, const char* path) {
+    for (int i = 0; i < t->count; ++i) if (PathsEqual(t->path[i], path)) return i;
+    if (t->count == SHADER_MAX_FILES) return -1;
+    snprintf(t->path[t->count], APP_PATH_MAX, "%s", path);
+    return t->count++;
+}
+
+static bool Expand(Expansion* x, const char* path, const char* from, int from_line) {
+    for (int i = 0; i < x->depth; ++i) {
+        if (!PathsEqual(x->stack[i], path)) continue;
+        snprintf(x->log, x->logsz, "%s:%d: include cycle back to %s", from, from_line, path);
+        return false;
+    }
+    if (x->depth == SHADER_INCLUDE_DEPTH) { snprintf(x->log, x->logsz, "%s:%d: includes nested too deeply", from, from_line); return false; }
+    x->log[0] = 0;
+    SourceFile* f = LookupFile(x->cache, path, x->log, x->logsz);
+    if (!f) {
+        if (x->log[0]) return false;
+        if (from) snprintf(x->log, x->logsz, "%s:%d: cannot open include %s", from, from_line, path);
+        else      snprintf(x->log, x->logsz, "Failed to read %s.", path);
+        return false;
+    }
+    int src = FileNumber(x->files, f->path);
+    if (src < 0) { snprintf(x->log, x->logsz, "%s:%d: more than %d files in one program", from, from_line, SHADER_MAX_FILES); return false; }
+    if (f->once_line >= 0 && x->expanded[src]) return true;
+    x->expanded[src] = true;
+
+    bool root = x->depth == 0;
+    x->stack[x->depth++] = f->path;
+    // Nothing may precede #version, so the root's numbering starts right after it.
+    if (!root || f->version_line < 0) EmitLine(x, 1, src);
+    int r = 0;
+    for (int i = 0; i < f->line_count; ++i) {
+        const char* line = f->text + f->line_start[i];
+        if (r < f->ref_count && f->refs[r].line == i) {
+            if (!Expand(x, f->refs[r++].path, f->path, i + 1)) return false;
+            EmitLine(x, i + 2, src);
+        } else if (i == f->version_line) {
+            if (root) { Emit(x, line, strlen(line)); Emit(x, "\n", 1); EmitLine(x, i + 2, src); }
+            else Emit(x, "\n", 1); // the root's #version applies to the whole stage
+        } else if (i == f->once_line) {
+            Emit(x, "\n", 1);
+        } else {
+            Emit(x, line, strlen(line));
+            Emit(x, "\n", 1);
+        }
+    }
+    x->depth--;
+    return true;
+}
+
+// ============================ Public API ===========================
+IncludeCache* IncludeCacheCreate(void) {
+    IncludeCache* c = (IncludeCache*)calloc(1, sizeof(IncludeCache));
+    MutexInit(&c->lock);
+    return c;
+}
+
+void IncludeCacheDestroy(IncludeCache* c) {
+    if (!c) return;
+    for (int i = 0; i < c->count; ++i) FreeSourceFile(c->files[i]);
+    MutexDestroy(&c->lock);
+    free(c);
+}
+
+bool PreprocessShaderFile(IncludeCache* c, const char* path, ShaderFileTable* files, char** out_src, char* log, int logsz) {
+    *out_src = NULL;
+    log[0] = 0;
+    char root[APP_PATH_MAX];
+    NormalizeShaderPath(path, root, sizeof(root));
+
+    Expansion x;
+    memset(&x, 0, sizeof(x));
+    x.cache = c;
+    x.files = files;
+    files->count = 0;
+    x.log = log;
+    x.logsz = logsz;
+    MutexLock(&c->lock);
+    c->generation++;
+    bool ok = Expand(&x, root, NULL, 0);
+    MutexUnlock(&c->lock);
+    if (!ok) { free(x.out); return false; }
+    *out_src = x.out;
+    return true;
+}
+
+void MapShaderLog(const ShaderFileTable* files, char* log, int logsz) {
+    if (!log[0] || logsz <= 1) return;
+    char* out = (char*)malloc((size_t)logsz);
+    int o = 0;
+    for (const char* p = log; *p && o < logsz - 1; ) {
+        // Optional "ERROR: " / "WARNING: " style prefix (AMD, Intel).
+        const char* q = p;
+        while (isupper((unsigned char)*q)) ++q;
+        if (q > p && q[0] == ':' && q[1] == ' ') q += 2; else q = p;
+        while (p < q && o < logsz - 1) out[o++] = *p++;
+
+        const char* d = p;
+        int n = 0;
+        while (isdigit((unsigned char)*d) && n < 1000000) n = n * 10 + (*d++ - '0');
+        if (d > p && (*d == ':' || *d == '(') && isdigit((unsigned char)d[1]) && n < files->count) {
+            o += snprintf(out + o, (size_t)(logsz - o), "%s", files->path[n]);
+            if (o > logsz - 1) o = logsz - 1;
+            p = d;
+        }
+        while (*p && o < logsz - 1) {
+            char ch = *p++;
+            out[o++] = ch;
+            if (ch == '\n') break;
+        }
+    }
+    out[o] = 0;
+    memcpy(log, out, (size_t)o + 1);
+    free(out);
+}
+
+static void Walk(IncludeCache* c, const char* path, Visited* v, void (*fn)(const char* path, void* user), void* user) {
+    for (int i = 0; i < v->count; ++i) if (PathsEqual(v->path[i], path)) return;
+    if (v->count == DEPENDENCY_MAX) return;
+    v->path[v->count++] = path;
+    fn(path, user);
+    const SourceFile* f = FindFile(c, path);
+    if (!f) return;
+    for (int i = 0; i < f->ref_count; ++i) Walk(c, f->refs[i].path, v, fn, user);
+}
+
+void ForEachShaderDependency(IncludeCache* c, const char* root, void (*fn)(const char* path, void* user), void* user) {
+    char norm[APP_PATH_MAX];
+    NormalizeShaderPath(root, norm, sizeof(norm));
+    if (!c) { fn(norm, user); return; }
+    MutexLock(&c->lock);
+    c->walk.count = 0;
+    Walk(c, norm, &c->walk, fn, user);
+    MutexUnlock(&c->lock);
+}
+
+typedef struct {
+    const char* const* paths;
+    int                count;
+    bool               hit;
+} DependsQuery;
+
+static void CheckDependency(const char* path, void* user) {
+    DependsQuery* q = (DependsQuery*)user;
+    for (int i = 0; i < q->count && !q->hit; ++i) q->hit = PathsEqual(q->paths[i], path);
+}
+
+bool ShaderDependsOnAny(IncludeCache* c, const char* root, const char* const* paths, int count) {
+    DependsQuery q = { paths, count, false };
+    ForEachShaderDependency(c, root, CheckDependency, &q);
+    return q.hit;
+}
@@ -0,0 +1,54 @@
+// shader_include.h — #include for GLSL, with an in-memory file cache and dependency graph
+//
+//   #include "noise.glsl"      // relative to the including file
+//   #pragma once               // in a header: expand it at most once per stage
+//
+// Parsed files stay in memory and are re-read only when their write time changes, so
+// rebuilding after an edit reads just the edited file (memory-mapped, and re-parsed
+// only if its content hash differs). Expansion emits "#line <n> <source>" around
+// every include; each file of a stage gets its own source number (ShaderFileTable),
+// the stage's root file 0, and MapShaderLog turns the driver's "1:12(5):" back into
+// "noise.glsl:12(5):". Stages are numbered separately because a compile log only
+// refers to its own stage, and drivers that drop the number (Mesa does for some
+// errors) then still name that stage's root rather than another stage's. The include
+// edges recorded while parsing form the dependency graph the front ends use to rebuild
+// only the programs a saved header reaches. Includes inside /* */ comments are ignored; #if around them is not seen.
+
+#ifndef SHADERDEVEL_SHADER_INCLUDE_H
+#define SHADERDEVEL_SHADER_INCLUDE_H
+
+#include "platform.h"
+
+#define SHADER_MAX_FILES     32 // distinct files per stage
+#define SHADER_INCLUDE_DEPTH 16
+
+// Source numbers of one stage's files: path[n] is what "#line x n" refers to, 0 the root.
+typedef struct {
+    int  count;
+    char path[SHADER_MAX_FILES][APP_PATH_MAX];
+} ShaderFileTable;
+
+typedef struct IncludeCache IncludeCache;
+
+IncludeCache* IncludeCacheCreate(void);
+void          IncludeCacheDestroy(IncludeCache* c);
+
+// Expands path's includes into a malloc'd, NUL-terminated *out_src and numbers its
+// files into files (path itself 0). Thread safe. On failure the log says which file and line.
+bool PreprocessShaderFile(IncludeCache* c, const char* path, ShaderFileTable* files, char** out_src, char* log, int logsz);
+
+// Rewrites "<n>:<line>" and "<n>(<line>)" file references in a driver info log in place;
+// files is the table of the stage the log is from.
+void MapShaderLog(const ShaderFileTable* files, char* log, int logsz);
+
+// Calls fn for root and every file it includes, transitively, as of the last parse
+// (a missing include is reported too, so creating it can be noticed). fn runs under
+// the cache lock and must not call back into it. With c NULL only root is reported.
+void ForEachShaderDependency(IncludeCache* c, const char* root, void (*fn)(const char* path, void* user), void* user);
+// True if root or anything it includes is one of the paths.
+bool ShaderDependsOnAny(IncludeCache* c, const char* root, const char* const* paths, int count);
+
+// The normalized form used for every path above ("a/./b/../c" -> "a/c", '/' separators).
+void NormalizeShaderPath(const char* in, char* out, size_t outsz);
+
+#endif // SHADERDEVEL_SHADER_INCLUDE_H
@@ -0,0 +1,99 @@
+// stage_cache.c — see stage_cache.h
+#include "stage_cache.h"
+#include "hash.h"
+
+#include <stdlib.h>
+
+typedef struct {
+    GLenum   type;
+    uint64_t hash;
+    GLuint   shader;
+    uint64_t last_used;
+    int      pins;      // builds between Find/Insert and Release: never evicted
+} StageEntry;
+
+struct StageCache {
+    Mutex           lock;
+    StageEntry*     entries;
+    int             count, capacity;
+    uint64_t        clock;
+    StageCacheStats stats;
+};
+
+StageCache* StageCacheCreate(int capacity) {
+    StageCache* c = (StageCache*)calloc(1, sizeof(StageCache));
+    if (!c) return NULL;
+    c->capacity = capacity > 1 ? capacity : STAGE_CACHE_DEFAULT_CAPACITY; // a program's two stages must fit
+    c->entries = (StageEntry*)calloc((size_t)c->capacity, sizeof(StageEntry));
+    if (!c->entries) { free(c); return NULL; }
+    MutexInit(&c->lock);
+    return c;
+}
+
+void StageCacheDestroy(StageCache* c) {
+    if (!c) return;
+    for (int i = 0; i < c->count; ++i) glDeleteShader(c->entries[i].shader);
+    MutexDestroy(&c->lock);
+    free(c->entries);
+    free(c);
+}
+
+uint64_t StageSourceHash(GLenum type, const char* src) {
+    return Hash64String(src, (uint64_t)type);
+}
+
+GLuint StageCacheFind(StageCache* c, GLenum type, uint64_t hash) {
+    GLuint found = 0;
+    MutexLock(&c->lock);
+    for (int i = 0; i < c->count && !found; ++i) {
+        StageEntry* e = &c->entries[i];
+        if (e->type != type || e->hash != hash) continue;
+        e->last_used = ++c->clock;
+        e->pins++;
+        found = e->shader;
+    }
+    if (found) c->stats.hits++; else c->stats.misses++;
+    MutexUnlock(&c->lock);
+    return found;
+}
+
+void StageCacheInsert(StageCache* c, GLenum type, uint64_t hash, GLuint shader) {
+    MutexLock(&c->lock);
+    for (int i = 0; i < c->count; ++i)
+        if (c->entries[i].type == type && c->entries[i].hash == hash) { MutexUnlock(&c->lock); return; } // raced with another build
+    int slot = c->count < c->capacity ? c->count++ : -1;
+    if (slot < 0) {
+        for (int i = 0; i < c->count; ++i)
+            if (!c->entries[i].pins && (slot < 0 || c->entries[i].last_used < c->entries[slot].last_used)) slot = i;
+        if (slot < 0) { MutexUnlock(&c->lock); return; } // every entry in use: Release deletes this one
+        glDeleteShader(c->entries[slot].shader); // linked programs don't need it
+        c->stats.evictions++;
+    }
+    StageEntry* e = &c->entries[slot];
+    e->type = type;
+    e->hash = hash;
+    e->shader = shader;
+    e->last_used = ++c->clock;
+    e->pins = 1;
+    MutexUnlock(&c->lock);
+}
+
+void StageCacheRelease(StageCache* c, GLuint shader) {
+    bool kept = false;
+    MutexLock(&c->lock);
+    for (int i = 0; i < c->count && !kept; ++i) {
+        StageEntry* e = &c->entries[i];
+        if (e->shader != shader) continue;
+        if (e->pins > 0) e->pins--;
+        kept = true;
+    }
+    MutexUnlock(&c->lock);
+    if (!kept) glDeleteShader(shader); // Insert didn't keep it
+}
+
+void StageCacheGetStats(StageCache* c, StageCacheStats* out) {
+    MutexLock(&c->lock);
+    *out = c->stats;
+    out->entries = c->count;
+    MutexUnlock(&c->lock);
+}
@@ -0,0 +1,45 @@
+// stage_cache.h — compiled shader objects kept in memory by a hash of their source
+//
+// A program is two stages; after an edit usually only one of them changed. Keeping
+// each successfully compiled stage keyed by (type, XXH64 of the expanded source)
+// lets a rebuild compile just the changed stage and relink it against the cached
+// other one. Shader objects are shared between the render and worker contexts, so
+// either may look them up. Least recently used objects are deleted past capacity.
+//
+// Builds run on the worker thread (the compiler) and the render thread (grid, graph
+// and variant builds) at once. A name is only safe on the thread that got it, while
+// it holds that name's pin: Find and Insert take one and Release drops it. Release
+// right after glAttachShader; an attached object survives its deletion until detached.
+
+#ifndef SHADERDEVEL_STAGE_CACHE_H
+#define SHADERDEVEL_STAGE_CACHE_H
+
+#include "platform.h"
+#include <glad/gl.h>
+
+#define STAGE_CACHE_DEFAULT_CAPACITY 64
+
+typedef struct StageCache StageCache;
+
+typedef struct {
+    uint32_t hits, misses, evictions;
+    int      entries;
+} StageCacheStats;
+
+// NULL when out of memory; SetStageCache(NULL) then builds every stage from source.
+StageCache* StageCacheCreate(int capacity);
+// Needs a context sharing the objects current (deletes them).
+void        StageCacheDestroy(StageCache* c);
+
+uint64_t StageSourceHash(GLenum type, const char* src);
+// Thread-safe. A compiled shader object, still owned by the cache and pinned, or 0.
+GLuint   StageCacheFind(StageCache* c, GLenum type, uint64_t hash);
+// Takes ownership of a successfully compiled shader, pinned as by Find. When it is
+// already cached (another build raced this one) or every entry is pinned, the cache
+// doesn't keep it, and Release deletes it.
+void     StageCacheInsert(StageCache* c, GLenum type, uint64_t hash, GLuint shader);
+// Drops the pin Find or Insert took on shader.
+void     StageCacheRelease(StageCache* c, GLuint shader);
+void     StageCacheGetStats(StageCache* c, StageCacheStats* out);
+
+#endif // SHADERDEVEL_STAGE_CACHE_H
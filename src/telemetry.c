@@ -0,0 +1,653 @@
+// telemetry.c — see telemetry.h
+#include "telemetry.h"
+
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET   Socket;
+typedef WSAPOLLFD PollFd;
+#define BAD_SOCKET  INVALID_SOCKET
+#define CloseSocket closesocket
+#define PollSockets WSAPoll
+#else
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+typedef int           Socket;
+typedef struct pollfd PollFd;
+#define BAD_SOCKET  (-1)
+#define CloseSocket close
+#define PollSockets poll
+#endif
+
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL // a client hanging up must not SIGPIPE the process
+#else
+#define SEND_FLAGS 0
+#endif
+
+#define TELEMETRY_EVENT_RING  16
+#define TELEMETRY_EVENT_TEXT  4096
+#define TELEMETRY_MAX_STREAMS 8
+#define TELEMETRY_POLL_MS     100
+#define HIST_MAX_BOUNDS       12
+
+// Upper bounds in ms; one more bucket above the last.
+static const double kFrameBounds[]  = { 1, 2, 4, 8, 12, 16.7, 20, 33.3, 50, 100, 250, 1000 };
+static const double kReloadBounds[] = { 10, 25, 50, 100, 250, 500, 1000, 2500, 5000 };
+#define FRAME_BOUNDS  ((int)(sizeof(kFrameBounds) / sizeof(kFrameBounds[0])))
+#define RELOAD_BOUNDS ((int)(sizeof(kReloadBounds) / sizeof(kReloadBounds[0])))
+
+// ========================= Per-thread slots ========================
+typedef struct {
+    volatile int64_t bucket[HIST_MAX_BOUNDS + 1];
+    volatile int64_t sum_us;
+} Histogram;
+
+typedef enum { EVENT_RELOAD, EVENT_RELOAD_SKIPPED, EVENT_COMPILE_ERROR, EVENT_PROGRAM } EventType;
+
+typedef struct {
+    EventType type;
+    double    at;       // seconds since TelemetryCreate
+    double    ms;       // reload latency
+    uint64_t  hash;     // program on screen
+    char      what[32];
+    char      text[TELEMETRY_EVENT_TEXT];
+} Event;
+
+// Written only by the thread that registered it; the server reads. The padding keeps a
+// slot's counters and its producer index off the cache lines the server writes.
+struct TelemetryThread {
+    Histogram        frame, gpu, reload;
+    volatile int64_t skipped, errors, dropped;
+    volatile int64_t program_hash;
+    volatile int32_t head;      // events published
+    char             pad0[64];
+    volatile int32_t tail;      // events consumed, server side
+    char             pad1[64];
+    volatile int32_t registered;
+    char             name[32];
+    const Telemetry* owner;
+    Event            ring[TELEMETRY_EVENT_RING];
+};
+
+// Single writer, so a plain read-modify-write; the store is what must not tear.
+static void Bump(volatile int64_t* p, int64_t v) {
+    AtomicStore64(p, AtomicLoad64(p) + v);
+}
+
+static void HistogramAdd(Histogram* h, const double* bounds, int n, double ms) {
+    int i = 0;
+    while (i < n && ms > bounds[i]) ++i;
+    Bump(&h->bucket[i], 1);
+    Bump(&h->sum_us, (int64_t)(ms * 1000.0 + 0.5));
+}
+
+// ============================== Server =============================
+struct Telemetry {
+    TelemetryThread  slot[TELEMETRY_MAX_THREADS];
+    volatile int32_t claimed;
+    double           created_at;
+    char             endpoint[APP_PATH_MAX + 16];
+    char             unix_path[APP_PATH_MAX]; // removed on destroy
+    Socket           listener;
+    Thread           thread;
+    volatile int32_t quit;
+
+    // server thread only
+    Socket           stream[TELEMETRY_MAX_STREAMS];
+    int              streams;
+    Event            error;         // compile error on screen; error.what[0] == 0 if none
+    char             program_what[32];
+    uint64_t         program_hash;
+    double           stats_at;
+    int64_t          stats_frame[HIST_MAX_BOUNDS + 1];
+    int64_t          stats_frame_us, stats_gpu_n, stats_gpu_us;
+};
+
+typedef struct {
+    int64_t bucket[HIST_MAX_BOUNDS + 1];
+    int64_t count, sum_us;
+} HistogramSnapshot;
+
+typedef struct {
+    HistogramSnapshot frame, gpu, reload;
+    int64_t           skipped, errors, dropped;
+} Snapshot;
+
+static void AddHistogram(HistogramSnapshot* s, Histogram* h) {
+    for (int i = 0; i <= HIST_MAX_BOUNDS; ++i) {
+        int64_t n = AtomicLoad64(&h->bucket[i]);
+        s->bucket[i] += n;
+        s->count += n; // from the buckets, so +Inf and _count always agree
+    }
+    s->sum_us += AtomicLoad64(&h->sum_us);
+}
+
+static void TakeSnapshot(Telemetry* t, Snapshot* s) {
+    memset(s, 0, sizeof(*s));
+    for (int i = 0; i < TELEMETRY_MAX_THREADS; ++i) {
+        TelemetryThread* th = &t->slot[i];
+        if (!AtomicLoad32(&th->registered)) continue;
+        AddHistogram(&s->frame, &th->frame);
+        AddHistogram(&s->gpu, &th->gpu);
+        AddHistogram(&s->reload, &th->reload);
+        s->skipped += AtomicLoad64(&th->skipped);
+        s->errors  += AtomicLoad64(&th->errors);
+        s->dropped += AtomicLoad64(&th->dropped);
+    }
+}
+
+// Growable text for responses.
+typedef struct { char* p; size_t len, cap; } Text;
+
+static void Put(Text* b, const char* fmt, ...) {
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        size_t room = b->cap - b->len;
+        int n = b->p ? vsnprintf(b->p + b->len, room, fmt, ap) : -1;
+        va_end(ap);
+        if (b->p && n >= 0 && (size_t)n < room) { b->len += (size_t)n; return; }
+        size_t cap = b->cap ? b->cap * 2 : 4096;
+        while (n >= 0 && cap - b->len <= (size_t)n) cap *= 2;
+        char* p = (char*)realloc(b->p, cap);
+        if (!p) return; // drops the piece; a response comes out short rather than not at all
+        b->p = p;
+        b->cap = cap;
+    }
+}
+
+static void PutJsonString(Text* b, const char* s) {
+    Put(b, "\"");
+    for (; *s; ++s) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') Put(b, "\\%c", c);
+        else if (c == '\n') Put(b, "\\n");
+        else if (c == '\t') Put(b, "\\t");
+        else if (c < 0x20) Put(b, "\\u%04x", c);
+        else Put(b, "%c", c);
+    }
+    Put(b, "\"");
+}
+
+// A Prometheus label value: the first line of s, at most max bytes.
+static void PutLabel(Text* b, const char* s, int max) {
+    for (int i = 0; s[i] && s[i] != '\n' && s[i] != '\r' && i < max; ++i) {
+        if (s[i] == '"' || s[i] == '\\') Put(b, "\\%c", s[i]);
+        else Put(b, "%c", s[i]);
+    }
+}
+
+static bool SendAll(Socket s, const char* p, size_t n) {
+    while (n > 0) {
+        int chunk = n > (size_t)INT_MAX ? INT_MAX : (int)n;
+        int sent = (int)send(s, p, chunk, SEND_FLAGS);
+        if (sent <= 0) return false;
+        p += sent;
+        n -= (size_t)sent;
+    }
+    return true;
+}
+
+static void SetTimeouts(Socket s, int recv_ms, int send_ms) {
+#ifdef _WIN32
+    DWORD r = (DWORD)recv_ms, w = (DWORD)send_ms;
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&r, sizeof(r));
+    setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, (const char*)&w, sizeof(w));
+#else
+    struct timeval r = { recv_ms / 1000, (recv_ms % 1000) * 1000 };
+    struct timeval w = { send_ms / 1000, (send_ms % 1000) * 1000 };
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &r, sizeof(r));
+    setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, &w, sizeof(w));
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+#endif
+}
+
+static void PutHistogram(Text* b, const char* name, const char* help, const HistogramSnapshot* h,
+                         const double* bounds, int n) {
+    Put(b, "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+    int64_t cumulative = 0;
+    for (int i = 0; i < n; ++i) {
+        cumulative += h->bucket[i];
+        Put(b, "%s_bucket{le=\"%g\"} %lld\n", name, bounds[i] / 1000.0, (long long)cumulative);
+    }
+    Put(b, "%s_bucket{le=\"+Inf\"} %lld\n", name, (long long)h->count);
+    Put(b, "%s_sum %.6f\n%s_count %lld\n", name, (double)h->sum_us * 1e-6, name, (long long)h->count);
+}
+
+static void PutCounter(Text* b, const char* name, const char* help, const char* type, double v) {
+    Put(b, "# HELP %s %s\n# TYPE %s %s\n%s %.17g\n", name, help, name, type, name, v);
+}
+
+static void BuildMetrics(Telemetry* t, Text* b) {
+    Snapshot s;
+    TakeSnapshot(t, &s);
+    PutHistogram(b, "shaderdevel_frame_seconds", "Time per frame.", &s.frame, kFrameBounds, FRAME_BOUNDS);
+    PutHistogram(b, "shaderdevel_gpu_frame_seconds", "GPU time per timed frame.", &s.gpu, kFrameBounds, FRAME_BOUNDS);
+    PutHistogram(b, "shaderdevel_reload_latency_seconds", "From a file change to the first frame with the new program.",
+                 &s.reload, kReloadBounds, RELOAD_BOUNDS);
+    PutCounter(b, "shaderdevel_reloads_total", "Programs swapped in after a file change.", "counter", (double)s.reload.count);
+    PutCounter(b, "shaderdevel_reloads_skipped_total", "File changes whose sources hashed the same.", "counter", (double)s.skipped);
+    PutCounter(b, "shaderdevel_compile_errors_total", "Failed builds.", "counter", (double)s.errors);
+
+    Put(b, "# HELP shaderdevel_program_info The program most recently installed.\n# TYPE shaderdevel_program_info gauge\n");
+    Put(b, "shaderdevel_program_info{program=\"");
+    PutLabel(b, t->program_what, 32);
+    Put(b, "\",hash=\"%016llx\"} 1\n", (unsigned long long)t->program_hash);
+
+    PutCounter(b, "shaderdevel_compile_error_active", "1 while the last build failed and the previous program is still drawing.", "gauge", t->error.what[0] ? 1.0 : 0.0);
+    if (t->error.what[0]) {
+        Put(b, "# HELP shaderdevel_compile_error_info The current compile error.\n# TYPE shaderdevel_compile_error_info gauge\n");
+        Put(b, "shaderdevel_compile_error_info{program=\"");
+        PutLabel(b, t->error.what, 32);
+        Put(b, "\",message=\"");
+        PutLabel(b, t->error.text, 200);
+        Put(b, "\"} 1\n");
+    }
+    PutCounter(b, "shaderdevel_uptime_seconds", "Since the telemetry server started.", "gauge", NowSeconds() - t->created_at);
+    PutCounter(b, "shaderdevel_telemetry_events_dropped_total", "Events lost to a full ring.", "counter", (double)s.dropped);
+}
+
+static const char* EventName(EventType type) {
+    switch (type) {
+    case EVENT_RELOAD:         return "reload";
+    case EVENT_RELOAD_SKIPPED: return "reload_skipped";
+    case EVENT_COMPILE_ERROR:  return "compile_error";
+    case EVENT_PROGRAM:        return "program";
+    }
+    return "?";
+}
+
+static void PutEvent(Text* b, const Event* e) {
+    Put(b, "{\"type\":\"%s\",\"t\":%.3f", EventName(e->type), e->at);
+    if (e->what[0]) { Put(b, ",\"program\":"); PutJsonString(b, e->what); }
+    if (e->type == EVENT_RELOAD) Put(b, ",\"latency_ms\":%.2f", e->ms);
+    if (e->type == EVENT_RELOAD || e->type == EVENT_PROGRAM) Put(b, ",\"hash\":\"%016llx\"", (unsigned long long)e->hash);
+    if (e->type == EVENT_COMPILE_ERROR) { Put(b, ",\"log\":"); PutJsonString(b, e->text); }
+    Put(b, "}\n");
+}
+
+static void Broadcast(Telemetry* t, const Text* b) {
+    if (!b->len) return;
+    for (int i = t->streams - 1; i >= 0; --i) {
+        if (SendAll(t->stream[i], b->p, b->len)) continue;
+        CloseSocket(t->stream[i]); // too slow or gone
+        t->stream[i] = t->stream[--t->streams];
+    }
+}
+
+// Takes every published event, keeps the program / error state and streams them.
+static void DrainEvents(Telemetry* t, Text* b) {
+    b->len = 0;
+    for (int i = 0; i < TELEMETRY_MAX_THREADS; ++i) {
+        TelemetryThread* th = &t->slot[i];
+        if (!AtomicLoad32(&th->registered)) continue;
+        uint32_t head = (uint32_t)AtomicLoad32(&th->head);
+        for (uint32_t tail = (uint32_t)th->tail; tail != head; ++tail) {
+            const Event* e = &th->ring[tail % TELEMETRY_EVENT_RING];
+            if (e->type == EVENT_COMPILE_ERROR) t->error = *e;
+            if (e->type == EVENT_PROGRAM) {
+                snprintf(t->program_what, sizeof(t->program_what), "%s", e->what);
+                t->program_hash = e->hash;
+            }
+            // Either way what draws matches the file again.
+            if ((e->type == EVENT_PROGRAM || e->type == EVENT_RELOAD_SKIPPED) && !strcmp(t->error.what, e->what))
+                t->error.what[0] = 0;
+            PutEvent(b, e);
+            AtomicStore32(&th->tail, (int32_t)(tail + 1)); // the slot may be reused from here on
+        }
+    }
+    Broadcast(t, b);
+}
+
+static void PutBounds(Text* b) {
+    Put(b, "[");
+    for (int i = 0; i < FRAME_BOUNDS; ++i) Put(b, "%s%g", i ? "," : "", kFrameBounds[i]);
+    Put(b, "]");
+}
+
+static void PutStatus(Telemetry* t, Text* b) {
+    Snapshot s;
+    TakeSnapshot(t, &s);
+    Put(b, "{\"type\":\"status\",\"t\":%.3f,\"program\":", NowSeconds() - t->created_at);
+    PutJsonString(b, t->program_what);
+    Put(b, ",\"hash\":\"%016llx\",\"frames\":%lld,\"reloads\":%lld,\"reloads_skipped\":%lld,\"compile_errors\":%lld,\"frame_le_ms\":",
+        (unsigned long long)t->program_hash, (long long)s.frame.count, (long long)s.reload.count,
+        (long long)s.skipped, (long long)s.errors);
+    PutBounds(b);
+    Put(b, ",\"threads\":[");
+    for (int i = 0, n = 0; i < TELEMETRY_MAX_THREADS; ++i) {
+        if (!AtomicLoad32(&t->slot[i].registered)) continue;
+        if (n++) Put(b, ",");
+        PutJsonString(b, t->slot[i].name);
+    }
+    Put(b, "],\"error\":");
+    if (t->error.what[0]) {
+        Put(b, "{\"program\":");
+        PutJsonString(b, t->error.what);
+        Put(b, ",\"log\":");
+        PutJsonString(b, t->error.text);
+        Put(b, "}");
+    } else {
+        Put(b, "null");
+    }
+    Put(b, "}\n");
+}
+
+// Once a second: what changed since the last one.
+static void SendStats(Telemetry* t, Text* b, double now) {
+    Snapshot s;
+    TakeSnapshot(t, &s);
+    double dt = now - t->stats_at;
+    int64_t frames = s.frame.count, last = 0;
+    for (int i = 0; i <= HIST_MAX_BOUNDS; ++i) last += t->stats_frame[i];
+    int64_t n = frames - last, gpu_n = s.gpu.count - t->stats_gpu_n;
+    b->len = 0;
+    Put(b, "{\"type\":\"stats\",\"t\":%.3f,\"frames\":%lld,\"fps\":%.2f,\"frame_ms\":", now - t->created_at,
+        (long long)frames, dt > 0.0 ? (double)n / dt : 0.0);
+    if (n > 0) Put(b, "%.3f", (double)(s.frame.sum_us - t->stats_frame_us) / 1000.0 / (double)n);
+    else Put(b, "null");
+    Put(b, ",\"gpu_ms\":");
+    if (gpu_n > 0) Put(b, "%.3f", (double)(s.gpu.sum_us - t->stats_gpu_us) / 1000.0 / (double)gpu_n);
+    else Put(b, "null");
+    Put(b, ",\"frame_hist\":[");
+    for (int i = 0; i <= FRAME_BOUNDS; ++i) Put(b, "%s%lld", i ? "," : "", (long long)(s.frame.bucket[i] - t->stats_frame[i]));
+    Put(b, "]}\n");
+    Broadcast(t, b);
+
+    memcpy(t->stats_frame, s.frame.bucket, sizeof(t->stats_frame));
+    t->stats_frame_us = s.frame.sum_us;
+    t->stats_gpu_n = s.gpu.count;
+    t->stats_gpu_us = s.gpu.sum_us;
+    t->stats_at = now;
+}
+
+static void Respond(Socket c, const char* status, const char* type, const Text* body) {
+    char head[256];
+    int n = snprintf(head, sizeof(head), "HTTP/1.0 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                     status, type, body ? body->len : 0);
+    if (SendAll(c, head, (size_t)n) && body && body->len) SendAll(c, body->p, body->len);
+}
+
+// One request per connection; /stream keeps it.
+static void Accept(Telemetry* t, Text* b) {
+    Socket c = accept(t->listener, NULL, NULL);
+    if (c == BAD_SOCKET) return;
+    SetTimeouts(c, 500, 200);
+    char req[2048];
+    int len = 0;
+    req[0] = 0;
+    while (len < (int)sizeof(req) - 1 && !strstr(req, "\r\n\r\n") && !strstr(req, "\n\n")) {
+        int got = (int)recv(c, req + len, (int)sizeof(req) - 1 - len, 0);
+        if (got <= 0) break;
+        len += got;
+        req[len] = 0;
+    }
+    char path[64] = "";
+    if (!strncmp(req, "GET ", 4)) sscanf(req + 4, "%63[^ ?\r\n]", path);
+
+    b->len = 0;
+    if (!strcmp(path, "/metrics")) {
+        BuildMetrics(t, b);
+        Respond(c, "200 OK", "text/plain; version=0.0.4", b);
+    } else if (!strcmp(path, "/stream") && t->streams < TELEMETRY_MAX_STREAMS) {
+        static const char kHead[] = "HTTP/1.0 200 OK\r\nContent-Type: application/x-ndjson\r\nCache-Control: no-cache\r\n\r\n";
+        PutStatus(t, b);
+        if (SendAll(c, kHead, sizeof(kHead) - 1) && SendAll(c, b->p, b->len)) {
+            t->stream[t->streams++] = c;
+            return;
+        }
+    } else if (!strcmp(path, "/stream")) {
+        Put(b, "too many stream clients\n");
+        Respond(c, "503 Service Unavailable", "text/plain", b);
+    } else {
+        Put(b, "GET /metrics or /stream\n");
+        Respond(c, "404 Not Found", "text/plain", b);
+    }
+    CloseSocket(c);
+}
+
+static void ServerMain(void* arg) {
+    Telemetry* t = (Telemetry*)arg;
+    Text b = { 0 };
+    t->stats_at = NowSeconds();
+    while (!AtomicLoad32(&t->quit)) {
+        PollFd fds[1 + TELEMETRY_MAX_STREAMS];
+        memset(fds, 0, sizeof(fds));
+        fds[0].fd = t->listener;
+        fds[0].events = POLLIN;
+        for (int i = 0; i < t->streams; ++i) { fds[1 + i].fd = t->stream[i]; fds[1 + i].events = POLLIN; }
+        int nfds = 1 + t->streams;
+        if (PollSockets(fds, (unsigned)nfds, TELEMETRY_POLL_MS) > 0) {
+            // Stream clients never send; readable means gone (or talking nonsense: drop it too).
+            for (int i = nfds - 1; i >= 1; --i) {
+                if (!fds[i].revents) continue;
+                CloseSocket(t->stream[i - 1]);
+                t->stream[i - 1] = t->stream[--t->streams];
+            }
+            if (fds[0].revents & POLLIN) Accept(t, &b);
+        }
+        DrainEvents(t, &b);
+        double now = NowSeconds();
+        if (now - t->stats_at >= 1.0) SendStats(t, &b, now);
+    }
+    free(b.p);
+}
+
+// ============================= Endpoint ============================
+static bool Listen(Telemetry* t, const char* endpoint, char* log, int logsz) {
+    if (!strncmp(endpoint, "unix:", 5)) {
+#ifdef _WIN32
+        snprintf(log, (size_t)logsz, "unix sockets are not supported on Windows, use PORT or HOST:PORT");
+        return false;
+#else
+        const char* path = endpoint + 5;
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (!path[0] || strlen(path) >= sizeof(addr.sun_path)) {
+            snprintf(log, (size_t)logsz, "bad socket path '%s'", path);
+            return false;
+        }
+        memcpy(addr.sun_path, path, strlen(path) + 1);
+        struct stat st;
+        if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode)) unlink(path); // left over from a crash
+        t->listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (t->listener == BAD_SOCKET || bind(t->listener, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+            listen(t->listener, 8) != 0) {
+            snprintf(log, (size_t)logsz, "can't listen on %s", endpoint);
+            return false;
+        }
+        snprintf(t->unix_path, sizeof(t->unix_path), "%s", path);
+        snprintf(t->endpoint, sizeof(t->endpoint), "%s", endpoint);
+        return true;
+#endif
+    }
+
+    // "PORT", "HOST:PORT" or "[V6HOST]:PORT"
+    char host[256] = "127.0.0.1", port[16];
+    const char* colon = strrchr(endpoint, ':');
+    const char* p = colon ? colon + 1 : endpoint;
+    if (colon) {
+        const char* h = endpoint;
+        size_t n = (size_t)(colon - endpoint);
+        if (n >= 2 && h[0] == '[' && h[n - 1] == ']') { h++; n -= 2; }
+        if (n >= sizeof(host)) n = sizeof(host) - 1;
+        memcpy(host, h, n);
+        host[n] = 0;
+    }
+    char* end = NULL;
+    long v = strtol(p, &end, 10);
+    if (!p[0] || *end || v < 0 || v > 65535) {
+        snprintf(log, (size_t)logsz, "'%s' is not PORT, HOST:PORT or unix:PATH", endpoint);
+        return false;
+    }
+    snprintf(port, sizeof(port), "%ld", v);
+
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    if (getaddrinfo(host, port, &hints, &res) != 0 || !res) {
+        snprintf(log, (size_t)logsz, "can't resolve '%s'", host);
+        return false;
+    }
+    t->listener = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    bool ok = t->listener != BAD_SOCKET;
+#ifndef _WIN32
+    int one = 1; // restarting right after a run must not wait out TIME_WAIT
+    if (ok) setsockopt(t->listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+#endif
+    ok = ok && bind(t->listener, res->ai_addr, (int)res->ai_addrlen) == 0 && listen(t->listener, 8) == 0;
+    freeaddrinfo(res);
+    if (!ok) {
+        snprintf(log, (size_t)logsz, "can't listen on %s:%s", host, port);
+        return false;
+    }
+
+    struct sockaddr_storage bound;
+    socklen_t boundsz = sizeof(bound);
+    char nhost[128] = "?", nport[16] = "?";
+    if (getsockname(t->listener, (struct sockaddr*)&bound, &boundsz) == 0)
+        getnameinfo((struct sockaddr*)&bound, boundsz, nhost, sizeof(nhost), nport, sizeof(nport), NI_NUMERICHOST | NI_NUMERICSERV);
+    snprintf(t->endpoint, sizeof(t->endpoint), strchr(nhost, ':') ? "[%s]:%s" : "%s:%s", nhost, nport);
+    return true;
+}
+
+// ================================ API ==============================
+Telemetry* TelemetryCreate(const char* endpoint, char* log, int logsz) {
+    log[0] = 0;
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        snprintf(log, (size_t)logsz, "WSAStartup failed");
+        return NULL;
+    }
+#endif
+    Telemetry* t = (Telemetry*)calloc(1, sizeof(Telemetry));
+    if (!t) {
+        snprintf(log, (size_t)logsz, "out of memory");
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return NULL;
+    }
+    t->listener = BAD_SOCKET;
+    t->created_at = NowSeconds();
+    if (!Listen(t, endpoint, log, logsz) || !ThreadStart(&t->thread, ServerMain, t)) {
+        if (!log[0]) snprintf(log, (size_t)logsz, "can't start the server thread");
+        if (t->listener != BAD_SOCKET) CloseSocket(t->listener);
+#ifndef _WIN32
+        if (t->unix_path[0]) unlink(t->unix_path);
+#else
+        WSACleanup();
+#endif
+        free(t);
+        return NULL;
+    }
+    return t;
+}
+
+void TelemetryDestroy(Telemetry* t) {
+    if (!t) return;
+    AtomicStore32(&t->quit, 1);
+    ThreadJoin(t->thread);
+    for (int i = 0; i < t->streams; ++i) CloseSocket(t->stream[i]);
+    CloseSocket(t->listener);
+#ifndef _WIN32
+    if (t->unix_path[0]) unlink(t->unix_path);
+#endif
+    free(t);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+const char* TelemetryEndpoint(const Telemetry* t) {
+    return t ? t->endpoint : "";
+}
+
+TelemetryThread* TelemetryRegisterThread(Telemetry* t, const char* name) {
+    if (!t) return NULL;
+    int i = AtomicAdd32(&t->claimed, 1) - 1;
+    if (i >= TELEMETRY_MAX_THREADS) return NULL;
+    TelemetryThread* th = &t->slot[i];
+    snprintf(th->name, sizeof(th->name), "%s", name ? name : "");
+    th->owner = t;
+    AtomicStore32(&th->registered, 1);
+    return th;
+}
+
+// A free ring entry to fill in and Publish, or NULL (counted) while the server is behind.
+static Event* NewEvent(TelemetryThread* th, EventType type, const char* what) {
+    uint32_t head = (uint32_t)th->head;
+    if (head - (uint32_t)AtomicLoad32(&th->tail) >= TELEMETRY_EVENT_RING) {
+        Bump(&th->dropped, 1);
+        return NULL;
+    }
+    Event* e = &th->ring[head % TELEMETRY_EVENT_RING];
+    e->type = type;
+    e->at   = NowSeconds() - th->owner->created_at;
+    e->ms   = 0.0;
+    e->hash = (uint64_t)AtomicLoad64(&th->program_hash);
+    snprintf(e->what, sizeof(e->what), "%s", what ? what : "");
+    e->text[0] = 0;
+    return e;
+}
+
+static void Publish(TelemetryThread* th) {
+    AtomicStore32(&th->head, (int32_t)((uint32_t)th->head + 1));
+}
+
+void TelemetryFrame(TelemetryThread* th, double frame_ms) {
+    if (th) HistogramAdd(&th->frame, kFrameBounds, FRAME_BOUNDS, frame_ms);
+}
+
+void TelemetryGpuSample(void* th, double gpu_ms) {
+    if (th) HistogramAdd(&((TelemetryThread*)th)->gpu, kFrameBounds, FRAME_BOUNDS, gpu_ms);
+}
+
+void TelemetryReload(TelemetryThread* th, double latency_ms) {
+    if (!th) return;
+    HistogramAdd(&th->reload, kReloadBounds, RELOAD_BOUNDS, latency_ms);
+    Event* e = NewEvent(th, EVENT_RELOAD, NULL);
+    if (!e) return;
+    e->ms = latency_ms;
+    Publish(th);
+}
+
+void TelemetryReloadSkipped(TelemetryThread* th, const char* what) {
+    if (!th) return;
+    Bump(&th->skipped, 1);
+    if (NewEvent(th, EVENT_RELOAD_SKIPPED, what)) Publish(th);
+}
+
+void TelemetryCompileError(TelemetryThread* th, const char* what, const char* log) {
+    if (!th) return;
+    Bump(&th->errors, 1);
+    Event* e = NewEvent(th, EVENT_COMPILE_ERROR, what);
+    if (!e) return;
+    snprintf(e->text, sizeof(e->text), "%s", log ? log : "");
+    Publish(th);
+}
+
+void TelemetrySetProgram(TelemetryThread* th, const char* what, uint64_t hash) {
+    if (!th) return;
+    AtomicStore64(&th->program_hash, (int64_t)hash);
+    if (NewEvent(th, EVENT_PROGRAM, what)) Publish(th);
+}
@@ -0,0 +1,54 @@
+// telemetry.h — live counters served on a local socket for dashboards and scripts
+//
+// Every thread that reports registers once and gets its own slot: cache-line separated
+// counters and histograms it alone writes, with untorn 64-bit stores, plus a small
+// single-producer ring for events (reloads, compile errors with their logs). Reporting
+// never takes a lock, allocates or touches a socket; a full ring drops the event and
+// counts it. A server thread reads every slot and answers on the endpoint:
+//
+//   GET /metrics   Prometheus text: frame and GPU time and reload latency histograms,
+//                  reload / skipped reload / compile error totals, the program hash
+//                  and the compile error currently shown (first line of its log);
+//   GET /stream    newline-delimited JSON: a "status" object (with the full log of
+//                  the current compile error), then every event as it is drained and
+//                  a "stats" object per second (fps, mean frame / GPU time, the frame
+//                  time histogram of that second).
+//
+// The endpoint is "PORT" or "HOST:PORT" over TCP (HOST defaults to 127.0.0.1, port 0
+// picks a free one), or "unix:PATH" for a Unix domain socket (not on Windows). HTTP is
+// just enough for curl and a Prometheus scrape: HTTP/1.0, one request per connection.
+
+#ifndef SHADERDEVEL_TELEMETRY_H
+#define SHADERDEVEL_TELEMETRY_H
+
+#include "platform.h"
+
+#define TELEMETRY_MAX_THREADS 8
+
+typedef struct Telemetry       Telemetry;
+typedef struct TelemetryThread TelemetryThread;
+
+// Binds the endpoint and starts the server thread. NULL (with log) if it can't listen.
+Telemetry*  TelemetryCreate(const char* endpoint, char* log, int logsz);
+void        TelemetryDestroy(Telemetry* t);
+// Where it listens ("127.0.0.1:9464", "unix:/tmp/shaderdevel.sock"), for the banner.
+const char* TelemetryEndpoint(const Telemetry* t);
+
+// Claims a slot for the calling thread; NULL once TELEMETRY_MAX_THREADS are taken or
+// when t is NULL. The slot lives until TelemetryDestroy.
+TelemetryThread* TelemetryRegisterThread(Telemetry* t, const char* name);
+
+// Reporting, from the thread that registered th; all of them accept th == NULL.
+void TelemetryFrame(TelemetryThread* th, double frame_ms);
+// void* so it can be handed to GpuTimerSetSink as is.
+void TelemetryGpuSample(void* th, double gpu_ms);
+// A new program is on screen, latency_ms after the file change that asked for it.
+void TelemetryReload(TelemetryThread* th, double latency_ms);
+// The sources of what hash to the program on screen (clears its compile error).
+void TelemetryReloadSkipped(TelemetryThread* th, const char* what);
+// what: "program" or the graph pass; log: the driver's.
+void TelemetryCompileError(TelemetryThread* th, const char* what, const char* log);
+// A build of what was installed (clears the compile error).
+void TelemetrySetProgram(TelemetryThread* th, const char* what, uint64_t hash);
+
+#endif // SHADERDEVEL_TELEMETRY_H
@@ -0,0 +1,437 @@
+// texture_cache.c — see texture_cache.h
+#include "texture_cache.h"
+#include "image_read.h"
+#include "profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEXTURE_LOADER_THREADS     4
+#define TEXTURE_FILE_MAX           ((size_t)1 << 30)
+#define TEXTURE_UPLOADS_PER_UPDATE 2 // a big glTexImage2D + mipmaps is a few ms even from a PBO
+#define TEXTURE_EVENT_RING         16
+
+// Where an entry's load is; the loader threads own the states they are busy in.
+typedef enum {
+    LOAD_NONE,
+    LOAD_QUEUED,   // loader: map and read the header
+    LOAD_READING,
+    LOAD_HEADER,   // render: allocate and map the unpack buffer
+    LOAD_MAPPED,   // loader: decode into it
+    LOAD_DECODING,
+    LOAD_DECODED,  // render: upload
+    LOAD_FAILED,   // render: clean up and report
+} LoadState;
+
+typedef struct {
+    char       path[APP_PATH_MAX]; // "" = free slot
+    uint64_t   write_time;         // of the version loaded or loading
+    int        refs;
+    uint64_t   last_used;
+
+    // render thread
+    GLuint     texture;            // 0 until the first load is done
+    int        width, height;
+    size_t     bytes;
+
+    // the load in flight, under lock
+    LoadState  load;
+    double     queued_at;
+    MappedFile file;               // LOAD_HEADER .. LOAD_DECODING
+    ImageInfo  info;
+    GLuint     pbo;                // 0 when decoding to heap memory (no mapping)
+    uint8_t*   dst;
+    double     decode_ms;
+    char       error[160];
+} TextureEntry;
+
+struct TextureCache {
+    TextureEntry     entry[TEXTURE_CACHE_MAX_ENTRIES];
+    size_t           budget;
+    size_t           resident;
+    uint64_t         tick;
+    GLuint           placeholder;
+    TextureLoadEvent events[TEXTURE_EVENT_RING]; // finished loads not yet taken, oldest first
+    int              event_count;
+    int              loads, hits, failures, evictions;
+    double           last_load_ms, total_load_ms;
+
+    Mutex            lock;
+    CondVar          wake;
+    bool             stop;
+    void           (*notify)(void* user); // under lock
+    void*            notify_user;
+    Thread           thread[TEXTURE_LOADER_THREADS];
+    int              thread_count;
+};
+
+// ============================= Loaders =============================
+static int FindWorkLocked(const TextureCache* c) {
+    for (int i = 0; i < TEXTURE_CACHE_MAX_ENTRIES; ++i)
+        if (c->entry[i].load == LOAD_QUEUED || c->entry[i].load == LOAD_MAPPED) return i;
+    return -1;
+}
+
+static void LoaderThread(void* arg) {
+    TextureCache* c = (TextureCache*)arg;
+    PROFILE_THREAD("texture loader");
+    MutexLock(&c->lock);
+    while (!c->stop) {
+        int i = FindWorkLocked(c);
+        if (i < 0) { CondWait(&c->wake, &c->lock); continue; }
+        TextureEntry* e = &c->entry[i];
+        char error[160] = "";
+        bool ok;
+        if (e->load == LOAD_QUEUED) {
+            e->load = LOAD_READING;
+            char path[APP_PATH_MAX];
+            snprintf(path, sizeof(path), "%s", e->path);
+            MutexUnlock(&c->lock);
+            double t0 = NowSeconds();
+            PROFILE_BEGIN("read image header");
+            MappedFile file;
+            ImageInfo info = {0};
+            ok = MapFileReadOnly(path, TEXTURE_FILE_MAX, &file);
+            if (!ok) snprintf(error, sizeof(error), "cannot read the file");
+            else if (!(ok = ReadImageInfo(file.data, file.size, &info, error, sizeof(error)))) UnmapFile(&file);
+            PROFILE_END();
+            double ms = (NowSeconds() - t0) * 1000.0;
+            MutexLock(&c->lock);
+            if (ok) { e->file = file; e->info = info; }
+            e->decode_ms = ms;
+            e->load = ok ? LOAD_HEADER : LOAD_FAILED;
+        } else {
+            e->load = LOAD_DECODING;
+            MappedFile file = e->file;
+            ImageInfo info = e->info;
+            uint8_t* dst = e->dst;
+            MutexUnlock(&c->lock);
+            double t0 = NowSeconds();
+            PROFILE_BEGIN("decode image");
+            ok = DecodeImage(file.data, file.size, &info, dst, true, error, sizeof(error));
+            UnmapFile(&file);
+            PROFILE_END();
+            double ms = (NowSeconds() - t0) * 1000.0;
+            MutexLock(&c->lock);
+            e->decode_ms += ms;
+            e->load = ok ? LOAD_DECODED : LOAD_FAILED;
+        }
+        if (!ok) snprintf(e->error, sizeof(e->error), "%s", error);
+        if (c->notify) c->notify(c->notify_user);
+    }
+    MutexUnlock(&c->lock);
+}
+
+// ============================= Lifetime ============================
+TextureCache* TextureCacheCreate(size_t budget_bytes) {
+    TextureCache* c = (TextureCache*)calloc(1, sizeof(TextureCache));
+    if (!c) return NULL;
+    c->budget = budget_bytes ? budget_bytes : TEXTURE_CACHE_DEFAULT_BUDGET;
+    const uint8_t black[4] = { 0, 0, 0, 255 };
+    glGenTextures(1, &c->placeholder);
+    glBindTexture(GL_TEXTURE_2D, c->placeholder);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, black);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    MutexInit(&c->lock);
+    CondInit(&c->wake);
+    int n = CpuCount();
+    if (n > TEXTURE_LOADER_THREADS) n = TEXTURE_LOADER_THREADS;
+    for (int i = 0; i < n; ++i)
+        if (ThreadStart(&c->thread[c->thread_count], LoaderThread, c)) c->thread_count++;
+    return c;
+}
+
+static void FreeEntry(TextureCache* c, TextureEntry* e) {
+    if (e->texture) glDeleteTextures(1, &e->texture);
+    c->resident -= e->bytes;
+    memset(e, 0, sizeof(*e));
+}
+
+void TextureCacheDestroy(TextureCache* c) {
+    if (!c) return;
+    MutexLock(&c->lock);
+    c->stop = true;
+    CondBroadcast(&c->wake);
+    MutexUnlock(&c->lock);
+    for (int i = 0; i < c->thread_count; ++i) ThreadJoin(c->thread[i]);
+    for (int i = 0; i < TEXTURE_CACHE_MAX_ENTRIES; ++i) {
+        TextureEntry* e = &c->entry[i];
+        if (e->load == LOAD_HEADER || e->load == LOAD_MAPPED) UnmapFile(&e->file);
+        if (e->pbo) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, e->pbo);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glDeleteBuffers(1, &e->pbo);
+        } else if (e->load >= LOAD_MAPPED) {
+            free(e->dst);
+        }
+        FreeEntry(c, e);
+    }
+    glDeleteTextures(1, &c->placeholder);
+    CondDestroy(&c->wake);
+    MutexDestroy(&c->lock);
+    free(c);
+}
+
+void TextureCacheSetNotify(TextureCache* c, void (*fn)(void* user), void* user) {
+    if (!c) return;
+    MutexLock(&c->lock);
+    c->notify = fn;
+    c->notify_user = user;
+    MutexUnlock(&c->lock);
+}
+
+// ============================ References ===========================
+// Oldest unreferenced entry with no load in flight, -1 if none.
+static int EvictionCandidateLocked(const TextureCache* c) {
+    int best = -1;
+    for (int i = 0; i < TEXTURE_CACHE_MAX_ENTRIES; ++i) {
+        const TextureEntry* e = &c->entry[i];
+        if (!e->path[0] || e->refs || e->load != LOAD_NONE) continue;
+        if (best < 0 || e->last_used < c->entry[best].last_used) best = i;
+    }
+    return best;
+}
+
+static void QueueLoadLocked(TextureCache* c, TextureEntry* e, uint64_t write_time) {
+    e->write_time = write_time;
+    e->load = LOAD_QUEUED;
+    e->queued_at = NowSeconds();
+    e->error[0] = 0;
+    c->loads++;
+    CondSignal(&c->wake);
+}
+
+int TextureCacheAcquire(TextureCache* c, const char* path) {
+    if (!c) return -1;
+    uint64_t write_time = 0;
+    GetFileWriteTime(path, &write_time); // a missing file fails in the loader, with a reason
+    MutexLock(&c->lock);
+    int found = -1, free_slot = -1;
+    for (int i = 0; i < TEXTURE_CACHE_MAX_ENTRIES && found < 0; ++i) {
+        if (!strcmp(c->entry[i].path, path)) found = i;
+        else if (!c->entry[i].path[0] && free_slot < 0) free_slot = i;
+    }
+    if (found >= 0) {
+        TextureEntry* e = &c->entry[found];
+        if (e->load == LOAD_NONE && write_time != e->write_time) QueueLoadLocked(c, e, write_time);
+        else c->hits++;
+    } else {
+        if (free_slot < 0 && (free_slot = EvictionCandidateLocked(c)) >= 0) {
+            FreeEntry(c, &c->entry[free_slot]);
+            c->evictions++;
+        }
+        if (free_slot >= 0) {
+            snprintf(c->entry[free_slot].path, APP_PATH_MAX, "%s", path);
+            QueueLoadLocked(c, &c->entry[free_slot], write_time);
+        }
+        found = free_slot;
+    }
+    if (found >= 0) {
+        c->entry[found].refs++;
+        c->entry[found].last_used = ++c->tick;
+    }
+    MutexUnlock(&c->lock);
+    return found;
+}
+
+void TextureCacheRelease(TextureCache* c, int handle) {
+    if (handle < 0 || handle >= TEXTURE_CACHE_MAX_ENTRIES) return;
+    MutexLock(&c->lock);
+    if (c->entry[handle].refs > 0) c->entry[handle].refs--;
+    c->entry[handle].last_used = ++c->tick;
+    MutexUnlock(&c->lock);
+}
+
+GLuint TextureCacheTexture(TextureCache* c, int handle, int* w, int* h) {
+    const TextureEntry* e = c && handle >= 0 && handle < TEXTURE_CACHE_MAX_ENTRIES ? &c->entry[handle] : NULL;
+    bool ready = e && e->texture;
+    if (w) *w = ready ? e->width : 0;
+    if (h) *h = ready ? e->height : 0;
+    return ready ? e->texture : c ? c->placeholder : 0;
+}
+
+const char* TextureCachePath(const TextureCache* c, int handle) {
+    return c && handle >= 0 && handle < TEXTURE_CACHE_MAX_ENTRIES ? c->entry[handle].path : "";
+}
+
+// ========================== Render thread ==========================
+static void PushEvent(TextureCache* c, const TextureEntry* e, bool ok, double load_ms) {
+    if (c->event_count == TEXTURE_EVENT_RING) {
+        memmove(c->events, c->events + 1, sizeof(c->events[0]) * (TEXTURE_EVENT_RING - 1));
+        c->event_count--;
+    }
+    TextureLoadEvent* ev = &c->events[c->event_count++];
+    snprintf(ev->path, sizeof(ev->path), "%s", e->path);
+    ev->ok = ok;
+    ev->width = ok ? e->info.width : 0;
+    ev->height = ok ? e->info.height : 0;
+    ev->load_ms = load_ms;
+    ev->decode_ms = e->decode_ms;
+    snprintf(ev->error, sizeof(ev->error), "%s", ok ? "" : e->error);
+}
+
+// LOAD_HEADER: a mapped unpack buffer for the loader to decode into.
+static void MapUploadBuffer(TextureEntry* e) {
+    GLsizeiptr size = (GLsizeiptr)e->info.width * e->info.height * 4;
+    glGenBuffers(1, &e->pbo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, e->pbo);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+    e->dst = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (e->dst) return;
+    // Mapping refused (out of address space, say): decode to memory, upload from there.
+    glDeleteBuffers(1, &e->pbo);
+    e->pbo = 0;
+    e->dst = (uint8_t*)malloc((size_t)size);
+}
+
+// LOAD_DECODED: the texture with its mip chain; false if the buffer was lost.
+static bool Upload(TextureCache* c, TextureEntry* e) {
+    bool ok = true;
+    if (e->pbo) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, e->pbo);
+        ok = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE; // false: contents lost, e.g. a mode switch
+    }
+    if (ok) {
+        if (e->texture) glDeleteTextures(1, &e->texture); // the previous version
+        c->resident -= e->bytes;
+        glGenTextures(1, &e->texture);
+        glBindTexture(GL_TEXTURE_2D, e->texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, e->info.width, e->info.height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                     e->pbo ? NULL : e->dst);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        e->width = e->info.width;
+        e->height = e->info.height;
+        e->bytes = (size_t)e->width * (size_t)e->height * 4 * 4 / 3;
+        c->resident += e->bytes;
+    } else {
+        snprintf(e->error, sizeof(e->error), "upload buffer contents lost");
+    }
+    if (e->pbo) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &e->pbo);
+        e->pbo = 0;
+    } else {
+        free(e->dst);
+    }
+    e->dst = NULL;
+    return ok;
+}
+
+// LOAD_FAILED: whatever the load still holds.
+static void AbandonLoad(TextureEntry* e) {
+    if (e->pbo) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, e->pbo);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &e->pbo);
+        e->pbo = 0;
+    } else {
+        free(e->dst);
+    }
+    e->dst = NULL;
+}
+
+int TextureCacheUpdate(TextureCache* c, TextureLoadEvent* ev, int max) {
+    if (!c) return 0;
+    // Only this thread moves entries out of HEADER, DECODED and FAILED, so the GL work
+    // runs unlocked between taking the list and publishing the new states.
+    int work[TEXTURE_CACHE_MAX_ENTRIES], n = 0;
+    MutexLock(&c->lock);
+    for (int i = 0; i < TEXTURE_CACHE_MAX_ENTRIES; ++i) {
+        LoadState s = c->entry[i].load;
+        if (s == LOAD_HEADER || s == LOAD_DECODED || s == LOAD_FAILED) work[n++] = i;
+    }
+    MutexUnlock(&c->lock);
+
+    int uploads = 0;
+    for (int k = 0; k < n; ++k) {
+        TextureEntry* e = &c->entry[work[k]];
+        LoadState next = LOAD_NONE;
+        if (e->load == LOAD_HEADER) {
+            MapUploadBuffer(e);
+            if (e->dst) next = LOAD_MAPPED;
+            else { snprintf(e->error, sizeof(e->error), "out of memory"); UnmapFile(&e->file); next = LOAD_FAILED; }
+        } else if (e->load == LOAD_DECODED) {
+            if (uploads == TEXTURE_UPLOADS_PER_UPDATE) continue; // next iteration
+            ++uploads;
+            next = Upload(c, e) ? LOAD_NONE : LOAD_FAILED;
+        }
+        double load_ms = (NowSeconds() - e->queued_at) * 1000.0;
+        MutexLock(&c->lock);
+        if (next == LOAD_NONE) {
+            bool ok = e->load != LOAD_FAILED;
+            if (!ok) { AbandonLoad(e); c->failures++; }
+            else { c->last_load_ms = load_ms; c->total_load_ms += load_ms; }
+            PushEvent(c, e, ok, load_ms);
+        }
+        e->load = next;
+        if (next == LOAD_MAPPED) CondSignal(&c->wake);
+        MutexUnlock(&c->lock);
+    }
+
+    MutexLock(&c->lock);
+    while (c->resident > c->budget) {
+        int victim = EvictionCandidateLocked(c);
+        if (victim < 0) break; // everything resident is in use: over budget until released
+        FreeEntry(c, &c->entry[victim]);
+        c->evictions++;
+    }
+    int taken = c->event_count < max ? c->event_count : max;
+    if (taken > 0) {
+        memcpy(ev, c->events, sizeof(c->events[0]) * (size_t)taken);
+        memmove(c->events, c->events + taken, sizeof(c->events[0]) * (size_t)(c->event_count - taken));
+        c->event_count -= taken;
+    }
+    MutexUnlock(&c->lock);
+    return taken;
+}
+
+static int LoadingCount(TextureCache* c) {
+    int n = 0;
+    MutexLock(&c->lock);
+    for (int i = 0; i < TEXTURE_CACHE_MAX_ENTRIES; ++i) n += c->entry[i].load != LOAD_NONE;
+    MutexUnlock(&c->lock);
+    return n;
+}
+
+void TextureCacheFinish(TextureCache* c) {
+    if (!c) return;
+    for (;;) {
+        TextureCacheUpdate(c, NULL, 0);
+        if (!LoadingCount(c)) break;
+        SleepMilliseconds(1);
+    }
+}
+
+void TextureCacheGetStats(const TextureCache* c, TextureCacheStats* out) {
+    TextureCache* m = (TextureCache*)c; // the lock only
+    memset(out, 0, sizeof(*out));
+    if (!c) return;
+    MutexLock(&m->lock);
+    for (int i = 0; i < TEXTURE_CACHE_MAX_ENTRIES; ++i) {
+        if (!c->entry[i].path[0]) continue;
+        out->entries++;
+        out->loading += c->entry[i].load != LOAD_NONE;
+    }
+    out->resident_bytes = c->resident;
+    out->budget_bytes = c->budget;
+    out->loads = c->loads;
+    out->hits = c->hits;
+    out->failures = c->failures;
+    out->evictions = c->evictions;
+    out->last_load_ms = c->last_load_ms;
+    out->total_load_ms = c->total_load_ms;
+    MutexUnlock(&m->lock);
+}
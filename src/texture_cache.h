@@ -0,0 +1,72 @@
+// texture_cache.h — image files as mipmapped textures, loaded off the render thread
+//
+// Acquire names a file; the texture is a 1x1 black placeholder until its load is done.
+// A load goes back and forth between the loader threads and the render thread so no
+// frame waits on the disk, the decoder or a large upload:
+//
+//   loader  maps the file (MapFileReadOnly) and reads the header;
+//   render  allocates a pixel unpack buffer of the decoded size and maps it;
+//   loader  decodes (image_read.h) straight into the mapping, bottom row first;
+//   render  unmaps it, glTexImage2D from the buffer, glGenerateMipmap.
+//
+// Entries stay resident after their last Release, so a shader or parameter reload
+// that asks for the same file again is a hit. Unreferenced ones are evicted least
+// recently used first whenever the resident total is over the byte budget (4/3 of
+// width * height * 4 with mipmaps). Acquiring a file whose write time changed since
+// it was loaded reloads it; the old texture stays bound until the new one is ready.
+
+#ifndef SHADERDEVEL_TEXTURE_CACHE_H
+#define SHADERDEVEL_TEXTURE_CACHE_H
+
+#include "platform.h"
+#include <glad/gl.h>
+
+#define TEXTURE_CACHE_MAX_ENTRIES    64
+#define TEXTURE_CACHE_DEFAULT_BUDGET ((size_t)256 << 20)
+
+typedef struct {
+    char   path[APP_PATH_MAX];
+    bool   ok;
+    int    width, height;
+    double load_ms;   // Acquire -> texture ready
+    double decode_ms; // loader time: header, decode (includes page faults on the file)
+    char   error[160];
+} TextureLoadEvent;
+
+typedef struct {
+    int    entries;        // cached, resident or not
+    int    loading;
+    size_t resident_bytes;
+    size_t budget_bytes;
+    int    loads, hits, failures, evictions; // since creation
+    double last_load_ms;
+    double total_load_ms;
+} TextureCacheStats;
+
+typedef struct TextureCache TextureCache;
+
+// Needs a current context; budget 0 means TEXTURE_CACHE_DEFAULT_BUDGET. NULL when out of
+// memory; every call below accepts that NULL and treats each image as missing.
+TextureCache* TextureCacheCreate(size_t budget_bytes);
+void          TextureCacheDestroy(TextureCache* c);
+// fn(user) runs on a loader thread when the render thread has work: see FrameSchedulerNotify.
+void          TextureCacheSetNotify(TextureCache* c, void (*fn)(void* user), void* user);
+
+// Handle of path's entry with one more reference, loading it if it isn't cached (or
+// changed on disk); -1 if every entry is referenced. Release drops the reference.
+int    TextureCacheAcquire(TextureCache* c, const char* path);
+void   TextureCacheRelease(TextureCache* c, int handle);
+// The texture to bind for handle (the placeholder until loaded, or on failure).
+// Size 0x0 until loaded; w and h may be NULL.
+GLuint TextureCacheTexture(TextureCache* c, int handle, int* w, int* h);
+const char* TextureCachePath(const TextureCache* c, int handle);
+
+// Render thread, once per iteration: advances loads and evicts. Fills ev with up to
+// max loads that finished since the last call; returns how many.
+int    TextureCacheUpdate(TextureCache* c, TextureLoadEvent* ev, int max);
+// Runs Update until no load is in flight (startup of benchmarks and offline renders).
+// The finished loads are still reported by the next Update.
+void   TextureCacheFinish(TextureCache* c);
+void   TextureCacheGetStats(const TextureCache* c, TextureCacheStats* out);
+
+#endif // SHADERDEVEL_TEXTURE_CACHE_H
@@ -0,0 +1,302 @@
+// uniforms.c — see uniforms.h
+#include "uniforms.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(sizeof(FrameInputs) == 64, "FrameInputs must match the std140 block");
+
+// ============================ Frame block ==========================
+struct FrameUniforms {
+    GLuint   buffer;
+    GLsizeiptr stride;          // sizeof(FrameInputs) rounded up to the offset alignment
+    uint8_t* mapped;            // persistent mapping, NULL on the glBufferSubData path
+    GLsync   fence[FRAME_UNIFORM_RING];
+    int      slot;              // slot written by the current frame
+};
+
+FrameUniforms* FrameUniformsCreate(void) {
+    FrameUniforms* u = (FrameUniforms*)calloc(1, sizeof(FrameUniforms));
+    if (!u) return NULL;
+    GLint align = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+    if (align < 1) align = 256;
+    u->stride = ((GLsizeiptr)sizeof(FrameInputs) + align - 1) / align * align;
+    u->slot = FRAME_UNIFORM_RING - 1;
+
+    GLsizeiptr size = u->stride * FRAME_UNIFORM_RING;
+    glGenBuffers(1, &u->buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, u->buffer);
+    if (GLAD_GL_ARB_buffer_storage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_UNIFORM_BUFFER, size, NULL, flags);
+        u->mapped = (uint8_t*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags);
+    }
+    if (!u->mapped) {
+        // No buffer storage, or mapping refused: a plain buffer updated in place.
+        glDeleteBuffers(1, &u->buffer);
+        glGenBuffers(1, &u->buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, u->buffer);
+        glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    return u;
+}
+
+void FrameUniformsDestroy(FrameUniforms* u) {
+    if (!u) return;
+    for (int i = 0; i < FRAME_UNIFORM_RING; ++i) if (u->fence[i]) glDeleteSync(u->fence[i]);
+    if (u->mapped) {
+        glBindBuffer(GL_UNIFORM_BUFFER, u->buffer);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &u->buffer);
+    free(u);
+}
+
+bool FrameUniformsPersistent(const FrameUniforms* u) { return u->mapped != NULL; }
+
+void FrameUniformsUpload(FrameUniforms* u, const FrameInputs* in) {
+    u->slot = (u->slot + 1) % FRAME_UNIFORM_RING;
+    GLintptr offset = u->stride * u->slot;
+    if (u->mapped) {
+        GLsync f = u->fence[u->slot];
+        if (f) {
+            // Normally long signalled; only a GPU three frames behind blocks here.
+            while (glClientWaitSync(f, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull) == GL_TIMEOUT_EXPIRED) {}
+            glDeleteSync(f);
+            u->fence[u->slot] = NULL;
+        }
+        memcpy(u->mapped + offset, in, sizeof(*in));
+    } else {
+        glBindBuffer(GL_UNIFORM_BUFFER, u->buffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, offset, sizeof(*in), in);
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_INPUTS_BINDING, u->buffer, offset, sizeof(*in));
+}
+
+void FrameUniformsFence(FrameUniforms* u) {
+    if (!u->mapped) return;
+    if (u->fence[u->slot]) glDeleteSync(u->fence[u->slot]);
+    u->fence[u->slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// ============================ Reflection ===========================
+// Samplers and images: bound to units, never set from the parameter file.
+static bool IsOpaqueType(GLenum type) {
+    switch (type) {
+    case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_2D_RECT:
+    case GL_SAMPLER_BUFFER: case GL_SAMPLER_2D_MULTISAMPLE:
+    case GL_INT_SAMPLER_2D: case GL_INT_SAMPLER_3D: case GL_INT_SAMPLER_2D_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_3D: case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+    case GL_IMAGE_2D: case GL_IMAGE_3D: case GL_IMAGE_2D_ARRAY: case GL_IMAGE_BUFFER:
+    case GL_INT_IMAGE_2D: case GL_UNSIGNED_INT_IMAGE_2D:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool IsBuiltinName(const char* name) {
+    return !strcmp(name, "uTime") || !strcmp(name, "uResolution") || !strcmp(name, "uMouse") ||
+           !strcmp(name, "iChannelResolution");
+}
+
+int ReflectUserUniforms(GLuint prog, UserUniforms* out) {
+    out->count = 0;
+    GLint active = 0;
+    glGetProgramiv(prog, GL_ACTIVE_UNIFORMS, &active);
+    for (GLuint i = 0; i < (GLuint)active && out->count < USER_UNIFORM_MAX; ++i) {
+        GLint block = -1;
+        glGetActiveUniformsiv(prog, 1, &i, GL_UNIFORM_BLOCK_INDEX, &block);
+        if (block >= 0) continue;
+        UserUniform* uu = &out->u[out->count];
+        GLsizei len = 0;
+        glGetActiveUniform(prog, i, (GLsizei)sizeof(uu->name), &len, &uu->size, &uu->type, uu->name);
+        char* bracket = strchr(uu->name, '[');
+        if (bracket) *bracket = 0; // arrays are reported as "name[0]"
+        if (IsOpaqueType(uu->type) || IsBuiltinName(uu->name) || !strncmp(uu->name, "gl_", 3)) continue;
+        uu->location = glGetUniformLocation(prog, uu->name);
+        if (uu->location >= 0) out->count++;
+    }
+    return out->count;
+}
+
+const char* UniformTypeName(GLenum type) {
+    switch (type) {
+    case GL_FLOAT:             return "float";
+    case GL_FLOAT_VEC2:        return "vec2";
+    case GL_FLOAT_VEC3:        return "vec3";
+    case GL_FLOAT_VEC4:        return "vec4";
+    case GL_INT:               return "int";
+    case GL_INT_VEC2:          return "ivec2";
+    case GL_INT_VEC3:          return "ivec3";
+    case GL_INT_VEC4:          return "ivec4";
+    case GL_UNSIGNED_INT:      return "uint";
+    case GL_UNSIGNED_INT_VEC2: return "uvec2";
+    case GL_UNSIGNED_INT_VEC3: return "uvec3";
+    case GL_UNSIGNED_INT_VEC4: return "uvec4";
+    case GL_BOOL:              return "bool";
+    case GL_BOOL_VEC2:         return "bvec2";
+    case GL_BOOL_VEC3:         return "bvec3";
+    case GL_BOOL_VEC4:         return "bvec4";
+    case GL_FLOAT_MAT2:        return "mat2";
+    case GL_FLOAT_MAT3:        return "mat3";
+    case GL_FLOAT_MAT4:        return "mat4";
+    default:                   return "?";
+    }
+}
+
+// ============================ Parameters ===========================
+// "iChannelN" -> N, else -1.
+static int ChannelIndex(const char* name) {
+    if (strncmp(name, "iChannel", 8) || name[8] < '0' || name[8] >= '0' + USER_CHANNELS || name[9]) return -1;
+    return name[8] - '0';
+}
+
+bool LoadUserParams(const char* path, UserParams* out, char* log, int logsz) {
+    log[0] = 0;
+    char* text = NULL; size_t size = 0;
+    if (!ReadFileUTF8(path, &text, &size)) { snprintf(log, logsz, "Failed to read parameter file %s.", path); return false; }
+
+    UserParams* next = (UserParams*)calloc(1, sizeof(UserParams));
+    if (!next) { free(text); snprintf(log, logsz, "Out of memory reading %s.", path); return false; }
+    snprintf(next->path, sizeof(next->path), "%s", path);
+    bool ok = true;
+    int lineno = 0;
+    for (char* line = text; ok && line; ) {
+        char* nl = strchr(line, '\n');
+        if (nl) *nl = 0;
+        ++lineno;
+        char* hash = strchr(line, '#');
+        if (hash) *hash = 0;
+        char* eq = strchr(line, '=');
+        char* name = line;
+        while (isspace((unsigned char)*name)) ++name;
+        if (!*name) { line = nl ? nl + 1 : NULL; continue; }
+        if (!eq) { snprintf(log, logsz, "%s:%d: expected 'name = values'", path, lineno); ok = false; break; }
+        *eq = 0;
+        for (char* e = eq - 1; e >= name && isspace((unsigned char)*e); --e) *e = 0;
+        int ch = ChannelIndex(name);
+        if (ch >= 0) {
+            char* file = eq + 1;
+            while (isspace((unsigned char)*file)) ++file;
+            for (char* e = file + strlen(file) - 1; e >= file && isspace((unsigned char)*e); --e) *e = 0;
+            if (!*file) { snprintf(log, logsz, "%s:%d: expected an image file after '='", path, lineno); ok = false; break; }
+            // Relative to the parameter file, like render graph paths.
+            const char* slash = NULL;
+            for (const char* s = path; *s; ++s) if (*s == '/' || *s == '\\') slash = s;
+            bool absolute = file[0] == '/' || file[0] == '\\' || (file[0] && file[1] == ':');
+            int dir = slash && !absolute ? (int)(slash - path) + 1 : 0;
+            snprintf(next->channel[ch], sizeof(next->channel[ch]), "%.*s%s", dir, path, file);
+            line = nl ? nl + 1 : NULL;
+            continue;
+        }
+        if (next->count == USER_PARAM_MAX || !*name || strlen(name) >= sizeof(next->p[0].name)) {
+            snprintf(log, logsz, "%s:%d: bad name or more than %d parameters", path, lineno, USER_PARAM_MAX);
+            ok = false; break;
+        }
+        UserParam* p = &next->p[next->count++];
+        snprintf(p->name, sizeof(p->name), "%s", name);
+        char* s = eq + 1;
+        for (;;) {
+            char* end = NULL;
+            float v = strtof(s, &end);
+            if (end == s) break;
+            if (p->count == USER_PARAM_VALUES) { snprintf(log, logsz, "%s:%d: more than %d values", path, lineno, USER_PARAM_VALUES); ok = false; break; }
+            p->v[p->count++] = v;
+            s = end;
+        }
+        while (ok && isspace((unsigned char)*s)) ++s;
+        if (ok && (*s || p->count == 0)) { snprintf(log, logsz, "%s:%d: expected numbers after '='", path, lineno); ok = false; }
+        line = nl ? nl + 1 : NULL;
+    }
+    free(text);
+    if (ok) *out = *next;
+    free(next);
+    return ok;
+}
+
+static int ComponentCount(GLenum type) {
+    switch (type) {
+    case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_UNSIGNED_INT_VEC2: case GL_BOOL_VEC2: return 2;
+    case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_UNSIGNED_INT_VEC3: case GL_BOOL_VEC3: return 3;
+    case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_UNSIGNED_INT_VEC4: case GL_BOOL_VEC4: case GL_FLOAT_MAT2: return 4;
+    case GL_FLOAT_MAT3: return 9;
+    case GL_FLOAT_MAT4: return 16;
+    default: return 1;
+    }
+}
+
+// Missing trailing components stay 0; extra values fill further array elements.
+static void SetUniform(const UserUniform* uu, const UserParam* p) {
+    int comps = ComponentCount(uu->type);
+    int n = (p->count + comps - 1) / comps;
+    if (n > uu->size) n = uu->size;
+    float f[USER_PARAM_VALUES] = {0};
+    GLint i[USER_PARAM_VALUES] = {0};
+    GLuint ui[USER_PARAM_VALUES] = {0};
+    for (int k = 0; k < p->count; ++k) { f[k] = p->v[k]; i[k] = (GLint)p->v[k]; ui[k] = p->v[k] > 0.f ? (GLuint)p->v[k] : 0u; }
+    switch (uu->type) {
+    case GL_FLOAT:      glUniform1fv(uu->location, n, f); break;
+    case GL_FLOAT_VEC2: glUniform2fv(uu->location, n, f); break;
+    case GL_FLOAT_VEC3: glUniform3fv(uu->location, n, f); break;
+    case GL_FLOAT_VEC4: glUniform4fv(uu->location, n, f); break;
+    case GL_INT: case GL_BOOL:           glUniform1iv(uu->location, n, i); break;
+    case GL_INT_VEC2: case GL_BOOL_VEC2: glUniform2iv(uu->location, n, i); break;
+    case GL_INT_VEC3: case GL_BOOL_VEC3: glUniform3iv(uu->location, n, i); break;
+    case GL_INT_VEC4: case GL_BOOL_VEC4: glUniform4iv(uu->location, n, i); break;
+    case GL_UNSIGNED_INT:      glUniform1uiv(uu->location, n, ui); break;
+    case GL_UNSIGNED_INT_VEC2: glUniform2uiv(uu->location, n, ui); break;
+    case GL_UNSIGNED_INT_VEC3: glUniform3uiv(uu->location, n, ui); break;
+    case GL_UNSIGNED_INT_VEC4: glUniform4uiv(uu->location, n, ui); break;
+    case GL_FLOAT_MAT2: glUniformMatrix2fv(uu->location, n, GL_FALSE, f); break;
+    case GL_FLOAT_MAT3: glUniformMatrix3fv(uu->location, n, GL_FALSE, f); break;
+    case GL_FLOAT_MAT4: glUniformMatrix4fv(uu->location, n, GL_FALSE, f); break;
+    default: break; // doubles etc.: not settable from the file
+    }
+}
+
+int ApplyUserParams(GLuint prog, const UserParams* params) {
+    if (!prog || !params || params->count == 0) return 0;
+    static UserUniforms reflected; // render thread only
+    if (ReflectUserUniforms(prog, &reflected) == 0) return 0;
+    glUseProgram(prog);
+    int applied = 0;
+    for (int k = 0; k < reflected.count; ++k) {
+        for (int j = 0; j < params->count; ++j) {
+            if (strcmp(reflected.u[k].name, params->p[j].name)) continue;
+            SetUniform(&reflected.u[k], &params->p[j]);
+            ++applied;
+            break;
+        }
+    }
+    return applied;
+}
+
+static UserParams* s_params = NULL;
+
+void        SetUserParams(UserParams* params) { s_params = params; }
+UserParams* GetUserParams(void) { return s_params; }
+
+bool SetupProgramUniforms(GLuint prog) {
+    ApplyUserParams(prog, s_params);
+    glUseProgram(prog);
+    for (int c = 0; c < USER_CHANNELS; ++c) {
+        char name[16];
+        snprintf(name, sizeof(name), "iChannel%d", c);
+        GLint loc = glGetUniformLocation(prog, name);
+        if (loc >= 0) glUniform1i(loc, c); // texture unit == channel
+    }
+    GLuint block = glGetUniformBlockIndex(prog, "FrameInputs");
+    if (block == GL_INVALID_INDEX) return false;
+    GLint size = 0;
+    glGetActiveUniformBlockiv(prog, block, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+    if (size > (GLint)sizeof(FrameInputs)) return false; // not our layout; leave it unbound
+    glUniformBlockBinding(prog, block, FRAME_INPUTS_BINDING);
+    return true;
+}
@@ -0,0 +1,117 @@
+// uniforms.h — per-frame shader inputs in one uniform block, plus file-driven user uniforms
+//
+// Built-in inputs live in a std140 block that shaders declare as
+//
+//   layout(std140) uniform FrameInputs {
+//       vec2  uResolution;   // render size in pixels
+//       vec2  uMouse;        // pixels, window coords (y down)
+//       vec4  uDate;         // year, month (1-12), day, seconds since local midnight
+//       float uTime;         // seconds, frozen while paused
+//       float uTimeDelta;    // wall seconds since the previous frame
+//       int   uFrame;        // frames rendered since start
+//       int   uMouseButtons; // bit 0 left, 1 right, 2 middle
+//       vec2  uTileOffset;   // tile origin in uResolution when an offline render
+//                            // draws in tiles (gl_FragCoord.xy + uTileOffset), else 0
+//       vec2  uJitter;       // subpixel offset of this sample while a paused still
+//   };                       // accumulates (gl_FragCoord.xy + uJitter), else 0
+//
+// The block is written once per frame into a ring of FRAME_UNIFORM_RING slots of one
+// buffer: persistently mapped (ARB_buffer_storage) with a fence per slot, else
+// glBufferSubData. Every program shares it through binding FRAME_INPUTS_BINDING, so
+// adding an input means a member here and nothing per program. Loose uTime,
+// uResolution and uMouse uniforms still work for older shaders.
+//
+// Any other non-sampler uniform a program declares is a user uniform, found by
+// reflection after each build and set from an optional parameter file:
+//
+//   # name = values (float or int, as many as the type has components)
+//   uSpeed = 1.5
+//   uTint  = 1.0 0.4 0.2
+//   iChannel0 = textures/noise.png   # an image for sampler iChannel0, relative to this file
+//
+// Samplers iChannel0..3 read texture units 0..3; uniform vec3 iChannelResolution[4]
+// gets their sizes (texture_cache.h loads the images).
+
+#ifndef SHADERDEVEL_UNIFORMS_H
+#define SHADERDEVEL_UNIFORMS_H
+
+#include "platform.h"
+#include <glad/gl.h>
+
+#define FRAME_INPUTS_BINDING 0
+#define FRAME_UNIFORM_RING   3
+#define USER_UNIFORM_MAX     64
+#define USER_PARAM_MAX       64
+#define USER_PARAM_VALUES    16 // enough for a mat4
+#define USER_CHANNELS        4
+
+// Mirror of the GLSL block above; std140 offsets 0, 8, 16, 32, 36, 40, 44, 48, 56.
+// A shader may declare a shorter prefix of it.
+typedef struct {
+    float   resolution[2];
+    float   mouse[2];
+    float   date[4];
+    float   time;
+    float   time_delta;
+    int32_t frame;
+    int32_t mouse_buttons;
+    float   tile_offset[2];
+    float   jitter[2];
+} FrameInputs;
+
+typedef struct FrameUniforms FrameUniforms;
+
+// Needs a current context. NULL when out of memory; frames then set only the loose uniforms.
+FrameUniforms* FrameUniformsCreate(void);
+void           FrameUniformsDestroy(FrameUniforms* u);
+bool           FrameUniformsPersistent(const FrameUniforms* u);
+// Writes this frame's slot (waiting only if the GPU still reads it, three frames on)
+// and binds it to FRAME_INPUTS_BINDING.
+void           FrameUniformsUpload(FrameUniforms* u, const FrameInputs* in);
+// After the frame's last draw that reads the block: fences the slot.
+void           FrameUniformsFence(FrameUniforms* u);
+
+typedef struct {
+    char   name[64];
+    GLenum type;
+    GLint  size;     // array length, 1 for non-arrays
+    GLint  location;
+} UserUniform;
+
+typedef struct {
+    UserUniform u[USER_UNIFORM_MAX];
+    int         count;
+} UserUniforms;
+
+// Active default-block uniforms minus samplers, block members and the loose built-ins.
+int         ReflectUserUniforms(GLuint prog, UserUniforms* out);
+const char* UniformTypeName(GLenum type);
+
+typedef struct {
+    char  name[64];
+    float v[USER_PARAM_VALUES];
+    int   count;
+} UserParam;
+
+typedef struct {
+    char      path[APP_PATH_MAX];
+    UserParam p[USER_PARAM_MAX];
+    int       count;
+    char      channel[USER_CHANNELS][APP_PATH_MAX]; // image files, "" = unbound
+} UserParams;
+
+// Parses a parameter file; on error keeps *out unchanged and logs "file:line: reason".
+bool LoadUserParams(const char* path, UserParams* out, char* log, int logsz);
+// Sets every reflected uniform the params name (leaves prog current). Returns how many.
+int  ApplyUserParams(GLuint prog, const UserParams* params);
+
+// Parameters applied to every program built from now on; NULL for none. Front end owned.
+void        SetUserParams(UserParams* params);
+UserParams* GetUserParams(void);
+
+// Run on every freshly built program: binds FrameInputs if declared, points the
+// iChannelN samplers at unit N and applies the user params. True if the program
+// reads the block.
+bool SetupProgramUniforms(GLuint prog);
+
+#endif // SHADERDEVEL_UNIFORMS_H
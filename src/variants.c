@@ -0,0 +1,298 @@
+// variants.c — see variants.h
+#include "variants.h"
+#include "app.h"
+#include "image_read.h"
+#include "render_target.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================ Sidecar ==============================
+bool LoadVariantSpace(const char* path, VariantSpace* out, char* log, int logsz) {
+    log[0] = 0;
+    char* text = NULL; size_t size = 0;
+    if (!ReadFileUTF8(path, &text, &size)) { snprintf(log, logsz, "Failed to read variant file %s.", path); return false; }
+
+    VariantSpace* next = (VariantSpace*)calloc(1, sizeof(VariantSpace));
+    snprintf(next->path, sizeof(next->path), "%s", path);
+    bool ok = true;
+    int lineno = 0;
+    for (char* line = text; ok && line; ) {
+        char* nl = strchr(line, '\n');
+        if (nl) *nl = 0;
+        ++lineno;
+        char* hash = strchr(line, '#');
+        if (hash) *hash = 0;
+        char* eq = strchr(line, '=');
+        char* name = line;
+        while (isspace((unsigned char)*name)) ++name;
+        if (!*name) { line = nl ? nl + 1 : NULL; continue; }
+        if (!eq) { snprintf(log, logsz, "%s:%d: expected 'NAME = values'", path, lineno); ok = false; break; }
+        *eq = 0;
+        for (char* e = eq - 1; e >= name && isspace((unsigned char)*e); --e) *e = 0;
+        int a = next->axis_count;
+        ShaderDefines probe = { 0 };
+        if (a == VARIANT_MAX_AXES || !AddShaderDefine(&probe, name, "")) {
+            snprintf(log, logsz, "%s:%d: bad name or more than %d axes", path, lineno, VARIANT_MAX_AXES);
+            ok = false; break;
+        }
+        for (int j = 0; j < a; ++j)
+            if (!strcmp(next->name[j], name)) { snprintf(log, logsz, "%s:%d: %s is declared twice", path, lineno, name); ok = false; }
+        if (!ok) break;
+        snprintf(next->name[a], sizeof(next->name[a]), "%s", name);
+        next->reference[a] = -1;
+        for (char* tok = strtok(eq + 1, " \t\r"); tok && ok; tok = strtok(NULL, " \t\r")) {
+            bool mark = *tok == '*';
+            if (mark) ++tok;
+            int* n = &next->value_count[a];
+            if (!*tok || *n == VARIANT_MAX_VALUES || strlen(tok) >= sizeof(next->value[a][0])) {
+                snprintf(log, logsz, "%s:%d: empty or overlong value, or more than %d values", path, lineno, VARIANT_MAX_VALUES);
+                ok = false; break;
+            }
+            if (mark) {
+                if (next->reference[a] >= 0) { snprintf(log, logsz, "%s:%d: more than one value marked *", path, lineno); ok = false; break; }
+                next->reference[a] = *n;
+                next->has_reference = true;
+            }
+            snprintf(next->value[a][(*n)++], sizeof(next->value[a][0]), "%s", tok);
+        }
+        if (ok && next->value_count[a] == 0) { snprintf(log, logsz, "%s:%d: expected values after '='", path, lineno); ok = false; }
+        next->axis_count++;
+        line = nl ? nl + 1 : NULL;
+    }
+    if (ok && next->axis_count == 0) { snprintf(log, logsz, "%s: no axes declared", path); ok = false; }
+    for (int a = 0; ok && a < next->axis_count; ++a)
+        if (next->reference[a] < 0) next->reference[a] = next->value_count[a] - 1;
+    if (ok && VariantCount(next) > VARIANT_MAX) {
+        snprintf(log, logsz, "%s: %d permutations, at most %d per run", path, VariantCount(next), VARIANT_MAX);
+        ok = false;
+    }
+    free(text);
+    if (ok) *out = *next;
+    free(next);
+    return ok;
+}
+
+int VariantCount(const VariantSpace* s) {
+    int n = 1;
+    for (int a = 0; a < s->axis_count; ++a) {
+        n *= s->value_count[a];
+        if (n > VARIANT_MAX) return VARIANT_MAX + 1; // 16^16 would overflow
+    }
+    return n;
+}
+
+void VariantDefines(const VariantSpace* s, int index, ShaderDefines* out) {
+    out->count = 0;
+    int value[VARIANT_MAX_AXES];
+    for (int a = s->axis_count - 1; a >= 0; --a) {
+        value[a] = index % s->value_count[a];
+        index /= s->value_count[a];
+    }
+    for (int a = 0; a < s->axis_count; ++a) AddShaderDefine(out, s->name[a], s->value[a][value[a]]);
+}
+
+void LocalSizeVariantSpace(VariantSpace* out) {
+    static const char* xs[] = { "4", "8", "16", "32", "64" };
+    static const char* ys[] = { "1", "2", "4", "8", "16" };
+    memset(out, 0, sizeof(*out));
+    snprintf(out->path, sizeof(out->path), "local size sweep");
+    out->axis_count = 2;
+    snprintf(out->name[0], sizeof(out->name[0]), "LOCAL_SIZE_X");
+    snprintf(out->name[1], sizeof(out->name[1]), "LOCAL_SIZE_Y");
+    for (int i = 0; i < 5; ++i) {
+        snprintf(out->value[0][i], sizeof(out->value[0][i]), "%s", xs[i]);
+        snprintf(out->value[1][i], sizeof(out->value[1][i]), "%s", ys[i]);
+    }
+    out->value_count[0] = out->value_count[1] = 5;
+    out->reference[0] = 1; // 8x8, the default
+    out->reference[1] = 3;
+    out->has_reference = true;
+}
+
+int VariantReferenceIndex(const VariantSpace* s) {
+    if (!s->has_reference) return -1;
+    int index = 0;
+    for (int a = 0; a < s->axis_count; ++a) index = index * s->value_count[a] + s->reference[a];
+    return index;
+}
+
+// ============================= Tuning ==============================
+// First line of a build log, for the ranked table.
+static void FirstLine(const char* log, char* out, size_t outsz) {
+    size_t n = strcspn(log, "\r\n");
+    if (n >= outsz) n = outsz - 1;
+    memcpy(out, log, n);
+    out[n] = 0;
+}
+
+// A compute variant that defines LOCAL_SIZE_X/Y must have been built at that size;
+// a shader with a literal local size would otherwise rank copies of itself.
+static bool LocalSizeFollows(GLuint prog, const ShaderDefines* d, char* error, size_t errorsz) {
+    GLint size[3] = { 1, 1, 1 };
+    glGetProgramiv(prog, GL_COMPUTE_WORK_GROUP_SIZE, size);
+    for (int i = 0; i < d->count; ++i) {
+        int axis = !strcmp(d->name[i], "LOCAL_SIZE_X") ? 0 : !strcmp(d->name[i], "LOCAL_SIZE_Y") ? 1 : -1;
+        if (axis < 0 || atoi(d->value[i]) == size[axis]) continue;
+        snprintf(error, errorsz, "local size is %dx%d; declare layout(local_size_x = LOCAL_SIZE_X, local_size_y = LOCAL_SIZE_Y) in;",
+                 size[0], size[1]);
+        return false;
+    }
+    return true;
+}
+
+// Every fragment (or compute) stage and link is issued before the first status query;
+// only the queries wait, by which time a parallel driver has had all of them in flight.
+static bool BuildVariants(TuneResult* out, GLuint* progs, char* log, int logsz) {
+    ShaderFileTable* files = (ShaderFileTable*)malloc(2 * sizeof(ShaderFileTable));
+    char *vsrc = NULL, *fsrc = NULL;
+    if (!files || !LoadShaderSourcesEx(g_app.vert_path, g_app.frag_path, NULL, &vsrc, &fsrc, files, log, logsz)) {
+        free(files);
+        return false;
+    }
+    bool compute = vsrc == NULL;
+    out->parallel = GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile;
+    if (GLAD_GL_KHR_parallel_shader_compile) glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+    else if (GLAD_GL_ARB_parallel_shader_compile) glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+
+    double t0 = NowSeconds();
+    GLuint vs = compute ? 0 : CompileShader(GL_VERTEX_SHADER, vsrc, log, logsz);
+    bool ok = compute || vs != 0;
+    GLuint* fs = (GLuint*)calloc((size_t)out->count, sizeof(GLuint));
+    if (!ok) MapBuildLog(files, GL_VERTEX_SHADER, log, logsz);
+    else if (!fs) { snprintf(log, logsz, "Out of memory."); ok = false; }
+    for (int i = 0; ok && i < out->count; ++i) {
+        char* src = InsertShaderDefines(fsrc, &out->v[i].defines);
+        if (!src) { snprintf(log, logsz, "Out of memory."); ok = false; break; }
+        fs[i] = glCreateShader(compute ? GL_COMPUTE_SHADER : GL_FRAGMENT_SHADER);
+        glShaderSource(fs[i], 1, (const GLchar* const*)&src, NULL);
+        glCompileShader(fs[i]);
+        free(src);
+        progs[i] = glCreateProgram();
+        if (vs) glAttachShader(progs[i], vs);
+        glAttachShader(progs[i], fs[i]);
+        glLinkProgram(progs[i]);
+    }
+    static char build_log[COMPILE_LOG_SIZE];
+    for (int i = 0; ok && i < out->count; ++i) {
+        GLint linked = 0, compiled = 0;
+        glGetProgramiv(progs[i], GL_LINK_STATUS, &linked);
+        out->v[i].ok = linked != 0;
+        if (!linked) {
+            glGetShaderiv(fs[i], GL_COMPILE_STATUS, &compiled);
+            build_log[0] = 0;
+            if (compiled) glGetProgramInfoLog(progs[i], sizeof(build_log), NULL, build_log);
+            else glGetShaderInfoLog(fs[i], sizeof(build_log), NULL, build_log);
+            MapBuildLog(files, compiled ? 0 : compute ? GL_COMPUTE_SHADER : GL_FRAGMENT_SHADER, build_log, sizeof(build_log));
+            FirstLine(build_log[0] ? build_log : "Compile/link failed.", out->v[i].error, sizeof(out->v[i].error));
+            glDeleteProgram(progs[i]);
+            progs[i] = 0;
+        } else if (compute && !LocalSizeFollows(progs[i], &out->v[i].defines, out->v[i].error, sizeof(out->v[i].error))) {
+            out->v[i].ok = false;
+            glDeleteProgram(progs[i]);
+            progs[i] = 0;
+        }
+    }
+    out->compile_ms = (NowSeconds() - t0) * 1000.0;
+    for (int i = 0; fs && i < out->count; ++i) if (fs[i]) glDeleteShader(fs[i]); // freed with their programs
+    if (vs) glDeleteShader(vs);
+    free(fs);
+    free(vsrc);
+    free(fsrc);
+    free(files);
+    return ok;
+}
+
+// Median GPU time, or the wall time when there were no timer results.
+static double RankMs(const VariantResult* r) { return r->gpu.frames > 0 ? r->gpu.median_ms : r->wall.median_ms; }
+
+static int CompareResults(const void* pa, const void* pb) {
+    const VariantResult* a = (const VariantResult*)pa;
+    const VariantResult* b = (const VariantResult*)pb;
+    if (a->ok != b->ok) return a->ok ? -1 : 1;
+    double ka = a->ok ? RankMs(a) : 0.0, kb = b->ok ? RankMs(b) : 0.0;
+    return ka < kb ? -1 : ka > kb ? 1 : 0;
+}
+
+bool RunVariantTuning(const VariantSpace* space, const TuneOptions* opt, TuneResult* out, char* log, int logsz) {
+    memset(out, 0, sizeof(*out));
+    out->best = -1;
+    out->count = VariantCount(space);
+    out->v = (VariantResult*)calloc((size_t)out->count, sizeof(VariantResult));
+    GLuint* progs = (GLuint*)calloc((size_t)out->count, sizeof(GLuint));
+    size_t pixels = (size_t)opt->width * (size_t)opt->height;
+    int ref = VariantReferenceIndex(space);
+    uint8_t* image = (uint8_t*)malloc(pixels * 4);
+    uint8_t* ref_image = ref >= 0 ? (uint8_t*)malloc(pixels * 4) : NULL;
+    double* samples = (double*)malloc((size_t)(opt->frames > 0 ? opt->frames : 1) * sizeof(double));
+    RenderTarget rt = { 0 };
+    bool ok = out->v && progs && image && samples && (ref < 0 || ref_image);
+    if (!ok) snprintf(log, logsz, "Out of memory.");
+    for (int i = 0; ok && i < out->count; ++i) {
+        VariantDefines(space, i, &out->v[i].defines);
+        out->v[i].reference = i == ref;
+        out->v[i].psnr = -1.0;
+    }
+    ok = ok && BuildVariants(out, progs, log, logsz);
+    if (ok && !CreateRenderTarget(&rt, opt->width, opt->height, GL_RGBA8)) {
+        snprintf(log, logsz, "Could not create a %dx%d offscreen framebuffer.", opt->width, opt->height);
+        ok = false;
+    }
+
+    FrameInputs in;
+    memset(&in, 0, sizeof(in));
+    in.resolution[0] = (float)opt->width;
+    in.resolution[1] = (float)opt->height;
+    in.time = opt->time;
+    in.time_delta = 1.0f / 60.0f;
+    // The reference first, so every other image can be compared as soon as it is drawn.
+    for (int k = -1; ok && k < out->count; ++k) {
+        int i = k < 0 ? ref : k;
+        if (i < 0 || (k >= 0 && i == ref) || !progs[i]) continue;
+        VariantResult* r = &out->v[i];
+        ApplyProgram(progs[i]); // g_app owns it from here
+        progs[i] = 0;
+        glBindFramebuffer(GL_FRAMEBUFFER, rt.fbo);
+        for (int f = -opt->warmup_frames; f < opt->frames; ++f) {
+            if (f == 0 && g_app.gpu_timer) GpuTimerReset(g_app.gpu_timer);
+            double t0 = NowSeconds();
+            RenderRegion(&in, opt->width, opt->height);
+            glFinish();
+            if (f >= 0) samples[f] = (NowSeconds() - t0) * 1000.0;
+        }
+        ComputeFrameStats(samples, opt->frames, &r->wall);
+        if (g_app.gpu_timer) {
+            GpuTimerCollect(g_app.gpu_timer, true);
+            if (!GpuTimerGetStats(g_app.gpu_timer, &r->gpu)) memset(&r->gpu, 0, sizeof(r->gpu));
+        }
+        if (ref >= 0) {
+            glReadPixels(0, 0, opt->width, opt->height, GL_RGBA, GL_UNSIGNED_BYTE, i == ref ? ref_image : image);
+            if (i == ref) { r->psnr = INFINITY; r->max_diff = 0; }
+            else CompareImages(ref_image, image, pixels, &r->psnr, &r->max_diff);
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (rt.fbo) DestroyRenderTarget(&rt);
+    for (int i = 0; progs && i < out->count; ++i) if (progs[i]) glDeleteProgram(progs[i]);
+
+    if (ok) {
+        qsort(out->v, (size_t)out->count, sizeof(VariantResult), CompareResults);
+        for (int i = 0; i < out->count && out->best < 0; ++i) {
+            const VariantResult* r = &out->v[i];
+            if (r->ok && (opt->min_psnr <= 0.0 || ref < 0 || r->psnr >= opt->min_psnr)) out->best = i;
+        }
+    }
+    free(samples);
+    free(ref_image);
+    free(image);
+    free(progs);
+    return ok;
+}
+
+void FreeTuneResult(TuneResult* r) {
+    free(r->v);
+    memset(r, 0, sizeof(*r));
+}
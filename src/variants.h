@@ -0,0 +1,87 @@
+// variants.h — #define permutations of a fragment shader, benchmarked and ranked
+//
+// A sidecar file declares the axes, one per line:
+//
+//   # name = values, each pasted verbatim as "#define name value"
+//   MARCH_STEPS = 32 64 *128
+//   OCTAVES     = 3 4 5
+//
+// and every combination of values is a variant (9 here). Values marked * form the
+// reference variant (an axis without a mark uses its last value); when there is one,
+// every variant's image is compared against it.
+//
+// Tuning builds all variants at once, submitting every compile and link before
+// asking for any status, so a driver with KHR_parallel_shader_compile spreads them
+// over its threads. Then it draws each one for a fixed number of frames with fixed
+// inputs (FrameInputs at uTime = time, frame 0) and ranks them by median GPU time.
+// The winner is the fastest variant, or the fastest within min_psnr of the reference;
+// an interactive session runs it with --variant (SetShaderDefines).
+
+#ifndef SHADERDEVEL_VARIANTS_H
+#define SHADERDEVEL_VARIANTS_H
+
+#include "platform.h"
+#include "frame_stats.h"
+#include "shader.h"
+
+#define VARIANT_MAX_AXES   SHADER_MAX_DEFINES
+#define VARIANT_MAX_VALUES 16
+#define VARIANT_MAX        1024 // permutations per tuning run
+
+typedef struct {
+    char path[APP_PATH_MAX];
+    int  axis_count;
+    char name[VARIANT_MAX_AXES][64];
+    char value[VARIANT_MAX_AXES][VARIANT_MAX_VALUES][64];
+    int  value_count[VARIANT_MAX_AXES];
+    int  reference[VARIANT_MAX_AXES]; // value index
+    bool has_reference;               // some value was marked *
+} VariantSpace;
+
+// Parses a sidecar file; on error logs "file:line: reason" and leaves *out alone.
+bool LoadVariantSpace(const char* path, VariantSpace* out, char* log, int logsz);
+int  VariantCount(const VariantSpace* s);
+// The workgroup shapes of a compute shader (compute_pass.h): LOCAL_SIZE_X = 4 .. 64
+// by LOCAL_SIZE_Y = 1 .. 16 in powers of two, at most 1024 invocations (every GL 4.3
+// implementation's minimum), with the default 8x8 as the reference, so a shape that
+// changes the image (a shared-memory tiling bug) shows up in its PSNR.
+void LocalSizeVariantSpace(VariantSpace* out);
+// Variant index (0 .. VariantCount-1) as defines; the last axis varies fastest.
+void VariantDefines(const VariantSpace* s, int index, ShaderDefines* out);
+// -1 without a marked reference.
+int  VariantReferenceIndex(const VariantSpace* s);
+
+typedef struct {
+    int    width, height;
+    int    frames, warmup_frames; // per variant
+    float  time;                  // uTime of every frame
+    double min_psnr;              // dB against the reference the winner needs, 0 = none
+} TuneOptions;
+
+typedef struct {
+    ShaderDefines defines;
+    bool       reference;
+    bool       ok;
+    char       error[256];  // first log line when the build failed
+    FrameStats gpu;         // timer-query ms; frames 0 if there were no results
+    FrameStats wall;        // ms from the draw call to glFinish returning
+    double     psnr;        // against the reference in dB (INFINITY: identical), -1 = not compared
+    int        max_diff;    // largest channel difference to the reference, 0-255
+} VariantResult;
+
+typedef struct {
+    VariantResult* v;      // malloc'd; ranked fastest first, failed builds last
+    int    count;
+    int    best;           // index into v, -1 if nothing qualified
+    double compile_ms;     // submitting and finishing every build
+    bool   parallel;       // the driver compiles in parallel (KHR/ARB_parallel_shader_compile)
+} TuneResult;
+
+// Needs a current context with g_app.vao, g_app.gpu_timer and a program built from the
+// same vertex shader (or g_app.compute for a compute shader, whose variants must build
+// at the LOCAL_SIZE_X/Y they define); replaces g_app.program (the last variant drawn
+// stays current).
+bool RunVariantTuning(const VariantSpace* space, const TuneOptions* opt, TuneResult* out, char* log, int logsz);
+void FreeTuneResult(TuneResult* r);
+
+#endif // SHADERDEVEL_VARIANTS_H
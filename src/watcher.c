@@ -0,0 +1,359 @@
+// watcher.c — see watcher.h
+#include "watcher.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#define WATCHER_NAME_MAX 256
+
+typedef struct {
+    char       path[APP_PATH_MAX]; // directory, "." when the file had no directory part
+#ifdef _WIN32
+    HANDLE     handle;
+    HANDLE     event;
+    OVERLAPPED ov;
+    bool       armed;
+    DWORD      buffer[16384 / sizeof(DWORD)]; // DWORD aligned as ReadDirectoryChangesW requires
+#else
+    int        wd;
+#endif
+} WatchDir;
+
+typedef struct {
+    char             name[WATCHER_NAME_MAX]; // file name inside dirs[dir]
+    int              dir;
+    volatile int32_t changed;     // published to the render thread
+    bool             local_dirty; // watcher thread only, not yet published
+} WatchFile;
+
+struct FileWatcher {
+    Mutex            lock; // guards the dir/file tables while they grow
+    WatchDir         dirs[WATCHER_MAX_DIRS];
+    int              dir_count;
+    WatchFile        files[WATCHER_MAX_FILES];
+    int              file_count;
+
+    volatile int32_t pending;
+    double           pending_since; // first event of the published burst(s), under lock
+    volatile int32_t stop;
+    int              debounce_ms;
+    double           first_event; // watcher thread only
+    double           last_event;  // watcher thread only
+    bool             any_dirty;   // watcher thread only
+    Thread           thread;
+    void           (*notify)(void* user); // under lock
+    void*            notify_user;
+
+#ifdef _WIN32
+    HANDLE           wake_event;
+#else
+    int              inotify_fd;
+    int              wake_pipe[2];
+#endif
+};
+
+static void SplitPath(const char* path, char* dir, size_t dirsz, char* name, size_t namesz) {
+    const char* slash = NULL;
+    for (const char* p = path; *p; ++p) if (*p == '/' || *p == '\\') slash = p;
+    if (!slash) {
+        snprintf(dir, dirsz, ".");
+        snprintf(name, namesz, "%s", path);
+    } else if (slash == path) {
+        snprintf(dir, dirsz, "/");
+        snprintf(name, namesz, "%s", slash + 1);
+    } else {
+        snprintf(dir, dirsz, "%.*s", (int)(slash - path), path);
+        snprintf(name, namesz, "%s", slash + 1);
+    }
+}
+
+static bool NamesEqual(const char* a, const char* b) {
+#ifdef _WIN32
+    return _stricmp(a, b) == 0;
+#else
+    return strcmp(a, b) == 0;
+#endif
+}
+
+// ===================== Debounce (watcher thread) ===================
+// Caller holds w->lock.
+static void MarkDirty(FileWatcher* w, int dir, const char* name) {
+    for (int i = 0; i < w->file_count; ++i) {
+        WatchFile* f = &w->files[i];
+        if (f->dir != dir) continue;
+        if (name && !NamesEqual(f->name, name)) continue;
+        f->local_dirty = true;
+        w->last_event = NowSeconds();
+        if (!w->any_dirty) w->first_event = w->last_event;
+        w->any_dirty = true;
+    }
+}
+
+static void PublishIfQuiet(FileWatcher* w) {
+    if (!w->any_dirty) return;
+    if ((NowSeconds() - w->last_event) * 1000.0 < (double)w->debounce_ms) return;
+    MutexLock(&w->lock);
+    for (int i = 0; i < w->file_count; ++i) {
+        if (!w->files[i].local_dirty) continue;
+        w->files[i].local_dirty = false;
+        AtomicStore32(&w->files[i].changed, 1);
+    }
+    // An unconsumed earlier burst keeps its (earlier) start time.
+    if (!AtomicLoad32(&w->pending)) w->pending_since = w->first_event;
+    w->any_dirty = false;
+    AtomicStore32(&w->pending, 1);
+    if (w->notify) w->notify(w->notify_user);
+    MutexUnlock(&w->lock);
+}
+
+// Milliseconds until the current burst may be published, or -1 to wait forever.
+static int DebounceTimeoutMs(const FileWatcher* w) {
+    if (!w->any_dirty) return -1;
+    int left = w->debounce_ms - (int)((NowSeconds() - w->last_event) * 1000.0);
+    return left > 0 ? left : 0;
+}
+
+// ============================== Win32 ==============================
+#ifdef _WIN32
+
+#define WATCH_FILTER (FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE)
+
+static bool ArmDir(WatchDir* d) {
+    memset(&d->ov, 0, sizeof(d->ov));
+    d->ov.hEvent = d->event;
+    d->armed = ReadDirectoryChangesW(d->handle, d->buffer, sizeof(d->buffer), FALSE, WATCH_FILTER, NULL, &d->ov, NULL) != 0;
+    return d->armed;
+}
+
+static void HandleDirEvent(FileWatcher* w, int di) {
+    WatchDir* d = &w->dirs[di];
+    DWORD bytes = 0;
+    BOOL ok = GetOverlappedResult(d->handle, &d->ov, &bytes, FALSE);
+    MutexLock(&w->lock);
+    if (!ok || bytes == 0) {
+        // Buffer overflow (or error): we don't know what changed, assume everything in the dir did.
+        MarkDirty(w, di, NULL);
+    } else {
+        const BYTE* p = (const BYTE*)d->buffer;
+        for (;;) {
+            const FILE_NOTIFY_INFORMATION* fni = (const FILE_NOTIFY_INFORMATION*)p;
+            if (fni->Action == FILE_ACTION_MODIFIED || fni->Action == FILE_ACTION_ADDED ||
+                fni->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+                char name[WATCHER_NAME_MAX];
+                int n = WideCharToMultiByte(CP_UTF8, 0, fni->FileName, (int)(fni->FileNameLength / sizeof(WCHAR)),
+                                            name, WATCHER_NAME_MAX - 1, NULL, NULL);
+                if (n > 0) { name[n] = 0; MarkDirty(w, di, name); }
+            }
+            if (!fni->NextEntryOffset) break;
+            p += fni->NextEntryOffset;
+        }
+    }
+    MutexUnlock(&w->lock);
+    ArmDir(d);
+}
+
+static void WatcherThread(void* arg) {
+    FileWatcher* w = (FileWatcher*)arg;
+    HANDLE handles[1 + WATCHER_MAX_DIRS];
+    int    dir_of[1 + WATCHER_MAX_DIRS];
+    while (!AtomicLoad32(&w->stop)) {
+        // Overlapped reads are owned by the thread that issued them, so newly
+        // added directories are armed here rather than in FileWatcherAddFile.
+        int n = 0;
+        handles[n] = w->wake_event; dir_of[n++] = -1;
+        MutexLock(&w->lock);
+        for (int i = 0; i < w->dir_count; ++i) {
+            WatchDir* d = &w->dirs[i];
+            if (!d->armed && !ArmDir(d)) continue;
+            handles[n] = d->event; dir_of[n++] = i;
+        }
+        MutexUnlock(&w->lock);
+
+        int timeout = DebounceTimeoutMs(w);
+        DWORD r = WaitForMultipleObjects((DWORD)n, handles, FALSE, timeout < 0 ? INFINITE : (DWORD)timeout);
+        if (AtomicLoad32(&w->stop)) break;
+        if (r >= WAIT_OBJECT_0 && r < WAIT_OBJECT_0 + (DWORD)n) {
+            int di = dir_of[r - WAIT_OBJECT_0];
+            if (di >= 0) HandleDirEvent(w, di);
+        }
+        PublishIfQuiet(w);
+    }
+}
+
+static bool OpenDir(FileWatcher* w, WatchDir* d) {
+    (void)w;
+    WCHAR wpath[APP_PATH_MAX];
+    if (!MultiByteToWideChar(CP_UTF8, 0, d->path, -1, wpath, APP_PATH_MAX)) return false;
+    d->handle = CreateFileW(wpath, FILE_LIST_DIRECTORY, FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE,
+                            NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (d->handle == INVALID_HANDLE_VALUE) return false;
+    d->event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    d->armed = false;
+    return true;
+}
+
+static void CloseDir(WatchDir* d) {
+    if (d->armed) {
+        DWORD bytes = 0;
+        CancelIoEx(d->handle, &d->ov);
+        GetOverlappedResult(d->handle, &d->ov, &bytes, TRUE);
+    }
+    CloseHandle(d->event);
+    CloseHandle(d->handle);
+}
+
+static bool PlatformInit(FileWatcher* w) {
+    w->wake_event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    return w->wake_event != NULL;
+}
+static void PlatformWake(FileWatcher* w) { SetEvent(w->wake_event); }
+static void PlatformShutdown(FileWatcher* w) { CloseHandle(w->wake_event); }
+
+// ============================== Linux ==============================
+#else
+
+#define WATCH_MASK (IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE)
+
+static void DrainInotify(FileWatcher* w) {
+    char buf[8192] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for (;;) {
+        ssize_t len = read(w->inotify_fd, buf, sizeof(buf));
+        if (len <= 0) break;
+        MutexLock(&w->lock);
+        for (char* p = buf; p < buf + len; ) {
+            const struct inotify_event* ev = (const struct inotify_event*)p;
+            if (ev->mask & IN_Q_OVERFLOW) {
+                for (int i = 0; i < w->dir_count; ++i) MarkDirty(w, i, NULL);
+            } else if (ev->len > 0) {
+                for (int i = 0; i < w->dir_count; ++i)
+                    if (w->dirs[i].wd == ev->wd) MarkDirty(w, i, ev->name);
+            }
+            p += sizeof(struct inotify_event) + ev->len;
+        }
+        MutexUnlock(&w->lock);
+    }
+}
+
+static void WatcherThread(void* arg) {
+    FileWatcher* w = (FileWatcher*)arg;
+    while (!AtomicLoad32(&w->stop)) {
+        struct pollfd fds[2] = {
+            { w->inotify_fd,   POLLIN, 0 },
+            { w->wake_pipe[0], POLLIN, 0 },
+        };
+        int r = poll(fds, 2, DebounceTimeoutMs(w));
+        if (AtomicLoad32(&w->stop)) break;
+        if (r < 0 && errno != EINTR) break;
+        if (r > 0 && (fds[0].revents & POLLIN)) DrainInotify(w);
+        if (r > 0 && (fds[1].revents & POLLIN)) { char c[16]; while (read(w->wake_pipe[0], c, sizeof(c)) > 0) {} }
+        PublishIfQuiet(w);
+    }
+}
+
+static bool OpenDir(FileWatcher* w, WatchDir* d) {
+    d->wd = inotify_add_watch(w->inotify_fd, d->path, WATCH_MASK);
+    return d->wd >= 0;
+}
+static void CloseDir(WatchDir* d) { (void)d; } // watches go away with the inotify fd
+
+static bool PlatformInit(FileWatcher* w) {
+    w->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (w->inotify_fd < 0) return false;
+    if (pipe2(w->wake_pipe, O_NONBLOCK | O_CLOEXEC) != 0) { close(w->inotify_fd); return false; }
+    return true;
+}
+static void PlatformWake(FileWatcher* w) { char c = 1; ssize_t r = write(w->wake_pipe[1], &c, 1); (void)r; }
+static void PlatformShutdown(FileWatcher* w) {
+    close(w->inotify_fd);
+    close(w->wake_pipe[0]);
+    close(w->wake_pipe[1]);
+}
+
+#endif
+
+// ============================ Public API ===========================
+FileWatcher* FileWatcherCreate(int debounce_ms) {
+    FileWatcher* w = (FileWatcher*)calloc(1, sizeof(FileWatcher));
+    if (!w) return NULL;
+    w->debounce_ms = debounce_ms;
+    MutexInit(&w->lock);
+    if (!PlatformInit(w)) { MutexDestroy(&w->lock); free(w); return NULL; }
+    if (!ThreadStart(&w->thread, WatcherThread, w)) {
+        PlatformShutdown(w); MutexDestroy(&w->lock); free(w);
+        return NULL;
+    }
+    return w;
+}
+
+void FileWatcherDestroy(FileWatcher* w) {
+    if (!w) return;
+    AtomicStore32(&w->stop, 1);
+    PlatformWake(w);
+    ThreadJoin(w->thread);
+    for (int i = 0; i < w->dir_count; ++i) CloseDir(&w->dirs[i]);
+    PlatformShutdown(w);
+    MutexDestroy(&w->lock);
+    free(w);
+}
+
+int FileWatcherAddFile(FileWatcher* w, const char* path) {
+    char dir[APP_PATH_MAX], name[WATCHER_NAME_MAX];
+    SplitPath(path, dir, sizeof(dir), name, sizeof(name));
+
+    int id = -1;
+    MutexLock(&w->lock);
+    int di = -1;
+    for (int i = 0; i < w->dir_count; ++i) if (NamesEqual(w->dirs[i].path, dir)) { di = i; break; }
+    if (di >= 0) {
+        for (int i = 0; i < w->file_count; ++i)
+            if (w->files[i].dir == di && NamesEqual(w->files[i].name, name)) { id = i; break; }
+    }
+    if (id < 0 && w->file_count < WATCHER_MAX_FILES) {
+        if (di < 0 && w->dir_count < WATCHER_MAX_DIRS) {
+            WatchDir* d = &w->dirs[w->dir_count];
+            memset(d, 0, sizeof(*d));
+            snprintf(d->path, sizeof(d->path), "%s", dir);
+            if (OpenDir(w, d)) di = w->dir_count++;
+        }
+        if (di >= 0) {
+            WatchFile* f = &w->files[w->file_count];
+            memset(f, 0, sizeof(*f));
+            snprintf(f->name, sizeof(f->name), "%s", name);
+            f->dir = di;
+            id = w->file_count++;
+        }
+    }
+    MutexUnlock(&w->lock);
+    PlatformWake(w);
+    return id;
+}
+
+bool FileWatcherPoll(FileWatcher* w, double* out_first_event) {
+    if (!AtomicLoad32(&w->pending)) return false;
+    MutexLock(&w->lock);
+    bool got = AtomicExchange32(&w->pending, 0) != 0;
+    if (out_first_event) *out_first_event = w->pending_since;
+    MutexUnlock(&w->lock);
+    return got;
+}
+
+bool FileWatcherTakeChanged(FileWatcher* w, int id) {
+    if (id < 0 || id >= WATCHER_MAX_FILES) return false;
+    return AtomicExchange32(&w->files[id].changed, 0) != 0;
+}
+
+void FileWatcherSetNotify(FileWatcher* w, void (*fn)(void* user), void* user) {
+    MutexLock(&w->lock);
+    w->notify = fn;
+    w->notify_user = user;
+    MutexUnlock(&w->lock);
+}
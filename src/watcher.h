@@ -0,0 +1,34 @@
+// watcher.h — event-driven file watching on a background thread
+//
+// ReadDirectoryChangesW on Win32, inotify on Linux. Directories are watched rather
+// than files so write-temp-then-rename saves are seen. Editor save bursts are
+// debounced on the watcher thread and published as one coalesced event; the render
+// thread only pays a single atomic load per frame when nothing changed.
+
+#ifndef SHADERDEVEL_WATCHER_H
+#define SHADERDEVEL_WATCHER_H
+
+#include "platform.h"
+
+#define WATCHER_MAX_FILES 256
+#define WATCHER_MAX_DIRS  32
+
+typedef struct FileWatcher FileWatcher;
+
+// Starts the watcher thread. Events closer together than debounce_ms are coalesced.
+FileWatcher* FileWatcherCreate(int debounce_ms);
+void         FileWatcherDestroy(FileWatcher* w);
+
+// Returns a small id for the file (the same id if already watched) or -1.
+int          FileWatcherAddFile(FileWatcher* w, const char* path);
+
+// True once per published burst; clears the pending flag. *out_first_event (may be
+// NULL) receives the NowSeconds() of the burst's first raw event, i.e. before debouncing.
+bool         FileWatcherPoll(FileWatcher* w, double* out_first_event);
+// After Poll returned true: was this file part of it? Clears the file's flag.
+bool         FileWatcherTakeChanged(FileWatcher* w, int id);
+// fn(user) runs on the watcher thread each time a burst is published, so a loop that
+// sleeps between frames can wake up for it (NULL to stop).
+void         FileWatcherSetNotify(FileWatcher* w, void (*fn)(void* user), void* user);
+
+#endif // SHADERDEVEL_WATCHER_H
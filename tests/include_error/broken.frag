@@ -0,0 +1,5 @@
+#version 330 core
+// Fails to compile in both files: the logs must name them, not the vertex shader.
+#include "helpers.glsl"
+out vec4 FragColor;
+void main() { FragColor = vec4(Helper(), undeclared_x, 0.0, 1.0); }
@@ -0,0 +1,4 @@
+#pragma once
+float Helper() {
+    return vec2(1.0);
+}